@@ -21,6 +21,9 @@
 #include "itkImageToImageMetric.h"
 
 #include "itkImageSamplerBase.h"
+#include "itkImageSampleArrays.h"
+#include "itkTransformEvaluationCache.h"
+#include "itkBSplineSupportCache.h"
 #include "itkGradientImageFilter.h"
 #include "itkBSplineInterpolateImageFunction.h"
 #include "itkReducedDimensionBSplineInterpolateImageFunction.h"
@@ -35,6 +38,7 @@
 #include "itkAdvancedCombinationTransform.h"
 
 #include "itkMultiThreader.h"
+#include "itkPersistentThreadPool.h"
 
 namespace itk
 {
@@ -139,6 +143,17 @@ public:
   typedef typename ImageSamplerType::Pointer                      ImageSamplerPointer;
   typedef typename ImageSamplerType::OutputVectorContainerType    ImageSampleContainerType;
   typedef typename ImageSamplerType::OutputVectorContainerPointer ImageSampleContainerPointer;
+  typedef ImageSampleArrays< FixedImageType >                     ImageSampleArraysType;
+  typedef typename ImageSampleArraysType::Pointer                 ImageSampleArraysPointer;
+
+  /** Typedefs for the transform evaluation cache. */
+  typedef TransformEvaluationCache<
+    FixedImageType, typename TransformType::OutputPointType >     TransformEvaluationCacheType;
+  typedef typename TransformEvaluationCacheType::Pointer          TransformEvaluationCachePointer;
+
+  /** Typedefs for the B-spline support cache. */
+  typedef BSplineSupportCache                BSplineSupportCacheType;
+  typedef BSplineSupportCacheType::Pointer   BSplineSupportCachePointer;
 
   /** Typedefs for Limiter support. */
   typedef LimiterFunctionBase< RealType, FixedImageDimension >  FixedImageLimiterType;
@@ -159,6 +174,7 @@ public:
   typedef AdvancedBSplineDeformableTransform< ScalarType, FixedImageDimension, 1 > BSplineOrder1TransformType;
   typedef AdvancedBSplineDeformableTransform< ScalarType, FixedImageDimension, 2 > BSplineOrder2TransformType;
   typedef AdvancedBSplineDeformableTransform< ScalarType, FixedImageDimension, 3 > BSplineOrder3TransformType;
+  typedef AdvancedBSplineDeformableTransformBase< ScalarType, FixedImageDimension > BSplineTransformBaseType;
 
   /** Hessian type; for SelfHessian (experimental feature) */
   typedef typename DerivativeType::ValueType    HessianValueType;
@@ -189,8 +205,11 @@ public:
   }
 
 
-  /** Set/Get the image sampler. */
-  itkSetObjectMacro( ImageSampler, ImageSamplerType );
+  /** Set/Get the image sampler. Setting another sampler invalidates the
+   * caches that depend on the samples.
+   */
+  virtual void SetImageSampler( ImageSamplerType * arg );
+
   virtual ImageSamplerType * GetImageSampler( void ) const
   {
     return this->m_ImageSampler.GetPointer();
@@ -201,6 +220,90 @@ public:
    * This method allows the user to inspect this setting. */
   itkGetConstMacro( UseImageSampler, bool );
 
+  /** Select the use of a structure-of-arrays copy of the image samples,
+   * see ImageSampleArrays. The copy is made in
+   * BeforeThreadedGetValueAndDerivative(), once the samples are used for a
+   * second time. Samplers that select new samples in every iteration thus
+   * never pay for the copy. Metrics that support it read the samples with
+   * GetFixedImageSample(). Set it before calling Initialize().
+   * Default: false.
+   */
+  itkSetMacro( UseImageSampleArrays, bool );
+  itkGetConstMacro( UseImageSampleArrays, bool );
+  itkBooleanMacro( UseImageSampleArrays );
+
+  /** Select the use of the B-spline support cache. For samplers that
+   * select the same samples in every iteration, i.e. the grid and full
+   * sampler, the support region and weights of the B-spline transform are
+   * computed once for each sample, see
+   * AdvancedBSplineDeformableTransformBase::PrecomputeSupportCache().
+   * Only used for a B-spline transform, possibly added to an initial
+   * transform, and by metrics that call the sample based TransformPoint()
+   * and EvaluateJacobianWithImageGradientProduct(). Set it before calling
+   * Initialize(). Default: false.
+   */
+  itkSetMacro( UseBSplineSupportCache, bool );
+  itkGetConstMacro( UseBSplineSupportCache, bool );
+  itkBooleanMacro( UseBSplineSupportCache );
+
+  /** The maximum memory of the B-spline support cache in megabytes.
+   * Samples that do not fit are computed as usual. Default: 512.
+   */
+  itkSetMacro( BSplineSupportCacheMaximumMemory, double );
+  itkGetConstMacro( BSplineSupportCacheMaximumMemory, double );
+
+  /** Set/Get the B-spline support cache. If none is set, Initialize()
+   * creates one when UseBSplineSupportCache is true and the cache can be
+   * used. Metrics that share the transform but not the sampler should not
+   * share the cache.
+   */
+  itkSetObjectMacro( BSplineSupportCache, BSplineSupportCacheType );
+  itkGetObjectMacro( BSplineSupportCache, BSplineSupportCacheType );
+
+  /** Get the number of samples in the B-spline support cache. */
+  virtual unsigned long GetBSplineSupportCacheSize( void ) const;
+
+  /** Get the memory used by the B-spline support cache, in bytes. */
+  virtual std::size_t GetBSplineSupportCacheMemorySize( void ) const;
+
+  /** Select the use of the transform evaluation cache, which stores the
+   * mapped points of the samples for the current transform parameters, see
+   * TransformEvaluationCache. The cache is refreshed in
+   * BeforeThreadedGetValueAndDerivative(), and used by metrics that call the
+   * sample based TransformPoint(). Metrics that use the same sampler and
+   * transform can share one cache, so that the points are only mapped once
+   * per iteration, see CombinationImageToImageMetric. Set it before calling
+   * Initialize(). Default: false.
+   */
+  itkSetMacro( UseTransformEvaluationCache, bool );
+  itkGetConstMacro( UseTransformEvaluationCache, bool );
+  itkBooleanMacro( UseTransformEvaluationCache );
+
+  /** Set/Get the transform evaluation cache. If none is set, Initialize()
+   * creates one when UseTransformEvaluationCache is true.
+   */
+  itkSetObjectMacro( TransformEvaluationCache, TransformEvaluationCacheType );
+  itkGetObjectMacro( TransformEvaluationCache, TransformEvaluationCacheType );
+
+  /** Get the structure-of-arrays copy of the image samples. */
+  virtual const ImageSampleArraysType * GetImageSampleArrays( void ) const
+  {
+    return this->m_ImageSampleArrays.GetPointer();
+  }
+
+
+  /** Returns whether GetValueAndDerivative() may run concurrently with
+   * that of other metrics that share the transform, after a call of
+   * BeforeThreadedGetValueAndDerivative(). Used by the
+   * CombinationImageToImageMetric. Metrics that change the transform
+   * parameters while computing their value should return false.
+   */
+  virtual bool ConcurrentEvaluationSupported( void ) const
+  {
+    return true;
+  }
+
+
   /** Set/Get the required ratio of valid samples; default 0.25.
    * When less than this ratio*numberOfSamplesTried samples map
    * inside the moving image buffer, an exception will be thrown. */
@@ -333,6 +436,18 @@ protected:
    */
   mutable ImageSamplerPointer m_ImageSampler;
 
+  /** Variables for the structure-of-arrays copy of the image samples. */
+  bool                             m_UseImageSampleArrays;
+  mutable bool                     m_ReadImageSampleArrays;
+  mutable ImageSampleArraysPointer m_ImageSampleArrays;
+
+  /** Variables for the transform evaluation cache. The cache is only used
+   * when it is valid for the current samples and parameters.
+   */
+  bool                            m_UseTransformEvaluationCache;
+  TransformEvaluationCachePointer m_TransformEvaluationCache;
+  mutable bool                    m_TransformEvaluationCacheValid;
+
   /** Variables for image derivative computation. */
   bool                                   m_InterpolatorIsBSpline;
   bool                                   m_InterpolatorIsBSplineFloat;
@@ -349,6 +464,21 @@ protected:
   typename AdvancedTransformType::Pointer m_AdvancedTransform;
   bool m_TransformIsBSpline;
 
+  /** Variables for the B-spline support cache. The B-spline transform is
+   * only set if the cache can be used. The combination transform is only
+   * set if its initial transform has to be added. The cache is owned by
+   * this metric, or shared with the metrics that use the same sampler, and
+   * keyed by the sample container. It is only used when it is valid for
+   * the current samples and B-spline grid.
+   */
+  bool                                     m_UseBSplineSupportCache;
+  double                                   m_BSplineSupportCacheMaximumMemory;
+  BSplineSupportCachePointer               m_BSplineSupportCache;
+  mutable bool                             m_BSplineSupportCacheValid;
+  BSplineTransformBaseType *               m_SupportCacheBSplineTransform;
+  const CombinationTransformType *         m_SupportCacheCombinationTransform;
+  mutable const ImageSampleContainerType * m_CachedSampleContainer;
+
   /** Variables for the Limiters. */
   FixedImageLimiterPointer     m_FixedImageLimiter;
   MovingImageLimiterPointer    m_MovingImageLimiter;
@@ -460,6 +590,35 @@ protected:
    * Make sure to set it before calling Initialize; default: false. */
   itkSetMacro( UseImageSampler, bool );
 
+  /** Get the coordinates and value of fixed image sample i, from the
+   * sample arrays if they hold the current samples, and from the sample
+   * container otherwise.
+   */
+  inline void GetFixedImageSample(
+    const ImageSampleContainerType * sampleContainer,
+    const unsigned long i,
+    FixedImagePointType & fixedPoint,
+    RealType & fixedImageValue ) const
+  {
+    if( this->m_ReadImageSampleArrays )
+    {
+      for( unsigned int d = 0; d < FixedImageDimension; ++d )
+      {
+        fixedPoint[ d ] = this->m_ImageSampleArrays->GetCoordinates( d )[ i ];
+      }
+      fixedImageValue = static_cast< RealType >(
+        this->m_ImageSampleArrays->GetValues()[ i ] );
+    }
+    else
+    {
+      const typename ImageSampleContainerType::Element & sample
+        = sampleContainer->ElementAt( i );
+      fixedPoint      = sample.m_ImageCoordinates;
+      fixedImageValue = static_cast< RealType >( sample.m_ImageValue );
+    }
+  }
+
+
   /** Check if enough samples have been found to compute a reliable
    * estimate of the value/derivative; throws an exception if not. */
   virtual void CheckNumberOfSamples(
@@ -512,6 +671,53 @@ protected:
     const FixedImagePointType & fixedImagePoint,
     MovingImagePointType & mappedPoint ) const;
 
+  /** Transform image sample sampleId, using the B-spline support cache
+   * if possible. The fixed image point of the sample must also be given.
+   */
+  virtual bool TransformPoint(
+    const unsigned long sampleId,
+    const FixedImagePointType & fixedImagePoint,
+    MovingImagePointType & mappedPoint ) const;
+
+  /** Compute the inner product of the transform Jacobian and the moving
+   * image gradient for image sample sampleId, using the B-spline support
+   * cache if possible.
+   */
+  virtual void EvaluateJacobianWithImageGradientProduct(
+    const unsigned long sampleId,
+    const FixedImagePointType & fixedImagePoint,
+    const MovingImageDerivativeType & movingImageDerivative,
+    DerivativeType & imageJacobian,
+    NonZeroJacobianIndicesType & nzji ) const;
+
+  /** Decide whether the B-spline support cache can be used. */
+  virtual void InitializeBSplineSupportCache( void );
+
+  /** Returns true if the B-spline support cache was computed for the
+   * current samples of this metric.
+   */
+  bool OwnsBSplineSupportCache( void ) const
+  {
+    return this->m_BSplineSupportCacheValid
+           && this->m_BSplineSupportCache->GetOwner() == this->m_CachedSampleContainer;
+  }
+
+
+  /** (Re)compute the B-spline support cache if the samples or the
+   * B-spline grid changed. Called by BeforeThreadedGetValueAndDerivative().
+   */
+  virtual void UpdateBSplineSupportCache( void ) const;
+
+  /** Map the samples with the given parameters and store them in the
+   * transform evaluation cache, unless another metric already did.
+   * Called by BeforeThreadedGetValueAndDerivative().
+   */
+  virtual void UpdateTransformEvaluationCache(
+    const TransformParametersType & parameters ) const;
+
+  /** TransformEvaluationCache threader callback function. */
+  static ITK_THREAD_RETURN_TYPE TransformEvaluationCacheThreaderCallback( void * arg );
+
   /** This function returns a reference to the transform Jacobians.
    * This is either a reference to the full TransformJacobian or
    * a reference to a sparse Jacobians.
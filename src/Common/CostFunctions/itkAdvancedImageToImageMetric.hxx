@@ -24,6 +24,9 @@
 #include "itkImageRegionConstIteratorWithIndex.h" // used for extrema computation
 #include "itkAdvancedRayCastInterpolateImageFunction.h"
 
+#include <algorithm>
+#include <cmath>
+
 #ifdef ELASTIX_USE_OPENMP
 #include <omp.h>
 #endif
@@ -49,6 +52,22 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 
   this->m_ImageSampler                = 0;
   this->m_UseImageSampler             = false;
+  this->m_UseImageSampleArrays        = false;
+  this->m_ReadImageSampleArrays       = false;
+  this->m_ImageSampleArrays           = 0;
+
+  this->m_UseBSplineSupportCache           = false;
+  this->m_BSplineSupportCacheMaximumMemory = 512.0;
+  this->m_BSplineSupportCache              = 0;
+  this->m_BSplineSupportCacheValid         = false;
+  this->m_SupportCacheBSplineTransform     = 0;
+  this->m_SupportCacheCombinationTransform = 0;
+  this->m_CachedSampleContainer            = 0;
+
+  this->m_UseTransformEvaluationCache   = false;
+  this->m_TransformEvaluationCache      = 0;
+  this->m_TransformEvaluationCacheValid = false;
+
   this->m_RequiredRatioOfValidSamples = 0.25;
 
   this->m_BSplineInterpolator             = 0;
@@ -87,6 +106,7 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
   this->m_UseMetricSingleThreaded = true;
   this->m_Threader->SetUseThreadPool( false ); // setting to true makes elastix hang
                                                // at a WaitForSingleMethodThread()
+  // the threads of the global PersistentThreadPool are used when available
 
   /** OpenMP related. Switch to on when available */
 #ifdef ELASTIX_USE_OPENMP
@@ -141,6 +161,32 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 } // end SetNumberOfThreads()
 
 
+/**
+ * ********************* SetImageSampler ****************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::SetImageSampler( ImageSamplerType * arg )
+{
+  if( this->m_ImageSampler != arg )
+  {
+    this->m_ImageSampler = arg;
+
+    /** The caches were computed for the samples of the previous sampler,
+     * e.g. when elastix temporarily sets another sampler to compute the
+     * exact metric value.
+     */
+    this->m_CachedSampleContainer         = 0;
+    this->m_BSplineSupportCacheValid      = false;
+    this->m_TransformEvaluationCacheValid = false;
+    this->Modified();
+  }
+
+} // end SetImageSampler()
+
+
 /**
  * ********************* Initialize ****************************
  */
@@ -168,6 +214,24 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
   /** Check if the transform is a B-spline transform. */
   this->CheckForBSplineTransform();
 
+  /** Check if the B-spline support cache can be used. */
+  this->InitializeBSplineSupportCache();
+
+  /** Create the transform evaluation cache, unless a shared one is set. */
+  this->m_TransformEvaluationCacheValid = false;
+  if( this->m_UseTransformEvaluationCache && this->m_UseImageSampler )
+  {
+    if( this->m_TransformEvaluationCache.IsNull() )
+    {
+      this->m_TransformEvaluationCache = TransformEvaluationCacheType::New();
+    }
+    this->m_TransformEvaluationCache->Clear();
+  }
+  else
+  {
+    this->m_TransformEvaluationCache = 0;
+  }
+
   /** Initialize some threading related parameters. */
   if( this->m_UseMultiThread )
   {
@@ -431,6 +495,17 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
     this->m_ImageSampler->SetInput( this->m_FixedImage );
     this->m_ImageSampler->SetMask( this->m_FixedImageMask );
     this->m_ImageSampler->SetInputImageRegion( this->GetFixedImageRegion() );
+
+    /** Create the structure-of-arrays copy of the samples. */
+    if( this->m_UseImageSampleArrays )
+    {
+      this->m_ImageSampleArrays = ImageSampleArraysType::New();
+      this->m_ImageSampleArrays->SetImage( this->m_FixedImage );
+    }
+  }
+  else
+  {
+    this->m_UseImageSampleArrays = false;
   }
 
 } // end InitializeImageSampler()
@@ -827,6 +902,322 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 } // end TransformPoint()
 
 
+/**
+ * ************************** TransformPoint *************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+bool
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::TransformPoint(
+  const unsigned long sampleId,
+  const FixedImagePointType & fixedImagePoint,
+  MovingImagePointType & mappedPoint ) const
+{
+  /** Use the points that were mapped before, possibly by another metric.
+   * A metric that shares the cache may have refilled it for other samples.
+   */
+  if( this->m_TransformEvaluationCacheValid
+    && this->m_TransformEvaluationCache->GetContainer() == this->m_CachedSampleContainer
+    && this->m_TransformEvaluationCache->GetPoint( sampleId, mappedPoint ) )
+  {
+    return true;
+  }
+
+  if( !this->OwnsBSplineSupportCache()
+    || !this->m_SupportCacheBSplineTransform->TransformPointUsingSupportCache(
+    this->m_BSplineSupportCache, sampleId, fixedImagePoint, mappedPoint ) )
+  {
+    return this->TransformPoint( fixedImagePoint, mappedPoint );
+  }
+
+  /** Add the initial transform, like AdvancedCombinationTransform does. */
+  if( this->m_SupportCacheCombinationTransform != 0 )
+  {
+    const MovingImagePointType mappedPoint0 = this->m_SupportCacheCombinationTransform
+      ->GetInitialTransform()->TransformPoint( fixedImagePoint );
+    for( unsigned int i = 0; i < MovingImageDimension; ++i )
+    {
+      mappedPoint[ i ] += ( mappedPoint0[ i ] - fixedImagePoint[ i ] );
+    }
+  }
+
+  return true;
+
+} // end TransformPoint()
+
+
+/**
+ * *************** EvaluateJacobianWithImageGradientProduct ****************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::EvaluateJacobianWithImageGradientProduct(
+  const unsigned long sampleId,
+  const FixedImagePointType & fixedImagePoint,
+  const MovingImageDerivativeType & movingImageDerivative,
+  DerivativeType & imageJacobian,
+  NonZeroJacobianIndicesType & nzji ) const
+{
+  /** The initial transform does not depend on the parameters, so it does
+   * not contribute in case of addition.
+   */
+  if( !this->OwnsBSplineSupportCache()
+    || !this->m_SupportCacheBSplineTransform
+    ->EvaluateJacobianWithImageGradientProductUsingSupportCache(
+    this->m_BSplineSupportCache, sampleId, movingImageDerivative, imageJacobian, nzji ) )
+  {
+    this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
+      fixedImagePoint, movingImageDerivative, imageJacobian, nzji );
+  }
+
+} // end EvaluateJacobianWithImageGradientProduct()
+
+
+/**
+ * *************** InitializeBSplineSupportCache ****************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::InitializeBSplineSupportCache( void )
+{
+  /** Release a cache of a previous resolution. A shared cache may be set
+   * before; another metric with the same sampler may release it as well.
+   */
+  if( this->m_BSplineSupportCache.IsNotNull() )
+  {
+    this->m_BSplineSupportCache->Clear();
+  }
+  this->m_BSplineSupportCacheValid         = false;
+  this->m_SupportCacheBSplineTransform     = 0;
+  this->m_SupportCacheCombinationTransform = 0;
+  this->m_CachedSampleContainer            = 0;
+
+  /** The samples should be the same in every iteration. */
+  if( !this->m_UseBSplineSupportCache || !this->m_UseImageSampler
+    || this->m_ImageSampler->SelectingNewSamplesOnUpdateSupported() )
+  {
+    this->m_BSplineSupportCache = 0;
+    return;
+  }
+
+  /** The input of the B-spline transform should be the fixed image point,
+   * so a composition with an initial transform is not supported.
+   */
+  BSplineTransformBaseType * bsplineTransform
+    = dynamic_cast< BSplineTransformBaseType * >( this->m_AdvancedTransform.GetPointer() );
+  const CombinationTransformType * comboTransform
+    = dynamic_cast< const CombinationTransformType * >( this->m_AdvancedTransform.GetPointer() );
+  if( bsplineTransform == 0 && comboTransform != 0 )
+  {
+    bsplineTransform = dynamic_cast< BSplineTransformBaseType * >(
+      const_cast< CombinationTransformType * >( comboTransform )->GetCurrentTransform() );
+    if( comboTransform->GetInitialTransform() == 0 )
+    {
+      comboTransform = 0;
+    }
+    else if( !comboTransform->GetUseAddition() )
+    {
+      bsplineTransform = 0;
+    }
+  }
+  else
+  {
+    comboTransform = 0;
+  }
+
+  this->m_SupportCacheBSplineTransform     = bsplineTransform;
+  this->m_SupportCacheCombinationTransform = bsplineTransform != 0 ? comboTransform : 0;
+
+  /** Create the cache, unless a shared one is set. */
+  if( bsplineTransform == 0 )
+  {
+    this->m_BSplineSupportCache = 0;
+  }
+  else if( this->m_BSplineSupportCache.IsNull() )
+  {
+    this->m_BSplineSupportCache = BSplineSupportCacheType::New();
+  }
+
+} // end InitializeBSplineSupportCache()
+
+
+/**
+ * *************** UpdateBSplineSupportCache ****************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::UpdateBSplineSupportCache( void ) const
+{
+  if( this->m_SupportCacheBSplineTransform == 0 )
+  {
+    return;
+  }
+
+  /** The cache is keyed by the sample container, and by the grid of the
+   * transform. Only recompute if the samples changed, if the grid changed,
+   * or if another metric with the same sampler did not do so already.
+   */
+  const ImageSampleContainerType * sampleContainer = this->m_CachedSampleContainer;
+  const unsigned long              sampleTime      = std::max(
+    static_cast< unsigned long >( sampleContainer->GetMTime() ),
+    static_cast< unsigned long >( sampleContainer->GetUpdateMTime() ) );
+  if( !this->m_BSplineSupportCache->IsValid( sampleContainer, sampleTime,
+    this->m_SupportCacheBSplineTransform,
+    this->m_SupportCacheBSplineTransform->GetGridMTime() ) )
+  {
+    /** Collect the sample points. */
+    const unsigned long numberOfSamples = sampleContainer->Size();
+    std::vector< FixedImagePointType > points( numberOfSamples );
+    typename ImageSampleContainerType::ConstIterator iter = sampleContainer->Begin();
+    for( unsigned long i = 0; i < numberOfSamples; ++i, ++iter )
+    {
+      points[ i ] = iter.Value().m_ImageCoordinates;
+    }
+
+    const std::size_t maximumMemory = static_cast< std::size_t >(
+      this->m_BSplineSupportCacheMaximumMemory * 1024.0 * 1024.0 );
+    this->m_SupportCacheBSplineTransform->PrecomputeSupportCache(
+      points, maximumMemory, this->m_BSplineSupportCache );
+    this->m_BSplineSupportCache->SetOwner( sampleContainer, sampleTime );
+  }
+
+  this->m_BSplineSupportCacheValid = true;
+
+} // end UpdateBSplineSupportCache()
+
+
+/**
+ * *************** UpdateTransformEvaluationCache ****************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::UpdateTransformEvaluationCache( const TransformParametersType & parameters ) const
+{
+  this->m_TransformEvaluationCacheValid = false;
+  if( this->m_TransformEvaluationCache.IsNull() )
+  {
+    return;
+  }
+
+  /** Another metric with the same sampler may have mapped the points. */
+  const ImageSampleContainerType * sampleContainer = this->m_CachedSampleContainer;
+  if( !this->m_TransformEvaluationCache->IsValid( sampleContainer, parameters ) )
+  {
+    /** Map the points, multi-threaded if possible. The cache itself is
+     * not used while it is filled.
+     */
+    this->m_TransformEvaluationCache->Allocate( sampleContainer, parameters );
+    if( this->m_UseMultiThread )
+    {
+      PersistentThreadPool::Launch( this->m_Threader,
+        this->TransformEvaluationCacheThreaderCallback,
+        const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
+    }
+    else
+    {
+      FixedImagePointType  fixedPoint;
+      MovingImagePointType mappedPoint;
+      const unsigned long  numberOfPoints = this->m_TransformEvaluationCache->GetNumberOfPoints();
+      for( unsigned long i = 0; i < numberOfPoints; ++i )
+      {
+        fixedPoint = sampleContainer->ElementAt( i ).m_ImageCoordinates;
+        this->TransformPoint( i, fixedPoint, mappedPoint );
+        this->m_TransformEvaluationCache->SetPoint( i, mappedPoint );
+      }
+    }
+    this->m_TransformEvaluationCache->Validate();
+  }
+
+  this->m_TransformEvaluationCacheValid = true;
+
+} // end UpdateTransformEvaluationCache()
+
+
+/**
+ * *************** TransformEvaluationCacheThreaderCallback ****************
+ */
+
+template< class TFixedImage, class TMovingImage >
+ITK_THREAD_RETURN_TYPE
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::TransformEvaluationCacheThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct  = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadID    = infoStruct->ThreadID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfThreads;
+
+  MultiThreaderParameterType * temp
+    = static_cast< MultiThreaderParameterType * >( infoStruct->UserData );
+  const Self * metric = temp->st_Metric;
+
+  /** Each thread maps a contiguous range of the samples. */
+  const ImageSampleContainerType * sampleContainer = metric->m_CachedSampleContainer;
+  TransformEvaluationCacheType * cache = metric->m_TransformEvaluationCache.GetPointer();
+  const unsigned long numberOfPoints   = cache->GetNumberOfPoints();
+  const unsigned long nrOfPointsPerThread = static_cast< unsigned long >(
+    std::ceil( static_cast< double >( numberOfPoints ) / static_cast< double >( nrOfThreads ) ) );
+  const unsigned long pos_begin = std::min( nrOfPointsPerThread * threadID, numberOfPoints );
+  const unsigned long pos_end   = std::min( nrOfPointsPerThread * ( threadID + 1 ), numberOfPoints );
+
+  FixedImagePointType  fixedPoint;
+  MovingImagePointType mappedPoint;
+  for( unsigned long i = pos_begin; i < pos_end; ++i )
+  {
+    fixedPoint = sampleContainer->ElementAt( i ).m_ImageCoordinates;
+    metric->TransformPoint( i, fixedPoint, mappedPoint );
+    cache->SetPoint( i, mappedPoint );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end TransformEvaluationCacheThreaderCallback()
+
+
+/**
+ * *************** GetBSplineSupportCacheSize ****************
+ */
+
+template< class TFixedImage, class TMovingImage >
+unsigned long
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::GetBSplineSupportCacheSize( void ) const
+{
+  if( !this->OwnsBSplineSupportCache() )
+  {
+    return 0;
+  }
+  return this->m_BSplineSupportCache->GetSize();
+
+} // end GetBSplineSupportCacheSize()
+
+
+/**
+ * *************** GetBSplineSupportCacheMemorySize ****************
+ */
+
+template< class TFixedImage, class TMovingImage >
+std::size_t
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::GetBSplineSupportCacheMemorySize( void ) const
+{
+  if( !this->OwnsBSplineSupportCache() )
+  {
+    return 0;
+  }
+  return this->m_BSplineSupportCache->GetMemorySize();
+
+} // end GetBSplineSupportCacheMemorySize()
+
+
 /**
  * *************** EvaluateTransformJacobian ****************
  */
@@ -913,6 +1304,20 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
     if( this->m_UseImageSampler )
     {
       this->GetImageSampler()->Update();
+
+      /** Copy the samples to the arrays, once they are reused. */
+      this->m_ReadImageSampleArrays = this->m_UseImageSampleArrays
+        && this->m_ImageSampleArrays->CopyFromContainerIfReused(
+        this->GetImageSampler()->GetOutput() );
+
+      /** Remember for which samples the caches are computed. */
+      this->m_CachedSampleContainer = this->GetImageSampler()->GetOutput();
+
+      /** Precompute the B-spline support of the samples, if needed. */
+      this->UpdateBSplineSupportCache();
+
+      /** Map the samples, if needed. */
+      this->UpdateTransformEvaluationCache( parameters );
     }
   }
 
@@ -950,13 +1355,11 @@ void
 AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 ::LaunchGetValueThreaderCallback( void ) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod( this->GetValueThreaderCallback,
+  /** Launch, on the thread pool if there is one. */
+  PersistentThreadPool::Launch( this->m_Threader,
+    this->GetValueThreaderCallback,
     const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
 
-  /** Launch. */
-  this->m_Threader->SingleMethodExecute();
-
 } // end LaunchGetValueThreaderCallback()
 
 
@@ -991,13 +1394,11 @@ void
 AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 ::LaunchGetValueAndDerivativeThreaderCallback( void ) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod( this->GetValueAndDerivativeThreaderCallback,
+  /** Launch, on the thread pool if there is one. */
+  PersistentThreadPool::Launch( this->m_Threader,
+    this->GetValueAndDerivativeThreaderCallback,
     const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
 
-  /** Launch. */
-  this->m_Threader->SingleMethodExecute();
-
 } // end LaunchGetValueAndDerivativeThreaderCallback()
 
 
@@ -1085,6 +1486,16 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
      << this->m_ImageSampler.GetPointer() << std::endl;
   os << indent.GetNextIndent() << "UseImageSampler: "
      << this->m_UseImageSampler << std::endl;
+  os << indent.GetNextIndent() << "UseImageSampleArrays: "
+     << this->m_UseImageSampleArrays << std::endl;
+  os << indent.GetNextIndent() << "UseBSplineSupportCache: "
+     << this->m_UseBSplineSupportCache << std::endl;
+  os << indent.GetNextIndent() << "BSplineSupportCacheMaximumMemory: "
+     << this->m_BSplineSupportCacheMaximumMemory << std::endl;
+  os << indent.GetNextIndent() << "UseTransformEvaluationCache: "
+     << this->m_UseTransformEvaluationCache << std::endl;
+  os << indent.GetNextIndent() << "TransformEvaluationCache: "
+     << this->m_TransformEvaluationCache.GetPointer() << std::endl;
 
   /** Variables for the Limiters. */
   os << indent << "Variables related to the Limiters: " << std::endl;
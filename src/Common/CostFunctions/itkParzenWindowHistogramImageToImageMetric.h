@@ -335,6 +335,18 @@ protected:
   /** Helper function to launch the threads. */
   void LaunchComputePDFsThreaderCallback( void ) const;
 
+  /** Multi-threaded accumulation of the per-thread joint histograms.
+   * Each thread owns a band of rows of the joint PDF, and sums that band
+   * over the joint PDFs of all threads.
+   */
+  inline void ThreadedAccumulateJointPDFs( ThreadIdType threadId );
+
+  /** Helper function to launch the threads. */
+  static ITK_THREAD_RETURN_TYPE AccumulateJointPDFsThreaderCallback( void * arg );
+
+  /** Helper function to launch the threads. */
+  void LaunchAccumulateJointPDFsThreaderCallback( void ) const;
+
   /** Compute the Parzen values given an image value and a starting histogram index
    * Compute the values at (parzenWindowIndex - parzenWindowTerm + k) for
    * k = 0 ... kernelsize-1
@@ -1190,7 +1190,8 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
   unsigned long numberOfPixelsCounted = 0;
 
   /** Loop over sample container and compute contribution of each sample to pdfs. */
-  for( fiter = fbegin; fiter != fend; ++fiter )
+  unsigned long sampleId = pos_begin;
+  for( fiter = fbegin; fiter != fend; ++fiter, ++sampleId )
   {
     /** Read fixed coordinates and initialize some variables. */
     const FixedImagePointType & fixedPoint = ( *fiter ).Value().m_ImageCoordinates;
@@ -1198,7 +1199,7 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
     MovingImagePointType        mappedPoint;
 
     /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+    bool sampleOk = this->TransformPoint( sampleId, fixedPoint, mappedPoint );
 
     /** Check if point is inside mask. */
     if( sampleOk )
@@ -1268,38 +1269,8 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
   /** Compute alpha. */
   this->m_Alpha = 1.0 / static_cast< double >( this->m_NumberOfPixelsCounted );
 
-  /** Accumulate joint histogram. */
-  // could be multi-threaded too, by each thread updating only a part of the JointPDF.
-  typedef ImageScanlineIterator< JointPDFType > JointPDFIteratorType;
-  JointPDFIteratorType                it( this->m_JointPDF, this->m_JointPDF->GetBufferedRegion() );
-  std::vector< JointPDFIteratorType > itT( this->m_NumberOfThreads );
-  for( ThreadIdType i = 0; i < this->m_NumberOfThreads; ++i )
-  {
-    itT[ i ] = JointPDFIteratorType(
-      this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ i ].st_JointPDF,
-      this->m_JointPDF->GetBufferedRegion() );
-  }
-
-  PDFValueType sum;
-  while( !it.IsAtEnd() )
-  {
-    while( !it.IsAtEndOfLine() )
-    {
-      sum = NumericTraits< PDFValueType >::Zero;
-      for( ThreadIdType i = 0; i < this->m_NumberOfThreads; ++i )
-      {
-        sum += itT[ i ].Value();
-        ++itT[ i ];
-      }
-      it.Set( sum );
-      ++it;
-    }
-    it.NextLine();
-    for( ThreadIdType i = 0; i < this->m_NumberOfThreads; ++i )
-    {
-      itT[ i ].NextLine();
-    }
-  }
+  /** Accumulate joint histogram, multi-threaded over bands of histogram rows. */
+  this->LaunchAccumulateJointPDFsThreaderCallback();
 
 } // end AfterThreadedComputePDFs()
 
@@ -1335,17 +1306,104 @@ void
 ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
 ::LaunchComputePDFsThreaderCallback( void ) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod( this->ComputePDFsThreaderCallback,
+  /** Launch, on the thread pool if there is one. */
+  PersistentThreadPool::Launch( this->m_Threader,
+    this->ComputePDFsThreaderCallback,
     const_cast< void * >( static_cast< const void * >(
       &this->m_ParzenWindowHistogramThreaderParameters ) ) );
 
-  /** Launch. */
-  this->m_Threader->SingleMethodExecute();
-
 } // end LaunchComputePDFsThreaderCallback()
 
 
+/**
+ * ******************* ThreadedAccumulateJointPDFs *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::ThreadedAccumulateJointPDFs( ThreadIdType threadId )
+{
+  /** Get the band of histogram rows for this thread. The joint PDF is
+   * stored row by row, so a band of rows is a contiguous part of the buffer.
+   */
+  const JointPDFSizeType jointPDFSize = this->m_JointPDF->GetBufferedRegion().GetSize();
+  const unsigned long    rowLength    = jointPDFSize[ 0 ];
+  const unsigned long    numberOfRows = jointPDFSize[ 1 ];
+  const unsigned long    nrOfRowsPerThread
+    = ( numberOfRows + this->m_NumberOfThreads - 1 ) / this->m_NumberOfThreads;
+
+  unsigned long row_begin = nrOfRowsPerThread * threadId;
+  unsigned long row_end   = nrOfRowsPerThread * ( threadId + 1 );
+  row_begin = ( row_begin > numberOfRows ) ? numberOfRows : row_begin;
+  row_end   = ( row_end > numberOfRows ) ? numberOfRows : row_end;
+
+  const unsigned long pos_begin = row_begin * rowLength;
+  const unsigned long pos_end   = row_end * rowLength;
+
+  /** Sum the band over all threads, in the same thread order as the
+   * single-threaded accumulation, so that the result is identical.
+   */
+  PDFValueType *       jointPDF = this->m_JointPDF->GetBufferPointer();
+  const PDFValueType * threadPDF
+    = this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ 0 ].st_JointPDF->GetBufferPointer();
+  for( unsigned long pos = pos_begin; pos < pos_end; ++pos )
+  {
+    jointPDF[ pos ] = threadPDF[ pos ];
+  }
+
+  for( ThreadIdType i = 1; i < this->m_NumberOfThreads; ++i )
+  {
+    threadPDF = this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ i ].st_JointPDF->GetBufferPointer();
+    for( unsigned long pos = pos_begin; pos < pos_end; ++pos )
+    {
+      jointPDF[ pos ] += threadPDF[ pos ];
+    }
+  }
+
+} // end ThreadedAccumulateJointPDFs()
+
+
+/**
+ * **************** AccumulateJointPDFsThreaderCallback *******
+ */
+
+template< class TFixedImage, class TMovingImage >
+ITK_THREAD_RETURN_TYPE
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::AccumulateJointPDFsThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadId   = infoStruct->ThreadID;
+
+  ParzenWindowHistogramMultiThreaderParameterType * temp
+    = static_cast< ParzenWindowHistogramMultiThreaderParameterType * >( infoStruct->UserData );
+
+  temp->m_Metric->ThreadedAccumulateJointPDFs( threadId );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end AccumulateJointPDFsThreaderCallback()
+
+
+/**
+ * *********************** LaunchAccumulateJointPDFsThreaderCallback***************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::LaunchAccumulateJointPDFsThreaderCallback( void ) const
+{
+  /** Launch, on the thread pool if there is one. */
+  PersistentThreadPool::Launch( this->m_Threader,
+    this->AccumulateJointPDFsThreaderCallback,
+    const_cast< void * >( static_cast< const void * >(
+      &this->m_ParzenWindowHistogramThreaderParameters ) ) );
+
+} // end LaunchAccumulateJointPDFsThreaderCallback()
+
+
 /**
  * ************************ ComputePDFsAndPDFDerivatives *******************
  */
@@ -0,0 +1,166 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkTransformEvaluationCache_h
+#define __itkTransformEvaluationCache_h
+
+#include "itkObject.h"
+#include "itkImageSample.h"
+#include "itkVectorDataContainer.h"
+#include "itkArray.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class TransformEvaluationCache
+ *
+ * \brief Stores the transformed image samples for one set of parameters.
+ *
+ * Metrics that use the same image sampler transform the same sample points
+ * in every iteration. This class stores the mapped points, so that they are
+ * computed only once per iteration: the first metric that needs them calls
+ * Allocate() and SetPoint(), and then Validate(), after which the other
+ * metrics check with IsValid() that the cache holds the points for their
+ * samples and parameters, and use GetPoint().
+ *
+ * The cache is keyed by the sample container, its modified time, and the
+ * values of the transform parameters. Only the first samples that fit in
+ * MaximumMemory bytes are stored.
+ *
+ * The cache is filled single-threadedly, or by non-overlapping ranges of
+ * samples. Reading is thread-safe.
+ *
+ * \ingroup RegistrationMetrics
+ */
+
+template< class TFixedImage, class TMovingPoint >
+class TransformEvaluationCache : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef TransformEvaluationCache   Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( TransformEvaluationCache, Object );
+
+  /** Typedefs. */
+  typedef TMovingPoint                                          MovingPointType;
+  typedef ImageSample< TFixedImage >                            ImageSampleType;
+  typedef VectorDataContainer< unsigned long, ImageSampleType > ImageSampleContainerType;
+  typedef Array< double >                                       ParametersType;
+
+  /** The maximum memory of the cache in bytes. Default: 512 MB. */
+  itkSetMacro( MaximumMemory, std::size_t );
+  itkGetConstMacro( MaximumMemory, std::size_t );
+
+  /** Prepare the cache for the samples in the container, transformed with
+   * the given parameters. The cache is invalid until Validate() is called.
+   * Returns the number of samples that can be stored.
+   */
+  virtual unsigned long Allocate( const ImageSampleContainerType * container,
+    const ParametersType & parameters );
+
+  /** Store the mapped point of sample i. */
+  void SetPoint( const unsigned long i, const MovingPointType & point )
+  {
+    this->m_Points[ i ] = point;
+  }
+
+
+  /** Mark the cache as valid, after all points have been set. */
+  virtual void Validate( void );
+
+  /** Release the memory, and invalidate the cache. */
+  virtual void Clear( void );
+
+  /** Returns true if the cache holds the mapped points of the samples in
+   * the container, for these parameters.
+   */
+  virtual bool IsValid( const ImageSampleContainerType * container,
+    const ParametersType & parameters ) const;
+
+  /** Get the mapped point of sample i. Returns false if it is not stored. */
+  bool GetPoint( const unsigned long i, MovingPointType & point ) const
+  {
+    if( i >= this->m_NumberOfPoints )
+    {
+      return false;
+    }
+    point = this->m_Points[ i ];
+    return true;
+  }
+
+
+  /** Get the sample container of which the points are stored. */
+  const ImageSampleContainerType * GetContainer( void ) const
+  {
+    return this->m_Container;
+  }
+
+
+  /** Get the number of stored points. */
+  itkGetConstMacro( NumberOfPoints, unsigned long );
+
+  /** Get the memory used by the cache, in bytes. */
+  std::size_t GetMemorySize( void ) const;
+
+protected:
+
+  TransformEvaluationCache();
+  virtual ~TransformEvaluationCache() {}
+
+  /** PrintSelf. */
+  virtual void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** Get the modified time of the contents of the container. */
+  static unsigned long GetContainerTime( const ImageSampleContainerType * container );
+
+private:
+
+  TransformEvaluationCache( const Self & ); // purposely not implemented
+  void operator=( const Self & );           // purposely not implemented
+
+  std::size_t m_MaximumMemory;
+  bool        m_Valid;
+
+  /** The key of the cache. */
+  const ImageSampleContainerType * m_Container;
+  unsigned long                    m_ContainerTime;
+  ParametersType                   m_Parameters;
+
+  /** The mapped points. */
+  unsigned long                  m_NumberOfPoints;
+  std::vector< MovingPointType > m_Points;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkTransformEvaluationCache.hxx"
+#endif
+
+#endif // end #ifndef __itkTransformEvaluationCache_h
@@ -0,0 +1,197 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkTransformEvaluationCache_hxx
+#define __itkTransformEvaluationCache_hxx
+
+#include "itkTransformEvaluationCache.h"
+
+#include <algorithm>
+
+namespace itk
+{
+
+/**
+ * ******************* Constructor *******************
+ */
+
+template< class TFixedImage, class TMovingPoint >
+TransformEvaluationCache< TFixedImage, TMovingPoint >
+::TransformEvaluationCache()
+{
+  this->m_MaximumMemory  = 512 * 1024 * 1024;
+  this->m_Valid          = false;
+  this->m_Container      = 0;
+  this->m_ContainerTime  = 0;
+  this->m_NumberOfPoints = 0;
+
+} // end Constructor
+
+
+/**
+ * ******************* GetContainerTime *******************
+ */
+
+template< class TFixedImage, class TMovingPoint >
+unsigned long
+TransformEvaluationCache< TFixedImage, TMovingPoint >
+::GetContainerTime( const ImageSampleContainerType * container )
+{
+  /** The samplers do not always call Modified() on their output,
+   * so also check the time at which the output was generated.
+   */
+  return std::max(
+    static_cast< unsigned long >( container->GetMTime() ),
+    static_cast< unsigned long >( container->GetUpdateMTime() ) );
+
+} // end GetContainerTime()
+
+
+/**
+ * ******************* Allocate *******************
+ */
+
+template< class TFixedImage, class TMovingPoint >
+unsigned long
+TransformEvaluationCache< TFixedImage, TMovingPoint >
+::Allocate( const ImageSampleContainerType * container,
+  const ParametersType & parameters )
+{
+  if( container == 0 )
+  {
+    itkExceptionMacro( << "No sample container given." );
+  }
+
+  this->m_Valid         = false;
+  this->m_Container     = container;
+  this->m_ContainerTime = Self::GetContainerTime( container );
+  this->m_Parameters    = parameters;
+
+  /** Only the first samples that fit are stored. */
+  const unsigned long maximumNumberOfPoints = static_cast< unsigned long >(
+    this->m_MaximumMemory / sizeof( MovingPointType ) );
+  this->m_NumberOfPoints = std::min(
+    static_cast< unsigned long >( container->Size() ), maximumNumberOfPoints );
+  this->m_Points.resize( this->m_NumberOfPoints );
+
+  return this->m_NumberOfPoints;
+
+} // end Allocate()
+
+
+/**
+ * ******************* Validate *******************
+ */
+
+template< class TFixedImage, class TMovingPoint >
+void
+TransformEvaluationCache< TFixedImage, TMovingPoint >
+::Validate( void )
+{
+  this->m_Valid = this->m_Container != 0;
+
+} // end Validate()
+
+
+/**
+ * ******************* Clear *******************
+ */
+
+template< class TFixedImage, class TMovingPoint >
+void
+TransformEvaluationCache< TFixedImage, TMovingPoint >
+::Clear( void )
+{
+  /** Swap with an empty vector to really release the memory. */
+  std::vector< MovingPointType >().swap( this->m_Points );
+  this->m_Parameters     = ParametersType( 0 );
+  this->m_NumberOfPoints = 0;
+  this->m_Valid          = false;
+  this->m_Container      = 0;
+  this->m_ContainerTime  = 0;
+
+} // end Clear()
+
+
+/**
+ * ******************* IsValid *******************
+ */
+
+template< class TFixedImage, class TMovingPoint >
+bool
+TransformEvaluationCache< TFixedImage, TMovingPoint >
+::IsValid( const ImageSampleContainerType * container,
+  const ParametersType & parameters ) const
+{
+  if( !this->m_Valid || container != this->m_Container
+    || Self::GetContainerTime( container ) != this->m_ContainerTime
+    || parameters.GetSize() != this->m_Parameters.GetSize() )
+  {
+    return false;
+  }
+
+  /** The optimizers may change the parameters in place,
+   * so compare the values.
+   */
+  for( unsigned int i = 0; i < parameters.GetSize(); ++i )
+  {
+    if( parameters[ i ] != this->m_Parameters[ i ] )
+    {
+      return false;
+    }
+  }
+  return true;
+
+} // end IsValid()
+
+
+/**
+ * ******************* GetMemorySize *******************
+ */
+
+template< class TFixedImage, class TMovingPoint >
+std::size_t
+TransformEvaluationCache< TFixedImage, TMovingPoint >
+::GetMemorySize( void ) const
+{
+  return this->m_Points.capacity() * sizeof( MovingPointType );
+
+} // end GetMemorySize()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template< class TFixedImage, class TMovingPoint >
+void
+TransformEvaluationCache< TFixedImage, TMovingPoint >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "MaximumMemory: " << this->m_MaximumMemory << std::endl;
+  os << indent << "Valid: " << this->m_Valid << std::endl;
+  os << indent << "Container: " << this->m_Container << std::endl;
+  os << indent << "NumberOfPoints: " << this->m_NumberOfPoints << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkTransformEvaluationCache_hxx
@@ -91,6 +91,9 @@ protected:
     const InputImageRegionType & inputRegionForThread,
     ThreadIdType threadId );
 
+  /** Translate a position in the cropped input image region to an index. */
+  void PositionToIndex( unsigned long position, InputImageIndexType & index ) const;
+
 private:
 
   /** The private constructor. */
@@ -20,9 +20,6 @@
 
 #include "itkImageRandomSampler.h"
 
-#include "itkMersenneTwisterRandomVariateGenerator.h"
-#include "itkImageRandomConstIteratorWithIndex.h"
-
 namespace itk
 {
 
@@ -50,31 +47,34 @@ ImageRandomSampler< TInputImage >
   /** Reserve memory for the output. */
   sampleContainer->Reserve( this->GetNumberOfSamples() );
 
-  /** Setup a random iterator over the input image. */
-  typedef ImageRandomConstIteratorWithIndex< InputImageType > RandomIteratorType;
-  RandomIteratorType randIter( inputImage, this->GetCroppedInputImageRegion() );
-  randIter.GoToBegin();
+  /** The positions are drawn from the random number generator in the same
+   * sequence as in the multi-threaded version: one dummy jump first, one
+   * jump for each sample, and one dummy jump at the end. With a mask, the
+   * jumps to positions outside the mask are skipped.
+   */
+  const double numPixels = static_cast< double >(
+    this->GetCroppedInputImageRegion().GetNumberOfPixels() );
+  this->m_RandomGenerator->GetVariateWithOpenRange( numPixels - 0.5 ); // dummy jump
 
   /** Setup an iterator over the output, which is of ImageSampleContainerType. */
   typename ImageSampleContainerType::Iterator iter;
   typename ImageSampleContainerType::ConstIterator end = sampleContainer->End();
+  InputImageIndexType index;
 
   if( mask.IsNull() )
   {
-    /** number of samples + 1, because of the initial ++randIter. */
-    randIter.SetNumberOfSamples( this->GetNumberOfSamples() + 1 );
-    /** Advance one, in order to generate the same sequence as when using a mask */
-    ++randIter;
     for( iter = sampleContainer->Begin(); iter != end; ++iter )
     {
-      /** Get the index, transform it to the physical coordinates and put it in the sample. */
-      InputImageIndexType index = randIter.GetIndex();
+      /** Jump to a random position. */
+      this->PositionToIndex( static_cast< unsigned long >(
+        this->m_RandomGenerator->GetVariateWithOpenRange( numPixels - 0.5 ) ), index );
+
+      /** Transform the index to the physical coordinates and put it in the sample. */
       inputImage->TransformIndexToPhysicalPoint( index,
         ( *iter ).Value().m_ImageCoordinates );
       /** Get the value and put it in the sample. */
-      ( *iter ).Value().m_ImageValue = randIter.Get();
-      /** Jump to a random position. */
-      ++randIter;
+      ( *iter ).Value().m_ImageValue
+        = static_cast< ImageSampleValueType >( inputImage->GetPixel( index ) );
 
     } // end for loop
   }   // end if no mask
@@ -87,7 +87,8 @@ ImageRandomSampler< TInputImage >
     }
 
     /** Make sure we are not eternally trying to find samples: */
-    randIter.SetNumberOfSamples( 10 * this->GetNumberOfSamples() );
+    const unsigned long maximumNumberOfJumps = 10 * this->GetNumberOfSamples();
+    unsigned long       numberOfJumps        = 0;
 
     /** Loop over the sample container. */
     InputImagePointType inputPoint;
@@ -98,9 +99,11 @@ ImageRandomSampler< TInputImage >
       do
       {
         /** Jump to a random position. */
-        ++randIter;
+        this->PositionToIndex( static_cast< unsigned long >(
+          this->m_RandomGenerator->GetVariateWithOpenRange( numPixels - 0.5 ) ), index );
+        ++numberOfJumps;
         /** Check if we are not trying eternally to find a valid point. */
-        if( randIter.IsAtEnd() )
+        if( numberOfJumps >= maximumNumberOfJumps )
         {
           /** Squeeze the sample container to the size that is still valid. */
           typename ImageSampleContainerType::iterator stlnow = sampleContainer->begin();
@@ -110,8 +113,7 @@ ImageRandomSampler< TInputImage >
           itkExceptionMacro( << "Could not find enough image samples within "
                              << "reasonable time. Probably the mask is too small" );
         }
-        /** Get the index, and transform it to the physical coordinates. */
-        InputImageIndexType index = randIter.GetIndex();
+        /** Transform the index to the physical coordinates. */
         inputImage->TransformIndexToPhysicalPoint( index, inputPoint );
         /** Check if it's inside the mask. */
         insideMask = mask->IsInside( inputPoint );
@@ -120,15 +122,13 @@ ImageRandomSampler< TInputImage >
 
       /** Put the coordinates and the value in the sample. */
       ( *iter ).Value().m_ImageCoordinates = inputPoint;
-      ( *iter ).Value().m_ImageValue       = randIter.Get();
+      ( *iter ).Value().m_ImageValue
+        = static_cast< ImageSampleValueType >( inputImage->GetPixel( index ) );
 
     } // end for loop
+  }   // end if mask
 
-    /** Extra random sample to make sure the same sequence is generated
-     * with and without mask.
-     */
-    ++randIter;
-  }
+  this->m_RandomGenerator->GetVariateWithOpenRange( numPixels - 0.5 ); // dummy jump
 
 } // end GenerateData()
 
@@ -171,24 +171,12 @@ ImageRandomSampler< TInputImage >
   typename ImageSampleContainerType::ConstIterator end = sampleContainerThisThread->End();
 
   /** Fill the local sample container. */
-  unsigned long       sampleId    = sampleStart;
-  InputImageSizeType  regionSize  = this->GetCroppedInputImageRegion().GetSize();
-  InputImageIndexType regionIndex = this->GetCroppedInputImageRegion().GetIndex();
+  unsigned long sampleId = sampleStart;
   for( iter = sampleContainerThisThread->Begin(); iter != end; ++iter, sampleId++ )
   {
-    unsigned long randomPosition = static_cast< unsigned long >( this->m_RandomNumberList[ sampleId ] );
-
-    /** Translate randomPosition to an index, copied from ImageRandomConstIteratorWithIndex. */
-    unsigned long       residual;
     InputImageIndexType positionIndex;
-    for( unsigned int dim = 0; dim < InputImageDimension; dim++ )
-    {
-      const unsigned long sizeInThisDimension = regionSize[ dim ];
-      residual             = randomPosition % sizeInThisDimension;
-      positionIndex[ dim ] = residual + regionIndex[ dim ];
-      randomPosition      -= residual;
-      randomPosition      /= sizeInThisDimension;
-    }
+    this->PositionToIndex(
+      static_cast< unsigned long >( this->m_RandomNumberList[ sampleId ] ), positionIndex );
 
     /** Transform index to the physical coordinates and put it in the sample. */
     inputImage->TransformIndexToPhysicalPoint( positionIndex,
@@ -202,6 +190,30 @@ ImageRandomSampler< TInputImage >
 } // end ThreadedGenerateData()
 
 
+/**
+ * ******************* PositionToIndex *******************
+ */
+
+template< class TInputImage >
+void
+ImageRandomSampler< TInputImage >
+::PositionToIndex( unsigned long position, InputImageIndexType & index ) const
+{
+  /** Copied from ImageRandomConstIteratorWithIndex. */
+  const InputImageSizeType  regionSize  = this->GetCroppedInputImageRegion().GetSize();
+  const InputImageIndexType regionIndex = this->GetCroppedInputImageRegion().GetIndex();
+  for( unsigned int dim = 0; dim < InputImageDimension; dim++ )
+  {
+    const unsigned long sizeInThisDimension = regionSize[ dim ];
+    const unsigned long residual            = position % sizeInThisDimension;
+    index[ dim ] = residual + regionIndex[ dim ];
+    position    -= residual;
+    position    /= sizeInThisDimension;
+  }
+
+} // end PositionToIndex()
+
+
 } // end namespace itk
 
 #endif // end #ifndef __ImageRandomSampler_txx
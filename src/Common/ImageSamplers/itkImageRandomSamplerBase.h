@@ -19,6 +19,7 @@
 #define __ImageRandomSamplerBase_h
 
 #include "itkImageSamplerBase.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
 
 namespace itk
 {
@@ -27,7 +28,8 @@ namespace itk
  *
  * \brief This class is a base class for any image sampler that randomly picks samples.
  *
- * It adds the Set/GetNumberOfSamples function.
+ * It adds the Set/GetNumberOfSamples function, and the random number
+ * generator that the samplers draw from.
  *
  * \ingroup ImageSamplers
  */
@@ -71,6 +73,17 @@ public:
   /** Set the number of samples. */
   itkSetClampMacro( NumberOfSamples, unsigned long, 1, NumericTraits< unsigned long >::max() );
 
+  /** The random number generator. */
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+  typedef typename RandomGeneratorType::Pointer                  RandomGeneratorPointer;
+
+  /** Set/Get the random number generator. The global instance is used by
+   * default; elastix sets the generator of the run, so that parallel
+   * registrations do not draw from the same generator.
+   */
+  itkSetObjectMacro( RandomGenerator, RandomGeneratorType );
+  itkGetObjectMacro( RandomGenerator, RandomGeneratorType );
+
 protected:
 
   /** The constructor. */
@@ -88,6 +101,8 @@ protected:
   /** Member variable used when threading. */
   std::vector< double > m_RandomNumberList;
 
+  RandomGeneratorPointer m_RandomGenerator;
+
 private:
 
   /** The private constructor. */
@@ -19,7 +19,6 @@
 #define __ImageRandomSamplerSparseMask_h
 
 #include "itkImageRandomSamplerBase.h"
-#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkImageFullSampler.h"
 
 namespace itk
@@ -75,8 +74,8 @@ public:
   typedef typename InputImageType::PointType InputImagePointType;
 
   /** The random number generator used to generate random indices. */
-  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
-  typedef typename RandomGeneratorType::Pointer                  RandomGeneratorPointer;
+  typedef typename Superclass::RandomGeneratorType    RandomGeneratorType;
+  typedef typename Superclass::RandomGeneratorPointer RandomGeneratorPointer;
 
 protected:
 
@@ -101,7 +100,6 @@ protected:
     const InputImageRegionType & inputRegionForThread,
     ThreadIdType threadId );
 
-  RandomGeneratorPointer     m_RandomGenerator;
   InternalFullSamplerPointer m_InternalFullSampler;
 
 private:
@@ -32,9 +32,6 @@ template< class TInputImage >
 ImageRandomSamplerSparseMask< TInputImage >
 ::ImageRandomSamplerSparseMask()
 {
-  /** Setup random generator. */
-  this->m_RandomGenerator = RandomGeneratorType::GetInstance();
-
   this->m_InternalFullSampler = InternalFullSamplerType::New();
 
 } // end Constructor
@@ -209,7 +206,6 @@ ImageRandomSamplerSparseMask< TInputImage >
   Superclass::PrintSelf( os, indent );
 
   os << indent << "InternalFullSampler: " << this->m_InternalFullSampler.GetPointer() << std::endl;
-  os << indent << "RandomGenerator: " << this->m_RandomGenerator.GetPointer() << std::endl;
 
 } // end PrintSelf()
 
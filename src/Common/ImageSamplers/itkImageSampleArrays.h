@@ -0,0 +1,220 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __ImageSampleArrays_h
+#define __ImageSampleArrays_h
+
+#include "itkObject.h"
+#include "itkImageSample.h"
+#include "itkVectorDataContainer.h"
+#include "itkContinuousIndex.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class ImageSampleArrays
+ *
+ * \brief A structure-of-arrays copy of an image sample container.
+ *
+ * The ImageSamplers produce a container of ImageSample's, i.e. an array of
+ * structures. This class stores the same samples as separate arrays: one
+ * for each coordinate and one for the image values. Optionally, the
+ * continuous index of each sample and the image gradient at each sample
+ * are precomputed and stored as well.
+ *
+ * All arrays are aligned to Alignment bytes, and contain contiguous
+ * doubles, so that the metrics can loop over them with vectorized code
+ * and without loading the unused parts of a sample.
+ *
+ * Usage:
+ * \code
+ *   arrays->SetImage( fixedImage );
+ *   arrays->CopyFromContainer( sampler->GetOutput() );
+ *   const double * x = arrays->GetCoordinates( 0 );
+ *   const double * v = arrays->GetValues();
+ * \endcode
+ *
+ * CopyFromContainer() does nothing if the container was not modified since
+ * the previous call. CopyFromContainerIfReused() only copies the samples
+ * when they did not change since its previous call. Samples that change
+ * in every iteration, as with the random samplers, are then read only once,
+ * so copying them would not pay off.
+ *
+ * \ingroup ImageSamplers
+ */
+
+template< class TImage >
+class ImageSampleArrays : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef ImageSampleArrays          Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ImageSampleArrays, Object );
+
+  /** The image dimension. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TImage::ImageDimension );
+
+  /** The alignment of the arrays in bytes. */
+  itkStaticConstMacro( Alignment, unsigned int, 32 );
+
+  /** Typedefs. */
+  typedef TImage                                               ImageType;
+  typedef typename ImageType::ConstPointer                     ImageConstPointer;
+  typedef typename ImageType::PointType                        PointType;
+  typedef ImageSample< ImageType >                             ImageSampleType;
+  typedef typename ImageSampleType::RealType                   RealType;
+  typedef VectorDataContainer< unsigned long, ImageSampleType > ImageSampleContainerType;
+  typedef ContinuousIndex< double,
+    itkGetStaticConstMacro( ImageDimension ) >                 ContinuousIndexType;
+
+  /** Set the image from which the samples were taken. Only needed
+   * for the continuous indices and the gradients.
+   */
+  itkSetConstObjectMacro( Image, ImageType );
+  itkGetConstObjectMacro( Image, ImageType );
+
+  /** Also store the continuous index of each sample. Default: false. */
+  itkSetMacro( ComputeContinuousIndices, bool );
+  itkGetConstMacro( ComputeContinuousIndices, bool );
+  itkBooleanMacro( ComputeContinuousIndices );
+
+  /** Also store the image gradient at each sample, computed with central
+   * differences. Default: false.
+   */
+  itkSetMacro( ComputeGradients, bool );
+  itkGetConstMacro( ComputeGradients, bool );
+  itkBooleanMacro( ComputeGradients );
+
+  /** Copy the samples from the container into the arrays. */
+  virtual void CopyFromContainer( const ImageSampleContainerType * container );
+
+  /** Copy the samples from the container into the arrays, but only if the
+   * container did not change since the previous call of this function.
+   * Returns whether the arrays hold the current samples of the container.
+   */
+  virtual bool CopyFromContainerIfReused( const ImageSampleContainerType * container );
+
+  /** Get the number of samples. */
+  unsigned long GetNumberOfSamples( void ) const
+  {
+    return this->m_NumberOfSamples;
+  }
+
+
+  /** Get the array of the coordinates in dimension dim. */
+  const double * GetCoordinates( const unsigned int dim ) const
+  {
+    return this->m_Coordinates[ dim ];
+  }
+
+
+  /** Get the array of the image values. */
+  const double * GetValues( void ) const
+  {
+    return this->m_Values;
+  }
+
+
+  /** Get the array of continuous indices in dimension dim.
+   * Returns NULL if they were not computed.
+   */
+  const double * GetContinuousIndices( const unsigned int dim ) const
+  {
+    return this->m_ContinuousIndices[ dim ];
+  }
+
+
+  /** Get the array of image gradients in dimension dim.
+   * Returns NULL if they were not computed.
+   */
+  const double * GetGradients( const unsigned int dim ) const
+  {
+    return this->m_Gradients[ dim ];
+  }
+
+
+  /** Convenience function to get the point and value of sample i. */
+  void GetSample( const unsigned long i, PointType & point, RealType & value ) const
+  {
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      point[ d ] = this->m_Coordinates[ d ][ i ];
+    }
+    value = static_cast< RealType >( this->m_Values[ i ] );
+  }
+
+
+protected:
+
+  ImageSampleArrays();
+  virtual ~ImageSampleArrays() {}
+
+  /** PrintSelf. */
+  virtual void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** Allocate the buffer and set the array pointers. */
+  virtual void Allocate( const unsigned long numberOfSamples );
+
+  /** The time at which the container was last changed. */
+  static unsigned long GetContainerMTime( const ImageSampleContainerType * container );
+
+private:
+
+  ImageSampleArrays( const Self & );  // purposely not implemented
+  void operator=( const Self & );     // purposely not implemented
+
+  ImageConstPointer m_Image;
+  bool              m_ComputeContinuousIndices;
+  bool              m_ComputeGradients;
+
+  /** The container that was copied last, and its modified time then. */
+  const ImageSampleContainerType * m_Container;
+  unsigned long                    m_ContainerMTime;
+  unsigned long                    m_NumberOfSamples;
+  TimeStamp                        m_CopyTime;
+
+  /** The container that was seen by the last CopyFromContainerIfReused(). */
+  const ImageSampleContainerType * m_SeenContainer;
+  unsigned long                    m_SeenContainerMTime;
+
+  /** A single buffer holds all arrays. */
+  std::vector< double > m_Buffer;
+  double *              m_Coordinates[ ImageDimension ];
+  double *              m_Values;
+  double *              m_ContinuousIndices[ ImageDimension ];
+  double *              m_Gradients[ ImageDimension ];
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkImageSampleArrays.hxx"
+#endif
+
+#endif // end #ifndef __ImageSampleArrays_h
@@ -0,0 +1,277 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __ImageSampleArrays_hxx
+#define __ImageSampleArrays_hxx
+
+#include "itkImageSampleArrays.h"
+#include "itkCentralDifferenceImageFunction.h"
+
+#include <algorithm>
+
+namespace itk
+{
+
+/**
+ * ******************* Constructor *******************
+ */
+
+template< class TImage >
+ImageSampleArrays< TImage >
+::ImageSampleArrays()
+{
+  this->m_Image                    = 0;
+  this->m_ComputeContinuousIndices = false;
+  this->m_ComputeGradients         = false;
+  this->m_Container                = 0;
+  this->m_ContainerMTime           = 0;
+  this->m_NumberOfSamples          = 0;
+  this->m_SeenContainer            = 0;
+  this->m_SeenContainerMTime       = 0;
+  this->m_Values                   = 0;
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    this->m_Coordinates[ d ]       = 0;
+    this->m_ContinuousIndices[ d ] = 0;
+    this->m_Gradients[ d ]         = 0;
+  }
+
+} // end Constructor
+
+
+/**
+ * ******************* Allocate *******************
+ */
+
+template< class TImage >
+void
+ImageSampleArrays< TImage >
+::Allocate( const unsigned long numberOfSamples )
+{
+  /** Round the length of each array up to a multiple of the alignment. */
+  const unsigned long elementsPerAlignment = Alignment / sizeof( double );
+  const unsigned long stride = ( ( numberOfSamples + elementsPerAlignment - 1 )
+    / elementsPerAlignment ) * elementsPerAlignment;
+
+  unsigned int numberOfArrays = ImageDimension + 1;
+  if( this->m_ComputeContinuousIndices ) { numberOfArrays += ImageDimension; }
+  if( this->m_ComputeGradients ) { numberOfArrays += ImageDimension; }
+
+  /** Allocate some extra room, to be able to align the first array. */
+  this->m_Buffer.resize( numberOfArrays * stride + elementsPerAlignment );
+  const std::size_t address = reinterpret_cast< std::size_t >( &this->m_Buffer[ 0 ] );
+  const std::size_t misalignment = address % Alignment;
+  double * p = &this->m_Buffer[ 0 ];
+  if( misalignment != 0 )
+  {
+    p += ( Alignment - misalignment ) / sizeof( double );
+  }
+
+  /** Set the array pointers. */
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    this->m_Coordinates[ d ] = p; p += stride;
+  }
+  this->m_Values = p; p += stride;
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    this->m_ContinuousIndices[ d ] = 0;
+    if( this->m_ComputeContinuousIndices )
+    {
+      this->m_ContinuousIndices[ d ] = p; p += stride;
+    }
+  }
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    this->m_Gradients[ d ] = 0;
+    if( this->m_ComputeGradients )
+    {
+      this->m_Gradients[ d ] = p; p += stride;
+    }
+  }
+
+  this->m_NumberOfSamples = numberOfSamples;
+
+} // end Allocate()
+
+
+/**
+ * ******************* GetContainerMTime *******************
+ */
+
+template< class TImage >
+unsigned long
+ImageSampleArrays< TImage >
+::GetContainerMTime( const ImageSampleContainerType * container )
+{
+  /** The samplers do not always call Modified() on their output,
+   * so also check the time at which the output was generated.
+   */
+  return std::max(
+    static_cast< unsigned long >( container->GetMTime() ),
+    static_cast< unsigned long >( container->GetUpdateMTime() ) );
+
+} // end GetContainerMTime()
+
+
+/**
+ * ******************* CopyFromContainer *******************
+ */
+
+template< class TImage >
+void
+ImageSampleArrays< TImage >
+::CopyFromContainer( const ImageSampleContainerType * container )
+{
+  if( container == 0 )
+  {
+    itkExceptionMacro( << "No sample container given." );
+  }
+
+  const unsigned long containerMTime = GetContainerMTime( container );
+  if( container == this->m_Container
+    && containerMTime == this->m_ContainerMTime
+    && this->GetMTime() < this->m_CopyTime.GetMTime() )
+  {
+    return;
+  }
+
+  if( ( this->m_ComputeContinuousIndices || this->m_ComputeGradients )
+    && this->m_Image.IsNull() )
+  {
+    itkExceptionMacro( << "The image is needed to compute the continuous "
+                       << "indices or gradients, but it is not set." );
+  }
+
+  /** Allocate and copy the coordinates and values. */
+  const unsigned long numberOfSamples = container->Size();
+  this->Allocate( numberOfSamples );
+
+  typename ImageSampleContainerType::ConstIterator iter = container->Begin();
+  for( unsigned long i = 0; i < numberOfSamples; ++i, ++iter )
+  {
+    const ImageSampleType & sample = iter.Value();
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      this->m_Coordinates[ d ][ i ] = sample.m_ImageCoordinates[ d ];
+    }
+    this->m_Values[ i ] = static_cast< double >( sample.m_ImageValue );
+  }
+
+  /** Optionally compute the continuous indices. */
+  if( this->m_ComputeContinuousIndices )
+  {
+    PointType           point;
+    ContinuousIndexType cindex;
+    RealType            value;
+    for( unsigned long i = 0; i < numberOfSamples; ++i )
+    {
+      this->GetSample( i, point, value );
+      this->m_Image->TransformPhysicalPointToContinuousIndex( point, cindex );
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        this->m_ContinuousIndices[ d ][ i ] = cindex[ d ];
+      }
+    }
+  }
+
+  /** Optionally compute the image gradients. */
+  if( this->m_ComputeGradients )
+  {
+    typedef CentralDifferenceImageFunction< ImageType, double > GradientFunctionType;
+    typedef typename GradientFunctionType::OutputType           GradientType;
+    typename GradientFunctionType::Pointer gradientFunction = GradientFunctionType::New();
+    gradientFunction->SetInputImage( this->m_Image );
+
+    PointType point;
+    RealType  value;
+    for( unsigned long i = 0; i < numberOfSamples; ++i )
+    {
+      this->GetSample( i, point, value );
+      const GradientType gradient = gradientFunction->Evaluate( point );
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        this->m_Gradients[ d ][ i ] = gradient[ d ];
+      }
+    }
+  }
+
+  /** Remember which container was copied, and when. A later change of
+   * the settings makes the MTime of this object newer than the copy time.
+   */
+  this->m_Container      = container;
+  this->m_ContainerMTime = containerMTime;
+  this->m_CopyTime.Modified();
+
+} // end CopyFromContainer()
+
+
+/**
+ * ******************* CopyFromContainerIfReused *******************
+ */
+
+template< class TImage >
+bool
+ImageSampleArrays< TImage >
+::CopyFromContainerIfReused( const ImageSampleContainerType * container )
+{
+  if( container == 0 )
+  {
+    itkExceptionMacro( << "No sample container given." );
+  }
+
+  /** Samples that are seen for the first time are not copied. */
+  const unsigned long containerMTime = GetContainerMTime( container );
+  const bool          reused         = container == this->m_SeenContainer
+    && containerMTime == this->m_SeenContainerMTime;
+  this->m_SeenContainer      = container;
+  this->m_SeenContainerMTime = containerMTime;
+  if( !reused )
+  {
+    return false;
+  }
+
+  /** This does nothing if the samples were copied before. */
+  this->CopyFromContainer( container );
+  return true;
+
+} // end CopyFromContainerIfReused()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template< class TImage >
+void
+ImageSampleArrays< TImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Image: " << this->m_Image.GetPointer() << std::endl;
+  os << indent << "ComputeContinuousIndices: "
+     << this->m_ComputeContinuousIndices << std::endl;
+  os << indent << "ComputeGradients: " << this->m_ComputeGradients << std::endl;
+  os << indent << "NumberOfSamples: " << this->m_NumberOfSamples << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __ImageSampleArrays_hxx
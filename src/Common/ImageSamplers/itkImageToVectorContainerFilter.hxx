@@ -228,10 +228,10 @@ ImageToVectorContainerFilter< TInputImage, TOutputVectorContainer >
   str.Filter = this;
 
   this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
-  this->GetMultiThreader()->SetSingleMethod( this->ThreaderCallback, &str );
 
-  // multithread the execution
-  this->GetMultiThreader()->SingleMethodExecute();
+  // multithread the execution, on the thread pool if there is one
+  PersistentThreadPool::Launch( this->GetMultiThreader(),
+    this->ThreaderCallback, &str );
 
   // Call a method that can be overridden by a subclass to perform
   // some calculations after all the threads have completed
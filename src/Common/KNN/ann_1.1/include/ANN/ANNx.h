@@ -48,6 +48,20 @@ enum  {ANN_IN=0, ANN_OUT=1};  // shrinking indices
                 // what to do in case of error
 enum ANNerr {ANNwarn = 0, ANNabort = 1};
 
+//----------------------------------------------------------------------
+//  Thread-local storage
+//  The search routines keep their state in global variables, to keep
+//  the argument lists of the recursive calls short. These variables
+//  are thread-local, so that several threads can search the same tree
+//  at the same time. The trees themselves are not changed by a search.
+//  The performance statistics (ANN_PERF) are not thread-safe.
+//----------------------------------------------------------------------
+#if defined(_MSC_VER)
+  #define ANN_THREAD_LOCAL __declspec(thread)
+#else
+  #define ANN_THREAD_LOCAL __thread
+#endif
+
 //----------------------------------------------------------------------
 //  Maximum number of points to visit
 //  We have an option for terminating the search early if the
@@ -57,7 +71,7 @@ enum ANNerr {ANNwarn = 0, ANNabort = 1};
 //----------------------------------------------------------------------
 
 extern int    ANNmaxPtsVisited; // maximum number of pts visited
-extern int    ANNptsVisited;    // number of pts visited in search
+extern ANN_THREAD_LOCAL int ANNptsVisited; // number of pts visited in search
 
 //----------------------------------------------------------------------
 //  Global function declarations
@@ -214,6 +214,17 @@ ANNkd_tree::~ANNkd_tree()       // tree destructor
   if (bnd_box_hi != NULL) annDeallocPt(bnd_box_hi);
 }
 
+//----------------------------------------------------------------------
+//  This allocates KD_TRIVIAL, which is otherwise allocated when the
+//  first kd-tree is created. Trees may only be built concurrently
+//  after it has been allocated.
+//----------------------------------------------------------------------
+void annInit()        // prepare use of ANN
+{
+  if (KD_TRIVIAL == NULL)       // no trivial leaf node yet?
+    KD_TRIVIAL = new ANNkd_leaf(0, IDX_TRIVIAL);  // allocate it
+}
+
 //----------------------------------------------------------------------
 //  This is called with all use of ANN is finished.  It eliminates the
 //  minor memory leak caused by the allocation of KD_TRIVIAL.
@@ -266,8 +277,7 @@ void ANNkd_tree::SkeletonTree(      // construct skeleton tree
   }
 
   bnd_box_lo = bnd_box_hi = NULL;   // bounding box is nonexistent
-  if (KD_TRIVIAL == NULL)       // no trivial leaf node yet?
-    KD_TRIVIAL = new ANNkd_leaf(0, IDX_TRIVIAL);  // allocate it
+  annInit();              // allocate trivial leaf node
 }
 
 ANNkd_tree::ANNkd_tree(         // basic constructor
@@ -24,7 +24,8 @@
 namespace itk
 {
 
-unsigned int ANNBinaryTreeCreator::m_NumberOfANNBinaryTrees = 0;
+unsigned int        ANNBinaryTreeCreator::m_NumberOfANNBinaryTrees = 0;
+SimpleFastMutexLock ANNBinaryTreeCreator::m_ReferenceCountLock;
 
 /**
  * ************************ CreateANNkDTree *************************
@@ -106,7 +107,16 @@ ANNBinaryTreeCreator::DeleteANNBruteForceTree( ANNBruteForceTreeType * & tree )
 void
 ANNBinaryTreeCreator::IncreaseReferenceCount( void )
 {
+  /** The shared trivial leaf node of ANN is allocated here, and not by
+   * the tree constructor, so that trees can be built concurrently.
+   */
+  m_ReferenceCountLock.Lock();
+  if( m_NumberOfANNBinaryTrees == 0 )
+  {
+    annInit();
+  }
   m_NumberOfANNBinaryTrees++;
+  m_ReferenceCountLock.Unlock();
 }   // end IncreaseReferenceCount
 
 
@@ -117,11 +127,13 @@ ANNBinaryTreeCreator::IncreaseReferenceCount( void )
 void
 ANNBinaryTreeCreator::DecreaseReferenceCount( void )
 {
+  m_ReferenceCountLock.Lock();
   m_NumberOfANNBinaryTrees--;
   if( m_NumberOfANNBinaryTrees == 0 )
   {
     annClose();
   }
+  m_ReferenceCountLock.Unlock();
 }   // end DecreaseReferenceCount
 
 
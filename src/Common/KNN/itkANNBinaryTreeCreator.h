@@ -21,6 +21,7 @@
 
 #include "itkObject.h"
 #include "itkObjectFactory.h"
+#include "itkSimpleFastMutexLock.h"
 #include "ANN/ANN.h"
 
 namespace itk
@@ -65,6 +66,8 @@ public:
    * of any sort exist, we can call annClose(). This little
    * function is cause of going through the trouble of creating
    * this class with static creating functions.
+   * The reference count is protected by a lock, so that trees
+   * can be created and deleted by several threads at the same time.
    */
 
   /** Static function to create an ANN kDTree. */
@@ -101,7 +104,8 @@ private:
   void operator=( const Self & );         // purposely not implemented
 
   /** Member variables. */
-  static unsigned int m_NumberOfANNBinaryTrees;
+  static unsigned int        m_NumberOfANNBinaryTrees;
+  static SimpleFastMutexLock m_ReferenceCountLock;
 
 };
 
@@ -175,6 +175,10 @@ public:
   typedef typename Superclass
     ::NonZeroJacobianIndicesType NonZeroJacobianIndicesType;
   typedef typename Superclass::SpatialJacobianType SpatialJacobianType;
+  typedef typename Superclass
+    ::OutputPointContainerType OutputPointContainerType;
+  typedef typename Superclass
+    ::SpatialJacobianContainerType SpatialJacobianContainerType;
   typedef typename Superclass
     ::JacobianOfSpatialJacobianType JacobianOfSpatialJacobianType;
   typedef typename Superclass::SpatialHessianType SpatialHessianType;
@@ -202,6 +206,16 @@ public:
   /** This method specifies the region over which the grid resides. */
   virtual void SetGridRegion( const RegionType & region );
 
+  /** Use the vectorized kernels, also in the weights functions. */
+  virtual void SetUseVectorizedKernels( bool _arg );
+
+  /** Precompute the support cache, see the superclass. */
+  typedef typename Superclass::SupportCacheType SupportCacheType;
+  virtual unsigned long PrecomputeSupportCache(
+    const std::vector< InputPointType > & points,
+    const std::size_t maximumMemory,
+    SupportCacheType * cache ) const;
+
   /** Transform points by a B-spline deformable transformation. */
   OutputPointType TransformPoint( const InputPointType & point ) const;
 
@@ -223,6 +237,15 @@ public:
     itkGetStaticConstMacro( SplineOrder ) >                 SODerivativeWeightsFunctionType;
   typedef typename SODerivativeWeightsFunctionType::Pointer SODerivativeWeightsFunctionPointer;
 
+  /** Kernel typedefs, used for the separable evaluation along lines. */
+  typedef BSplineKernelFunction2<
+    itkGetStaticConstMacro( SplineOrder ) >                 KernelType;
+  typedef BSplineDerivativeKernelFunction<
+    itkGetStaticConstMacro( SplineOrder ) >                 DerivativeKernelType;
+  typedef Matrix< double,
+    itkGetStaticConstMacro( SpaceDimension ),
+    itkGetStaticConstMacro( SplineOrder ) + 1 >             OneDWeightsType;
+
   /** Parameter index array type. */
   typedef typename Superclass::ParameterIndexArrayType ParameterIndexArrayType;
 
@@ -240,6 +263,18 @@ public:
     ParameterIndexArrayType & indices,
     bool & inside ) const;
 
+  /** Transform a line of equidistant points. When the line runs parallel
+   * to one of the grid axes, the B-spline coefficients are contracted with
+   * the weights of the other axes only once per line, so that per point
+   * only the weights along the line have to be computed. Otherwise, the
+   * points are transformed one by one.
+   */
+  virtual void TransformPointsAlongLine(
+    const InputPointType & startPoint,
+    const InputVectorType & step,
+    const unsigned long numberOfPoints,
+    OutputPointContainerType & outputPoints ) const;
+
   /** Get number of weights. */
   unsigned long GetNumberOfWeights( void ) const
   {
@@ -271,6 +306,19 @@ public:
     const InputPointType & ipp,
     SpatialJacobianType & sj ) const;
 
+  /** Compute the spatial Jacobian at a line of equidistant points.
+   * When the line runs parallel to one of the grid axes, the B-spline
+   * coefficients are contracted with the weights of the other axes only
+   * once per line, which makes the cost per point independent of the
+   * size of the support region in those directions. Otherwise, the
+   * default point-by-point implementation is used.
+   */
+  virtual void GetSpatialJacobianAlongLine(
+    const InputPointType & startPoint,
+    const InputVectorType & step,
+    const unsigned long numberOfPoints,
+    SpatialJacobianContainerType & sjs ) const;
+
   /** Compute the spatial Hessian of the transformation. */
   virtual void GetSpatialHessian(
     const InputPointType & ipp,
@@ -326,6 +374,22 @@ protected:
     NonZeroJacobianIndicesType & nonZeroJacobianIndices,
     const RegionType & supportRegion ) const;
 
+  /** Check whether a line with the given step runs parallel to one of the
+   * grid axes, and return that axis.
+   */
+  bool GetLineAxis( const InputVectorType & step,
+    const unsigned long numberOfPoints, unsigned int & lineAxis ) const;
+
+  /** Contract the coefficients with the 1D weights of all axes except the
+   * line axis, for all grid indices along the line axis. The result for the
+   * s-th set of weights and dimension dim is stored at
+   * contraction[ ( s * SpaceDimension + dim ) * gridLineSize + g ].
+   */
+  void ContractCoefficientsAlongLine( const unsigned int lineAxis,
+    const IndexType & supportIndex,
+    const std::vector< OneDWeightsType > & weights1D,
+    std::vector< double > & contraction ) const;
+
   typedef typename Superclass::JacobianImageType JacobianImageType;
   typedef typename Superclass::JacobianPixelType JacobianPixelType;
 
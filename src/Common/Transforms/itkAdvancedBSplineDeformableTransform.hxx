@@ -158,6 +158,7 @@ AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
   {
 
     this->m_GridRegion = region;
+    this->m_GridTime.Modified();
 
     // set regions for each coefficient and Jacobian image
     for( unsigned int j = 0; j < SpaceDimension; j++ )
@@ -440,6 +441,74 @@ AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
 } // end GetJacobian()
 
 
+/**
+ * ********************* SetUseVectorizedKernels ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::SetUseVectorizedKernels( bool _arg )
+{
+  this->Superclass::SetUseVectorizedKernels( _arg );
+
+  /** Pass the setting to all weights functions. */
+  this->m_WeightsFunction->SetUseVectorizedKernels( _arg );
+  for( unsigned int i = 0; i < SpaceDimension; ++i )
+  {
+    this->m_DerivativeWeightsFunctions[ i ]->SetUseVectorizedKernels( _arg );
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      this->m_SODerivativeWeightsFunctions[ i ][ j ]->SetUseVectorizedKernels( _arg );
+    }
+  }
+
+} // end SetUseVectorizedKernels()
+
+
+/**
+ * ********************* PrecomputeSupportCache ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+unsigned long
+AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::PrecomputeSupportCache(
+  const std::vector< InputPointType > & points,
+  const std::size_t maximumMemory,
+  SupportCacheType * cache ) const
+{
+  cache->Clear();
+  if( !this->m_CoefficientImages[ 0 ] )
+  {
+    return 0;
+  }
+
+  /** Determine how many points fit in the requested memory. */
+  const unsigned long numberOfWeights = WeightsFunctionType::NumberOfWeights;
+  const std::size_t   bytesPerPoint   = numberOfWeights
+    * ( sizeof( double ) + sizeof( unsigned long ) ) + sizeof( unsigned char );
+  const unsigned long numberOfPoints = static_cast< unsigned long >(
+    std::min< std::size_t >( points.size(), maximumMemory / bytesPerPoint ) );
+
+  cache->Allocate( numberOfPoints, numberOfWeights, this, this->GetGridMTime() );
+
+  /** TransformPoint() computes the weights and the parameter indices. */
+  OutputPointType outputPoint;
+  bool            inside;
+  for( unsigned long i = 0; i < numberOfPoints; ++i )
+  {
+    WeightsType weights( cache->GetWeights( i ), numberOfWeights, false );
+    ParameterIndexArrayType indices( cache->GetIndices( i ), numberOfWeights, false );
+    this->TransformPoint( points[ i ], outputPoint, weights, indices, inside );
+    cache->SetInside( i, inside );
+  }
+
+  return numberOfPoints;
+
+} // end PrecomputeSupportCache()
+
+
 /**
  * ********************* EvaluateJacobianAndImageGradientProduct ****************************
  */
@@ -490,14 +559,27 @@ AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
   this->m_WeightsFunction->Evaluate( cindex, supportIndex, weights );
 
   /** Compute the inner product. */
-  NumberOfParametersType counter = 0;
-  for( unsigned int d = 0; d < SpaceDimension; ++d )
+  if( this->m_UseVectorizedKernels )
   {
-    const MovingImageGradientValueType mig = movingImageGradient[ d ];
-    for( NumberOfParametersType i = 0; i < nnzjiPerDimension; ++i )
+    double mig[ SpaceDimension ];
+    for( unsigned int d = 0; d < SpaceDimension; ++d )
     {
-      imageJacobian[ counter ] = weightsArray[ i ] * mig;
-      ++counter;
+      mig[ d ] = movingImageGradient[ d ];
+    }
+    BSplineVectorizedKernels::MultiplyWeightsWithGradient( weightsArray,
+      nnzjiPerDimension, mig, SpaceDimension, imageJacobian.data_block() );
+  }
+  else
+  {
+    NumberOfParametersType counter = 0;
+    for( unsigned int d = 0; d < SpaceDimension; ++d )
+    {
+      const MovingImageGradientValueType mig = movingImageGradient[ d ];
+      for( NumberOfParametersType i = 0; i < nnzjiPerDimension; ++i )
+      {
+        imageJacobian[ counter ] = weightsArray[ i ] * mig;
+        ++counter;
+      }
     }
   }
 
@@ -604,6 +686,377 @@ AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
 } // end GetSpatialJacobian()
 
 
+/**
+ * ********************* GetLineAxis ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+bool
+AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::GetLineAxis(
+  const InputVectorType & step,
+  const unsigned long numberOfPoints,
+  unsigned int & lineAxis ) const
+{
+  /** Compute the step of the line in grid index space. The other grid
+   * indices are considered constant if they drift less than a negligible
+   * fraction of a grid cell over the complete line. This accounts for
+   * round-off in the direction cosines.
+   */
+  Vector< double, SpaceDimension > tstep;
+  for( unsigned int j = 0; j < SpaceDimension; ++j )
+  {
+    tstep[ j ] = step[ j ];
+  }
+  const Vector< double, SpaceDimension > gridStep = this->m_PointToIndexMatrix * tstep;
+
+  lineAxis = 0;
+  unsigned int numberOfLineAxes = 0;
+  for( unsigned int j = 0; j < SpaceDimension; ++j )
+  {
+    if( vcl_abs( gridStep[ j ] ) * static_cast< double >( numberOfPoints ) > 1e-6 )
+    {
+      lineAxis = j;
+      ++numberOfLineAxes;
+    }
+  }
+
+  return numberOfLineAxes <= 1;
+
+} // end GetLineAxis()
+
+
+/**
+ * ********************* ContractCoefficientsAlongLine ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::ContractCoefficientsAlongLine(
+  const unsigned int lineAxis,
+  const IndexType & supportIndex,
+  const std::vector< OneDWeightsType > & weights1D,
+  std::vector< double > & contraction ) const
+{
+  /** Contract the coefficients with the weights of the other axes, for all
+   * grid indices g along the line axis:
+   *   C_{s,dim}[ g ] = \sum coefs_{dim} * \prod_{j != lineAxis} w^{(s)}_j,
+   * with w^{(s)} the s-th set of 1D weights.
+   */
+  const unsigned int  supportSize    = SplineOrder + 1;
+  const unsigned int  numberOfSets   = weights1D.size();
+  const RegionType    bufferedRegion = this->m_CoefficientImages[ 0 ]->GetBufferedRegion();
+  const unsigned long gridLineSize   = bufferedRegion.GetSize()[ lineAxis ];
+  const typename ImageType::OffsetValueType * offsetTable
+    = this->m_CoefficientImages[ 0 ]->GetOffsetTable();
+
+  contraction.assign( numberOfSets * SpaceDimension * gridLineSize, 0.0 );
+
+  unsigned long numberOfOtherSupportPoints = 1;
+  for( unsigned int j = 1; j < SpaceDimension; ++j )
+  {
+    numberOfOtherSupportPoints *= supportSize;
+  }
+
+  unsigned int          supportPosition[ SpaceDimension ];
+  std::vector< double > weightProducts( numberOfSets );
+  for( unsigned long p = 0; p < numberOfOtherSupportPoints; ++p )
+  {
+    /** Decode the position in the support region of the other axes. */
+    unsigned long rest = p;
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      if( j == lineAxis ) { supportPosition[ j ] = 0; continue; }
+      supportPosition[ j ] = rest % supportSize;
+      rest                /= supportSize;
+    }
+
+    /** Offset of the coefficient and the weight products. */
+    typename ImageType::OffsetValueType offset = 0;
+    std::fill( weightProducts.begin(), weightProducts.end(), 1.0 );
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      if( j == lineAxis ) { continue; }
+      offset += ( supportIndex[ j ] + supportPosition[ j ]
+        - bufferedRegion.GetIndex()[ j ] ) * offsetTable[ j ];
+      for( unsigned int s = 0; s < numberOfSets; ++s )
+      {
+        weightProducts[ s ] *= weights1D[ s ][ j ][ supportPosition[ j ] ];
+      }
+    }
+
+    for( unsigned int dim = 0; dim < SpaceDimension; ++dim )
+    {
+      const PixelType * coefs = this->m_CoefficientImages[ dim ]->GetBufferPointer() + offset;
+      for( unsigned long g = 0; g < gridLineSize; ++g )
+      {
+        const double coef = coefs[ g * offsetTable[ lineAxis ] ];
+        for( unsigned int s = 0; s < numberOfSets; ++s )
+        {
+          contraction[ ( s * SpaceDimension + dim ) * gridLineSize + g ]
+            += weightProducts[ s ] * coef;
+        }
+      }
+    }
+  }
+
+} // end ContractCoefficientsAlongLine()
+
+
+/**
+ * ********************* TransformPointsAlongLine ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::TransformPointsAlongLine(
+  const InputPointType & startPoint,
+  const InputVectorType & step,
+  const unsigned long numberOfPoints,
+  OutputPointContainerType & outputPoints ) const
+{
+  outputPoints.resize( numberOfPoints );
+  if( numberOfPoints == 0 ) { return; }
+
+  /** Oblique lines, or no coefficients: transform the points one by one. */
+  unsigned int lineAxis = 0;
+  if( !this->m_CoefficientImages[ 0 ]
+    || !this->GetLineAxis( step, numberOfPoints, lineAxis ) )
+  {
+    this->Superclass::TransformPointsAlongLine( startPoint, step, numberOfPoints, outputPoints );
+    return;
+  }
+
+  /** Check if the line crosses the valid region at all. */
+  ContinuousIndexType cindex0;
+  this->TransformPointToContinuousGridIndex( startPoint, cindex0 );
+  bool lineInside = true;
+  for( unsigned int j = 0; j < SpaceDimension; ++j )
+  {
+    if( j != lineAxis && ( cindex0[ j ] < this->m_ValidRegionBegin[ j ]
+      || cindex0[ j ] >= this->m_ValidRegionEnd[ j ] ) )
+    {
+      lineInside = false;
+    }
+  }
+
+  /** Compute the 1D weights of the other axes, which are constant along
+   * the line, and contract the coefficients with them.
+   */
+  const unsigned int                   supportSize = SplineOrder + 1;
+  typename KernelType::Pointer         kernel      = KernelType::New();
+  typename KernelType::WeightArrayType weightArray;
+  IndexType                            supportIndex0;
+  std::vector< OneDWeightsType >       weights1D( 1 );
+  std::vector< double >                contraction;
+  unsigned long                        gridLineSize  = 0;
+  long                                 gridLineBegin = 0;
+  if( lineInside )
+  {
+    this->m_WeightsFunction->ComputeStartIndex( cindex0, supportIndex0 );
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      kernel->Evaluate( cindex0[ j ] - static_cast< double >( supportIndex0[ j ] ), weightArray );
+      for( unsigned int k = 0; k < supportSize; ++k )
+      {
+        weights1D[ 0 ][ j ][ k ] = weightArray[ k ];
+      }
+    }
+    this->ContractCoefficientsAlongLine( lineAxis, supportIndex0, weights1D, contraction );
+
+    const RegionType bufferedRegion = this->m_CoefficientImages[ 0 ]->GetBufferedRegion();
+    gridLineSize  = bufferedRegion.GetSize()[ lineAxis ];
+    gridLineBegin = bufferedRegion.GetIndex()[ lineAxis ];
+  }
+
+  /** Now transform each point on the line, for which only the 1D weights
+   * along the line axis are needed.
+   */
+  InputPointType      point;
+  ContinuousIndexType cindex = cindex0;
+  for( unsigned long k = 0; k < numberOfPoints; ++k )
+  {
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      point[ j ] = startPoint[ j ] + static_cast< ScalarType >( k ) * step[ j ];
+    }
+    OutputPointType & outputPoint = outputPoints[ k ];
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      outputPoint[ j ] = point[ j ];
+    }
+    if( !lineInside ) { continue; }
+
+    ContinuousIndexType cindexPoint;
+    this->TransformPointToContinuousGridIndex( point, cindexPoint );
+    cindex[ lineAxis ] = cindexPoint[ lineAxis ];
+
+    // NOTE: if the support region does not lie totally within the grid
+    // we assume zero displacement and return the input point
+    if( !this->InsideValidRegion( cindex ) ) { continue; }
+
+    const long supportStart = static_cast< long >( vcl_floor( cindex[ lineAxis ]
+      - static_cast< double >( supportSize - 2.0 ) / 2.0 ) );
+    kernel->Evaluate( cindex[ lineAxis ] - static_cast< double >( supportStart ), weightArray );
+
+    const unsigned long g0 = static_cast< unsigned long >( supportStart - gridLineBegin );
+    for( unsigned int dim = 0; dim < SpaceDimension; ++dim )
+    {
+      const double * c   = &contraction[ dim * gridLineSize + g0 ];
+      double         sum = 0.0;
+      for( unsigned int m = 0; m < supportSize; ++m )
+      {
+        sum += weightArray[ m ] * c[ m ];
+      }
+      outputPoint[ dim ] += static_cast< ScalarType >( sum );
+    }
+  }
+
+} // end TransformPointsAlongLine()
+
+
+/**
+ * ********************* GetSpatialJacobianAlongLine ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::GetSpatialJacobianAlongLine(
+  const InputPointType & startPoint,
+  const InputVectorType & step,
+  const unsigned long numberOfPoints,
+  SpatialJacobianContainerType & sjs ) const
+{
+  sjs.resize( numberOfPoints );
+  if( numberOfPoints == 0 ) { return; }
+
+  /** Oblique line: compute the spatial Jacobian point by point. */
+  unsigned int lineAxis = 0;
+  if( !this->GetLineAxis( step, numberOfPoints, lineAxis ) )
+  {
+    this->Superclass::GetSpatialJacobianAlongLine( startPoint, step, numberOfPoints, sjs );
+    return;
+  }
+
+  /** Check if the line crosses the valid region at all. */
+  ContinuousIndexType cindex0;
+  this->TransformPointToContinuousGridIndex( startPoint, cindex0 );
+  for( unsigned int j = 0; j < SpaceDimension; ++j )
+  {
+    if( j == lineAxis ) { continue; }
+    if( cindex0[ j ] < this->m_ValidRegionBegin[ j ]
+      || cindex0[ j ] >= this->m_ValidRegionEnd[ j ] )
+    {
+      for( unsigned long k = 0; k < numberOfPoints; ++k )
+      {
+        sjs[ k ].SetIdentity();
+      }
+      return;
+    }
+  }
+
+  /** Compute the 1D weights and derivative weights of the other axes,
+   * which are constant along the line. The kernels are evaluated exactly
+   * as in the derivative weights functions. The i-th set of weights
+   * holds the derivative weights for axis i.
+   */
+  const unsigned int                     supportSize      = SplineOrder + 1;
+  typename KernelType::Pointer           kernel           = KernelType::New();
+  typename DerivativeKernelType::Pointer derivativeKernel = DerivativeKernelType::New();
+
+  IndexType                      supportIndex0;
+  std::vector< OneDWeightsType > weights1D( SpaceDimension );
+  this->m_DerivativeWeightsFunctions[ 0 ]->ComputeStartIndex( cindex0, supportIndex0 );
+  for( unsigned int j = 0; j < SpaceDimension; ++j )
+  {
+    double x = cindex0[ j ] - static_cast< double >( supportIndex0[ j ] );
+    for( unsigned int k = 0; k < supportSize; ++k )
+    {
+      const double w  = kernel->Evaluate( x );
+      const double dw = derivativeKernel->Evaluate( x );
+      for( unsigned int i = 0; i < SpaceDimension; ++i )
+      {
+        weights1D[ i ][ j ][ k ] = ( i == j ) ? dw : w;
+      }
+      x -= 1.0;
+    }
+  }
+
+  std::vector< double > contraction;
+  this->ContractCoefficientsAlongLine( lineAxis, supportIndex0, weights1D, contraction );
+
+  const RegionType    bufferedRegion = this->m_CoefficientImages[ 0 ]->GetBufferedRegion();
+  const unsigned long gridLineSize   = bufferedRegion.GetSize()[ lineAxis ];
+  const long          gridLineBegin  = bufferedRegion.GetIndex()[ lineAxis ];
+
+  /** Now compute the spatial Jacobian for each point on the line, for which
+   * only the 1D weights along the line axis are needed.
+   */
+  InputPointType      point;
+  ContinuousIndexType cindex = cindex0;
+  double              lineWeights[ SplineOrder + 1 ];
+  double              lineDerivativeWeights[ SplineOrder + 1 ];
+  SpatialJacobianType sj;
+  for( unsigned long k = 0; k < numberOfPoints; ++k )
+  {
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      point[ j ] = startPoint[ j ] + static_cast< ScalarType >( k ) * step[ j ];
+    }
+    ContinuousIndexType cindexPoint;
+    this->TransformPointToContinuousGridIndex( point, cindexPoint );
+    cindex[ lineAxis ] = cindexPoint[ lineAxis ];
+
+    // NOTE: if the support region does not lie totally within the grid
+    // we assume zero displacement and identity spatial Jacobian
+    if( !this->InsideValidRegion( cindex ) )
+    {
+      sjs[ k ].SetIdentity();
+      continue;
+    }
+
+    const long supportStart = static_cast< long >( vcl_floor( cindex[ lineAxis ]
+      - static_cast< double >( supportSize - 2.0 ) / 2.0 ) );
+    double x = cindex[ lineAxis ] - static_cast< double >( supportStart );
+    for( unsigned int m = 0; m < supportSize; ++m )
+    {
+      lineWeights[ m ]           = kernel->Evaluate( x );
+      lineDerivativeWeights[ m ] = derivativeKernel->Evaluate( x );
+      x                         -= 1.0;
+    }
+
+    const unsigned long g0 = static_cast< unsigned long >( supportStart - gridLineBegin );
+    for( unsigned int i = 0; i < SpaceDimension; ++i )
+    {
+      const double * w = ( i == lineAxis ) ? lineDerivativeWeights : lineWeights;
+      for( unsigned int dim = 0; dim < SpaceDimension; ++dim )
+      {
+        const double * c   = &contraction[ ( i * SpaceDimension + dim ) * gridLineSize + g0 ];
+        double         sum = 0.0;
+        for( unsigned int m = 0; m < supportSize; ++m )
+        {
+          sum += w[ m ] * c[ m ];
+        }
+        sj( dim, i ) = sum;
+      }
+    }
+
+    /** Take into account grid spacing and direction cosines. */
+    sjs[ k ] = sj * this->m_PointToIndexMatrix2;
+
+    /** Add contribution of spatial derivative of x. */
+    for( unsigned int dim = 0; dim < SpaceDimension; ++dim )
+    {
+      sjs[ k ]( dim, dim ) += 1.0;
+    }
+  }
+
+} // end GetSpatialJacobianAlongLine()
+
+
 /**
  * ********************* GetSpatialHessian ****************************
  */
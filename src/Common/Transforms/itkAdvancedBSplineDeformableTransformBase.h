@@ -21,6 +21,9 @@
 #include "itkAdvancedTransform.h"
 #include "itkImage.h"
 #include "itkImageRegion.h"
+#include "itkBSplineSupportCache.h"
+
+#include <vector>
 
 namespace itk
 {
@@ -217,6 +220,63 @@ public:
   //itkGetMacro( GridOrigin, OriginType );
   itkGetConstMacro( GridOrigin, OriginType );
 
+  /** Use the explicitly vectorized kernels of BSplineVectorizedKernels for
+   * the computation of the B-spline weights. The results agree with the
+   * default implementation within BSplineVectorizedKernels::GetTolerance().
+   * Default: false.
+   */
+  virtual void SetUseVectorizedKernels( bool _arg );
+
+  itkGetConstMacro( UseVectorizedKernels, bool );
+  itkBooleanMacro( UseVectorizedKernels );
+
+  /** Typedef for the support cache. */
+  typedef BSplineSupportCache SupportCacheType;
+
+  /** Precompute the support of the transform for a fixed set of points:
+   * for each point whether it lies inside the valid region, and the weights
+   * and parameter indices of its support region. The results are stored in
+   * the given cache, which is owned by the caller, so that callers with
+   * different points, e.g. several metrics, do not overwrite each other's
+   * results. The cache is used by TransformPointUsingSupportCache() and
+   * EvaluateJacobianWithImageGradientProductUsingSupportCache(), and stays
+   * valid until the grid changes. It does not depend on the parameters.
+   * Only the first points that fit in maximumMemory bytes are cached.
+   * Returns the number of cached points. This default implementation
+   * caches nothing.
+   */
+  virtual unsigned long PrecomputeSupportCache(
+    const std::vector< InputPointType > & points,
+    const std::size_t maximumMemory,
+    SupportCacheType * cache ) const;
+
+  /** Get the time at which the grid of this transform was last changed.
+   * A support cache is only valid for the grid time it was computed for.
+   */
+  unsigned long GetGridMTime( void ) const
+  {
+    return this->m_GridTime.GetMTime();
+  }
+
+
+  /** Transform point i of the support cache. The point itself must also be
+   * given. Returns false if point i is not cached.
+   */
+  bool TransformPointUsingSupportCache( const SupportCacheType * cache,
+    const unsigned long i,
+    const InputPointType & point, OutputPointType & outputPoint ) const;
+
+  /** Compute the inner product of the Jacobian with the moving image
+   * gradient for point i of the support cache. Returns false if point i
+   * is not cached.
+   */
+  bool EvaluateJacobianWithImageGradientProductUsingSupportCache(
+    const SupportCacheType * cache,
+    const unsigned long i,
+    const MovingImageGradientType & movingImageGradient,
+    DerivativeType & imageJacobian,
+    NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const;
+
   /** Parameter index array type. */
   typedef Array< unsigned long > ParameterIndexArrayType;
 
@@ -341,6 +401,12 @@ protected:
   /** Odd or even order B-spline. */
   bool m_SplineOrderOdd;
 
+  /** Use the vectorized kernels for the B-spline weights. */
+  bool m_UseVectorizedKernels;
+
+  /** The time at which the grid was last changed. */
+  TimeStamp m_GridTime;
+
   /** Keep a pointer to the input parameters. */
   const ParametersType * m_InputParametersPointer;
 
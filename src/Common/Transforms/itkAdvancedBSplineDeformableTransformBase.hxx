@@ -43,6 +43,8 @@ AdvancedBSplineDeformableTransformBase< TScalarType, NDimensions >
   this->m_GridSpacing.Fill( 1.0 );     // default spacing is all ones
   this->m_GridDirection.SetIdentity(); // default spacing is all ones
   this->m_GridOffsetTable.Fill( 0 );
+  this->m_UseVectorizedKernels = false;
+  this->m_GridTime.Modified();
 
   this->m_InternalParametersBuffer = ParametersType( 0 );
   // Make sure the parameters pointer is not NULL after construction.
@@ -212,6 +214,7 @@ AdvancedBSplineDeformableTransformBase< TScalarType, NDimensions >
     }
 
     this->UpdatePointIndexConversions();
+    this->m_GridTime.Modified();
 
     this->Modified();
   }
@@ -235,6 +238,7 @@ AdvancedBSplineDeformableTransformBase< TScalarType, NDimensions >
     }
 
     this->UpdatePointIndexConversions();
+    this->m_GridTime.Modified();
 
     this->Modified();
   }
@@ -258,6 +262,140 @@ AdvancedBSplineDeformableTransformBase< TScalarType, NDimensions >
       this->m_WrappedImage[ j ]->SetOrigin( this->m_GridOrigin.GetDataPointer() );
     }
 
+    this->m_GridTime.Modified();
+    this->Modified();
+  }
+
+}
+
+
+// Precompute the support cache
+template< class TScalarType, unsigned int NDimensions >
+unsigned long
+AdvancedBSplineDeformableTransformBase< TScalarType, NDimensions >
+::PrecomputeSupportCache(
+  const std::vector< InputPointType > & itkNotUsed( points ),
+  const std::size_t itkNotUsed( maximumMemory ),
+  SupportCacheType * cache ) const
+{
+  cache->Clear();
+  return 0;
+
+}
+
+
+// Transform a point using the support cache
+template< class TScalarType, unsigned int NDimensions >
+bool
+AdvancedBSplineDeformableTransformBase< TScalarType, NDimensions >
+::TransformPointUsingSupportCache( const SupportCacheType * cache,
+  const unsigned long i,
+  const InputPointType & point, OutputPointType & outputPoint ) const
+{
+  if( i >= cache->GetSize() || !this->m_CoefficientImages[ 0 ] )
+  {
+    return false;
+  }
+
+  /** Zero displacement outside the valid region. */
+  outputPoint = point;
+  if( !cache->GetInside( i ) )
+  {
+    return true;
+  }
+
+  /** Multiply the weights with the coefficients, in the same order as
+   * TransformPoint() does.
+   */
+  const unsigned long   nw      = cache->GetNumberOfWeights();
+  const double *        weights = cache->GetWeights( i );
+  const unsigned long * indices = cache->GetIndices( i );
+  OutputPointType       displacement;
+  displacement.Fill( NumericTraits< ScalarType >::ZeroValue() );
+  for( unsigned int j = 0; j < SpaceDimension; ++j )
+  {
+    const PixelType * coefficients = this->m_CoefficientImages[ j ]->GetBufferPointer();
+    for( unsigned long k = 0; k < nw; ++k )
+    {
+      displacement[ j ] += static_cast< ScalarType >(
+        weights[ k ] * coefficients[ indices[ k ] ] );
+    }
+  }
+
+  for( unsigned int j = 0; j < SpaceDimension; ++j )
+  {
+    outputPoint[ j ] = displacement[ j ] + point[ j ];
+  }
+  return true;
+
+}
+
+
+// Evaluate the Jacobian times the image gradient using the support cache
+template< class TScalarType, unsigned int NDimensions >
+bool
+AdvancedBSplineDeformableTransformBase< TScalarType, NDimensions >
+::EvaluateJacobianWithImageGradientProductUsingSupportCache(
+  const SupportCacheType * cache,
+  const unsigned long i,
+  const MovingImageGradientType & movingImageGradient,
+  DerivativeType & imageJacobian,
+  NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const
+{
+  if( i >= cache->GetSize() )
+  {
+    return false;
+  }
+
+  const unsigned long          nw    = cache->GetNumberOfWeights();
+  const NumberOfParametersType nnzji = nw * SpaceDimension;
+  const NumberOfParametersType parametersPerDim
+    = this->GetNumberOfParametersPerDimension();
+  nonZeroJacobianIndices.resize( nnzji );
+
+  /** Zero Jacobian outside the valid region. */
+  if( !cache->GetInside( i ) )
+  {
+    for( NumberOfParametersType k = 0; k < nnzji; ++k )
+    {
+      nonZeroJacobianIndices[ k ] = k;
+    }
+    imageJacobian.Fill( 0.0 );
+    return true;
+  }
+
+  /** The parameter indices of dimension d follow from those of the first
+   * dimension. These equal the nonzero Jacobian indices, since the
+   * coefficient images wrap the parameters.
+   */
+  const double *         weights = cache->GetWeights( i );
+  const unsigned long *  indices = cache->GetIndices( i );
+  NumberOfParametersType counter = 0;
+  for( unsigned int d = 0; d < SpaceDimension; ++d )
+  {
+    const MovingImageGradientValueType mig    = movingImageGradient[ d ];
+    const NumberOfParametersType       offset = d * parametersPerDim;
+    for( unsigned long k = 0; k < nw; ++k )
+    {
+      imageJacobian[ counter ] = weights[ k ] * mig;
+      nonZeroJacobianIndices[ counter ] = indices[ k ] + offset;
+      ++counter;
+    }
+  }
+  return true;
+
+}
+
+
+// Use the vectorized kernels
+template< class TScalarType, unsigned int NDimensions >
+void
+AdvancedBSplineDeformableTransformBase< TScalarType, NDimensions >
+::SetUseVectorizedKernels( bool _arg )
+{
+  if( this->m_UseVectorizedKernels != _arg )
+  {
+    this->m_UseVectorizedKernels = _arg;
     this->Modified();
   }
 
@@ -555,6 +693,8 @@ AdvancedBSplineDeformableTransformBase< TScalarType, NDimensions >
   os << indent << "GridSpacing: " << this->m_GridSpacing << std::endl;
   os << indent << "GridDirection:\n" << this->m_GridDirection << std::endl;
   os << indent << "GridOffsetTable: " << this->m_GridOffsetTable << std::endl;
+  os << indent << "UseVectorizedKernels: "
+     << ( this->m_UseVectorizedKernels ? "true" : "false" ) << std::endl;
   os << indent << "IndexToPoint:\n" << this->m_IndexToPoint << std::endl;
   os << indent << "PointToIndex:\n" << this->m_PointToIndexMatrix << std::endl;
   os << indent << "PointToIndex2:\n" << this->m_PointToIndexMatrix2 << std::endl;
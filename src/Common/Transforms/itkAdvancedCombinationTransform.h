@@ -92,6 +92,8 @@ public:
   typedef typename Superclass::OutputPointType               OutputPointType;
   typedef typename Superclass::NonZeroJacobianIndicesType    NonZeroJacobianIndicesType;
   typedef typename Superclass::SpatialJacobianType           SpatialJacobianType;
+  typedef typename Superclass::OutputPointContainerType      OutputPointContainerType;
+  typedef typename Superclass::SpatialJacobianContainerType  SpatialJacobianContainerType;
   typedef typename Superclass::JacobianOfSpatialJacobianType JacobianOfSpatialJacobianType;
   typedef typename Superclass::SpatialHessianType            SpatialHessianType;
   typedef typename Superclass::JacobianOfSpatialHessianType  JacobianOfSpatialHessianType;
@@ -213,6 +215,20 @@ public:
   /** Set the fixed parameters in the CurrentTransform. */
   virtual void SetFixedParameters( const FixedParametersType & fixedParam );
 
+  /** Set the transformation parameters and freeze them. While frozen,
+   * SetParameters() and SetParametersByValue() do nothing when called with
+   * the frozen parameters, and throw an exception otherwise. This allows
+   * several metrics that share this transform to be evaluated concurrently,
+   * since each of them sets the parameters before computing its value.
+   */
+  virtual void SetAndFreezeParameters( const ParametersType & param );
+
+  /** Allow the parameters to be changed again. */
+  virtual void UnfreezeParameters( void );
+
+  /** Get whether the parameters are frozen. */
+  itkGetConstMacro( ParametersFrozen, bool );
+
   /** Return the inverse \f$T^{-1}\f$ of the transform.
    *  This is only possible when:
    * - both the inverses of the initial and the current transform
@@ -258,6 +274,28 @@ public:
     const InputPointType & ipp,
     SpatialJacobianType & sj ) const;
 
+  /** Transform a line of equidistant points. The line is passed on to the
+   * current transform if there is no initial transform, if the transforms
+   * are added, or if the initial transform is linear.
+   */
+  virtual void TransformPointsAlongLine(
+    const InputPointType & startPoint,
+    const InputVectorType & step,
+    const unsigned long numberOfPoints,
+    OutputPointContainerType & outputPoints ) const;
+
+  /** Compute the spatial Jacobian at a line of equidistant points.
+   * The line is passed on to the current transform if there is no initial
+   * transform, or if the initial transform is linear. In that case a line
+   * is mapped to a line, so that the current transform can still exploit
+   * the coherence of the points.
+   */
+  virtual void GetSpatialJacobianAlongLine(
+    const InputPointType & startPoint,
+    const InputVectorType & step,
+    const unsigned long numberOfPoints,
+    SpatialJacobianContainerType & sjs ) const;
+
   /** Compute the spatial Hessian of the transformation. */
   virtual void GetSpatialHessian(
     const InputPointType & ipp,
@@ -625,11 +663,20 @@ protected:
   bool m_UseAddition;
   bool m_UseComposition;
 
+  /** Returns true if the parameters are frozen and equal to param.
+   * Throws an exception if they are frozen and differ from param.
+   */
+  bool CheckFrozenParameters( const ParametersType & param ) const;
+
 private:
 
   AdvancedCombinationTransform( const Self & ); // purposely not implemented
   void operator=( const Self & );               // purposely not implemented
 
+  /** A copy of the frozen parameters. */
+  bool           m_ParametersFrozen;
+  ParametersType m_FrozenParameters;
+
 };
 
 } // end namespace itk
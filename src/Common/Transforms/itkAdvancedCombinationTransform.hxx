@@ -39,6 +39,8 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
   this->m_UseAddition    = false;
   this->m_UseComposition = true;
 
+  this->m_ParametersFrozen = false;
+
   /** Set everything to have no current transform. */
   this->m_SelectedTransformPointFunction
     = &Self::TransformPointNoCurrentTransform;
@@ -321,6 +323,12 @@ void
 AdvancedCombinationTransform< TScalarType, NDimensions >
 ::SetParameters( const ParametersType & param )
 {
+  /** Nothing to do if these parameters are frozen. */
+  if( this->CheckFrozenParameters( param ) )
+  {
+    return;
+  }
+
   /** Set the parameters in the m_CurrentTransform. */
   if( this->m_CurrentTransform.IsNotNull() )
   {
@@ -369,6 +377,12 @@ void
 AdvancedCombinationTransform< TScalarType, NDimensions >
 ::SetParametersByValue( const ParametersType & param )
 {
+  /** Nothing to do if these parameters are frozen. */
+  if( this->CheckFrozenParameters( param ) )
+  {
+    return;
+  }
+
   /** Set the parameters in the m_CurrentTransfom. */
   if( this->m_CurrentTransform.IsNotNull() )
   {
@@ -384,6 +398,70 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
 } // end SetParametersByValue()
 
 
+/**
+ * ***************** SetAndFreezeParameters **************************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::SetAndFreezeParameters( const ParametersType & param )
+{
+  this->UnfreezeParameters();
+  this->SetParameters( param );
+
+  /** Keep a copy, since param may change while the parameters are frozen. */
+  this->m_FrozenParameters = param;
+  this->m_ParametersFrozen = true;
+
+} // end SetAndFreezeParameters()
+
+
+/**
+ * ***************** UnfreezeParameters **************************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::UnfreezeParameters( void )
+{
+  this->m_ParametersFrozen = false;
+
+} // end UnfreezeParameters()
+
+
+/**
+ * ***************** CheckFrozenParameters **************************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+bool
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::CheckFrozenParameters( const ParametersType & param ) const
+{
+  if( !this->m_ParametersFrozen )
+  {
+    return false;
+  }
+
+  /** Only the copy is read here, so this is safe to call concurrently. */
+  if( param.GetSize() != this->m_FrozenParameters.GetSize() )
+  {
+    itkExceptionMacro( << "The parameters are frozen, and cannot be changed." );
+  }
+  for( unsigned int i = 0; i < param.GetSize(); ++i )
+  {
+    if( param[ i ] != this->m_FrozenParameters[ i ] )
+    {
+      itkExceptionMacro( << "The parameters are frozen, and cannot be changed." );
+    }
+  }
+  return true;
+
+} // end CheckFrozenParameters()
+
+
 /**
  * ***************** GetInverse **************************
  */
@@ -1670,6 +1748,140 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
 } // end GetSpatialJacobian()
 
 
+/**
+ * ****************** TransformPointsAlongLine ****************************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::TransformPointsAlongLine(
+  const InputPointType & startPoint,
+  const InputVectorType & step,
+  const unsigned long numberOfPoints,
+  OutputPointContainerType & outputPoints ) const
+{
+  /** Without a current transform the default implementation throws. */
+  if( this->m_CurrentTransform.IsNull() )
+  {
+    this->Superclass::TransformPointsAlongLine( startPoint, step, numberOfPoints, outputPoints );
+    return;
+  }
+
+  /** CURRENT ONLY: simply pass on the line. */
+  if( this->m_InitialTransform.IsNull() )
+  {
+    this->m_CurrentTransform->TransformPointsAlongLine(
+      startPoint, step, numberOfPoints, outputPoints );
+    return;
+  }
+
+  if( this->m_UseAddition )
+  {
+    /** ADDITION: T(x) = T_0(x) + T_1(x) - x. */
+    this->m_CurrentTransform->TransformPointsAlongLine(
+      startPoint, step, numberOfPoints, outputPoints );
+    InputPointType point;
+    for( unsigned long k = 0; k < numberOfPoints; ++k )
+    {
+      for( unsigned int j = 0; j < NDimensions; ++j )
+      {
+        point[ j ] = startPoint[ j ] + static_cast< ScalarType >( k ) * step[ j ];
+      }
+      const OutputPointType initialPoint = this->m_InitialTransform->TransformPoint( point );
+      for( unsigned int j = 0; j < NDimensions; ++j )
+      {
+        outputPoints[ k ][ j ] += initialPoint[ j ] - point[ j ];
+      }
+    }
+  }
+  else if( this->m_InitialTransform->IsLinear() )
+  {
+    /** COMPOSITION: T(x) = T_1( T_0(x) ), with T_0(x) on a line. */
+    SpatialJacobianType sj0;
+    this->m_InitialTransform->GetSpatialJacobian( startPoint, sj0 );
+    const InputVectorType mappedStep = sj0 * step;
+    this->m_CurrentTransform->TransformPointsAlongLine(
+      this->m_InitialTransform->TransformPoint( startPoint ),
+      mappedStep, numberOfPoints, outputPoints );
+  }
+  else
+  {
+    /** A nonlinear initial transform does not map the line to a line. */
+    this->Superclass::TransformPointsAlongLine( startPoint, step, numberOfPoints, outputPoints );
+  }
+
+} // end TransformPointsAlongLine()
+
+
+/**
+ * ****************** GetSpatialJacobianAlongLine ****************************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::GetSpatialJacobianAlongLine(
+  const InputPointType & startPoint,
+  const InputVectorType & step,
+  const unsigned long numberOfPoints,
+  SpatialJacobianContainerType & sjs ) const
+{
+  /** Without a current transform the default implementation throws. */
+  if( this->m_CurrentTransform.IsNull() )
+  {
+    this->Superclass::GetSpatialJacobianAlongLine( startPoint, step, numberOfPoints, sjs );
+    return;
+  }
+
+  /** CURRENT ONLY: simply pass on the line. */
+  if( this->m_InitialTransform.IsNull() )
+  {
+    this->m_CurrentTransform->GetSpatialJacobianAlongLine(
+      startPoint, step, numberOfPoints, sjs );
+    return;
+  }
+
+  /** A nonlinear initial transform does not map the line to a line. */
+  if( !this->m_InitialTransform->IsLinear() )
+  {
+    this->Superclass::GetSpatialJacobianAlongLine( startPoint, step, numberOfPoints, sjs );
+    return;
+  }
+
+  /** The spatial Jacobian of the linear initial transform is constant. */
+  SpatialJacobianType sj0;
+  this->m_InitialTransform->GetSpatialJacobian( startPoint, sj0 );
+
+  if( this->m_UseAddition )
+  {
+    /** ADDITION: sj = sj0 + sj1 - I. */
+    SpatialJacobianType identity;
+    identity.SetIdentity();
+    const SpatialJacobianType sj0MinusIdentity = sj0 - identity;
+    this->m_CurrentTransform->GetSpatialJacobianAlongLine(
+      startPoint, step, numberOfPoints, sjs );
+    for( unsigned long k = 0; k < numberOfPoints; ++k )
+    {
+      sjs[ k ] += sj0MinusIdentity;
+    }
+  }
+  else
+  {
+    /** COMPOSITION: sj = sj1( T_0(x) ) * sj0, with T_0(x) on a line. */
+    const InputVectorType mappedStep = sj0 * step;
+    this->m_CurrentTransform->GetSpatialJacobianAlongLine(
+      this->m_InitialTransform->TransformPoint( startPoint ),
+      mappedStep, numberOfPoints, sjs );
+    for( unsigned long k = 0; k < numberOfPoints; ++k )
+    {
+      sjs[ k ] = sjs[ k ] * sj0;
+    }
+  }
+
+} // end GetSpatialJacobianAlongLine()
+
+
 /**
  * ****************** GetSpatialHessian ****************************
  */
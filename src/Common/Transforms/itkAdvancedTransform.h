@@ -235,6 +235,42 @@ public:
     const InputPointType & ipp,
     SpatialJacobianType & sj ) const = 0;
 
+  /** Container for the transformed points of a line of points. */
+  typedef std::vector< OutputPointType > OutputPointContainerType;
+
+  /** Transform a line of equidistant points,
+   * p_k = startPoint + k * step, for k = 0, ..., numberOfPoints - 1.
+   *
+   * This is typically used to process an image scanline, for example by
+   * a resampler. By default TransformPoint() is called for each point.
+   * Transforms that can exploit the coherence of consecutive points, like
+   * the B-spline transform, override this function. The container
+   * outputPoints is resized to numberOfPoints.
+   */
+  virtual void TransformPointsAlongLine(
+    const InputPointType & startPoint,
+    const InputVectorType & step,
+    const unsigned long numberOfPoints,
+    OutputPointContainerType & outputPoints ) const;
+
+  /** Container for the spatial Jacobians of a line of points. */
+  typedef std::vector< SpatialJacobianType > SpatialJacobianContainerType;
+
+  /** Compute the spatial Jacobian at a line of equidistant points,
+   * p_k = startPoint + k * step, for k = 0, ..., numberOfPoints - 1.
+   *
+   * This is typically used to process an image scanline. By default
+   * GetSpatialJacobian() is called for each point. Transforms that
+   * can exploit the coherence of consecutive points, like the B-spline
+   * transform, override this function. The container sjs is resized
+   * to numberOfPoints.
+   */
+  virtual void GetSpatialJacobianAlongLine(
+    const InputPointType & startPoint,
+    const InputVectorType & step,
+    const unsigned long numberOfPoints,
+    SpatialJacobianContainerType & sjs ) const;
+
   /** Override some pure virtual ITK4 functions. */
   virtual void ComputeJacobianWithRespectToParameters(
     const InputPointType & itkNotUsed( p ), JacobianType & itkNotUsed( j ) ) const
@@ -107,6 +107,64 @@ AdvancedTransform< TScalarType, NInputDimensions, NOutputDimensions >
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ********************* TransformPointsAlongLine ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+AdvancedTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::TransformPointsAlongLine(
+  const InputPointType & startPoint,
+  const InputVectorType & step,
+  const unsigned long numberOfPoints,
+  OutputPointContainerType & outputPoints ) const
+{
+  outputPoints.resize( numberOfPoints );
+
+  /** Simply transform the points one by one. */
+  InputPointType point;
+  for( unsigned long k = 0; k < numberOfPoints; ++k )
+  {
+    for( unsigned int j = 0; j < NInputDimensions; ++j )
+    {
+      point[ j ] = startPoint[ j ] + static_cast< ScalarType >( k ) * step[ j ];
+    }
+    outputPoints[ k ] = this->TransformPoint( point );
+  }
+
+} // end TransformPointsAlongLine()
+
+
+/**
+ * ********************* GetSpatialJacobianAlongLine ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+AdvancedTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::GetSpatialJacobianAlongLine(
+  const InputPointType & startPoint,
+  const InputVectorType & step,
+  const unsigned long numberOfPoints,
+  SpatialJacobianContainerType & sjs ) const
+{
+  sjs.resize( numberOfPoints );
+
+  /** Simply compute the spatial Jacobian point by point. */
+  InputPointType point;
+  for( unsigned long k = 0; k < numberOfPoints; ++k )
+  {
+    for( unsigned int j = 0; j < NInputDimensions; ++j )
+    {
+      point[ j ] = startPoint[ j ] + static_cast< ScalarType >( k ) * step[ j ];
+    }
+    this->GetSpatialJacobian( point, sjs[ k ] );
+  }
+
+} // end GetSpatialJacobianAlongLine()
+
+
 /**
  * ********************* GetNumberOfNonZeroJacobianIndices ****************************
  */
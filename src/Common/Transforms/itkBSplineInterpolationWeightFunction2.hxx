@@ -49,6 +49,19 @@ BSplineInterpolationWeightFunction2< TCoordRep, VSpaceDimension, VSplineOrder >
   const IndexType & startIndex,
   OneDWeightsType & weights1D ) const
 {
+  /** Use the vectorized kernel for the common cubic case. */
+  if( this->m_UseVectorizedKernels && SplineOrder == 3 )
+  {
+    double u[ SpaceDimension ];
+    for( unsigned int i = 0; i < SpaceDimension; ++i )
+    {
+      u[ i ] = index[ i ] - static_cast< double >( startIndex[ i ] );
+    }
+    BSplineVectorizedKernels::EvaluateCubicWeights(
+      u, SpaceDimension, weights1D.GetVnlMatrix().data_block() );
+    return;
+  }
+
   /** Compute the 1D weights. */
   for( unsigned int i = 0; i < SpaceDimension; ++i )
   {
@@ -26,6 +26,7 @@
 #include "itkBSplineKernelFunction2.h"
 #include "itkBSplineDerivativeKernelFunction.h"
 #include "itkBSplineSecondOrderDerivativeKernelFunction2.h"
+#include "itkBSplineVectorizedKernels.h"
 
 namespace itk
 {
@@ -129,6 +130,14 @@ public:
   /** Get number of weights. */
   itkGetConstMacro( NumberOfWeights, unsigned long );
 
+  /** Use the explicitly vectorized kernels of BSplineVectorizedKernels.
+   * The weights agree with the default implementation within
+   * BSplineVectorizedKernels::GetTolerance(). Default: false.
+   */
+  itkSetMacro( UseVectorizedKernels, bool );
+  itkGetConstMacro( UseVectorizedKernels, bool );
+  itkBooleanMacro( UseVectorizedKernels );
+
 protected:
 
   BSplineInterpolationWeightFunctionBase();
@@ -167,6 +176,7 @@ protected:
   unsigned long m_NumberOfWeights;
   SizeType      m_SupportSize;
   TableType     m_OffsetToIndexTable;
+  bool          m_UseVectorizedKernels;
 
   /** Interpolation kernels. */
   typename KernelType::Pointer m_Kernel;
@@ -35,6 +35,7 @@ BSplineInterpolationWeightFunctionBase< TCoordRep, VSpaceDimension, VSplineOrder
 ::BSplineInterpolationWeightFunctionBase()
 {
   /** Initialize members. */
+  this->m_UseVectorizedKernels = false;
   this->InitializeSupport();
   this->InitializeOffsetToIndexTable();
 
@@ -119,6 +120,8 @@ BSplineInterpolationWeightFunctionBase< TCoordRep, VSpaceDimension, VSplineOrder
      << this->m_SupportSize << std::endl;
   os << indent << "OffsetToIndexTable: "
      << this->m_OffsetToIndexTable << std::endl;
+  os << indent << "UseVectorizedKernels: "
+     << ( this->m_UseVectorizedKernels ? "true" : "false" ) << std::endl;
   os << indent << "Kernel: "
      << this->m_Kernel.GetPointer() << std::endl;
   os << indent << "DerivativeKernel: "
@@ -197,7 +200,17 @@ BSplineInterpolationWeightFunctionBase< TCoordRep, VSpaceDimension, VSplineOrder
   OneDWeightsType weights1D;
   this->Compute1DWeights( cindex, startIndex, weights1D );
 
-  /** Compute the vector of weights. */
+  /** Compute the vector of weights. The vectorized kernel computes the
+   * same products in the same order as the loop below.
+   */
+  if( this->m_UseVectorizedKernels )
+  {
+    BSplineVectorizedKernels::EvaluateTensorProduct(
+      weights1D.GetVnlMatrix().data_block(), SpaceDimension,
+      SplineOrder + 1, weights.data_block() );
+    return;
+  }
+
   for( unsigned int k = 0; k < this->m_NumberOfWeights; k++ )
   {
     double                tmp1 = 1.0;
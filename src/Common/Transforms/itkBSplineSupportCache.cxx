@@ -0,0 +1,123 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkBSplineSupportCache_cxx
+#define __itkBSplineSupportCache_cxx
+
+#include "itkBSplineSupportCache.h"
+
+namespace itk
+{
+
+/**
+ * ******************* Constructor *******************
+ */
+
+BSplineSupportCache
+::BSplineSupportCache()
+{
+  this->m_Owner           = 0;
+  this->m_OwnerTime       = 0;
+  this->m_Transform       = 0;
+  this->m_GridTime        = 0;
+  this->m_Size            = 0;
+  this->m_NumberOfWeights = 0;
+
+} // end Constructor
+
+
+/**
+ * ******************* Allocate *******************
+ */
+
+void
+BSplineSupportCache
+::Allocate( const unsigned long numberOfPoints,
+  const unsigned long numberOfWeights,
+  const void * transform, const unsigned long gridTime )
+{
+  this->m_Owner           = 0;
+  this->m_OwnerTime       = 0;
+  this->m_Transform       = transform;
+  this->m_GridTime        = gridTime;
+  this->m_Size            = numberOfPoints;
+  this->m_NumberOfWeights = numberOfWeights;
+  this->m_Weights.resize( numberOfPoints * numberOfWeights );
+  this->m_Indices.resize( numberOfPoints * numberOfWeights );
+  this->m_Inside.resize( numberOfPoints );
+
+} // end Allocate()
+
+
+/**
+ * ******************* Clear *******************
+ */
+
+void
+BSplineSupportCache
+::Clear( void )
+{
+  /** Swap with empty vectors to really release the memory. */
+  std::vector< double >().swap( this->m_Weights );
+  std::vector< unsigned long >().swap( this->m_Indices );
+  std::vector< unsigned char >().swap( this->m_Inside );
+  this->m_Owner           = 0;
+  this->m_OwnerTime       = 0;
+  this->m_Transform       = 0;
+  this->m_GridTime        = 0;
+  this->m_Size            = 0;
+  this->m_NumberOfWeights = 0;
+
+} // end Clear()
+
+
+/**
+ * ******************* GetMemorySize *******************
+ */
+
+std::size_t
+BSplineSupportCache
+::GetMemorySize( void ) const
+{
+  return this->m_Weights.capacity() * sizeof( double )
+         + this->m_Indices.capacity() * sizeof( unsigned long )
+         + this->m_Inside.capacity() * sizeof( unsigned char );
+
+} // end GetMemorySize()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+void
+BSplineSupportCache
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Owner: " << this->m_Owner << std::endl;
+  os << indent << "Transform: " << this->m_Transform << std::endl;
+  os << indent << "Size: " << this->m_Size << std::endl;
+  os << indent << "NumberOfWeights: " << this->m_NumberOfWeights << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkBSplineSupportCache_cxx
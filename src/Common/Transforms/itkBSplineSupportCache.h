@@ -0,0 +1,184 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkBSplineSupportCache_h
+#define __itkBSplineSupportCache_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class BSplineSupportCache
+ *
+ * \brief Stores the B-spline support of a fixed set of points.
+ *
+ * For each point it stores whether the point lies inside the valid region
+ * of the B-spline grid, and the weights and parameter indices (of the first
+ * dimension) of its support region. These do not depend on the B-spline
+ * coefficients, so the cache stays valid while the parameters change.
+ *
+ * The cache is filled by AdvancedBSplineDeformableTransformBase::
+ * PrecomputeSupportCache(), and read by TransformPointUsingSupportCache()
+ * and EvaluateJacobianWithImageGradientProductUsingSupportCache() of the
+ * same transform.
+ *
+ * The cache does not live in the transform, since several metrics may
+ * share the transform while each samples other points. Each metric has
+ * its own cache, or shares it with the metrics that use the same sampler.
+ * The cache is keyed by its owner (the sample container) and the modified
+ * time of the owner, and by the transform and the time its grid changed.
+ *
+ * \ingroup Transforms
+ */
+
+class BSplineSupportCache : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef BSplineSupportCache        Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( BSplineSupportCache, Object );
+
+  /** Allocate the cache for numberOfPoints points with numberOfWeights
+   * weights each, computed for the grid of transform at gridTime. This
+   * invalidates the owner.
+   */
+  virtual void Allocate( const unsigned long numberOfPoints,
+    const unsigned long numberOfWeights,
+    const void * transform, const unsigned long gridTime );
+
+  /** Release the memory, and invalidate the cache. */
+  virtual void Clear( void );
+
+  /** Set the owner of the cached points, e.g. the sample container, and
+   * the modified time of the owner at that moment.
+   */
+  void SetOwner( const void * owner, const unsigned long ownerTime )
+  {
+    this->m_Owner     = owner;
+    this->m_OwnerTime = ownerTime;
+  }
+
+
+  /** Returns true if the cache holds the points of this owner, at this
+   * time, for the grid of this transform at gridTime.
+   */
+  bool IsValid( const void * owner, const unsigned long ownerTime,
+    const void * transform, const unsigned long gridTime ) const
+  {
+    return owner != 0 && owner == this->m_Owner
+           && ownerTime == this->m_OwnerTime
+           && transform == this->m_Transform
+           && gridTime == this->m_GridTime;
+  }
+
+
+  /** Get the owner of the cached points. */
+  const void * GetOwner( void ) const
+  {
+    return this->m_Owner;
+  }
+
+
+  /** Get the number of cached points and the number of weights per point. */
+  itkGetConstMacro( Size, unsigned long );
+  itkGetConstMacro( NumberOfWeights, unsigned long );
+
+  /** Access the weights and parameter indices of point i. */
+  double * GetWeights( const unsigned long i )
+  {
+    return &this->m_Weights[ i * this->m_NumberOfWeights ];
+  }
+
+
+  const double * GetWeights( const unsigned long i ) const
+  {
+    return &this->m_Weights[ i * this->m_NumberOfWeights ];
+  }
+
+
+  unsigned long * GetIndices( const unsigned long i )
+  {
+    return &this->m_Indices[ i * this->m_NumberOfWeights ];
+  }
+
+
+  const unsigned long * GetIndices( const unsigned long i ) const
+  {
+    return &this->m_Indices[ i * this->m_NumberOfWeights ];
+  }
+
+
+  /** Set and get whether point i lies inside the valid region. */
+  void SetInside( const unsigned long i, const bool inside )
+  {
+    this->m_Inside[ i ] = inside;
+  }
+
+
+  bool GetInside( const unsigned long i ) const
+  {
+    return this->m_Inside[ i ] != 0;
+  }
+
+
+  /** Get the memory used by the cache, in bytes. */
+  std::size_t GetMemorySize( void ) const;
+
+protected:
+
+  BSplineSupportCache();
+  virtual ~BSplineSupportCache() {}
+
+  /** PrintSelf. */
+  virtual void PrintSelf( std::ostream & os, Indent indent ) const;
+
+private:
+
+  BSplineSupportCache( const Self & ); // purposely not implemented
+  void operator=( const Self & );      // purposely not implemented
+
+  /** The key of the cache. */
+  const void *  m_Owner;
+  unsigned long m_OwnerTime;
+  const void *  m_Transform;
+  unsigned long m_GridTime;
+
+  /** The cached support. */
+  unsigned long                m_Size;
+  unsigned long                m_NumberOfWeights;
+  std::vector< double >        m_Weights;
+  std::vector< unsigned long > m_Indices;
+  std::vector< unsigned char > m_Inside;
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkBSplineSupportCache_h
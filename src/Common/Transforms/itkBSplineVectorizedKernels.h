@@ -0,0 +1,448 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkBSplineVectorizedKernels_h
+#define __itkBSplineVectorizedKernels_h
+
+/** SSE2 is part of the x86-64 instruction set, and can be used without
+ * a run-time check. AVX is used only when the compiler supports function
+ * specific targets, and the processor supports it at run-time.
+ */
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __SSE2__ ) \
+  || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define ELX_BSPLINE_KERNELS_USE_SSE2
+#include <emmintrin.h>
+#if ( defined( __GNUC__ ) && __GNUC__ >= 5 ) || defined( __clang__ )
+#define ELX_BSPLINE_KERNELS_USE_AVX
+#include <immintrin.h>
+#endif
+#endif
+
+namespace itk
+{
+
+/** \class BSplineVectorizedKernels
+ * \brief Explicitly vectorized kernels for the computation of B-spline
+ * interpolation weights.
+ *
+ * This class contains the innermost loops of the B-spline transform:
+ * the cubic 1D B-spline weights, the tensor product that combines the
+ * 1D weights into the weights of the support region, and the product of
+ * the weights with the moving image gradient. Each kernel has an SSE2, an
+ * AVX and a scalar implementation. The fastest one that is supported by
+ * the processor is selected at run-time.
+ *
+ * The vectorized kernels perform the same floating point operations in the
+ * same order as the scalar code, so that in practice the results are bit
+ * identical. Since this can not be guaranteed for every compiler, the
+ * results are only documented to agree within a relative tolerance of
+ * GetTolerance() = 1e-14.
+ *
+ * \ingroup Transforms
+ */
+
+class BSplineVectorizedKernels
+{
+public:
+
+  /** The available implementations. */
+  typedef enum {
+    Scalar = 0,
+    SSE2   = 1,
+    AVX    = 2
+  } InstructionSetType;
+
+  /** The relative tolerance within which the vectorized kernels agree
+   * with the scalar implementation.
+   */
+  static double GetTolerance( void ) { return 1e-14; }
+
+  /** Get the fastest implementation supported by this processor. */
+  static InstructionSetType GetInstructionSet( void )
+  {
+    static const InstructionSetType instructionSet = DetectInstructionSet();
+    return instructionSet;
+  }
+
+
+  /** Get the name of an implementation, for printing purposes. */
+  static const char * GetInstructionSetName( const InstructionSetType set )
+  {
+    switch( set )
+    {
+      case AVX: return "AVX";
+      case SSE2: return "SSE2";
+      default: return "Scalar";
+    }
+  }
+
+
+  /** Compute the cubic 1D B-spline weights for dim dimensions. The input
+   * u[ j ] is the distance of the continuous index to the start index of
+   * the support region, in [1,2). The output weights1D[ 4 * j + k ] is
+   * the k-th weight of dimension j.
+   */
+  static void EvaluateCubicWeights( const double * u,
+    const unsigned int dim, double * weights1D )
+  {
+    switch( GetInstructionSet() )
+    {
+#ifdef ELX_BSPLINE_KERNELS_USE_AVX
+      case AVX:
+        EvaluateCubicWeightsAVX( u, dim, weights1D );
+        break;
+#endif
+#ifdef ELX_BSPLINE_KERNELS_USE_SSE2
+      case SSE2:
+        EvaluateCubicWeightsSSE2( u, dim, weights1D );
+        break;
+#endif
+      default:
+        EvaluateCubicWeightsScalar( u, dim, weights1D );
+    }
+  }
+
+
+  /** Compute the tensor product of the 1D weights, i.e. the weights of
+   * all points in the support region, with dimension 0 running fastest.
+   * The 1D weights of dimension j are stored at weights1D[ supportSize * j ].
+   * The output weights must have room for supportSize^dim elements.
+   */
+  static void EvaluateTensorProduct( const double * weights1D,
+    const unsigned int dim, const unsigned int supportSize, double * weights )
+  {
+    switch( GetInstructionSet() )
+    {
+#ifdef ELX_BSPLINE_KERNELS_USE_AVX
+      case AVX:
+        EvaluateTensorProductAVX( weights1D, dim, supportSize, weights );
+        break;
+#endif
+#ifdef ELX_BSPLINE_KERNELS_USE_SSE2
+      case SSE2:
+        EvaluateTensorProductSSE2( weights1D, dim, supportSize, weights );
+        break;
+#endif
+      default:
+        EvaluateTensorProductScalar( weights1D, dim, supportSize, weights );
+    }
+  }
+
+
+  /** Multiply the n weights with each of the dim components of the
+   * gradient: out[ d * n + i ] = weights[ i ] * gradient[ d ].
+   */
+  static void MultiplyWeightsWithGradient( const double * weights,
+    const unsigned long n, const double * gradient,
+    const unsigned int dim, double * out )
+  {
+    switch( GetInstructionSet() )
+    {
+#ifdef ELX_BSPLINE_KERNELS_USE_AVX
+      case AVX:
+        MultiplyWeightsWithGradientAVX( weights, n, gradient, dim, out );
+        break;
+#endif
+#ifdef ELX_BSPLINE_KERNELS_USE_SSE2
+      case SSE2:
+        MultiplyWeightsWithGradientSSE2( weights, n, gradient, dim, out );
+        break;
+#endif
+      default:
+        MultiplyWeightsWithGradientScalar( weights, n, gradient, dim, out );
+    }
+  }
+
+
+  /** Overload for output types other than double, which are not
+   * vectorized.
+   */
+  template< class TOutput >
+  static void MultiplyWeightsWithGradient( const double * weights,
+    const unsigned long n, const double * gradient,
+    const unsigned int dim, TOutput * out )
+  {
+    for( unsigned int d = 0; d < dim; ++d )
+    {
+      const double g = gradient[ d ];
+      for( unsigned long i = 0; i < n; ++i )
+      {
+        out[ i ] = static_cast< TOutput >( weights[ i ] * g );
+      }
+      out += n;
+    }
+  }
+
+
+  /** Scalar implementations. These are also the reference for the
+   * vectorized implementations.
+   */
+  static void EvaluateCubicWeightsScalar( const double * u,
+    const unsigned int dim, double * weights1D )
+  {
+    for( unsigned int j = 0; j < dim; ++j )
+    {
+      const double x   = u[ j ];
+      const double xx  = x * x;
+      const double xxx = xx * x;
+      double *     w   = weights1D + 4 * j;
+      w[ 0 ] = ( 8.0 - 12.0 * x + 6.0 * xx - xxx ) / 6.0;
+      w[ 1 ] = ( -5.0 + 21.0 * x - 15.0 * xx + 3.0 * xxx ) / 6.0;
+      w[ 2 ] = ( 4.0 - 12.0 * x + 12.0 * xx - 3.0 * xxx ) / 6.0;
+      w[ 3 ] = ( -1.0 + 3.0 * x - 3.0 * xx + xxx ) / 6.0;
+    }
+  }
+
+
+  static void EvaluateTensorProductScalar( const double * weights1D,
+    const unsigned int dim, const unsigned int supportSize, double * weights )
+  {
+    /** Expand the weights dimension by dimension, in place. The block
+     * b = 0 is computed last, since it overwrites the input.
+     */
+    unsigned long length = supportSize;
+    for( unsigned int k = 0; k < supportSize; ++k )
+    {
+      weights[ k ] = weights1D[ k ];
+    }
+    for( unsigned int j = 1; j < dim; ++j )
+    {
+      const double * w = weights1D + supportSize * j;
+      for( unsigned int b = supportSize; b-- > 0; )
+      {
+        double * out = weights + b * length;
+        for( unsigned long a = 0; a < length; ++a )
+        {
+          out[ a ] = weights[ a ] * w[ b ];
+        }
+      }
+      length *= supportSize;
+    }
+  }
+
+
+  static void MultiplyWeightsWithGradientScalar( const double * weights,
+    const unsigned long n, const double * gradient,
+    const unsigned int dim, double * out )
+  {
+    for( unsigned int d = 0; d < dim; ++d )
+    {
+      const double g = gradient[ d ];
+      for( unsigned long i = 0; i < n; ++i )
+      {
+        out[ i ] = weights[ i ] * g;
+      }
+      out += n;
+    }
+  }
+
+
+private:
+
+  /** Select the fastest implementation. */
+  static InstructionSetType DetectInstructionSet( void )
+  {
+#if defined( ELX_BSPLINE_KERNELS_USE_AVX )
+    if( __builtin_cpu_supports( "avx" ) )
+    {
+      return AVX;
+    }
+#endif
+#if defined( ELX_BSPLINE_KERNELS_USE_SSE2 )
+    return SSE2;
+#else
+    return Scalar;
+#endif
+  }
+
+
+#ifdef ELX_BSPLINE_KERNELS_USE_SSE2
+
+  /** SSE2 implementations. */
+  static void EvaluateCubicWeightsSSE2( const double * u,
+    const unsigned int dim, double * weights1D )
+  {
+    /** The coefficients of the four cubic polynomials. */
+    const __m128d c0lo = _mm_set_pd( -5.0, 8.0 );
+    const __m128d c0hi = _mm_set_pd( -1.0, 4.0 );
+    const __m128d c1lo = _mm_set_pd( 21.0, -12.0 );
+    const __m128d c1hi = _mm_set_pd( 3.0, -12.0 );
+    const __m128d c2lo = _mm_set_pd( -15.0, 6.0 );
+    const __m128d c2hi = _mm_set_pd( -3.0, 12.0 );
+    const __m128d c3lo = _mm_set_pd( 3.0, -1.0 );
+    const __m128d c3hi = _mm_set_pd( 1.0, -3.0 );
+    const __m128d six  = _mm_set1_pd( 6.0 );
+
+    for( unsigned int j = 0; j < dim; ++j )
+    {
+      const double  x   = u[ j ];
+      const double  xx  = x * x;
+      const __m128d vx   = _mm_set1_pd( x );
+      const __m128d vxx  = _mm_set1_pd( xx );
+      const __m128d vxxx = _mm_set1_pd( xx * x );
+
+      __m128d lo = _mm_add_pd( c0lo, _mm_mul_pd( c1lo, vx ) );
+      __m128d hi = _mm_add_pd( c0hi, _mm_mul_pd( c1hi, vx ) );
+      lo = _mm_add_pd( lo, _mm_mul_pd( c2lo, vxx ) );
+      hi = _mm_add_pd( hi, _mm_mul_pd( c2hi, vxx ) );
+      lo = _mm_add_pd( lo, _mm_mul_pd( c3lo, vxxx ) );
+      hi = _mm_add_pd( hi, _mm_mul_pd( c3hi, vxxx ) );
+      _mm_storeu_pd( weights1D + 4 * j, _mm_div_pd( lo, six ) );
+      _mm_storeu_pd( weights1D + 4 * j + 2, _mm_div_pd( hi, six ) );
+    }
+  }
+
+
+  static void EvaluateTensorProductSSE2( const double * weights1D,
+    const unsigned int dim, const unsigned int supportSize, double * weights )
+  {
+    unsigned long length = supportSize;
+    for( unsigned int k = 0; k < supportSize; ++k )
+    {
+      weights[ k ] = weights1D[ k ];
+    }
+    for( unsigned int j = 1; j < dim; ++j )
+    {
+      const double * w = weights1D + supportSize * j;
+      for( unsigned int b = supportSize; b-- > 0; )
+      {
+        const __m128d wb  = _mm_set1_pd( w[ b ] );
+        double *      out = weights + b * length;
+        unsigned long a   = 0;
+        for( ; a + 2 <= length; a += 2 )
+        {
+          _mm_storeu_pd( out + a, _mm_mul_pd( _mm_loadu_pd( weights + a ), wb ) );
+        }
+        for( ; a < length; ++a )
+        {
+          out[ a ] = weights[ a ] * w[ b ];
+        }
+      }
+      length *= supportSize;
+    }
+  }
+
+
+  static void MultiplyWeightsWithGradientSSE2( const double * weights,
+    const unsigned long n, const double * gradient,
+    const unsigned int dim, double * out )
+  {
+    for( unsigned int d = 0; d < dim; ++d )
+    {
+      const __m128d g = _mm_set1_pd( gradient[ d ] );
+      unsigned long i = 0;
+      for( ; i + 2 <= n; i += 2 )
+      {
+        _mm_storeu_pd( out + i, _mm_mul_pd( _mm_loadu_pd( weights + i ), g ) );
+      }
+      for( ; i < n; ++i )
+      {
+        out[ i ] = weights[ i ] * gradient[ d ];
+      }
+      out += n;
+    }
+  }
+
+
+#endif // ELX_BSPLINE_KERNELS_USE_SSE2
+
+#ifdef ELX_BSPLINE_KERNELS_USE_AVX
+
+  /** AVX implementations. */
+  __attribute__( ( target( "avx" ) ) )
+  static void EvaluateCubicWeightsAVX( const double * u,
+    const unsigned int dim, double * weights1D )
+  {
+    /** The coefficients of the four cubic polynomials. */
+    const __m256d c0  = _mm256_set_pd( -1.0, 4.0, -5.0, 8.0 );
+    const __m256d c1  = _mm256_set_pd( 3.0, -12.0, 21.0, -12.0 );
+    const __m256d c2  = _mm256_set_pd( -3.0, 12.0, -15.0, 6.0 );
+    const __m256d c3  = _mm256_set_pd( 1.0, -3.0, 3.0, -1.0 );
+    const __m256d six = _mm256_set1_pd( 6.0 );
+
+    for( unsigned int j = 0; j < dim; ++j )
+    {
+      const double x  = u[ j ];
+      const double xx = x * x;
+      __m256d      w  = _mm256_add_pd( c0, _mm256_mul_pd( c1, _mm256_set1_pd( x ) ) );
+      w = _mm256_add_pd( w, _mm256_mul_pd( c2, _mm256_set1_pd( xx ) ) );
+      w = _mm256_add_pd( w, _mm256_mul_pd( c3, _mm256_set1_pd( xx * x ) ) );
+      _mm256_storeu_pd( weights1D + 4 * j, _mm256_div_pd( w, six ) );
+    }
+  }
+
+
+  __attribute__( ( target( "avx" ) ) )
+  static void EvaluateTensorProductAVX( const double * weights1D,
+    const unsigned int dim, const unsigned int supportSize, double * weights )
+  {
+    unsigned long length = supportSize;
+    for( unsigned int k = 0; k < supportSize; ++k )
+    {
+      weights[ k ] = weights1D[ k ];
+    }
+    for( unsigned int j = 1; j < dim; ++j )
+    {
+      const double * w = weights1D + supportSize * j;
+      for( unsigned int b = supportSize; b-- > 0; )
+      {
+        const __m256d wb  = _mm256_set1_pd( w[ b ] );
+        double *      out = weights + b * length;
+        unsigned long a   = 0;
+        for( ; a + 4 <= length; a += 4 )
+        {
+          _mm256_storeu_pd( out + a, _mm256_mul_pd( _mm256_loadu_pd( weights + a ), wb ) );
+        }
+        for( ; a < length; ++a )
+        {
+          out[ a ] = weights[ a ] * w[ b ];
+        }
+      }
+      length *= supportSize;
+    }
+  }
+
+
+  __attribute__( ( target( "avx" ) ) )
+  static void MultiplyWeightsWithGradientAVX( const double * weights,
+    const unsigned long n, const double * gradient,
+    const unsigned int dim, double * out )
+  {
+    for( unsigned int d = 0; d < dim; ++d )
+    {
+      const __m256d g = _mm256_set1_pd( gradient[ d ] );
+      unsigned long i = 0;
+      for( ; i + 4 <= n; i += 4 )
+      {
+        _mm256_storeu_pd( out + i, _mm256_mul_pd( _mm256_loadu_pd( weights + i ), g ) );
+      }
+      for( ; i < n; ++i )
+      {
+        out[ i ] = weights[ i ] * gradient[ d ];
+      }
+      out += n;
+    }
+  }
+
+
+#endif // ELX_BSPLINE_KERNELS_USE_AVX
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkBSplineVectorizedKernels_h
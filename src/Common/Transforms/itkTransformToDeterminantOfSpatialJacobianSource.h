@@ -104,6 +104,9 @@ public:
     itkGetStaticConstMacro( ImageDimension ) >     TransformType;
   typedef typename TransformType::ConstPointer        TransformPointerType;
   typedef typename TransformType::SpatialJacobianType SpatialJacobianType;
+  typedef typename TransformType::InputVectorType     InputVectorType;
+  typedef typename TransformType
+    ::SpatialJacobianContainerType SpatialJacobianContainerType;
 
   /** Typedefs for output image. */
   typedef typename OutputImageType::PixelType PixelType;
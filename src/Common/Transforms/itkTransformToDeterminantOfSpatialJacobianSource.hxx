@@ -38,7 +38,7 @@
 
 #include "itkAdvancedIdentityTransform.h"
 #include "itkProgressReporter.h"
-#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageScanlineIterator.h"
 #include "vnl/vnl_det.h"
 
 namespace itk
@@ -245,32 +245,52 @@ TransformToDeterminantOfSpatialJacobianSource< TOutputImage, TTransformPrecision
   OutputImagePointer outputPtr = this->GetOutput();
 
   // Create an iterator that will walk the output region for this thread.
-  typedef ImageRegionIteratorWithIndex< TOutputImage > OutputIteratorType;
+  // The region is processed line by line, which allows the transform to
+  // exploit the coherence of the points on a line.
+  typedef ImageScanlineIterator< TOutputImage > OutputIteratorType;
   OutputIteratorType it( outputPtr, outputRegionForThread );
   it.GoToBegin();
 
-  // pixel coordinates
-  PointType point;
+  // Determine the physical step between two voxels on a line
+  const unsigned long lineLength = outputRegionForThread.GetSize()[ 0 ];
+  IndexType           index      = outputRegionForThread.GetIndex();
+  PointType           point, nextPoint;
+  outputPtr->TransformIndexToPhysicalPoint( index, point );
+  ++index[ 0 ];
+  outputPtr->TransformIndexToPhysicalPoint( index, nextPoint );
+  InputVectorType step;
+  for( unsigned int j = 0; j < ImageDimension; ++j )
+  {
+    step[ j ] = nextPoint[ j ] - point[ j ];
+  }
 
   // Support for progress methods/callbacks
   ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
 
   // Walk the output region
+  SpatialJacobianContainerType sjs;
   while( !it.IsAtEnd() )
   {
-    // Determine the coordinates of the current voxel
+    // Determine the coordinates of the first voxel of the line
     outputPtr->TransformIndexToPhysicalPoint( it.GetIndex(), point );
 
-    SpatialJacobianType sj;
-    this->m_Transform->GetSpatialJacobian( point, sj );
-    const PixelType detjac = static_cast< PixelType >( vnl_det( sj.GetVnlMatrix() ) );
+    // Compute the spatial Jacobians of the complete line
+    this->m_Transform->GetSpatialJacobianAlongLine( point, step, lineLength, sjs );
 
-    // Set it
-    it.Set( detjac );
+    unsigned long k = 0;
+    while( !it.IsAtEndOfLine() )
+    {
+      const PixelType detjac = static_cast< PixelType >( vnl_det( sjs[ k ].GetVnlMatrix() ) );
+
+      // Set it
+      it.Set( detjac );
 
-    // Update progress and iterator
-    progress.CompletedPixel();
-    ++it;
+      // Update progress and iterator
+      progress.CompletedPixel();
+      ++k;
+      ++it;
+    }
+    it.NextLine();
   }
 
 } // end NonlinearThreadedGenerateData()
@@ -323,7 +343,6 @@ TransformToDeterminantOfSpatialJacobianSource< TOutputImage, TTransformPrecision
   outputPtr->SetSpacing( m_OutputSpacing );
   outputPtr->SetOrigin( m_OutputOrigin );
   outputPtr->SetDirection( m_OutputDirection );
-  outputPtr->Allocate();
 
 } // end GenerateOutputInformation()
 
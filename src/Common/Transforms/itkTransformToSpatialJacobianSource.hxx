@@ -22,7 +22,7 @@
 
 #include "itkAdvancedIdentityTransform.h"
 #include "itkProgressReporter.h"
-#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageScanlineIterator.h"
 #include "vnl/vnl_copy.h"
 
 namespace itk
@@ -240,38 +240,57 @@ TransformToSpatialJacobianSource< TOutputImage, TTransformPrecisionType >
   OutputImagePointer outputPtr = this->GetOutput();
 
   // Create an iterator that will walk the output region for this thread.
-  typedef ImageRegionIteratorWithIndex< TOutputImage > OutputIteratorType;
+  // The region is processed line by line, which allows the transform to
+  // exploit the coherence of the points on a line.
+  typedef ImageScanlineIterator< TOutputImage > OutputIteratorType;
   OutputIteratorType it( outputPtr, outputRegionForThread );
   it.GoToBegin();
 
-  // pixel coordinates
-  PointType point;
+  // Determine the physical step between two voxels on a line
+  const unsigned long lineLength = outputRegionForThread.GetSize()[ 0 ];
+  IndexType           index      = outputRegionForThread.GetIndex();
+  PointType           point, nextPoint;
+  outputPtr->TransformIndexToPhysicalPoint( index, point );
+  ++index[ 0 ];
+  outputPtr->TransformIndexToPhysicalPoint( index, nextPoint );
+  InputVectorType step;
+  for( unsigned int j = 0; j < ImageDimension; ++j )
+  {
+    step[ j ] = nextPoint[ j ] - point[ j ];
+  }
 
   // Support for progress methods/callbacks
   ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
 
-  SpatialJacobianType sj;
-  PixelType           sjOut;
-  const unsigned int  nrElements = sj.GetVnlMatrix().size();
+  SpatialJacobianContainerType sjs;
+  PixelType                    sjOut;
+  const unsigned int           nrElements = sjOut.GetVnlMatrix().size();
 
   // Walk the output region
   while( !it.IsAtEnd() )
   {
-    // Determine the coordinates of the current voxel
+    // Determine the coordinates of the first voxel of the line
     outputPtr->TransformIndexToPhysicalPoint( it.GetIndex(), point );
 
-    this->m_Transform->GetSpatialJacobian( point, sj );
+    // Compute the spatial Jacobians of the complete line
+    this->m_Transform->GetSpatialJacobianAlongLine( point, step, lineLength, sjs );
 
-    // cast spatial jacobian to output pixel type
-    vnl_copy( sj.GetVnlMatrix().begin(), sjOut.GetVnlMatrix().begin(),
-      nrElements );
+    unsigned long k = 0;
+    while( !it.IsAtEndOfLine() )
+    {
+      // cast spatial jacobian to output pixel type
+      vnl_copy( sjs[ k ].GetVnlMatrix().begin(), sjOut.GetVnlMatrix().begin(),
+        nrElements );
 
-    // Set it
-    it.Set( sjOut );
+      // Set it
+      it.Set( sjOut );
 
-    // Update progress and iterator
-    progress.CompletedPixel();
-    ++it;
+      // Update progress and iterator
+      progress.CompletedPixel();
+      ++k;
+      ++it;
+    }
+    it.NextLine();
   }
 
 } // end NonlinearThreadedGenerateData()
@@ -330,7 +349,6 @@ TransformToSpatialJacobianSource< TOutputImage, TTransformPrecisionType >
   outputPtr->SetSpacing( m_OutputSpacing );
   outputPtr->SetOrigin( m_OutputOrigin );
   outputPtr->SetDirection( m_OutputDirection );
-  outputPtr->Allocate();
 
 } // end GenerateOutputInformation()
 
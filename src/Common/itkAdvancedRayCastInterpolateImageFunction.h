@@ -35,9 +35,15 @@ PURPOSE.  See the above copyright notices for more information.
 #define __itkAdvancedRayCastInterpolateImageFunction_h
 
 #include "itkInterpolateImageFunction.h"
+#include "itkAdvancedLinearInterpolateImageFunction.h"
+#include "itkAdvancedTransform.h"
+#include "itkImage.h"
+#include "itkMultiThreader.h"
 #include "itkTransform.h"
 #include "itkVector.h"
 
+#include <vector>
+
 namespace itk
 {
 
@@ -48,6 +54,10 @@ namespace itk
  * image and uses bilinear interpolation to integrate each plane of
  * voxels traversed.
  *
+ * EvaluateWeightedDerivative() computes the derivative of a weighted sum
+ * of projections with respect to the parameters of the transform, which
+ * the 2D-3D metrics use for their analytic derivatives.
+ *
  * \warning This interpolator works for 3-dimensional images only.
  *
  * \ingroup ImageFunctions
@@ -91,6 +101,17 @@ public:
 
   typedef typename InterpolatorType::Pointer InterpolatorPointer;
 
+  /** Typedefs for the derivative with respect to the transform parameters. */
+  typedef AdvancedTransform< TCoordRep, InputImageDimension,
+    InputImageDimension >                                            AdvancedTransformType;
+  typedef typename AdvancedTransformType::DerivativeType             DerivativeType;
+  typedef typename AdvancedTransformType::NonZeroJacobianIndicesType NonZeroJacobianIndicesType;
+  typedef typename AdvancedTransformType::MovingImageGradientType    MovingImageGradientType;
+  typedef Image< double, InputImageDimension >                       WeightImageType;
+  typedef AdvancedLinearInterpolateImageFunction<
+    TInputImage, TCoordRep >                                         LinearInterpolatorType;
+  typedef typename LinearInterpolatorType::Pointer                   LinearInterpolatorPointer;
+
   /** Run-time type information (and related methods). */
   itkTypeMacro( AdvancedRayCastInterpolateImageFunction, InterpolateImageFunction );
 
@@ -144,6 +165,27 @@ public:
   virtual OutputType EvaluateAtContinuousIndex(
     const ContinuousIndexType & index ) const;
 
+  /** Set the input image, also for the linear interpolator that is used
+   * by EvaluateWeightedDerivative().
+   */
+  virtual void SetInputImage( const InputImageType * ptr );
+
+  /** Compute the derivative of sum_p w(p) * Evaluate( T(p) ) with respect to
+   * the parameters of the transform T, for the pixels p of the buffered
+   * region of the weight image w. Pixels with zero weight are skipped.
+   *
+   * The projection is differentiated as the integral of the image above the
+   * threshold over the line through p and the focal point, mapped by the
+   * transform. The image gradient is taken from linear interpolation, and
+   * the line is sampled with a step of the smallest voxel spacing. This is
+   * exact for rigid transforms, and an approximation for other transforms,
+   * which do not map lines to lines. The transform must be an
+   * AdvancedTransform. The pixels are divided over the threads of the
+   * threader.
+   */
+  virtual void EvaluateWeightedDerivative( const WeightImageType * weights,
+    MultiThreader * threader, DerivativeType & derivative ) const;
+
   /** Connect the Transform. */
   itkSetObjectMacro( Transform, TransformType );
   /** Get a pointer to the Transform.  */
@@ -208,6 +250,28 @@ protected:
   /// Pointer to the interpolator
   InterpolatorPointer m_Interpolator;
 
+  /// The linear interpolator for the image gradient along the rays
+  LinearInterpolatorPointer m_LinearInterpolator;
+
+  /// The data that is passed to the threads by EvaluateWeightedDerivative()
+  struct WeightedDerivativeThreadStruct
+  {
+    const Self *                  m_Self;
+    const AdvancedTransformType * m_Transform;
+    const WeightImageType *       m_Weights;
+    InputPointType                m_TransformedFocalPoint;
+    std::vector< DerivativeType > m_Derivatives;
+  };
+
+  /// Add the weighted derivative of the projection of one pixel
+  void AccumulateWeightedDerivative( const WeightedDerivativeThreadStruct & str,
+    const InputPointType & point, const double weight,
+    DerivativeType & derivative, DerivativeType & imageJacobian,
+    NonZeroJacobianIndicesType & nzji ) const;
+
+  /// The threader callback of EvaluateWeightedDerivative()
+  static ITK_THREAD_RETURN_TYPE WeightedDerivativeThreaderCallback( void * arg );
+
 private:
 
   AdvancedRayCastInterpolateImageFunction( const Self & ); // purposely not implemented
@@ -36,8 +36,13 @@ PURPOSE.  See the above copyright notices for more information.
 
 #include "itkAdvancedRayCastInterpolateImageFunction.h"
 
+#include "itkPersistentThreadPool.h"
 #include "vnl/vnl_math.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 // Put the helper class in an anonymous namespace so that it is not
 // exposed to the user
 namespace
@@ -1524,6 +1529,8 @@ AdvancedRayCastInterpolateImageFunction< TInputImage, TCoordRep >
   m_FocalPoint[ 0 ] = 0.;
   m_FocalPoint[ 1 ] = 0.;
   m_FocalPoint[ 2 ] = 0.;
+
+  m_LinearInterpolator = LinearInterpolatorType::New();
 }
 
 
@@ -1588,6 +1595,220 @@ AdvancedRayCastInterpolateImageFunction< TInputImage, TCoordRep >
 }
 
 
+/* -----------------------------------------------------------------------
+   SetInputImage
+   ----------------------------------------------------------------------- */
+
+template< class TInputImage, class TCoordRep >
+void
+AdvancedRayCastInterpolateImageFunction< TInputImage, TCoordRep >
+::SetInputImage( const InputImageType * ptr )
+{
+  this->Superclass::SetInputImage( ptr );
+  m_LinearInterpolator->SetInputImage( ptr );
+}
+
+
+/* -----------------------------------------------------------------------
+   EvaluateWeightedDerivative
+   ----------------------------------------------------------------------- */
+
+template< class TInputImage, class TCoordRep >
+void
+AdvancedRayCastInterpolateImageFunction< TInputImage, TCoordRep >
+::EvaluateWeightedDerivative( const WeightImageType * weights,
+  MultiThreader * threader, DerivativeType & derivative ) const
+{
+  const AdvancedTransformType * transform
+    = dynamic_cast< const AdvancedTransformType * >( m_Transform.GetPointer() );
+  if( transform == 0 )
+  {
+    itkExceptionMacro( << "The transform of the ray caster is not an AdvancedTransform." );
+  }
+  if( weights == 0 || this->m_Image.IsNull() )
+  {
+    itkExceptionMacro( << "The weight image or the input image is not set." );
+  }
+
+  const unsigned long numberOfParameters = transform->GetNumberOfParameters();
+  DerivativeType      zero( numberOfParameters );
+  zero.Fill( 0.0 );
+
+  /** Each thread sums into its own derivative. */
+  WeightedDerivativeThreadStruct str;
+  str.m_Self                  = this;
+  str.m_Transform             = transform;
+  str.m_Weights               = weights;
+  str.m_TransformedFocalPoint = transform->TransformPoint( m_FocalPoint );
+  str.m_Derivatives.resize( threader->GetNumberOfThreads(), zero );
+
+  PersistentThreadPool::Launch( threader,
+    Self::WeightedDerivativeThreaderCallback, &str );
+
+  derivative = zero;
+  for( std::size_t i = 0; i < str.m_Derivatives.size(); ++i )
+  {
+    derivative += str.m_Derivatives[ i ];
+  }
+}
+
+
+/* -----------------------------------------------------------------------
+   WeightedDerivativeThreaderCallback
+   ----------------------------------------------------------------------- */
+
+template< class TInputImage, class TCoordRep >
+ITK_THREAD_RETURN_TYPE
+AdvancedRayCastInterpolateImageFunction< TInputImage, TCoordRep >
+::WeightedDerivativeThreaderCallback( void * arg )
+{
+  typedef MultiThreader::ThreadInfoStruct ThreadInfoType;
+  ThreadInfoType * infoStruct  = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadId    = infoStruct->ThreadID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfThreads;
+
+  WeightedDerivativeThreadStruct * str
+    = static_cast< WeightedDerivativeThreadStruct * >( infoStruct->UserData );
+
+  /** Divide the pixels of the weight image over the threads. */
+  const WeightImageType * weights        = str->m_Weights;
+  const unsigned long     numberOfPixels
+    = weights->GetBufferedRegion().GetNumberOfPixels();
+  const unsigned long chunk
+    = ( numberOfPixels + nrOfThreads - 1 ) / nrOfThreads;
+  const unsigned long begin = std::min( numberOfPixels, threadId * chunk );
+  const unsigned long end   = std::min( numberOfPixels, begin + chunk );
+
+  DerivativeType &           derivative = str->m_Derivatives[ threadId ];
+  DerivativeType             imageJacobian(
+    str->m_Transform->GetNumberOfNonZeroJacobianIndices() );
+  NonZeroJacobianIndicesType nzji(
+    str->m_Transform->GetNumberOfNonZeroJacobianIndices() );
+
+  const double * buffer = weights->GetBufferPointer();
+  InputPointType point;
+  for( unsigned long offset = begin; offset < end; ++offset )
+  {
+    if( buffer[ offset ] == 0.0 )
+    {
+      continue;
+    }
+    weights->TransformIndexToPhysicalPoint(
+      weights->ComputeIndex( static_cast< OffsetValueType >( offset ) ), point );
+    str->m_Self->AccumulateWeightedDerivative( *str, point, buffer[ offset ],
+      derivative, imageJacobian, nzji );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+/* -----------------------------------------------------------------------
+   AccumulateWeightedDerivative
+   ----------------------------------------------------------------------- */
+
+template< class TInputImage, class TCoordRep >
+void
+AdvancedRayCastInterpolateImageFunction< TInputImage, TCoordRep >
+::AccumulateWeightedDerivative( const WeightedDerivativeThreadStruct & str,
+  const InputPointType & point, const double weight,
+  DerivativeType & derivative, DerivativeType & imageJacobian,
+  NonZeroJacobianIndicesType & nzji ) const
+{
+  /** Like the ray cast helper, assume that the volume is centred at the
+   * origin, so that the continuous index is an affine function of the
+   * position on the ray: c(s) = c0 + s * dc, for s = 0 at the transformed
+   * point and s = 1 at the transformed focal point.
+   */
+  typename InputImageType::SpacingType spacing = this->m_Image->GetSpacing();
+  SizeType dim = this->m_Image->GetLargestPossibleRegion().GetSize();
+
+  const OutputPointType transformedPoint = str.m_Transform->TransformPoint( point );
+
+  double c0[ InputImageDimension ];
+  double dc[ InputImageDimension ];
+  double smin = -std::numeric_limits< double >::max();
+  double smax = std::numeric_limits< double >::max();
+  double length = 0.0;
+  double minimumSpacing = std::numeric_limits< double >::max();
+  for( unsigned int i = 0; i < InputImageDimension; ++i )
+  {
+    const double halfSize = 0.5 * ( static_cast< double >( dim[ i ] ) - 1.0 );
+    c0[ i ] = transformedPoint[ i ] / spacing[ i ] + halfSize;
+    dc[ i ] = ( str.m_TransformedFocalPoint[ i ] - transformedPoint[ i ] ) / spacing[ i ];
+
+    const double d = str.m_TransformedFocalPoint[ i ] - transformedPoint[ i ];
+    length        += d * d;
+    minimumSpacing = std::min( minimumSpacing, static_cast< double >( spacing[ i ] ) );
+
+    /** Clip the ray to the voxel centres of the volume. */
+    const double last = static_cast< double >( dim[ i ] ) - 1.0;
+    if( std::abs( dc[ i ] ) < 1e-12 )
+    {
+      if( c0[ i ] < 0.0 || c0[ i ] > last )
+      {
+        return;
+      }
+      continue;
+    }
+    const double sa = -c0[ i ] / dc[ i ];
+    const double sb = ( last - c0[ i ] ) / dc[ i ];
+    smin = std::max( smin, std::min( sa, sb ) );
+    smax = std::min( smax, std::max( sa, sb ) );
+  }
+  length = std::sqrt( length );
+  if( smax <= smin || length == 0.0 )
+  {
+    return;
+  }
+
+  /** Sample the ray with the midpoint rule. */
+  const unsigned long numberOfSteps = static_cast< unsigned long >(
+    std::ceil( ( smax - smin ) * length / minimumSpacing ) );
+  if( numberOfSteps == 0 )
+  {
+    return;
+  }
+  const double ds   = ( smax - smin ) / static_cast< double >( numberOfSteps );
+  const double step = ds * length;
+
+  typename LinearInterpolatorType::OutputType          value;
+  typename LinearInterpolatorType::CovariantVectorType gradient;
+  MovingImageGradientType                              movingImageGradient;
+  ContinuousIndexType                                  cindex;
+  InputPointType                                       rayPoint;
+  for( unsigned long k = 0; k < numberOfSteps; ++k )
+  {
+    const double s = smin + ( static_cast< double >( k ) + 0.5 ) * ds;
+    for( unsigned int i = 0; i < InputImageDimension; ++i )
+    {
+      cindex[ i ] = c0[ i ] + s * dc[ i ];
+    }
+
+    m_LinearInterpolator->EvaluateValueAndDerivativeAtContinuousIndex(
+      cindex, value, gradient );
+    if( value <= m_Threshold )
+    {
+      continue;
+    }
+
+    /** The point on the untransformed ray that maps to the sample. */
+    for( unsigned int i = 0; i < InputImageDimension; ++i )
+    {
+      rayPoint[ i ] = point[ i ] + s * ( m_FocalPoint[ i ] - point[ i ] );
+      movingImageGradient[ i ] = gradient[ i ];
+    }
+
+    str.m_Transform->EvaluateJacobianWithImageGradientProduct(
+      rayPoint, movingImageGradient, imageJacobian, nzji );
+    for( unsigned int j = 0; j < nzji.size(); ++j )
+    {
+      derivative[ nzji[ j ] ] += weight * step * imageJacobian[ j ];
+    }
+  }
+}
+
+
 } // namespace itk
 
 #endif
@@ -98,6 +98,18 @@ namespace itk
  * compute only single level of the pyramid via SetCurrentLevel() and
  * SetComputeOnlyForCurrentLevel() methods.
  *
+ * By default every level is computed from the input image. With
+ * SetUseCascade( true ) each level is instead computed from the next finer
+ * level, by smoothing it with the incremental sigma
+ * sqrt( sigma_level^2 - sigma_finer^2 ) and rescaling it with the relative
+ * shrink factors. The coarse levels are then smoothed and rescaled on small
+ * images, which is much faster for large inputs. The result equals the
+ * default computation up to discretisation and interpolation errors. A
+ * level is computed from the input anyway when its sigma is smaller than
+ * that of the finer level, or when the shrink filter is used and its
+ * factors are not a multiple of those of the finer level. The cascade is
+ * not used when only the current level is computed.
+ *
  * \author Denis P. Shamonin and Marius Staring. Division of Image Processing,
  * Department of Radiology, Leiden, The Netherlands
  *
@@ -220,6 +232,13 @@ public:
   itkGetConstMacro( ComputeOnlyForCurrentLevel, bool );
   itkBooleanMacro( ComputeOnlyForCurrentLevel );
 
+  /** Set a control on whether a level is computed from the next finer level,
+   * instead of from the input. Default: false.
+   */
+  itkSetMacro( UseCascade, bool );
+  itkGetConstMacro( UseCascade, bool );
+  itkBooleanMacro( UseCascade );
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro( SameDimensionCheck,
@@ -266,6 +285,7 @@ protected:
   unsigned int          m_CurrentLevel;
   bool                  m_ComputeOnlyForCurrentLevel;
   bool                  m_SmoothingScheduleDefined;
+  bool                  m_UseCascade;
 
 private:
 
@@ -284,6 +304,29 @@ private:
   typedef ImageToImageFilter< InputImageType, OutputImageType >
     ImageToImageFilterDifferentTypes;
 
+  /** Typedef for the smoother of the cascade, which smoothes the next finer
+   * level, and therefore goes from OutputImageType to OutputImageType.
+   */
+  typedef SmoothingRecursiveGaussianImageFilter<
+    OutputImageType, OutputImageType > CascadeSmootherType;
+
+  /** Compute the output of the level from the input image. */
+  void GenerateLevelFromInput( const unsigned int level,
+    const InputImageConstPointer & input,
+    typename SmootherType::Pointer & smoother,
+    typename ImageToImageFilterSameTypes::Pointer & rescaleSameTypes,
+    typename ImageToImageFilterDifferentTypes::Pointer & rescaleDifferentTypes );
+
+  /** Compute all levels, each from the next finer level if possible. */
+  void GenerateDataCascaded( const InputImageConstPointer & input );
+
+  /** Get the sigmas and shrink factors that turn the next finer level into
+   * this level. Returns false if the level can not be computed in that way.
+   */
+  bool GetCascadeSigmaAndShrinkFactors( const unsigned int level,
+    SigmaArrayType & sigmaArray,
+    RescaleFactorArrayType & shrinkFactors ) const;
+
   /** Smooth image at current level. Returns true if performed.
    * This method does not perform execution.
    */
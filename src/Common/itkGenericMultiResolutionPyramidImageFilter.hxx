@@ -24,6 +24,8 @@
 #include "itkShrinkImageFilter.h"
 #include "itkImageAlgorithm.h"
 
+#include <cmath>
+
 namespace // anonymous namespace
 {
 /**
@@ -65,6 +67,7 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
   temp.Fill( NumericTraits< ScalarRealType >::ZeroValue() );
   this->m_SmoothingSchedule        = temp;
   this->m_SmoothingScheduleDefined = false;
+  this->m_UseCascade               = false;
 } // end Constructor
 
 
@@ -329,6 +332,13 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
     this->SetSmoothingScheduleToDefault();
   }
 
+  // The cascade needs the next finer level, so it requires all levels
+  if( this->m_UseCascade && !this->m_ComputeOnlyForCurrentLevel )
+  {
+    this->GenerateDataCascaded( input );
+    return;
+  }
+
   typename SmootherType::Pointer smoother;
   typename ImageToImageFilterSameTypes::Pointer rescaleSameTypes;
   typename ImageToImageFilterDifferentTypes::Pointer rescaleDifferentTypes;
@@ -343,45 +353,196 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
 
     if( this->ComputeForCurrentLevel( level ) )
     {
-      // Allocate memory for each output
-      OutputImagePointer outputPtr = this->GetOutput( level );
-      outputPtr->SetBufferedRegion( outputPtr->GetRequestedRegion() );
-      outputPtr->Allocate();
+      this->GenerateLevelFromInput( level, input,
+        smoother, rescaleSameTypes, rescaleDifferentTypes );
+    }
+  } // end for ilevel
+}   // end GenerateData()
 
-      // Setup the smoother
-      const bool smootherIsUsed = this->SetupSmoother( level, smoother, input );
 
-      // Setup the shrinker or resampler
-      const int shrinkerOrResamplerIsUsed = this->SetupShrinkerOrResampler( level,
-        smoother, smootherIsUsed, input, outputPtr,
-        rescaleSameTypes, rescaleDifferentTypes );
+/**
+ * ******************* GenerateLevelFromInput ***********************
+ */
 
-      // Update the pipeline and graft or copy results to this filters output
-      if( shrinkerOrResamplerIsUsed == 0 && smootherIsUsed )
-      {
-        UpdateAndGraft< Self, SmootherType, OutputImageType >(
-          this, smoother, outputPtr, level );
-      }
-      else if( shrinkerOrResamplerIsUsed == 0 )
-      {
-        ImageAlgorithm::Copy( input.GetPointer(), outputPtr.GetPointer(),
-          input->GetLargestPossibleRegion(), outputPtr->GetLargestPossibleRegion() );
-      }
-      else if( shrinkerOrResamplerIsUsed == 1 )
+template< class TInputImage, class TOutputImage, class TPrecisionType >
+void
+GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionType >
+::GenerateLevelFromInput( const unsigned int level,
+  const InputImageConstPointer & input,
+  typename SmootherType::Pointer & smoother,
+  typename ImageToImageFilterSameTypes::Pointer & rescaleSameTypes,
+  typename ImageToImageFilterDifferentTypes::Pointer & rescaleDifferentTypes )
+{
+  // Allocate memory for the output
+  OutputImagePointer outputPtr = this->GetOutput( level );
+  outputPtr->SetBufferedRegion( outputPtr->GetRequestedRegion() );
+  outputPtr->Allocate();
+
+  // Setup the smoother
+  const bool smootherIsUsed = this->SetupSmoother( level, smoother, input );
+
+  // Setup the shrinker or resampler
+  const int shrinkerOrResamplerIsUsed = this->SetupShrinkerOrResampler( level,
+    smoother, smootherIsUsed, input, outputPtr,
+    rescaleSameTypes, rescaleDifferentTypes );
+
+  // Update the pipeline and graft or copy results to this filters output
+  if( shrinkerOrResamplerIsUsed == 0 && smootherIsUsed )
+  {
+    UpdateAndGraft< Self, SmootherType, OutputImageType >(
+      this, smoother, outputPtr, level );
+  }
+  else if( shrinkerOrResamplerIsUsed == 0 )
+  {
+    ImageAlgorithm::Copy( input.GetPointer(), outputPtr.GetPointer(),
+      input->GetLargestPossibleRegion(), outputPtr->GetLargestPossibleRegion() );
+  }
+  else if( shrinkerOrResamplerIsUsed == 1 )
+  {
+    UpdateAndGraft< Self, ImageToImageFilterSameTypes, OutputImageType >(
+      this, rescaleSameTypes, outputPtr, level );
+  }
+  else if( shrinkerOrResamplerIsUsed == 2 )
+  {
+    UpdateAndGraft< Self, ImageToImageFilterDifferentTypes, OutputImageType >(
+      this, rescaleDifferentTypes, outputPtr, level );
+  }
+  // no else needed
+
+} // end GenerateLevelFromInput()
+
+
+/**
+ * ******************* GenerateDataCascaded ***********************
+ */
+
+template< class TInputImage, class TOutputImage, class TPrecisionType >
+void
+GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionType >
+::GenerateDataCascaded( const InputImageConstPointer & input )
+{
+  typename SmootherType::Pointer smoother;
+  typename CascadeSmootherType::Pointer cascadeSmoother;
+  typename ImageToImageFilterSameTypes::Pointer rescaleSameTypes;
+  typename ImageToImageFilterSameTypes::Pointer cascadeRescaler;
+  typename ImageToImageFilterDifferentTypes::Pointer rescaleDifferentTypes;
+
+  // Go from the finest level, which is computed from the input, to the coarsest
+  SigmaArrayType         sigmaArray;
+  RescaleFactorArrayType shrinkFactors;
+  for( int level = this->m_NumberOfLevels - 1; level >= 0; --level )
+  {
+    this->UpdateProgress( static_cast< float >( this->m_NumberOfLevels - 1 - level )
+      / static_cast< float >( this->m_NumberOfLevels ) );
+
+    if( static_cast< unsigned int >( level ) == this->m_NumberOfLevels - 1
+      || !this->GetCascadeSigmaAndShrinkFactors( level, sigmaArray, shrinkFactors ) )
+    {
+      this->GenerateLevelFromInput( level, input,
+        smoother, rescaleSameTypes, rescaleDifferentTypes );
+      continue;
+    }
+
+    // Allocate memory for the output
+    OutputImagePointer outputPtr = this->GetOutput( level );
+    outputPtr->SetBufferedRegion( outputPtr->GetRequestedRegion() );
+    outputPtr->Allocate();
+
+    // Take the next finer level as input. It is grafted onto a new image,
+    // so that the mini-pipeline does not try to update this filter.
+    OutputImagePointer finer = OutputImageType::New();
+    finer->Graft( this->GetOutput( level + 1 ) );
+
+    // Setup the smoother with the incremental sigma
+    const bool smootherIsUsed = !this->AreSigmasAllZeros( sigmaArray );
+    if( smootherIsUsed )
+    {
+      if( cascadeSmoother.IsNull() ) { cascadeSmoother = CascadeSmootherType::New(); }
+      cascadeSmoother->SetInput( finer );
+      cascadeSmoother->SetSigmaArray( sigmaArray );
+    }
+
+    // Setup the shrinker or resampler with the relative shrink factors
+    const bool rescalerIsUsed = !this->AreRescaleFactorsAllOnes( shrinkFactors );
+    if( rescalerIsUsed )
+    {
+      typename ImageToImageFilterDifferentTypes::Pointer dummy;
+      this->DefineShrinkerOrResampler( true, shrinkFactors, outputPtr,
+        cascadeRescaler, dummy );
+      if( smootherIsUsed )
       {
-        UpdateAndGraft< Self, ImageToImageFilterSameTypes, OutputImageType >(
-          this, rescaleSameTypes, outputPtr, level );
+        cascadeRescaler->SetInput( cascadeSmoother->GetOutput() );
       }
-      else if( shrinkerOrResamplerIsUsed == 2 )
+      else
       {
-        UpdateAndGraft< Self, ImageToImageFilterDifferentTypes, OutputImageType >(
-          this, rescaleDifferentTypes, outputPtr, level );
+        cascadeRescaler->SetInput( finer );
       }
-      // no else needed
+    }
 
+    // Update the pipeline and graft or copy results to this filters output
+    if( rescalerIsUsed )
+    {
+      UpdateAndGraft< Self, ImageToImageFilterSameTypes, OutputImageType >(
+        this, cascadeRescaler, outputPtr, level );
     }
-  } // end for ilevel
-}   // end GenerateData()
+    else if( smootherIsUsed )
+    {
+      UpdateAndGraft< Self, CascadeSmootherType, OutputImageType >(
+        this, cascadeSmoother, outputPtr, level );
+    }
+    else
+    {
+      ImageAlgorithm::Copy( finer.GetPointer(), outputPtr.GetPointer(),
+        finer->GetLargestPossibleRegion(), outputPtr->GetLargestPossibleRegion() );
+    }
+  } // end for level
+
+} // end GenerateDataCascaded()
+
+
+/**
+ * ******************* GetCascadeSigmaAndShrinkFactors ***********************
+ */
+
+template< class TInputImage, class TOutputImage, class TPrecisionType >
+bool
+GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionType >
+::GetCascadeSigmaAndShrinkFactors( const unsigned int level,
+  SigmaArrayType & sigmaArray, RescaleFactorArrayType & shrinkFactors ) const
+{
+  SigmaArrayType         finerSigmaArray;
+  RescaleFactorArrayType finerShrinkFactors;
+  this->GetSigma( level, sigmaArray );
+  this->GetSigma( level + 1, finerSigmaArray );
+  this->GetShrinkFactors( level, shrinkFactors );
+  this->GetShrinkFactors( level + 1, finerShrinkFactors );
+
+  for( unsigned int dim = 0; dim < ImageDimension; dim++ )
+  {
+    // Gaussian smoothing is additive in the variance. A level that is
+    // smoothed less than the finer level can not be computed from it, so
+    // it is computed from the input. Small negative values are round-off.
+    const double finerVariance = finerSigmaArray[ dim ] * finerSigmaArray[ dim ];
+    const double variance      = sigmaArray[ dim ] * sigmaArray[ dim ] - finerVariance;
+    if( variance < -1e-6 * finerVariance )
+    {
+      return false;
+    }
+    sigmaArray[ dim ] = variance > 0.0 ? std::sqrt( variance ) : 0.0;
+
+    // The shrinker only supports integer factors
+    const unsigned int factor      = static_cast< unsigned int >( shrinkFactors[ dim ] );
+    const unsigned int finerFactor = static_cast< unsigned int >( finerShrinkFactors[ dim ] );
+    if( this->GetUseShrinkImageFilter() && factor % finerFactor != 0 )
+    {
+      return false;
+    }
+    shrinkFactors[ dim ] = shrinkFactors[ dim ] / finerShrinkFactors[ dim ];
+  }
+
+  return true;
+
+} // end GetCascadeSigmaAndShrinkFactors()
 
 
 /**
@@ -916,6 +1077,8 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
      << ( this->m_ComputeOnlyForCurrentLevel ? "true" : "false" ) << std::endl;
   os << indent << "SmoothingScheduleDefined: "
      << ( this->m_SmoothingScheduleDefined ? "true" : "false" ) << std::endl;
+  os << indent << "UseCascade: "
+     << ( this->m_UseCascade ? "true" : "false" ) << std::endl;
   os << indent << "Smoothing Schedule: ";
   if( this->m_SmoothingSchedule.size() == 0 )
   {
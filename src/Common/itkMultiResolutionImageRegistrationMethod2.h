@@ -45,6 +45,9 @@
 #include "itkMultiResolutionPyramidImageFilter.h"
 #include "itkNumericTraits.h"
 #include "itkDataObjectDecorator.h"
+#include "itkPersistentThreadPool.h"
+
+#include <vector>
 
 namespace itk
 {
@@ -266,6 +269,23 @@ protected:
   /** Compute the size of the fixed region for each level of the pyramid. */
   virtual void PreparePyramids( void );
 
+  /** Update the given pyramids. Pyramids with different inputs are updated
+   * concurrently, unless an input is the output of another filter.
+   */
+  virtual void UpdatePyramids( const std::vector< ProcessObject * > & pyramids ) const;
+
+  /** Typedefs for updating the pyramids in threads. */
+  typedef MultiThreader::ThreadInfoStruct ThreadInfoType;
+  struct UpdatePyramidsThreaderParameterType
+  {
+    std::vector< std::vector< ProcessObject * > > st_Groups;
+    std::vector< unsigned char >                  st_Failed;
+    std::vector< ExceptionObject >                st_Exceptions;
+  };
+
+  /** Update one or more groups of pyramids, in a thread. */
+  static ITK_THREAD_RETURN_TYPE UpdatePyramidsThreaderCallback( void * arg );
+
   /** Set the current level to be processed. */
   itkSetMacro( CurrentLevel, unsigned long );
 
@@ -44,6 +44,8 @@
 #include "itkContinuousIndex.h"
 #include "vnl/vnl_math.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -202,12 +204,16 @@ MultiResolutionImageRegistrationMethod2< TFixedImage, TMovingImage >
   // Setup the fixed image pyramid
   this->m_FixedImagePyramid->SetNumberOfLevels( this->m_NumberOfLevels );
   this->m_FixedImagePyramid->SetInput( this->m_FixedImage );
-  this->m_FixedImagePyramid->UpdateLargestPossibleRegion();
 
   // Setup the moving image pyramid
   this->m_MovingImagePyramid->SetNumberOfLevels( this->m_NumberOfLevels );
   this->m_MovingImagePyramid->SetInput( this->m_MovingImage );
-  this->m_MovingImagePyramid->UpdateLargestPossibleRegion();
+
+  // Compute both pyramids, concurrently if possible
+  std::vector< ProcessObject * > pyramids( 2 );
+  pyramids[ 0 ] = this->m_FixedImagePyramid.GetPointer();
+  pyramids[ 1 ] = this->m_MovingImagePyramid.GetPointer();
+  this->UpdatePyramids( pyramids );
 
   typedef typename FixedImageRegionType::SizeType      SizeType;
   typedef typename FixedImageRegionType::IndexType     IndexType;
@@ -273,6 +279,109 @@ MultiResolutionImageRegistrationMethod2< TFixedImage, TMovingImage >
 } // end PreparePyramids()
 
 
+/*
+ * Update the pyramids
+ */
+template< typename TFixedImage, typename TMovingImage >
+void
+MultiResolutionImageRegistrationMethod2< TFixedImage, TMovingImage >
+::UpdatePyramids( const std::vector< ProcessObject * > & pyramids ) const
+{
+  // Group the pyramids by input. Pyramids that share an input are updated
+  // one after another, since they would set the requested region of the
+  // same image. An input that is the output of another filter might share
+  // a pipeline with other inputs, so in that case nothing runs concurrently.
+  UpdatePyramidsThreaderParameterType parameters;
+  std::vector< const DataObject * >   inputs;
+  bool                                concurrent = true;
+  for( std::size_t i = 0; i < pyramids.size(); ++i )
+  {
+    const DataObject * input = 0;
+    if( !pyramids[ i ]->GetInputs().empty() )
+    {
+      input = pyramids[ i ]->GetInputs()[ 0 ].GetPointer();
+    }
+    if( input == 0 || input->GetSource().GetPointer() != 0 )
+    {
+      concurrent = false;
+    }
+
+    const std::size_t group = std::find( inputs.begin(), inputs.end(), input ) - inputs.begin();
+    if( group == inputs.size() )
+    {
+      inputs.push_back( input );
+      parameters.st_Groups.push_back( std::vector< ProcessObject * >() );
+    }
+    parameters.st_Groups[ group ].push_back( pyramids[ i ] );
+  }
+
+  if( !concurrent || parameters.st_Groups.size() < 2 )
+  {
+    for( std::size_t i = 0; i < pyramids.size(); ++i )
+    {
+      pyramids[ i ]->UpdateLargestPossibleRegion();
+    }
+    return;
+  }
+
+  // Update the groups in threads
+  const std::size_t numberOfGroups = parameters.st_Groups.size();
+  parameters.st_Failed.assign( numberOfGroups, 0 );
+  parameters.st_Exceptions.resize( numberOfGroups );
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( static_cast< ThreadIdType >( numberOfGroups ) );
+  PersistentThreadPool::Launch( threader,
+    this->UpdatePyramidsThreaderCallback, &parameters );
+
+  for( std::size_t g = 0; g < numberOfGroups; ++g )
+  {
+    if( parameters.st_Failed[ g ] )
+    {
+      throw parameters.st_Exceptions[ g ];
+    }
+  }
+
+} // end UpdatePyramids()
+
+
+/*
+ * Update a group of pyramids, in a thread
+ */
+template< typename TFixedImage, typename TMovingImage >
+ITK_THREAD_RETURN_TYPE
+MultiResolutionImageRegistrationMethod2< TFixedImage, TMovingImage >
+::UpdatePyramidsThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct  = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadID    = infoStruct->ThreadID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfThreads;
+
+  UpdatePyramidsThreaderParameterType * temp
+    = static_cast< UpdatePyramidsThreaderParameterType * >( infoStruct->UserData );
+
+  // There may be less threads than groups
+  for( std::size_t g = threadID; g < temp->st_Groups.size(); g += nrOfThreads )
+  {
+    try
+    {
+      for( std::size_t i = 0; i < temp->st_Groups[ g ].size(); ++i )
+      {
+        temp->st_Groups[ g ][ i ]->UpdateLargestPossibleRegion();
+      }
+    }
+    catch( ExceptionObject & excp )
+    {
+      temp->st_Failed[ g ]     = 1;
+      temp->st_Exceptions[ g ] = excp;
+    }
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end UpdatePyramidsThreaderCallback()
+
+
 /*
  * Starts the Registration Process
  */
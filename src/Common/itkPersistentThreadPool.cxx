@@ -0,0 +1,446 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef __itkPersistentThreadPool_cxx
+#define __itkPersistentThreadPool_cxx
+
+#include "itkPersistentThreadPool.h"
+#include "xoutmain.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace itk
+{
+
+/** The global instance and its lock. */
+PersistentThreadPool::Pointer PersistentThreadPool::s_GlobalInstance = 0;
+SimpleFastMutexLock           PersistentThreadPool::s_GlobalInstanceLock;
+unsigned int                  PersistentThreadPool::s_GlobalInstanceUsers      = 0;
+bool                          PersistentThreadPool::s_GlobalInstanceIsAcquired = false;
+
+/**
+ * ****************** Constructor *********************************
+ */
+
+PersistentThreadPool
+::PersistentThreadPool()
+{
+  this->m_NumberOfThreads = 1;
+  this->m_Spawner         = MultiThreader::New();
+  this->m_WorkAvailable   = ConditionVariable::New();
+  this->m_WorkDone        = ConditionVariable::New();
+  this->m_Shutdown        = false;
+
+} // end Constructor
+
+
+/**
+ * ****************** Destructor *********************************
+ */
+
+PersistentThreadPool
+::~PersistentThreadPool()
+{
+  this->StopWorkerThreads();
+
+} // end Destructor
+
+
+/**
+ * ****************** SetNumberOfThreads *********************************
+ */
+
+void
+PersistentThreadPool
+::SetNumberOfThreads( ThreadIdType numberOfThreads )
+{
+  /** The number of threads that can be spawned is limited. */
+  numberOfThreads = std::max( numberOfThreads, static_cast< ThreadIdType >( 1 ) );
+  numberOfThreads = std::min( numberOfThreads, static_cast< ThreadIdType >( ITK_MAX_THREADS ) );
+  if( numberOfThreads == this->m_NumberOfThreads
+    && this->m_WorkerThreadIds.size() + 1 == numberOfThreads )
+  {
+    return;
+  }
+
+  this->StopWorkerThreads();
+
+  /** The calling thread is one of the threads, so spawn one less. */
+  this->m_Shutdown = false;
+  for( ThreadIdType i = 1; i < numberOfThreads; ++i )
+  {
+    this->m_WorkerThreadIds.push_back(
+      this->m_Spawner->SpawnThread( Self::WorkerThreadCallback, this ) );
+  }
+
+  this->m_NumberOfThreads = numberOfThreads;
+  this->Modified();
+
+} // end SetNumberOfThreads()
+
+
+/**
+ * ****************** StopWorkerThreads *********************************
+ */
+
+void
+PersistentThreadPool
+::StopWorkerThreads( void )
+{
+  this->m_Mutex.Lock();
+  this->m_Shutdown = true;
+  this->m_WorkAvailable->Broadcast();
+  this->m_Mutex.Unlock();
+
+  /** TerminateThread() joins the thread. */
+  for( std::size_t i = 0; i < this->m_WorkerThreadIds.size(); ++i )
+  {
+    this->m_Spawner->TerminateThread( this->m_WorkerThreadIds[ i ] );
+  }
+  this->m_WorkerThreadIds.clear();
+
+} // end StopWorkerThreads()
+
+
+/**
+ * ****************** SingleMethodExecute *********************************
+ */
+
+void
+PersistentThreadPool
+::SingleMethodExecute( ThreadFunctionType callback,
+  void * userData, ThreadIdType numberOfWorkItems )
+{
+  if( numberOfWorkItems == 0 )
+  {
+    return;
+  }
+
+  /** Without workers there is nobody to share the work with. */
+  if( this->m_WorkerThreadIds.empty() || numberOfWorkItems == 1 )
+  {
+    ThreadInfoType info;
+    info.NumberOfThreads = numberOfWorkItems;
+    info.UserData        = userData;
+    info.ActiveFlag      = 0;
+    info.ThreadFunction  = callback;
+    for( ThreadIdType i = 0; i < numberOfWorkItems; ++i )
+    {
+      info.ThreadID = i;
+      callback( &info );
+    }
+    return;
+  }
+
+  /** Queue the job. */
+  JobType job;
+  job.m_Callback                 = callback;
+  job.m_UserData                 = userData;
+  job.m_Xout                     = xl::get_thread_xout();
+  job.m_NumberOfWorkItems        = numberOfWorkItems;
+  job.m_NextWorkItem             = 0;
+  job.m_NumberOfPendingWorkItems = numberOfWorkItems;
+
+  this->m_Mutex.Lock();
+  this->m_Jobs.push_back( &job );
+  this->m_WorkAvailable->Broadcast();
+
+  /** Help the workers with this job, and wait until the last work item
+   * is done. The job is removed from the queue when its last work item
+   * is taken, so it may be destroyed after the wait.
+   */
+  while( job.m_NextWorkItem < job.m_NumberOfWorkItems )
+  {
+    this->ProcessWorkItem( &job );
+  }
+  while( job.m_NumberOfPendingWorkItems > 0 )
+  {
+    this->m_WorkDone->Wait( &this->m_Mutex );
+  }
+  this->m_Mutex.Unlock();
+
+  if( !job.m_ExceptionDescription.empty() )
+  {
+    itkExceptionMacro( << "A work item failed:\n" << job.m_ExceptionDescription );
+  }
+
+} // end SingleMethodExecute()
+
+
+/**
+ * ****************** ProcessWorkItem *********************************
+ */
+
+void
+PersistentThreadPool
+::ProcessWorkItem( JobType * job )
+{
+  /** Take the next work item. */
+  ThreadInfoType info;
+  info.ActiveFlag      = 0;
+  info.ThreadID        = job->m_NextWorkItem++;
+  info.NumberOfThreads = job->m_NumberOfWorkItems;
+  info.UserData        = job->m_UserData;
+  info.ThreadFunction  = job->m_Callback;
+  if( job->m_NextWorkItem == job->m_NumberOfWorkItems )
+  {
+    this->m_Jobs.erase( std::find( this->m_Jobs.begin(), this->m_Jobs.end(), job ) );
+  }
+  this->m_Mutex.Unlock();
+
+  /** Do the work with the xout of the calling thread. Exceptions are
+   * passed to the calling thread.
+   */
+  XoutType * const previousXout = xl::get_thread_xout();
+  xl::set_thread_xout( job->m_Xout );
+  std::string exceptionDescription;
+  try
+  {
+    info.ThreadFunction( &info );
+  }
+  catch( ExceptionObject & excp )
+  {
+    exceptionDescription = excp.what();
+  }
+  catch( std::exception & excp )
+  {
+    exceptionDescription = excp.what();
+  }
+  catch( ... )
+  {
+    exceptionDescription = "Unknown exception.";
+  }
+  xl::set_thread_xout( previousXout );
+
+  /** Report that the work item is done. The job may be destroyed as soon
+   * as the mutex is released after the last work item.
+   */
+  this->m_Mutex.Lock();
+  if( !exceptionDescription.empty() && job->m_ExceptionDescription.empty() )
+  {
+    job->m_ExceptionDescription = exceptionDescription;
+  }
+  --job->m_NumberOfPendingWorkItems;
+  if( job->m_NumberOfPendingWorkItems == 0 )
+  {
+    this->m_WorkDone->Broadcast();
+  }
+
+} // end ProcessWorkItem()
+
+
+/**
+ * ****************** WorkerLoop *********************************
+ */
+
+void
+PersistentThreadPool
+::WorkerLoop( void )
+{
+  this->m_Mutex.Lock();
+  while( true )
+  {
+    /** Wait for work, and take it from the oldest job. */
+    while( !this->m_Shutdown && this->m_Jobs.empty() )
+    {
+      this->m_WorkAvailable->Wait( &this->m_Mutex );
+    }
+    if( this->m_Shutdown )
+    {
+      this->m_Mutex.Unlock();
+      return;
+    }
+    this->ProcessWorkItem( this->m_Jobs.front() );
+  }
+
+} // end WorkerLoop()
+
+
+/**
+ * ****************** WorkerThreadCallback *********************************
+ */
+
+ITK_THREAD_RETURN_TYPE
+PersistentThreadPool
+::WorkerThreadCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  Self *           pool       = static_cast< Self * >( infoStruct->UserData );
+
+  pool->WorkerLoop();
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end WorkerThreadCallback()
+
+
+/**
+ * ****************** GetGlobalInstance *********************************
+ */
+
+PersistentThreadPool::Pointer
+PersistentThreadPool
+::GetGlobalInstance( void )
+{
+  s_GlobalInstanceLock.Lock();
+  Pointer pool = s_GlobalInstance;
+  s_GlobalInstanceLock.Unlock();
+  return pool;
+
+} // end GetGlobalInstance()
+
+
+/**
+ * ****************** SetGlobalInstance *********************************
+ */
+
+void
+PersistentThreadPool
+::SetGlobalInstance( Self * pool )
+{
+  s_GlobalInstanceLock.Lock();
+  s_GlobalInstance           = pool;
+  s_GlobalInstanceIsAcquired = false;
+  s_GlobalInstanceLock.Unlock();
+
+} // end SetGlobalInstance()
+
+
+/**
+ * ****************** AcquireGlobalInstance *********************************
+ */
+
+PersistentThreadPool::Pointer
+PersistentThreadPool
+::AcquireGlobalInstance( ThreadIdType numberOfThreads )
+{
+  s_GlobalInstanceLock.Lock();
+  if( s_GlobalInstance.IsNull() )
+  {
+    s_GlobalInstance = Self::New();
+    s_GlobalInstance->SetNumberOfThreads( numberOfThreads );
+    s_GlobalInstanceIsAcquired = true;
+  }
+  ++s_GlobalInstanceUsers;
+  Pointer pool = s_GlobalInstance;
+  s_GlobalInstanceLock.Unlock();
+  return pool;
+
+} // end AcquireGlobalInstance()
+
+
+/**
+ * ****************** ReleaseGlobalInstance *********************************
+ */
+
+void
+PersistentThreadPool
+::ReleaseGlobalInstance( void )
+{
+  /** The workers are joined when the pool is destroyed, outside the lock. */
+  Pointer pool;
+  s_GlobalInstanceLock.Lock();
+  if( s_GlobalInstanceUsers > 0 )
+  {
+    --s_GlobalInstanceUsers;
+  }
+  if( s_GlobalInstanceUsers == 0 && s_GlobalInstanceIsAcquired )
+  {
+    pool                       = s_GlobalInstance;
+    s_GlobalInstance           = 0;
+    s_GlobalInstanceIsAcquired = false;
+  }
+  s_GlobalInstanceLock.Unlock();
+
+} // end ReleaseGlobalInstance()
+
+
+/**
+ * ****************** Launch *********************************
+ */
+
+void
+PersistentThreadPool
+::Launch( MultiThreader * threader,
+  ThreadFunctionType callback, void * userData )
+{
+  Pointer pool = Self::GetGlobalInstance();
+  if( pool.IsNotNull() )
+  {
+    pool->SingleMethodExecute( callback, userData, threader->GetNumberOfThreads() );
+  }
+  else
+  {
+    /** The threads of the threader are new, so pass the xout to them. */
+    LaunchInfoType launchInfo;
+    launchInfo.m_Callback = callback;
+    launchInfo.m_UserData = userData;
+    launchInfo.m_Xout     = xl::get_thread_xout();
+    threader->SetSingleMethod( Self::LaunchThreaderCallback, &launchInfo );
+    threader->SingleMethodExecute();
+  }
+
+} // end Launch()
+
+
+/**
+ * ****************** LaunchThreaderCallback *********************************
+ */
+
+ITK_THREAD_RETURN_TYPE
+PersistentThreadPool
+::LaunchThreaderCallback( void * arg )
+{
+  ThreadInfoType *       infoStruct = static_cast< ThreadInfoType * >( arg );
+  const LaunchInfoType * launchInfo = static_cast< const LaunchInfoType * >( infoStruct->UserData );
+
+  /** The callback expects its own user data. The info struct belongs to
+   * this thread, so it can be changed.
+   */
+  XoutType * const previousXout = xl::get_thread_xout();
+  xl::set_thread_xout( launchInfo->m_Xout );
+  infoStruct->UserData = launchInfo->m_UserData;
+  ITK_THREAD_RETURN_TYPE returnValue = launchInfo->m_Callback( infoStruct );
+  xl::set_thread_xout( previousXout );
+
+  return returnValue;
+
+} // end LaunchThreaderCallback()
+
+
+/**
+ * ****************** PrintSelf *********************************
+ */
+
+void
+PersistentThreadPool
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "NumberOfThreads: " << this->m_NumberOfThreads << std::endl;
+  os << indent << "NumberOfWorkerThreads: "
+     << this->m_WorkerThreadIds.size() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkPersistentThreadPool_cxx
@@ -0,0 +1,200 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkPersistentThreadPool_h
+#define __itkPersistentThreadPool_h
+
+#include "itkObject.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleMutexLock.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itkConditionVariable.h"
+#include "xoutbase.h"
+
+#include <string>
+#include <vector>
+
+namespace itk
+{
+
+/** \class PersistentThreadPool
+ *
+ * \brief A pool of worker threads that stay alive between calls.
+ *
+ * MultiThreader::SingleMethodExecute() creates and joins its threads on
+ * every call. The metrics, samplers and optimizers call it in each
+ * iteration, so with small sample sizes and many cores the thread creation
+ * takes a considerable part of the run time. This class starts its worker
+ * threads once, and lets them wait for work in between.
+ *
+ * SingleMethodExecute() calls a MultiThreader callback once for each work
+ * item, with a ThreadInfoStruct in which ThreadID is the index of the work
+ * item and NumberOfThreads the number of work items, so existing callbacks
+ * can be used unchanged. The calling thread processes work items as well.
+ * Each idle thread takes the next pending work item, so the number of work
+ * items may differ from the number of threads.
+ *
+ * Several jobs may run at the same time, for example when the sub-metrics
+ * of a combination metric are evaluated concurrently, or when a work item
+ * calls SingleMethodExecute() itself. The jobs are queued, and an idle
+ * worker takes its next work item from the oldest job. A caller only waits
+ * for work items that are already being processed by other threads, so
+ * nested calls do not deadlock.
+ *
+ * A work item writes to the xout of the thread that started the job, so
+ * the logs of elastix runs in parallel threads stay separated, also when
+ * they share the pool.
+ *
+ * A global instance can be set, which is used by Launch(). elastix acquires
+ * it for the duration of a registration, so that all components share the
+ * same threads. Registrations in parallel threads share one global instance,
+ * which is created by the first and released by the last. Without a global
+ * instance Launch() falls back to the MultiThreader.
+ *
+ * \ingroup Common
+ */
+
+class PersistentThreadPool : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef PersistentThreadPool       Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( PersistentThreadPool, Object );
+
+  /** Typedefs. */
+  typedef MultiThreader::ThreadFunctionType ThreadFunctionType;
+  typedef MultiThreader::ThreadInfoStruct   ThreadInfoType;
+
+  /** Set the number of threads, including the calling thread. This starts
+   * or stops worker threads, so it should not be called while a job runs.
+   */
+  virtual void SetNumberOfThreads( ThreadIdType numberOfThreads );
+
+  itkGetConstMacro( NumberOfThreads, ThreadIdType );
+
+  /** Call the callback for each work item in [0, numberOfWorkItems) and wait
+   * until all work items are done. An exception thrown by a work item is
+   * rethrown as an ExceptionObject.
+   */
+  virtual void SingleMethodExecute( ThreadFunctionType callback,
+    void * userData, ThreadIdType numberOfWorkItems );
+
+  /** Get and set the global instance. */
+  static Pointer GetGlobalInstance( void );
+
+  static void SetGlobalInstance( Self * pool );
+
+  /** Use the global instance, and create it with numberOfThreads threads if
+   * there is none. Each call should be matched by ReleaseGlobalInstance().
+   * An instance that was created here is removed when the last user
+   * releases it; an instance that was set with SetGlobalInstance() is kept.
+   */
+  static Pointer AcquireGlobalInstance( ThreadIdType numberOfThreads );
+
+  static void ReleaseGlobalInstance( void );
+
+  /** Execute the callback with the global instance, using as many work
+   * items as the threader has threads. If there is no global instance,
+   * the threader itself is used. In both cases the callback writes to the
+   * xout of the calling thread.
+   */
+  static void Launch( MultiThreader * threader,
+    ThreadFunctionType callback, void * userData );
+
+protected:
+
+  PersistentThreadPool();
+  virtual ~PersistentThreadPool();
+
+  /** PrintSelf. */
+  virtual void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** Stop and join all worker threads. */
+  virtual void StopWorkerThreads( void );
+
+  /** The state of a job, protected by m_Mutex. */
+  typedef xoutlibrary::xoutbase< char > XoutType;
+  struct JobType
+  {
+    ThreadFunctionType m_Callback;
+    void *             m_UserData;
+    XoutType *         m_Xout;
+    ThreadIdType       m_NumberOfWorkItems;
+    ThreadIdType       m_NextWorkItem;
+    ThreadIdType       m_NumberOfPendingWorkItems;
+    std::string        m_ExceptionDescription;
+  };
+
+  /** Take the next work item of the job and process it. Must be called with
+   * m_Mutex locked, and while the job has an unprocessed work item. The job
+   * is removed from the queue when its last work item is taken.
+   */
+  void ProcessWorkItem( JobType * job );
+
+  /** The loop of a worker thread. */
+  void WorkerLoop( void );
+
+  /** The function that is started for each worker thread. */
+  static ITK_THREAD_RETURN_TYPE WorkerThreadCallback( void * arg );
+
+  /** The callback and xout of a job for the MultiThreader, see Launch(). */
+  struct LaunchInfoType
+  {
+    ThreadFunctionType m_Callback;
+    void *             m_UserData;
+    XoutType *         m_Xout;
+  };
+
+  /** Calls the callback of a LaunchInfoType with the xout of the caller. */
+  static ITK_THREAD_RETURN_TYPE LaunchThreaderCallback( void * arg );
+
+private:
+
+  PersistentThreadPool( const Self & ); // purposely not implemented
+  void operator=( const Self & );       // purposely not implemented
+
+  ThreadIdType                m_NumberOfThreads;
+  MultiThreader::Pointer      m_Spawner;
+  std::vector< ThreadIdType > m_WorkerThreadIds;
+
+  /** The queue of jobs with unprocessed work items, protected by m_Mutex. */
+  SimpleMutexLock            m_Mutex;
+  ConditionVariable::Pointer m_WorkAvailable;
+  ConditionVariable::Pointer m_WorkDone;
+  bool                       m_Shutdown;
+  std::vector< JobType * >   m_Jobs;
+
+  /** The global instance. */
+  static Pointer             s_GlobalInstance;
+  static SimpleFastMutexLock s_GlobalInstanceLock;
+  static unsigned int        s_GlobalInstanceUsers;
+  static bool                s_GlobalInstanceIsAcquired;
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkPersistentThreadPool_h
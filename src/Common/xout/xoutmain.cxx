@@ -20,14 +20,34 @@
 
 #include "xoutmain.h"
 
+/** Thread-local storage for the xout of each thread. */
+#if defined( _MSC_VER )
+#define xoutThreadLocal __declspec( thread )
+#else
+#define xoutThreadLocal __thread
+#endif
+
 namespace xoutlibrary
 {
 static xoutbase_type * local_xout = 0;
 
+static xoutThreadLocal xoutbase_type * local_thread_xout = 0;
+
+/** Without outputs, all messages are discarded. */
+static xoutbase_type null_xout;
+
 xoutbase_type &
 get_xout( void )
 {
-  return *local_xout;
+  if( local_thread_xout )
+  {
+    return *local_thread_xout;
+  }
+  if( local_xout )
+  {
+    return *local_xout;
+  }
+  return null_xout;
 }
 
 
@@ -38,6 +58,20 @@ set_xout( xoutbase_type * arg )
 }
 
 
+void
+set_thread_xout( xoutbase_type * arg )
+{
+  local_thread_xout = arg;
+}
+
+
+xoutbase_type *
+get_thread_xout( void )
+{
+  return local_thread_xout;
+}
+
+
 } // end namespace
 
 #endif // end #ifndef __xoutmain_cxx
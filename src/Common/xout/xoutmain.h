@@ -37,10 +37,25 @@ typedef xoutsimple< char > xoutsimple_type;
 typedef xoutrow< char >    xoutrow_type;
 typedef xoutcell< char >   xoutcell_type;
 
+/** Get the xout of the calling thread. This is the xout that was set
+ * with set_thread_xout() in this thread, or otherwise the process-wide
+ * xout that was set with set_xout(). If neither was set, an xout without
+ * outputs is returned, which discards all messages.
+ */
 xoutbase_type & get_xout( void );
 
+/** Set the process-wide xout. */
 void set_xout( xoutbase_type * arg );
 
+/** Set the xout of the calling thread only. Passing 0 makes the thread
+ * use the process-wide xout again. This allows several elastix runs in
+ * one process, each logging to its own outputs.
+ */
+void set_thread_xout( xoutbase_type * arg );
+
+/** Get the xout that was set for the calling thread, or 0. */
+xoutbase_type * get_thread_xout( void );
+
 } // end namespace xoutlibrary
 
 #endif // end #ifndef __xoutmain_h
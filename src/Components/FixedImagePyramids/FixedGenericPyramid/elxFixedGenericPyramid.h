@@ -65,6 +65,15 @@ namespace elastix
  *    for rescaling the image, or the ResampleImageFilter. Skrinker is faster.\n
  *    example: <tt>(ImagePyramidUseShrinkImageFilter "true")</tt>\n
  *    Default false, so by default the resampler is used.
+ * \parameter ImagePyramidUseCascade: Flag to specify if each resolution level is computed
+ *    from the next finer level, by smoothing with the difference in sigma and rescaling
+ *    with the relative factor, instead of from the full resolution image. This is much
+ *    faster for large images, and gives nearly the same pyramid. Only used when
+ *    ComputePyramidImagesPerResolution is false.\n
+ *    example: <tt>(ImagePyramidUseCascade "true")</tt>\n
+ *    Default false. If FixedImagePyramidUseCascade is specified, it is used instead for the fixed pyramid.
+ * \parameter FixedImagePyramidUseCascade: the same as ImagePyramidUseCascade, for the fixed pyramid only.\n
+ *    example: <tt>(FixedImagePyramidUseCascade "true")</tt>
  *
  * \ingroup ImagePyramids
  */
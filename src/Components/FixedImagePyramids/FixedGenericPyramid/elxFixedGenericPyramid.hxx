@@ -153,6 +153,16 @@ FixedGenericPyramid< TElastix >
     "ComputePyramidImagesPerResolution", 0, false );
   this->SetComputeOnlyForCurrentLevel( computeThisResolution );
 
+  /** Decide whether or not to compute each level from the next finer level.
+   * The fixed specific parameter has precedence over the general one.
+   */
+  bool useCascade = false;
+  this->m_Configuration->ReadParameter( useCascade,
+    "ImagePyramidUseCascade", 0, false );
+  this->m_Configuration->ReadParameter( useCascade,
+    "FixedImagePyramidUseCascade", 0, false );
+  this->SetUseCascade( useCascade );
+
 } // end SetFixedSchedule()
 
 
@@ -42,6 +42,9 @@ MultiInputRandomCoordinateSampler< TElastix >
     "NumberOfSpatialSamples", this->GetComponentLabel(), level, 0 );
   this->SetNumberOfSamples( numberOfSpatialSamples );
 
+  /** Draw from the random number generator of this run. */
+  this->SetRandomGenerator( this->GetElastix()->GetRandomGenerator() );
+
   /** Set up the fixed image interpolator and set the SplineOrder, default value = 1. */
   typename DefaultInterpolatorType::Pointer fixedImageInterpolator
     = DefaultInterpolatorType::New();
@@ -43,6 +43,9 @@ RandomSampler< TElastix >
 
   this->SetNumberOfSamples( numberOfSpatialSamples );
 
+  /** Draw from the random number generator of this run. */
+  this->SetRandomGenerator( this->GetElastix()->GetRandomGenerator() );
+
 }   // end BeforeEachResolution
 
 
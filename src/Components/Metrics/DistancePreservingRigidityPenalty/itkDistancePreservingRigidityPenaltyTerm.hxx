@@ -289,6 +289,28 @@ DistancePreservingRigidityPenaltyTerm< TFixedImage, TScalarType >
 } // end GetDerivative()
 
 
+/**
+ * *********************** BeforeThreadedGetValueAndDerivative ***********************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+DistancePreservingRigidityPenaltyTerm< TFixedImage, TScalarType >
+::BeforeThreadedGetValueAndDerivative( const TransformParametersType & parameters ) const
+{
+  /** In this function do all stuff that cannot be multi-threaded.
+   * The B-spline transform is shared with the other metrics of the
+   * CombinationImageToImageMetric, so its parameters may not be set while
+   * these metrics run concurrently.
+   */
+  if( this->m_UseMetricSingleThreaded )
+  {
+    this->m_BSplineTransform->SetParameters( parameters );
+  }
+
+} // end BeforeThreadedGetValueAndDerivative()
+
+
 /**
  * *********************** GetValueAndDerivative ****************
  */
@@ -307,7 +329,10 @@ DistancePreservingRigidityPenaltyTerm< TFixedImage, TScalarType >
   derivative = DerivativeType( this->GetNumberOfParameters() );
   derivative.Fill( NumericTraits< MeasureType >::ZeroValue() );
 
-  this->m_BSplineTransform->SetParameters( parameters );
+  /** Set the parameters, unless that was done before by the
+   * CombinationImageToImageMetric, see TransformRigidityPenaltyTerm.
+   */
+  this->BeforeThreadedGetValueAndDerivative( parameters );
 
   /** Distance-preserving penalty */
   MeasureType penaltyTermBuffer   = 0.0;
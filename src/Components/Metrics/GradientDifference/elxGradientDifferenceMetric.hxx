@@ -78,6 +78,16 @@ void
 GradientDifferenceMetric< TElastix >
 ::BeforeEachResolution( void )
 {
+  /** Get the current resolution level. */
+  unsigned int level
+    = ( this->m_Registration->GetAsITKBaseType() )->GetCurrentLevel();
+
+  /** Set the derivative method. */
+  bool useFiniteDifferenceDerivative = false;
+  this->m_Configuration->ReadParameter( useFiniteDifferenceDerivative,
+    "UseFiniteDifferenceDerivative", this->GetComponentLabel(), level, 0 );
+  this->SetUseFiniteDifferenceDerivative( useFiniteDifferenceDerivative );
+
   typedef typename elastix::OptimizerBase< TElastix >::ITKBaseType::ScalesType ScalesType;
   ScalesType scales = this->m_Elastix->GetElxOptimizerBase()->GetAsITKBaseType()->GetScales();
   this->SetScales( scales );
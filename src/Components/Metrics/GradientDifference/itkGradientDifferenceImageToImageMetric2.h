@@ -44,6 +44,7 @@
 #include "itkOptimizer.h"
 #include "itkAdvancedCombinationTransform.h"
 #include "itkAdvancedRayCastInterpolateImageFunction.h"
+#include "itkConstantBoundaryCondition.h"
 
 namespace itk
 {
@@ -64,6 +65,15 @@ namespace itk
  * on it. Values at these non-grid position of the Fixed image are
  * interpolated using a user-selected Interpolator.
  *
+ * The derivative is computed analytically, by differentiating the measure
+ * with respect to the pixels of the projection of the moving image, and
+ * passing these weights to the ray cast interpolator, which multiplies
+ * them with the derivative of the projection with respect to the transform
+ * parameters. The subtraction factors are treated as constants. With
+ * UseFiniteDifferenceDerivative the derivative is computed by central
+ * finite differences instead, which is also done when the transform of the
+ * ray caster is not an AdvancedTransform.
+ *
  * Implementation of this class is based on:
  * Hipwell, J. H., et. al. (2003), "Intensity-Based 2-D-3D Registration of
  * Cerebral Angiograms,", IEEE Transactions on Medical Imaging,
@@ -144,6 +154,8 @@ public:
     CastMovedImageFilterType;
   typedef typename CastMovedImageFilterType::Pointer CastMovedImageFilterPointer;
   typedef typename MovedGradientImageType::PixelType MovedGradientPixelType;
+  typedef typename RayCastInterpolatorType::WeightImageType WeightImageType;
+  typedef typename WeightImageType::Pointer                 WeightImagePointer;
 
   /** Get the derivatives of the match measure. */
   void GetDerivative( const TransformParametersType & parameters,
@@ -170,6 +182,22 @@ public:
   itkSetMacro( DerivativeDelta, double );
   itkGetConstReferenceMacro( DerivativeDelta, double );
 
+  /** Compute the derivative by finite differences instead of analytically.
+   * Default: false.
+   */
+  itkSetMacro( UseFiniteDifferenceDerivative, bool );
+  itkGetConstMacro( UseFiniteDifferenceDerivative, bool );
+  itkBooleanMacro( UseFiniteDifferenceDerivative );
+
+  /** The finite difference derivative changes the transform parameters,
+   * so then this metric cannot run concurrently with other metrics.
+   */
+  virtual bool ConcurrentEvaluationSupported( void ) const
+  {
+    return !this->m_UseFiniteDifferenceDerivative;
+  }
+
+
 protected:
 
   GradientDifferenceImageToImageMetric();
@@ -186,12 +214,24 @@ protected:
   MeasureType ComputeMeasure( const TransformParametersType & parameters,
     const double * subtractionFactor ) const;
 
+  /** Compute the derivative by central finite differences. */
+  void ComputeFiniteDifferenceDerivative( const TransformParametersType & parameters,
+    DerivativeType & derivative ) const;
+
+  /** Compute the derivative analytically, for the moved image of the
+   * last call of GetValue().
+   */
+  void ComputeAnalyticDerivative( DerivativeType & derivative ) const;
+
   typedef NeighborhoodOperatorImageFilter<
     FixedGradientImageType, FixedGradientImageType > FixedSobelFilter;
 
   typedef NeighborhoodOperatorImageFilter<
     MovedGradientImageType, MovedGradientImageType > MovedSobelFilter;
 
+  typedef NeighborhoodOperatorImageFilter<
+    WeightImageType, WeightImageType > WeightSobelFilter;
+
 private:
 
   GradientDifferenceImageToImageMetric( const Self & ); // purposely not implemented
@@ -204,6 +244,9 @@ private:
   mutable MovedGradientPixelType m_MinMovedGradient[ MovedImageDimension ];
   mutable MovedGradientPixelType m_MaxMovedGradient[ MovedImageDimension ];
 
+  /** The subtraction factors of the last call of GetValue(). */
+  mutable MovedGradientPixelType m_SubtractionFactor[ FixedImageDimension ];
+
   /** The range of the fixed image gradients. */
   mutable FixedGradientPixelType m_MinFixedGradient[ FixedImageDimension ];
   mutable FixedGradientPixelType m_MaxFixedGradient[ FixedImageDimension ];
@@ -238,6 +281,8 @@ private:
   double                      m_DerivativeDelta;
   double                      m_Rescalingfactor;
   CombinationTransformPointer m_CombinationTransform;
+  RayCastInterpolatorPointer  m_RayCastInterpolator;
+  bool                        m_UseFiniteDifferenceDerivative;
 
 };
 
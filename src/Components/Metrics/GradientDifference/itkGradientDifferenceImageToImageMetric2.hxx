@@ -36,6 +36,7 @@
 
 #include "itkGradientDifferenceImageToImageMetric2.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIterator.h"
 #include "itkNumericTraits.h"
 #include "itkRescaleIntensityImageFilter.h"
 #include "itkImageFileWriter.h"
@@ -68,6 +69,7 @@ GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
     this->m_MinFixedGradient[ iDimension ] = 0;
     this->m_MaxFixedGradient[ iDimension ] = 0;
     this->m_Variance[ iDimension ]         = 0;
+    this->m_SubtractionFactor[ iDimension ] = 0;
   }
 
   for( iDimension = 0; iDimension < MovedImageDimension; iDimension++ )
@@ -76,8 +78,9 @@ GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
     this->m_MaxMovedGradient[ iDimension ] = 0;
   }
 
-  this->m_DerivativeDelta = 0.001;
-  this->m_Rescalingfactor = 1.0;
+  this->m_DerivativeDelta               = 0.001;
+  this->m_Rescalingfactor               = 1.0;
+  this->m_UseFiniteDifferenceDerivative = false;
 }
 
 
@@ -116,6 +119,14 @@ GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
   if( rayCaster != 0 )
   {
     this->m_TransformMovingImageFilter->SetTransform( rayCaster->GetTransform() );
+    this->m_RayCastInterpolator = rayCaster;
+
+    /** The analytic derivative needs the Jacobian of the transform. */
+    typedef typename RayCastInterpolatorType::AdvancedTransformType AdvancedTransformType;
+    if( dynamic_cast< AdvancedTransformType * >( rayCaster->GetTransform() ) == 0 )
+    {
+      this->m_UseFiniteDifferenceDerivative = true;
+    }
   }
   else
   {
@@ -171,6 +182,8 @@ GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
 {
   Superclass::PrintSelf( os, indent );
   os << indent << "DerivativeDelta: " << this->m_DerivativeDelta << std::endl;
+  os << indent << "UseFiniteDifferenceDerivative: "
+     << this->m_UseFiniteDifferenceDerivative << std::endl;
 
 }
 
@@ -479,16 +492,15 @@ GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
   /** Compute the range of the moved image gradients */
   this->ComputeMovedGradientRange();
 
-  MovedGradientPixelType subtractionFactor[ FixedImageDimension ];
-  MeasureType            currentMeasure;
+  MeasureType currentMeasure;
 
   for( iDimension = 0; iDimension < FixedImageDimension; iDimension++ )
   {
-    subtractionFactor[ iDimension ] = this->m_MaxFixedGradient[ iDimension ]
+    this->m_SubtractionFactor[ iDimension ] = this->m_MaxFixedGradient[ iDimension ]
       / this->m_MaxMovedGradient[ iDimension ];
   }
 
-  currentMeasure = this->ComputeMeasure( parameters, subtractionFactor );
+  currentMeasure = this->ComputeMeasure( parameters, this->m_SubtractionFactor );
 
   return currentMeasure;
 
@@ -504,6 +516,29 @@ void
 GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
 ::GetDerivative( const TransformParametersType & parameters,
   DerivativeType & derivative ) const
+{
+  if( this->m_UseFiniteDifferenceDerivative )
+  {
+    this->ComputeFiniteDifferenceDerivative( parameters, derivative );
+  }
+  else
+  {
+    MeasureType dummyvalue = NumericTraits< MeasureType >::Zero;
+    this->GetValueAndDerivative( parameters, dummyvalue, derivative );
+  }
+
+} // end GetDerivative()
+
+
+/**
+ * ******************** ComputeFiniteDifferenceDerivative ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeFiniteDifferenceDerivative( const TransformParametersType & parameters,
+  DerivativeType & derivative ) const
 {
   TransformParametersType testPoint;
   testPoint = parameters;
@@ -520,7 +555,109 @@ GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
     testPoint[ i ]  = parameters[ i ];
   }
 
-} // end GetDerivative()
+} // end ComputeFiniteDifferenceDerivative()
+
+
+/**
+ * ******************** ComputeAnalyticDerivative ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeAnalyticDerivative( DerivativeType & derivative ) const
+{
+  /** The weights of the pixels of the moved image, i.e. the derivative of
+   * the measure with respect to these pixels. They are the sum of the
+   * adjoint Sobel filters applied to the derivatives with respect to the
+   * moved gradients.
+   */
+  const MovedGradientImageType * movedImage = this->m_CastMovedImageFilter->GetOutput();
+  WeightImagePointer             weights    = WeightImageType::New();
+  weights->CopyInformation( movedImage );
+  weights->SetRegions( movedImage->GetLargestPossibleRegion() );
+  weights->Allocate();
+  weights->FillBuffer( 0.0 );
+
+  WeightImagePointer gradientWeights = WeightImageType::New();
+  gradientWeights->CopyInformation( movedImage );
+  gradientWeights->SetRegions( movedImage->GetLargestPossibleRegion() );
+  gradientWeights->Allocate();
+
+  typename FixedImageType::IndexType currentIndex;
+  typename FixedImageType::PointType point;
+
+  for( unsigned int iDimension = 0; iDimension < FixedImageDimension; iDimension++ )
+  {
+    const double variance = this->m_Variance[ iDimension ];
+    if( variance == NumericTraits< MovedGradientPixelType >::ZeroValue() )
+    {
+      continue;
+    }
+
+    /** The derivative of V / ( V + diff^2 ) / -R with respect to the moved
+     * gradient, for diff = fixedGradient - a * movedGradient.
+     */
+    gradientWeights->FillBuffer( 0.0 );
+
+    typedef itk::ImageRegionConstIteratorWithIndex< FixedGradientImageType > FixedIteratorType;
+    typedef itk::ImageRegionConstIteratorWithIndex< MovedGradientImageType > MovedIteratorType;
+
+    FixedIteratorType fixedIterator( this->m_FixedSobelFilters[ iDimension ]->GetOutput(),
+    this->GetFixedImageRegion() );
+    MovedIteratorType movedIterator( this->m_MovedSobelFilters[ iDimension ]->GetOutput(),
+    this->GetFixedImageRegion() );
+
+    const double factor = this->m_SubtractionFactor[ iDimension ];
+    while( !fixedIterator.IsAtEnd() )
+    {
+      currentIndex = fixedIterator.GetIndex();
+      this->m_FixedImage->TransformIndexToPhysicalPoint( currentIndex, point );
+
+      if( this->m_FixedImageMask.IsNull() || this->m_FixedImageMask->IsInside( point ) )
+      {
+        const double diff  = fixedIterator.Get() - factor * movedIterator.Get();
+        const double denom = variance + diff * diff;
+        gradientWeights->SetPixel( currentIndex,
+          -2.0 * factor * variance * diff / ( this->m_Rescalingfactor * denom * denom ) );
+      }
+
+      ++fixedIterator;
+      ++movedIterator;
+    }
+
+    /** The adjoint of the Sobel filter correlates with the reversed kernel,
+     * which is the negated kernel. Outside the image the gradient weights
+     * are zero.
+     */
+    SobelOperator< double, itkGetStaticConstMacro( FixedImageDimension ) > sobelOperator;
+    sobelOperator.SetDirection( iDimension );
+    sobelOperator.CreateDirectional();
+
+    ConstantBoundaryCondition< WeightImageType > zeroBoundCond;
+    typename WeightSobelFilter::Pointer          adjointFilter = WeightSobelFilter::New();
+    adjointFilter->OverrideBoundaryCondition( &zeroBoundCond );
+    adjointFilter->SetOperator( sobelOperator );
+    adjointFilter->SetInput( gradientWeights );
+    adjointFilter->Update();
+
+    ImageRegionConstIterator< WeightImageType > adjointIterator(
+      adjointFilter->GetOutput(), weights->GetLargestPossibleRegion() );
+    ImageRegionIterator< WeightImageType > weightIterator(
+      weights, weights->GetLargestPossibleRegion() );
+    while( !weightIterator.IsAtEnd() )
+    {
+      weightIterator.Set( weightIterator.Get() - adjointIterator.Get() );
+      ++adjointIterator;
+      ++weightIterator;
+    }
+  }
+
+  /** Multiply the weights with the derivative of the projection. */
+  this->m_RayCastInterpolator->EvaluateWeightedDerivative(
+    weights, this->m_Threader, derivative );
+
+} // end ComputeAnalyticDerivative()
 
 
 /**
@@ -534,7 +671,14 @@ GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
   MeasureType & Value, DerivativeType & derivative ) const
 {
   Value = this->GetValue( parameters );
-  this->GetDerivative( parameters, derivative );
+  if( this->m_UseFiniteDifferenceDerivative )
+  {
+    this->ComputeFiniteDifferenceDerivative( parameters, derivative );
+  }
+  else
+  {
+    this->ComputeAnalyticDerivative( derivative );
+  }
 
 } // end GetValueAndDerivative()
 
@@ -61,6 +61,10 @@ namespace itk
  * features, it would be better (but slower) to first apply the transform
  * on the image and then recalculate the feature.
  *
+ * The nearest neighbours of the samples are searched multi-threaded. The
+ * tree of the fixed features is only rebuilt when the fixed samples change,
+ * and the trees of the moving and joint features are built concurrently.
+ *
  * All the technical details can be found in:\n
  * M. Staring, U.A. van der Heide, S. Klein, M.A. Viergever and J.P.W. Pluim,
  * "Registration of Cervical MRI Using Multifeature Mutual Information,"
@@ -286,6 +290,26 @@ private:
   typedef Array2D< double >                         SpatialDerivativeType;
   typedef std::vector< SpatialDerivativeType >      SpatialDerivativeContainerType;
 
+  typedef typename NumericTraits< MeasureType >::AccumulateType AccumulateType;
+  typedef typename Superclass::ThreadInfoType                   ThreadInfoType;
+
+  /** The data shared by the threads that build the trees and search them.
+   * Each thread writes its part of the sums into m_SumG and m_Contributions.
+   */
+  struct KNNGraphThreaderParameterType
+  {
+    const Self *                                  m_Metric;
+    ListSampleType *                              m_ListSampleFixed;
+    ListSampleType *                              m_ListSampleMoving;
+    ListSampleType *                              m_ListSampleJoint;
+    bool                                          m_DoDerivative;
+    const TransformJacobianContainerType *        m_JacobianContainer;
+    const TransformJacobianIndicesContainerType * m_JacobianIndicesContainer;
+    const SpatialDerivativeContainerType *        m_SpatialDerivativesContainer;
+    std::vector< AccumulateType >                 m_SumG;
+    std::vector< DerivativeType >                 m_Contributions;
+  };
+
   /** This function takes the fixed image samples from the ImageSampler
    * and puts them in the listSampleFixed, together with the fixed feature
    * image samples. Also the corresponding moving image values and moving
@@ -335,6 +359,37 @@ private:
     DerivativeType & dGamma_M,
     DerivativeType & dGamma_J ) const;
 
+  /** Generate the three trees and connect them to the searchers.
+   * The fixed tree is only rebuilt when the fixed list sample changed,
+   * which is not the case for deterministic samplers. The moving and
+   * joint trees are built concurrently.
+   */
+  virtual void GenerateTrees( KNNGraphThreaderParameterType & parameters ) const;
+
+  /** Returns true if the fixed tree was built from a list sample with
+   * the same contents as the given one.
+   */
+  virtual bool FixedTreeIsUpToDate( const ListSampleType * listSampleFixed ) const;
+
+  /** Threader callback that builds the moving and the joint tree. */
+  static ITK_THREAD_RETURN_TYPE GenerateTreesThreaderCallback( void * arg );
+
+  /** Search the neighbours of all samples, and compute the sum of the
+   * graph length ratios and, if desired, its derivative. The samples are
+   * divided over the threads, which all use the same searchers.
+   */
+  virtual void ComputeGraphLengths( KNNGraphThreaderParameterType & parameters,
+    AccumulateType & sumG, DerivativeType & contribution ) const;
+
+  /** Compute the contribution of the samples in [begin, end). */
+  virtual void ComputeGraphLengthsOfRange(
+    const KNNGraphThreaderParameterType & parameters,
+    const unsigned long begin, const unsigned long end,
+    AccumulateType & sumG, DerivativeType & contribution ) const;
+
+  /** Threader callback that calls ComputeGraphLengthsOfRange(). */
+  static ITK_THREAD_RETURN_TYPE ComputeGraphLengthsThreaderCallback( void * arg );
+
 };
 
 } // end namespace itk
@@ -20,6 +20,9 @@
 
 #include "itkKNNGraphAlphaMutualInformationImageToImageMetric.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace itk
 {
 
@@ -330,31 +333,17 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
   this->CheckNumberOfSamples( size,
     this->m_NumberOfPixelsCounted );
 
-  /**
-   * *************** Generate the three trees ******************
-   *
-   * and connect them to the searchers.
-   */
-
-  /** Generate the tree for the fixed image samples. */
-  this->m_BinaryKNNTreeFixed->SetSample( listSampleFixed );
-  this->m_BinaryKNNTreeFixed->GenerateTree();
-
-  /** Generate the tree for the moving image samples. */
-  this->m_BinaryKNNTreeMoving->SetSample( listSampleMoving );
-  this->m_BinaryKNNTreeMoving->GenerateTree();
-
-  /** Generate the tree for the joint image samples. */
-  this->m_BinaryKNNTreeJoint->SetSample( listSampleJoint );
-  this->m_BinaryKNNTreeJoint->GenerateTree();
-
-  /** Initialize tree searchers. */
-  this->m_BinaryKNNTreeSearcherFixed
-  ->SetBinaryTree( this->m_BinaryKNNTreeFixed );
-  this->m_BinaryKNNTreeSearcherMoving
-  ->SetBinaryTree( this->m_BinaryKNNTreeMoving );
-  this->m_BinaryKNNTreeSearcherJoint
-  ->SetBinaryTree( this->m_BinaryKNNTreeJoint );
+  /** Generate the three trees and connect them to the searchers. */
+  KNNGraphThreaderParameterType threaderParameters;
+  threaderParameters.m_Metric                      = this;
+  threaderParameters.m_ListSampleFixed             = listSampleFixed.GetPointer();
+  threaderParameters.m_ListSampleMoving            = listSampleMoving.GetPointer();
+  threaderParameters.m_ListSampleJoint             = listSampleJoint.GetPointer();
+  threaderParameters.m_DoDerivative                = false;
+  threaderParameters.m_JacobianContainer           = &dummyJacobianContainer;
+  threaderParameters.m_JacobianIndicesContainer    = &dummyJacobianIndicesContainer;
+  threaderParameters.m_SpatialDerivativesContainer = &dummySpatialDerivativesContainer;
+  this->GenerateTrees( threaderParameters );
 
   /**
    * *************** Estimate the \alpha MI ******************
@@ -389,77 +378,10 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
    * where d1 and d2 are the possibly different dimensions of the two feature sets.
    */
 
-  /** Temporary variables. */
-  typedef typename NumericTraits< MeasureType >::AccumulateType AccumulateType;
-  MeasurementVectorType z_F, z_M, z_J;
-  IndexArrayType        indices_F, indices_M, indices_J;
-  DistanceArrayType     distances_F, distances_M, distances_J;
-
-  MeasureType    H, G;
+  /** Compute the sum over all query points. */
   AccumulateType sumG = NumericTraits< AccumulateType >::Zero;
-
-  /** Get the size of the feature vectors. */
-  unsigned int fixedSize  = this->GetNumberOfFixedImages();
-  unsigned int movingSize = this->GetNumberOfMovingImages();
-  unsigned int jointSize  = fixedSize + movingSize;
-
-  /** Get the number of neighbours and \gamma. */
-  unsigned int k        = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
-  double       twoGamma = jointSize * ( 1.0 - this->m_Alpha );
-
-  /** Loop over all query points, i.e. all samples. */
-  for( unsigned long i = 0; i < this->m_NumberOfPixelsCounted; i++ )
-  {
-    /** Get the i-th query point. */
-    listSampleFixed->GetMeasurementVector(  i, z_F );
-    listSampleMoving->GetMeasurementVector( i, z_M );
-    listSampleJoint->GetMeasurementVector(  i, z_J );
-
-    /** Search for the K nearest neighbours of the current query point. */
-    this->m_BinaryKNNTreeSearcherFixed->Search(  z_F, indices_F, distances_F );
-    this->m_BinaryKNNTreeSearcherMoving->Search( z_M, indices_M, distances_M );
-    this->m_BinaryKNNTreeSearcherJoint->Search(  z_J, indices_J, distances_J );
-
-    /** Add the distances between the points to get the total graph length.
-     * The outcommented implementation calculates: sum J/sqrt(F*M)
-     *
-    for ( unsigned int j = 0; j < K; j++ )
-    {
-    enumerator = vcl_sqrt( distsJ[ j ] );
-    denominator = vcl_sqrt( vcl_sqrt( distsF[ j ] ) * vcl_sqrt( distsM[ j ] ) );
-    if ( denominator > 1e-14 )
-    {
-    contribution += vcl_pow( enumerator / denominator, twoGamma );
-    }
-    }*/
-
-    /** Add the distances of all neighbours of the query point,
-    * for the three graphs:
-    * sum M / sqrt( sum F * sum M)
-    */
-
-    /** Variables to compute the measure. */
-    AccumulateType Gamma_F = NumericTraits< AccumulateType >::Zero;
-    AccumulateType Gamma_M = NumericTraits< AccumulateType >::Zero;
-    AccumulateType Gamma_J = NumericTraits< AccumulateType >::Zero;
-
-    /** Loop over the neighbours. */
-    for( unsigned int p = 0; p < k; p++ )
-    {
-      Gamma_F += vcl_sqrt( distances_F[ p ] );
-      Gamma_M += vcl_sqrt( distances_M[ p ] );
-      Gamma_J += vcl_sqrt( distances_J[ p ] );
-    } // end loop over the k neighbours
-
-    /** Calculate the contribution of this query point. */
-    H = vcl_sqrt( Gamma_F * Gamma_M );
-    if( H > this->m_AvoidDivisionBy )
-    {
-      /** Compute some sums. */
-      G     = Gamma_J / H;
-      sumG += vcl_pow( G, twoGamma );
-    }
-  } // end looping over all query points
+  DerivativeType dummyContribution;
+  this->ComputeGraphLengths( threaderParameters, sumG, dummyContribution );
 
   /**
    * *************** Finally, calculate the metric value \alpha MI ******************
@@ -555,31 +477,17 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
   unsigned long size = this->GetImageSampler()->GetOutput()->Size();
   this->CheckNumberOfSamples( size, this->m_NumberOfPixelsCounted );
 
-  /**
-   * *************** Generate the three trees ******************
-   *
-   * and connect them to the searchers.
-   */
-
-  /** Generate the tree for the fixed image samples. */
-  this->m_BinaryKNNTreeFixed->SetSample( listSampleFixed );
-  this->m_BinaryKNNTreeFixed->GenerateTree();
-
-  /** Generate the tree for the moving image samples. */
-  this->m_BinaryKNNTreeMoving->SetSample( listSampleMoving );
-  this->m_BinaryKNNTreeMoving->GenerateTree();
-
-  /** Generate the tree for the joint image samples. */
-  this->m_BinaryKNNTreeJoint->SetSample( listSampleJoint );
-  this->m_BinaryKNNTreeJoint->GenerateTree();
-
-  /** Initialize tree searchers. */
-  this->m_BinaryKNNTreeSearcherFixed
-  ->SetBinaryTree( this->m_BinaryKNNTreeFixed );
-  this->m_BinaryKNNTreeSearcherMoving
-  ->SetBinaryTree( this->m_BinaryKNNTreeMoving );
-  this->m_BinaryKNNTreeSearcherJoint
-  ->SetBinaryTree( this->m_BinaryKNNTreeJoint );
+  /** Generate the three trees and connect them to the searchers. */
+  KNNGraphThreaderParameterType threaderParameters;
+  threaderParameters.m_Metric                      = this;
+  threaderParameters.m_ListSampleFixed             = listSampleFixed.GetPointer();
+  threaderParameters.m_ListSampleMoving            = listSampleMoving.GetPointer();
+  threaderParameters.m_ListSampleJoint             = listSampleJoint.GetPointer();
+  threaderParameters.m_DoDerivative                = true;
+  threaderParameters.m_JacobianContainer           = &jacobianContainer;
+  threaderParameters.m_JacobianIndicesContainer    = &jacobianIndicesContainer;
+  threaderParameters.m_SpatialDerivativesContainer = &spatialDerivativesContainer;
+  this->GenerateTrees( threaderParameters );
 
   /**
    * *************** Estimate the \alpha MI and its derivatives ******************
@@ -614,107 +522,15 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
    * where d1 and d2 are the possibly different dimensions of the two feature sets.
    */
 
-  /** Temporary variables. */
-  typedef typename NumericTraits< MeasureType >::AccumulateType AccumulateType;
-  MeasurementVectorType z_F, z_M, z_J, z_M_ip, z_J_ip, diff_M, diff_J;
-  IndexArrayType        indices_F,   indices_M,   indices_J;
-  DistanceArrayType     distances_F, distances_M, distances_J;
-  MeasureType           distance_F,  distance_M,  distance_J;
-
-  MeasureType    H, G, Gpow;
+  /** Compute the sum over all query points and its derivative. */
   AccumulateType sumG = NumericTraits< AccumulateType >::Zero;
-
   DerivativeType contribution( this->GetNumberOfParameters() );
   contribution.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
-  DerivativeType dGamma_M( this->GetNumberOfParameters() );
-  DerivativeType dGamma_J( this->GetNumberOfParameters() );
+  this->ComputeGraphLengths( threaderParameters, sumG, contribution );
 
   /** Get the size of the feature vectors. */
-  unsigned int fixedSize  = this->GetNumberOfFixedImages();
-  unsigned int movingSize = this->GetNumberOfMovingImages();
-  unsigned int jointSize  = fixedSize + movingSize;
-
-  /** Get the number of neighbours and \gamma. */
-  unsigned int k        = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
-  double       twoGamma = jointSize * ( 1.0 - this->m_Alpha );
-
-  /** Loop over all query points, i.e. all samples. */
-  for( unsigned long i = 0; i < this->m_NumberOfPixelsCounted; i++ )
-  {
-    /** Get the i-th query point. */
-    listSampleFixed->GetMeasurementVector(  i, z_F );
-    listSampleMoving->GetMeasurementVector( i, z_M );
-    listSampleJoint->GetMeasurementVector(  i, z_J );
-
-    /** Search for the k nearest neighbours of the current query point. */
-    this->m_BinaryKNNTreeSearcherFixed->Search(  z_F, indices_F, distances_F );
-    this->m_BinaryKNNTreeSearcherMoving->Search( z_M, indices_M, distances_M );
-    this->m_BinaryKNNTreeSearcherJoint->Search(  z_J, indices_J, distances_J );
-
-    /** Variables to compute the measure and its derivative. */
-    AccumulateType Gamma_F = NumericTraits< AccumulateType >::Zero;
-    AccumulateType Gamma_M = NumericTraits< AccumulateType >::Zero;
-    AccumulateType Gamma_J = NumericTraits< AccumulateType >::Zero;
-
-    SpatialDerivativeType D1sparse, D2sparse_M, D2sparse_J;
-    D1sparse = spatialDerivativesContainer[ i ] * jacobianContainer[ i ];
-
-    dGamma_M.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
-    dGamma_J.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
-
-    /** Loop over the neighbours. */
-    for( unsigned int p = 0; p < k; p++ )
-    {
-      /** Get the neighbour point z_ip^M. */
-      listSampleMoving->GetMeasurementVector( indices_M[ p ], z_M_ip );
-      listSampleMoving->GetMeasurementVector( indices_J[ p ], z_J_ip );
-
-      /** Get the distances. */
-      distance_F = vcl_sqrt( distances_F[ p ] );
-      distance_M = vcl_sqrt( distances_M[ p ] );
-      distance_J = vcl_sqrt( distances_J[ p ] );
-
-      /** Compute Gamma's. */
-      Gamma_F += distance_F;
-      Gamma_M += distance_M;
-      Gamma_J += distance_J;
-
-      /** Get the difference of z_ip^M with z_i^M. */
-      diff_M = z_M - z_M_ip;
-      diff_J = z_M - z_J_ip;
-
-      /** Compute derivatives. */
-      D2sparse_M = spatialDerivativesContainer[ indices_M[ p ] ]
-        * jacobianContainer[ indices_M[ p ] ];
-      D2sparse_J = spatialDerivativesContainer[ indices_J[ p ] ]
-        * jacobianContainer[ indices_J[ p ] ];
-
-      /** Update the dGamma's. */
-      this->UpdateDerivativeOfGammas(
-        D1sparse, D2sparse_M, D2sparse_J,
-        jacobianIndicesContainer[ i ],
-        jacobianIndicesContainer[ indices_M[ p ] ],
-        jacobianIndicesContainer[ indices_J[ p ] ],
-        diff_M, diff_J,
-        distance_M, distance_J,
-        dGamma_M, dGamma_J );
-
-    } // end loop over the k neighbours
-
-    /** Compute contributions. */
-    H = vcl_sqrt( Gamma_F * Gamma_M );
-    if( H > this->m_AvoidDivisionBy )
-    {
-      /** Compute some sums. */
-      G     = Gamma_J / H;
-      sumG += vcl_pow( G, twoGamma );
-
-      /** Compute the contribution to the derivative. */
-      Gpow          = vcl_pow( G, twoGamma - 1.0 );
-      contribution += ( Gpow / H ) * ( dGamma_J - ( 0.5 * Gamma_J / Gamma_M ) * dGamma_M );
-    }
-
-  } // end looping over all query points
+  const unsigned int jointSize
+    = this->GetNumberOfFixedImages() + this->GetNumberOfMovingImages();
 
   /**
    * *************** Finally, calculate the metric value and derivative ******************
@@ -1076,6 +892,358 @@ KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
 } // end UpdateDerivativeOfGammas()
 
 
+/**
+ * ************************ GenerateTrees *************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::GenerateTrees( KNNGraphThreaderParameterType & parameters ) const
+{
+  /** Generate the tree for the fixed image samples. With a deterministic
+   * sampler the fixed samples, and so the fixed tree, do not change between
+   * iterations. The tree keeps a reference to the list sample it was built
+   * from, so the old tree can be reused.
+   */
+  if( !this->FixedTreeIsUpToDate( parameters.m_ListSampleFixed ) )
+  {
+    this->m_BinaryKNNTreeFixed->SetSample( parameters.m_ListSampleFixed );
+    this->m_BinaryKNNTreeFixed->GenerateTree();
+  }
+
+  /** Generate the trees for the moving and the joint image samples.
+   * They are independent, so they are built by two work items. The
+   * threads without a work item return immediately.
+   */
+  if( this->m_UseMultiThread )
+  {
+    PersistentThreadPool::Launch( this->m_Threader,
+      this->GenerateTreesThreaderCallback, &parameters );
+  }
+  else
+  {
+    this->m_BinaryKNNTreeMoving->SetSample( parameters.m_ListSampleMoving );
+    this->m_BinaryKNNTreeMoving->GenerateTree();
+    this->m_BinaryKNNTreeJoint->SetSample( parameters.m_ListSampleJoint );
+    this->m_BinaryKNNTreeJoint->GenerateTree();
+  }
+
+  /** Initialize tree searchers. */
+  this->m_BinaryKNNTreeSearcherFixed
+  ->SetBinaryTree( this->m_BinaryKNNTreeFixed );
+  this->m_BinaryKNNTreeSearcherMoving
+  ->SetBinaryTree( this->m_BinaryKNNTreeMoving );
+  this->m_BinaryKNNTreeSearcherJoint
+  ->SetBinaryTree( this->m_BinaryKNNTreeJoint );
+
+} // end GenerateTrees()
+
+
+/**
+ * ************************ FixedTreeIsUpToDate *************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+bool
+KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::FixedTreeIsUpToDate( const ListSampleType * listSampleFixed ) const
+{
+  /** A new tree, e.g. at the start of a resolution, has no sample yet. */
+  const ListSampleType * treeSample = this->m_BinaryKNNTreeFixed->GetSample();
+  if( treeSample == 0
+    || treeSample->GetMeasurementVectorSize() != listSampleFixed->GetMeasurementVectorSize()
+    || this->m_BinaryKNNTreeFixed->GetActualNumberOfDataPoints() != this->m_NumberOfPixelsCounted )
+  {
+    return false;
+  }
+
+  /** Compare the contents. For random samplers this stops at the first
+   * sample, so the check is much cheaper than building the tree.
+   */
+  typedef typename ListSampleType::InternalDataContainerType InternalDataContainerType;
+  const InternalDataContainerType & treeData  = treeSample->GetInternalContainer();
+  const InternalDataContainerType & newData   = listSampleFixed->GetInternalContainer();
+  const unsigned int                fixedSize = listSampleFixed->GetMeasurementVectorSize();
+  for( unsigned long i = 0; i < this->m_NumberOfPixelsCounted; ++i )
+  {
+    for( unsigned int j = 0; j < fixedSize; ++j )
+    {
+      if( treeData[ i ][ j ] != newData[ i ][ j ] )
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+
+} // end FixedTreeIsUpToDate()
+
+
+/**
+ * ************************ GenerateTreesThreaderCallback *************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+ITK_THREAD_RETURN_TYPE
+KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::GenerateTreesThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct  = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadID    = infoStruct->ThreadID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfThreads;
+
+  KNNGraphThreaderParameterType * parameters
+    = static_cast< KNNGraphThreaderParameterType * >( infoStruct->UserData );
+  const Self * metric = parameters->m_Metric;
+
+  /** Work item 0 builds the moving tree, work item 1 the joint tree. */
+  for( ThreadIdType i = threadID; i < 2; i += nrOfThreads )
+  {
+    if( i == 0 )
+    {
+      metric->m_BinaryKNNTreeMoving->SetSample( parameters->m_ListSampleMoving );
+      metric->m_BinaryKNNTreeMoving->GenerateTree();
+    }
+    else
+    {
+      metric->m_BinaryKNNTreeJoint->SetSample( parameters->m_ListSampleJoint );
+      metric->m_BinaryKNNTreeJoint->GenerateTree();
+    }
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end GenerateTreesThreaderCallback()
+
+
+/**
+ * ************************ ComputeGraphLengths *************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeGraphLengths( KNNGraphThreaderParameterType & parameters,
+  AccumulateType & sumG, DerivativeType & contribution ) const
+{
+  /** Single-threaded: no need for the intermediate sums. */
+  if( !this->m_UseMultiThread )
+  {
+    this->ComputeGraphLengthsOfRange( parameters,
+      0, this->m_NumberOfPixelsCounted, sumG, contribution );
+    return;
+  }
+
+  /** Initialize the sums of the threads. */
+  const ThreadIdType numberOfThreads = this->m_Threader->GetNumberOfThreads();
+  parameters.m_SumG.assign( numberOfThreads, NumericTraits< AccumulateType >::Zero );
+  parameters.m_Contributions.resize( numberOfThreads );
+  if( parameters.m_DoDerivative )
+  {
+    for( ThreadIdType i = 0; i < numberOfThreads; ++i )
+    {
+      parameters.m_Contributions[ i ].SetSize( this->GetNumberOfParameters() );
+      parameters.m_Contributions[ i ].Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
+    }
+  }
+
+  /** Launch the threads. The searchers are shared: the ANN search state is
+   * thread-local, and the searchers do not change during a search.
+   */
+  PersistentThreadPool::Launch( this->m_Threader,
+    this->ComputeGraphLengthsThreaderCallback, &parameters );
+
+  /** Accumulate the sums of the threads, in a fixed order. */
+  for( ThreadIdType i = 0; i < numberOfThreads; ++i )
+  {
+    sumG += parameters.m_SumG[ i ];
+    if( parameters.m_DoDerivative )
+    {
+      contribution += parameters.m_Contributions[ i ];
+    }
+  }
+
+} // end ComputeGraphLengths()
+
+
+/**
+ * ************************ ComputeGraphLengthsThreaderCallback *************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+ITK_THREAD_RETURN_TYPE
+KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeGraphLengthsThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct  = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadID    = infoStruct->ThreadID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfThreads;
+
+  KNNGraphThreaderParameterType * parameters
+    = static_cast< KNNGraphThreaderParameterType * >( infoStruct->UserData );
+  const Self * metric = parameters->m_Metric;
+
+  /** Each thread searches the neighbours of a contiguous range of samples. */
+  const unsigned long numberOfSamples      = metric->m_NumberOfPixelsCounted;
+  const unsigned long nrOfSamplesPerThread = static_cast< unsigned long >(
+    std::ceil( static_cast< double >( numberOfSamples ) / static_cast< double >( nrOfThreads ) ) );
+  const unsigned long pos_begin = std::min( nrOfSamplesPerThread * threadID, numberOfSamples );
+  const unsigned long pos_end   = std::min( nrOfSamplesPerThread * ( threadID + 1 ), numberOfSamples );
+
+  metric->ComputeGraphLengthsOfRange( *parameters, pos_begin, pos_end,
+    parameters->m_SumG[ threadID ], parameters->m_Contributions[ threadID ] );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ComputeGraphLengthsThreaderCallback()
+
+
+/**
+ * ************************ ComputeGraphLengthsOfRange *************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+KNNGraphAlphaMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeGraphLengthsOfRange(
+  const KNNGraphThreaderParameterType & parameters,
+  const unsigned long begin, const unsigned long end,
+  AccumulateType & sumG, DerivativeType & contribution ) const
+{
+  /** Get the list samples and the derivative information. */
+  const ListSampleType * listSampleFixed  = parameters.m_ListSampleFixed;
+  const ListSampleType * listSampleMoving = parameters.m_ListSampleMoving;
+  const ListSampleType * listSampleJoint  = parameters.m_ListSampleJoint;
+  const bool             doDerivative     = parameters.m_DoDerivative;
+
+  const TransformJacobianContainerType & jacobianContainer
+    = *parameters.m_JacobianContainer;
+  const TransformJacobianIndicesContainerType & jacobianIndicesContainer
+    = *parameters.m_JacobianIndicesContainer;
+  const SpatialDerivativeContainerType & spatialDerivativesContainer
+    = *parameters.m_SpatialDerivativesContainer;
+
+  /** Temporary variables. */
+  MeasurementVectorType z_F, z_M, z_J, z_M_ip, z_J_ip, diff_M, diff_J;
+  IndexArrayType        indices_F,   indices_M,   indices_J;
+  DistanceArrayType     distances_F, distances_M, distances_J;
+  MeasureType           distance_F,  distance_M,  distance_J;
+  MeasureType           H, G, Gpow;
+
+  DerivativeType dGamma_M, dGamma_J;
+  if( doDerivative )
+  {
+    dGamma_M.SetSize( this->GetNumberOfParameters() );
+    dGamma_J.SetSize( this->GetNumberOfParameters() );
+  }
+
+  /** Get the size of the feature vectors. */
+  unsigned int fixedSize  = this->GetNumberOfFixedImages();
+  unsigned int movingSize = this->GetNumberOfMovingImages();
+  unsigned int jointSize  = fixedSize + movingSize;
+
+  /** Get the number of neighbours and \gamma. */
+  unsigned int k        = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
+  double       twoGamma = jointSize * ( 1.0 - this->m_Alpha );
+
+  /** Loop over the query points. */
+  for( unsigned long i = begin; i < end; i++ )
+  {
+    /** Get the i-th query point. */
+    listSampleFixed->GetMeasurementVector(  i, z_F );
+    listSampleMoving->GetMeasurementVector( i, z_M );
+    listSampleJoint->GetMeasurementVector(  i, z_J );
+
+    /** Search for the k nearest neighbours of the current query point. */
+    this->m_BinaryKNNTreeSearcherFixed->Search(  z_F, indices_F, distances_F );
+    this->m_BinaryKNNTreeSearcherMoving->Search( z_M, indices_M, distances_M );
+    this->m_BinaryKNNTreeSearcherJoint->Search(  z_J, indices_J, distances_J );
+
+    /** Add the distances of all neighbours of the query point,
+     * for the three graphs:
+     * sum M / sqrt( sum F * sum M)
+     */
+
+    /** Variables to compute the measure and its derivative. */
+    AccumulateType Gamma_F = NumericTraits< AccumulateType >::Zero;
+    AccumulateType Gamma_M = NumericTraits< AccumulateType >::Zero;
+    AccumulateType Gamma_J = NumericTraits< AccumulateType >::Zero;
+
+    SpatialDerivativeType D1sparse, D2sparse_M, D2sparse_J;
+    if( doDerivative )
+    {
+      D1sparse = spatialDerivativesContainer[ i ] * jacobianContainer[ i ];
+      dGamma_M.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
+      dGamma_J.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
+    }
+
+    /** Loop over the neighbours. */
+    for( unsigned int p = 0; p < k; p++ )
+    {
+      /** Get the distances. */
+      distance_F = vcl_sqrt( distances_F[ p ] );
+      distance_M = vcl_sqrt( distances_M[ p ] );
+      distance_J = vcl_sqrt( distances_J[ p ] );
+
+      /** Compute Gamma's. */
+      Gamma_F += distance_F;
+      Gamma_M += distance_M;
+      Gamma_J += distance_J;
+
+      if( !doDerivative )
+      {
+        continue;
+      }
+
+      /** Get the neighbour point z_ip^M. */
+      listSampleMoving->GetMeasurementVector( indices_M[ p ], z_M_ip );
+      listSampleMoving->GetMeasurementVector( indices_J[ p ], z_J_ip );
+
+      /** Get the difference of z_ip^M with z_i^M. */
+      diff_M = z_M - z_M_ip;
+      diff_J = z_M - z_J_ip;
+
+      /** Compute derivatives. */
+      D2sparse_M = spatialDerivativesContainer[ indices_M[ p ] ]
+        * jacobianContainer[ indices_M[ p ] ];
+      D2sparse_J = spatialDerivativesContainer[ indices_J[ p ] ]
+        * jacobianContainer[ indices_J[ p ] ];
+
+      /** Update the dGamma's. */
+      this->UpdateDerivativeOfGammas(
+        D1sparse, D2sparse_M, D2sparse_J,
+        jacobianIndicesContainer[ i ],
+        jacobianIndicesContainer[ indices_M[ p ] ],
+        jacobianIndicesContainer[ indices_J[ p ] ],
+        diff_M, diff_J,
+        distance_M, distance_J,
+        dGamma_M, dGamma_J );
+
+    } // end loop over the k neighbours
+
+    /** Compute contributions. */
+    H = vcl_sqrt( Gamma_F * Gamma_M );
+    if( H > this->m_AvoidDivisionBy )
+    {
+      /** Compute some sums. */
+      G     = Gamma_J / H;
+      sumG += vcl_pow( G, twoGamma );
+
+      /** Compute the contribution to the derivative. */
+      if( doDerivative )
+      {
+        Gpow          = vcl_pow( G, twoGamma - 1.0 );
+        contribution += ( Gpow / H ) * ( dGamma_J - ( 0.5 * Gamma_J / Gamma_M ) * dGamma_M );
+      }
+    }
+
+  } // end looping over the query points
+
+} // end ComputeGraphLengthsOfRange()
+
+
 /**
  * ************************ PrintSelf *************************
  */
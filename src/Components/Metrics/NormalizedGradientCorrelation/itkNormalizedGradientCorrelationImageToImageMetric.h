@@ -27,6 +27,7 @@
 #include "itkOptimizer.h"
 #include "itkAdvancedCombinationTransform.h"
 #include "itkAdvancedRayCastInterpolateImageFunction.h"
+#include "itkConstantBoundaryCondition.h"
 
 namespace itk
 {
@@ -35,6 +36,13 @@ namespace itk
  * \class NormalizedGradientCorrelationImageToImageMetric
  * \brief An metric based on the itk::NormalizedGradientCorrelationImageToImageMetric.
  *
+ * The derivative is computed analytically, by differentiating the measure
+ * with respect to the pixels of the projection of the moving image, and
+ * passing these weights to the ray cast interpolator, which multiplies
+ * them with the derivative of the projection with respect to the transform
+ * parameters. With UseFiniteDifferenceDerivative the derivative is computed
+ * by central finite differences instead, which is also done when the
+ * transform of the ray caster is not an AdvancedTransform.
  *
  * \ingroup Metrics
  *
@@ -122,6 +130,8 @@ public:
     MovedGradientImageType >                              CastMovedImageFilterType;
   typedef typename CastMovedImageFilterType::Pointer CastMovedImageFilterPointer;
   typedef typename MovedGradientImageType::PixelType MovedGradientPixelType;
+  typedef typename RayCastInterpolatorType::WeightImageType WeightImageType;
+  typedef typename WeightImageType::Pointer                 WeightImagePointer;
 
   /** Get the derivatives of the match measure. */
   virtual void GetDerivative( const TransformParametersType & parameters,
@@ -155,6 +165,22 @@ public:
   /** Set the parameters defining the Transform. */
   void SetTransformParameters( const TransformParametersType & parameters ) const;
 
+  /** Compute the derivative by finite differences instead of analytically.
+   * Default: false.
+   */
+  itkSetMacro( UseFiniteDifferenceDerivative, bool );
+  itkGetConstMacro( UseFiniteDifferenceDerivative, bool );
+  itkBooleanMacro( UseFiniteDifferenceDerivative );
+
+  /** The finite difference derivative changes the transform parameters,
+   * so then this metric cannot run concurrently with other metrics.
+   */
+  virtual bool ConcurrentEvaluationSupported( void ) const
+  {
+    return !this->m_UseFiniteDifferenceDerivative;
+  }
+
+
 protected:
 
   NormalizedGradientCorrelationImageToImageMetric();
@@ -169,10 +195,21 @@ protected:
   /** Compute the similarity measure  */
   MeasureType ComputeMeasure( const TransformParametersType & parameters ) const;
 
+  /** Compute the derivative by central finite differences. */
+  void ComputeFiniteDifferenceDerivative( const TransformParametersType & parameters,
+    DerivativeType & derivative ) const;
+
+  /** Compute the derivative analytically, for the moved image of the
+   * last call of GetValue().
+   */
+  void ComputeAnalyticDerivative( DerivativeType & derivative ) const;
+
   typedef NeighborhoodOperatorImageFilter<
     FixedGradientImageType, FixedGradientImageType >        FixedSobelFilter;
   typedef NeighborhoodOperatorImageFilter<
     MovedGradientImageType, MovedGradientImageType >        MovedSobelFilter;
+  typedef NeighborhoodOperatorImageFilter<
+    WeightImageType, WeightImageType >                      WeightSobelFilter;
 
 private:
 
@@ -182,6 +219,13 @@ private:
   ScalesType                  m_Scales;
   double                      m_DerivativeDelta;
   CombinationTransformPointer m_CombinationTransform;
+  RayCastInterpolatorPointer  m_RayCastInterpolator;
+  bool                        m_UseFiniteDifferenceDerivative;
+
+  /** The correlations of the last call of ComputeMeasure(). */
+  mutable MeasureType m_CrossCorrelation;
+  mutable MeasureType m_FixedAutoCorrelation;
+  mutable MeasureType m_MovedAutoCorrelation;
 
   /** The mean of the moving image gradients. */
   mutable MovedGradientPixelType m_MeanMovedGradient[ MovedImageDimension ];
@@ -20,6 +20,7 @@
 
 #include "itkNormalizedGradientCorrelationImageToImageMetric.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIterator.h"
 #include "itkNumericTraits.h"
 #include "itkSimpleFilterWatcher.h"
 
@@ -38,11 +39,15 @@ template< class TFixedImage, class TMovingImage >
 NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
 ::NormalizedGradientCorrelationImageToImageMetric()
 {
-  this->m_CastFixedImageFilter       = CastFixedImageFilterType::New();
-  this->m_CastMovedImageFilter       = CastMovedImageFilterType::New();
-  this->m_CombinationTransform       = CombinationTransformType::New();
-  this->m_TransformMovingImageFilter = TransformMovingImageFilterType::New();
-  this->m_DerivativeDelta            = 0.001;
+  this->m_CastFixedImageFilter          = CastFixedImageFilterType::New();
+  this->m_CastMovedImageFilter          = CastMovedImageFilterType::New();
+  this->m_CombinationTransform          = CombinationTransformType::New();
+  this->m_TransformMovingImageFilter    = TransformMovingImageFilterType::New();
+  this->m_DerivativeDelta               = 0.001;
+  this->m_UseFiniteDifferenceDerivative = false;
+  this->m_CrossCorrelation              = NumericTraits< MeasureType >::Zero;
+  this->m_FixedAutoCorrelation          = NumericTraits< MeasureType >::Zero;
+  this->m_MovedAutoCorrelation          = NumericTraits< MeasureType >::Zero;
 
   for( unsigned int iDimension = 0; iDimension < MovedImageDimension; iDimension++ )
   {
@@ -90,6 +95,14 @@ NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
   if( rayCaster != 0 )
   {
     this->m_TransformMovingImageFilter->SetTransform( rayCaster->GetTransform() );
+    this->m_RayCastInterpolator = rayCaster;
+
+    /** The analytic derivative needs the Jacobian of the transform. */
+    typedef typename RayCastInterpolatorType::AdvancedTransformType AdvancedTransformType;
+    if( dynamic_cast< AdvancedTransformType * >( rayCaster->GetTransform() ) == 0 )
+    {
+      this->m_UseFiniteDifferenceDerivative = true;
+    }
   }
   else
   {
@@ -134,6 +147,8 @@ NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
 {
   Superclass::PrintSelf( os, indent );
   os << indent << "DerivativeDelta: " << this->m_DerivativeDelta << std::endl;
+  os << indent << "UseFiniteDifferenceDerivative: "
+     << this->m_UseFiniteDifferenceDerivative << std::endl;
 } // end PrintSelf()
 
 
@@ -393,6 +408,10 @@ NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
 
   } // end while
 
+  this->m_CrossCorrelation     = NGcrosscorrelation;
+  this->m_FixedAutoCorrelation = NGautocorrelationfixed;
+  this->m_MovedAutoCorrelation = NGautocorrelationmoving;
+
   measure = -1.0 * ( NGcrosscorrelation
     / ( vcl_sqrt( NGautocorrelationfixed ) * vcl_sqrt( NGautocorrelationmoving ) ) );
   return measure;
@@ -469,6 +488,29 @@ void
 NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
 ::GetDerivative( const TransformParametersType & parameters,
   DerivativeType & derivative ) const
+{
+  if( this->m_UseFiniteDifferenceDerivative )
+  {
+    this->ComputeFiniteDifferenceDerivative( parameters, derivative );
+  }
+  else
+  {
+    MeasureType dummyvalue = NumericTraits< MeasureType >::Zero;
+    this->GetValueAndDerivative( parameters, dummyvalue, derivative );
+  }
+
+} // end GetDerivative()
+
+
+/**
+ * ***************** ComputeFiniteDifferenceDerivative *****************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeFiniteDifferenceDerivative( const TransformParametersType & parameters,
+  DerivativeType & derivative ) const
 {
   TransformParametersType testPoint;
   testPoint = parameters;
@@ -485,7 +527,114 @@ NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
     testPoint[ i ]  = parameters[ i ];
   }
 
-} // end GetDerivative()
+} // end ComputeFiniteDifferenceDerivative()
+
+
+/**
+ * ***************** ComputeAnalyticDerivative *****************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeAnalyticDerivative( DerivativeType & derivative ) const
+{
+  /** The weights of the pixels of the moved image, i.e. the derivative of
+   * the measure with respect to these pixels. They are the sum of the
+   * adjoint Sobel filters applied to the derivatives with respect to the
+   * moved gradients.
+   */
+  const MovedGradientImageType * movedImage = this->m_CastMovedImageFilter->GetOutput();
+  WeightImagePointer             weights    = WeightImageType::New();
+  weights->CopyInformation( movedImage );
+  weights->SetRegions( movedImage->GetLargestPossibleRegion() );
+  weights->Allocate();
+  weights->FillBuffer( 0.0 );
+
+  const double denominator = vcl_sqrt( this->m_FixedAutoCorrelation )
+    * vcl_sqrt( this->m_MovedAutoCorrelation );
+  if( denominator == 0.0 )
+  {
+    derivative = DerivativeType( this->GetNumberOfParameters() );
+    derivative.Fill( 0.0 );
+    return;
+  }
+  const double ratio = this->m_CrossCorrelation / this->m_MovedAutoCorrelation;
+
+  WeightImagePointer gradientWeights = WeightImageType::New();
+  gradientWeights->CopyInformation( movedImage );
+  gradientWeights->SetRegions( movedImage->GetLargestPossibleRegion() );
+  gradientWeights->Allocate();
+
+  typename FixedImageType::IndexType currentIndex;
+  typename FixedImageType::PointType point;
+
+  /** As in ComputeMeasure(), only the first two dimensions are used. */
+  for( unsigned int iDimension = 0; iDimension < 2; iDimension++ )
+  {
+    /** The derivative of -C / ( sqrt( F ) sqrt( M ) ) with respect to the
+     * moved gradient. The normalized gradients of the masked pixels sum to
+     * zero, so the derivative of the mean moved gradient cancels.
+     */
+    gradientWeights->FillBuffer( 0.0 );
+
+    typedef itk::ImageRegionConstIteratorWithIndex< FixedGradientImageType > FixedIteratorType;
+    typedef itk::ImageRegionConstIteratorWithIndex< MovedGradientImageType > MovedIteratorType;
+
+    FixedIteratorType fixedIterator( this->m_FixedSobelFilters[ iDimension ]->GetOutput(),
+    this->GetFixedImageRegion() );
+    MovedIteratorType movedIterator( this->m_MovedSobelFilters[ iDimension ]->GetOutput(),
+    this->GetFixedImageRegion() );
+
+    while( !fixedIterator.IsAtEnd() )
+    {
+      currentIndex = fixedIterator.GetIndex();
+      this->m_FixedImage->TransformIndexToPhysicalPoint( currentIndex, point );
+
+      if( this->m_FixedImageMask.IsNull() || this->m_FixedImageMask->IsInside( point ) )
+      {
+        const double nfixed = fixedIterator.Get() - this->m_MeanFixedGradient[ iDimension ];
+        const double nmoved = movedIterator.Get() - this->m_MeanMovedGradient[ iDimension ];
+        gradientWeights->SetPixel( currentIndex,
+          -( nfixed - ratio * nmoved ) / denominator );
+      }
+
+      ++fixedIterator;
+      ++movedIterator;
+    }
+
+    /** The adjoint of the Sobel filter correlates with the reversed kernel,
+     * which is the negated kernel. Outside the image the gradient weights
+     * are zero.
+     */
+    SobelOperator< double, itkGetStaticConstMacro( MovedImageDimension ) > sobelOperator;
+    sobelOperator.SetDirection( iDimension );
+    sobelOperator.CreateDirectional();
+
+    ConstantBoundaryCondition< WeightImageType > zeroBoundCond;
+    typename WeightSobelFilter::Pointer          adjointFilter = WeightSobelFilter::New();
+    adjointFilter->OverrideBoundaryCondition( &zeroBoundCond );
+    adjointFilter->SetOperator( sobelOperator );
+    adjointFilter->SetInput( gradientWeights );
+    adjointFilter->Update();
+
+    ImageRegionConstIterator< WeightImageType > adjointIterator(
+      adjointFilter->GetOutput(), weights->GetLargestPossibleRegion() );
+    ImageRegionIterator< WeightImageType > weightIterator(
+      weights, weights->GetLargestPossibleRegion() );
+    while( !weightIterator.IsAtEnd() )
+    {
+      weightIterator.Set( weightIterator.Get() - adjointIterator.Get() );
+      ++adjointIterator;
+      ++weightIterator;
+    }
+  }
+
+  /** Multiply the weights with the derivative of the projection. */
+  this->m_RayCastInterpolator->EvaluateWeightedDerivative(
+    weights, this->m_Threader, derivative );
+
+} // end ComputeAnalyticDerivative()
 
 
 /**
@@ -499,7 +648,14 @@ NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
   MeasureType & value, DerivativeType & derivative ) const
 {
   value = this->GetValue( parameters );
-  this->GetDerivative( parameters, derivative );
+  if( this->m_UseFiniteDifferenceDerivative )
+  {
+    this->ComputeFiniteDifferenceDerivative( parameters, derivative );
+  }
+  else
+  {
+    this->ComputeAnalyticDerivative( derivative );
+  }
 
 } // end GetValueAndDerivative()
 
@@ -67,6 +67,9 @@ void PCAMetric<TElastix>
     "SubtractMean", this->GetComponentLabel(), 0, 0 );
   this->SetSubtractMean( subtractMean );
 
+  /** Select the last dimension positions with the random number generator of this run. */
+  this->SetRandomGenerator( this->GetElastix()->GetRandomGenerator() );
+
   /** Get and set the number of additional samples sampled at the fixed timepoint.  */
 //    unsigned int numAdditionalSamplesFixed = 0;
 //    this->GetConfiguration()->ReadParameter( numAdditionalSamplesFixed,
@@ -22,6 +22,7 @@
 
 #include "itkSmoothingRecursiveGaussianImageFilter.h"
 #include "itkImageRandomCoordinateSampler.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkNearestNeighborInterpolateImageFunction.h"
 #include "itkExtractImageFilter.h"
 
@@ -51,6 +52,9 @@ public:
   /** Run-time type information (and related methods). */
   itkTypeMacro( PCAMetric, AdvancedImageToImageMetric );
 
+  /** The random number generator. */
+  typedef Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+
   /** Set functions. */
   itkSetMacro( SampleLastDimensionRandomly, bool );
   itkSetMacro( NumSamplesLastDimension, unsigned int );
@@ -64,6 +68,11 @@ public:
   itkSetMacro( DeNoise, bool );
   itkSetMacro( VarNoise, double );
 
+  /** Set the random number generator that selects the last dimension
+   * positions. The global instance is used by default.
+   */
+  itkSetObjectMacro( RandomGenerator, RandomGeneratorType );
+
   /** Get functions. */
   itkGetConstMacro( SampleLastDimensionRandomly, bool );
   itkGetConstMacro( NumSamplesLastDimension, int );
@@ -205,6 +214,9 @@ private:
   /** Bool to indicate if the transform used is a stacktransform. Set by elx files. */
   bool m_TransformIsStackTransform;
 
+  /** The random number generator that selects the last dimension positions. */
+  RandomGeneratorType::Pointer m_RandomGenerator;
+
   /** Integer to indicate how many eigenvalues you want to use in the metric */
   unsigned int m_NumEigenValues;
 
@@ -20,7 +20,6 @@
 
 #include "itkPCAMetric.h"
 
-#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "vnl/algo/vnl_matrix_update.h"
 #include "itkImage.h"
 #include "vnl/algo/vnl_svd.h"
@@ -48,6 +47,7 @@ PCAMetric<TFixedImage,TMovingImage>
   this->SetUseImageSampler( true );
   this->SetUseFixedImageLimiter( false );
   this->SetUseMovingImageLimiter( false );
+  this->m_RandomGenerator = RandomGeneratorType::GetInstance();
 } // end constructor
 
 
@@ -106,9 +106,6 @@ PCAMetric<TFixedImage, TMovingImage>
   /** Empty list of last dimension positions. */
   numbers.clear();
 
-  /** Initialize random number generator. */
-  Statistics::MersenneTwisterRandomVariateGenerator::Pointer randomGenerator = Statistics::MersenneTwisterRandomVariateGenerator::GetInstance();
-
   /** Sample additional at fixed timepoint. */
   for( unsigned int i = 0; i < m_NumAdditionalSamplesFixed; ++i )
   {
@@ -121,7 +118,7 @@ PCAMetric<TFixedImage, TMovingImage>
     int randomNum = 0;
     do
     {
-      randomNum = static_cast<int>( randomGenerator->GetVariateWithClosedRange( m ) );
+      randomNum = static_cast<int>( this->m_RandomGenerator->GetVariateWithClosedRange( m ) );
     } while( find( numbers.begin(), numbers.end(), randomNum ) != numbers.end() );
     numbers.push_back( randomNum );
   }
@@ -29,6 +29,14 @@ namespace elastix
  * \class PatternIntensityMetric
  * \brief An metric based on the itk::PatternIntensityImageToImageMetric.
  *
+ * The parameters used in this class are:
+ * \parameter Metric: Select this metric as follows:\n
+ *    <tt>(Metric "PatternIntensity")</tt>
+ * \parameter UseFiniteDifferenceDerivative: Compute the derivative by finite
+ *    differences, instead of analytically from the Jacobian of the transform.
+ *    Can be given for each resolution, or for all resolutions at once. \n
+ *    example: <tt>(UseFiniteDifferenceDerivative "false")</tt> \n
+ *    The default is "false".
  *
  * \ingroup Metrics
  *
@@ -93,6 +93,12 @@ PatternIntensityMetric< TElastix >
     "OptimizeNormalizationFactor", this->GetComponentLabel(), level, 0 );
   this->SetOptimizeNormalizationFactor( optimizenormalizationfactor );
 
+  /** Set the derivative method. */
+  bool useFiniteDifferenceDerivative = false;
+  this->m_Configuration->ReadParameter( useFiniteDifferenceDerivative,
+    "UseFiniteDifferenceDerivative", this->GetComponentLabel(), level, 0 );
+  this->SetUseFiniteDifferenceDerivative( useFiniteDifferenceDerivative );
+
   typedef typename elastix::OptimizerBase< TElastix >::ITKBaseType::ScalesType ScalesType;
   ScalesType scales = this->m_Elastix->GetElxOptimizerBase()->GetAsITKBaseType()->GetScales();
   this->SetScales( scales );
@@ -36,7 +36,14 @@ namespace itk
 /** \class PatternIntensityImageToImageMetric
  * \brief Computes similarity between two objects to be registered
  *
- *
+ * The derivative is computed analytically, by differentiating the measure
+ * with respect to the pixels of the projection of the moving image, and
+ * passing these weights to the ray cast interpolator, which multiplies
+ * them with the derivative of the projection with respect to the transform
+ * parameters. The normalization factor is treated as a constant. With
+ * UseFiniteDifferenceDerivative the derivative is computed by central
+ * finite differences instead, which is also done when the transform of the
+ * ray caster is not an AdvancedTransform.
  *
  * \ingroup RegistrationMetrics
  */
@@ -139,6 +146,8 @@ public:
     TransformedMovingImageType,
     TransformedMovingImageType >         MultiplyImageFilterType;
   typedef typename MultiplyImageFilterType::Pointer MultiplyImageFilterPointer;
+  typedef typename RayCastInterpolatorType::WeightImageType WeightImageType;
+  typedef typename WeightImageType::Pointer                 WeightImagePointer;
 
   /** The moving image dimension. */
   itkStaticConstMacro( MovingImageDimension, unsigned int,
@@ -174,6 +183,22 @@ public:
   itkSetMacro( OptimizeNormalizationFactor, bool );
   itkGetConstReferenceMacro( OptimizeNormalizationFactor, bool );
 
+  /** Compute the derivative by finite differences instead of analytically.
+   * Default: false.
+   */
+  itkSetMacro( UseFiniteDifferenceDerivative, bool );
+  itkGetConstMacro( UseFiniteDifferenceDerivative, bool );
+  itkBooleanMacro( UseFiniteDifferenceDerivative );
+
+  /** The finite difference derivative changes the transform parameters,
+   * so then this metric cannot run concurrently with other metrics.
+   */
+  virtual bool ConcurrentEvaluationSupported( void ) const
+  {
+    return !this->m_UseFiniteDifferenceDerivative;
+  }
+
+
 protected:
 
   PatternIntensityImageToImageMetric();
@@ -186,6 +211,15 @@ protected:
   /** Compute the pattern intensity difference image. */
   MeasureType ComputePIDiff( const TransformParametersType & parameters, float scalingfactor ) const;
 
+  /** Compute the derivative by central finite differences. */
+  void ComputeFiniteDifferenceDerivative( const TransformParametersType & parameters,
+    DerivativeType & derivative ) const;
+
+  /** Compute the derivative analytically, for the moved image of the
+   * last call of GetValue().
+   */
+  void ComputeAnalyticDerivative( DerivativeType & derivative ) const;
+
 private:
 
   PatternIntensityImageToImageMetric( const Self & ); // purposely not implemented
@@ -204,6 +238,13 @@ private:
   ScalesType                         m_Scales;
   MeasureType                        m_FixedMeasure;
   CombinationTransformPointer        m_CombinationTransform;
+  RayCastInterpolatorPointer         m_RayCastInterpolator;
+  bool                               m_UseFiniteDifferenceDerivative;
+
+  /** The normalization factor that gave the value of the last call of
+   * GetValue().
+   */
+  mutable float m_CurrentNormalizationFactor;
 
 };
 
@@ -20,6 +20,7 @@
 
 #include "itkPatternIntensityImageToImageMetric.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIterator.h"
 #include "itkNumericTraits.h"
 
 #include <iostream>
@@ -38,18 +39,20 @@ template< class TFixedImage, class TMovingImage >
 PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
 ::PatternIntensityImageToImageMetric()
 {
-  this->m_NormalizationFactor         = 1.0;
-  this->m_Rescalingfactor             = 1.0;
-  this->m_DerivativeDelta             = 0.001;
-  this->m_NoiseConstant               = 10000; // = sigma * sigma = 100*100 if not specified
-  this->m_NeighborhoodRadius          = 3;
-  this->m_FixedMeasure                = 0;
-  this->m_OptimizeNormalizationFactor = false;
-  this->m_TransformMovingImageFilter  = TransformMovingImageFilterType::New();
-  this->m_CombinationTransform        = CombinationTransformType::New();
-  this->m_RescaleImageFilter          = RescaleIntensityImageFilterType::New();
-  this->m_DifferenceImageFilter       = DifferenceImageFilterType::New();
-  this->m_MultiplyImageFilter         = MultiplyImageFilterType::New();
+  this->m_NormalizationFactor           = 1.0;
+  this->m_Rescalingfactor               = 1.0;
+  this->m_DerivativeDelta               = 0.001;
+  this->m_NoiseConstant                 = 10000; // = sigma * sigma = 100*100 if not specified
+  this->m_NeighborhoodRadius            = 3;
+  this->m_FixedMeasure                  = 0;
+  this->m_OptimizeNormalizationFactor   = false;
+  this->m_UseFiniteDifferenceDerivative = false;
+  this->m_CurrentNormalizationFactor    = 1.0;
+  this->m_TransformMovingImageFilter    = TransformMovingImageFilterType::New();
+  this->m_CombinationTransform          = CombinationTransformType::New();
+  this->m_RescaleImageFilter            = RescaleIntensityImageFilterType::New();
+  this->m_DifferenceImageFilter         = DifferenceImageFilterType::New();
+  this->m_MultiplyImageFilter           = MultiplyImageFilterType::New();
 
 } // end Constructor
 
@@ -71,6 +74,14 @@ PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
   if( rayCaster != 0 )
   {
     this->m_TransformMovingImageFilter->SetTransform( rayCaster->GetTransform() );
+    this->m_RayCastInterpolator = rayCaster;
+
+    /** The analytic derivative needs the Jacobian of the transform. */
+    typedef typename RayCastInterpolatorType::AdvancedTransformType AdvancedTransformType;
+    if( dynamic_cast< AdvancedTransformType * >( rayCaster->GetTransform() ) == 0 )
+    {
+      this->m_UseFiniteDifferenceDerivative = true;
+    }
   }
   else
   {
@@ -128,6 +139,8 @@ PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
 {
   Superclass::PrintSelf( os, indent );
   os << indent << "DerivativeDelta: " << this->m_DerivativeDelta << std::endl;
+  os << indent << "UseFiniteDifferenceDerivative: "
+     << this->m_UseFiniteDifferenceDerivative << std::endl;
 
 } // end PrintSelf()
 
@@ -150,7 +163,7 @@ PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
   typename FixedImageType::SizeType neighborIterationSize;
   typename FixedImageType::PointType point;
 
-  iterationSize.Fill( 1 ); neighborIterationSize.Fill( 1 ); iterationStartIndex.Fill( 0 );
+  neighborIterationSize.Fill( 1 ); iterationStartIndex.Fill( 0 );
   for( unsigned int i = 0; i < 2; ++i ) // Only 2D
   {
     iterationSize[ i ]        -= static_cast< int >( 2 * this->m_NeighborhoodRadius );
@@ -262,7 +275,7 @@ PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
   typename FixedImageType::SizeType neighborIterationSize;
   typename FixedImageType::PointType point;
 
-  iterationSize.Fill( 1 ); neighborIterationSize.Fill( 1 ); iterationStartIndex.Fill( 0 );
+  neighborIterationSize.Fill( 1 ); iterationStartIndex.Fill( 0 );
   for( unsigned int i = 0; i < 2; ++i ) // Only 2D
   {
     iterationSize[ i ]        -= static_cast< int >( 2 * this->m_NeighborhoodRadius );
@@ -372,7 +385,7 @@ PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
   {
     float tmpfactor  =  0.0;
     float factorstep =  ( this->m_NormalizationFactor * 10 - tmpfactor ) / 100;
-    //float bestfactor = tmpfactor;
+    float bestfactor = tmpfactor;
     MeasureType tmpMeasure = 1e10;
 
     while( tmpfactor <=  this->m_NormalizationFactor * 1.0 )
@@ -383,16 +396,18 @@ PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
       if( tmpMeasure < currentMeasure )
       {
         currentMeasure = tmpMeasure;
-        //bestfactor = tmpfactor;
+        bestfactor     = tmpfactor;
       }
 
       tmpfactor += factorstep;
     }
+    this->m_CurrentNormalizationFactor = bestfactor;
   }
   else
   {
     measure        = this->ComputePIDiff( parameters, this->m_NormalizationFactor );
     currentMeasure = -( measure - this->m_FixedMeasure ) / this->m_Rescalingfactor;
+    this->m_CurrentNormalizationFactor = this->m_NormalizationFactor;
   }
 
   return currentMeasure;
@@ -409,6 +424,29 @@ void
 PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
 ::GetDerivative( const TransformParametersType & parameters,
   DerivativeType & derivative ) const
+{
+  if( this->m_UseFiniteDifferenceDerivative )
+  {
+    this->ComputeFiniteDifferenceDerivative( parameters, derivative );
+  }
+  else
+  {
+    MeasureType dummyvalue = NumericTraits< MeasureType >::Zero;
+    this->GetValueAndDerivative( parameters, dummyvalue, derivative );
+  }
+
+} // end GetDerivative()
+
+
+/**
+ * ********************* ComputeFiniteDifferenceDerivative ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeFiniteDifferenceDerivative( const TransformParametersType & parameters,
+  DerivativeType & derivative ) const
 {
   TransformParametersType testPoint;
   testPoint = parameters;
@@ -425,7 +463,113 @@ PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
     testPoint[ i ]  = parameters[ i ];
   }
 
-} // end GetDerivative()
+} // end ComputeFiniteDifferenceDerivative()
+
+
+/**
+ * ********************* ComputeAnalyticDerivative ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeAnalyticDerivative( DerivativeType & derivative ) const
+{
+  /** The difference image of the normalization factor that gave the value;
+   * when the factor is optimized, the last one that was tried may differ.
+   */
+  const float scalingfactor = this->m_CurrentNormalizationFactor;
+  if( this->m_OptimizeNormalizationFactor )
+  {
+    this->m_MultiplyImageFilter->SetConstant( scalingfactor );
+    this->m_DifferenceImageFilter->UpdateLargestPossibleRegion();
+  }
+  const TransformedMovingImageType * differenceImage
+    = this->m_DifferenceImageFilter->GetOutput();
+
+  /** The derivative of the measure with respect to the difference image.
+   * Each pair of pixels p, q contributes psi'( D(p) - D(q) ) to p, and its
+   * negation to q, with psi( d ) = sigma / ( sigma + d^2 ).
+   */
+  WeightImagePointer weights = WeightImageType::New();
+  weights->CopyInformation( differenceImage );
+  weights->SetRegions( differenceImage->GetLargestPossibleRegion() );
+  weights->Allocate();
+  weights->FillBuffer( 0.0 );
+
+  typename FixedImageType::SizeType iterationSize
+    = this->m_FixedImage->GetLargestPossibleRegion().GetSize();
+  typename FixedImageType::IndexType iterationStartIndex, currentIndex, neighborIndex;
+  typename FixedImageType::SizeType neighborIterationSize;
+  typename FixedImageType::PointType point;
+
+  neighborIterationSize.Fill( 1 ); iterationStartIndex.Fill( 0 );
+  for( unsigned int i = 0; i < 2; ++i ) // Only 2D
+  {
+    iterationSize[ i ]        -= static_cast< int >( 2 * this->m_NeighborhoodRadius );
+    iterationStartIndex[ i ]   = static_cast< int >( this->m_NeighborhoodRadius );
+    neighborIterationSize[ i ] = static_cast< int >( 2 * this->m_NeighborhoodRadius + 1 );
+  }
+
+  typename FixedImageType::RegionType iterationRegion, neighboriterationRegion;
+  iterationRegion.SetIndex( iterationStartIndex );
+  iterationRegion.SetSize( iterationSize );
+  neighboriterationRegion.SetSize( neighborIterationSize );
+
+  typedef itk::ImageRegionConstIteratorWithIndex< TransformedMovingImageType >
+    DifferenceImageIteratorType;
+  DifferenceImageIteratorType differenceImageIt( differenceImage, iterationRegion );
+
+  const double sigma = this->m_NoiseConstant;
+  while( !differenceImageIt.IsAtEnd() )
+  {
+    currentIndex = differenceImageIt.GetIndex();
+    this->m_FixedImage->TransformIndexToPhysicalPoint( currentIndex, point );
+
+    if( this->m_FixedImageMask.IsNull() || this->m_FixedImageMask->IsInside( point ) )
+    {
+      neighborIndex.Fill( 0 );
+      for( unsigned int i = 0; i < 2; ++i ) // 2D only
+      {
+        neighborIndex[ i ] = currentIndex[ i ] - this->m_NeighborhoodRadius;
+      }
+      neighboriterationRegion.SetIndex( neighborIndex );
+      DifferenceImageIteratorType neighborIt( differenceImage, neighboriterationRegion );
+
+      double centerWeight = 0.0;
+      while( !neighborIt.IsAtEnd() )
+      {
+        const double diff  = static_cast< double >( differenceImageIt.Value() ) - neighborIt.Value();
+        const double denom = sigma + diff * diff;
+        const double dpsi  = -2.0 * sigma * diff / ( denom * denom );
+        centerWeight += dpsi;
+        weights->SetPixel( neighborIt.GetIndex(),
+          weights->GetPixel( neighborIt.GetIndex() ) - dpsi );
+        ++neighborIt;
+      }
+      weights->SetPixel( currentIndex, weights->GetPixel( currentIndex ) + centerWeight );
+    }
+
+    ++differenceImageIt;
+  }
+
+  /** The value is -( PI - PIfixed ) / R, and D = F - s * DRR, so the weights
+   * of the pixels of the projection are s / R times the derivatives above.
+   */
+  const double factor = static_cast< double >( scalingfactor ) / this->m_Rescalingfactor;
+  ImageRegionIterator< WeightImageType > weightIterator(
+    weights, weights->GetLargestPossibleRegion() );
+  while( !weightIterator.IsAtEnd() )
+  {
+    weightIterator.Set( factor * weightIterator.Get() );
+    ++weightIterator;
+  }
+
+  /** Multiply the weights with the derivative of the projection. */
+  this->m_RayCastInterpolator->EvaluateWeightedDerivative(
+    weights, this->m_Threader, derivative );
+
+} // end ComputeAnalyticDerivative()
 
 
 /**
@@ -439,7 +583,14 @@ PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
   MeasureType & Value, DerivativeType & derivative ) const
 {
   Value = this->GetValue( parameters );
-  this->GetDerivative( parameters, derivative );
+  if( this->m_UseFiniteDifferenceDerivative )
+  {
+    this->ComputeFiniteDifferenceDerivative( parameters, derivative );
+  }
+  else
+  {
+    this->ComputeAnalyticDerivative( derivative );
+  }
 
 } // end GetValueAndDerivative()
 
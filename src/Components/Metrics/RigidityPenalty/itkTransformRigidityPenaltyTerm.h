@@ -57,6 +57,11 @@ namespace itk
  *
  * This metric only works with B-splines as a transformation model.
  *
+ * The penalty term and its derivative are only computed in the bounding
+ * region of the non-zero rigidity coefficients, which for a typical rigid
+ * structure is a small part of the B-spline grid. The computation in this
+ * region is multi-threaded, see SetUseMultiThread().
+ *
  * References:\n
  * [1] M. Staring, S. Klein and J.P.W. Pluim,
  *    "A Rigidity Penalty Term for Nonrigid Registration,"
@@ -122,6 +127,8 @@ public:
   typedef typename Superclass::ImageSampleContainerType     ImageSampleContainerType;
   typedef typename Superclass::ImageSampleContainerPointer  ImageSampleContainerPointer;
   typedef typename Superclass::ScalarType                   ScalarType;
+  typedef typename Superclass::ThreaderType                 ThreaderType;
+  typedef typename Superclass::ThreadInfoType               ThreadInfoType;
 
   /** Typedefs from the AdvancedTransform. */
   typedef typename Superclass::SpatialJacobianType SpatialJacobianType;
@@ -287,7 +294,11 @@ public:
   /** Set to use the MovingRigidityImage or not. */
   itkSetMacro( UseMovingRigidityImage, bool );
 
-  /** Function to fill the RigidityCoefficientImage every iteration. */
+  /** Function to fill the RigidityCoefficientImage every iteration.
+   * It also computes the sum of the rigidity coefficients and the bounding
+   * region of the non-zero coefficients, to which the computation of the
+   * penalty term is restricted.
+   */
   void FillRigidityCoefficientImage( const ParametersType & parameters ) const;
 
 protected:
@@ -318,9 +329,76 @@ private:
   void CreateNDOperator( NeighborhoodType & F, const std::string & whichF,
     const CoefficientImageSpacingType & spacing ) const;
 
-  /** Private function used for the filtering. It performs 1D separable filtering. */
+  /** Private function used for the filtering. It performs 1D separable filtering.
+   * The output is only computed in the given region.
+   */
   CoefficientImagePointer FilterSeparable( const CoefficientImageType *,
-    const std::vector< NeighborhoodType > & Operators ) const;
+    const std::vector< NeighborhoodType > & Operators,
+    const RigidityImageRegionType & region ) const;
+
+  /** The images and sums that are shared by the threads in
+   * GetValueAndDerivative(). The filtered B-spline coefficient images and
+   * the condition parts are needed in m_Region, the bounding region of the
+   * non-zero rigidity coefficients, and the filtered parts in m_DilatedRegion,
+   * which is m_Region dilated by the support of the ND operators. Each thread
+   * writes its part of the sums into the vectors, indexed by the thread id.
+   */
+  struct RigidityPenaltyTermThreaderParameterType
+  {
+    const Self *                                          m_Metric;
+    RigidityImageRegionType                               m_Region;
+    RigidityImageRegionType                               m_DilatedRegion;
+    CoefficientImageSpacingType                           m_Spacing;
+    ScalarType                                            m_RigidityCoefficientSum;
+    DerivativeValueType *                                 m_DerivativePointer;
+    std::vector< CoefficientImagePointer >                m_FA, m_FB, m_FC;
+    std::vector< CoefficientImagePointer >                m_FD, m_FE, m_FF;
+    std::vector< CoefficientImagePointer >                m_FG, m_FH, m_FI;
+    std::vector< std::vector< CoefficientImagePointer > > m_OCparts;
+    std::vector< std::vector< CoefficientImagePointer > > m_PCparts;
+    std::vector< std::vector< CoefficientImagePointer > > m_LCparts;
+    std::vector< CoefficientImagePointer >                m_OCpartsF;
+    std::vector< CoefficientImagePointer >                m_PCpartsF;
+    std::vector< CoefficientImagePointer >                m_LCpartsF;
+    std::vector< MeasureType >                            m_LinearityConditionValues;
+    std::vector< MeasureType >                            m_OrthonormalityConditionValues;
+    std::vector< MeasureType >                            m_PropernessConditionValues;
+    std::vector< MeasureType >                            m_LinearityConditionGradientMagnitudes;
+    std::vector< MeasureType >                            m_OrthonormalityConditionGradientMagnitudes;
+    std::vector< MeasureType >                            m_PropernessConditionGradientMagnitudes;
+  };
+
+  /** Get the part of the region that is processed by a thread. The region is
+   * divided in slabs along its last dimension. Returns false if the part is empty.
+   */
+  static bool GetThreadRegion( const RigidityImageRegionType & region,
+    const ThreadIdType threadId, const ThreadIdType numberOfThreads,
+    RigidityImageRegionType & threadRegion );
+
+  /** Compute the orthonormality, properness and linearity parts and the
+   * (unnormalized) condition values in a part of m_Region.
+   */
+  void ComputeConditionPartsOfRegion(
+    RigidityPenaltyTermThreaderParameterType & parameters,
+    const RigidityImageRegionType & region,
+    MeasureType & linearityValue,
+    MeasureType & orthonormalityValue,
+    MeasureType & propernessValue ) const;
+
+  /** Compute the filtered parts and the derivative in a part of m_DilatedRegion,
+   * and the contributions to the squared gradient magnitudes.
+   */
+  void ComputeDerivativeOfRegion(
+    RigidityPenaltyTermThreaderParameterType & parameters,
+    const RigidityImageRegionType & region,
+    MeasureType & gradMagLC,
+    MeasureType & gradMagOC,
+    MeasureType & gradMagPC ) const;
+
+  /** Threader callbacks that call the functions above for the slab of a thread. */
+  static ITK_THREAD_RETURN_TYPE ComputeConditionPartsThreaderCallback( void * arg );
+
+  static ITK_THREAD_RETURN_TYPE ComputeDerivativeThreaderCallback( void * arg );
 
   /** Member variables. */
   BSplineTransformPointer m_BSplineTransform;
@@ -350,6 +428,8 @@ private:
   RigidityImagePointer               m_FixedRigidityImage;
   RigidityImagePointer               m_MovingRigidityImage;
   RigidityImagePointer               m_RigidityCoefficientImage;
+  mutable ScalarType                 m_RigidityCoefficientSum;
+  mutable RigidityImageRegionType    m_RigidityCoefficientRegion;
   std::vector< DilateFilterPointer > m_FixedRigidityImageDilation;
   std::vector< DilateFilterPointer > m_MovingRigidityImageDilation;
   RigidityImagePointer               m_FixedRigidityImageDilated;
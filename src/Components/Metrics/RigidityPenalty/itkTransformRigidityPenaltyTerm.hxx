@@ -22,6 +22,9 @@
 
 #include "itkZeroFluxNeumannBoundaryCondition.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace itk
 {
 
@@ -68,6 +71,7 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   this->m_MovingRigidityImage              = 0;
   this->m_RigidityCoefficientImage         = RigidityImageType::New();
   this->m_RigidityCoefficientImageIsFilled = false;
+  this->m_RigidityCoefficientSum           = NumericTraits< ScalarType >::Zero;
 
   /** Initialize dilation filter for the rigidity images. */
   this->m_FixedRigidityImageDilation.resize( FixedImageDimension );
@@ -158,6 +162,8 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   {
     /** Fill the rigidity coefficient image with ones. */
     this->m_RigidityCoefficientImage->FillBuffer( 1.0 );
+    this->m_RigidityCoefficientSum    = static_cast< ScalarType >( region.GetNumberOfPixels() );
+    this->m_RigidityCoefficientRegion = region;
   }
   else
   {
@@ -364,6 +370,12 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   in          = NumericTraits< RigidityPixelType >::Zero;
   bool isInFixedImage  = false;
   bool isInMovingImage = false;
+
+  /** Keep track of the sum and the bounding box of the non-zero coefficients. */
+  ScalarType             rigidityCoefficientSum = NumericTraits< ScalarType >::Zero;
+  RigidityImageIndexType minIndex, maxIndex;
+  bool                   foundNonZero = false;
+  minIndex.Fill( 0 ); maxIndex.Fill( 0 );
   while( !it.IsAtEnd() )
   {
     /** Get current pixel in world coordinates. */
@@ -456,10 +468,44 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
     /** Set it. */
     it.Set( in );
 
+    /** Update the sum and the bounding box. */
+    if( in != NumericTraits< RigidityPixelType >::Zero )
+    {
+      const RigidityImageIndexType & index = it.GetIndex();
+      rigidityCoefficientSum += in;
+      if( !foundNonZero )
+      {
+        minIndex     = index;
+        maxIndex     = index;
+        foundNonZero = true;
+      }
+      for( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+        minIndex[ i ] = std::min( minIndex[ i ], index[ i ] );
+        maxIndex[ i ] = std::max( maxIndex[ i ], index[ i ] );
+      }
+    }
+
     /** Increase iterator. */
     ++it;
   } // end while loop over rigidity coefficient image
 
+  /** Store the sum and the bounding region of the non-zero coefficients.
+   * If all coefficients are zero the region is empty.
+   */
+  this->m_RigidityCoefficientSum = rigidityCoefficientSum;
+  RigidityImageRegionType region;
+  region.SetIndex( this->m_RigidityCoefficientImage->GetLargestPossibleRegion().GetIndex() );
+  if( foundNonZero )
+  {
+    region.SetIndex( minIndex );
+    for( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+      region.SetSize( i, maxIndex[ i ] - minIndex[ i ] + 1 );
+    }
+  }
+  this->m_RigidityCoefficientRegion = region;
+
   /** Remember that the rigidity coefficient image is filled. */
   this->m_RigidityCoefficientImageIsFilled = true;
 
@@ -506,22 +552,16 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   CoefficientImageSpacingType spacing = inputImages[ 0 ]->GetSpacing();
 
   /** TASK 0:
-   * Compute the rigidityCoefficientSum and check on it.
+   * Get the rigidityCoefficientSum and check on it.
    *
    ************************************************************************* */
 
-  /** Create iterator over the rigidity coeficient image. */
-  CoefficientImageIteratorType it_RCI( this->m_RigidityCoefficientImage,
-  this->m_RigidityCoefficientImage->GetLargestPossibleRegion() );
-  it_RCI.GoToBegin();
-  ScalarType rigidityCoefficientSum = NumericTraits< ScalarType >::Zero;
-
-  /** Add the rigidity coefficients together. */
-  while( !it_RCI.IsAtEnd() )
-  {
-    rigidityCoefficientSum += it_RCI.Get();
-    ++it_RCI;
-  }
+  /** The sum of the rigidity coefficients and the bounding region of the
+   * non-zero coefficients are computed when the rigidity coefficient image
+   * is filled. Outside this region the penalty term is zero.
+   */
+  const ScalarType              rigidityCoefficientSum = this->m_RigidityCoefficientSum;
+  const RigidityImageRegionType region                 = this->m_RigidityCoefficientRegion;
 
   /** Check for early termination. */
   if( rigidityCoefficientSum < 1e-14 )
@@ -530,6 +570,10 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
     return this->m_RigidityPenaltyTermValue;
   }
 
+  /** Create iterator over the rigidity coeficient image. */
+  CoefficientImageIteratorType it_RCI( this->m_RigidityCoefficientImage, region );
+  it_RCI.GoToBegin();
+
   /** TASK 1:
    * Prepare for the calculation of the rigidity penalty term.
    *
@@ -584,24 +628,24 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   } // end for loop
 
   /** TASK 2:
-   * Filter the B-spline coefficient images.
+   * Filter the B-spline coefficient images, only in the bounding region.
    *
    ************************************************************************* */
 
   /** Filter the inputImages. */
   for( unsigned int i = 0; i < ImageDimension; i++ )
   {
-    ui_FA[ i ] = this->FilterSeparable( inputImages[ i ], Operators_A );
-    ui_FB[ i ] = this->FilterSeparable( inputImages[ i ], Operators_B );
-    ui_FD[ i ] = this->FilterSeparable( inputImages[ i ], Operators_D );
-    ui_FE[ i ] = this->FilterSeparable( inputImages[ i ], Operators_E );
-    ui_FG[ i ] = this->FilterSeparable( inputImages[ i ], Operators_G );
+    ui_FA[ i ] = this->FilterSeparable( inputImages[ i ], Operators_A, region );
+    ui_FB[ i ] = this->FilterSeparable( inputImages[ i ], Operators_B, region );
+    ui_FD[ i ] = this->FilterSeparable( inputImages[ i ], Operators_D, region );
+    ui_FE[ i ] = this->FilterSeparable( inputImages[ i ], Operators_E, region );
+    ui_FG[ i ] = this->FilterSeparable( inputImages[ i ], Operators_G, region );
     if( ImageDimension == 3 )
     {
-      ui_FC[ i ] = this->FilterSeparable( inputImages[ i ], Operators_C );
-      ui_FF[ i ] = this->FilterSeparable( inputImages[ i ], Operators_F );
-      ui_FH[ i ] = this->FilterSeparable( inputImages[ i ], Operators_H );
-      ui_FI[ i ] = this->FilterSeparable( inputImages[ i ], Operators_I );
+      ui_FC[ i ] = this->FilterSeparable( inputImages[ i ], Operators_C, region );
+      ui_FF[ i ] = this->FilterSeparable( inputImages[ i ], Operators_F, region );
+      ui_FH[ i ] = this->FilterSeparable( inputImages[ i ], Operators_H, region );
+      ui_FI[ i ] = this->FilterSeparable( inputImages[ i ], Operators_I, region );
     }
   }
 
@@ -621,17 +665,17 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   for( unsigned int i = 0; i < ImageDimension; i++ )
   {
     /** Create iterators. */
-    itA[ i ] = CoefficientImageIteratorType( ui_FA[ i ], ui_FA[ i ]->GetLargestPossibleRegion() );
-    itB[ i ] = CoefficientImageIteratorType( ui_FB[ i ], ui_FB[ i ]->GetLargestPossibleRegion() );
-    itD[ i ] = CoefficientImageIteratorType( ui_FD[ i ], ui_FD[ i ]->GetLargestPossibleRegion() );
-    itE[ i ] = CoefficientImageIteratorType( ui_FE[ i ], ui_FE[ i ]->GetLargestPossibleRegion() );
-    itG[ i ] = CoefficientImageIteratorType( ui_FG[ i ], ui_FG[ i ]->GetLargestPossibleRegion() );
+    itA[ i ] = CoefficientImageIteratorType( ui_FA[ i ], region );
+    itB[ i ] = CoefficientImageIteratorType( ui_FB[ i ], region );
+    itD[ i ] = CoefficientImageIteratorType( ui_FD[ i ], region );
+    itE[ i ] = CoefficientImageIteratorType( ui_FE[ i ], region );
+    itG[ i ] = CoefficientImageIteratorType( ui_FG[ i ], region );
     if( ImageDimension == 3 )
     {
-      itC[ i ] = CoefficientImageIteratorType( ui_FC[ i ], ui_FC[ i ]->GetLargestPossibleRegion() );
-      itF[ i ] = CoefficientImageIteratorType( ui_FF[ i ], ui_FF[ i ]->GetLargestPossibleRegion() );
-      itH[ i ] = CoefficientImageIteratorType( ui_FH[ i ], ui_FH[ i ]->GetLargestPossibleRegion() );
-      itI[ i ] = CoefficientImageIteratorType( ui_FI[ i ], ui_FI[ i ]->GetLargestPossibleRegion() );
+      itC[ i ] = CoefficientImageIteratorType( ui_FC[ i ], region );
+      itF[ i ] = CoefficientImageIteratorType( ui_FF[ i ], region );
+      itH[ i ] = CoefficientImageIteratorType( ui_FH[ i ], region );
+      itI[ i ] = CoefficientImageIteratorType( ui_FI[ i ], region );
     }
     /** Reset iterators. */
     itA[ i ].GoToBegin(); itB[ i ].GoToBegin();
@@ -990,22 +1034,15 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   CoefficientImageSpacingType spacing = inputImages[ 0 ]->GetSpacing();
 
   /** TASK 0:
-   * Compute the rigidityCoefficientSum and check on it.
+   * Get the rigidityCoefficientSum and check on it.
    *
    ************************************************************************* */
 
-  /** Create iterator over the rigidity coeficient image. */
-  CoefficientImageIteratorType it_RCI( this->m_RigidityCoefficientImage,
-  this->m_RigidityCoefficientImage->GetLargestPossibleRegion() );
-  it_RCI.GoToBegin();
-  ScalarType rigidityCoefficientSum = NumericTraits< ScalarType >::Zero;
-
-  /** Add the rigidity coefficients together. */
-  while( !it_RCI.IsAtEnd() )
-  {
-    rigidityCoefficientSum += it_RCI.Get();
-    ++it_RCI;
-  }
+  /** The sum of the rigidity coefficients and the bounding region of the
+   * non-zero coefficients are computed when the rigidity coefficient image
+   * is filled. Outside this region the penalty term and its derivative are zero.
+   */
+  const ScalarType rigidityCoefficientSum = this->m_RigidityCoefficientSum;
 
   /** Check for early termination. */
   if( rigidityCoefficientSum < 1e-14 )
@@ -1014,6 +1051,19 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
     return;
   }
 
+  /** The filtered parts are needed in the bounding region,
+   * dilated by the radius of the ND operators.
+   */
+  RigidityPenaltyTermThreaderParameterType parameters;
+  parameters.m_Metric                 = this;
+  parameters.m_Region                 = this->m_RigidityCoefficientRegion;
+  parameters.m_DilatedRegion          = this->m_RigidityCoefficientRegion;
+  parameters.m_DilatedRegion.PadByRadius( 1 );
+  parameters.m_DilatedRegion.Crop( inputImages[ 0 ]->GetLargestPossibleRegion() );
+  parameters.m_Spacing                = spacing;
+  parameters.m_RigidityCoefficientSum = rigidityCoefficientSum;
+  parameters.m_DerivativePointer      = derivative.data_block();
+
   /** TASK 1:
    * Prepare for the calculation of the rigidity penalty term.
    *
@@ -1026,33 +1076,19 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   Operators_F( ImageDimension ), Operators_G( ImageDimension ),
   Operators_H( ImageDimension ), Operators_I( ImageDimension );
 
-  /** Create B-spline coefficient images that are filtered once. */
-  std::vector< CoefficientImagePointer > ui_FA( ImageDimension ),
-  ui_FB( ImageDimension ), ui_FC( ImageDimension ),
-  ui_FD( ImageDimension ), ui_FE( ImageDimension ),
-  ui_FF( ImageDimension ), ui_FG( ImageDimension ),
-  ui_FH( ImageDimension ), ui_FI( ImageDimension );
+  /** The B-spline coefficient images that are filtered once. */
+  parameters.m_FA.resize( ImageDimension ); parameters.m_FB.resize( ImageDimension );
+  parameters.m_FC.resize( ImageDimension ); parameters.m_FD.resize( ImageDimension );
+  parameters.m_FE.resize( ImageDimension ); parameters.m_FF.resize( ImageDimension );
+  parameters.m_FG.resize( ImageDimension ); parameters.m_FH.resize( ImageDimension );
+  parameters.m_FI.resize( ImageDimension );
 
-  /** For all dimensions ... */
+  /** For all dimensions create the apropiate operators.
+   * The operators C, D and E from the paper are here created
+   * by Create1DOperator D, E and G, because of the 3D case and history.
+   */
   for( unsigned int i = 0; i < ImageDimension; i++ )
   {
-    /** ... create the filtered images ... */
-    ui_FA[ i ] = CoefficientImageType::New();
-    ui_FB[ i ] = CoefficientImageType::New();
-    ui_FD[ i ] = CoefficientImageType::New();
-    ui_FE[ i ] = CoefficientImageType::New();
-    ui_FG[ i ] = CoefficientImageType::New();
-    if( ImageDimension == 3 )
-    {
-      ui_FC[ i ] = CoefficientImageType::New();
-      ui_FF[ i ] = CoefficientImageType::New();
-      ui_FH[ i ] = CoefficientImageType::New();
-      ui_FI[ i ] = CoefficientImageType::New();
-    }
-    /** ... and the apropiate operators.
-     * The operators C, D and E from the paper are here created
-     * by Create1DOperator D, E and G, because of the 3D case and history.
-     */
     this->Create1DOperator( Operators_A[ i ], "FA_xi", i + 1, spacing );
     this->Create1DOperator( Operators_B[ i ], "FB_xi", i + 1, spacing );
     this->Create1DOperator( Operators_D[ i ], "FD_xi", i + 1, spacing );
@@ -1068,32 +1104,223 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   } // end for loop
 
   /** TASK 2:
-   * Filter the B-spline coefficient images.
+   * Filter the B-spline coefficient images, only in the bounding region.
    *
    ************************************************************************* */
 
   /** Filter the inputImages. */
+  const RigidityImageRegionType & region = parameters.m_Region;
   for( unsigned int i = 0; i < ImageDimension; i++ )
   {
-    ui_FA[ i ] = this->FilterSeparable( inputImages[ i ], Operators_A );
-    ui_FB[ i ] = this->FilterSeparable( inputImages[ i ], Operators_B );
-    ui_FD[ i ] = this->FilterSeparable( inputImages[ i ], Operators_D );
-    ui_FE[ i ] = this->FilterSeparable( inputImages[ i ], Operators_E );
-    ui_FG[ i ] = this->FilterSeparable( inputImages[ i ], Operators_G );
+    parameters.m_FA[ i ] = this->FilterSeparable( inputImages[ i ], Operators_A, region );
+    parameters.m_FB[ i ] = this->FilterSeparable( inputImages[ i ], Operators_B, region );
+    parameters.m_FD[ i ] = this->FilterSeparable( inputImages[ i ], Operators_D, region );
+    parameters.m_FE[ i ] = this->FilterSeparable( inputImages[ i ], Operators_E, region );
+    parameters.m_FG[ i ] = this->FilterSeparable( inputImages[ i ], Operators_G, region );
     if( ImageDimension == 3 )
     {
-      ui_FC[ i ] = this->FilterSeparable( inputImages[ i ], Operators_C );
-      ui_FF[ i ] = this->FilterSeparable( inputImages[ i ], Operators_F );
-      ui_FH[ i ] = this->FilterSeparable( inputImages[ i ], Operators_H );
-      ui_FI[ i ] = this->FilterSeparable( inputImages[ i ], Operators_I );
+      parameters.m_FC[ i ] = this->FilterSeparable( inputImages[ i ], Operators_C, region );
+      parameters.m_FF[ i ] = this->FilterSeparable( inputImages[ i ], Operators_F, region );
+      parameters.m_FH[ i ] = this->FilterSeparable( inputImages[ i ], Operators_H, region );
+      parameters.m_FI[ i ] = this->FilterSeparable( inputImages[ i ], Operators_I, region );
     }
   }
 
   /** TASK 3:
-   * Create subparts and iterators.
+   * Create subparts.
+   *
+   ************************************************************************* */
+
+  /** Create orthonormality, properness and linearity parts. They are read in
+   * the dilated region, but only computed in the bounding region, so they are
+   * initialized with zeros.
+   */
+  const unsigned int NofLParts = 3 * ImageDimension - 3;
+  parameters.m_OCparts.resize( ImageDimension );
+  parameters.m_PCparts.resize( ImageDimension );
+  parameters.m_LCparts.resize( ImageDimension );
+  for( unsigned int i = 0; i < ImageDimension; i++ )
+  {
+    parameters.m_OCparts[ i ].resize( ImageDimension );
+    parameters.m_PCparts[ i ].resize( ImageDimension );
+    parameters.m_LCparts[ i ].resize( NofLParts );
+    for( unsigned int j = 0; j < ImageDimension; j++ )
+    {
+      parameters.m_OCparts[ i ][ j ] = CoefficientImageType::New();
+      parameters.m_OCparts[ i ][ j ]->SetRegions( parameters.m_DilatedRegion );
+      parameters.m_OCparts[ i ][ j ]->Allocate();
+      parameters.m_OCparts[ i ][ j ]->FillBuffer( NumericTraits< ScalarType >::Zero );
+      parameters.m_PCparts[ i ][ j ] = CoefficientImageType::New();
+      parameters.m_PCparts[ i ][ j ]->SetRegions( parameters.m_DilatedRegion );
+      parameters.m_PCparts[ i ][ j ]->Allocate();
+      parameters.m_PCparts[ i ][ j ]->FillBuffer( NumericTraits< ScalarType >::Zero );
+    }
+    for( unsigned int j = 0; j < NofLParts; j++ )
+    {
+      parameters.m_LCparts[ i ][ j ] = CoefficientImageType::New();
+      parameters.m_LCparts[ i ][ j ]->SetRegions( parameters.m_DilatedRegion );
+      parameters.m_LCparts[ i ][ j ]->Allocate();
+      parameters.m_LCparts[ i ][ j ]->FillBuffer( NumericTraits< ScalarType >::Zero );
+    }
+  }
+
+  /** TASK 4:
+   * Do the calculation of the orthonormality, properness and linearity
+   * subparts and values. Each thread processes a slab of the bounding region.
    *
    ************************************************************************* */
 
+  if( this->m_UseMultiThread )
+  {
+    const ThreadIdType numberOfThreads = this->m_Threader->GetNumberOfThreads();
+    parameters.m_LinearityConditionValues.assign( numberOfThreads, NumericTraits< MeasureType >::Zero );
+    parameters.m_OrthonormalityConditionValues.assign( numberOfThreads, NumericTraits< MeasureType >::Zero );
+    parameters.m_PropernessConditionValues.assign( numberOfThreads, NumericTraits< MeasureType >::Zero );
+
+    PersistentThreadPool::Launch( this->m_Threader,
+      this->ComputeConditionPartsThreaderCallback, &parameters );
+
+    /** Accumulate the values of the threads, in a fixed order. */
+    for( ThreadIdType i = 0; i < numberOfThreads; ++i )
+    {
+      this->m_LinearityConditionValue      += parameters.m_LinearityConditionValues[ i ];
+      this->m_OrthonormalityConditionValue += parameters.m_OrthonormalityConditionValues[ i ];
+      this->m_PropernessConditionValue     += parameters.m_PropernessConditionValues[ i ];
+    }
+  }
+  else
+  {
+    this->ComputeConditionPartsOfRegion( parameters, region,
+      this->m_LinearityConditionValue,
+      this->m_OrthonormalityConditionValue,
+      this->m_PropernessConditionValue );
+  }
+
+  /** TASK 5:
+   * Do the actual calculation of the rigidity penalty term value.
+   *
+   ************************************************************************* */
+
+  /** Calculate the rigidity penalty term value. */
+  if( this->m_CalculateLinearityCondition )
+  {
+    this->m_LinearityConditionValue /= rigidityCoefficientSum;
+  }
+  if( this->m_CalculateOrthonormalityCondition )
+  {
+    this->m_OrthonormalityConditionValue /= rigidityCoefficientSum;
+  }
+  if( this->m_CalculatePropernessCondition )
+  {
+    this->m_PropernessConditionValue /= rigidityCoefficientSum;
+  }
+
+  if( this->m_UseLinearityCondition )
+  {
+    this->m_RigidityPenaltyTermValue
+      += this->m_LinearityConditionWeight * this->m_LinearityConditionValue;
+  }
+  if( this->m_UseOrthonormalityCondition )
+  {
+    this->m_RigidityPenaltyTermValue
+      += this->m_OrthonormalityConditionWeight * this->m_OrthonormalityConditionValue;
+  }
+  if( this->m_UsePropernessCondition )
+  {
+    this->m_RigidityPenaltyTermValue
+      += this->m_PropernessConditionWeight * this->m_PropernessConditionValue;
+  }
+  value = this->m_RigidityPenaltyTermValue;
+
+  /** TASK 6:
+   * Create filtered versions of the subparts.
+   *
+   ************************************************************************* */
+
+  /** Create filtered orthonormality, properness and linearity parts.
+   * The parts that are not calculated are zero.
+   */
+  parameters.m_OCpartsF.resize( ImageDimension );
+  parameters.m_PCpartsF.resize( ImageDimension );
+  parameters.m_LCpartsF.resize( ImageDimension );
+  for( unsigned int i = 0; i < ImageDimension; i++ )
+  {
+    parameters.m_OCpartsF[ i ] = CoefficientImageType::New();
+    parameters.m_OCpartsF[ i ]->SetRegions( parameters.m_DilatedRegion );
+    parameters.m_OCpartsF[ i ]->Allocate();
+    parameters.m_OCpartsF[ i ]->FillBuffer( NumericTraits< ScalarType >::Zero );
+    parameters.m_PCpartsF[ i ] = CoefficientImageType::New();
+    parameters.m_PCpartsF[ i ]->SetRegions( parameters.m_DilatedRegion );
+    parameters.m_PCpartsF[ i ]->Allocate();
+    parameters.m_PCpartsF[ i ]->FillBuffer( NumericTraits< ScalarType >::Zero );
+    parameters.m_LCpartsF[ i ] = CoefficientImageType::New();
+    parameters.m_LCpartsF[ i ]->SetRegions( parameters.m_DilatedRegion );
+    parameters.m_LCpartsF[ i ]->Allocate();
+    parameters.m_LCpartsF[ i ]->FillBuffer( NumericTraits< ScalarType >::Zero );
+  }
+
+  /** TASK 7:
+   * Calculate the filtered versions of the subparts, and add them to create
+   * the final derivative. Each thread processes a slab of the dilated region.
+   * Outside this region the derivative is zero.
+   ************************************************************************* */
+
+  MeasureType gradMagLC = NumericTraits< MeasureType >::Zero;
+  MeasureType gradMagOC = NumericTraits< MeasureType >::Zero;
+  MeasureType gradMagPC = NumericTraits< MeasureType >::Zero;
+  if( this->m_UseMultiThread )
+  {
+    const ThreadIdType numberOfThreads = this->m_Threader->GetNumberOfThreads();
+    parameters.m_LinearityConditionGradientMagnitudes.assign(
+      numberOfThreads, NumericTraits< MeasureType >::Zero );
+    parameters.m_OrthonormalityConditionGradientMagnitudes.assign(
+      numberOfThreads, NumericTraits< MeasureType >::Zero );
+    parameters.m_PropernessConditionGradientMagnitudes.assign(
+      numberOfThreads, NumericTraits< MeasureType >::Zero );
+
+    PersistentThreadPool::Launch( this->m_Threader,
+      this->ComputeDerivativeThreaderCallback, &parameters );
+
+    /** Accumulate the sums of the threads, in a fixed order. */
+    for( ThreadIdType i = 0; i < numberOfThreads; ++i )
+    {
+      gradMagLC += parameters.m_LinearityConditionGradientMagnitudes[ i ];
+      gradMagOC += parameters.m_OrthonormalityConditionGradientMagnitudes[ i ];
+      gradMagPC += parameters.m_PropernessConditionGradientMagnitudes[ i ];
+    }
+  }
+  else
+  {
+    this->ComputeDerivativeOfRegion( parameters, parameters.m_DilatedRegion,
+      gradMagLC, gradMagOC, gradMagPC );
+  }
+
+  /** Set the gradient magnitudes of the several terms. */
+  this->m_LinearityConditionGradientMagnitude      = vcl_sqrt( gradMagLC );
+  this->m_OrthonormalityConditionGradientMagnitude = vcl_sqrt( gradMagOC );
+  this->m_PropernessConditionGradientMagnitude     = vcl_sqrt( gradMagPC );
+
+} // end GetValueAndDerivative()
+
+
+/**
+ * *********************** ComputeConditionPartsOfRegion ****************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::ComputeConditionPartsOfRegion(
+  RigidityPenaltyTermThreaderParameterType & parameters,
+  const RigidityImageRegionType & region,
+  MeasureType & linearityValue,
+  MeasureType & orthonormalityValue,
+  MeasureType & propernessValue ) const
+{
+  /** Create an iterator over the rigidity coefficient image. */
+  CoefficientImageIteratorType it_RCI( this->m_RigidityCoefficientImage, region );
+  it_RCI.GoToBegin();
+
   /** Create iterators over ui_F?. */
   std::vector< CoefficientImageIteratorType > itA( ImageDimension ),
   itB( ImageDimension ), itC( ImageDimension ),
@@ -1105,17 +1332,17 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   for( unsigned int i = 0; i < ImageDimension; i++ )
   {
     /** Create iterators. */
-    itA[ i ] = CoefficientImageIteratorType( ui_FA[ i ], ui_FA[ i ]->GetLargestPossibleRegion() );
-    itB[ i ] = CoefficientImageIteratorType( ui_FB[ i ], ui_FB[ i ]->GetLargestPossibleRegion() );
-    itD[ i ] = CoefficientImageIteratorType( ui_FD[ i ], ui_FD[ i ]->GetLargestPossibleRegion() );
-    itE[ i ] = CoefficientImageIteratorType( ui_FE[ i ], ui_FE[ i ]->GetLargestPossibleRegion() );
-    itG[ i ] = CoefficientImageIteratorType( ui_FG[ i ], ui_FG[ i ]->GetLargestPossibleRegion() );
+    itA[ i ] = CoefficientImageIteratorType( parameters.m_FA[ i ], region );
+    itB[ i ] = CoefficientImageIteratorType( parameters.m_FB[ i ], region );
+    itD[ i ] = CoefficientImageIteratorType( parameters.m_FD[ i ], region );
+    itE[ i ] = CoefficientImageIteratorType( parameters.m_FE[ i ], region );
+    itG[ i ] = CoefficientImageIteratorType( parameters.m_FG[ i ], region );
     if( ImageDimension == 3 )
     {
-      itC[ i ] = CoefficientImageIteratorType( ui_FC[ i ], ui_FC[ i ]->GetLargestPossibleRegion() );
-      itF[ i ] = CoefficientImageIteratorType( ui_FF[ i ], ui_FF[ i ]->GetLargestPossibleRegion() );
-      itH[ i ] = CoefficientImageIteratorType( ui_FH[ i ], ui_FH[ i ]->GetLargestPossibleRegion() );
-      itI[ i ] = CoefficientImageIteratorType( ui_FI[ i ], ui_FI[ i ]->GetLargestPossibleRegion() );
+      itC[ i ] = CoefficientImageIteratorType( parameters.m_FC[ i ], region );
+      itF[ i ] = CoefficientImageIteratorType( parameters.m_FF[ i ], region );
+      itH[ i ] = CoefficientImageIteratorType( parameters.m_FH[ i ], region );
+      itI[ i ] = CoefficientImageIteratorType( parameters.m_FI[ i ], region );
     }
     /** Reset iterators. */
     itA[ i ].GoToBegin(); itB[ i ].GoToBegin();
@@ -1127,37 +1354,7 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
     }
   }
 
-  /** Create orthonormality and properness parts. */
-  std::vector< std::vector< CoefficientImagePointer > > OCparts( ImageDimension );
-  std::vector< std::vector< CoefficientImagePointer > > PCparts( ImageDimension );
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    OCparts[ i ].resize( ImageDimension );
-    PCparts[ i ].resize( ImageDimension );
-    for( unsigned int j = 0; j < ImageDimension; j++ )
-    {
-      OCparts[ i ][ j ] = CoefficientImageType::New();
-      OCparts[ i ][ j ]->SetRegions( inputImages[ 0 ]->GetLargestPossibleRegion() );
-      OCparts[ i ][ j ]->Allocate();
-      PCparts[ i ][ j ] = CoefficientImageType::New();
-      PCparts[ i ][ j ]->SetRegions( inputImages[ 0 ]->GetLargestPossibleRegion() );
-      PCparts[ i ][ j ]->Allocate();
-    }
-  }
-
-  /** Create linearity parts. */
-  unsigned int                                          NofLParts = 3 * ImageDimension - 3;
-  std::vector< std::vector< CoefficientImagePointer > > LCparts( ImageDimension );
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    LCparts[ i ].resize( NofLParts );
-    for( unsigned int j = 0; j < NofLParts; j++ )
-    {
-      LCparts[ i ][ j ] = CoefficientImageType::New();
-      LCparts[ i ][ j ]->SetRegions( inputImages[ 0 ]->GetLargestPossibleRegion() );
-      LCparts[ i ][ j ]->Allocate();
-    }
-  }
+  const unsigned int NofLParts = 3 * ImageDimension - 3;
 
   /** Create iterators over all parts. */
   std::vector< std::vector< CoefficientImageIteratorType > > itOCp( ImageDimension );
@@ -1170,17 +1367,14 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
     itLCp[ i ].resize( NofLParts );
     for( unsigned int j = 0; j < ImageDimension; j++ )
     {
-      itOCp[ i ][ j ] = CoefficientImageIteratorType( OCparts[ i ][ j ],
-        OCparts[ i ][ j ]->GetLargestPossibleRegion() );
+      itOCp[ i ][ j ] = CoefficientImageIteratorType( parameters.m_OCparts[ i ][ j ], region );
       itOCp[ i ][ j ].GoToBegin();
-      itPCp[ i ][ j ] = CoefficientImageIteratorType( PCparts[ i ][ j ],
-        PCparts[ i ][ j ]->GetLargestPossibleRegion() );
+      itPCp[ i ][ j ] = CoefficientImageIteratorType( parameters.m_PCparts[ i ][ j ], region );
       itPCp[ i ][ j ].GoToBegin();
     }
     for( unsigned int j = 0; j < NofLParts; j++ )
     {
-      itLCp[ i ][ j ] = CoefficientImageIteratorType( LCparts[ i ][ j ],
-        LCparts[ i ][ j ]->GetLargestPossibleRegion() );
+      itLCp[ i ][ j ] = CoefficientImageIteratorType( parameters.m_LCparts[ i ][ j ], region );
       itLCp[ i ][ j ].GoToBegin();
     }
   }
@@ -1212,7 +1406,7 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
       if( ImageDimension == 2 )
       {
         /** Calculate the value of the orthonormality condition. */
-        this->m_OrthonormalityConditionValue
+        orthonormalityValue
           += it_RCI.Get() * (
           vcl_pow(
           +( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
@@ -1266,7 +1460,7 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
       else if( ImageDimension == 3 )
       {
         /** Calculate the value of the orthonormality condition. */
-        this->m_OrthonormalityConditionValue
+        orthonormalityValue
           += it_RCI.Get() * (
           vcl_pow(
           +( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
@@ -1468,7 +1662,7 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
       if( ImageDimension == 2 )
       {
         /** Calculate the value of the properness condition. */
-        this->m_PropernessConditionValue
+        propernessValue
           += it_RCI.Get() * (
           vcl_pow(
           +( 1.0 + mu1_A ) * ( 1.0 + mu2_B )
@@ -1505,7 +1699,7 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
       else if( ImageDimension == 3 )
       {
         /** Calculate the value of the properness condition. */
-        this->m_PropernessConditionValue
+        propernessValue
           += it_RCI.Get() * (
           vcl_pow(
           -mu1_C * ( 1.0 + mu2_B ) * mu3_A
@@ -1695,7 +1889,7 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
       for( unsigned int i = 0; i < ImageDimension; i++ )
       {
         /** Calculate the value of the linearity condition. */
-        this->m_LinearityConditionValue
+        linearityValue
           += it_RCI.Get() * (
           +itD[ i ].Get() * itD[ i ].Get()
           + itE[ i ].Get() * itE[ i ].Get()
@@ -1703,7 +1897,7 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
           );
         if( ImageDimension == 3 )
         {
-          this->m_LinearityConditionValue
+          linearityValue
             += it_RCI.Get() * (
             +itF[ i ].Get() * itF[ i ].Get()
             + itH[ i ].Get() * itH[ i ].Get()
@@ -1762,63 +1956,25 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
     } // end while
   }   // end if do linearity
 
-  /** TASK 5:
-   * Do the actual calculation of the rigidity penalty term value.
-   *
-   ************************************************************************* */
-
-  /** Calculate the rigidity penalty term value. */
-  if( this->m_CalculateLinearityCondition )
-  {
-    this->m_LinearityConditionValue /= rigidityCoefficientSum;
-  }
-  if( this->m_CalculateOrthonormalityCondition )
-  {
-    this->m_OrthonormalityConditionValue /= rigidityCoefficientSum;
-  }
-  if( this->m_CalculatePropernessCondition )
-  {
-    this->m_PropernessConditionValue /= rigidityCoefficientSum;
-  }
+} // end ComputeConditionPartsOfRegion()
 
-  if( this->m_UseLinearityCondition )
-  {
-    this->m_RigidityPenaltyTermValue
-      += this->m_LinearityConditionWeight * this->m_LinearityConditionValue;
-  }
-  if( this->m_UseOrthonormalityCondition )
-  {
-    this->m_RigidityPenaltyTermValue
-      += this->m_OrthonormalityConditionWeight * this->m_OrthonormalityConditionValue;
-  }
-  if( this->m_UsePropernessCondition )
-  {
-    this->m_RigidityPenaltyTermValue
-      += this->m_PropernessConditionWeight * this->m_PropernessConditionValue;
-  }
-  value = this->m_RigidityPenaltyTermValue;
 
-  /** TASK 6:
-   * Create filtered versions of the subparts.
-   * Create all necessary iterators and operators.
-   ************************************************************************* */
+/**
+ * *********************** ComputeDerivativeOfRegion ****************
+ */
 
-  /** Create filtered orthonormality, properness and linearity parts. */
-  std::vector< CoefficientImagePointer > OCpartsF( ImageDimension );
-  std::vector< CoefficientImagePointer > PCpartsF( ImageDimension );
-  std::vector< CoefficientImagePointer > LCpartsF( ImageDimension );
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    OCpartsF[ i ] = CoefficientImageType::New();
-    OCpartsF[ i ]->SetRegions( inputImages[ 0 ]->GetLargestPossibleRegion() );
-    OCpartsF[ i ]->Allocate();
-    PCpartsF[ i ] = CoefficientImageType::New();
-    PCpartsF[ i ]->SetRegions( inputImages[ 0 ]->GetLargestPossibleRegion() );
-    PCpartsF[ i ]->Allocate();
-    LCpartsF[ i ] = CoefficientImageType::New();
-    LCpartsF[ i ]->SetRegions( inputImages[ 0 ]->GetLargestPossibleRegion() );
-    LCpartsF[ i ]->Allocate();
-  }
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::ComputeDerivativeOfRegion(
+  RigidityPenaltyTermThreaderParameterType & parameters,
+  const RigidityImageRegionType & region,
+  MeasureType & gradMagLC,
+  MeasureType & gradMagOC,
+  MeasureType & gradMagPC ) const
+{
+  const unsigned int    NofLParts = 3 * ImageDimension - 3;
+  std::vector< double > tmp( ImageDimension );
 
   /** Create neighborhood iterators over the subparts. */
   std::vector< std::vector< NeighborhoodIteratorType > > nitOCp( ImageDimension );
@@ -1834,16 +1990,16 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
     for( unsigned int j = 0; j < ImageDimension; j++ )
     {
       nitOCp[ i ][ j ] = NeighborhoodIteratorType( radius,
-        OCparts[ i ][ j ], OCparts[ i ][ j ]->GetLargestPossibleRegion() );
+        parameters.m_OCparts[ i ][ j ], region );
       nitOCp[ i ][ j ].GoToBegin();
       nitPCp[ i ][ j ] = NeighborhoodIteratorType( radius,
-        PCparts[ i ][ j ], PCparts[ i ][ j ]->GetLargestPossibleRegion() );
+        parameters.m_PCparts[ i ][ j ], region );
       nitPCp[ i ][ j ].GoToBegin();
     }
     for( unsigned int j = 0; j < NofLParts; j++ )
     {
       nitLCp[ i ][ j ] = NeighborhoodIteratorType( radius,
-        LCparts[ i ][ j ], LCparts[ i ][ j ]->GetLargestPossibleRegion() );
+        parameters.m_LCparts[ i ][ j ], region );
       nitLCp[ i ][ j ].GoToBegin();
     }
   }
@@ -1854,20 +2010,16 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   std::vector< CoefficientImageIteratorType > itLCpf( ImageDimension );
   for( unsigned int i = 0; i < ImageDimension; i++ )
   {
-    itOCpf[ i ] = CoefficientImageIteratorType( OCpartsF[ i ],
-      OCpartsF[ i ]->GetLargestPossibleRegion() );
+    itOCpf[ i ] = CoefficientImageIteratorType( parameters.m_OCpartsF[ i ], region );
     itOCpf[ i ].GoToBegin();
-    itPCpf[ i ] = CoefficientImageIteratorType( PCpartsF[ i ],
-      PCpartsF[ i ]->GetLargestPossibleRegion() );
+    itPCpf[ i ] = CoefficientImageIteratorType( parameters.m_PCpartsF[ i ], region );
     itPCpf[ i ].GoToBegin();
-    itLCpf[ i ] = CoefficientImageIteratorType( LCpartsF[ i ],
-      LCpartsF[ i ]->GetLargestPossibleRegion() );
+    itLCpf[ i ] = CoefficientImageIteratorType( parameters.m_LCpartsF[ i ], region );
     itLCpf[ i ].GoToBegin();
   }
 
   /** Create a neigborhood iterator over the rigidity image. */
-  NeighborhoodIteratorType nit_RCI( radius, this->m_RigidityCoefficientImage,
-  this->m_RigidityCoefficientImage->GetLargestPossibleRegion() );
+  NeighborhoodIteratorType nit_RCI( radius, this->m_RigidityCoefficientImage, region );
   nit_RCI.GoToBegin();
   unsigned int neighborhoodSize = nit_RCI.Size();
 
@@ -1875,23 +2027,23 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   NeighborhoodType Operator_A, Operator_B, Operator_C,
     Operator_D, Operator_E, Operator_F,
     Operator_G, Operator_H, Operator_I;
-  this->CreateNDOperator( Operator_A, "FA", spacing );
-  this->CreateNDOperator( Operator_B, "FB", spacing );
+  this->CreateNDOperator( Operator_A, "FA", parameters.m_Spacing );
+  this->CreateNDOperator( Operator_B, "FB", parameters.m_Spacing );
   if( ImageDimension == 3 )
   {
-    this->CreateNDOperator( Operator_C, "FC", spacing );
+    this->CreateNDOperator( Operator_C, "FC", parameters.m_Spacing );
   }
 
   if( this->m_CalculateLinearityCondition )
   {
-    this->CreateNDOperator( Operator_D, "FD", spacing );
-    this->CreateNDOperator( Operator_E, "FE", spacing );
-    this->CreateNDOperator( Operator_G, "FG", spacing );
+    this->CreateNDOperator( Operator_D, "FD", parameters.m_Spacing );
+    this->CreateNDOperator( Operator_E, "FE", parameters.m_Spacing );
+    this->CreateNDOperator( Operator_G, "FG", parameters.m_Spacing );
     if( ImageDimension == 3 )
     {
-      this->CreateNDOperator( Operator_F, "FF", spacing );
-      this->CreateNDOperator( Operator_H, "FH", spacing );
-      this->CreateNDOperator( Operator_I, "FI", spacing );
+      this->CreateNDOperator( Operator_F, "FF", parameters.m_Spacing );
+      this->CreateNDOperator( Operator_H, "FH", parameters.m_Spacing );
+      this->CreateNDOperator( Operator_I, "FI", parameters.m_Spacing );
     }
   }
 
@@ -1905,8 +2057,8 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   {
     while( !itOCpf[ 0 ].IsAtEnd() )
     {
-      /** Create and reset tmp with zeros. */
-      std::vector< double > tmp( ImageDimension, 0.0 );
+      /** Reset tmp with zeros. */
+      std::fill( tmp.begin(), tmp.end(), 0.0 );
 
       /** Loop over all dimensions. */
       for( unsigned int i = 0; i < ImageDimension; i++ )
@@ -1958,8 +2110,8 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   {
     while( !itPCpf[ 0 ].IsAtEnd() )
     {
-      /** Create and reset tmp with zeros. */
-      std::vector< double > tmp( ImageDimension, 0.0 );
+      /** Reset tmp with zeros. */
+      std::fill( tmp.begin(), tmp.end(), 0.0 );
 
       /** Loop over all dimensions. */
       for( unsigned int i = 0; i < ImageDimension; i++ )
@@ -2010,8 +2162,8 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   {
     while( !itLCpf[ 0 ].IsAtEnd() )
     {
-      /** Create and reset tmp with zeros. */
-      std::vector< double > tmp( ImageDimension, 0.0 );
+      /** Reset tmp with zeros. */
+      std::fill( tmp.begin(), tmp.end(), 0.0 );
 
       /** Loop over all dimensions. */
       for( unsigned int i = 0; i < ImageDimension; i++ )
@@ -2062,38 +2214,32 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   }   // end if do linearity
 
   /** TASK 8:
-   * Add it all to create the final derivative images.
+   * Add it all to create the final derivative.
    ************************************************************************* */
 
-  /** Create derivative images, each holding a component of the vector field. */
-  std::vector< CoefficientImagePointer > derivativeImages( ImageDimension );
+  /** Reset the iterators over the filtered parts. */
   for( unsigned int i = 0; i < ImageDimension; i++ )
   {
-    derivativeImages[ i ] = CoefficientImageType::New();
-    derivativeImages[ i ]->SetRegions( inputImages[ i ]->GetLargestPossibleRegion() );
-    derivativeImages[ i ]->Allocate();
-  }
-
-  /** Create iterators over the derivative images. */
-  std::vector< CoefficientImageIteratorType > itDIs( ImageDimension );
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    itDIs[ i ] = CoefficientImageIteratorType( derivativeImages[ i ],
-      derivativeImages[ i ]->GetLargestPossibleRegion() );
-    itDIs[ i ].GoToBegin();
     itOCpf[ i ].GoToBegin();
     itPCpf[ i ].GoToBegin();
     itLCpf[ i ].GoToBegin();
   }
 
+  /** The derivative is ordered like the B-spline parameters: for each
+   * dimension all grid points, in the order of the rigidity coefficient image.
+   */
+  const RigidityImageType * rigidityImage  = this->m_RigidityCoefficientImage;
+  const unsigned long       numberOfPixels
+    = rigidityImage->GetLargestPossibleRegion().GetNumberOfPixels();
+  DerivativeValueType * derivative = parameters.m_DerivativePointer;
+
   /** Do the addition. */
   // NOTE: unlike the values, for the derivatives weight * derivative is returned.
-  MeasureType gradMagLC                 = NumericTraits< MeasureType >::Zero;
-  MeasureType gradMagOC                 = NumericTraits< MeasureType >::Zero;
-  MeasureType gradMagPC                 = NumericTraits< MeasureType >::Zero;
-  double      rigidityCoefficientSumSqr = rigidityCoefficientSum * rigidityCoefficientSum;
-  while( !itDIs[ 0 ].IsAtEnd() )
+  const ScalarType rigidityCoefficientSum    = parameters.m_RigidityCoefficientSum;
+  const double     rigidityCoefficientSumSqr = rigidityCoefficientSum * rigidityCoefficientSum;
+  while( !itOCpf[ 0 ].IsAtEnd() )
   {
+    const unsigned long offset = rigidityImage->ComputeOffset( itOCpf[ 0 ].GetIndex() );
     for( unsigned int i = 0; i < ImageDimension; i++ )
     {
       ScalarType tmpDIs = NumericTraits< ScalarType >::Zero;
@@ -2123,32 +2269,103 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
       {
         tmpDIs += tmpPC;
       }
-      itDIs[ i ].Set( tmpDIs );
+      derivative[ i * numberOfPixels + offset ] = tmpDIs / rigidityCoefficientSum;
 
       /** Update iterators. */
-      ++itDIs[ i ]; ++itOCpf[ i ]; ++itPCpf[ i ]; ++itLCpf[ i ];
+      ++itOCpf[ i ]; ++itPCpf[ i ]; ++itLCpf[ i ];
     }
   } // end while
 
-  /** Set the gradient magnitudes of the several terms. */
-  this->m_LinearityConditionGradientMagnitude      = vcl_sqrt( gradMagLC );
-  this->m_OrthonormalityConditionGradientMagnitude = vcl_sqrt( gradMagOC );
-  this->m_PropernessConditionGradientMagnitude     = vcl_sqrt( gradMagPC );
+} // end ComputeDerivativeOfRegion()
 
-  /** Rearrange to create a derivative. */
-  unsigned int j = 0;
-  for( unsigned int i = 0; i < ImageDimension; i++ )
+
+/**
+ * ********************* GetThreadRegion ******************************
+ */
+
+template< class TFixedImage, class TScalarType >
+bool
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::GetThreadRegion( const RigidityImageRegionType & region,
+  const ThreadIdType threadId, const ThreadIdType numberOfThreads,
+  RigidityImageRegionType & threadRegion )
+{
+  /** Divide the last dimension in contiguous slabs. */
+  const unsigned int  lastDimension       = ImageDimension - 1;
+  const unsigned long numberOfSlices      = region.GetSize( lastDimension );
+  const unsigned long nrOfSlicesPerThread = static_cast< unsigned long >(
+    std::ceil( static_cast< double >( numberOfSlices ) / static_cast< double >( numberOfThreads ) ) );
+  const unsigned long pos_begin = std::min( nrOfSlicesPerThread * threadId, numberOfSlices );
+  const unsigned long pos_end   = std::min( nrOfSlicesPerThread * ( threadId + 1 ), numberOfSlices );
+
+  threadRegion = region;
+  threadRegion.SetIndex( lastDimension, region.GetIndex( lastDimension )
+    + static_cast< typename RigidityImageRegionType::IndexValueType >( pos_begin ) );
+  threadRegion.SetSize( lastDimension, pos_end - pos_begin );
+
+  return pos_end > pos_begin;
+
+} // end GetThreadRegion()
+
+
+/**
+ * ********************* ComputeConditionPartsThreaderCallback ******************************
+ */
+
+template< class TFixedImage, class TScalarType >
+ITK_THREAD_RETURN_TYPE
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::ComputeConditionPartsThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct  = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadID    = infoStruct->ThreadID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfThreads;
+
+  RigidityPenaltyTermThreaderParameterType * parameters
+    = static_cast< RigidityPenaltyTermThreaderParameterType * >( infoStruct->UserData );
+
+  RigidityImageRegionType threadRegion;
+  if( Self::GetThreadRegion( parameters->m_Region, threadID, nrOfThreads, threadRegion ) )
   {
-    itDIs[ i ].GoToBegin();
-    while( !itDIs[ i ].IsAtEnd() )
-    {
-      derivative[ j ] = itDIs[ i ].Get() / rigidityCoefficientSum;
-      ++itDIs[ i ];
-      j++;
-    } // end while
-  }   // end for
+    parameters->m_Metric->ComputeConditionPartsOfRegion( *parameters, threadRegion,
+      parameters->m_LinearityConditionValues[ threadID ],
+      parameters->m_OrthonormalityConditionValues[ threadID ],
+      parameters->m_PropernessConditionValues[ threadID ] );
+  }
 
-} // end GetValueAndDerivative()
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ComputeConditionPartsThreaderCallback()
+
+
+/**
+ * ********************* ComputeDerivativeThreaderCallback ******************************
+ */
+
+template< class TFixedImage, class TScalarType >
+ITK_THREAD_RETURN_TYPE
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::ComputeDerivativeThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct  = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadID    = infoStruct->ThreadID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfThreads;
+
+  RigidityPenaltyTermThreaderParameterType * parameters
+    = static_cast< RigidityPenaltyTermThreaderParameterType * >( infoStruct->UserData );
+
+  RigidityImageRegionType threadRegion;
+  if( Self::GetThreadRegion( parameters->m_DilatedRegion, threadID, nrOfThreads, threadRegion ) )
+  {
+    parameters->m_Metric->ComputeDerivativeOfRegion( *parameters, threadRegion,
+      parameters->m_LinearityConditionGradientMagnitudes[ threadID ],
+      parameters->m_OrthonormalityConditionGradientMagnitudes[ threadID ],
+      parameters->m_PropernessConditionGradientMagnitudes[ threadID ] );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ComputeDerivativeThreaderCallback()
 
 
 /**
@@ -2390,7 +2607,8 @@ typename TransformRigidityPenaltyTerm< TFixedImage, TScalarType >::CoefficientIm
 TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
 ::FilterSeparable(
   const CoefficientImageType * image,
-  const std::vector< NeighborhoodType > & Operators ) const
+  const std::vector< NeighborhoodType > & Operators,
+  const RigidityImageRegionType & region ) const
 {
   /** Create filters, supply them with boundary conditions and operators. */
   std::vector< typename NOIFType::Pointer > filters( ImageDimension );
@@ -2407,7 +2625,11 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
     filters[ i ]->SetInput( filters[ i - 1 ]->GetOutput() );
   }
 
-  /** Execute the mini-pipeline. */
+  /** Execute the mini-pipeline, only for the requested region. Each filter
+   * requests the region that it needs from its input, which is the requested
+   * region padded by the radius of its operator.
+   */
+  filters[ ImageDimension - 1 ]->GetOutput()->SetRequestedRegion( region );
   filters[ ImageDimension - 1 ]->Update();
 
   /** Return the filtered image. */
@@ -22,6 +22,7 @@
 
 #include "itkSmoothingRecursiveGaussianImageFilter.h"
 #include "itkImageRandomCoordinateSampler.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkNearestNeighborInterpolateImageFunction.h"
 #include "itkExtractImageFilter.h"
 
@@ -51,6 +52,9 @@ public:
   /** Run-time type information (and related methods). */
   itkTypeMacro( SumOfPairwiseCorrelationCoefficientsMetric, AdvancedImageToImageMetric );
 
+  /** The random number generator. */
+  typedef Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+
   /** Set functions. */
   itkSetMacro( NumAdditionalSamplesFixed, unsigned int );
   itkSetMacro( ReducedDimensionIndex, unsigned int );
@@ -58,6 +62,11 @@ public:
   itkSetMacro( GridSize, FixedImageSizeType );
   itkSetMacro( TransformIsStackTransform, bool );
 
+  /** Set the random number generator that selects the last dimension
+   * positions. The global instance is used by default.
+   */
+  itkSetObjectMacro( RandomGenerator, RandomGeneratorType );
+
   /** Typedefs from the superclass. */
   typedef typename
     Superclass::CoordinateRepresentationType              CoordinateRepresentationType;
@@ -86,6 +95,7 @@ public:
   typedef typename Superclass::MovingImageMaskPointer     MovingImageMaskPointer;
   typedef typename Superclass::MeasureType                MeasureType;
   typedef typename Superclass::DerivativeType             DerivativeType;
+  typedef typename Superclass::DerivativeValueType        DerivativeValueType;
   typedef typename Superclass::ParametersType             ParametersType;
   typedef typename Superclass::FixedImagePixelType        FixedImagePixelType;
   typedef typename Superclass::MovingImageRegionType      MovingImageRegionType;
@@ -112,6 +122,8 @@ public:
     MovingImageType::ImageDimension );
 
   /** Get the value for single valued optimizers. */
+  virtual MeasureType GetValueSingleThreaded( const TransformParametersType & parameters ) const;
+
   virtual MeasureType GetValue( const TransformParametersType & parameters ) const;
 
   /** Get the derivatives of the match measure. */
@@ -119,6 +131,9 @@ public:
     DerivativeType & derivative ) const;
 
   /** Get value and derivatives for multiple valued optimizers. */
+  void GetValueAndDerivativeSingleThreaded(const TransformParametersType& parameters,
+      MeasureType& Value, DerivativeType& Derivative) const;
+
   virtual void GetValueAndDerivative(const TransformParametersType& parameters,
       MeasureType& Value, DerivativeType& Derivative) const;
 
@@ -130,7 +145,7 @@ public:
 
 protected:
   SumOfPairwiseCorrelationCoefficientsMetric();
-  virtual ~SumOfPairwiseCorrelationCoefficientsMetric() {}
+  virtual ~SumOfPairwiseCorrelationCoefficientsMetric();
   void PrintSelf( std::ostream& os, Indent indent ) const;
 
   /** Protected Typedefs ******************/
@@ -149,6 +164,9 @@ protected:
   typedef typename Superclass::MovingImageDerivativeType          MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType         NonZeroJacobianIndicesType;
 
+  typedef vnl_matrix< RealType >                                  MatrixType;
+  typedef vnl_matrix< DerivativeValueType >                       DerivativeMatrixType;
+
   /** Computes the innerproduct of transform Jacobian with moving image gradient.
    * The results are stored in imageJacobian, which is supposed
    * to have the right size (same length as Jacobian's number of columns). */
@@ -157,6 +175,45 @@ protected:
     const MovingImageDerivativeType & movingImageDerivative,
     DerivativeType & imageJacobian) const;
 
+  /** The samples of which all images are valid, collected by each thread.
+   * The thread also computes the mean of its samples, and the sum of the
+   * outer products of their deviations from that mean, which are combined
+   * into the covariance matrix in AfterThreadedGetValue().
+   */
+  struct SumOfPairwiseCorrelationCoefficientsGetSamplesPerThreadStruct
+  {
+    std::vector< unsigned long > st_ApprovedSamples;
+    std::vector< RealType >      st_DataBlock;
+    vnl_vector< RealType >       st_Mean;
+    MatrixType                   st_SquaredDeviations;
+  };
+
+  itkPadStruct( ITK_CACHE_LINE_ALIGNMENT, SumOfPairwiseCorrelationCoefficientsGetSamplesPerThreadStruct,
+    PaddedSumOfPairwiseCorrelationCoefficientsGetSamplesPerThreadStruct );
+
+  itkAlignedTypedef( ITK_CACHE_LINE_ALIGNMENT,
+    PaddedSumOfPairwiseCorrelationCoefficientsGetSamplesPerThreadStruct,
+    AlignedSumOfPairwiseCorrelationCoefficientsGetSamplesPerThreadStruct );
+
+  mutable AlignedSumOfPairwiseCorrelationCoefficientsGetSamplesPerThreadStruct * m_GetSamplesPerThreadVariables;
+  mutable ThreadIdType m_GetSamplesPerThreadVariablesSize;
+
+  /** Collect the samples of each thread. */
+  inline void ThreadedGetValue( ThreadIdType threadID );
+
+  /** Compute the correlation matrix from the samples of all threads. */
+  inline void AfterThreadedGetValue( MeasureType & value ) const;
+
+  /** Get the derivative for each thread. */
+  inline void ThreadedGetValueAndDerivative( ThreadIdType threadID );
+
+  /** Gather the derivatives from all threads. */
+  inline void AfterThreadedGetValueAndDerivative(
+    MeasureType & value, DerivativeType & derivative ) const;
+
+  /** Initialize some multi-threading related parameters. */
+  virtual void InitializeThreadingParameters( void ) const;
+
 private:
   SumOfPairwiseCorrelationCoefficientsMetric(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
@@ -164,6 +221,9 @@ private:
   /** Sample n random numbers from 0..m and add them to the vector. */
   void SampleRandom (const int n, const int m, std::vector<int> & numbers) const;
 
+  /** Subtract the mean over the last dimension from the derivative elements. */
+  void SubtractMeanFromDerivative( DerivativeType & derivative ) const;
+
   /** Variables to control random sampling in last dimension. */
   unsigned int m_NumAdditionalSamplesFixed;
   unsigned int m_ReducedDimensionIndex;
@@ -177,6 +237,17 @@ private:
   /** Bool to indicate if the transform used is a stacktransform. Set by elx files. */
   bool m_TransformIsStackTransform;
 
+  /** The random number generator that selects the last dimension positions. */
+  RandomGeneratorType::Pointer m_RandomGenerator;
+
+  /** Variables computed in AfterThreadedGetValue(), needed for the derivative. */
+  mutable vnl_vector< RealType >            m_Mean;
+  mutable DerivativeMatrixType              m_KS;
+  mutable vnl_vector< DerivativeValueType > m_S;
+  mutable vnl_vector< DerivativeValueType > m_dSdmu_part1;
+  mutable vnl_vector< DerivativeValueType > m_KAtZscoreAmmDiagonal;
+  mutable RealType                          m_KFrobeniusNorm;
+
 }; // end class SumOfPairwiseCorrelationCoefficientsMetric
 
 } // end namespace itk
@@ -20,7 +20,6 @@
 
 #include "itkSumOfPairwiseCorrelationCoefficientsMetric.h"
 
-#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "vnl/algo/vnl_matrix_update.h"
 #include "itkImage.h"
 #include <numeric>
@@ -40,9 +39,26 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>
   this->SetUseImageSampler( true );
   this->SetUseFixedImageLimiter( false );
   this->SetUseMovingImageLimiter( false );
+  this->m_RandomGenerator = RandomGeneratorType::GetInstance();
+
+  /** Multi-threading structs. */
+  this->m_GetSamplesPerThreadVariables     = NULL;
+  this->m_GetSamplesPerThreadVariablesSize = 0;
 } // end constructor
 
 
+/**
+ * ******************* Destructor *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>
+::~SumOfPairwiseCorrelationCoefficientsMetric()
+{
+  delete[] this->m_GetSamplesPerThreadVariables;
+} // end Destructor
+
+
 /**
  * ******************* Initialize *******************
  */
@@ -70,6 +86,30 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>
 } // end PrintSelf()
 
 
+/**
+ * ********************* InitializeThreadingParameters ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>
+::InitializeThreadingParameters( void ) const
+{
+  /** Call superclass implementation. */
+  Superclass::InitializeThreadingParameters();
+
+  /** Only resize the array of structs when needed. */
+  if( this->m_GetSamplesPerThreadVariablesSize != this->m_NumberOfThreads )
+  {
+    delete[] this->m_GetSamplesPerThreadVariables;
+    this->m_GetSamplesPerThreadVariables
+      = new AlignedSumOfPairwiseCorrelationCoefficientsGetSamplesPerThreadStruct[ this->m_NumberOfThreads ];
+    this->m_GetSamplesPerThreadVariablesSize = this->m_NumberOfThreads;
+  }
+
+} // end InitializeThreadingParameters()
+
+
 /**
  * ******************* SampleRandom *******************
  */
@@ -82,9 +122,6 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>
   /** Empty list of last dimension positions. */
   numbers.clear();
 
-  /** Initialize random number generator. */
-  Statistics::MersenneTwisterRandomVariateGenerator::Pointer randomGenerator = Statistics::MersenneTwisterRandomVariateGenerator::GetInstance();
-
   /** Sample additional at fixed timepoint. */
   for( unsigned int i = 0; i < m_NumAdditionalSamplesFixed; ++i )
   {
@@ -97,7 +134,7 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>
     int randomNum = 0;
     do
     {
-      randomNum = static_cast<int>( randomGenerator->GetVariateWithClosedRange( m ) );
+      randomNum = static_cast<int>( this->m_RandomGenerator->GetVariateWithClosedRange( m ) );
     } while( find( numbers.begin(), numbers.end(), randomNum ) != numbers.end() );
     numbers.push_back( randomNum );
   }
@@ -138,13 +175,94 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>
 
 
 /**
- * ******************* GetValue *******************
+ * ******************* SubtractMeanFromDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>
+::SubtractMeanFromDerivative( DerivativeType & derivative ) const
+{
+  /** Retrieve slowest varying dimension and its size. */
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+  const unsigned int G = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
+
+  if( !this->m_TransformIsStackTransform )
+  {
+    /** Update derivative per dimension.
+     * Parameters are ordered xxxxxxx yyyyyyy zzzzzzz ttttttt and
+     * per dimension xyz.
+     */
+    const unsigned int lastDimGridSize = this->m_GridSize[ lastDim ];
+    const unsigned int numParametersPerDimension
+      = this->GetNumberOfParameters() / this->GetMovingImage()->GetImageDimension();
+    const unsigned int numControlPointsPerDimension = numParametersPerDimension / lastDimGridSize;
+    DerivativeType mean( numControlPointsPerDimension );
+    for( unsigned int d = 0; d < this->GetMovingImage()->GetImageDimension(); ++d )
+    {
+      /** Compute mean per dimension. */
+      mean.Fill( 0.0 );
+      const unsigned int starti = numParametersPerDimension * d;
+      for( unsigned int i = starti; i < starti + numParametersPerDimension; ++i )
+      {
+        const unsigned int index = i % numControlPointsPerDimension;
+        mean[ index ] += derivative[ i ];
+      }
+      mean /= static_cast<double>( lastDimGridSize );
+
+      /** Update derivative for every control point per dimension. */
+      for( unsigned int i = starti; i < starti + numParametersPerDimension; ++i )
+      {
+        const unsigned int index = i % numControlPointsPerDimension;
+        derivative[ i ] -= mean[ index ];
+      }
+    }
+  }
+  else
+  {
+    /** Update derivative per dimension.
+     * Parameters are ordered x0x0x0y0y0y0z0z0z0x1x1x1y1y1y1z1z1z1 with
+     * the number the time point index.
+     */
+    const unsigned int numParametersPerLastDimension = this->GetNumberOfParameters() / G;
+    DerivativeType mean( numParametersPerLastDimension );
+    mean.Fill( 0.0 );
+
+    /** Compute mean per control point. */
+    for( unsigned int t = 0; t < G; ++t )
+    {
+      const unsigned int startc = numParametersPerLastDimension * t;
+      for( unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c )
+      {
+        const unsigned int index = c % numParametersPerLastDimension;
+        mean[ index ] += derivative[ c ];
+      }
+    }
+    mean /= static_cast<double>( G );
+
+    /** Update derivative per control point. */
+    for( unsigned int t = 0; t < G; ++t )
+    {
+      const unsigned int startc = numParametersPerLastDimension * t;
+      for( unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c )
+      {
+        const unsigned int index = c % numParametersPerLastDimension;
+        derivative[ c ] -= mean[ index ];
+      }
+    }
+  }
+
+} // end SubtractMeanFromDerivative()
+
+
+/**
+ * ******************* GetValueSingleThreaded *******************
  */
 
 template <class TFixedImage, class TMovingImage>
 typename SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>::MeasureType
 SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>
-::GetValue( const TransformParametersType & parameters ) const
+::GetValueSingleThreaded( const TransformParametersType & parameters ) const
 {
   itkDebugMacro( "GetValue( " << parameters << " ) " );
 
@@ -283,9 +401,279 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>
   /** Return the measure value. */
   return measure;
 
+} // end GetValueSingleThreaded()
+
+
+/**
+ * ******************* GetValue *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+typename SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>::MeasureType
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>
+::GetValue( const TransformParametersType & parameters ) const
+{
+  /** Option for now to still use the single threaded code. */
+  if( !this->m_UseMultiThread )
+  {
+    return this->GetValueSingleThreaded( parameters );
+  }
+
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   */
+  this->BeforeThreadedGetValueAndDerivative( parameters );
+
+  /** Launch multi-threading metric, which collects the samples. */
+  this->LaunchGetValueThreaderCallback();
+
+  /** Compute the metric value from the samples of all threads. */
+  MeasureType value = NumericTraits< MeasureType >::Zero;
+  this->AfterThreadedGetValue( value );
+
+  return value;
+
 } // end GetValue()
 
 
+/**
+ * ******************* ThreadedGetValue *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>
+::ThreadedGetValue( ThreadIdType threadId )
+{
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const unsigned long         sampleContainerSize = sampleContainer->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads
+    = static_cast<unsigned long>( vcl_ceil( static_cast<double>( sampleContainerSize )
+    / static_cast<double>( this->m_NumberOfThreads ) ) );
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * ( threadId + 1 );
+  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
+  pos_end = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
+
+  /** Retrieve slowest varying dimension and its size. */
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+  const unsigned int G = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
+
+  /** Create variables to store intermediate results. circumvent false sharing */
+  std::vector< unsigned long > approvedSamples;
+  std::vector< RealType >      datablock;
+  std::vector< RealType >      values( G );
+
+  for( unsigned long pos = pos_begin; pos < pos_end; ++pos )
+  {
+    /** Read fixed coordinates. */
+    FixedImagePointType fixedPoint = sampleContainer->ElementAt( pos ).m_ImageCoordinates;
+
+    /** Transform sampled point to voxel coordinates. */
+    FixedImageContinuousIndexType voxelCoord;
+    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex( fixedPoint, voxelCoord );
+
+    /** Loop over t. A sample is only used if it is valid in all images. */
+    unsigned int numSamplesOk = 0;
+    for( unsigned int d = 0; d < G; ++d )
+    {
+      /** Initialize some variables. */
+      RealType movingImageValue;
+      MovingImagePointType mappedPoint;
+
+      /** Set fixed point's last dimension to lastDimPosition. */
+      voxelCoord[ lastDim ] = d;
+
+      /** Transform sampled point back to world coordinates. */
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint( voxelCoord, fixedPoint );
+
+      /** Transform point and check if it is inside the B-spline support region. */
+      bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+
+      /** Check if point is inside mask. */
+      if( sampleOk )
+      {
+        sampleOk = this->IsInsideMovingMask( mappedPoint );
+      }
+
+      if( sampleOk )
+      {
+        sampleOk = this->EvaluateMovingImageValueAndDerivative(
+          mappedPoint, movingImageValue, 0 );
+      }
+
+      if( !sampleOk )
+      {
+        break;
+      }
+
+      numSamplesOk++;
+      values[ d ] = movingImageValue;
+
+    } // end loop over t
+
+    if( numSamplesOk == G )
+    {
+      approvedSamples.push_back( pos );
+      datablock.insert( datablock.end(), values.begin(), values.end() );
+    }
+
+  } // end loop over image sample container
+
+  /** Compute the mean of the samples of this thread, and the sum of the
+   * outer products of the deviations from this mean.
+   */
+  const unsigned long numberOfSamplesOk = approvedSamples.size();
+  vnl_vector< RealType > mean( G, NumericTraits< RealType >::Zero );
+  MatrixType squaredDeviations( G, G, NumericTraits< RealType >::Zero );
+  for( unsigned long i = 0; i < numberOfSamplesOk; ++i )
+  {
+    for( unsigned int j = 0; j < G; ++j )
+    {
+      mean( j ) += datablock[ i * G + j ];
+    }
+  }
+  if( numberOfSamplesOk > 0 )
+  {
+    mean /= static_cast< RealType >( numberOfSamplesOk );
+  }
+
+  for( unsigned long i = 0; i < numberOfSamplesOk; ++i )
+  {
+    for( unsigned int j = 0; j < G; ++j )
+    {
+      values[ j ] = datablock[ i * G + j ] - mean( j );
+    }
+    for( unsigned int j = 0; j < G; ++j )
+    {
+      for( unsigned int k = 0; k <= j; ++k )
+      {
+        squaredDeviations( j, k ) += values[ j ] * values[ k ];
+      }
+    }
+  }
+  for( unsigned int j = 0; j < G; ++j )
+  {
+    for( unsigned int k = 0; k < j; ++k )
+    {
+      squaredDeviations( k, j ) = squaredDeviations( j, k );
+    }
+  }
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  SumOfPairwiseCorrelationCoefficientsGetSamplesPerThreadStruct & threadVariables
+    = this->m_GetSamplesPerThreadVariables[ threadId ];
+  threadVariables.st_ApprovedSamples.swap( approvedSamples );
+  threadVariables.st_DataBlock.swap( datablock );
+  threadVariables.st_Mean = mean;
+  threadVariables.st_SquaredDeviations = squaredDeviations;
+
+} // end ThreadedGetValue()
+
+
+/**
+ * ******************* AfterThreadedGetValue *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>
+::AfterThreadedGetValue( MeasureType & value ) const
+{
+  /** Retrieve slowest varying dimension and its size. */
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+  const unsigned int G = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
+
+  /** Accumulate the number of pixels. */
+  this->m_NumberOfPixelsCounted = 0;
+  for( ThreadIdType i = 0; i < this->m_NumberOfThreads; ++i )
+  {
+    this->m_NumberOfPixelsCounted
+      += this->m_GetSamplesPerThreadVariables[ i ].st_ApprovedSamples.size();
+  }
+
+  /** Check if enough samples were valid. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  this->CheckNumberOfSamples(
+    sampleContainer->Size(), this->m_NumberOfPixelsCounted );
+  const RealType N = static_cast< RealType >( this->m_NumberOfPixelsCounted );
+
+  /** Combine the means of the threads. */
+  vnl_vector< RealType > mean( G, NumericTraits< RealType >::Zero );
+  for( ThreadIdType i = 0; i < this->m_NumberOfThreads; ++i )
+  {
+    const SumOfPairwiseCorrelationCoefficientsGetSamplesPerThreadStruct & threadVariables
+      = this->m_GetSamplesPerThreadVariables[ i ];
+    mean += threadVariables.st_Mean
+      * static_cast< RealType >( threadVariables.st_ApprovedSamples.size() );
+  }
+  mean /= N;
+
+  /** Combine the squared deviations of the threads into the covariance
+   * matrix C, correcting for the difference between the thread means
+   * and the overall mean.
+   */
+  MatrixType C( G, G, NumericTraits< RealType >::Zero );
+  for( ThreadIdType i = 0; i < this->m_NumberOfThreads; ++i )
+  {
+    const SumOfPairwiseCorrelationCoefficientsGetSamplesPerThreadStruct & threadVariables
+      = this->m_GetSamplesPerThreadVariables[ i ];
+    const unsigned long n = threadVariables.st_ApprovedSamples.size();
+    if( n == 0 )
+    {
+      continue;
+    }
+    const vnl_vector< RealType > delta = threadVariables.st_Mean - mean;
+    C += threadVariables.st_SquaredDeviations;
+    C += outer_product( delta, delta ) * static_cast< RealType >( n );
+  }
+  C /= static_cast<RealType> ( N - 1.0 );
+
+  vnl_diag_matrix< RealType > S( G );
+  S.fill( NumericTraits< RealType >::Zero );
+  for( unsigned int j = 0; j < G; j++ )
+  {
+    S( j, j ) = 1.0 / sqrt( C( j, j ) );
+  }
+
+  DerivativeMatrixType K( S*C*S );
+
+  /** Store the variables that the threads need for the derivative. The
+   * products with the centered samples are formed per sample in
+   * ThreadedGetValueAndDerivative(). The diagonal of K S A^T A, with A the
+   * centered samples, equals (N - 1) times the diagonal of K S C.
+   */
+  this->m_Mean = mean;
+  this->m_KS = K*S;
+  this->m_S.set_size( G );
+  this->m_dSdmu_part1.set_size( G );
+  this->m_KAtZscoreAmmDiagonal.set_size( G );
+  for( unsigned int d = 0; d < G; d++ )
+  {
+    double S_sqr = S( d, d ) * S( d, d );
+    double S_qub = S_sqr * S( d, d );
+    this->m_S[ d ] = S( d, d );
+    this->m_dSdmu_part1[ d ] = -S_qub / ( DerivativeValueType( N ) - 1.0 );
+
+    DerivativeValueType tmp = 0.0;
+    for( unsigned int k = 0; k < G; k++ )
+    {
+      tmp += this->m_KS( d, k ) * C( k, d );
+    }
+    this->m_KAtZscoreAmmDiagonal[ d ] = tmp * ( DerivativeValueType( N ) - 1.0 );
+  }
+  this->m_KFrobeniusNorm = K.fro_norm();
+
+  value = RealType( 1.0 - ( this->m_KFrobeniusNorm / RealType( G ) ) );
+
+} // end AfterThreadedGetValue()
+
+
 /**
  * ******************* GetDerivative *******************
  */
@@ -309,13 +697,13 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>
 
 
 /**
- * ******************* GetValueAndDerivative *******************
+ * ******************* GetValueAndDerivativeSingleThreaded *******************
  */
 
 template< class TFixedImage, class TMovingImage >
 void
 SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>
-::GetValueAndDerivative( const TransformParametersType & parameters,
+::GetValueAndDerivativeSingleThreaded( const TransformParametersType & parameters,
                          MeasureType& value, DerivativeType& derivative ) const
 {
   itkDebugMacro( "GetValueAndDerivative( " << parameters << " ) " );
@@ -545,76 +933,179 @@ SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>
   /** Subtract mean from derivative elements. */
   if( this->m_SubtractMean )
   {
-    if( !this->m_TransformIsStackTransform )
+    this->SubtractMeanFromDerivative( derivative );
+  }
+
+  /** Return the measure value. */
+  value = measure;
+
+} // end GetValueAndDerivativeSingleThreaded()
+
+
+/**
+ * ******************* GetValueAndDerivative *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>
+::GetValueAndDerivative( const TransformParametersType & parameters,
+                         MeasureType& value, DerivativeType& derivative ) const
+{
+  /** Option for now to still use the single threaded code. */
+  if( !this->m_UseMultiThread )
+  {
+    return this->GetValueAndDerivativeSingleThreaded(
+      parameters, value, derivative );
+  }
+
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   */
+  this->BeforeThreadedGetValueAndDerivative( parameters );
+
+  /** Launch multi-threading metric, which collects the samples. */
+  this->LaunchGetValueThreaderCallback();
+
+  /** Compute the metric value from the samples of all threads. */
+  this->AfterThreadedGetValue( value );
+
+  /** Launch multi-threading derivative. */
+  this->LaunchGetValueAndDerivativeThreaderCallback();
+
+  /** Gather the derivatives from all threads. */
+  this->AfterThreadedGetValueAndDerivative( value, derivative );
+
+} // end GetValueAndDerivative()
+
+
+/**
+ * ******************* ThreadedGetValueAndDerivative *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>
+::ThreadedGetValueAndDerivative( ThreadIdType threadId )
+{
+  /** Get a handle to the pre-allocated derivative for the current thread.
+   * The initialization is performed at the beginning of each resolution in
+   * InitializeThreadingParameters(), and at the end of each iteration in
+   * the accumulate functions.
+   */
+  DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Derivative;
+
+  /** The samples of this thread, collected in ThreadedGetValue(). */
+  const SumOfPairwiseCorrelationCoefficientsGetSamplesPerThreadStruct & threadVariables
+    = this->m_GetSamplesPerThreadVariables[ threadId ];
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+
+  /** Retrieve slowest varying dimension and its size. */
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+  const unsigned int G = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
+
+  /** Create variables to store intermediate results in. */
+  TransformJacobianType jacobian;
+  DerivativeType imageJacobian( this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices() );
+  NonZeroJacobianIndicesType nzji( this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices() );
+  std::vector< DerivativeValueType > Amm( G );
+
+  for( unsigned long pixelIndex = 0; pixelIndex < threadVariables.st_ApprovedSamples.size(); ++pixelIndex )
+  {
+    /** The centered values of this sample. */
+    const RealType * values = &threadVariables.st_DataBlock[ pixelIndex * G ];
+    for( unsigned int d = 0; d < G; ++d )
     {
-      /** Update derivative per dimension.
-       * Parameters are ordered xxxxxxx yyyyyyy zzzzzzz ttttttt and
-       * per dimension xyz.
-       */
-      const unsigned int lastDimGridSize = this->m_GridSize[ lastDim ];
-      const unsigned int numParametersPerDimension
-        = this->GetNumberOfParameters() / this->GetMovingImage()->GetImageDimension();
-      const unsigned int numControlPointsPerDimension = numParametersPerDimension / lastDimGridSize;
-      DerivativeType mean( numControlPointsPerDimension );
-      for( unsigned int d = 0; d < this->GetMovingImage()->GetImageDimension(); ++d )
-      {
-        /** Compute mean per dimension. */
-        mean.Fill( 0.0 );
-        const unsigned int starti = numParametersPerDimension * d;
-        for( unsigned int i = starti; i < starti + numParametersPerDimension; ++i )
-        {
-          const unsigned int index = i % numControlPointsPerDimension;
-          mean[ index ] += derivative[ i ];
-        }
-        mean /= static_cast<double>( lastDimGridSize );
-
-        /** Update derivative for every control point per dimension. */
-        for( unsigned int i = starti; i < starti + numParametersPerDimension; ++i )
-        {
-          const unsigned int index = i % numControlPointsPerDimension;
-          derivative[ i ] -= mean[ index ];
-        }
-      }
+      Amm[ d ] = values[ d ] - this->m_Mean( d );
     }
-    else
+
+    /** Read fixed coordinates. */
+    FixedImagePointType fixedPoint
+      = sampleContainer->ElementAt( threadVariables.st_ApprovedSamples[ pixelIndex ] ).m_ImageCoordinates;
+
+    /** Transform sampled point to voxel coordinates. */
+    FixedImageContinuousIndexType voxelCoord;
+    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex( fixedPoint, voxelCoord );
+
+    for( unsigned int d = 0; d < G; ++d )
     {
-      /** Update derivative per dimension.
-       * Parameters are ordered x0x0x0y0y0y0z0z0z0x1x1x1y1y1y1z1z1z1 with
-       * the number the time point index.
-       */
-      const unsigned int numParametersPerLastDimension = this->GetNumberOfParameters() / G;
-      DerivativeType mean( numParametersPerLastDimension );
-      mean.Fill( 0.0 );
+      /** Initialize some variables. */
+      RealType movingImageValue;
+      MovingImagePointType mappedPoint;
+      MovingImageDerivativeType movingImageDerivative;
 
-      /** Compute mean per control point. */
-      for( unsigned int t = 0; t < G; ++t )
+      /** Set fixed point's last dimension to lastDimPosition. */
+      voxelCoord[ lastDim ] = d;
+
+      /** Transform sampled point back to world coordinates. */
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint( voxelCoord, fixedPoint );
+      this->TransformPoint( fixedPoint, mappedPoint );
+
+      this->EvaluateMovingImageValueAndDerivative(
+        mappedPoint, movingImageValue, &movingImageDerivative );
+
+      /** Get the TransformJacobian dT/dmu */
+      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
+
+      /** Compute the innerproduct (dM/dx)^T (dT/dmu). */
+      this->EvaluateTransformJacobianInnerProduct(
+        jacobian, movingImageDerivative, imageJacobian );
+
+      /** The element of K (A S)^T of this sample and image. */
+      DerivativeValueType KAtZscore = 0.0;
+      for( unsigned int k = 0; k < G; ++k )
       {
-        const unsigned int startc = numParametersPerLastDimension * t;
-        for( unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c )
-        {
-          const unsigned int index = c % numParametersPerLastDimension;
-          mean[ index ] += derivative[ c ];
-        }
+        KAtZscore += this->m_KS( d, k ) * Amm[ k ];
       }
-      mean /= static_cast<double>( G );
+      const DerivativeValueType weight = KAtZscore * this->m_S[ d ]
+        + this->m_dSdmu_part1[ d ] * Amm[ d ] * this->m_KAtZscoreAmmDiagonal[ d ];
 
-      /** Update derivative per control point. */
-      for( unsigned int t = 0; t < G; ++t )
+      /** build metric derivative components */
+      for( unsigned int p = 0; p < nzji.size(); ++p )
       {
-        const unsigned int startc = numParametersPerLastDimension * t;
-        for( unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c )
-        {
-          const unsigned int index = c % numParametersPerLastDimension;
-          derivative[ c ] -= mean[ index ];
-        }
+        derivative[ nzji[ p ] ] += weight * imageJacobian[ p ];
       }
-    }
-  }
 
-  /** Return the measure value. */
-  value = measure;
+    } // end loop over t
 
-} // end GetValueAndDerivative()
+  } // end loop over the samples of this thread
+
+} // end ThreadedGetValueAndDerivative()
+
+
+/**
+ * ******************* AfterThreadedGetValueAndDerivative *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+SumOfPairwiseCorrelationCoefficientsMetric<TFixedImage,TMovingImage>
+::AfterThreadedGetValueAndDerivative(
+  MeasureType & value, DerivativeType & derivative ) const
+{
+  /** Retrieve slowest varying dimension and its size. */
+  const unsigned int lastDim = this->GetFixedImage()->GetImageDimension() - 1;
+  const unsigned int G = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
+
+  /** Accumulate and normalize the derivatives multi-threadedly. */
+  derivative = DerivativeType( this->GetNumberOfParameters() );
+  this->m_ThreaderMetricParameters.st_DerivativePointer = derivative.begin();
+  this->m_ThreaderMetricParameters.st_NormalizationFactor
+    = -( DerivativeValueType( this->m_NumberOfPixelsCounted ) - 1.0 )
+    * this->m_KFrobeniusNorm * RealType( G ) / 2.0;
+
+  PersistentThreadPool::Launch( this->m_Threader,
+    this->AccumulateDerivativesThreaderCallback,
+    const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
+
+  /** Subtract mean from derivative elements. */
+  if( this->m_SubtractMean )
+  {
+    this->SubtractMeanFromDerivative( derivative );
+  }
+
+} // end AfterThreadedGetValueAndDerivative()
 
 } // end namespace itk
 
@@ -107,6 +107,9 @@ VarianceOverLastDimensionMetric< TElastix >
     "SubtractMean", this->GetComponentLabel(), 0, 0 );
   this->SetSubtractMean( subtractMean );
 
+  /** Select the last dimension positions with the random number generator of this run. */
+  this->SetRandomGenerator( this->GetElastix()->GetRandomGenerator() );
+
   /** Get and set the number of random samples for the last dimension. */
   int numSamplesLastDimension = 10;
   this->GetConfiguration()->ReadParameter( numSamplesLastDimension,
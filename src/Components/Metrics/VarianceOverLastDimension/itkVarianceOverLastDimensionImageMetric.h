@@ -21,6 +21,7 @@
 
 #include "itkSmoothingRecursiveGaussianImageFilter.h"
 #include "itkImageRandomCoordinateSampler.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkNearestNeighborInterpolateImageFunction.h"
 #include "itkAdvancedImageToImageMetric.h"
 
@@ -44,6 +45,11 @@ namespace itk
  * or by nearest neighbor interpolation of a precomputed central difference image.
  * \li A minimum number of samples that should map within the moving image (mask) can be specified.
  *
+ * The samples are divided over the threads, which accumulate their own value and
+ * derivative. When the last dimension is sampled randomly, the positions are drawn
+ * for all samples before the threads are started, so that the result does not
+ * depend on the number of threads.
+ *
  * \ingroup RegistrationMetrics
  * \ingroup Metrics
  */
@@ -70,6 +76,9 @@ public:
   /** Run-time type information (and related methods). */
   itkTypeMacro( VarianceOverLastDimensionImageMetric, AdvancedImageToImageMetric );
 
+  /** The random number generator. */
+  typedef Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+
   /** Set functions. */
   itkSetMacro( SampleLastDimensionRandomly, bool );
   itkSetMacro( NumSamplesLastDimension, unsigned int );
@@ -79,6 +88,11 @@ public:
   itkSetMacro( GridSize, FixedImageSizeType );
   itkSetMacro( TransformIsStackTransform, bool );
 
+  /** Set the random number generator that selects the last dimension
+   * positions. The global instance is used by default.
+   */
+  itkSetObjectMacro( RandomGenerator, RandomGeneratorType );
+
   /** Get functions. */
   itkGetConstMacro( SampleLastDimensionRandomly, bool );
   itkGetConstMacro( NumSamplesLastDimension, int );
@@ -137,6 +151,8 @@ public:
     MovingImageType::ImageDimension );
 
   /** Get the value for single valued optimizers. */
+  virtual MeasureType GetValueSingleThreaded( const TransformParametersType & parameters ) const;
+
   virtual MeasureType GetValue( const TransformParametersType & parameters ) const;
 
   /** Get the derivatives of the match measure. */
@@ -144,6 +160,9 @@ public:
     DerivativeType & derivative ) const;
 
   /** Get value and derivatives for multiple valued optimizers. */
+  void GetValueAndDerivativeSingleThreaded( const TransformParametersType & parameters,
+    MeasureType & Value, DerivativeType & Derivative ) const;
+
   virtual void GetValueAndDerivative( const TransformParametersType & parameters,
     MeasureType & Value, DerivativeType & Derivative ) const;
 
@@ -182,6 +201,19 @@ protected:
     const MovingImageDerivativeType & movingImageDerivative,
     DerivativeType & imageJacobian ) const;
 
+  /** Get value for each thread. */
+  inline void ThreadedGetValue( ThreadIdType threadID );
+
+  /** Gather the values from all threads. */
+  inline void AfterThreadedGetValue( MeasureType & value ) const;
+
+  /** Get value and derivatives for each thread. */
+  inline void ThreadedGetValueAndDerivative( ThreadIdType threadID );
+
+  /** Gather the values and derivatives from all threads. */
+  inline void AfterThreadedGetValueAndDerivative(
+    MeasureType & value, DerivativeType & derivative ) const;
+
 private:
 
   VarianceOverLastDimensionImageMetric( const Self & ); // purposely not implemented
@@ -190,6 +222,13 @@ private:
   /** Sample n random numbers from 0..m and add them to the vector. */
   void SampleRandom( const int n, const int m, std::vector< int > & numbers ) const;
 
+  /** Fill m_LastDimPositions for the threads. With random sampling the positions
+   * of all samples are stored after each other, otherwise all positions once. */
+  void InitializeLastDimPositions( void ) const;
+
+  /** Subtract the mean over the last dimension from the derivative elements. */
+  void SubtractMeanFromDerivative( DerivativeType & derivative ) const;
+
   /** Variables to control random sampling in last dimension. */
   bool         m_SampleLastDimensionRandomly;
   unsigned int m_NumSamplesLastDimension;
@@ -208,6 +247,13 @@ private:
   /** Bool to indicate if the transform used is a stacktransform. Set by elx files. */
   bool m_TransformIsStackTransform;
 
+  /** The random number generator that selects the last dimension positions. */
+  RandomGeneratorType::Pointer m_RandomGenerator;
+
+  /** The last dimension positions used by the threads. */
+  mutable std::vector< int > m_LastDimPositions;
+  mutable unsigned int       m_NumLastDimPositions;
+
 };
 
 } // end namespace itk
@@ -19,7 +19,6 @@
 #define __itkVarianceOverLastDimensionImageMetric_hxx
 
 #include "itkVarianceOverLastDimensionImageMetric.h"
-#include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "vnl/algo/vnl_matrix_update.h"
 #include <numeric>
 
@@ -36,11 +35,13 @@ VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
   m_SampleLastDimensionRandomly( false ),
   m_NumSamplesLastDimension( 10 ),
   m_SubtractMean( false ),
-  m_TransformIsStackTransform( false )
+  m_TransformIsStackTransform( false ),
+  m_NumLastDimPositions( 0 )
 {
   this->SetUseImageSampler( true );
   this->SetUseFixedImageLimiter( false );
   this->SetUseMovingImageLimiter( false );
+  this->m_RandomGenerator = RandomGeneratorType::GetInstance();
 
 } // end Constructor
 
@@ -136,10 +137,6 @@ VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
   /** Empty list of last dimension positions. */
   numbers.clear();
 
-  /** Initialize random number generator. */
-  Statistics::MersenneTwisterRandomVariateGenerator::Pointer randomGenerator
-    = Statistics::MersenneTwisterRandomVariateGenerator::GetInstance();
-
   /** Sample additional at fixed timepoint. */
   for( unsigned int i = 0; i < m_NumAdditionalSamplesFixed; ++i )
   {
@@ -152,7 +149,7 @@ VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
     int randomNum = 0;
     do
     {
-      randomNum = static_cast< int >( randomGenerator->GetVariateWithClosedRange( m ) );
+      randomNum = static_cast< int >( this->m_RandomGenerator->GetVariateWithClosedRange( m ) );
     }
     while( find( numbers.begin(), numbers.end(), randomNum ) != numbers.end() );
     numbers.push_back( randomNum );
@@ -160,6 +157,129 @@ VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
 } // end SampleRandom()
 
 
+/**
+ * ******************* InitializeLastDimPositions *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
+::InitializeLastDimPositions( void ) const
+{
+  /** Retrieve slowest varying dimension and its size. */
+  const unsigned int lastDim     = this->GetFixedImage()->GetImageDimension() - 1;
+  const unsigned int lastDimSize = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
+
+  this->m_LastDimPositions.clear();
+  if( !this->m_SampleLastDimensionRandomly )
+  {
+    this->m_NumLastDimPositions = lastDimSize;
+    for( unsigned int i = 0; i < lastDimSize; ++i )
+    {
+      this->m_LastDimPositions.push_back( i );
+    }
+    return;
+  }
+
+  /** The random number generator is not thread-safe, so draw the positions
+   * of all samples here, in the order of the single-threaded code.
+   */
+  const unsigned long numberOfSamples = this->GetImageSampler()->GetOutput()->Size();
+  this->m_NumLastDimPositions
+    = this->m_NumSamplesLastDimension + this->m_NumAdditionalSamplesFixed;
+  this->m_LastDimPositions.reserve( numberOfSamples * this->m_NumLastDimPositions );
+
+  std::vector< int > lastDimPositions;
+  for( unsigned long pos = 0; pos < numberOfSamples; ++pos )
+  {
+    this->SampleRandom( this->m_NumSamplesLastDimension, lastDimSize, lastDimPositions );
+    this->m_LastDimPositions.insert( this->m_LastDimPositions.end(),
+      lastDimPositions.begin(), lastDimPositions.end() );
+  }
+
+} // end InitializeLastDimPositions()
+
+
+/**
+ * ******************* SubtractMeanFromDerivative *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
+::SubtractMeanFromDerivative( DerivativeType & derivative ) const
+{
+  /** Retrieve slowest varying dimension and its size. */
+  const unsigned int lastDim     = this->GetFixedImage()->GetImageDimension() - 1;
+  const unsigned int lastDimSize = this->GetFixedImage()->GetLargestPossibleRegion().GetSize( lastDim );
+
+  if( !this->m_TransformIsStackTransform )
+  {
+    /** Update derivative per dimension.
+    * Parameters are ordered xxxxxxx yyyyyyy zzzzzzz ttttttt and
+    * per dimension xyz.
+    */
+    const unsigned int lastDimGridSize              = this->m_GridSize[ lastDim ];
+    const unsigned int numParametersPerDimension    = this->GetNumberOfParameters() / this->GetMovingImage()->GetImageDimension();
+    const unsigned int numControlPointsPerDimension = numParametersPerDimension / lastDimGridSize;
+    DerivativeType     mean( numControlPointsPerDimension );
+    for( unsigned int d = 0; d < this->GetMovingImage()->GetImageDimension(); ++d )
+    {
+      /** Compute mean per dimension. */
+      mean.Fill( 0.0 );
+      const unsigned int starti = numParametersPerDimension * d;
+      for( unsigned int i = starti; i < starti + numParametersPerDimension; ++i )
+      {
+        const unsigned int index = i % numControlPointsPerDimension;
+        mean[ index ] += derivative[ i ];
+      }
+      mean /= static_cast< double >( lastDimGridSize );
+
+      /** Update derivative for every control point per dimension. */
+      for( unsigned int i = starti; i < starti + numParametersPerDimension; ++i )
+      {
+        const unsigned int index = i % numControlPointsPerDimension;
+        derivative[ i ] -= mean[ index ];
+      }
+    }
+  }
+  else
+  {
+    /** Update derivative per dimension.
+    * Parameters are ordered x0x0x0y0y0y0z0z0z0x1x1x1y1y1y1z1z1z1 with
+    * the number the time point index.
+    */
+    const unsigned int numParametersPerLastDimension = this->GetNumberOfParameters() / lastDimSize;
+    DerivativeType     mean( numParametersPerLastDimension );
+    mean.Fill( 0.0 );
+
+    /** Compute mean per control point. */
+    for( unsigned int t = 0; t < lastDimSize; ++t )
+    {
+      const unsigned int startc = numParametersPerLastDimension * t;
+      for( unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c )
+      {
+        const unsigned int index = c % numParametersPerLastDimension;
+        mean[ index ] += derivative[ c ];
+      }
+    }
+    mean /= static_cast< double >( lastDimSize );
+
+    /** Update derivative per control point. */
+    for( unsigned int t = 0; t < lastDimSize; ++t )
+    {
+      const unsigned int startc = numParametersPerLastDimension * t;
+      for( unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c )
+      {
+        const unsigned int index = c % numParametersPerLastDimension;
+        derivative[ c ] -= mean[ index ];
+      }
+    }
+  }
+
+} // end SubtractMeanFromDerivative()
+
+
 /**
  * *************** EvaluateTransformJacobianInnerProduct ****************
  */
@@ -193,13 +313,13 @@ VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
 
 
 /**
- * ******************* GetValue *******************
+ * ******************* GetValueSingleThreaded *******************
  */
 
 template< class TFixedImage, class TMovingImage >
 typename VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >::MeasureType
 VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
-::GetValue( const TransformParametersType & parameters ) const
+::GetValueSingleThreaded( const TransformParametersType & parameters ) const
 {
   itkDebugMacro( "GetValue( " << parameters << " ) " );
 
@@ -330,9 +450,194 @@ VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
   /** Return the mean squares measure value. */
   return measure;
 
+} // end GetValueSingleThreaded()
+
+
+/**
+ * ******************* GetValue *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >::MeasureType
+VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
+::GetValue( const TransformParametersType & parameters ) const
+{
+  /** Option for now to still use the single threaded code. */
+  if( !this->m_UseMultiThread )
+  {
+    return this->GetValueSingleThreaded( parameters );
+  }
+
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   */
+  this->BeforeThreadedGetValueAndDerivative( parameters );
+
+  /** Determine the last dimension positions of all samples. */
+  this->InitializeLastDimPositions();
+
+  /** Launch multi-threading metric */
+  this->LaunchGetValueThreaderCallback();
+
+  /** Gather the metric values from all threads. */
+  MeasureType value = NumericTraits< MeasureType >::Zero;
+  this->AfterThreadedGetValue( value );
+
+  return value;
+
 } // end GetValue()
 
 
+/**
+ * ******************* ThreadedGetValue *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
+::ThreadedGetValue( ThreadIdType threadId )
+{
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer     = this->GetImageSampler()->GetOutput();
+  const unsigned long         sampleContainerSize = sampleContainer->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads
+    = static_cast< unsigned long >( vcl_ceil( static_cast< double >( sampleContainerSize )
+    / static_cast< double >( this->m_NumberOfThreads ) ) );
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
+  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
+  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
+
+  /** Retrieve slowest varying dimension. */
+  const unsigned int lastDim                 = this->GetFixedImage()->GetImageDimension() - 1;
+  const unsigned int realNumLastDimPositions = this->m_NumLastDimPositions;
+
+  /** Create variables to store intermediate results. circumvent false sharing */
+  unsigned long numberOfPixelsCounted = 0;
+  MeasureType   measure               = NumericTraits< MeasureType >::Zero;
+
+  /** Loop over the fixed image samples to calculate the variance over time for every sample position. */
+  for( unsigned long pos = pos_begin; pos < pos_end; ++pos )
+  {
+    /** Read fixed coordinates. */
+    FixedImagePointType fixedPoint = sampleContainer->ElementAt( pos ).m_ImageCoordinates;
+
+    /** The last dimension positions of this sample. */
+    const int * lastDimPositions = &this->m_LastDimPositions[ 0 ];
+    if( this->m_SampleLastDimensionRandomly )
+    {
+      lastDimPositions += pos * realNumLastDimPositions;
+    }
+
+    /** Transform sampled point to voxel coordinates. */
+    FixedImageContinuousIndexType voxelCoord;
+    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex( fixedPoint, voxelCoord );
+
+    /** Loop over the slowest varying dimension. */
+    float        sumValues        = 0.0;
+    float        sumValuesSquared = 0.0;
+    unsigned int numSamplesOk     = 0;
+    for( unsigned int d = 0; d < realNumLastDimPositions; ++d )
+    {
+      /** Initialize some variables. */
+      RealType             movingImageValue;
+      MovingImagePointType mappedPoint;
+
+      /** Set fixed point's last dimension to lastDimPosition. */
+      voxelCoord[ lastDim ] = lastDimPositions[ d ];
+
+      /** Transform sampled point back to world coordinates. */
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint( voxelCoord, fixedPoint );
+
+      /** Transform point and check if it is inside the B-spline support region. */
+      bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+
+      /** Check if point is inside mask. */
+      if( sampleOk )
+      {
+        sampleOk = this->IsInsideMovingMask( mappedPoint );
+      }
+
+      /** Compute the moving image value and check if the point is
+       * inside the moving image buffer.
+       */
+      if( sampleOk )
+      {
+        sampleOk = this->EvaluateMovingImageValueAndDerivative(
+          mappedPoint, movingImageValue, 0 );
+      }
+
+      if( sampleOk )
+      {
+        numSamplesOk++;
+        sumValues        += movingImageValue;
+        sumValuesSquared += movingImageValue * movingImageValue;
+      } // end if sampleOk
+    }   // end for loop over last dimension
+
+    if( numSamplesOk > 0 )
+    {
+      numberOfPixelsCounted++;
+
+      /** Add this variance to the variance sum. */
+      const float expectedValue        = sumValues / static_cast< float >( numSamplesOk );
+      const float expectedSquaredValue = sumValuesSquared / static_cast< float >( numSamplesOk );
+      measure += expectedSquaredValue - expectedValue * expectedValue;
+    }
+
+  } // end for loop over the image sample container
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted = numberOfPixelsCounted;
+  this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Value                 = measure;
+
+} // end ThreadedGetValue()
+
+
+/**
+ * ******************* AfterThreadedGetValue *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
+::AfterThreadedGetValue( MeasureType & value ) const
+{
+  /** Accumulate the number of pixels. */
+  this->m_NumberOfPixelsCounted = this->m_GetValueAndDerivativePerThreadVariables[ 0 ].st_NumberOfPixelsCounted;
+  for( ThreadIdType i = 1; i < this->m_NumberOfThreads; ++i )
+  {
+    this->m_NumberOfPixelsCounted += this->m_GetValueAndDerivativePerThreadVariables[ i ].st_NumberOfPixelsCounted;
+
+    /** Reset this variable for the next iteration. */
+    this->m_GetValueAndDerivativePerThreadVariables[ i ].st_NumberOfPixelsCounted = 0;
+  }
+
+  /** Check if enough samples were valid. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  this->CheckNumberOfSamples(
+    sampleContainer->Size(), this->m_NumberOfPixelsCounted );
+
+  /** Accumulate values. */
+  value = NumericTraits< MeasureType >::Zero;
+  for( ThreadIdType i = 0; i < this->m_NumberOfThreads; ++i )
+  {
+    value += this->m_GetValueAndDerivativePerThreadVariables[ i ].st_Value;
+
+    /** Reset this variable for the next iteration. */
+    this->m_GetValueAndDerivativePerThreadVariables[ i ].st_Value = NumericTraits< MeasureType >::Zero;
+  }
+
+  /** Compute average over variances and normalize with initial variance. */
+  value /= static_cast< float >( this->m_NumberOfPixelsCounted * this->m_InitialVariance );
+
+} // end AfterThreadedGetValue()
+
+
 /**
  * ******************* GetDerivative *******************
  */
@@ -355,13 +660,13 @@ VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
 
 
 /**
- * ******************* GetValueAndDerivative *******************
+ * ******************* GetValueAndDerivativeSingleThreaded *******************
  */
 
 template< class TFixedImage, class TMovingImage >
 void
 VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
-::GetValueAndDerivative( const TransformParametersType & parameters,
+::GetValueAndDerivativeSingleThreaded( const TransformParametersType & parameters,
   MeasureType & value, DerivativeType & derivative ) const
 {
   itkDebugMacro( "GetValueAndDerivative( " << parameters << " ) " );
@@ -545,75 +850,242 @@ VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
   /** Subtract mean from derivative elements. */
   if( this->m_SubtractMean )
   {
-    if( !this->m_TransformIsStackTransform )
+    this->SubtractMeanFromDerivative( derivative );
+  }
+
+  /** Return the measure value. */
+  value = measure;
+
+} // end GetValueAndDerivativeSingleThreaded()
+
+
+/**
+ * ******************* GetValueAndDerivative *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
+::GetValueAndDerivative( const TransformParametersType & parameters,
+  MeasureType & value, DerivativeType & derivative ) const
+{
+  /** Option for now to still use the single threaded code. */
+  if( !this->m_UseMultiThread )
+  {
+    return this->GetValueAndDerivativeSingleThreaded(
+      parameters, value, derivative );
+  }
+
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   */
+  this->BeforeThreadedGetValueAndDerivative( parameters );
+
+  /** Determine the last dimension positions of all samples. */
+  this->InitializeLastDimPositions();
+
+  /** Launch multi-threading metric */
+  this->LaunchGetValueAndDerivativeThreaderCallback();
+
+  /** Gather the metric values and derivatives from all threads. */
+  this->AfterThreadedGetValueAndDerivative( value, derivative );
+
+} // end GetValueAndDerivative()
+
+
+/**
+ * ******************* ThreadedGetValueAndDerivative *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
+::ThreadedGetValueAndDerivative( ThreadIdType threadId )
+{
+  /** Define derivative and Jacobian types. */
+  typedef typename DerivativeType::ValueType DerivativeValueType;
+
+  /** Get a handle to the pre-allocated derivative for the current thread.
+   * The initialization is performed at the beginning of each resolution in
+   * InitializeThreadingParameters(), and at the end of each iteration in
+   * the accumulate functions.
+   */
+  DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Derivative;
+
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer     = this->GetImageSampler()->GetOutput();
+  const unsigned long         sampleContainerSize = sampleContainer->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads
+    = static_cast< unsigned long >( vcl_ceil( static_cast< double >( sampleContainerSize )
+    / static_cast< double >( this->m_NumberOfThreads ) ) );
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
+  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
+  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
+
+  /** Retrieve slowest varying dimension. */
+  const unsigned int lastDim                 = this->GetFixedImage()->GetImageDimension() - 1;
+  const unsigned int realNumLastDimPositions = this->m_NumLastDimPositions;
+
+  /** Create variables to store intermediate results in. */
+  const unsigned int    nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+  TransformJacobianType jacobian;
+  DerivativeType        imageJacobian( nnzji );
+
+  std::vector< NonZeroJacobianIndicesType > nzjis(
+  realNumLastDimPositions, NonZeroJacobianIndicesType() );
+  std::vector< RealType >       MT( realNumLastDimPositions );
+  std::vector< DerivativeType > dMTdmu( realNumLastDimPositions );
+
+  /** Create variables to store intermediate results. circumvent false sharing */
+  unsigned long numberOfPixelsCounted = 0;
+  MeasureType   measure               = NumericTraits< MeasureType >::Zero;
+
+  /** Loop over the fixed image samples to calculate the variance over time for every sample position. */
+  for( unsigned long pos = pos_begin; pos < pos_end; ++pos )
+  {
+    /** Read fixed coordinates. */
+    FixedImagePointType fixedPoint = sampleContainer->ElementAt( pos ).m_ImageCoordinates;
+
+    /** The last dimension positions of this sample. */
+    const int * lastDimPositions = &this->m_LastDimPositions[ 0 ];
+    if( this->m_SampleLastDimensionRandomly )
+    {
+      lastDimPositions += pos * realNumLastDimPositions;
+    }
+
+    /** Initialize MT vector. */
+    std::fill( MT.begin(), MT.end(), itk::NumericTraits< RealType >::ZeroValue() );
+
+    /** Transform sampled point to voxel coordinates. */
+    FixedImageContinuousIndexType voxelCoord;
+    this->GetFixedImage()->TransformPhysicalPointToContinuousIndex( fixedPoint, voxelCoord );
+
+    /** Loop over the slowest varying dimension. */
+    float        sumValues        = 0.0;
+    float        sumValuesSquared = 0.0;
+    unsigned int numSamplesOk     = 0;
+
+    /** First loop over t: compute M(T(x,t)), dM(T(x,t))/dmu, nzji and store. */
+    for( unsigned int d = 0; d < realNumLastDimPositions; ++d )
     {
-      /** Update derivative per dimension.
-      * Parameters are ordered xxxxxxx yyyyyyy zzzzzzz ttttttt and
-      * per dimension xyz.
-      */
-      const unsigned int lastDimGridSize              = this->m_GridSize[ lastDim ];
-      const unsigned int numParametersPerDimension    = this->GetNumberOfParameters() / this->GetMovingImage()->GetImageDimension();
-      const unsigned int numControlPointsPerDimension = numParametersPerDimension / lastDimGridSize;
-      DerivativeType     mean( numControlPointsPerDimension );
-      for( unsigned int d = 0; d < this->GetMovingImage()->GetImageDimension(); ++d )
+      /** Initialize some variables. */
+      RealType                  movingImageValue;
+      MovingImagePointType      mappedPoint;
+      MovingImageDerivativeType movingImageDerivative;
+
+      /** Set fixed point's last dimension to lastDimPosition. */
+      voxelCoord[ lastDim ] = lastDimPositions[ d ];
+      /** Transform sampled point back to world coordinates. */
+      this->GetFixedImage()->TransformContinuousIndexToPhysicalPoint( voxelCoord, fixedPoint );
+      /** Transform point and check if it is inside the B-spline support region. */
+      bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+
+      /** Check if point is inside mask. */
+      if( sampleOk )
       {
-        /** Compute mean per dimension. */
-        mean.Fill( 0.0 );
-        const unsigned int starti = numParametersPerDimension * d;
-        for( unsigned int i = starti; i < starti + numParametersPerDimension; ++i )
-        {
-          const unsigned int index = i % numControlPointsPerDimension;
-          mean[ index ] += derivative[ i ];
-        }
-        mean /= static_cast< double >( lastDimGridSize );
+        sampleOk = this->IsInsideMovingMask( mappedPoint );
+      }
 
-        /** Update derivative for every control point per dimension. */
-        for( unsigned int i = starti; i < starti + numParametersPerDimension; ++i )
-        {
-          const unsigned int index = i % numControlPointsPerDimension;
-          derivative[ i ] -= mean[ index ];
-        }
+      /** Compute the moving image value and check if the point is
+      * inside the moving image buffer. */
+      if( sampleOk )
+      {
+        sampleOk = this->EvaluateMovingImageValueAndDerivative(
+          mappedPoint, movingImageValue, &movingImageDerivative );
       }
-    }
-    else
-    {
-      /** Update derivative per dimension.
-      * Parameters are ordered x0x0x0y0y0y0z0z0z0x1x1x1y1y1y1z1z1z1 with
-      * the number the time point index.
-      */
-      const unsigned int numParametersPerLastDimension = this->GetNumberOfParameters() / lastDimSize;
-      DerivativeType     mean( numParametersPerLastDimension );
-      mean.Fill( 0.0 );
 
-      /** Compute mean per control point. */
-      for( unsigned int t = 0; t < lastDimSize; ++t )
+      if( sampleOk )
       {
-        const unsigned int startc = numParametersPerLastDimension * t;
-        for( unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c )
-        {
-          const unsigned int index = c % numParametersPerLastDimension;
-          mean[ index ] += derivative[ c ];
-        }
+        /** Update value terms **/
+        numSamplesOk++;
+        sumValues        += movingImageValue;
+        sumValuesSquared += movingImageValue * movingImageValue;
+
+        /** Get the TransformJacobian dT/dmu. */
+        this->EvaluateTransformJacobian( fixedPoint, jacobian, nzjis[ d ] );
+
+        /** Compute the innerproduct (dM/dx)^T (dT/dmu). */
+        this->EvaluateTransformJacobianInnerProduct(
+          jacobian, movingImageDerivative, imageJacobian );
+
+        /** Store values. */
+        MT[ d ]     = movingImageValue;
+        dMTdmu[ d ] = imageJacobian;
       }
-      mean /= static_cast< double >( lastDimSize );
+      else
+      {
+        dMTdmu[ d ] = DerivativeType( nnzji );
+        dMTdmu[ d ].Fill( itk::NumericTraits< DerivativeValueType >::ZeroValue() );
+        nzjis[ d ] = NonZeroJacobianIndicesType( nnzji, 0 );
+      } // end if sampleOk
+    }
 
-      /** Update derivative per control point. */
-      for( unsigned int t = 0; t < lastDimSize; ++t )
+    if( numSamplesOk > 0 )
+    {
+      numberOfPixelsCounted++;
+
+      /** Compute average intensity value. */
+      const float expectedValue = sumValues / static_cast< float >( numSamplesOk );
+      /** Add this variance to the variance sum. */
+      const float expectedSquaredValue = sumValuesSquared / static_cast< float >( numSamplesOk );
+      measure += expectedSquaredValue - expectedValue * expectedValue;
+
+      /** Second loop over t: update derivative. */
+      for( unsigned int d = 0; d < realNumLastDimPositions; ++d )
       {
-        const unsigned int startc = numParametersPerLastDimension * t;
-        for( unsigned int c = startc; c < startc + numParametersPerLastDimension; ++c )
+        for( unsigned int j = 0; j < nzjis[ d ].size(); ++j )
         {
-          const unsigned int index = c % numParametersPerLastDimension;
-          derivative[ c ] -= mean[ index ];
+          derivative[ nzjis[ d ][ j ] ] += ( 2.0 * ( MT[ d ] - expectedValue ) * dMTdmu[ d ][ j ] )
+            / static_cast< float >( numSamplesOk );
         }
       }
     }
-  }
+  } // end for loop over the image sample container
 
-  /** Return the measure value. */
-  value = measure;
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted = numberOfPixelsCounted;
+  this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Value                 = measure;
 
-} // end GetValueAndDerivative()
+} // end ThreadedGetValueAndDerivative()
+
+
+/**
+ * ******************* AfterThreadedGetValueAndDerivative *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+VarianceOverLastDimensionImageMetric< TFixedImage, TMovingImage >
+::AfterThreadedGetValueAndDerivative(
+  MeasureType & value, DerivativeType & derivative ) const
+{
+  /** Accumulate the number of pixels and the values. */
+  this->AfterThreadedGetValue( value );
+
+  /** Accumulate the derivatives multi-threadedly, and normalize them
+   * in the same way as the value.
+   */
+  derivative = DerivativeType( this->GetNumberOfParameters() );
+  this->m_ThreaderMetricParameters.st_DerivativePointer   = derivative.begin();
+  this->m_ThreaderMetricParameters.st_NormalizationFactor
+    = static_cast< float >( this->m_NumberOfPixelsCounted * this->m_InitialVariance );
+
+  PersistentThreadPool::Launch( this->m_Threader,
+    this->AccumulateDerivativesThreaderCallback,
+    const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
+
+  /** Subtract mean from derivative elements. */
+  if( this->m_SubtractMean )
+  {
+    this->SubtractMeanFromDerivative( derivative );
+  }
+
+} // end AfterThreadedGetValueAndDerivative()
 
 
 } // end namespace itk
@@ -153,6 +153,16 @@ MovingGenericPyramid< TElastix >
     "ComputePyramidImagesPerResolution", 0, false );
   this->SetComputeOnlyForCurrentLevel( computeThisResolution );
 
+  /** Decide whether or not to compute each level from the next finer level.
+   * The moving specific parameter has precedence over the general one.
+   */
+  bool useCascade = false;
+  this->m_Configuration->ReadParameter( useCascade,
+    "ImagePyramidUseCascade", 0, false );
+  this->m_Configuration->ReadParameter( useCascade,
+    "MovingImagePyramidUseCascade", 0, false );
+  this->SetUseCascade( useCascade );
+
 } // end SetMovingSchedule()
 
 
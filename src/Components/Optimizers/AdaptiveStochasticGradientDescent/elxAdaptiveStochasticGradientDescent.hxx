@@ -84,6 +84,9 @@ AdaptiveStochasticGradientDescent< TElastix >
   xl::xout[ "iteration" ][ "3b:StepSize" ] << std::showpoint << std::fixed;
   xl::xout[ "iteration" ][ "4:||Gradient||" ] << std::showpoint << std::fixed;
 
+  /** Draw the random perturbations from the random number generator of this run. */
+  this->m_RandomGenerator = this->GetElastix()->GetRandomGenerator();
+
   this->m_SettingsVector.clear();
 
 } // end BeforeRegistration()
@@ -274,18 +277,21 @@ void
 AdaptiveStochasticGradientDescent< TElastix >
 ::AfterEachIteration( void )
 {
-  /** Print some information. */
-  xl::xout[ "iteration" ][ "2:Metric" ] << this->GetValue();
-  xl::xout[ "iteration" ][ "3a:Time" ] << this->GetCurrentTime();
-  xl::xout[ "iteration" ][ "3b:StepSize" ] << this->GetLearningRate();
-  bool asFastAsPossible = false;
-  if( asFastAsPossible )
+  /** Print some information, unless the iteration table is not written. */
+  if( this->GetElastix()->GetWriteIterationInfo() )
   {
-    xl::xout[ "iteration" ][ "4:||Gradient||" ] << "---";
-  }
-  else
-  {
-    xl::xout[ "iteration" ][ "4:||Gradient||" ] << this->GetGradient().magnitude();
+    xl::xout[ "iteration" ][ "2:Metric" ] << this->GetValue();
+    xl::xout[ "iteration" ][ "3a:Time" ] << this->GetCurrentTime();
+    xl::xout[ "iteration" ][ "3b:StepSize" ] << this->GetLearningRate();
+    bool asFastAsPossible = false;
+    if( asFastAsPossible )
+    {
+      xl::xout[ "iteration" ][ "4:||Gradient||" ] << "---";
+    }
+    else
+    {
+      xl::xout[ "iteration" ][ "4:||Gradient||" ] << this->GetGradient().magnitude();
+    }
   }
 
   /** Select new spatial samples for the computation of the metric. */
@@ -297,6 +303,23 @@ AdaptiveStochasticGradientDescent< TElastix >
 } // end AfterEachIteration()
 
 
+/**
+ * ***************** GetIterationTelemetry ***************************
+ */
+
+template< class TElastix >
+void
+AdaptiveStochasticGradientDescent< TElastix >
+::GetIterationTelemetry( double & value, double & stepSize,
+  double & gradientMagnitude ) const
+{
+  value             = this->GetValue();
+  stepSize          = this->GetLearningRate();
+  gradientMagnitude = this->GetGradient().magnitude();
+
+} // end GetIterationTelemetry()
+
+
 /**
  * ***************** AfterEachResolution *************************
  */
@@ -23,6 +23,10 @@
 #include "itkImageGridSampler.h"
 #include "itkImageRandomSamplerBase.h"
 #include "itkImageRandomCoordinateSampler.h"
+#include "itkMultiThreader.h"
+#include "itkPersistentThreadPool.h"
+
+#include <vector>
 
 namespace itk
 {
@@ -38,6 +42,9 @@ namespace itk
  * SPIE Medical Imaging: Image Processing,February, 2014.
  * http://elastix.isi.uu.nl/marius/publications/2014_c_SPIEMI.php
  *
+ * The loop over the samples is multi-threaded. Each thread handles a
+ * contiguous range of samples and keeps its own maximum and sum, which are
+ * combined afterwards in a fixed order.
  */
 
 template< class TFixedImage, class TTransform >
@@ -92,6 +99,17 @@ public:
   /** Set some parameters. */
   itkSetMacro( NumberOfJacobianMeasurements, SizeValueType );
 
+  /** Set the number of threads. */
+  void SetNumberOfThreads( ThreadIdType numberOfThreads )
+  {
+    this->m_Threader->SetNumberOfThreads( numberOfThreads );
+  }
+
+
+  /** Set/Get whether to use multi-threading. Default: true. */
+  itkSetMacro( UseMultiThread, bool );
+  itkGetConstMacro( UseMultiThread, bool );
+
   /** Set the region over which the metric will be computed. */
   void SetFixedImageRegion( const FixedImageRegionType & region )
   {
@@ -121,6 +139,13 @@ protected:
   ScaledSingleValuedCostFunction::Pointer m_CostFunction;
   SizeValueType                           m_NumberOfJacobianMeasurements;
 
+  /** Typedefs for multi-threading. */
+  typedef MultiThreader                  ThreaderType;
+  typedef ThreaderType::ThreadInfoStruct ThreadInfoType;
+
+  ThreaderType::Pointer m_Threader;
+  bool                  m_UseMultiThread;
+
   typedef typename  FixedImageType::IndexType   FixedImageIndexType;
   typedef typename  FixedImageType::PointType   FixedImagePointType;
   typedef typename  TransformType::JacobianType JacobianType;
@@ -143,6 +168,25 @@ protected:
   typedef typename TransformType::ScalarType             CoordinateRepresentationType;
   typedef typename TransformType::NumberOfParametersType NumberOfParametersType;
 
+  /** The data shared by the threads. */
+  struct ComputeDistributionTermsThreaderParameterType
+  {
+    Self *                           m_Self;
+    const ImageSampleContainerType * m_SampleContainer;
+    const DerivativeType *           m_ExactGradient;
+    std::vector< double > *          m_JGG_k;
+    std::vector< double >            m_MaxJJ;
+    std::vector< double >            m_SumJacg;
+  };
+
+  /** Compute maxJJ and |J_j g| of one range of samples. */
+  virtual void ThreadedComputeDistributionTerms( ThreadIdType threadId,
+    ThreadIdType numberOfThreads,
+    ComputeDistributionTermsThreaderParameterType * parameters ) const;
+
+  /** The callback function for the threader. */
+  static ITK_THREAD_RETURN_TYPE ComputeDistributionTermsThreaderCallback( void * arg );
+
   /** Sample the fixed image to compute the Jacobian terms. */
   // \todo: note that this is an exact copy of itk::ComputeJacobianTerms
   // in the future it would be better to refactoring this part of the code
@@ -20,6 +20,7 @@
 
 #include "itkComputeDisplacementDistribution.h"
 
+#include <algorithm>
 #include <string>
 #include "vnl/vnl_math.h"
 #include "vnl/vnl_fastops.h"
@@ -41,6 +42,10 @@ ComputeDisplacementDistribution< TFixedImage, TTransform >
   this->m_FixedImageMask               = NULL;
   this->m_NumberOfJacobianMeasurements = 0;
 
+  /** The threads are taken from the PersistentThreadPool, if there is one. */
+  this->m_Threader       = ThreaderType::New();
+  this->m_UseMultiThread = true;
+
 } // end Constructor
 
 
@@ -80,41 +85,129 @@ ComputeDisplacementDistribution< TFixedImage, TTransform >
   DerivativeType exactgradient( P );
   this->GetScaledDerivative( mu, exactgradient );
 
-  /** Get transform and set current position. */
-  typename TransformType::Pointer transform = this->m_Transform;
-  const unsigned int outdim = this->m_Transform->GetOutputSpaceDimension();
+  /**
+   * Compute maxJJ and jac*gradient.
+   * Each thread computes the terms of a range of samples.
+   */
+  const ThreadIdType numberOfThreads = this->m_UseMultiThread
+    ? this->m_Threader->GetNumberOfThreads() : 1;
+  std::vector< double > JGG_k( nrofsamples, 0.0 );
+
+  ComputeDistributionTermsThreaderParameterType parameters;
+  parameters.m_Self            = this;
+  parameters.m_SampleContainer = sampleContainer.GetPointer();
+  parameters.m_ExactGradient   = &exactgradient;
+  parameters.m_JGG_k           = &JGG_k;
+  parameters.m_MaxJJ.assign( numberOfThreads, 0.0 );
+  parameters.m_SumJacg.assign( numberOfThreads, 0.0 );
+
+  if( numberOfThreads > 1 )
+  {
+    PersistentThreadPool::Launch( this->m_Threader,
+      ComputeDistributionTermsThreaderCallback, &parameters );
+  }
+  else
+  {
+    this->ThreadedComputeDistributionTerms( 0, 1, &parameters );
+  }
+
+  /** Combine the results of the threads. */
+  double sum_jacg = 0.0;
+  for( ThreadIdType t = 0; t < numberOfThreads; ++t )
+  {
+    maxJJ     = vnl_math_max( maxJJ, parameters.m_MaxJJ[ t ] );
+    sum_jacg += parameters.m_SumJacg[ t ];
+  }
+
+  if( methods == "95percentile" )
+  {
+    /** Compute the 95% percentile of the distribution of JGG_k */
+    unsigned int d = static_cast< unsigned int >( nrofsamples * 0.95 );
+    std::sort( JGG_k.begin(), JGG_k.end() );
+    jacg = ( JGG_k[ d - 1 ] + JGG_k[ d ] + JGG_k[ d + 1 ] ) / 3.0;
+  }
+  else if( methods == "2sigma" )
+  {
+    /** Compute the sigma of the distribution of JGG_k. */
+    double sigma    = 0.0;
+    double mean_JGG = sum_jacg / nrofsamples;
+    for( unsigned int i = 0; i < nrofsamples - 1; ++i )
+    {
+      sigma += vnl_math_sqr( JGG_k[ i ] - mean_JGG );
+    }
+    sigma /= ( nrofsamples - 1 ); // unbiased estimation
+    jacg   = mean_JGG + 2.0 * vcl_sqrt( sigma );
+  }
+} // end ComputeDistributionTerms()
+
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator iter;
-  typename ImageSampleContainerType::ConstIterator begin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator end   = sampleContainer->End();
-  unsigned int samplenr = 0;
+/**
+ * ************************* ComputeDistributionTermsThreaderCallback ************************
+ */
 
-  /** Variables for nonzerojacobian indices and the Jacobian. */
+template< class TFixedImage, class TTransform >
+ITK_THREAD_RETURN_TYPE
+ComputeDisplacementDistribution< TFixedImage, TTransform >
+::ComputeDistributionTermsThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ComputeDistributionTermsThreaderParameterType * parameters
+    = static_cast< ComputeDistributionTermsThreaderParameterType * >( infoStruct->UserData );
+
+  parameters->m_Self->ThreadedComputeDistributionTerms(
+    infoStruct->ThreadID, infoStruct->NumberOfThreads, parameters );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ComputeDistributionTermsThreaderCallback()
+
+
+/**
+ * ************************* ThreadedComputeDistributionTerms ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeDisplacementDistribution< TFixedImage, TTransform >
+::ThreadedComputeDistributionTerms( ThreadIdType threadId, ThreadIdType numberOfThreads,
+  ComputeDistributionTermsThreaderParameterType * parameters ) const
+{
+  /** Get the range of samples of this thread. */
+  const ImageSampleContainerType * sampleContainer = parameters->m_SampleContainer;
+  const unsigned long sampleContainerSize = sampleContainer->Size();
+  const unsigned long nrOfSamplesPerThreads
+    = static_cast< unsigned long >( vcl_ceil( static_cast< double >( sampleContainerSize )
+    / static_cast< double >( numberOfThreads ) ) );
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
+  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
+  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
+
+  const DerivativeType & exactgradient = *parameters->m_ExactGradient;
+  std::vector< double > & JGG_k        = *parameters->m_JGG_k;
+  const ScalesType &      scales       = this->GetScales();
+
+  /** Thread-local variables for nonzerojacobian indices and the Jacobian. */
+  const unsigned int  outdim = this->m_Transform->GetOutputSpaceDimension();
   const SizeValueType sizejacind
     = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
   JacobianType jacj( outdim, sizejacind );
   jacj.Fill( 0.0 );
   NonZeroJacobianIndicesType jacind( sizejacind );
-  jacind[ 0 ] = 0;
-  if( sizejacind > 1 ) { jacind[ 1 ] = 0; }
-
-  /**
-   * Compute maxJJ and jac*gradient
-   */
-  DerivativeType Jgg( outdim );
+  DerivativeType             Jgg( outdim );
   Jgg.Fill( 0.0 );
-  std::vector< double > JGG_k;
-  double                sum_jacg = 0.0;
-  const double          sqrt2    = vcl_sqrt( static_cast< double >( 2.0 ) );
-  JacobianType          jacjjacj( outdim, outdim );
+  JacobianType jacjjacj( outdim, outdim );
+  const double sqrt2    = vcl_sqrt( static_cast< double >( 2.0 ) );
+  double       maxJJ    = 0.0;
+  double       sum_jacg = 0.0;
 
-  samplenr = 0;
-  for( iter = begin; iter != end; ++iter )
+  for( unsigned long pos = pos_begin; pos < pos_end; ++pos )
   {
     /** Read fixed coordinates and get Jacobian. */
-    const FixedImagePointType & point = ( *iter ).Value().m_ImageCoordinates;
-    this->m_Transform->GetJacobian( point, jacj, jacind  );
+    const FixedImagePointType & point
+      = sampleContainer->GetElement( pos ).m_ImageCoordinates;
+    this->m_Transform->GetJacobian( point, jacj, jacind );
 
     /** Apply scales, if necessary. */
     if( this->GetUseScales() )
@@ -148,32 +241,17 @@ ComputeDisplacementDistribution< TFixedImage, TTransform >
       Jgg( i ) = temp;
     }
 
-    sum_jacg += Jgg.magnitude();
-    JGG_k.push_back( Jgg.magnitude() );
-    ++samplenr;
+    /** Each thread writes its own range of JGG_k. */
+    const double magnitude = Jgg.magnitude();
+    sum_jacg     += magnitude;
+    JGG_k[ pos ]  = magnitude;
 
-  } // end loop over sample container
+  } // end loop over samples
 
-  if( methods == "95percentile" )
-  {
-    /** Compute the 95% percentile of the distribution of JGG_k */
-    unsigned int d = static_cast< unsigned int >( nrofsamples * 0.95 );
-    std::sort( JGG_k.begin(), JGG_k.end() );
-    jacg = ( JGG_k[ d - 1 ] + JGG_k[ d ] + JGG_k[ d + 1 ] ) / 3.0;
-  }
-  else if( methods == "2sigma" )
-  {
-    /** Compute the sigma of the distribution of JGG_k. */
-    double sigma    = 0.0;
-    double mean_JGG = sum_jacg / samplenr;
-    for( unsigned int i = 0; i < nrofsamples - 1; ++i )
-    {
-      sigma += vnl_math_sqr( JGG_k[ i ] - mean_JGG );
-    }
-    sigma /= ( nrofsamples - 1 ); // unbiased estimation
-    jacg   = mean_JGG + 2.0 * vcl_sqrt( sigma );
-  }
-} // end ComputeDistributionTerms()
+  parameters->m_MaxJJ[ threadId ]   = maxJJ;
+  parameters->m_SumJacg[ threadId ] = sum_jacg;
+
+} // end ThreadedComputeDistributionTerms()
 
 
 /**
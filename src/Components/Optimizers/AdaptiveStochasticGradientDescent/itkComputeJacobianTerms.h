@@ -23,6 +23,14 @@
 #include "itkImageRandomSamplerBase.h"
 #include "itkImageRandomCoordinateSampler.h"
 #include "itkScaledSingleValuedNonLinearOptimizer.h"
+#include "itkMultiThreader.h"
+#include "itkPersistentThreadPool.h"
+#include "itkArray2D.h"
+
+#include "vnl/vnl_diag_matrix.h"
+#include "vnl/vnl_sparse_matrix.h"
+
+#include <vector>
 
 namespace itk
 {
@@ -32,6 +40,14 @@ namespace itk
  * More specifically this class computes the Jacobian terms related to the automatic
  * parameter estimation for the adaptive stochastic gradient descent optimizer.
  * Details can be found in the paper.
+ *
+ * The loops over the samples are multi-threaded. The covariance matrix is
+ * computed per block of samples: first the threads compute the Jacobians of
+ * the block, each for a range of samples, and then each thread adds them to
+ * its own range of rows of the covariance matrix. So no thread needs a copy
+ * of the matrix, and the result equals the single-threaded result. The
+ * maxima are computed per range of samples, and combined afterwards in a
+ * fixed order.
  */
 
 template< class TFixedImage, class TTransform >
@@ -91,6 +107,17 @@ public:
   itkSetMacro( NumberOfBandStructureSamples, unsigned int );
   itkSetMacro( NumberOfJacobianMeasurements, SizeValueType );
 
+  /** Set the number of threads. */
+  void SetNumberOfThreads( ThreadIdType numberOfThreads )
+  {
+    this->m_Threader->SetNumberOfThreads( numberOfThreads );
+  }
+
+
+  /** Set/Get whether to use multi-threading. Default: true. */
+  itkSetMacro( UseMultiThread, bool );
+  itkGetConstMacro( UseMultiThread, bool );
+
   /** Set the region over which the metric will be computed. */
   void SetFixedImageRegion( const FixedImageRegionType & region )
   {
@@ -124,6 +151,13 @@ protected:
   unsigned int  m_NumberOfBandStructureSamples;
   SizeValueType m_NumberOfJacobianMeasurements;
 
+  /** Typedefs for multi-threading. */
+  typedef MultiThreader                  ThreaderType;
+  typedef ThreaderType::ThreadInfoStruct ThreadInfoType;
+
+  ThreaderType::Pointer m_Threader;
+  bool                  m_UseMultiThread;
+
   typedef typename  FixedImageType::IndexType   FixedImageIndexType;
   typedef typename  FixedImageType::PointType   FixedImagePointType;
   typedef typename  TransformType::JacobianType JacobianType;
@@ -146,6 +180,82 @@ protected:
   typedef typename TransformType::ScalarType             CoordinateRepresentationType;
   typedef typename TransformType::NumberOfParametersType NumberOfParametersType;
 
+  /** Typedefs for the covariance matrix. */
+  typedef double                                   CovarianceValueType;
+  typedef Array2D< CovarianceValueType >           CovarianceMatrixType;
+  typedef vnl_sparse_matrix< CovarianceValueType > SparseCovarianceMatrixType;
+  typedef vnl_diag_matrix< CovarianceValueType >   DiagCovarianceMatrixType;
+
+  /** The rows [m_RowBegin, m_RowEnd) of the covariance matrix that are
+   * computed by one thread, and the rows of J^T J of the current run of
+   * samples with the same nonzero Jacobian indices. A run may continue in
+   * the next block of samples.
+   */
+  struct CovarianceRowsType
+  {
+    unsigned int               m_RowBegin;
+    unsigned int               m_RowEnd;
+    CovarianceMatrixType       m_JacTJac;
+    NonZeroJacobianIndicesType m_PrevJacInd;
+    bool                       m_JacTJacIsSet;
+  };
+
+  /** The data shared by the threads. */
+  struct ComputeJacobianTermsThreaderParameterType
+  {
+    Self *                                    m_Self;
+    const ImageSampleContainerType *          m_SampleContainer;
+    unsigned long                             m_BlockBegin;
+    unsigned long                             m_BlockEnd;
+    std::vector< JacobianType >               m_Jacobians;
+    std::vector< NonZeroJacobianIndicesType > m_JacobianIndices;
+    const std::vector< unsigned int > *       m_BandCovMap;
+    unsigned int                              m_BandCovSize;
+    CovarianceMatrixType *                    m_BandCov;
+    SparseCovarianceMatrixType *              m_Cov;
+    const DiagCovarianceMatrixType *          m_DiagCov;
+    std::vector< CovarianceRowsType >         m_CovarianceRows;
+    std::vector< double >                     m_MaxJJ;
+    std::vector< double >                     m_MaxJCJ;
+  };
+
+  /** Compute the Jacobians of one range of the samples of the current block. */
+  virtual void ThreadedComputeJacobians( ThreadIdType threadId,
+    ThreadIdType numberOfThreads,
+    ComputeJacobianTermsThreaderParameterType * parameters ) const;
+
+  /** Add the Jacobians of the current block to one range of rows of the
+   * covariance matrix C = 1/n \sum_i J_i^T J_i (term 1).
+   */
+  virtual void ThreadedComputeCovariance( ThreadIdType threadId,
+    ThreadIdType numberOfThreads,
+    ComputeJacobianTermsThreaderParameterType * parameters ) const;
+
+  /** Compute maxJJ and maxJCJ of one range of samples (terms 3 and 4). */
+  virtual void ThreadedComputeMaxJJAndMaxJCJ( ThreadIdType threadId,
+    ThreadIdType numberOfThreads,
+    ComputeJacobianTermsThreaderParameterType * parameters ) const;
+
+  /** Add the J^T J of a run of samples with the same nonzero Jacobian
+   * indices to the rows of the covariance matrix of one thread.
+   */
+  void UpdateCovarianceRows( const CovarianceRowsType & rows, const double n,
+    const ComputeJacobianTermsThreaderParameterType * parameters ) const;
+
+  /** Get the number of threads that is used. */
+  ThreadIdType GetNumberOfThreadsUsed( void ) const;
+
+  /** Run a threaded function on all threads, or on one if multi-threading is off. */
+  void LaunchThreads( ThreaderType::ThreadFunctionType callback,
+    ComputeJacobianTermsThreaderParameterType * parameters );
+
+  /** The callback functions for the threader. */
+  static ITK_THREAD_RETURN_TYPE ComputeJacobiansThreaderCallback( void * arg );
+
+  static ITK_THREAD_RETURN_TYPE ComputeCovarianceThreaderCallback( void * arg );
+
+  static ITK_THREAD_RETURN_TYPE ComputeMaxJJAndMaxJCJThreaderCallback( void * arg );
+
   /** Sample the fixed image to compute the Jacobian terms. */
   // \todo: note that this is an exact copy of itk::ComputeDisplacementDistribution
   // in the future it would be better to refactoring this part of the code.
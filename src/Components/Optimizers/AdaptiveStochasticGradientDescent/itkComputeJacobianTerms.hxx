@@ -25,6 +25,8 @@
 #include "vnl/vnl_diag_matrix.h"
 #include "vnl/vnl_sparse_matrix.h"
 
+#include <algorithm>
+
 namespace itk
 {
 /**
@@ -45,6 +47,10 @@ ComputeJacobianTerms< TFixedImage, TTransform >
   this->m_NumberOfBandStructureSamples = 0;
   this->m_NumberOfJacobianMeasurements = 0;
 
+  /** The threads are taken from the PersistentThreadPool, if there is one. */
+  this->m_Threader       = ThreaderType::New();
+  this->m_UseMultiThread = true;
+
 } // end Constructor
 
 
@@ -73,12 +79,7 @@ ComputeJacobianTerms< TFixedImage, TTransform >
    * Term 4: maxJCJ, see (54)
    */
 
-  typedef double                                   CovarianceValueType;
-  typedef itk::Array2D< CovarianceValueType >      CovarianceMatrixType;
-  typedef vnl_sparse_matrix< CovarianceValueType > SparseCovarianceMatrixType;
-  typedef SparseCovarianceMatrixType::row          SparseRowType;
-  typedef itk::Array< SizeValueType >              NonZeroJacobianIndicesExpandedType;
-  typedef vnl_diag_matrix< CovarianceValueType >   DiagCovarianceMatrixType;
+  typedef std::vector< unsigned int > BandCovMapType;
 
   /** Initialize. */
   TrC = TrCC = maxJJ = maxJCJ = 0.0;
@@ -87,26 +88,17 @@ ComputeJacobianTerms< TFixedImage, TTransform >
   ImageSampleContainerPointer sampleContainer = 0;
   SampleFixedImageForJacobianTerms( sampleContainer );
   const SizeValueType nrofsamples = sampleContainer->Size();
-  const double        n           = static_cast< double >( nrofsamples );
 
   /** Get the number of parameters. */
   const unsigned int P = static_cast< unsigned int >(
     this->m_Transform->GetNumberOfParameters() );
 
   /** Get transform and set current position. */
-  typename TransformType::Pointer transform
-    = this->m_Transform;
   const unsigned int outdim = this->m_Transform->GetOutputSpaceDimension();
 
   /** Get scales vector */
   const ScalesType & scales = this->m_Scales;
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator iter;
-  typename ImageSampleContainerType::ConstIterator begin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator end   = sampleContainer->End();
-  unsigned int samplenr = 0;
-
   /** Variables for nonzerojacobian indices and the Jacobian. */
   NumberOfParametersType sizejacind
     = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
@@ -115,17 +107,12 @@ ComputeJacobianTerms< TFixedImage, TTransform >
   NonZeroJacobianIndicesType jacind( sizejacind );
   jacind[ 0 ] = 0;
   if( sizejacind > 1 ) { jacind[ 1 ] = 0; }
-  NonZeroJacobianIndicesType prevjacind = jacind;
 
   /** Initialize covariance matrix. Sparse, diagonal, and band form. */
   SparseCovarianceMatrixType cov( P, P );
   DiagCovarianceMatrixType   diagcov( P, 0.0 );
   CovarianceMatrixType       bandcov;
 
-  /** For temporary storage of J'J. */
-  CovarianceMatrixType jactjac( sizejacind, sizejacind );
-  jactjac.Fill( 0.0 );
-
   typedef std::vector< unsigned int >             DifHistType;
   typedef std::pair< unsigned int, unsigned int > FreqPairType;
   typedef std::vector< FreqPairType >             DifHist2Type;
@@ -200,9 +187,9 @@ ComputeJacobianTerms< TFixedImage, TTransform >
     static_cast< unsigned int >( difHist2.size() ) );
 
   /** Maps parameterNrDifference (q-p) to colnr in bandcov. */
-  std::vector< unsigned int > bandcovMap( P, bandcovsize );
+  BandCovMapType bandcovMap( P, bandcovsize );
   /** Maps colnr in bandcov to parameterNrDifference (q-p). */
-  std::vector< unsigned int > bandcovMap2( bandcovsize, P );
+  BandCovMapType bandcovMap2( bandcovsize, P );
 
   /** Sort the difHist2 based on the frequencies. */
   std::sort( difHist2.begin(), difHist2.end() );
@@ -216,108 +203,69 @@ ComputeJacobianTerms< TFixedImage, TTransform >
     bandcovMap2[ b ]                 = difHist2It->second;
   }
 
-  /** Initialize band matrix. */
-  bandcov = CovarianceMatrixType( P, bandcovsize );
-  bandcov.Fill( 0.0 );
-
   /**
    *    TERM 1
    *
    * Loop over image and compute Jacobian.
    * Compute C = 1/n \sum_i J_i^T J_i
    * Possibly apply scaling afterwards.
+   *
+   * The samples are processed in blocks. The threads first compute the
+   * Jacobians of a block, each for a range of samples, and then add them
+   * to the covariance matrix, each for a range of rows.
    */
-  jacind[ 0 ] = 0;
-  if( sizejacind > 1 ) { jacind[ 1 ] = 0; }
-  for( iter = begin; iter != end; ++iter )
+  const ThreadIdType  numberOfThreads     = this->GetNumberOfThreadsUsed();
+  const SizeValueType nrOfSamplesPerBlock = 128 * numberOfThreads;
+  const unsigned int  nrOfRowsPerThread   = static_cast< unsigned int >(
+    vcl_ceil( static_cast< double >( P ) / static_cast< double >( numberOfThreads ) ) );
+
+  bandcov = CovarianceMatrixType( P, bandcovsize );
+  bandcov.Fill( 0.0 );
+
+  ComputeJacobianTermsThreaderParameterType parameters;
+  parameters.m_Self            = this;
+  parameters.m_SampleContainer = sampleContainer.GetPointer();
+  parameters.m_BandCovMap      = &bandcovMap;
+  parameters.m_BandCovSize     = bandcovsize;
+  parameters.m_BandCov         = &bandcov;
+  parameters.m_Cov             = &cov;
+  parameters.m_DiagCov         = &diagcov;
+  parameters.m_Jacobians.assign( vnl_math_min( nrOfSamplesPerBlock, nrofsamples ), jacj );
+  parameters.m_JacobianIndices.assign( parameters.m_Jacobians.size(), jacind );
+  parameters.m_CovarianceRows.resize( numberOfThreads );
+  for( ThreadIdType t = 0; t < numberOfThreads; ++t )
   {
-    /** Print progress 0-50%.
-     *progressObserver->UpdateAndPrintProgress( samplenr );*/
-    ++samplenr;
+    CovarianceRowsType & rows = parameters.m_CovarianceRows[ t ];
+    rows.m_RowBegin = vnl_math_min( nrOfRowsPerThread * t, P );
+    rows.m_RowEnd   = vnl_math_min( nrOfRowsPerThread * ( t + 1 ), P );
+    rows.m_JacTJac.SetSize( sizejacind, sizejacind );
+    rows.m_JacTJac.Fill( 0.0 );
+    rows.m_PrevJacInd   = jacind;
+    rows.m_JacTJacIsSet = false;
+  }
 
-    /** Read fixed coordinates and get Jacobian J_j. */
-    const FixedImagePointType & point = ( *iter ).Value().m_ImageCoordinates;
-    this->m_Transform->GetJacobian( point, jacj, jacind  );
+  for( SizeValueType blockBegin = 0; blockBegin < nrofsamples; blockBegin += nrOfSamplesPerBlock )
+  {
+    parameters.m_BlockBegin = blockBegin;
+    parameters.m_BlockEnd   = vnl_math_min( blockBegin + nrOfSamplesPerBlock, nrofsamples );
+    this->LaunchThreads( ComputeJacobiansThreaderCallback, &parameters );
+    this->LaunchThreads( ComputeCovarianceThreaderCallback, &parameters );
+  }
 
-    /** Skip invalid Jacobians in the beginning, if any. */
-    if( sizejacind > 1 )
+  /** Update covariance matrix once again to include last jactjac updates. */
+  const double n = static_cast< double >( nrofsamples );
+  for( ThreadIdType t = 0; t < numberOfThreads; ++t )
+  {
+    if( parameters.m_CovarianceRows[ t ].m_JacTJacIsSet )
     {
-      if( jacind[ 0 ] == jacind[ 1 ] ) { continue; }
+      this->UpdateCovarianceRows( parameters.m_CovarianceRows[ t ], n, &parameters );
     }
+  }
 
-    if( jacind == prevjacind )
-    {
-      /** Update sum of J_j^T J_j. */
-      vnl_fastops::inc_X_by_AtA( jactjac, jacj );
-    }
-    else
-    {
-      /** The following should only be done after the first sample. */
-      if( iter != begin )
-      {
-        /** Update covariance matrix. */
-        for( unsigned int pi = 0; pi < sizejacind; ++pi )
-        {
-          const unsigned int p = prevjacind[ pi ];
-          for( unsigned int qi = 0; qi < sizejacind; ++qi )
-          {
-            const unsigned int q = prevjacind[ qi ];
-            if( q >= p )
-            {
-              const double tempval = jactjac( pi, qi ) / n;
-              if( vcl_abs( tempval ) > 1e-14 )
-              {
-                const unsigned int bandindex = bandcovMap[ q - p ];
-                if( bandindex < bandcovsize )
-                {
-                  bandcov( p, bandindex ) += tempval;
-                }
-                else
-                {
-                  cov( p, q ) += tempval;
-                }
-              }
-            }
-          } // qi
-        }   // pi
-      }     // end if
-
-      /** Initialize jactjac by J_j^T J_j. */
-      vnl_fastops::AtA( jactjac, jacj );
-
-      /** Remember nonzerojacobian indices. */
-      prevjacind = jacind;
-    } // end else
-
-  } // end iter loop: end computation of covariance matrix
-
-  /** Update covariance matrix once again to include last jactjac updates
-   * \todo: a bit ugly that this loop is copied from above.
-   */
-  for( unsigned int pi = 0; pi < sizejacind; ++pi )
-  {
-    const unsigned int p = prevjacind[ pi ];
-    for( unsigned int qi = 0; qi < sizejacind; ++qi )
-    {
-      const unsigned int q = prevjacind[ qi ];
-      if( q >= p )
-      {
-        const double tempval = jactjac( pi, qi ) / n;
-        if( vcl_abs( tempval ) > 1e-14 )
-        {
-          const unsigned int bandindex = bandcovMap[ q - p ];
-          if( bandindex < bandcovsize )
-          {
-            bandcov( p, bandindex ) += tempval;
-          }
-          else
-          {
-            cov( p, q ) += tempval;
-          }
-        }
-      }
-    } // qi
-  }   // pi
+  /** Release the memory. */
+  parameters.m_Jacobians.clear();
+  parameters.m_JacobianIndices.clear();
+  parameters.m_CovarianceRows.clear();
 
   /** Copy the bandmatrix into the sparse matrix and empty the bandcov matrix.
    * \todo: perhaps work further with this bandmatrix instead.
@@ -389,25 +337,353 @@ ComputeJacobianTerms< TFixedImage, TTransform >
    * Compute maxJJ and maxJCJ
    * \li maxJJ = max_j [ ||J_j||_F^2 + 2\sqrt{2} || J_j J_j^T ||_F ]
    * \li maxJCJ = max_j [ Tr( J_j C J_j^T ) + 2\sqrt{2} || J_j C J_j^T ||_F ]
+   *
+   * Each thread computes the maxima of a range of samples.
    */
+  parameters.m_MaxJJ.assign( numberOfThreads, 0.0 );
+  parameters.m_MaxJCJ.assign( numberOfThreads, 0.0 );
+  this->LaunchThreads( ComputeMaxJJAndMaxJCJThreaderCallback, &parameters );
+
   maxJJ  = 0.0;
   maxJCJ = 0.0;
+  for( std::size_t t = 0; t < parameters.m_MaxJJ.size(); ++t )
+  {
+    maxJJ  = vnl_math_max( maxJJ, parameters.m_MaxJJ[ t ] );
+    maxJCJ = vnl_math_max( maxJCJ, parameters.m_MaxJCJ[ t ] );
+  }
+
+} // end ComputeParameters()
+
+
+/**
+ * ************************* GetNumberOfThreadsUsed ************************
+ */
+
+template< class TFixedImage, class TTransform >
+ThreadIdType
+ComputeJacobianTerms< TFixedImage, TTransform >
+::GetNumberOfThreadsUsed( void ) const
+{
+  return this->m_UseMultiThread ? this->m_Threader->GetNumberOfThreads() : 1;
+
+} // end GetNumberOfThreadsUsed()
+
+
+/**
+ * ************************* LaunchThreads ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::LaunchThreads( ThreaderType::ThreadFunctionType callback,
+  ComputeJacobianTermsThreaderParameterType * parameters )
+{
+  const ThreadIdType numberOfThreads = this->GetNumberOfThreadsUsed();
+
+  if( numberOfThreads > 1 )
+  {
+    PersistentThreadPool::Launch( this->m_Threader, callback, parameters );
+  }
+  else
+  {
+    ThreadInfoType infoStruct;
+    infoStruct.ThreadID        = 0;
+    infoStruct.NumberOfThreads = 1;
+    infoStruct.UserData        = parameters;
+    callback( &infoStruct );
+  }
+
+} // end LaunchThreads()
+
+
+/**
+ * ************************* ComputeJacobiansThreaderCallback ************************
+ */
+
+template< class TFixedImage, class TTransform >
+ITK_THREAD_RETURN_TYPE
+ComputeJacobianTerms< TFixedImage, TTransform >
+::ComputeJacobiansThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ComputeJacobianTermsThreaderParameterType * parameters
+    = static_cast< ComputeJacobianTermsThreaderParameterType * >( infoStruct->UserData );
+
+  parameters->m_Self->ThreadedComputeJacobians(
+    infoStruct->ThreadID, infoStruct->NumberOfThreads, parameters );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ComputeJacobiansThreaderCallback()
+
+
+/**
+ * ************************* ComputeCovarianceThreaderCallback ************************
+ */
+
+template< class TFixedImage, class TTransform >
+ITK_THREAD_RETURN_TYPE
+ComputeJacobianTerms< TFixedImage, TTransform >
+::ComputeCovarianceThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ComputeJacobianTermsThreaderParameterType * parameters
+    = static_cast< ComputeJacobianTermsThreaderParameterType * >( infoStruct->UserData );
+
+  parameters->m_Self->ThreadedComputeCovariance(
+    infoStruct->ThreadID, infoStruct->NumberOfThreads, parameters );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ComputeCovarianceThreaderCallback()
+
+
+/**
+ * ************************* ComputeMaxJJAndMaxJCJThreaderCallback ************************
+ */
+
+template< class TFixedImage, class TTransform >
+ITK_THREAD_RETURN_TYPE
+ComputeJacobianTerms< TFixedImage, TTransform >
+::ComputeMaxJJAndMaxJCJThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ComputeJacobianTermsThreaderParameterType * parameters
+    = static_cast< ComputeJacobianTermsThreaderParameterType * >( infoStruct->UserData );
+
+  parameters->m_Self->ThreadedComputeMaxJJAndMaxJCJ(
+    infoStruct->ThreadID, infoStruct->NumberOfThreads, parameters );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ComputeMaxJJAndMaxJCJThreaderCallback()
+
+
+/**
+ * ************************* ThreadedComputeJacobians ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::ThreadedComputeJacobians( ThreadIdType threadId, ThreadIdType numberOfThreads,
+  ComputeJacobianTermsThreaderParameterType * parameters ) const
+{
+  /** Get the range of samples of the block of this thread. */
+  const ImageSampleContainerType * sampleContainer = parameters->m_SampleContainer;
+  const unsigned long blockBegin = parameters->m_BlockBegin;
+  const unsigned long blockSize  = parameters->m_BlockEnd - blockBegin;
+  const unsigned long nrOfSamplesPerThreads
+    = static_cast< unsigned long >( vcl_ceil( static_cast< double >( blockSize )
+    / static_cast< double >( numberOfThreads ) ) );
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
+  pos_begin = ( pos_begin > blockSize ) ? blockSize : pos_begin;
+  pos_end   = ( pos_end > blockSize ) ? blockSize : pos_end;
+
+  /** Read fixed coordinates and get Jacobian J_j. */
+  for( unsigned long pos = pos_begin; pos < pos_end; ++pos )
+  {
+    const FixedImagePointType & point
+      = sampleContainer->GetElement( blockBegin + pos ).m_ImageCoordinates;
+    this->m_Transform->GetJacobian( point,
+      parameters->m_Jacobians[ pos ], parameters->m_JacobianIndices[ pos ] );
+  }
+
+} // end ThreadedComputeJacobians()
+
+
+/**
+ * ************************* ThreadedComputeCovariance ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::ThreadedComputeCovariance( ThreadIdType threadId, ThreadIdType itkNotUsed( numberOfThreads ),
+  ComputeJacobianTermsThreaderParameterType * parameters ) const
+{
+  /** The rows of this thread, and the state of its current run. */
+  CovarianceRowsType &   rows     = parameters->m_CovarianceRows[ threadId ];
+  CovarianceMatrixType & jactjac  = rows.m_JacTJac;
+  const unsigned int     rowBegin = rows.m_RowBegin;
+  const unsigned int     rowEnd   = rows.m_RowEnd;
+  if( rowBegin == rowEnd ) { return; }
+
+  const double                 n      = static_cast< double >( parameters->m_SampleContainer->Size() );
+  const unsigned int           outdim = this->m_Transform->GetOutputSpaceDimension();
+  const NumberOfParametersType sizejacind
+    = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
+
+  /** Loop over the Jacobians of the block, and sum the rows of J^T J of this
+   * thread for consecutive samples with the same nonzero Jacobian indices.
+   * All threads see the same runs, so the result does not depend on the
+   * number of threads.
+   */
+  const unsigned long blockSize = parameters->m_BlockEnd - parameters->m_BlockBegin;
+  for( unsigned long pos = 0; pos < blockSize; ++pos )
+  {
+    const JacobianType &               jacj   = parameters->m_Jacobians[ pos ];
+    const NonZeroJacobianIndicesType & jacind = parameters->m_JacobianIndices[ pos ];
+
+    /** Skip invalid Jacobians in the beginning, if any. */
+    if( sizejacind > 1 )
+    {
+      if( jacind[ 0 ] == jacind[ 1 ] ) { continue; }
+    }
+
+    /** Update covariance matrix with the previous run, if this is a new one. */
+    const bool newRun = !rows.m_JacTJacIsSet || jacind != rows.m_PrevJacInd;
+    if( newRun && rows.m_JacTJacIsSet )
+    {
+      this->UpdateCovarianceRows( rows, n, parameters );
+    }
+
+    /** Initialize or update the rows of jactjac by J_j^T J_j. */
+    for( unsigned int pi = 0; pi < sizejacind; ++pi )
+    {
+      const unsigned int p = jacind[ pi ];
+      if( p < rowBegin || p >= rowEnd ) { continue; }
+      for( unsigned int qi = 0; qi < sizejacind; ++qi )
+      {
+        if( jacind[ qi ] < p ) { continue; }
+        double accum = 0.0;
+        for( unsigned int d = 0; d < outdim; ++d )
+        {
+          accum += jacj[ d ][ pi ] * jacj[ d ][ qi ];
+        }
+        if( newRun )
+        {
+          jactjac( pi, qi ) = accum;
+        }
+        else
+        {
+          jactjac( pi, qi ) += accum;
+        }
+      }
+    }
+
+    /** Remember nonzerojacobian indices. */
+    if( newRun )
+    {
+      rows.m_PrevJacInd   = jacind;
+      rows.m_JacTJacIsSet = true;
+    }
+  } // end loop over samples
+
+} // end ThreadedComputeCovariance()
+
+
+/**
+ * ************************* UpdateCovarianceRows ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::UpdateCovarianceRows( const CovarianceRowsType & rows, const double n,
+  const ComputeJacobianTermsThreaderParameterType * parameters ) const
+{
+  const std::vector< unsigned int > & bandcovMap  = *parameters->m_BandCovMap;
+  const unsigned int                  bandcovsize = parameters->m_BandCovSize;
+  const NonZeroJacobianIndicesType &  jacind      = rows.m_PrevJacInd;
+  const unsigned int                  sizejacind  = static_cast< unsigned int >( jacind.size() );
+  CovarianceMatrixType &              bandcov     = *parameters->m_BandCov;
+  SparseCovarianceMatrixType &        cov         = *parameters->m_Cov;
+
+  /** Only the rows of this thread are written, so no locking is needed. */
+  for( unsigned int pi = 0; pi < sizejacind; ++pi )
+  {
+    const unsigned int p = jacind[ pi ];
+    if( p < rows.m_RowBegin || p >= rows.m_RowEnd ) { continue; }
+    for( unsigned int qi = 0; qi < sizejacind; ++qi )
+    {
+      const unsigned int q = jacind[ qi ];
+      if( q >= p )
+      {
+        const double tempval = rows.m_JacTJac( pi, qi ) / n;
+        if( vcl_abs( tempval ) > 1e-14 )
+        {
+          const unsigned int bandindex = bandcovMap[ q - p ];
+          if( bandindex < bandcovsize )
+          {
+            bandcov( p, bandindex ) += tempval;
+          }
+          else
+          {
+            cov( p, q ) += tempval;
+          }
+        }
+      }
+    } // qi
+  }   // pi
+
+} // end UpdateCovarianceRows()
+
+
+/**
+ * ************************* ThreadedComputeMaxJJAndMaxJCJ ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::ThreadedComputeMaxJJAndMaxJCJ( ThreadIdType threadId, ThreadIdType numberOfThreads,
+  ComputeJacobianTermsThreaderParameterType * parameters ) const
+{
+  typedef typename SparseCovarianceMatrixType::row SparseRowType;
+  typedef Array< SizeValueType >                   NonZeroJacobianIndicesExpandedType;
+
+  /** Get the range of samples of this thread. */
+  const ImageSampleContainerType * sampleContainer = parameters->m_SampleContainer;
+  const unsigned long sampleContainerSize = sampleContainer->Size();
+  const unsigned long nrOfSamplesPerThreads
+    = static_cast< unsigned long >( vcl_ceil( static_cast< double >( sampleContainerSize )
+    / static_cast< double >( numberOfThreads ) ) );
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
+  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
+  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
+
+  /** The covariance matrix is only read, so it can be shared. */
+  SparseCovarianceMatrixType &     cov     = *parameters->m_Cov;
+  const DiagCovarianceMatrixType & diagcov = *parameters->m_DiagCov;
+  const ScalesType &               scales  = this->m_Scales;
+
+  const unsigned int P = static_cast< unsigned int >(
+    this->m_Transform->GetNumberOfParameters() );
+  const unsigned int           outdim = this->m_Transform->GetOutputSpaceDimension();
+  const NumberOfParametersType sizejacind
+    = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
   const double sqrt2 = vcl_sqrt( static_cast< double >( 2.0 ) );
 
-  JacobianType                       jacjjacj( outdim, outdim );
-  JacobianType                       jacjcov( outdim, sizejacind );
-  DiagCovarianceMatrixType           diagcovsparse( sizejacind );
-  JacobianType                       jacjdiagcov( outdim, sizejacind );
-  JacobianType                       jacjdiagcovjacj( outdim, outdim );
-  JacobianType                       jacjcovjacj( outdim, outdim );
+  /** Thread-local variables. */
+  JacobianType               jacj( outdim, sizejacind );
+  NonZeroJacobianIndicesType jacind( sizejacind );
+  JacobianType               jacjjacj( outdim, outdim );
+  JacobianType               jacjcov( outdim, sizejacind );
+  DiagCovarianceMatrixType   diagcovsparse( sizejacind );
+  JacobianType               jacjdiagcov( outdim, sizejacind );
+  JacobianType               jacjdiagcovjacj( outdim, outdim );
+  JacobianType               jacjcovjacj( outdim, outdim );
+
+  /** Only the elements of the current nonzero Jacobian indices are set,
+   * and reset afterwards, instead of filling the whole vector each time.
+   */
   NonZeroJacobianIndicesExpandedType jacindExpanded( P );
+  jacindExpanded.Fill( sizejacind );
 
-  samplenr = 0;
-  for( iter = begin; iter != end; ++iter )
+  double maxJJ  = 0.0;
+  double maxJCJ = 0.0;
+  for( unsigned long pos = pos_begin; pos < pos_end; ++pos )
   {
     /** Read fixed coordinates and get Jacobian. */
-    const FixedImagePointType & point = ( *iter ).Value().m_ImageCoordinates;
-    this->m_Transform->GetJacobian( point, jacj, jacind  );
+    const FixedImagePointType & point
+      = sampleContainer->GetElement( pos ).m_ImageCoordinates;
+    this->m_Transform->GetJacobian( point, jacj, jacind );
 
     /** Apply scales, if necessary. */
     if( this->m_UseScales )
@@ -438,7 +714,6 @@ ComputeJacobianTerms< TFixedImage, TTransform >
     /** Store the nonzero Jacobian indices in a different format
      * and create the sparse diagcov.
      */
-    jacindExpanded.Fill( sizejacind );
     for( unsigned int pi = 0; pi < sizejacind; ++pi )
     {
       const unsigned int p = jacind[ pi ];
@@ -457,7 +732,7 @@ ComputeJacobianTerms< TFixedImage, TTransform >
       if( !cov.empty_row( p ) )
       {
         SparseRowType & covrowp = cov.get_row( p );
-        typename SparseRowType::iterator covrowpit;
+        typename SparseRowType::const_iterator covrowpit;
 
         /** Loop over row p of the sparse cov matrix. */
         for( covrowpit = covrowp.begin(); covrowpit != covrowp.end(); ++covrowpit )
@@ -479,6 +754,12 @@ ComputeJacobianTerms< TFixedImage, TTransform >
       } // if not empty row
     }   // pi
 
+    /** Reset the expanded nonzero Jacobian indices. */
+    for( unsigned int pi = 0; pi < sizejacind; ++pi )
+    {
+      jacindExpanded[ jacind[ pi ] ] = sizejacind;
+    }
+
     /** J_j C J_j^T  = jacjCjacj.
      * But note that we actually compute J_j cov' J_j^T
      */
@@ -502,16 +783,12 @@ ComputeJacobianTerms< TFixedImage, TTransform >
     /** Max_j [JCJ_j]. */
     maxJCJ = vnl_math_max( maxJCJ, JCJ_j );
 
-    /** Show progress 50-100%. */
-    //progressObserver->UpdateAndPrintProgress( samplenr + nrofsamples );
-    ++samplenr;
-
-  } // end loop over sample container
+  } // end loop over samples
 
-  /** Finalize progress information. */
-  //progressObserver->PrintProgress( 1.0 );
+  parameters->m_MaxJJ[ threadId ]  = maxJJ;
+  parameters->m_MaxJCJ[ threadId ] = maxJCJ;
 
-} // end ComputeJacobianTerms()
+} // end ThreadedComputeMaxJJAndMaxJCJ()
 
 
 /**
@@ -108,6 +108,11 @@ namespace elastix
  *    example: <tt>(UpdateBDPeriod 0 0 50)</tt> \n
  *    Default: 0 (so, automatically determined).
  *
+ * This component evaluates the members of the population one after another:
+ * the elastix metrics share one transform, so they can not be evaluated for
+ * different parameters at the same time. See
+ * itk::CMAEvolutionStrategyOptimizer::SetEvaluatePopulationConcurrently().
+ *
  * \ingroup Optimizers
  */
 
@@ -102,6 +102,9 @@ CMAEvolutionStrategy< TElastix >::BeforeRegistration( void )
   xout[ "iteration" ][ "5b:MaximumD" ] << std::showpoint << std::fixed;
   xout[ "iteration" ][ "5c:MinimumD" ] << std::showpoint << std::fixed;
 
+  /** Generate the offspring with the random number generator of this run. */
+  this->m_RandomGenerator = this->GetElastix()->GetRandomGenerator();
+
 }   // end BeforeRegistration
 
 
@@ -76,6 +76,11 @@ CMAEvolutionStrategyOptimizer::CMAEvolutionStrategyOptimizer()
   this->m_PositionToleranceMax       = 1e8;
   this->m_ValueTolerance             = 1e-12;
 
+  /** The threads are taken from the PersistentThreadPool, if there is one. */
+  this->m_Threader                       = ThreaderType::New();
+  this->m_EvaluatePopulationConcurrently = false;
+  this->m_UseMultiThread                 = true;
+
 }   // end constructor
 
 
@@ -124,6 +129,8 @@ CMAEvolutionStrategyOptimizer::PrintSelf( std::ostream & os, Indent indent ) con
   os << indent << "m_PositionToleranceMin: " << this->m_PositionToleranceMin << std::endl;
   os << indent << "m_PositionToleranceMax: " << this->m_PositionToleranceMax << std::endl;
   os << indent << "m_ValueTolerance: " << this->m_ValueTolerance << std::endl;
+  os << indent << "m_EvaluatePopulationConcurrently: " << this->m_EvaluatePopulationConcurrently << std::endl;
+  os << indent << "m_UseMultiThread: " << this->m_UseMultiThread << std::endl;
 
   os << indent << "m_RecombinationWeights: " << this->m_RecombinationWeights << std::endl;
   os << indent << "m_C: " << this->m_C << std::endl;
@@ -423,6 +430,9 @@ CMAEvolutionStrategyOptimizer::InitializeProgressVariables( void )
 
   /** m_CostFunctionValues */
   this->m_CostFunctionValues.clear();
+  this->m_OffspringValues.assign( lambda, NumericTraits< MeasureType >::Zero );
+  this->m_OffspringFailed.assign( lambda, 0 );
+  this->m_OffspringErrors.assign( lambda, ExceptionObject() );
 
   /** m_CurrentScaledStep */
   this->m_CurrentScaledStep.SetSize( N );
@@ -500,76 +510,229 @@ CMAEvolutionStrategyOptimizer::GenerateOffspring( void )
 {
   itkDebugMacro( "GenerateOffspring" );
 
-  /** Get the number of parameters from the cost function */
-  const unsigned int numberOfParameters
-    = this->GetScaledCostFunction()->GetNumberOfParameters();
-
   /** Some casts/aliases: */
-  const unsigned int N      = numberOfParameters;
   const unsigned int lambda = this->m_PopulationSize;
 
   /** Clear the old values */
   this->m_CostFunctionValues.clear();
 
-  /** Fill the m_NormalizedSearchDirs and SearchDirs */
-  unsigned int lam       = 0;
-  unsigned int nrOfFails = 0;
-  while( lam < lambda )
+  /** Without concurrent evaluation, draw and evaluate the members one by
+   * one. If the cost function fails for a member, another search direction
+   * is drawn right away, up to 10 times in a row. This keeps the order in
+   * which the random numbers are drawn.
+   */
+  if( !this->m_EvaluatePopulationConcurrently )
   {
-    /** draw from distribution N(0,I) */
-    for( unsigned int par = 0; par < N; ++par )
+    unsigned int lam       = 0;
+    unsigned int nrOfFails = 0;
+    while( lam < lambda )
     {
-      this->m_NormalizedSearchDirs[ lam ][ par ]
-        = this->m_RandomGenerator->GetNormalVariate();
+      this->DrawSearchDirection( lam );
+      this->EvaluateOffspringMember( lam );
+      if( this->m_OffspringFailed[ lam ] )
+      {
+        ++nrOfFails;
+        /** try another parameter vector if we haven't tried that for 10 times already */
+        if( nrOfFails <= 10 )
+        {
+          continue;
+        }
+        else
+        {
+          this->m_StopCondition = MetricError;
+          this->StopOptimization();
+          throw this->m_OffspringErrors[ lam ];
+        }
+      }
+
+      /** Reset the number of failed cost function evaluations */
+      nrOfFails = 0;
+
+      /** next offspring member */
+      ++lam;
     }
-    /** Make like it was drawn from N(0,C) */
-    if( this->GetUseCovarianceMatrixAdaptation() )
+  }
+  else
+  {
+    /** Fill the m_NormalizedSearchDirs and SearchDirs. All random numbers
+     * are drawn before the cost function is evaluated, so that the
+     * evaluations can be done concurrently.
+     */
+    std::vector< unsigned int > members( lambda );
+    for( unsigned int lam = 0; lam < lambda; ++lam )
     {
-      this->m_SearchDirs[ lam ] = this->m_B * ( this->m_D * this->m_NormalizedSearchDirs[ lam ] );
+      this->DrawSearchDirection( lam );
+      members[ lam ] = lam;
     }
-    else
+
+    /** Compute the cost function values. If the cost function fails for a
+     * member, another search direction is tried for that member, up to 10
+     * times. These are drawn after those of the whole population.
+     */
+    std::vector< unsigned int > nrOfFails( lambda, 0 );
+    while( !members.empty() )
     {
-      this->m_SearchDirs[ lam ] = this->m_NormalizedSearchDirs[ lam ];
+      this->EvaluateOffspring( members );
+
+      std::vector< unsigned int > failedMembers;
+      for( unsigned int i = 0; i < members.size(); ++i )
+      {
+        const unsigned int lam = members[ i ];
+        if( !this->m_OffspringFailed[ lam ] )
+        {
+          continue;
+        }
+
+        ++nrOfFails[ lam ];
+        if( nrOfFails[ lam ] > 10 )
+        {
+          this->m_StopCondition = MetricError;
+          this->StopOptimization();
+          throw this->m_OffspringErrors[ lam ];
+        }
+
+        /** Try another parameter vector */
+        this->DrawSearchDirection( lam );
+        failedMembers.push_back( lam );
+      }
+      members.swap( failedMembers );
     }
-    /** Make like it was drawn from N( 0, sigma^2 C ) */
-    this->m_SearchDirs[ lam ] *= this->m_CurrentSigma;
-
-    /** Compute the cost function */
-    MeasureType costFunctionValue = 0.0;
-    /** x_lam = m + d_lam */
-    ParametersType x_lam = this->GetScaledCurrentPosition();
-    x_lam += this->m_SearchDirs[ lam ];
-    try
+  }
+
+  /** Successfull cost function evaluations */
+  for( unsigned int lam = 0; lam < lambda; ++lam )
+  {
+    this->m_CostFunctionValues.push_back(
+      MeasureIndexPairType( this->m_OffspringValues[ lam ], lam ) );
+  }
+
+}   // end GenerateOffspring
+
+
+/**
+ * ****************** DrawSearchDirection *********************
+ */
+
+void
+CMAEvolutionStrategyOptimizer::DrawSearchDirection( unsigned int lam )
+{
+  /** Some casts/aliases: */
+  const unsigned int N = this->GetScaledCostFunction()->GetNumberOfParameters();
+  ParametersType &   normalizedSearchDir = this->m_NormalizedSearchDirs[ lam ];
+  ParametersType &   searchDir           = this->m_SearchDirs[ lam ];
+
+  /** draw from distribution N(0,I) */
+  for( unsigned int par = 0; par < N; ++par )
+  {
+    normalizedSearchDir[ par ] = this->m_RandomGenerator->GetNormalVariate();
+  }
+
+  /** Make like it was drawn from N(0,C): B * ( D * z ), without temporaries. */
+  if( this->GetUseCovarianceMatrixAdaptation() )
+  {
+    ParametersType Dz( N );
+    for( unsigned int j = 0; j < N; ++j )
     {
-      costFunctionValue = this->GetScaledValue( x_lam );
+      Dz[ j ] = this->m_D[ j ] * normalizedSearchDir[ j ];
     }
-    catch( ExceptionObject & err )
+    for( unsigned int i = 0; i < N; ++i )
     {
-      ++nrOfFails;
-      /** try another parameter vector if we haven't tried that for 10 times already */
-      if( nrOfFails <= 10 )
-      {
-        continue;
-      }
-      else
+      const double * B_i = this->m_B[ i ];
+      double         sum = 0.0;
+      for( unsigned int j = 0; j < N; ++j )
       {
-        this->m_StopCondition = MetricError;
-        this->StopOptimization();
-        throw err;
+        sum += B_i[ j ] * Dz[ j ];
       }
+      searchDir[ i ] = sum;
     }
-    /** Successfull cost function evaluation */
-    this->m_CostFunctionValues.push_back(
-      MeasureIndexPairType( costFunctionValue, lam ) );
+  }
+  else
+  {
+    searchDir = normalizedSearchDir;
+  }
 
-    /** Reset the number of failed cost function evaluations */
-    nrOfFails = 0;
+  /** Make like it was drawn from N( 0, sigma^2 C ) */
+  searchDir *= this->m_CurrentSigma;
 
-    /** next offspring member */
-    ++lam;
+}   // end DrawSearchDirection
+
+
+/**
+ * ****************** EvaluateOffspring *********************
+ */
+
+void
+CMAEvolutionStrategyOptimizer::EvaluateOffspring(
+  const std::vector< unsigned int > & members )
+{
+  if( this->m_EvaluatePopulationConcurrently && members.size() > 1 )
+  {
+    EvaluateOffspringThreaderParameterType parameters;
+    parameters.m_Optimizer = this;
+    parameters.m_Members   = &members;
+
+    PersistentThreadPool::Launch( this->m_Threader,
+      EvaluateOffspringThreaderCallback, &parameters );
+  }
+  else
+  {
+    for( unsigned int i = 0; i < members.size(); ++i )
+    {
+      this->EvaluateOffspringMember( members[ i ] );
+    }
   }
 
-}   // end GenerateOffspring
+}   // end EvaluateOffspring
+
+
+/**
+ * ****************** EvaluateOffspringMember *********************
+ */
+
+void
+CMAEvolutionStrategyOptimizer::EvaluateOffspringMember( unsigned int lam )
+{
+  /** x_lam = m + d_lam */
+  ParametersType x_lam = this->GetScaledCurrentPosition();
+  x_lam += this->m_SearchDirs[ lam ];
+
+  this->m_OffspringFailed[ lam ] = 0;
+  try
+  {
+    this->m_OffspringValues[ lam ] = this->GetScaledValue( x_lam );
+  }
+  catch( ExceptionObject & err )
+  {
+    this->m_OffspringFailed[ lam ] = 1;
+    this->m_OffspringErrors[ lam ] = err;
+  }
+
+}   // end EvaluateOffspringMember
+
+
+/**
+ * ****************** EvaluateOffspringThreaderCallback *********************
+ */
+
+ITK_THREAD_RETURN_TYPE
+CMAEvolutionStrategyOptimizer::EvaluateOffspringThreaderCallback( void * arg )
+{
+  ThreadInfoType *   infoStruct      = static_cast< ThreadInfoType * >( arg );
+  const ThreadIdType threadId        = infoStruct->ThreadID;
+  const ThreadIdType numberOfThreads = infoStruct->NumberOfThreads;
+  EvaluateOffspringThreaderParameterType * parameters
+    = static_cast< EvaluateOffspringThreaderParameterType * >( infoStruct->UserData );
+
+  /** Each thread evaluates every numberOfThreads-th member. */
+  const std::vector< unsigned int > & members = *parameters->m_Members;
+  for( std::size_t i = threadId; i < members.size(); i += numberOfThreads )
+  {
+    parameters->m_Optimizer->EvaluateOffspringMember( members[ i ] );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+}   // end EvaluateOffspringThreaderCallback
 
 
 /**
@@ -757,40 +920,117 @@ CMAEvolutionStrategyOptimizer::UpdateC( void )
   {
     oldCfactor += ( c_cov * c_c * ( 2.0 - c_c ) / mu_cov );
   }
-  this->m_C *= oldCfactor;
 
-  /** Do rank-one update */
-  const double rankonefactor = c_cov / mu_cov;
+  /** Store the weighted search directions of the parents in the columns
+   * of a matrix, so that the rank-mu update of an element reads two
+   * contiguous rows.
+   */
+  CovarianceMatrixType weightedSearchDirs( N, mu );
+  for( unsigned int m = 0; m < mu; ++m )
+  {
+    const unsigned int     lam        = this->m_CostFunctionValues[ m ].second;
+    const double           sqrtweight = vcl_sqrt( this->m_RecombinationWeights[ m ] );
+    const ParametersType & searchDir  = this->m_SearchDirs[ lam ];
+    for( unsigned int i = 0; i < N; ++i )
+    {
+      weightedSearchDirs[ i ][ m ] = searchDir[ i ] * ( sqrtweight / sigma );
+    }
+  }
+
+  /** Scale the old C, and do the rank-one and rank-mu updates, in a single
+   * pass over the upper triangle. Below 12 parameters, the matrix is too
+   * small to divide over the threads.
+   */
+  UpdateCThreaderParameterType parameters;
+  parameters.m_Optimizer          = this;
+  parameters.m_OldCFactor         = oldCfactor;
+  parameters.m_RankOneFactor      = c_cov / mu_cov;
+  parameters.m_RankMuFactor       = c_cov * ( 1.0 - 1.0 / mu_cov );
+  parameters.m_WeightedSearchDirs = &weightedSearchDirs;
+
+  const unsigned int minimumNumberOfParametersForThreads = 12;
+  if( this->m_UseMultiThread && N >= minimumNumberOfParametersForThreads )
+  {
+    PersistentThreadPool::Launch( this->m_Threader,
+      UpdateCThreaderCallback, &parameters );
+  }
+  else
+  {
+    this->ThreadedUpdateC( 0, 1, &parameters );
+  }
+
+  /** Copy the upper triangle to the lower triangle. */
   for( unsigned int i = 0; i < N; ++i )
   {
-    const double evolutionPath_i = this->m_EvolutionPath[ i ];
-    for( unsigned int j = 0; j < N; ++j )
+    for( unsigned int j = 0; j < i; ++j )
     {
-      const double update = rankonefactor * evolutionPath_i * this->m_EvolutionPath[ j ];
-      this->m_C[ i ][ j ] += update;
+      this->m_C[ i ][ j ] = this->m_C[ j ][ i ];
     }
   }
 
-  /** Do rank-mu update */
-  const double rankmufactor = c_cov * ( 1.0 - 1.0 / mu_cov );
-  for( unsigned int m = 0; m < mu; ++m )
+}   // end UpdateC
+
+
+/**
+ * ****************** ThreadedUpdateC *********************
+ */
+
+void
+CMAEvolutionStrategyOptimizer::ThreadedUpdateC( ThreadIdType threadId,
+  ThreadIdType numberOfThreads, const UpdateCThreaderParameterType * parameters )
+{
+  const unsigned int           N                  = this->m_C.rows();
+  const CovarianceMatrixType & weightedSearchDirs = *parameters->m_WeightedSearchDirs;
+  const unsigned int           mu                 = weightedSearchDirs.cols();
+  const double                 oldCfactor         = parameters->m_OldCFactor;
+  const double                 rankonefactor      = parameters->m_RankOneFactor;
+  const double                 rankmufactor       = parameters->m_RankMuFactor;
+
+  /** The rows are divided cyclically over the threads, because the rows
+   * of the upper triangle become shorter.
+   */
+  for( unsigned int i = threadId; i < N; i += numberOfThreads )
   {
-    const unsigned int lam               = this->m_CostFunctionValues[ m ].second;
-    const double       sqrtweight        = vcl_sqrt( this->m_RecombinationWeights[ m ] );
-    ParametersType     weightedSearchDir = this->m_SearchDirs[ lam ];
-    weightedSearchDir *= ( sqrtweight / sigma );
-    for( unsigned int i = 0; i < N; ++i )
+    const double   evolutionPath_i = this->m_EvolutionPath[ i ];
+    const double * y_i             = weightedSearchDirs[ i ];
+    double *       C_i             = this->m_C[ i ];
+    for( unsigned int j = i; j < N; ++j )
     {
-      const double weightedSearchDir_i = weightedSearchDir[ i ];
-      for( unsigned int j = 0; j < N; ++j )
+      const double * y_j = weightedSearchDirs[ j ];
+
+      /** Multiply old C with some factor, and do the rank-one update. */
+      double c_ij = C_i[ j ] * oldCfactor;
+      c_ij += rankonefactor * evolutionPath_i * this->m_EvolutionPath[ j ];
+
+      /** Do the rank-mu update */
+      for( unsigned int m = 0; m < mu; ++m )
       {
-        const double update = rankmufactor * weightedSearchDir_i * weightedSearchDir[ j ];
-        this->m_C[ i ][ j ] += update;
+        c_ij += rankmufactor * y_i[ m ] * y_j[ m ];
       }
+      C_i[ j ] = c_ij;
     }
-  }   // end for m
+  }
 
-}   // end UpdateC
+}   // end ThreadedUpdateC
+
+
+/**
+ * ****************** UpdateCThreaderCallback *********************
+ */
+
+ITK_THREAD_RETURN_TYPE
+CMAEvolutionStrategyOptimizer::UpdateCThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  const UpdateCThreaderParameterType * parameters
+    = static_cast< UpdateCThreaderParameterType * >( infoStruct->UserData );
+
+  parameters->m_Optimizer->ThreadedUpdateC(
+    infoStruct->ThreadID, infoStruct->NumberOfThreads, parameters );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+}   // end UpdateCThreaderCallback
 
 
 /**
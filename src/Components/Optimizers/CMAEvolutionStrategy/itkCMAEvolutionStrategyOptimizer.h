@@ -27,6 +27,8 @@
 #include "itkArray.h"
 #include "itkArray2D.h"
 #include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkMultiThreader.h"
+#include "itkPersistentThreadPool.h"
 #include "vnl/vnl_diag_matrix.h"
 
 namespace itk
@@ -43,6 +45,10 @@ namespace itk
  *   - See also the Matlab code, cmaes.m, which you can download from the
  *     website mentioned above.
  *
+ * The offspring of a generation can be evaluated concurrently, see
+ * SetEvaluatePopulationConcurrently(). The update of the covariance matrix
+ * is multi-threaded over its rows from 12 parameters on.
+ *
  * \ingroup Numerics Optimizers
  */
 
@@ -219,6 +225,30 @@ public:
   itkSetMacro( ValueTolerance, double );
   itkGetConstMacro( ValueTolerance, double );
 
+  /** Setting: evaluate the cost function for the members of the population
+   * concurrently. Only use this if the cost function can be evaluated for
+   * different parameters at the same time; this is not the case for the
+   * elastix metrics, which share one transform. The random numbers of the
+   * whole population are then drawn before the evaluation, so if the cost
+   * function fails for a member, its new search direction is drawn later
+   * than without concurrent evaluation.
+   * Default: false */
+  itkSetMacro( EvaluatePopulationConcurrently, bool );
+  itkGetConstMacro( EvaluatePopulationConcurrently, bool );
+  itkBooleanMacro( EvaluatePopulationConcurrently );
+
+  /** Set the number of threads. */
+  void SetNumberOfThreads( ThreadIdType numberOfThreads )
+  {
+    this->m_Threader->SetNumberOfThreads( numberOfThreads );
+  }
+
+
+  /** Setting: use multiple threads for the update of the covariance matrix.
+   * Default: true */
+  itkSetMacro( UseMultiThread, bool );
+  itkGetConstMacro( UseMultiThread, bool );
+
 protected:
 
   typedef Array< double >               RecombinationWeightsType;
@@ -236,6 +266,12 @@ protected:
   /** The random number generator used to generate the offspring. */
   RandomGeneratorType::Pointer m_RandomGenerator;
 
+  /** Typedefs for multi-threading. */
+  typedef MultiThreader                  ThreaderType;
+  typedef ThreaderType::ThreadInfoStruct ThreadInfoType;
+
+  ThreaderType::Pointer m_Threader;
+
   /** The value of the cost function at the current position */
   MeasureType m_CurrentValue;
 
@@ -358,6 +394,15 @@ protected:
    * and m_CostFunctionValues */
   virtual void GenerateOffspring( void );
 
+  /** Draw a new search direction for population member lam. */
+  virtual void DrawSearchDirection( unsigned int lam );
+
+  /** Evaluate the cost function for the given population members, and
+   * store the values in m_OffspringValues. Members for which the cost
+   * function throws are marked in m_OffspringFailed.
+   */
+  virtual void EvaluateOffspring( const std::vector< unsigned int > & members );
+
   /** Sort the m_CostFunctionValues vector and update m_MeasureHistory */
   virtual void SortCostFunctionValues( void );
 
@@ -405,6 +450,42 @@ protected:
    * \li Check if the value tolerance is satisfied.  */
   virtual bool TestConvergence( bool firstCheck );
 
+  /** The cost function values of the members of the population, and
+   * whether their evaluation failed. Not a vector of bools, because the
+   * threads write to it concurrently.
+   */
+  std::vector< MeasureType >     m_OffspringValues;
+  std::vector< unsigned char >   m_OffspringFailed;
+  std::vector< ExceptionObject > m_OffspringErrors;
+
+  /** The data shared by the threads. */
+  struct EvaluateOffspringThreaderParameterType
+  {
+    Self *                              m_Optimizer;
+    const std::vector< unsigned int > * m_Members;
+  };
+
+  struct UpdateCThreaderParameterType
+  {
+    Self *                       m_Optimizer;
+    double                       m_OldCFactor;
+    double                       m_RankOneFactor;
+    double                       m_RankMuFactor;
+    const CovarianceMatrixType * m_WeightedSearchDirs;
+  };
+
+  /** Evaluate the cost function for population member lam. */
+  void EvaluateOffspringMember( unsigned int lam );
+
+  /** Update the rows of the upper triangle of C that belong to a thread. */
+  void ThreadedUpdateC( ThreadIdType threadId, ThreadIdType numberOfThreads,
+    const UpdateCThreaderParameterType * parameters );
+
+  /** The callback functions for the threader. */
+  static ITK_THREAD_RETURN_TYPE EvaluateOffspringThreaderCallback( void * arg );
+
+  static ITK_THREAD_RETURN_TYPE UpdateCThreaderCallback( void * arg );
+
 private:
 
   CMAEvolutionStrategyOptimizer( const Self & ); // purposely not implemented
@@ -422,6 +503,8 @@ private:
   double        m_PositionToleranceMax;
   double        m_PositionToleranceMin;
   double        m_ValueTolerance;
+  bool          m_EvaluatePopulationConcurrently;
+  bool          m_UseMultiThread;
 
 };
 
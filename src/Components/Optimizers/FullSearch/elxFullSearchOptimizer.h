@@ -48,6 +48,11 @@ namespace elastix
  *   This varies the second transform parameter in the range [-4.0 3.0] with steps of 1.0
  *   and the third parameter in the range [-1.0 1.0] with steps of 0.5. The names are used
  *   as column headers in the screen output.
+ * \parameter FullSearchRefinementLevels: The number of times the grid is refined around
+ *    the best point, after the full range has been searched. Each refinement halves the
+ *    step sizes. The optimization surface image only contains the initial grid.\n
+ *    example: <tt>(FullSearchRefinementLevels 3)</tt> \n
+ *    Default value: 0. The parameter can be specified for each resolution.\n
  *
  * \ingroup Optimizers
  * \sa FullSearchOptimizer
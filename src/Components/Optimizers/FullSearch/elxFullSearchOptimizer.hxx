@@ -164,6 +164,12 @@ FullSearch< TElastix >
     }
   } // end while
 
+  /** Read the number of refinements of the grid. */
+  unsigned int numberOfRefinementLevels = 0;
+  this->m_Configuration->ReadParameter( numberOfRefinementLevels,
+    "FullSearchRefinementLevels", this->GetComponentLabel(), level, 0 );
+  this->SetNumberOfRefinementLevels( numberOfRefinementLevels );
+
   if( realGood )
   {
     /** The number of dimensions. */
@@ -198,6 +204,12 @@ FullSearch< TElastix >
       << "Total number of iterations needed in this resolution: "
       << this->GetNumberOfIterations()
       << "." << std::endl;
+    if( numberOfRefinementLevels > 0 )
+    {
+      elxout
+        << "The grid is refined " << numberOfRefinementLevels
+        << " times around the best point afterwards." << std::endl;
+    }
 
   }
   else
@@ -221,8 +233,12 @@ FullSearch< TElastix >
   /** Print some information. */
   xl::xout[ "iteration" ][ "2:Metric" ] << this->GetValue();
 
-  this->m_OptimizationSurface->SetPixel(
-    this->GetCurrentIndexInSearchSpace(), this->GetValue() );
+  /** The optimization surface only contains the initial grid. */
+  if( this->GetCurrentRefinementLevel() == 0 )
+  {
+    this->m_OptimizationSurface->SetPixel(
+      this->GetCurrentIndexInSearchSpace(), this->GetValue() );
+  }
 
   SearchSpacePointType currentPoint = this->GetCurrentPointInSearchSpace();
   unsigned int         nrOfSSDims   = currentPoint.GetSize();
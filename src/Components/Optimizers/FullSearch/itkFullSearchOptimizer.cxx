@@ -25,6 +25,8 @@
 #include "itkExceptionObject.h"
 #include "itkNumericTraits.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -45,10 +47,47 @@ FullSearchOptimizer
   m_NumberOfSearchSpaceDimensions = 0;
   m_SearchSpace                   = 0;
   m_LastSearchSpaceChanges        = 0;
+  m_NumberOfRefinementLevels      = 0;
+  m_CurrentRefinementLevel        = 0;
+  m_InitialSearchSpace            = 0;
+  m_FirstIterationOfCurrentGrid   = 0;
+  m_BlockBegin                    = 0;
+
+  /** The threads are taken from the PersistentThreadPool, if there is one. */
+  m_Threader = ThreaderType::New();
 
 }   //end constructor
 
 
+/**
+ * ********************* SetSearchSpace **************************
+ */
+void
+FullSearchOptimizer
+::SetSearchSpace( SearchSpaceType * searchSpace )
+{
+  /** A new search space is not refined. */
+  m_SearchSpace            = searchSpace;
+  m_InitialSearchSpace     = 0;
+  m_CurrentRefinementLevel = 0;
+  this->Modified();
+
+}   // end SetSearchSpace
+
+
+/**
+ * ****************** SetConcurrentCostFunctions ******************
+ */
+void
+FullSearchOptimizer
+::SetConcurrentCostFunctions( const CostFunctionContainerType & costFunctions )
+{
+  m_ConcurrentCostFunctions = costFunctions;
+  this->Modified();
+
+}   // end SetConcurrentCostFunctions
+
+
 /**
  * ***************** Start the optimization **********************
  */
@@ -61,6 +100,17 @@ FullSearchOptimizer
 
   m_CurrentIteration = 0;
 
+  /** Start from the initial grid, if a previous run refined it. */
+  if( m_InitialSearchSpace.IsNotNull() )
+  {
+    m_SearchSpace            = m_InitialSearchSpace;
+    m_InitialSearchSpace     = 0;
+    m_LastSearchSpaceChanges = 0;
+  }
+  m_CurrentRefinementLevel      = 0;
+  m_FirstIterationOfCurrentGrid = 0;
+  m_BlockValues.clear();
+
   this->ProcessSearchSpaceChanges();
 
   m_CurrentIndexInSearchSpace.Fill( 0 );
@@ -103,7 +153,25 @@ FullSearchOptimizer
 
     try
     {
-      m_Value = m_CostFunction->GetValue( this->GetCurrentPosition() );
+      if( m_ConcurrentCostFunctions.empty() )
+      {
+        m_Value = m_CostFunction->GetValue( this->GetCurrentPosition() );
+      }
+      else
+      {
+        /** Take the value from the block of concurrently evaluated points. */
+        const unsigned long gridIteration = m_CurrentIteration - m_FirstIterationOfCurrentGrid;
+        if( gridIteration < m_BlockBegin || gridIteration >= m_BlockBegin + m_BlockValues.size() )
+        {
+          this->EvaluateBlock( gridIteration );
+        }
+        const unsigned long blockIteration = gridIteration - m_BlockBegin;
+        if( !m_BlockErrors[ blockIteration ].empty() )
+        {
+          itkExceptionMacro( << m_BlockErrors[ blockIteration ] );
+        }
+        m_Value = m_BlockValues[ blockIteration ];
+      }
     }
     catch( ExceptionObject & err )
     {
@@ -121,12 +189,17 @@ FullSearchOptimizer
       break;
     }
 
-    /** Check if the value is a minimum or maximum */
+    /** Check if the value is a minimum or maximum. The best index
+     * refers to the initial grid.
+     */
     if( ( m_Value < m_BestValue )  ^  m_Maximize )         // ^ = xor, yields true if only one of the expressions is true
     {
       m_BestValue              = m_Value;
       m_BestPointInSearchSpace = m_CurrentPointInSearchSpace;
-      m_BestIndexInSearchSpace = m_CurrentIndexInSearchSpace;
+      if( m_CurrentRefinementLevel == 0 )
+      {
+        m_BestIndexInSearchSpace = m_CurrentIndexInSearchSpace;
+      }
     }
 
     this->InvokeEvent( IterationEvent() );
@@ -134,8 +207,15 @@ FullSearchOptimizer
     /** Prepare for next step */
     m_CurrentIteration++;
 
-    if( m_CurrentIteration >= this->GetNumberOfIterations() )
+    if( m_CurrentIteration - m_FirstIterationOfCurrentGrid >= this->GetNumberOfIterations() )
     {
+      /** Continue with a finer grid, or stop. */
+      if( m_CurrentRefinementLevel < m_NumberOfRefinementLevels )
+      {
+        this->RefineSearchSpace();
+        continue;
+      }
+
       m_StopCondition = FullRangeSearched;
       StopOptimization();
       break;
@@ -149,6 +229,163 @@ FullSearchOptimizer
 }   //end function ResumeOptimization
 
 
+/**
+ * ********************* RefineSearchSpace ***********************
+ */
+void
+FullSearchOptimizer
+::RefineSearchSpace( void )
+{
+  itkDebugMacro( "RefineSearchSpace" );
+
+  if( m_CurrentRefinementLevel == 0 )
+  {
+    m_InitialSearchSpace = m_SearchSpace;
+  }
+
+  /** Halve the steps, and search one new step around the best point,
+   * within the initial ranges.
+   */
+  SearchSpacePointer      refinedSearchSpace = SearchSpaceType::New();
+  SearchSpaceIteratorType it( m_SearchSpace->Begin() );
+  SearchSpaceIteratorType initialIt( m_InitialSearchSpace->Begin() );
+  for( unsigned int ssdim = 0; ssdim < m_NumberOfSearchSpaceDimensions; ssdim++ )
+  {
+    const RangeType &    range        = it.Value();
+    const RangeType &    initialRange = initialIt.Value();
+    const RangeValueType step         = range[ 2 ] / 2.0;
+    const RangeValueType best         = m_BestPointInSearchSpace[ ssdim ];
+
+    RangeType refinedRange;
+    refinedRange[ 0 ] = std::max( best - step, initialRange[ 0 ] );
+    refinedRange[ 1 ] = std::min( best + step, initialRange[ 1 ] );
+    refinedRange[ 2 ] = step;
+    refinedSearchSpace->InsertElement( it.Index(), refinedRange );
+
+    it++;
+    initialIt++;
+  }
+
+  /** Go to the first point of the new grid. */
+  m_SearchSpace = refinedSearchSpace;
+  m_CurrentRefinementLevel++;
+  m_FirstIterationOfCurrentGrid = m_CurrentIteration;
+  m_BlockValues.clear();
+  this->ProcessSearchSpaceChanges();
+
+  m_CurrentIndexInSearchSpace.Fill( 0 );
+  m_CurrentPointInSearchSpace = this->IndexToPoint( m_CurrentIndexInSearchSpace );
+  this->SetCurrentPosition( this->PointToPosition( m_CurrentPointInSearchSpace ) );
+
+}   // end RefineSearchSpace
+
+
+/**
+ * ********************* GridIterationToIndex ********************
+ */
+FullSearchOptimizer::SearchSpaceIndexType
+FullSearchOptimizer
+::GridIterationToIndex( unsigned long gridIteration )
+{
+  /** The first dimension runs fastest, see UpdateCurrentPosition(). */
+  const unsigned int          searchSpaceDimension = this->GetNumberOfSearchSpaceDimensions();
+  const SearchSpaceSizeType & searchSpaceSize      = this->GetSearchSpaceSize();
+  SearchSpaceIndexType        index( searchSpaceDimension );
+  for( unsigned int ssdim = 0; ssdim < searchSpaceDimension; ssdim++ )
+  {
+    index[ ssdim ]  = static_cast< IndexValueType >( gridIteration % searchSpaceSize[ ssdim ] );
+    gridIteration  /= searchSpaceSize[ ssdim ];
+  }
+
+  return index;
+
+}   // end GridIterationToIndex
+
+
+/**
+ * ************************ EvaluateBlock ************************
+ */
+void
+FullSearchOptimizer
+::EvaluateBlock( unsigned long gridIteration )
+{
+  /** A block has some points per thread, so that the threads are
+   * started not too often, and the memory stays small.
+   */
+  const unsigned long numberOfThreads = m_ConcurrentCostFunctions.size() + 1;
+  const unsigned long blockSize       = std::min( 64 * numberOfThreads,
+    this->GetNumberOfIterations() - gridIteration );
+
+  /** Compute the positions beforehand, since converting an index to a
+   * position is not thread-safe.
+   */
+  m_BlockBegin = gridIteration;
+  m_BlockPositions.resize( blockSize );
+  for( unsigned long i = 0; i < blockSize; ++i )
+  {
+    m_BlockPositions[ i ] = this->IndexToPosition(
+      this->GridIterationToIndex( gridIteration + i ) );
+  }
+  m_BlockValues.assign( blockSize, NumericTraits< MeasureType >::Zero );
+  m_BlockErrors.assign( blockSize, std::string() );
+
+  m_Threader->SetNumberOfThreads( static_cast< ThreadIdType >( numberOfThreads ) );
+  PersistentThreadPool::Launch( m_Threader, EvaluateBlockThreaderCallback, this );
+
+}   // end EvaluateBlock
+
+
+/**
+ * ******************* ThreadedEvaluateBlock *********************
+ */
+void
+FullSearchOptimizer
+::ThreadedEvaluateBlock( ThreadIdType threadId, ThreadIdType numberOfThreads )
+{
+  /** Thread 0 uses the cost function, the others a copy. */
+  const CostFunctionType * costFunction = threadId == 0
+    ? m_CostFunction.GetPointer()
+    : m_ConcurrentCostFunctions[ threadId - 1 ].GetPointer();
+
+  /** Errors are reported when the point is processed. */
+  for( std::size_t i = threadId; i < m_BlockValues.size(); i += numberOfThreads )
+  {
+    try
+    {
+      m_BlockValues[ i ] = costFunction->GetValue( m_BlockPositions[ i ] );
+    }
+    catch( ExceptionObject & err )
+    {
+      m_BlockErrors[ i ] = err.GetDescription();
+    }
+  }
+
+}   // end ThreadedEvaluateBlock
+
+
+/**
+ * *************** EvaluateBlockThreaderCallback *****************
+ */
+ITK_THREAD_RETURN_TYPE
+FullSearchOptimizer
+::EvaluateBlockThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  Self *           optimizer  = static_cast< Self * >( infoStruct->UserData );
+
+  /** The threader may have fewer threads than cost functions. */
+  const ThreadIdType numberOfThreads = std::min( infoStruct->NumberOfThreads,
+    static_cast< ThreadIdType >( optimizer->m_ConcurrentCostFunctions.size() + 1 ) );
+  if( infoStruct->ThreadID < numberOfThreads )
+  {
+    optimizer->ThreadedEvaluateBlock( infoStruct->ThreadID, numberOfThreads );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+}   // end EvaluateBlockThreaderCallback
+
+
 /**
  * ************************** Stop optimization ******************
  */
@@ -275,7 +512,9 @@ FullSearchOptimizer
     for( unsigned int ssdim = 0; ssdim < m_NumberOfSearchSpaceDimensions; ssdim++ )
     {
       RangeType range = it.Value();
-      m_SearchSpaceSize[ ssdim ] = static_cast< unsigned long >( ( range[ 1 ] - range[ 0 ] ) / range[ 2 ] ) + 1;
+      /** A small tolerance, so that the maximum is included despite rounding errors. */
+      m_SearchSpaceSize[ ssdim ] = static_cast< unsigned long >(
+        ( range[ 1 ] - range[ 0 ] ) / range[ 2 ] + 1e-6 ) + 1;
       it++;
     }
 
@@ -300,6 +539,9 @@ FullSearchOptimizer
   RangeValueType maximum,
   RangeValueType step )
 {
+  /** Change the initial grid, if a previous run refined it. */
+  this->ResetRefinedSearchSpace();
+
   if( !m_SearchSpace )
   {
     m_SearchSpace = SearchSpaceType::New();
@@ -316,6 +558,7 @@ FullSearchOptimizer
 
   /** Insert the new range specification */
   m_SearchSpace->InsertElement( param_nr, range );
+  this->Modified();
 }
 
 
@@ -328,13 +571,37 @@ void
 FullSearchOptimizer
 ::RemoveSearchDimension( unsigned int param_nr )
 {
+  /** Change the initial grid, if a previous run refined it. */
+  this->ResetRefinedSearchSpace();
+
   if( m_SearchSpace )
   {
     m_SearchSpace->DeleteIndex( param_nr );
+    this->Modified();
   }
 }
 
 
+/**
+ * ****************** ResetRefinedSearchSpace *******************
+ *
+ * Go back to the initial grid and refinement level, like SetSearchSpace()
+ */
+void
+FullSearchOptimizer
+::ResetRefinedSearchSpace( void )
+{
+  if( m_InitialSearchSpace.IsNotNull() )
+  {
+    m_SearchSpace            = m_InitialSearchSpace;
+    m_LastSearchSpaceChanges = 0;
+  }
+  m_InitialSearchSpace     = 0;
+  m_CurrentRefinementLevel = 0;
+
+}   // end ResetRefinedSearchSpace
+
+
 /**
  * ***************** GetNumberOfIterations **********************
  *
@@ -24,6 +24,10 @@
 #include "itkImage.h"
 #include "itkArray.h"
 #include "itkFixedArray.h"
+#include "itkMultiThreader.h"
+#include "itkPersistentThreadPool.h"
+
+#include <vector>
 
 namespace itk
 {
@@ -35,6 +39,15 @@ namespace itk
  * Optimizer that scans a subspace of the parameter space
  * and searches for the best parameters.
  *
+ * After the full range has been searched, the grid can be refined around
+ * the best point a number of times, see SetNumberOfRefinementLevels().
+ *
+ * If copies of the cost function are given that can be evaluated at the
+ * same time as the cost function, for example metrics with their own
+ * transform, the grid points are evaluated concurrently in blocks, one
+ * thread per cost function. The events and results are the same as in a
+ * serial search.
+ *
  * \todo This optimizer has similar functionality as the recently added
  * itkExhaustiveOptimizer. See if we can replace it by that optimizer,
  * or inherit from it.
@@ -145,7 +158,8 @@ public:
    * Instead of using this function, the Add/RemoveSearchDimension methods can be used,
    * to define a search space.
    */
-  itkSetObjectMacro( SearchSpace, SearchSpaceType );
+  virtual void SetSearchSpace( SearchSpaceType * searchSpace );
+
   itkGetObjectMacro( SearchSpace, SearchSpaceType );
 
   /** Add/Remove a dimension to/from the SearchSpace */
@@ -191,6 +205,32 @@ public:
   /** Get Stop condition. */
   itkGetConstMacro( StopCondition, StopConditionType );
 
+  /** Set/Get the number of times the grid is refined, after the full range
+   * has been searched. Each refinement halves the step sizes, and searches
+   * the points within one new step of the best point, within the initial
+   * ranges. During the refinements the search space is replaced; the best
+   * index refers to the initial grid. Default: 0.
+   */
+  itkSetMacro( NumberOfRefinementLevels, unsigned int );
+  itkGetConstMacro( NumberOfRefinementLevels, unsigned int );
+
+  /** Get the current refinement level; 0 while the initial grid is searched. */
+  itkGetConstMacro( CurrentRefinementLevel, unsigned int );
+
+  /** Set/Get copies of the cost function, which are used by additional
+   * threads. They should compute the same as the cost function, and it
+   * should be possible to evaluate them at the same time as the cost
+   * function and each other. Default: none, so the search is serial.
+   */
+  typedef std::vector< CostFunctionPointer > CostFunctionContainerType;
+  virtual void SetConcurrentCostFunctions( const CostFunctionContainerType & costFunctions );
+
+  const CostFunctionContainerType & GetConcurrentCostFunctions( void ) const
+  {
+    return this->m_ConcurrentCostFunctions;
+  }
+
+
 protected:
 
   FullSearchOptimizer();
@@ -215,6 +255,41 @@ protected:
   unsigned long m_LastSearchSpaceChanges;
   virtual void ProcessSearchSpaceChanges( void );
 
+  /** Refinement of the grid. */
+  unsigned int       m_NumberOfRefinementLevels;
+  unsigned int       m_CurrentRefinementLevel;
+  SearchSpacePointer m_InitialSearchSpace;
+  unsigned long      m_FirstIterationOfCurrentGrid;
+
+  /** Replace the search space by a finer grid around the best point. */
+  virtual void RefineSearchSpace( void );
+
+  /** Go back to the initial grid, if it was refined. */
+  void ResetRefinedSearchSpace( void );
+
+  /** Convert the number of a point in the grid to an index. */
+  virtual SearchSpaceIndexType GridIterationToIndex( unsigned long gridIteration );
+
+  /** Concurrent evaluation. */
+  typedef MultiThreader                  ThreaderType;
+  typedef ThreaderType::ThreadInfoStruct ThreadInfoType;
+
+  CostFunctionContainerType     m_ConcurrentCostFunctions;
+  ThreaderType::Pointer         m_Threader;
+  unsigned long                 m_BlockBegin;
+  std::vector< MeasureType >    m_BlockValues;
+  std::vector< ParametersType > m_BlockPositions;
+  std::vector< std::string >    m_BlockErrors;
+
+  /** Evaluate the block of grid points that starts at gridIteration. */
+  virtual void EvaluateBlock( unsigned long gridIteration );
+
+  /** Evaluate the points of the block that belong to a thread. */
+  void ThreadedEvaluateBlock( ThreadIdType threadId, ThreadIdType numberOfThreads );
+
+  /** The callback function for the threader. */
+  static ITK_THREAD_RETURN_TYPE EvaluateBlockThreaderCallback( void * arg );
+
 private:
 
   FullSearchOptimizer( const Self & ); // purposely not implemented
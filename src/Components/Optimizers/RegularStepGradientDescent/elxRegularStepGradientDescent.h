@@ -117,6 +117,10 @@ public:
 
   virtual void AfterRegistration( void );
 
+  /** Provide the values of the current iteration to the iteration telemetry. */
+  virtual void GetIterationTelemetry( double & value, double & stepSize,
+    double & gradientMagnitude ) const;
+
   /** Override the SetInitialPosition.
    * Override the implementation in itkOptimizer.h, to
    * ensure that the scales array and the parameters
@@ -113,6 +113,23 @@ RegularStepGradientDescent< TElastix >
 }   // end AfterEachIteration
 
 
+/**
+ * ***************** GetIterationTelemetry ***************************
+ */
+
+template< class TElastix >
+void
+RegularStepGradientDescent< TElastix >
+::GetIterationTelemetry( double & value, double & stepSize,
+  double & gradientMagnitude ) const
+{
+  value             = this->GetValue();
+  stepSize          = this->GetCurrentStepLength();
+  gradientMagnitude = this->GetGradient().magnitude();
+
+} // end GetIterationTelemetry()
+
+
 /**
  * ***************** AfterEachResolution *************************
  */
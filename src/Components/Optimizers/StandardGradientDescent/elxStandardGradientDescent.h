@@ -121,6 +121,10 @@ public:
 
   virtual void AfterRegistration( void );
 
+  /** Provide the values of the current iteration to the iteration telemetry. */
+  virtual void GetIterationTelemetry( double & value, double & stepSize,
+    double & gradientMagnitude ) const;
+
   /** Check if any scales are set, and set the UseScales flag on or off;
   * after that call the superclass' implementation */
   virtual void StartOptimization( void );
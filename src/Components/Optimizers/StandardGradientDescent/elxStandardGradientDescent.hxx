@@ -120,10 +120,13 @@ void
 StandardGradientDescent< TElastix >
 ::AfterEachIteration( void )
 {
-  /** Print some information */
-  xl::xout[ "iteration" ][ "2:Metric" ] << this->GetValue();
-  xl::xout[ "iteration" ][ "3:StepSize" ] << this->GetLearningRate();
-  xl::xout[ "iteration" ][ "4:||Gradient||" ] << this->GetGradient().magnitude();
+  /** Print some information, unless the iteration table is not written. */
+  if( this->GetElastix()->GetWriteIterationInfo() )
+  {
+    xl::xout[ "iteration" ][ "2:Metric" ] << this->GetValue();
+    xl::xout[ "iteration" ][ "3:StepSize" ] << this->GetLearningRate();
+    xl::xout[ "iteration" ][ "4:||Gradient||" ] << this->GetGradient().magnitude();
+  }
 
   /** Select new spatial samples for the computation of the metric */
   if( this->GetNewSamplesEveryIteration() )
@@ -134,6 +137,23 @@ StandardGradientDescent< TElastix >
 }   // end AfterEachIteration()
 
 
+/**
+ * ***************** GetIterationTelemetry ***************************
+ */
+
+template< class TElastix >
+void
+StandardGradientDescent< TElastix >
+::GetIterationTelemetry( double & value, double & stepSize,
+  double & gradientMagnitude ) const
+{
+  value             = this->GetValue();
+  stepSize          = this->GetLearningRate();
+  gradientMagnitude = this->GetGradient().magnitude();
+
+} // end GetIterationTelemetry()
+
+
 /**
  * ***************** AfterEachResolution *************************
  */
@@ -58,6 +58,9 @@ GradientDescentOptimizer2
 #endif
   this->m_UseEigen       = false;
 
+  /** The threads are taken from the PersistentThreadPool, if there is one.
+   * The ITK thread pool is not used, see AdvancedImageToImageMetric.
+   */
   //this->m_Threader->SetUseThreadPool( true );
 
 } // end Constructor
@@ -297,8 +300,8 @@ GradientDescentOptimizer2
     temp->t_Optimizer   = this;
 
     /** Call multi-threaded AdvanceOneStep(). */
-    this->m_Threader->SetSingleMethod( AdvanceOneStepThreaderCallback, (void *)( temp ) );
-    this->m_Threader->SingleMethodExecute();
+    PersistentThreadPool::Launch( this->m_Threader,
+      AdvanceOneStepThreaderCallback, (void *)( temp ) );
 
     delete temp;
   }
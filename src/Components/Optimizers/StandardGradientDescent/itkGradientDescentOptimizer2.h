@@ -20,6 +20,7 @@
 
 #include "itkScaledSingleValuedNonLinearOptimizer.h"
 #include "itkMultiThreader.h"
+#include "itkPersistentThreadPool.h"
 
 namespace itk
 {
@@ -126,29 +126,46 @@ void
 MultiMetricMultiResolutionRegistration< TElastix >
 ::AfterEachIteration( void )
 {
-  /** Print the submetric values and gradients to xout["iteration"]. */
+  /** Print the submetric values and gradients to xout["iteration"],
+   * unless the iteration table is not written.
+   */
   const unsigned int nrOfMetrics = this->GetCombinationMetric()->GetNumberOfMetrics();
   unsigned int       width       = 0;
   for( unsigned int i = nrOfMetrics; i > 0; i /= 10 )
   {
     width++;
   }
-  for( unsigned int i = 0; i < nrOfMetrics; ++i )
+  if( this->GetElastix()->GetWriteIterationInfo() )
   {
-    std::ostringstream makestring1;
-    makestring1 << "2:Metric" << std::setfill( '0' ) << std::setw( width ) << i;
-    xl::xout[ "iteration" ][ makestring1.str().c_str() ]
-      << this->GetCombinationMetric()->GetMetricValue( i );
-
-    std::ostringstream makestring2;
-    makestring2 << "4:||Gradient" << std::setfill( '0' ) << std::setw( width ) << i << "||";
-    xl::xout[ "iteration" ][ makestring2.str().c_str() ]
-      << this->GetCombinationMetric()->GetMetricDerivativeMagnitude( i );
+    for( unsigned int i = 0; i < nrOfMetrics; ++i )
+    {
+      std::ostringstream makestring1;
+      makestring1 << "2:Metric" << std::setfill( '0' ) << std::setw( width ) << i;
+      xl::xout[ "iteration" ][ makestring1.str().c_str() ]
+        << this->GetCombinationMetric()->GetMetricValue( i );
+
+      std::ostringstream makestring2;
+      makestring2 << "4:||Gradient" << std::setfill( '0' ) << std::setw( width ) << i << "||";
+      xl::xout[ "iteration" ][ makestring2.str().c_str() ]
+        << this->GetCombinationMetric()->GetMetricDerivativeMagnitude( i );
+
+      std::ostringstream makestring3;
+      makestring3 << "Time" << std::setfill( '0' ) << std::setw( width ) << i << "[ms]";
+      xl::xout[ "iteration" ][ makestring3.str().c_str() ]
+        << this->GetCombinationMetric()->GetMetricComputationTime( i );
+    }
+  }
 
-    std::ostringstream makestring3;
-    makestring3 << "Time" << std::setfill( '0' ) << std::setw( width ) << i << "[ms]";
-    xl::xout[ "iteration" ][ makestring3.str().c_str() ]
-      << this->GetCombinationMetric()->GetMetricComputationTime( i );
+  /** Report how the threads are divided over the metrics. */
+  if( this->m_Elastix->GetIterationCounter() == 0
+    && this->GetCombinationMetric()->GetEvaluateMetricsConcurrently() )
+  {
+    elxout << "  The metrics are evaluated concurrently, with threads:";
+    for( unsigned int i = 0; i < nrOfMetrics; ++i )
+    {
+      elxout << " " << this->GetCombinationMetric()->GetNumberOfThreadsPerMetric( i );
+    }
+    elxout << std::endl;
   }
 
   if( this->m_ShowExactMetricValue )
@@ -20,6 +20,9 @@
 
 #include "itkAdvancedImageToImageMetric.h"
 #include "itkSingleValuedPointSetToPointSetMetric.h"
+#include "itkPersistentThreadPool.h"
+
+#include <string>
 
 namespace itk
 {
@@ -50,6 +53,26 @@ namespace itk
  * why we chose to reimplement the Get{Transform,Interpolator}()
  * methods.
  *
+ * With UseMultiThread the sub-metrics are evaluated concurrently. The
+ * non thread-safe parts, like updating the image samplers, are done for
+ * all metrics first, after which the parameters of the shared transform
+ * are frozen. The threads of this metric are divided over the image
+ * metrics, proportional to their computation time in the previous
+ * resolution, so that the metrics together use as many threads as a single
+ * metric would. The derivatives are combined multi-threadedly as well.
+ * The metrics are evaluated one after another if the transform is not an
+ * AdvancedCombinationTransform, if the metrics do not share the transform,
+ * if they share an image sampler, or if a metric does not support it; see
+ * AdvancedImageToImageMetric::ConcurrentEvaluationSupported().
+ *
+ * Metrics that share the image sampler and the transform also share one
+ * TransformEvaluationCache, if they use it, so that the samples are mapped
+ * only once per iteration. Since a shared sampler rules out the concurrent
+ * evaluation, the cache and the concurrency exclude each other. The cache
+ * pays off when mapping the samples dominates the cost of the metrics, like
+ * for a B-spline transform with a few cheap metrics; otherwise separate
+ * samplers with concurrent evaluation are faster.
+ *
  *
  * \ingroup RegistrationMetrics
  *
@@ -112,6 +135,7 @@ public:
   typedef typename Superclass::DerivativeType             DerivativeType;
   typedef typename Superclass::DerivativeValueType        DerivativeValueType;
   typedef typename Superclass::ParametersType             ParametersType;
+  typedef typename Superclass::CombinationTransformType   CombinationTransformType;
 
   /** Some typedefs for computing the SelfHessian */
   typedef typename Superclass::HessianValueType HessianValueType;
@@ -202,6 +226,17 @@ public:
 
   /** \todo: Temporary, should think about interface. */
   itkSetMacro( UseMultiThread, bool );
+  itkGetConstMacro( UseMultiThread, bool );
+
+  /** Get whether the metrics are evaluated concurrently. Determined in
+   * Initialize().
+   */
+  itkGetConstMacro( EvaluateMetricsConcurrently, bool );
+
+  /** Get the number of threads of metric pos, when the metrics are
+   * evaluated concurrently.
+   */
+  ThreadIdType GetNumberOfThreadsPerMetric( unsigned int pos ) const;
 
   /** Select which metrics are used.
    * This is useful in case you want to compute a certain measure, but not
@@ -450,6 +485,26 @@ private:
    */
   double GetFinalMetricWeight( unsigned int pos ) const;
 
+  /** Check whether the metrics can be evaluated concurrently. */
+  virtual bool CheckConcurrentEvaluation( void ) const;
+
+  /** Divide the threads of this metric over the image metrics, based on
+   * the last computation times. Each image metric gets at least one thread.
+   */
+  virtual void ComputeNumberOfThreadsPerMetric( void );
+
+  /** Let the image metrics that use the transform evaluation cache and
+   * share an image sampler also share the cache, so that the samples are
+   * mapped only once per iteration.
+   */
+  virtual void ShareTransformEvaluationCaches( void );
+
+  /** Likewise, let the image metrics that use the B-spline support cache
+   * and share an image sampler also share that cache. Other metrics each
+   * keep their own cache, since they sample other points.
+   */
+  virtual void ShareBSplineSupportCaches( void );
+
   /** For threading: store thread data. */
   struct MultiThreaderComboMetricsType
   {
@@ -457,6 +512,7 @@ private:
     typename std::vector< MeasureType >::iterator st_MetricValuesIterator;
     typename std::vector< DerivativeType >::iterator st_MetricDerivativesIterator;
     std::vector< double > st_MetricComputationTime;
+    std::vector< std::string > st_ExceptionDescriptions;
     ParametersType *           st_Parameters;
   };
 
@@ -469,6 +525,10 @@ private:
 
   bool m_UseMultiThread;
 
+  /** Settings for the concurrent evaluation of the metrics. */
+  bool                        m_EvaluateMetricsConcurrently;
+  std::vector< ThreadIdType > m_NumberOfThreadsPerMetric;
+
 };
 
 } // end namespace itk
@@ -22,6 +22,9 @@
 #include "itkTimeProbe.h"
 #include "itkMath.h"
 
+#include <algorithm>
+#include <exception>
+
 
 /** Macros to reduce some copy-paste work.
  * These macros provide the implementation of
@@ -165,7 +168,8 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
   this->m_UseRelativeWeights = false;
   this->ComputeGradientOff();
 
-  this->m_UseMultiThread = true;
+  this->m_UseMultiThread              = true;
+  this->m_EvaluateMetricsConcurrently = false;
 
 } // end Constructor
 
@@ -195,7 +199,11 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
     os << indent << "MetricDerivativesMagnitude: "  << this->m_MetricDerivativesMagnitude[ i ] << "\n";
     os << indent << "UseMetric: " << ( this->m_UseMetric[ i ] ? "true\n" : "false\n" );
     os << indent << "MetricComputationTime: " << this->m_MetricComputationTime[ i ] << "\n";
+    os << indent << "NumberOfThreadsPerMetric: " << this->GetNumberOfThreadsPerMetric( i ) << "\n";
   }
+  os << "UseMultiThread: " << ( this->m_UseMultiThread ? "true\n" : "false\n" );
+  os << "EvaluateMetricsConcurrently: "
+     << ( this->m_EvaluateMetricsConcurrently ? "true\n" : "false\n" );
 
 } // end PrintSelf()
 
@@ -283,6 +291,7 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
     this->m_MetricDerivatives.resize( count );
     this->m_MetricDerivativesMagnitude.resize( count );
     this->m_MetricComputationTime.resize( count );
+    this->m_NumberOfThreadsPerMetric.resize( count, 1 );
     this->Modified();
   }
 
@@ -618,7 +627,7 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
     itkExceptionMacro( << "At least one metric should be set!" );
   }
 
-  /** Call Initialize for all metrics. */
+  /** Check if all metrics are set. */
   for( unsigned int i = 0; i < this->GetNumberOfMetrics(); i++ )
   {
     SingleValuedCostFunctionType * costfunc = this->GetMetric( i );
@@ -626,13 +635,37 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
     {
       itkExceptionMacro( << "Metric " << i << " has not been set!" );
     }
+  }
+
+  /** Decide whether the metrics are evaluated concurrently, and if so,
+   * divide the threads over them before they are initialized, since the
+   * metrics allocate their per-thread variables in Initialize().
+   */
+  const bool evaluateMetricsConcurrently
+    = this->m_UseMultiThread && this->CheckConcurrentEvaluation();
+  if( evaluateMetricsConcurrently )
+  {
+    this->ComputeNumberOfThreadsPerMetric();
+  }
+  this->m_EvaluateMetricsConcurrently = evaluateMetricsConcurrently;
+
+  /** Share the transform evaluation caches, before the metrics create
+   * their own in Initialize().
+   */
+  this->ShareTransformEvaluationCaches();
+  this->ShareBSplineSupportCaches();
+
+  /** Call Initialize for all metrics. */
+  for( unsigned int i = 0; i < this->GetNumberOfMetrics(); i++ )
+  {
     ImageMetricType *    testPtr1 = dynamic_cast< ImageMetricType * >( this->GetMetric( i ) );
     PointSetMetricType * testPtr2 = dynamic_cast< PointSetMetricType * >( this->GetMetric( i ) );
     if( testPtr1 )
     {
       // The NumberOfThreadsPerMetric is changed after Initialize() so we save it before and then
       // set it on.
-      unsigned nrOfThreadsPerMetric = this->GetNumberOfThreads();
+      const ThreadIdType nrOfThreadsPerMetric = this->GetNumberOfThreadsPerMetric( i );
+      testPtr1->SetNumberOfThreads( nrOfThreadsPerMetric );
       testPtr1->Initialize();
       testPtr1->SetNumberOfThreads( nrOfThreadsPerMetric );
     }
@@ -645,6 +678,279 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
 } // end Initialize()
 
 
+/**
+ * ******************* CheckConcurrentEvaluation *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+bool
+CombinationImageToImageMetric< TFixedImage, TMovingImage >
+::CheckConcurrentEvaluation( void ) const
+{
+  if( this->GetNumberOfMetrics() < 2 )
+  {
+    return false;
+  }
+
+  /** The parameters of the shared transform are frozen during the
+   * evaluation, which is only possible for an AdvancedCombinationTransform.
+   */
+  const TransformType * transform = this->GetTransform( 0 );
+  if( dynamic_cast< const CombinationTransformType * >( transform ) == 0 )
+  {
+    return false;
+  }
+
+  typedef typename ImageMetricType::ImageSamplerType MetricImageSamplerType;
+  std::vector< const MetricImageSamplerType * > samplers;
+  for( unsigned int i = 0; i < this->GetNumberOfMetrics(); i++ )
+  {
+    /** All metrics should use the frozen transform. */
+    if( this->GetTransform( i ) != transform )
+    {
+      return false;
+    }
+
+    /** An image sampler is updated by each metric that uses it, so it
+     * should not be shared.
+     */
+    const ImageMetricType * testPtr1 = dynamic_cast< const ImageMetricType * >( this->GetMetric( i ) );
+    if( testPtr1 )
+    {
+      if( !testPtr1->ConcurrentEvaluationSupported() )
+      {
+        return false;
+      }
+      if( testPtr1->GetUseImageSampler() )
+      {
+        const MetricImageSamplerType * sampler = testPtr1->GetImageSampler();
+        if( std::find( samplers.begin(), samplers.end(), sampler ) != samplers.end() )
+        {
+          return false;
+        }
+        samplers.push_back( sampler );
+      }
+    }
+  }
+
+  return true;
+
+} // end CheckConcurrentEvaluation()
+
+
+/**
+ * ******************* ShareTransformEvaluationCaches *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+CombinationImageToImageMetric< TFixedImage, TMovingImage >
+::ShareTransformEvaluationCaches( void )
+{
+  typedef typename ImageMetricType::ImageSamplerType             MetricImageSamplerType;
+  typedef typename ImageMetricType::TransformEvaluationCacheType TransformEvaluationCacheType;
+
+  /** Collect the image metrics that use the cache. */
+  std::vector< ImageMetricType * > metrics;
+  for( unsigned int i = 0; i < this->GetNumberOfMetrics(); i++ )
+  {
+    ImageMetricType * testPtr1 = dynamic_cast< ImageMetricType * >( this->GetMetric( i ) );
+    if( testPtr1 )
+    {
+      /** Let each metric create its own cache, unless it is shared below. */
+      testPtr1->SetTransformEvaluationCache( 0 );
+      if( testPtr1->GetUseTransformEvaluationCache() && testPtr1->GetUseImageSampler() )
+      {
+        metrics.push_back( testPtr1 );
+      }
+    }
+  }
+
+  /** Metrics with the same sampler and transform map the same points. */
+  std::vector< bool > done( metrics.size(), false );
+  for( std::size_t i = 0; i < metrics.size(); ++i )
+  {
+    if( done[ i ] )
+    {
+      continue;
+    }
+
+    const MetricImageSamplerType * sampler   = metrics[ i ]->GetImageSampler();
+    const TransformType *          transform = metrics[ i ]->GetTransform();
+    std::vector< ImageMetricType * > group( 1, metrics[ i ] );
+    for( std::size_t j = i + 1; j < metrics.size(); ++j )
+    {
+      if( !done[ j ] && metrics[ j ]->GetImageSampler() == sampler
+        && metrics[ j ]->GetTransform() == transform )
+      {
+        group.push_back( metrics[ j ] );
+        done[ j ] = true;
+      }
+    }
+
+    if( group.size() > 1 )
+    {
+      typename TransformEvaluationCacheType::Pointer cache
+        = TransformEvaluationCacheType::New();
+      for( std::size_t j = 0; j < group.size(); ++j )
+      {
+        group[ j ]->SetTransformEvaluationCache( cache );
+      }
+    }
+  }
+
+} // end ShareTransformEvaluationCaches()
+
+
+/**
+ * ******************* ShareBSplineSupportCaches *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+CombinationImageToImageMetric< TFixedImage, TMovingImage >
+::ShareBSplineSupportCaches( void )
+{
+  typedef typename ImageMetricType::ImageSamplerType        MetricImageSamplerType;
+  typedef typename ImageMetricType::BSplineSupportCacheType BSplineSupportCacheType;
+
+  /** Collect the image metrics that use the cache. */
+  std::vector< ImageMetricType * > metrics;
+  for( unsigned int i = 0; i < this->GetNumberOfMetrics(); i++ )
+  {
+    ImageMetricType * testPtr1 = dynamic_cast< ImageMetricType * >( this->GetMetric( i ) );
+    if( testPtr1 )
+    {
+      /** Let each metric create its own cache, unless it is shared below. */
+      testPtr1->SetBSplineSupportCache( 0 );
+      if( testPtr1->GetUseBSplineSupportCache() && testPtr1->GetUseImageSampler() )
+      {
+        metrics.push_back( testPtr1 );
+      }
+    }
+  }
+
+  /** Metrics with the same sampler and transform need the same support.
+   * Such metrics are never evaluated concurrently, see
+   * CheckConcurrentEvaluation(), so they can fill the cache in turn.
+   */
+  std::vector< bool > done( metrics.size(), false );
+  for( std::size_t i = 0; i < metrics.size(); ++i )
+  {
+    if( done[ i ] )
+    {
+      continue;
+    }
+
+    const MetricImageSamplerType * sampler   = metrics[ i ]->GetImageSampler();
+    const TransformType *          transform = metrics[ i ]->GetTransform();
+    std::vector< ImageMetricType * > group( 1, metrics[ i ] );
+    for( std::size_t j = i + 1; j < metrics.size(); ++j )
+    {
+      if( !done[ j ] && metrics[ j ]->GetImageSampler() == sampler
+        && metrics[ j ]->GetTransform() == transform )
+      {
+        group.push_back( metrics[ j ] );
+        done[ j ] = true;
+      }
+    }
+
+    if( group.size() > 1 )
+    {
+      typename BSplineSupportCacheType::Pointer cache
+        = BSplineSupportCacheType::New();
+      for( std::size_t j = 0; j < group.size(); ++j )
+      {
+        group[ j ]->SetBSplineSupportCache( cache );
+      }
+    }
+  }
+
+} // end ShareBSplineSupportCaches()
+
+
+/**
+ * ******************* ComputeNumberOfThreadsPerMetric *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+CombinationImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeNumberOfThreadsPerMetric( void )
+{
+  /** Estimate the work of each image metric by its last computation time
+   * times its number of threads. The point set metrics are single-threaded.
+   */
+  std::vector< unsigned int > imageMetrics;
+  std::vector< double >       work;
+  double                      totalWork = 0.0;
+  for( unsigned int i = 0; i < this->GetNumberOfMetrics(); i++ )
+  {
+    if( dynamic_cast< ImageMetricType * >( this->GetMetric( i ) ) )
+    {
+      imageMetrics.push_back( i );
+      work.push_back( this->m_MetricComputationTime[ i ]
+        * static_cast< double >( this->GetNumberOfThreadsPerMetric( i ) ) );
+      totalWork += work.back();
+    }
+  }
+
+  /** Each image metric gets at least one thread. */
+  std::fill( this->m_NumberOfThreadsPerMetric.begin(),
+    this->m_NumberOfThreadsPerMetric.end(), 1 );
+  const ThreadIdType numberOfThreads = this->GetNumberOfThreads();
+  const ThreadIdType numberOfImageMetrics = static_cast< ThreadIdType >( imageMetrics.size() );
+  if( numberOfThreads <= numberOfImageMetrics )
+  {
+    return;
+  }
+
+  /** Divide the remaining threads proportional to the work, or equally in
+   * the first resolution. Round down, and give the threads that are left
+   * to the metrics with the largest remainders.
+   */
+  const ThreadIdType    remainingThreads = numberOfThreads - numberOfImageMetrics;
+  ThreadIdType          assignedThreads  = 0;
+  std::vector< double > remainders( numberOfImageMetrics );
+  for( ThreadIdType k = 0; k < numberOfImageMetrics; ++k )
+  {
+    const double share = totalWork > 0.0
+      ? remainingThreads * work[ k ] / totalWork
+      : static_cast< double >( remainingThreads ) / numberOfImageMetrics;
+    const ThreadIdType extraThreads = static_cast< ThreadIdType >( vcl_floor( share ) );
+    this->m_NumberOfThreadsPerMetric[ imageMetrics[ k ] ] += extraThreads;
+    assignedThreads += extraThreads;
+    remainders[ k ]  = share - extraThreads;
+  }
+  for( ; assignedThreads < remainingThreads; ++assignedThreads )
+  {
+    const ThreadIdType k = static_cast< ThreadIdType >(
+      std::max_element( remainders.begin(), remainders.end() ) - remainders.begin() );
+    this->m_NumberOfThreadsPerMetric[ imageMetrics[ k ] ] += 1;
+    remainders[ k ] = -1.0;
+  }
+
+} // end ComputeNumberOfThreadsPerMetric()
+
+
+/**
+ * ******************* GetNumberOfThreadsPerMetric *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+ThreadIdType
+CombinationImageToImageMetric< TFixedImage, TMovingImage >
+::GetNumberOfThreadsPerMetric( unsigned int pos ) const
+{
+  if( !this->m_EvaluateMetricsConcurrently || pos >= this->m_NumberOfThreadsPerMetric.size() )
+  {
+    return this->GetNumberOfThreads();
+  }
+  return this->m_NumberOfThreadsPerMetric[ pos ];
+
+} // end GetNumberOfThreadsPerMetric()
+
+
 /**
  * ******************* InitializeThreadingParameters *******************
  */
@@ -858,27 +1164,8 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
   /** Initialize some threading related parameters. */
   this->InitializeThreadingParameters();
 
-  /** Decide whether or not to use multi-threading.
-   * If the global maximum number of threads is smaller than the number
-   * of metrics, then setting the number of threads to the number of
-   * threads will result in a bug: all metrics after the max will not be
-   * run. For now we decide to run this metric single-threadedly in that case.
-   *
-   * Actually we should sum the number of threads of each metric and check that
-   * it does not surpass the global maximum. But for now we don't.
-   */
-  bool useMultiThread = this->m_UseMultiThread;
-  if( MultiThreader::GetGlobalMaximumNumberOfThreads() < this->m_NumberOfMetrics )
-  {
-    useMultiThread = false;
-  }
-
-  // For now we disable multi-threading of the combo metric, since the MacMini build
-  // segfaults with it. Have to investigate this issue later
-  useMultiThread = false;
-
   /** Compute all metric values and derivatives, single-threadedly. */
-  if( !useMultiThread )
+  if( !this->m_EvaluateMetricsConcurrently )
   {
     for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
     {
@@ -897,32 +1184,46 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
   else
   {
     /** Setup struct with multi-threading information. */
-    MultiThreaderComboMetricsType * temp_c = new MultiThreaderComboMetricsType;
-    temp_c->st_MetricsIterator           = this->m_Metrics;
-    temp_c->st_MetricDerivativesIterator = this->m_MetricDerivatives.begin();
-    temp_c->st_MetricValuesIterator      = this->m_MetricValues.begin();
-    temp_c->st_MetricComputationTime.resize( this->m_NumberOfMetrics, 0 );
-    temp_c->st_Parameters = const_cast< ParametersType * >( &parameters );
-
-    /** GetValueAndDerivative */
+    MultiThreaderComboMetricsType temp_c;
+    temp_c.st_MetricsIterator           = this->m_Metrics;
+    temp_c.st_MetricDerivativesIterator = this->m_MetricDerivatives.begin();
+    temp_c.st_MetricValuesIterator      = this->m_MetricValues.begin();
+    temp_c.st_MetricComputationTime.resize( this->m_NumberOfMetrics, 0 );
+    temp_c.st_ExceptionDescriptions.resize( this->m_NumberOfMetrics );
+    temp_c.st_Parameters = const_cast< ParametersType * >( &parameters );
+
+    /** The metrics share the transform, and each of them sets its parameters.
+     * Freeze them, so that this does not change the transform while another
+     * metric uses it.
+     */
+    CombinationTransformType * transform
+      = dynamic_cast< CombinationTransformType * >( this->m_AdvancedTransform.GetPointer() );
+    transform->SetAndFreezeParameters( parameters );
+
+    /** GetValueAndDerivative. The callback catches all exceptions. */
     local_threader->SetNumberOfThreads( this->m_NumberOfMetrics );
-    local_threader->SetSingleMethod( GetValueAndDerivativeComboThreaderCallback, temp_c );
-    local_threader->SingleMethodExecute();
+    PersistentThreadPool::Launch( local_threader,
+      GetValueAndDerivativeComboThreaderCallback, &temp_c );
+    transform->UnfreezeParameters();
 
-    /** Store computation time. */
+    /** Store computation time, and pass on the first exception. */
     for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
     {
-      this->m_MetricComputationTime[ i ] = temp_c->st_MetricComputationTime[ i ];
+      this->m_MetricComputationTime[ i ] = temp_c.st_MetricComputationTime[ i ];
+    }
+    for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
+    {
+      if( !temp_c.st_ExceptionDescriptions[ i ].empty() )
+      {
+        itkExceptionMacro( << "Metric " << i << " failed:\n"
+                           << temp_c.st_ExceptionDescriptions[ i ] );
+      }
     }
-
-    delete temp_c;
   }
 
   /** Compute the derivative magnitude, single-threadedly. */
-  // I get random segfaults on the Linux or Mac systems when this is enabled.
-  // For now disable multi-threading and force single-threaded:
-  //if( !this->m_UseMultiThread )
-  if( true )
+  const unsigned int numberOfParameters = this->GetNumberOfParameters();
+  if( !this->m_UseMultiThread )
   {
     for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
     {
@@ -932,16 +1233,18 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
   /** Compute the derivative magnitude, multi-threadedly. */
   else
   {
-    /** Setup struct with multi-threading information. */
-    ThreadIdType                         numberOfThreads = this->GetNumberOfThreads();
-    MultiThreaderCombineDerivativeType * temp_m          = new MultiThreaderCombineDerivativeType;
-    temp_m->st_ThisComboMetric = const_cast< Self * >( this );
-    temp_m->st_DerivativesSumOfSquares.resize( numberOfThreads * this->m_NumberOfMetrics );
+    /** Setup struct with multi-threading information. The threader may use
+     * less threads than asked for, so the struct is sized afterwards.
+     */
+    local_threader->SetNumberOfThreads( this->GetNumberOfThreads() );
+    const ThreadIdType                 numberOfThreads = local_threader->GetNumberOfThreads();
+    MultiThreaderCombineDerivativeType temp_m;
+    temp_m.st_ThisComboMetric = const_cast< Self * >( this );
+    temp_m.st_DerivativesSumOfSquares.resize( numberOfThreads * this->m_NumberOfMetrics, 0.0 );
 
     /** Compute derivatives magnitude multi-threadedly. */
-    local_threader->SetNumberOfThreads( numberOfThreads );
-    local_threader->SetSingleMethod( ComputeDerivativesMagnitudeThreaderCallback, temp_m );
-    local_threader->SingleMethodExecute();
+    PersistentThreadPool::Launch( local_threader,
+      ComputeDerivativesMagnitudeThreaderCallback, &temp_m );
 
     /** Gather the results. */
     for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
@@ -949,12 +1252,10 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
       double mag = 0.0;
       for( unsigned int j = 0; j < numberOfThreads; j++ )
       {
-        mag += temp_m->st_DerivativesSumOfSquares[ i * numberOfThreads + j ];
+        mag += temp_m.st_DerivativesSumOfSquares[ i * numberOfThreads + j ];
       }
       this->m_MetricDerivativesMagnitude[ i ] = vcl_sqrt( mag );
     }
-
-    delete temp_m;
   }
 
   /** Combine the metric values, single-threadedly. */
@@ -969,10 +1270,7 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
   }   // end of combine metrics
 
   /** Combine the metric derivatives, single-threadedly. */
-  // I get random segfaults on the linux or Mac systems when this is enabled.
-  // For now disable multi-threading and force single-threaded:
-  //if( !this->m_UseMultiThread )
-  if( true )
+  if( !this->m_UseMultiThread )
   {
     /** The first derivative. */
     if( this->m_UseMetric[ 0 ] )
@@ -982,6 +1280,7 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
     }
     else
     {
+      derivative.SetSize( numberOfParameters );
       derivative.Fill( 0 );
     }
 
@@ -999,18 +1298,18 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
   /** Combine the derivatives, multi-threadedly. */
   else
   {
+    /** The derivative may not have been allocated yet. */
+    derivative.SetSize( numberOfParameters );
+
     /** Setup struct with multi-threading information. */
-    ThreadIdType                         numberOfThreads = this->GetNumberOfThreads();
-    MultiThreaderCombineDerivativeType * temp_d          = new MultiThreaderCombineDerivativeType;
-    temp_d->st_ThisComboMetric = const_cast< Self * >( this );
-    temp_d->st_Derivative      = &derivative[ 0 ];
+    MultiThreaderCombineDerivativeType temp_d;
+    temp_d.st_ThisComboMetric = const_cast< Self * >( this );
+    temp_d.st_Derivative      = derivative.data_block();
 
     /** Combine derivatives */
-    local_threader->SetNumberOfThreads( numberOfThreads );
-    local_threader->SetSingleMethod( CombineDerivativesThreaderCallback, temp_d );
-    local_threader->SingleMethodExecute();
-
-    delete temp_d;
+    local_threader->SetNumberOfThreads( this->GetNumberOfThreads() );
+    PersistentThreadPool::Launch( local_threader,
+      CombineDerivativesThreaderCallback, &temp_d );
   }
 
 } // end GetValueAndDerivative()
@@ -1028,17 +1327,41 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
   ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
   ThreadIdType     threadID   = infoStruct->ThreadID;
 
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfThreads;
+
   MultiThreaderComboMetricsType * temp
     = static_cast< MultiThreaderComboMetricsType * >( infoStruct->UserData );
 
-  itk::TimeProbe timer;
-  timer.Start();
-  temp->st_MetricsIterator[ threadID ]->GetValueAndDerivative(
-    *temp->st_Parameters,
-    temp->st_MetricValuesIterator[ threadID ],
-    temp->st_MetricDerivativesIterator[ threadID ] );
-  timer.Stop();
-  temp->st_MetricComputationTime[ threadID ] = timer.GetMean() * 1000.0;
+  /** The threader may have less threads than there are metrics. Exceptions
+   * can not be thrown from a thread, so they are stored for the caller.
+   */
+  const unsigned int numberOfMetrics = temp->st_MetricsIterator.size();
+  for( unsigned int i = threadID; i < numberOfMetrics; i += nrOfThreads )
+  {
+    itk::TimeProbe timer;
+    timer.Start();
+    try
+    {
+      temp->st_MetricsIterator[ i ]->GetValueAndDerivative(
+        *temp->st_Parameters,
+        temp->st_MetricValuesIterator[ i ],
+        temp->st_MetricDerivativesIterator[ i ] );
+    }
+    catch( ExceptionObject & excp )
+    {
+      temp->st_ExceptionDescriptions[ i ] = excp.what();
+    }
+    catch( std::exception & excp )
+    {
+      temp->st_ExceptionDescriptions[ i ] = excp.what();
+    }
+    catch( ... )
+    {
+      temp->st_ExceptionDescriptions[ i ] = "Unknown exception.";
+    }
+    timer.Stop();
+    temp->st_MetricComputationTime[ i ] = timer.GetMean() * 1000.0;
+  }
 
   return ITK_THREAD_RETURN_VALUE;
 
@@ -1076,17 +1399,14 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
   double derivativeValue = 0.0;
   for( unsigned int i = 0; i < numberOfMetrics; i++ )
   {
-    if( temp->st_ThisComboMetric->m_UseMetric[ i ] )
+    const DerivativeType & derivative   = temp->st_ThisComboMetric->m_MetricDerivatives[ i ];
+    double                 sumOfSquares = 0.0;
+    for( unsigned int j = jmin; j < jmax; j++ )
     {
-      const DerivativeType & derivative   = temp->st_ThisComboMetric->m_MetricDerivatives[ i ];
-      double                 sumOfSquares = 0.0;
-      for( unsigned int j = jmin; j < jmax; j++ )
-      {
-        derivativeValue = derivative[ j ];
-        sumOfSquares   += derivativeValue * derivativeValue;
-      }
-      temp->st_DerivativesSumOfSquares[ i * nrOfThreads + threadId ] = sumOfSquares;
+      derivativeValue = derivative[ j ];
+      sumOfSquares   += derivativeValue * derivativeValue;
     }
+    temp->st_DerivativesSumOfSquares[ i * nrOfThreads + threadId ] = sumOfSquares;
   }
 
   return ITK_THREAD_RETURN_VALUE;
@@ -1131,6 +1451,13 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
       temp->st_Derivative[ j ] = weight * metricDerivative[ j ];
     }
   }
+  else
+  {
+    for( unsigned int j = jmin; j < jmax; j++ )
+    {
+      temp->st_Derivative[ j ] = NumericTraits< DerivativeValueType >::Zero;
+    }
+  }
 
   // Other metrics, add
   for( unsigned int i = 1; i < numberOfMetrics; i++ )
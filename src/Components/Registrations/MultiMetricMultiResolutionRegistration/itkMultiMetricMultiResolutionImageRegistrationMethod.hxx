@@ -221,15 +221,10 @@ MultiMetricMultiResolutionImageRegistrationMethod< TFixedImage, TMovingImage >
 {
   this->CheckPyramids();
 
-  /** Set up the fixed image pyramids and the fixed image region pyramids. */
-  typedef typename FixedImageRegionType::SizeType      SizeType;
-  typedef typename FixedImageRegionType::IndexType     IndexType;
-  typedef typename FixedImagePyramidType::ScheduleType ScheduleType;
-
-  this->m_FixedImageRegionPyramids.resize( this->GetNumberOfFixedImagePyramids() );
+  /** Set up the fixed and moving image pyramids. */
+  std::vector< ProcessObject * > pyramids;
   for( unsigned int i = 0; i < this->GetNumberOfFixedImagePyramids(); ++i )
   {
-    // Setup the fixed image pyramid
     FixedImagePyramidPointer fixpyr = this->GetFixedImagePyramid( i );
     if( fixpyr.IsNotNull() )
     {
@@ -242,8 +237,43 @@ MultiMetricMultiResolutionImageRegistrationMethod< TFixedImage, TMovingImage >
       {
         fixpyr->SetInput( this->GetFixedImage() );
       }
-      fixpyr->UpdateLargestPossibleRegion();
+      pyramids.push_back( fixpyr.GetPointer() );
+    }
+  }
+
+  for( unsigned int i = 0; i < this->GetNumberOfMovingImagePyramids(); ++i )
+  {
+    MovingImagePyramidPointer movpyr = this->GetMovingImagePyramid( i );
+    if( movpyr.IsNotNull() )
+    {
+      movpyr->SetNumberOfLevels( this->GetNumberOfLevels() );
+      if( this->GetNumberOfMovingImages() > 1 )
+      {
+        movpyr->SetInput( this->GetMovingImage( i ) );
+      }
+      else
+      {
+        movpyr->SetInput( this->GetMovingImage() );
+      }
+      pyramids.push_back( movpyr.GetPointer() );
+    }
+  }
+
+  /** Compute the pyramids, concurrently where possible. */
+  this->UpdatePyramids( pyramids );
+
+  /** Set up the fixed image region pyramids. */
+  typedef typename FixedImageRegionType::SizeType      SizeType;
+  typedef typename FixedImageRegionType::IndexType     IndexType;
+  typedef typename FixedImagePyramidType::ScheduleType ScheduleType;
 
+  this->m_FixedImageRegionPyramids.resize( this->GetNumberOfFixedImagePyramids() );
+  for( unsigned int i = 0; i < this->GetNumberOfFixedImagePyramids(); ++i )
+  {
+    // Setup the fixed image pyramid
+    FixedImagePyramidPointer fixpyr = this->GetFixedImagePyramid( i );
+    if( fixpyr.IsNotNull() )
+    {
       ScheduleType schedule = fixpyr->GetSchedule();
 
       FixedImageRegionType fixedImageRegion;
@@ -318,25 +348,6 @@ MultiMetricMultiResolutionImageRegistrationMethod< TFixedImage, TMovingImage >
 
   } // end for loop over fixed pyramids
 
-  /** Setup the moving image pyramids. */
-  for( unsigned int i = 0; i < this->GetNumberOfMovingImagePyramids(); ++i )
-  {
-    MovingImagePyramidPointer movpyr = this->GetMovingImagePyramid( i );
-    if( movpyr.IsNotNull() )
-    {
-      movpyr->SetNumberOfLevels( this->GetNumberOfLevels() );
-      if( this->GetNumberOfMovingImages() > 1 )
-      {
-        movpyr->SetInput( this->GetMovingImage( i ) );
-      }
-      else
-      {
-        movpyr->SetInput( this->GetMovingImage() );
-      }
-      movpyr->UpdateLargestPossibleRegion();
-    }
-  }
-
 } // end PrepareAllPyramids()
 
 
@@ -20,6 +20,7 @@
 
 #include "elxIncludes.h" // include first to avoid MSVS warning
 #include "itkResampleImageFilter.h"
+#include "itkAdvancedTransform.h"
 
 namespace elastix
 {
@@ -28,6 +29,11 @@ namespace elastix
  * \class MyStandardResampler
  * \brief A resampler based on the itk::ResampleImageFilter.
  *
+ * For nonlinear transforms the output image is processed line by line.
+ * If the transform is an AdvancedTransform, the points of a complete line
+ * are transformed at once, using TransformPointsAlongLine(). This allows
+ * the B-spline transform to reuse the B-spline weights along a line.
+ *
  * The parameters used in this class are:
  * \parameter Resampler: Select this resampler as follows:\n
  *    <tt>(Resampler "DefaultResampler")</tt>
@@ -88,7 +94,14 @@ public:
   typedef typename Superclass2::RegistrationPointer  RegistrationPointer;
   typedef typename Superclass2::ITKBaseType          ITKBaseType;
 
-  /* Nothing to add. In the baseclass already everything is done what should be done. */
+  /** The image dimension. */
+  itkStaticConstMacro( ImageDimension, unsigned int, Superclass2::ImageDimension );
+
+  /** Typedef's for the line-wise transformation of points. */
+  typedef typename Superclass2::CoordRepType CoordRepType;
+  typedef itk::AdvancedTransform< CoordRepType,
+    itkGetStaticConstMacro( ImageDimension ),
+    itkGetStaticConstMacro( ImageDimension ) >      AdvancedTransformType;
 
 protected:
 
@@ -97,6 +110,14 @@ protected:
   /** The destructor. */
   virtual ~MyStandardResampler() {}
 
+  /** Resample the output region line by line, when the transform is an
+   * AdvancedTransform. Otherwise the implementation of the
+   * ResampleImageFilter is used.
+   */
+  virtual void NonlinearThreadedGenerateData(
+    const OutputImageRegionType & outputRegionForThread,
+    itk::ThreadIdType threadId );
+
 private:
 
   /** The private constructor. */
@@ -20,7 +20,118 @@
 #define __elxMyStandardResampler_hxx
 
 #include "elxMyStandardResampler.h"
+#include "itkImageScanlineIterator.h"
+#include "itkProgressReporter.h"
 
-//nothing
+namespace elastix
+{
+
+/**
+ * ******************* NonlinearThreadedGenerateData ***********************
+ */
+
+template< class TElastix >
+void
+MyStandardResampler< TElastix >
+::NonlinearThreadedGenerateData(
+  const OutputImageRegionType & outputRegionForThread,
+  itk::ThreadIdType threadId )
+{
+  /** Use the default implementation, if the transform can not transform lines. */
+  const AdvancedTransformType * transform
+    = dynamic_cast< const AdvancedTransformType * >( this->GetTransform() );
+  if( transform == 0 )
+  {
+    this->Superclass1::NonlinearThreadedGenerateData( outputRegionForThread, threadId );
+    return;
+  }
+
+  /** Typedef's. */
+  typedef itk::ImageScanlineIterator< OutputImageType >       OutputIteratorType;
+  typedef typename AdvancedTransformType::InputPointType      TransformInputPointType;
+  typedef typename AdvancedTransformType::InputVectorType     TransformInputVectorType;
+  typedef typename AdvancedTransformType::OutputPointContainerType
+    OutputPointContainerType;
+  typedef typename Superclass1::InterpolatorOutputType        InterpolatorOutputType;
+  typedef typename Superclass1::ComponentType                 ComponentType;
+  typedef itk::ContinuousIndex< CoordRepType,
+    itkGetStaticConstMacro( ImageDimension ) >                ContinuousInputIndexType;
+
+  OutputImageType *        outputPtr    = this->GetOutput();
+  const InputImageType *   inputPtr     = this->GetInput();
+  const InterpolatorType * interpolator = this->GetInterpolator();
+  const typename Superclass1::ExtrapolatorType * extrapolator = this->GetExtrapolator();
+
+  /** Values used to cast the interpolated values to the output pixel type. */
+  const PixelType     defaultValue = this->GetDefaultPixelValue();
+  const ComponentType minValue     = itk::NumericTraits< ComponentType >::NonpositiveMin();
+  const ComponentType maxValue     = itk::NumericTraits< ComponentType >::max();
+
+  /** Determine the physical step between two voxels on a line. */
+  const unsigned long lineLength = outputRegionForThread.GetSize()[ 0 ];
+  IndexType           index      = outputRegionForThread.GetIndex();
+  PointType           point, nextPoint;
+  outputPtr->TransformIndexToPhysicalPoint( index, point );
+  ++index[ 0 ];
+  outputPtr->TransformIndexToPhysicalPoint( index, nextPoint );
+  TransformInputVectorType step;
+  for( unsigned int j = 0; j < ImageDimension; ++j )
+  {
+    step[ j ] = nextPoint[ j ] - point[ j ];
+  }
+
+  /** Support for progress methods/callbacks. */
+  itk::ProgressReporter progress( this, threadId,
+    outputRegionForThread.GetNumberOfPixels() );
+
+  /** Walk the output region line by line. */
+  OutputIteratorType outIt( outputPtr, outputRegionForThread );
+  outIt.GoToBegin();
+  TransformInputPointType  startPoint;
+  OutputPointContainerType transformedPoints;
+  ContinuousInputIndexType inputIndex;
+  while( !outIt.IsAtEnd() )
+  {
+    /** Transform all points of the line at once. */
+    outputPtr->TransformIndexToPhysicalPoint( outIt.GetIndex(), point );
+    for( unsigned int j = 0; j < ImageDimension; ++j )
+    {
+      startPoint[ j ] = point[ j ];
+    }
+    transform->TransformPointsAlongLine( startPoint, step, lineLength, transformedPoints );
+
+    unsigned long k = 0;
+    while( !outIt.IsAtEndOfLine() )
+    {
+      /** Compute the corresponding input index and evaluate the input image. */
+      inputPtr->TransformPhysicalPointToContinuousIndex( transformedPoints[ k ], inputIndex );
+      if( interpolator->IsInsideBuffer( inputIndex ) )
+      {
+        const InterpolatorOutputType value
+          = interpolator->EvaluateAtContinuousIndex( inputIndex );
+        outIt.Set( this->CastPixelWithBoundsChecking( value, minValue, maxValue ) );
+      }
+      else if( extrapolator != 0 )
+      {
+        const InterpolatorOutputType value
+          = extrapolator->EvaluateAtContinuousIndex( inputIndex );
+        outIt.Set( this->CastPixelWithBoundsChecking( value, minValue, maxValue ) );
+      }
+      else
+      {
+        outIt.Set( defaultValue );
+      }
+
+      progress.CompletedPixel();
+      ++k;
+      ++outIt;
+    }
+    outIt.NextLine();
+  }
+
+} // end NonlinearThreadedGenerateData()
+
+
+} // end namespace elastix
 
 #endif
@@ -74,6 +74,13 @@ namespace elastix
  *   <em>Nonrigid registration of dynamic medical imaging data using nD+t B-splines and a
  *   groupwise optimization approach</em>, C.T. Metz, S. Klein, M. Schaap, T. van Walsum and
  *   W.J. Niessen, Medical Image Analysis, in press.
+ * \parameter BSplineTransformUseVectorizedKernels: use explicitly vectorized (SSE2 or AVX,
+ *   selected at run-time) kernels for the B-spline weights and for the product of the
+ *   weights with the image gradient. The results agree with the default implementation
+ *   within a relative tolerance of 1e-14, and are usually bit identical. Also used by
+ *   transformix. \n
+ *   example: <tt>(BSplineTransformUseVectorizedKernels "true")</tt> \n
+ *   The default is "false".
  *
  *
  * The transform parameters necessary for transformix, additionally defined by this class, are:
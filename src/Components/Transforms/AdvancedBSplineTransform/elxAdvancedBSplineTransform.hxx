@@ -97,6 +97,19 @@ AdvancedBSplineTransform< TElastix >
   this->m_GridUpsampler = GridUpsamplerType::New();
   this->m_GridUpsampler->SetBSplineOrder( this->m_SplineOrder );
 
+  /** Optionally use the vectorized kernels for the B-spline weights. */
+  bool useVectorizedKernels = false;
+  this->GetConfiguration()->ReadParameter( useVectorizedKernels,
+    "BSplineTransformUseVectorizedKernels", this->GetComponentLabel(), 0, 0, false );
+  this->m_BSplineTransform->SetUseVectorizedKernels( useVectorizedKernels );
+  if( useVectorizedKernels )
+  {
+    elxout << "  Using the "
+           << itk::BSplineVectorizedKernels::GetInstructionSetName(
+      itk::BSplineVectorizedKernels::GetInstructionSet() )
+           << " kernels for the B-spline weights." << std::endl;
+  }
+
   return 0;
 } // end InitializeBSplineTransform()
 
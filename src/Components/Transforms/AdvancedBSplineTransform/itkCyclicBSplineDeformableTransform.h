@@ -94,6 +94,11 @@ public:
   typedef typename RegionType::IndexType       GridOffsetType;
   typedef typename Superclass::InputPointType  InputPointType;
   typedef typename Superclass::OutputPointType OutputPointType;
+  typedef typename Superclass::InputVectorType InputVectorType;
+  typedef typename Superclass
+    ::OutputPointContainerType OutputPointContainerType;
+  typedef typename Superclass
+    ::SpatialJacobianContainerType SpatialJacobianContainerType;
   typedef typename Superclass::WeightsType     WeightsType;
   typedef typename Superclass::
     ParameterIndexArrayType ParameterIndexArrayType;
@@ -129,6 +134,16 @@ public:
     ParameterIndexArrayType & indices,
     bool & inside ) const;
 
+  /** Transform a line of equidistant points. The line algorithm of the
+   * superclass does not wrap the support region around the last dimension,
+   * so the points are transformed one by one.
+   */
+  virtual void TransformPointsAlongLine(
+    const InputPointType & startPoint,
+    const InputVectorType & step,
+    const unsigned long numberOfPoints,
+    OutputPointContainerType & outputPoints ) const;
+
   /** Compute the Jacobian of the transformation. */
   virtual void GetJacobian(
     const InputPointType & ipp,
@@ -140,6 +155,28 @@ public:
     const InputPointType & ipp,
     SpatialJacobianType & sj ) const;
 
+  /** Compute the spatial Jacobian at a line of equidistant points.
+   * The line algorithm of the superclass does not wrap the support region
+   * around the last dimension, so the spatial Jacobian is computed point
+   * by point.
+   */
+  virtual void GetSpatialJacobianAlongLine(
+    const InputPointType & startPoint,
+    const InputVectorType & step,
+    const unsigned long numberOfPoints,
+    SpatialJacobianContainerType & sjs ) const;
+
+  /** The support cache is not supported for the cyclic transform. */
+  typedef typename Superclass::SupportCacheType SupportCacheType;
+  virtual unsigned long PrecomputeSupportCache(
+    const std::vector< InputPointType > &, const std::size_t,
+    SupportCacheType * cache ) const
+  {
+    cache->Clear();
+    return 0;
+  }
+
+
 protected:
 
   CyclicBSplineDeformableTransform();
@@ -245,6 +245,28 @@ CyclicBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
 }
 
 
+/**
+ * ********************* TransformPointsAlongLine ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+CyclicBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::TransformPointsAlongLine(
+  const InputPointType & startPoint,
+  const InputVectorType & step,
+  const unsigned long numberOfPoints,
+  OutputPointContainerType & outputPoints ) const
+{
+  /** Skip the line algorithm of the superclass, and call the point-wise
+   * implementation of AdvancedTransform, which calls TransformPoint().
+   */
+  this->Superclass::Superclass::TransformPointsAlongLine(
+    startPoint, step, numberOfPoints, outputPoints );
+
+} // end TransformPointsAlongLine()
+
+
 /** Compute the Jacobian in one position. */
 template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
 void
@@ -402,6 +424,28 @@ CyclicBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
 } // end GetSpatialJacobian()
 
 
+/**
+ * ********************* GetSpatialJacobianAlongLine ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+CyclicBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::GetSpatialJacobianAlongLine(
+  const InputPointType & startPoint,
+  const InputVectorType & step,
+  const unsigned long numberOfPoints,
+  SpatialJacobianContainerType & sjs ) const
+{
+  /** Skip the line algorithm of the superclass, and call the point-wise
+   * implementation of AdvancedTransform, which calls GetSpatialJacobian().
+   */
+  this->Superclass::Superclass::GetSpatialJacobianAlongLine(
+    startPoint, step, numberOfPoints, sjs );
+
+} // end GetSpatialJacobianAlongLine()
+
+
 /**
  * ********************* ComputeNonZeroJacobianIndices ****************************
  */
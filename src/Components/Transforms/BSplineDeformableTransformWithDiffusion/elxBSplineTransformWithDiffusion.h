@@ -348,6 +348,14 @@ public:
    */
   virtual OutputPointType TransformPoint( const InputPointType  & point ) const;
 
+  /** The TransformPoint() above adds the deformation field, so this
+   * transform should not be split into its current and initial transform.
+   */
+  virtual bool GetTransformPointOnlyCombines( void ) const
+  {
+    return false;
+  }
+
   /**  Method to transform a point with extra arguments. Just calls
    * the Superclass1's implementation. Has to be present here since it is an
    * overloaded function.
@@ -72,6 +72,7 @@ public:
   typedef typename Superclass::OutputVnlVectorType       OutputVnlVectorType;
   typedef typename Superclass::InputPointType            InputPointType;
   typedef typename Superclass::OutputPointType           OutputPointType;
+  typedef typename Superclass::OutputPointContainerType  OutputPointContainerType;
 
   /** Typedef's needed in this class. */
   typedef DeformationVectorFieldTransform<
@@ -112,6 +113,16 @@ public:
   /** Method to transform a point. */
   virtual OutputPointType TransformPoint( const InputPointType & inputPoint ) const;
 
+  /** Method to transform a line of points. The Superclass may pass the line
+   * on to its own parts, which would skip the deformation field, so the
+   * points are transformed one by one with TransformPoint().
+   */
+  virtual void TransformPointsAlongLine(
+    const InputPointType & startPoint,
+    const InputVectorType & step,
+    const unsigned long numberOfPoints,
+    OutputPointContainerType & outputPoints ) const;
+
 protected:
 
   /** The constructor. */
@@ -117,6 +117,35 @@ DeformationFieldRegulizer< TAnyITKTransform >
 } // end TransformPoint()
 
 
+/**
+ * ******************* TransformPointsAlongLine ******************
+ */
+
+template< class TAnyITKTransform >
+void
+DeformationFieldRegulizer< TAnyITKTransform >
+::TransformPointsAlongLine(
+  const InputPointType & startPoint,
+  const InputVectorType & step,
+  const unsigned long numberOfPoints,
+  OutputPointContainerType & outputPoints ) const
+{
+  outputPoints.resize( numberOfPoints );
+
+  /** Transform the points one by one, including the deformation field. */
+  InputPointType point;
+  for( unsigned long k = 0; k < numberOfPoints; ++k )
+  {
+    for( unsigned int i = 0; i < InputSpaceDimension; i++ )
+    {
+      point[ i ] = startPoint[ i ] + static_cast< ScalarType >( k ) * step[ i ];
+    }
+    outputPoints[ k ] = this->TransformPoint( point );
+  }
+
+} // end TransformPointsAlongLine()
+
+
 /**
  * ******** UpdateIntermediaryDeformationFieldTransform *********
  */
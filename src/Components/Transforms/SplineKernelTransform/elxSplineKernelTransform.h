@@ -70,6 +70,36 @@ namespace elastix
  * Default: 0.3. You cannot specify this parameter for each resolution differently.\n
  * Valid values are withing -1.0 and 0.5. 0.5 means incompressible.
  * Negative values are a bit odd, but possible. See Wikipedia on PoissonRatio.
+ * \parameter TPSMatrixInversionMethod: How the spline coefficients are solved,
+ * one of { SVD, QR, Iterative }. SVD and QR invert the dense L matrix, of which
+ * the size is quadratic in the number of landmarks. Iterative solves without
+ * storing L, which is needed for thousands of landmarks, but does not support
+ * the Jacobian, so the transform cannot be optimized with it: a registration
+ * with Iterative gives a configuration error. Use it in a transform parameter
+ * file, to apply a transform, for example with transformix.\n
+ *   example: <tt>(TPSMatrixInversionMethod "Iterative")</tt>\n
+ * Default: SVD.
+ * \parameter TPSIterativeSolverTolerance: The relative residual at which the
+ * iterative solver stops.\n
+ *   example: <tt>(TPSIterativeSolverTolerance 1e-8)</tt>\n
+ * Default: 1e-6.
+ * \parameter TPSMaximumNumberOfIterativeSolverIterations: The maximum number
+ * of iterations of the iterative solver.\n
+ *   example: <tt>(TPSMaximumNumberOfIterativeSolverIterations 20000)</tt>\n
+ * Default: 10000.
+ * \parameter TPSEvaluationGridTolerance: When positive, the deformation is
+ * precomputed on a grid over the image domain and interpolated with cubic
+ * B-splines, when the transform is read from a transform parameter file.
+ * The grid is refined until the estimated maximum error (in mm) is below
+ * this value. This makes transforming a point independent of the number of
+ * landmarks. The error is estimated from samples, so it is not a strict bound.\n
+ *   example: <tt>(TPSEvaluationGridTolerance 0.01)</tt>\n
+ * Default: 0, which means that the transform is always evaluated exactly.
+ * \parameter TPSMaximumEvaluationGridSize: The maximum number of grid nodes.
+ * If the tolerance is not reached within this size, the transform is
+ * evaluated exactly.\n
+ *   example: <tt>(TPSMaximumEvaluationGridSize 1000000)</tt>\n
+ * Default: 4194304.
  *
  * \commandlinearg -fp: a file specifying a set of points that will serve
  * as fixed image landmarks.\n
@@ -104,6 +134,14 @@ namespace elastix
  *   example: <tt>(SplinePoissonRatio 0.3 )</tt>\n
  * Valid values are withing -1.0 and 0.5. 0.5 means incompressible.
  * Negative values are a bit odd, but possible. See Wikipedia on PoissonRatio.
+ * \transformparameter TPSMatrixInversionMethod: See the parameter with this name.
+ * \transformparameter TPSIterativeSolverTolerance: See the parameter with this name.
+ * \transformparameter TPSMaximumNumberOfIterativeSolverIterations: See the
+ * parameter with this name.
+ * \transformparameter TPSEvaluationGridTolerance: See the parameter with this
+ * name. The grid covers the image domain given by the Size, Index, Spacing,
+ * Origin and Direction in the transform parameter file.
+ * \transformparameter TPSMaximumEvaluationGridSize: See the parameter with this name.
  * \transformparameter FixedImageLandmarks: The landmark positions in the
  * fixed image, in world coordinates. Positions written as x1 y1 [z1] x2 y2 [z2] etc.\n
  *   example: <tt>(FixedImageLandmarks 10.0 11.0 12.0 4.0 4.0 4.0 6.0 6.0 6.0 )</tt>
@@ -225,6 +263,17 @@ protected:
    */
   virtual bool SetKernelType( const std::string & kernelType );
 
+  /** Read the settings of the solver and the evaluation grid, and set
+   * them in the kernel transform. The iterative solver does not support
+   * the Jacobian, so it is refused for a registration.
+   */
+  virtual void ReadSolverSettings( const bool forRegistration );
+
+  /** Compute the evaluation grid over the image domain that is given in the
+   * transform parameter file, if a TPSEvaluationGridTolerance is given.
+   */
+  virtual void InitializeEvaluationGrid( void );
+
   /** Read source landmarks from fp file
    * \li Try reading -fp file
    */
@@ -196,11 +196,8 @@ SplineKernelTransform< TElastix >
     this->m_KernelTransform->SetPoissonRatio( poissonRatio );
   }
 
-  /** Set the matrix inversion method (one of {SVD, QR}). */
-  std::string matrixInversionMethod = "SVD";
-  this->GetConfiguration()->ReadParameter(
-    matrixInversionMethod, "TPSMatrixInversionMethod", 0, true );
-  this->m_KernelTransform->SetMatrixInversionMethod( matrixInversionMethod );
+  /** Set the matrix inversion method and the evaluation grid settings. */
+  this->ReadSolverSettings( true );
 
   /** Load fixed image (source) landmark positions. */
   this->DetermineSourceLandmarks();
@@ -433,6 +430,11 @@ SplineKernelTransform< TElastix >
     poissonRatio, "SplinePoissonRatio", this->GetComponentLabel(), 0, -1 );
   this->m_KernelTransform->SetPoissonRatio( poissonRatio );
 
+  /** Set the matrix inversion method and the evaluation grid settings,
+   * before the source landmarks are set.
+   */
+  this->ReadSolverSettings( false );
+
   /** Read number of parameters. */
   unsigned int numberOfParameters = 0;
   this->GetConfiguration()->ReadParameter(
@@ -465,9 +467,182 @@ SplineKernelTransform< TElastix >
    */
   this->Superclass2::ReadFromFile();
 
+  if( this->m_KernelTransform->GetMatrixInversionMethod() == "Iterative" )
+  {
+    elxout << "  The iterative solver took "
+           << this->m_KernelTransform->GetNumberOfIterativeSolverIterations()
+           << " iterations, relative residual: "
+           << this->m_KernelTransform->GetIterativeSolverResidual() << std::endl;
+  }
+
+  /** Precompute the deformation on a grid, if requested. */
+  this->InitializeEvaluationGrid();
+
 } // ReadFromFile()
 
 
+/**
+ * ************************* ReadSolverSettings ************************
+ */
+
+template< class TElastix >
+void
+SplineKernelTransform< TElastix >
+::ReadSolverSettings( const bool forRegistration )
+{
+  /** Set the matrix inversion method (one of {SVD, QR, Iterative}). */
+  std::string matrixInversionMethod = "SVD";
+  this->GetConfiguration()->ReadParameter(
+    matrixInversionMethod, "TPSMatrixInversionMethod", 0, true );
+  if( matrixInversionMethod != "SVD" && matrixInversionMethod != "QR"
+    && matrixInversionMethod != "Iterative" )
+  {
+    xl::xout[ "error" ] << "ERROR: The TPSMatrixInversionMethod "
+                        << matrixInversionMethod << " is not supported." << std::endl;
+    itkExceptionMacro( << "ERROR: unable to configure "
+                       << this->GetComponentLabel() );
+  }
+  if( forRegistration && matrixInversionMethod == "Iterative" )
+  {
+    xl::xout[ "error" ] << "ERROR: The TPSMatrixInversionMethod Iterative cannot be "
+                        << "used for a registration, since it does not support the "
+                        << "Jacobian. Register with SVD or QR, and set Iterative in "
+                        << "the transform parameter file to apply the transform."
+                        << std::endl;
+    itkExceptionMacro( << "ERROR: unable to configure "
+                       << this->GetComponentLabel() );
+  }
+  this->m_KernelTransform->SetMatrixInversionMethod( matrixInversionMethod );
+
+  /** Settings of the iterative solver. */
+  double tolerance = this->m_KernelTransform->GetIterativeSolverTolerance();
+  this->GetConfiguration()->ReadParameter(
+    tolerance, "TPSIterativeSolverTolerance", 0, true );
+  this->m_KernelTransform->SetIterativeSolverTolerance( tolerance );
+
+  unsigned long maximumNumberOfIterations
+    = this->m_KernelTransform->GetMaximumNumberOfIterativeSolverIterations();
+  this->GetConfiguration()->ReadParameter(
+    maximumNumberOfIterations, "TPSMaximumNumberOfIterativeSolverIterations", 0, true );
+  this->m_KernelTransform->SetMaximumNumberOfIterativeSolverIterations( maximumNumberOfIterations );
+
+  /** Settings of the evaluation grid. */
+  double gridTolerance = 0.0;
+  this->GetConfiguration()->ReadParameter(
+    gridTolerance, "TPSEvaluationGridTolerance", 0, true );
+  this->m_KernelTransform->SetEvaluationGridTolerance( gridTolerance );
+
+  unsigned long maximumGridSize = this->m_KernelTransform->GetMaximumEvaluationGridSize();
+  this->GetConfiguration()->ReadParameter(
+    maximumGridSize, "TPSMaximumEvaluationGridSize", 0, true );
+  this->m_KernelTransform->SetMaximumEvaluationGridSize( maximumGridSize );
+
+} // end ReadSolverSettings()
+
+
+/**
+ * ************************* InitializeEvaluationGrid ************************
+ */
+
+template< class TElastix >
+void
+SplineKernelTransform< TElastix >
+::InitializeEvaluationGrid( void )
+{
+  if( this->m_KernelTransform->GetEvaluationGridTolerance() <= 0.0 )
+  {
+    return;
+  }
+
+  /** Read the image domain from the transform parameter file. */
+  typedef typename FixedImageType::SizeType      SizeType;
+  typedef typename FixedImageType::IndexType     IndexType;
+  typedef typename FixedImageType::SpacingType   SpacingType;
+  typedef typename FixedImageType::PointType     PointType;
+  typedef typename FixedImageType::DirectionType DirectionType;
+  typedef typename FixedImageType::RegionType    RegionType;
+
+  SizeType      size;
+  IndexType     index;
+  SpacingType   spacing;
+  PointType     origin;
+  DirectionType direction;
+  direction.SetIdentity();
+  for( unsigned int i = 0; i < SpaceDimension; i++ )
+  {
+    size[ i ] = 0;
+    this->GetConfiguration()->ReadParameter( size[ i ], "Size", i );
+    index[ i ] = 0;
+    this->GetConfiguration()->ReadParameter( index[ i ], "Index", i );
+    spacing[ i ] = 1.0;
+    this->GetConfiguration()->ReadParameter( spacing[ i ], "Spacing", i );
+    origin[ i ] = 0.0;
+    this->GetConfiguration()->ReadParameter( origin[ i ], "Origin", i );
+    for( unsigned int j = 0; j < SpaceDimension; j++ )
+    {
+      this->GetConfiguration()->ReadParameter( direction( j, i ),
+        "Direction", i * SpaceDimension + j );
+    }
+    if( size[ i ] == 0 )
+    {
+      xl::xout[ "warning" ] << "WARNING: The image size is not given, "
+                            << "so the evaluation grid is not used." << std::endl;
+      return;
+    }
+  }
+
+  /** The bounding box of the corners of the image domain. */
+  typedef typename FixedImageType::Pointer DummyImagePointer;
+  DummyImagePointer dummyImage = FixedImageType::New();
+  dummyImage->SetRegions( RegionType( index, size ) );
+  dummyImage->SetOrigin( origin );
+  dummyImage->SetSpacing( spacing );
+  dummyImage->SetDirection( direction );
+
+  InputPointType minimum, maximum, corner;
+  for( unsigned int c = 0; c < ( 1u << SpaceDimension ); ++c )
+  {
+    IndexType cornerIndex = index;
+    for( unsigned int i = 0; i < SpaceDimension; i++ )
+    {
+      if( c & ( 1u << i ) )
+      {
+        cornerIndex[ i ] += size[ i ] - 1;
+      }
+    }
+    dummyImage->TransformIndexToPhysicalPoint( cornerIndex, corner );
+    for( unsigned int i = 0; i < SpaceDimension; i++ )
+    {
+      minimum[ i ] = ( c == 0 ) ? corner[ i ] : std::min( minimum[ i ], corner[ i ] );
+      maximum[ i ] = ( c == 0 ) ? corner[ i ] : std::max( maximum[ i ], corner[ i ] );
+    }
+  }
+  this->m_KernelTransform->SetEvaluationGridRegion( minimum, maximum );
+
+  /** Compute the grid. */
+  itk::TimeProbe timer;
+  timer.Start();
+  const bool gridUsed = this->m_KernelTransform->ComputeEvaluationGrid();
+  timer.Stop();
+  if( gridUsed )
+  {
+    elxout << "  Computing the evaluation grid took: "
+           << this->ConvertSecondsToDHMS( timer.GetMean(), 6 ) << "\n"
+           << "  Grid spacing: " << this->m_KernelTransform->GetEvaluationGridSpacing()
+           << ", estimated maximum error: "
+           << this->m_KernelTransform->GetEvaluationGridError() << std::endl;
+  }
+  else
+  {
+    xl::xout[ "warning" ] << "WARNING: The TPSEvaluationGridTolerance could not be "
+                          << "reached within the TPSMaximumEvaluationGridSize "
+                          << "(estimated error " << this->m_KernelTransform->GetEvaluationGridError()
+                          << "), so the transform is evaluated exactly." << std::endl;
+  }
+
+} // end InitializeEvaluationGrid()
+
+
 /**
  * ************************* WriteToFile ************************
  * Save the kernel type and the source landmarks
@@ -494,6 +669,25 @@ SplineKernelTransform< TElastix >
   xl::xout[ "transpar" ] << "(SplineRelaxationFactor "
                          << this->m_KernelTransform->GetStiffness() << ")" << std::endl;
 
+  /** Write the solver and evaluation grid settings. */
+  xl::xout[ "transpar" ] << "(TPSMatrixInversionMethod \""
+                         << this->m_KernelTransform->GetMatrixInversionMethod() << "\")" << std::endl;
+  if( this->m_KernelTransform->GetMatrixInversionMethod() == "Iterative" )
+  {
+    xl::xout[ "transpar" ] << "(TPSIterativeSolverTolerance "
+                           << this->m_KernelTransform->GetIterativeSolverTolerance() << ")" << std::endl;
+    xl::xout[ "transpar" ] << "(TPSMaximumNumberOfIterativeSolverIterations "
+                           << this->m_KernelTransform->GetMaximumNumberOfIterativeSolverIterations()
+                           << ")" << std::endl;
+  }
+  if( this->m_KernelTransform->GetEvaluationGridTolerance() > 0.0 )
+  {
+    xl::xout[ "transpar" ] << "(TPSEvaluationGridTolerance "
+                           << this->m_KernelTransform->GetEvaluationGridTolerance() << ")" << std::endl;
+    xl::xout[ "transpar" ] << "(TPSMaximumEvaluationGridSize "
+                           << this->m_KernelTransform->GetMaximumEvaluationGridSize() << ")" << std::endl;
+  }
+
   /** Write the fixed image landmarks. */
   const ParametersType & fixedParams = this->m_KernelTransform->GetFixedParameters();
   xl::xout[ "transpar" ] << "(FixedImageLandmarks ";
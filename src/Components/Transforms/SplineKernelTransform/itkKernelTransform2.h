@@ -39,7 +39,11 @@ PURPOSE.  See the above copyright notices for more information.
 #include "itkVector.h"
 #include "itkMatrix.h"
 #include "itkPointSet.h"
+#include "itkImage.h"
+#include "itkMultiThreader.h"
+#include "itkBSplineInterpolationWeightFunction2.h"
 #include <deque>
+#include <vector>
 #include <math.h>
 #include "vnl/vnl_matrix_fixed.h"
 #include "vnl/vnl_matrix.h"
@@ -86,6 +90,9 @@ namespace itk
  * - Support for matrix inversion by QR decomposition, instead of SVD.
  *   QR is much faster. Used in SetParameters() and SetFixedParameters().
  * - Much faster Jacobian computation for some of the derived kernel transforms.
+ * - An iterative solver for large numbers of landmarks, which does not
+ *   compute L or its inverse, see SetMatrixInversionMethod().
+ * - An optional B-spline interpolated evaluation grid, see ComputeEvaluationGrid().
  *
  * \ingroup Transforms
  *
@@ -292,10 +299,73 @@ public:
   }
 
 
-  /** Matrix inversion by SVD or QR decomposition. */
+  /** Matrix inversion by SVD or QR decomposition, or "Iterative".
+   * SVD and QR store the dense L matrix and its inverse, which takes
+   * O(N^2) memory and O(N^3) time for N landmarks. The iterative method
+   * solves for the coefficients with MINRES, on the system projected on
+   * the null space of P^T, computing the kernel matrix products on the fly
+   * in multiple threads. It needs O(N) memory, and O(N^2) time per
+   * iteration. L and its inverse are not computed, so the Jacobian
+   * GetJacobian() is not available with this method.
+   */
   itkSetMacro( MatrixInversionMethod, std::string );
   itkGetConstReferenceMacro( MatrixInversionMethod, std::string );
 
+  /** The iterative solver stops when the norm of the residual, relative
+   * to the norm of the projected displacements, is below this tolerance.
+   * Default: 1e-6.
+   */
+  itkSetMacro( IterativeSolverTolerance, double );
+  itkGetConstMacro( IterativeSolverTolerance, double );
+
+  /** The maximum number of iterations of the iterative solver. Default: 10000. */
+  itkSetMacro( MaximumNumberOfIterativeSolverIterations, unsigned long );
+  itkGetConstMacro( MaximumNumberOfIterativeSolverIterations, unsigned long );
+
+  /** The number of iterations and the relative residual of the last
+   * iterative solve.
+   */
+  itkGetConstMacro( NumberOfIterativeSolverIterations, unsigned long );
+  itkGetConstMacro( IterativeSolverResidual, double );
+
+  /** Set the bounding box of the points that are going to be transformed,
+   * for the evaluation grid.
+   */
+  virtual void SetEvaluationGridRegion(
+    const InputPointType & minimum, const InputPointType & maximum );
+
+  /** The maximum error of the evaluation grid. The grid is only used when
+   * it is positive. Default: 0.
+   */
+  itkSetMacro( EvaluationGridTolerance, double );
+  itkGetConstMacro( EvaluationGridTolerance, double );
+
+  /** The maximum number of grid nodes. Default: 2^22. */
+  itkSetMacro( MaximumEvaluationGridSize, unsigned long );
+  itkGetConstMacro( MaximumEvaluationGridSize, unsigned long );
+
+  /** Sample the deformation part of the transform on a regular grid over
+   * the evaluation grid region, and interpolate it with cubic B-splines in
+   * TransformPoint(), which then costs 4^D instead of N kernel evaluations.
+   * The affine part is still evaluated exactly, and points outside the
+   * region are transformed exactly.
+   *
+   * The grid spacing starts at the mean landmark distance, and is halved
+   * until the error, estimated at the centres of grid cells and at the
+   * landmarks, is below the EvaluationGridTolerance. If that would take more
+   * than MaximumEvaluationGridSize nodes, the grid is not used and false is
+   * returned. Call this after the parameters are set; setting parameters
+   * discards the grid.
+   */
+  virtual bool ComputeEvaluationGrid( void );
+
+  /** Whether the evaluation grid is used, the estimated maximum error of
+   * the last computed grid, and its spacing.
+   */
+  itkGetConstMacro( EvaluationGridComputed, bool );
+  itkGetConstMacro( EvaluationGridError, double );
+  itkGetConstMacro( EvaluationGridSpacing, double );
+
   /** Must be provided. */
   virtual void GetSpatialJacobian(
     const InputPointType & ipp, SpatialJacobianType & sj ) const
@@ -420,6 +490,16 @@ protected:
     const InputPointType & inputPoint,
     OutputPointType & result ) const;
 
+  /** Add the deformation contribution, interpolated from the evaluation
+   * grid. Returns false if the point is outside the evaluation grid region.
+   */
+  bool EvaluateDeformationOnGrid(
+    const InputPointType & inputPoint,
+    OutputPointType & result ) const;
+
+  /** Compute W with the iterative solver. */
+  void ComputeWMatrixIteratively( void );
+
   /** Compute K matrix. */
   void ComputeK( void );
 
@@ -511,6 +591,65 @@ protected:
   /** Identity matrix. */
   IMatrixType m_I;
 
+  /** Typedefs for the multi-threaded parts. */
+  typedef MultiThreader                   ThreaderType;
+  typedef ThreaderType::ThreadInfoStruct  ThreadInfoType;
+
+  /** The data of the multi-threaded product of K with a vector. */
+  struct KProductThreaderParameterType
+  {
+    Self *                        m_Transform;
+    std::vector< InputPointType > m_Points;
+    std::vector< GMatrixType >    m_ReflexiveG;
+    const TScalarType *           m_Input;
+    TScalarType *                 m_Output;
+  };
+
+  /** Compute output = K input, without storing K. */
+  void ComputeKProduct( KProductThreaderParameterType & parameters,
+    const vnl_vector< TScalarType > & input, vnl_vector< TScalarType > & output );
+
+  static ITK_THREAD_RETURN_TYPE ComputeKProductThreaderCallback( void * arg );
+
+  /** Typedefs for the evaluation grid. The deformation contribution of each
+   * dimension is stored as an image of B-spline coefficients.
+   */
+  typedef Image< TScalarType, NDimensions >                   EvaluationGridImageType;
+  typedef typename EvaluationGridImageType::Pointer           EvaluationGridImagePointer;
+  typedef typename EvaluationGridImageType::RegionType        EvaluationGridRegionType;
+  typedef typename EvaluationGridImageType::IndexType         EvaluationGridIndexType;
+  typedef typename EvaluationGridImageType::SizeType          EvaluationGridSizeType;
+  typedef typename EvaluationGridImageType::PointType         EvaluationGridPointType;
+  typedef BSplineInterpolationWeightFunction2<
+    TScalarType, NDimensions, 3 >                             EvaluationGridWeightFunctionType;
+  typedef typename EvaluationGridWeightFunctionType::Pointer  EvaluationGridWeightFunctionPointer;
+  typedef typename EvaluationGridWeightFunctionType::WeightsType
+    EvaluationGridWeightsType;
+  typedef typename EvaluationGridWeightFunctionType::ContinuousIndexType
+    EvaluationGridContinuousIndexType;
+
+  /** The data of the multi-threaded sampling of the evaluation grid. */
+  struct EvaluationGridThreaderParameterType
+  {
+    Self *                  m_Transform;
+    EvaluationGridSizeType  m_Size;
+    TScalarType *           m_Buffers[ NDimensions ];
+  };
+
+  /** Sample the deformation contribution on the grid with the given
+   * spacing, and compute the B-spline coefficients. Returns false if the
+   * grid would have more than MaximumEvaluationGridSize nodes.
+   */
+  bool ComputeEvaluationGridCoefficients( const double spacing );
+
+  /** Estimate the maximum error of the evaluation grid. */
+  double EstimateEvaluationGridError( void ) const;
+
+  static ITK_THREAD_RETURN_TYPE ComputeEvaluationGridThreaderCallback( void * arg );
+
+  /** Threader for the iterative solver and the evaluation grid. */
+  ThreaderType::Pointer m_Threader;
+
   /** Precomputed nonzero Jacobian indices (simply all params) */
   NonZeroJacobianIndicesType m_NonZeroJacobianIndices;
 
@@ -529,9 +668,28 @@ private:
 
   TScalarType m_PoissonRatio;
 
-  /** Using SVD or QR decomposition. */
+  /** Using SVD or QR decomposition, or the iterative solver. */
   std::string m_MatrixInversionMethod;
 
+  /** Settings and results of the iterative solver. */
+  double        m_IterativeSolverTolerance;
+  unsigned long m_MaximumNumberOfIterativeSolverIterations;
+  unsigned long m_NumberOfIterativeSolverIterations;
+  double        m_IterativeSolverResidual;
+
+  /** The evaluation grid. */
+  double                              m_EvaluationGridTolerance;
+  unsigned long                       m_MaximumEvaluationGridSize;
+  bool                                m_EvaluationGridRegionSet;
+  InputPointType                      m_EvaluationGridMinimum;
+  InputPointType                      m_EvaluationGridMaximum;
+  bool                                m_EvaluationGridComputed;
+  double                              m_EvaluationGridError;
+  double                              m_EvaluationGridSpacing;
+  EvaluationGridPointType             m_EvaluationGridOrigin;
+  EvaluationGridImagePointer          m_EvaluationGridImages[ NDimensions ];
+  EvaluationGridWeightFunctionPointer m_EvaluationGridWeightFunction;
+
 };
 
 } // end namespace itk
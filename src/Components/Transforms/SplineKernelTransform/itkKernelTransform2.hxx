@@ -35,6 +35,11 @@ PURPOSE.  See the above copyright notices for more information.
 #define _itkKernelTransform2_hxx
 
 #include "itkKernelTransform2.h"
+#include "itkBSplineDecompositionImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+
+#include <algorithm>
+#include <cmath>
 
 namespace itk
 {
@@ -71,6 +76,24 @@ KernelTransform2< TScalarType, NDimensions >
   this->m_MatrixInversionMethod   = "SVD";
   this->m_FastComputationPossible = false;
 
+  this->m_IterativeSolverTolerance                 = 1e-6;
+  this->m_MaximumNumberOfIterativeSolverIterations = 10000;
+  this->m_NumberOfIterativeSolverIterations        = 0;
+  this->m_IterativeSolverResidual                  = 0.0;
+
+  this->m_EvaluationGridTolerance   = 0.0;
+  this->m_MaximumEvaluationGridSize = 1UL << 22;
+  this->m_EvaluationGridRegionSet   = false;
+  this->m_EvaluationGridComputed    = false;
+  this->m_EvaluationGridError       = 0.0;
+  this->m_EvaluationGridSpacing     = 0.0;
+  this->m_EvaluationGridMinimum.Fill( 0.0 );
+  this->m_EvaluationGridMaximum.Fill( 0.0 );
+  this->m_EvaluationGridOrigin.Fill( 0.0 );
+  this->m_EvaluationGridWeightFunction = EvaluationGridWeightFunctionType::New();
+
+  this->m_Threader = ThreaderType::New();
+
   this->m_HasNonZeroSpatialHessian           = true;
   this->m_HasNonZeroJacobianOfSpatialHessian = true;
 
@@ -251,6 +274,16 @@ void
 KernelTransform2< TScalarType, NDimensions >
 ::ComputeWMatrix( void )
 {
+  /** The iterative solver does not need L. */
+  if( this->m_MatrixInversionMethod == "Iterative" )
+  {
+    this->ComputeY();
+    this->ComputeWMatrixIteratively();
+    this->ReorganizeW();
+    this->m_WMatrixComputed = true;
+    return;
+  }
+
   /** Compute L and Y. */
   if( !this->m_LMatrixComputed )
   {
@@ -311,6 +344,14 @@ void
 KernelTransform2< TScalarType, NDimensions >
 ::ComputeLInverse( void )
 {
+  /** The iterative solver computes neither L nor its inverse. */
+  if( this->m_MatrixInversionMethod == "Iterative" )
+  {
+    this->m_LMatrixInverse.set_size( 0, 0 );
+    this->m_LInverseComputed = false;
+    return;
+  }
+
   if( !this->m_LMatrixComputed )
   {
     this->ComputeL();
@@ -524,6 +565,9 @@ KernelTransform2< TScalarType, NDimensions >
   this->m_WMatrix         = WMatrixType( 1, 1 );
   this->m_WMatrixComputed = true;
 
+  // the evaluation grid belongs to the previous coefficients
+  this->m_EvaluationGridComputed = false;
+
 } // end ReorganizeW()
 
 
@@ -538,7 +582,11 @@ KernelTransform2< TScalarType, NDimensions >
 {
   OutputPointType opp;
   opp.Fill( NumericTraits< typename OutputPointType::ValueType >::ZeroValue() );
-  this->ComputeDeformationContribution( thisPoint, opp );
+  if( !this->m_EvaluationGridComputed
+    || !this->EvaluateDeformationOnGrid( thisPoint, opp ) )
+  {
+    this->ComputeDeformationContribution( thisPoint, opp );
+  }
 
   // Add the rotational part of the Affine component
   for( unsigned int j = 0; j < NDimensions; j++ )
@@ -754,6 +802,12 @@ KernelTransform2< TScalarType, NDimensions >
 ::GetJacobian( const InputPointType & p, JacobianType & jac,
   NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const
 {
+  if( this->m_MatrixInversionMethod == "Iterative" )
+  {
+    itkExceptionMacro( << "ERROR: the Jacobian needs the inverse of the L matrix, "
+                       << "which is not computed by the iterative solver." );
+  }
+
   const unsigned long numberOfLandmarks = this->m_SourceLandmarks->GetNumberOfPoints();
   jac.SetSize( NDimensions, numberOfLandmarks * NDimensions );
   jac.Fill( 0.0 );
@@ -888,6 +942,550 @@ KernelTransform2< TScalarType, NDimensions >
 } // end GetJacobian()
 
 
+/**
+ * ******************* ComputeWMatrixIteratively *******************
+ *
+ * Solves L [c; a] = [y; 0] without forming L. With the projection
+ * Pi = I - P (P^T P)^+ P^T on the null space of P^T, the deformation
+ * coefficients satisfy Pi K Pi c = Pi y. This system is symmetric, but
+ * not definite for all kernels, so it is solved with MINRES (Paige and
+ * Saunders, 1975). The affine coefficients then follow from
+ * a = (P^T P)^+ P^T (y - K c).
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+void
+KernelTransform2< TScalarType, NDimensions >
+::ComputeWMatrixIteratively( void )
+{
+  typedef vnl_vector< TScalarType > VectorType;
+
+  const unsigned long numberOfLandmarks = this->m_SourceLandmarks->GetNumberOfPoints();
+  const unsigned long n                 = numberOfLandmarks * NDimensions;
+  const unsigned int  m                 = NDimensions * ( NDimensions + 1 );
+
+  /** Q = P (P^T P)^+, so that Pi v = v - Q P^T v. */
+  this->ComputeP();
+  const PMatrixType PT         = this->m_PMatrix.transpose();
+  const PMatrixType PTPInverse = vnl_svd< TScalarType >( PT * this->m_PMatrix, -1e-12 ).pinverse();
+  const PMatrixType Q          = this->m_PMatrix * PTPInverse;
+
+  /** Store the landmarks and the block diagonal of K for the products with K. */
+  KProductThreaderParameterType parameters;
+  parameters.m_Transform = this;
+  parameters.m_Points.resize( numberOfLandmarks );
+  parameters.m_ReflexiveG.resize( numberOfLandmarks );
+  PointsIterator sp = this->m_SourceLandmarks->GetPoints()->Begin();
+  for( unsigned long i = 0; i < numberOfLandmarks; ++i, ++sp )
+  {
+    parameters.m_Points[ i ] = sp->Value();
+    this->ComputeReflexiveG( sp, parameters.m_ReflexiveG[ i ] );
+  }
+
+  /** The right hand side: the projected displacements. */
+  VectorType y( n );
+  for( unsigned long i = 0; i < n; ++i )
+  {
+    y[ i ] = this->m_YMatrix( i, 0 );
+  }
+  const VectorType b = y - Q * ( PT * y );
+
+  /** MINRES, in the notation of Paige and Saunders. z is the unnormalized
+   * Lanczos vector, and v the normalized one.
+   */
+  VectorType        c( n, 0.0 );
+  const TScalarType beta1 = b.two_norm();
+  this->m_NumberOfIterativeSolverIterations = 0;
+  this->m_IterativeSolverResidual           = 0.0;
+  if( beta1 > 0.0 )
+  {
+    VectorType  r1 = b;
+    VectorType  r2 = b;
+    VectorType  z  = b;
+    VectorType  v( n ), pv( n ), w( n, 0.0 ), w1( n ), w2( n, 0.0 );
+    TScalarType oldb   = 0.0;
+    TScalarType beta   = beta1;
+    TScalarType dbar   = 0.0;
+    TScalarType epsln  = 0.0;
+    TScalarType phibar = beta1;
+    TScalarType cs     = -1.0;
+    TScalarType sn     = 0.0;
+
+    while( this->m_NumberOfIterativeSolverIterations
+      < this->m_MaximumNumberOfIterativeSolverIterations )
+    {
+      ++this->m_NumberOfIterativeSolverIterations;
+
+      /** Lanczos step: z = Pi K Pi v - (alfa / beta) r2 - (beta / oldb) r1. */
+      v  = z / beta;
+      pv = v - Q * ( PT * v );
+      this->ComputeKProduct( parameters, pv, z );
+      z -= Q * ( PT * z );
+      if( this->m_NumberOfIterativeSolverIterations > 1 )
+      {
+        z -= ( beta / oldb ) * r1;
+      }
+      const TScalarType alfa = dot_product( v, z );
+      z   -= ( alfa / beta ) * r2;
+      r1   = r2;
+      r2   = z;
+      oldb = beta;
+      beta = z.two_norm();
+
+      /** Apply the previous rotation, and compute the next one. */
+      const TScalarType oldeps = epsln;
+      const TScalarType delta  = cs * dbar + sn * alfa;
+      const TScalarType gbar   = sn * dbar - cs * alfa;
+      epsln = sn * beta;
+      dbar  = -cs * beta;
+      const TScalarType gamma = std::max(
+        static_cast< TScalarType >( std::sqrt( gbar * gbar + beta * beta ) ),
+        NumericTraits< TScalarType >::min() );
+      cs = gbar / gamma;
+      sn = beta / gamma;
+      const TScalarType phi = cs * phibar;
+      phibar = sn * phibar;
+
+      /** Update the solution. phibar is the norm of the residual. */
+      w1 = w2;
+      w2 = w;
+      w  = ( v - oldeps * w1 - delta * w2 ) / gamma;
+      c += phi * w;
+
+      if( phibar <= this->m_IterativeSolverTolerance * beta1 || beta == 0.0 )
+      {
+        break;
+      }
+    }
+    this->m_IterativeSolverResidual = phibar / beta1;
+
+    /** Remove the component in the range of P that builds up by rounding errors. */
+    c -= Q * ( PT * c );
+  }
+
+  /** The affine part. */
+  VectorType Kc( n );
+  this->ComputeKProduct( parameters, c, Kc );
+  const VectorType a = PTPInverse * ( PT * ( y - Kc ) );
+
+  /** Assemble W = [c; a], as expected by ReorganizeW(). */
+  this->m_WMatrix.set_size( n + m, 1 );
+  for( unsigned long i = 0; i < n; ++i )
+  {
+    this->m_WMatrix( i, 0 ) = c[ i ];
+  }
+  for( unsigned int i = 0; i < m; ++i )
+  {
+    this->m_WMatrix( n + i, 0 ) = a[ i ];
+  }
+
+} // end ComputeWMatrixIteratively()
+
+
+/**
+ * ******************* ComputeKProduct *******************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+void
+KernelTransform2< TScalarType, NDimensions >
+::ComputeKProduct( KProductThreaderParameterType & parameters,
+  const vnl_vector< TScalarType > & input, vnl_vector< TScalarType > & output )
+{
+  output.set_size( input.size() );
+  parameters.m_Input  = input.data_block();
+  parameters.m_Output = output.data_block();
+
+  this->m_Threader->SetSingleMethod( Self::ComputeKProductThreaderCallback, &parameters );
+  this->m_Threader->SingleMethodExecute();
+
+} // end ComputeKProduct()
+
+
+/**
+ * ******************* ComputeKProductThreaderCallback *******************
+ *
+ * Each thread computes the rows of a range of landmarks, so the kernel is
+ * evaluated N^2 times in total, but nothing is written concurrently.
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+ITK_THREAD_RETURN_TYPE
+KernelTransform2< TScalarType, NDimensions >
+::ComputeKProductThreaderCallback( void * arg )
+{
+  ThreadInfoType *   infoStruct  = static_cast< ThreadInfoType * >( arg );
+  const ThreadIdType threadID    = infoStruct->ThreadID;
+  const ThreadIdType nrOfThreads = infoStruct->NumberOfThreads;
+
+  KProductThreaderParameterType * parameters
+    = static_cast< KProductThreaderParameterType * >( infoStruct->UserData );
+
+  const unsigned long numberOfLandmarks = parameters->m_Points.size();
+  const unsigned long begin             = numberOfLandmarks * threadID / nrOfThreads;
+  const unsigned long end               = numberOfLandmarks * ( threadID + 1 ) / nrOfThreads;
+
+  GMatrixType G;
+  for( unsigned long i = begin; i < end; ++i )
+  {
+    TScalarType sum[ NDimensions ];
+    std::fill( sum, sum + NDimensions, NumericTraits< TScalarType >::ZeroValue() );
+
+    for( unsigned long j = 0; j < numberOfLandmarks; ++j )
+    {
+      if( j != i )
+      {
+        parameters->m_Transform->ComputeG(
+          parameters->m_Points[ i ] - parameters->m_Points[ j ], G );
+      }
+      const GMatrixType & Gij   = ( j == i ) ? parameters->m_ReflexiveG[ i ] : G;
+      const TScalarType * input = parameters->m_Input + j * NDimensions;
+      for( unsigned int r = 0; r < NDimensions; ++r )
+      {
+        for( unsigned int c = 0; c < NDimensions; ++c )
+        {
+          sum[ r ] += Gij( r, c ) * input[ c ];
+        }
+      }
+    }
+
+    std::copy( sum, sum + NDimensions, parameters->m_Output + i * NDimensions );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ComputeKProductThreaderCallback()
+
+
+/**
+ * ******************* SetEvaluationGridRegion *******************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+void
+KernelTransform2< TScalarType, NDimensions >
+::SetEvaluationGridRegion( const InputPointType & minimum, const InputPointType & maximum )
+{
+  this->m_EvaluationGridMinimum   = minimum;
+  this->m_EvaluationGridMaximum   = maximum;
+  this->m_EvaluationGridRegionSet = true;
+  this->m_EvaluationGridComputed  = false;
+  this->Modified();
+
+} // end SetEvaluationGridRegion()
+
+
+/**
+ * ******************* ComputeEvaluationGrid *******************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+bool
+KernelTransform2< TScalarType, NDimensions >
+::ComputeEvaluationGrid( void )
+{
+  this->m_EvaluationGridComputed = false;
+  this->m_EvaluationGridError    = 0.0;
+
+  const unsigned long numberOfLandmarks = this->m_SourceLandmarks->GetNumberOfPoints();
+  if( this->m_EvaluationGridTolerance <= 0.0 || !this->m_EvaluationGridRegionSet
+    || !this->m_WMatrixComputed || numberOfLandmarks == 0 )
+  {
+    return false;
+  }
+
+  /** Start with the mean distance between the landmarks in the region. */
+  double volume        = 1.0;
+  double maximumExtent = 0.0;
+  for( unsigned int d = 0; d < NDimensions; ++d )
+  {
+    const double extent = this->m_EvaluationGridMaximum[ d ] - this->m_EvaluationGridMinimum[ d ];
+    if( extent < 0.0 )
+    {
+      itkExceptionMacro( << "ERROR: the evaluation grid region is empty." );
+    }
+    volume       *= extent;
+    maximumExtent = std::max( maximumExtent, extent );
+  }
+  if( maximumExtent == 0.0 )
+  {
+    return false;
+  }
+  double spacing = maximumExtent;
+  if( volume > 0.0 )
+  {
+    spacing = std::min( spacing,
+      std::pow( volume / numberOfLandmarks, 1.0 / NDimensions ) );
+  }
+
+  /** Halve the spacing until the error is small enough, or the grid too big. */
+  while( this->ComputeEvaluationGridCoefficients( spacing ) )
+  {
+    this->m_EvaluationGridError = this->EstimateEvaluationGridError();
+    if( this->m_EvaluationGridError <= this->m_EvaluationGridTolerance )
+    {
+      this->m_EvaluationGridComputed = true;
+      return true;
+    }
+    spacing *= 0.5;
+  }
+
+  /** Release the memory of the grid. */
+  for( unsigned int d = 0; d < NDimensions; ++d )
+  {
+    this->m_EvaluationGridImages[ d ] = 0;
+  }
+  return false;
+
+} // end ComputeEvaluationGrid()
+
+
+/**
+ * ******************* ComputeEvaluationGridCoefficients *******************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+bool
+KernelTransform2< TScalarType, NDimensions >
+::ComputeEvaluationGridCoefficients( const double spacing )
+{
+  /** Add two nodes on each side of the region, so that the support of the
+   * B-splines of the points in the region lies within the grid.
+   */
+  const unsigned int     margin        = 2;
+  EvaluationGridSizeType size;
+  EvaluationGridPointType origin;
+  double                 numberOfNodes = 1.0;
+  for( unsigned int d = 0; d < NDimensions; ++d )
+  {
+    const double extent = this->m_EvaluationGridMaximum[ d ] - this->m_EvaluationGridMinimum[ d ];
+    size[ d ]      = static_cast< SizeValueType >( std::ceil( extent / spacing ) ) + 1 + 2 * margin;
+    origin[ d ]    = this->m_EvaluationGridMinimum[ d ] - margin * spacing;
+    numberOfNodes *= size[ d ];
+  }
+  if( numberOfNodes > this->m_MaximumEvaluationGridSize )
+  {
+    return false;
+  }
+  this->m_EvaluationGridOrigin  = origin;
+  this->m_EvaluationGridSpacing = spacing;
+
+  /** Sample the deformation contribution in multiple threads. */
+  EvaluationGridRegionType region;
+  region.SetSize( size );
+  typename EvaluationGridImageType::SpacingType gridSpacing;
+  gridSpacing.Fill( spacing );
+
+  EvaluationGridThreaderParameterType parameters;
+  parameters.m_Transform = this;
+  parameters.m_Size      = size;
+  EvaluationGridImagePointer samples[ NDimensions ];
+  for( unsigned int d = 0; d < NDimensions; ++d )
+  {
+    samples[ d ] = EvaluationGridImageType::New();
+    samples[ d ]->SetRegions( region );
+    samples[ d ]->SetOrigin( origin );
+    samples[ d ]->SetSpacing( gridSpacing );
+    samples[ d ]->Allocate();
+    parameters.m_Buffers[ d ] = samples[ d ]->GetBufferPointer();
+  }
+
+  this->m_Threader->SetSingleMethod( Self::ComputeEvaluationGridThreaderCallback, &parameters );
+  this->m_Threader->SingleMethodExecute();
+
+  /** Compute the B-spline coefficients that interpolate the samples. */
+  typedef BSplineDecompositionImageFilter<
+    EvaluationGridImageType, EvaluationGridImageType > DecompositionFilterType;
+  for( unsigned int d = 0; d < NDimensions; ++d )
+  {
+    typename DecompositionFilterType::Pointer decomposition = DecompositionFilterType::New();
+    decomposition->SetSplineOrder( 3 );
+    decomposition->SetInput( samples[ d ] );
+    decomposition->Update();
+    this->m_EvaluationGridImages[ d ] = decomposition->GetOutput();
+  }
+
+  return true;
+
+} // end ComputeEvaluationGridCoefficients()
+
+
+/**
+ * ******************* ComputeEvaluationGridThreaderCallback *******************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+ITK_THREAD_RETURN_TYPE
+KernelTransform2< TScalarType, NDimensions >
+::ComputeEvaluationGridThreaderCallback( void * arg )
+{
+  ThreadInfoType *   infoStruct  = static_cast< ThreadInfoType * >( arg );
+  const ThreadIdType threadID    = infoStruct->ThreadID;
+  const ThreadIdType nrOfThreads = infoStruct->NumberOfThreads;
+
+  EvaluationGridThreaderParameterType * parameters
+    = static_cast< EvaluationGridThreaderParameterType * >( infoStruct->UserData );
+  const Self * transform = parameters->m_Transform;
+
+  unsigned long numberOfNodes = 1;
+  for( unsigned int d = 0; d < NDimensions; ++d )
+  {
+    numberOfNodes *= parameters->m_Size[ d ];
+  }
+  const unsigned long begin = numberOfNodes * threadID / nrOfThreads;
+  const unsigned long end   = numberOfNodes * ( threadID + 1 ) / nrOfThreads;
+
+  InputPointType  point;
+  OutputPointType opp;
+  for( unsigned long node = begin; node < end; ++node )
+  {
+    /** The first dimension runs fastest, as in the image buffer. */
+    unsigned long rest = node;
+    for( unsigned int d = 0; d < NDimensions; ++d )
+    {
+      point[ d ] = transform->m_EvaluationGridOrigin[ d ]
+        + ( rest % parameters->m_Size[ d ] ) * transform->m_EvaluationGridSpacing;
+      rest /= parameters->m_Size[ d ];
+    }
+
+    opp.Fill( NumericTraits< typename OutputPointType::ValueType >::ZeroValue() );
+    transform->ComputeDeformationContribution( point, opp );
+    for( unsigned int d = 0; d < NDimensions; ++d )
+    {
+      parameters->m_Buffers[ d ][ node ] = opp[ d ];
+    }
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ComputeEvaluationGridThreaderCallback()
+
+
+/**
+ * ******************* EstimateEvaluationGridError *******************
+ *
+ * The error is largest halfway between the grid nodes, and, for kernels
+ * that are not smooth at the origin, near the landmarks. So the maximum
+ * error is estimated at the centres of (at most) 1024 grid cells, spread
+ * over the region, and at (at most) 1024 landmarks in the region.
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+double
+KernelTransform2< TScalarType, NDimensions >
+::EstimateEvaluationGridError( void ) const
+{
+  const unsigned long maximumNumberOfSamples = 1024;
+  std::vector< InputPointType > samples;
+
+  /** The centres of the grid cells. */
+  unsigned long numberOfCellsPerDimension[ NDimensions ];
+  double        numberOfCells = 1.0;
+  for( unsigned int d = 0; d < NDimensions; ++d )
+  {
+    const double extent = this->m_EvaluationGridMaximum[ d ] - this->m_EvaluationGridMinimum[ d ];
+    numberOfCellsPerDimension[ d ] = std::max( 1UL,
+      static_cast< unsigned long >( std::ceil( extent / this->m_EvaluationGridSpacing ) ) );
+    numberOfCells *= numberOfCellsPerDimension[ d ];
+  }
+  const unsigned long numberOfCellSamples = static_cast< unsigned long >(
+    std::min( numberOfCells, static_cast< double >( maximumNumberOfSamples ) ) );
+  InputPointType point;
+  for( unsigned long s = 0; s < numberOfCellSamples; ++s )
+  {
+    unsigned long rest = static_cast< unsigned long >( s * numberOfCells / numberOfCellSamples );
+    for( unsigned int d = 0; d < NDimensions; ++d )
+    {
+      const double cellIndex = static_cast< double >( rest % numberOfCellsPerDimension[ d ] );
+      rest    /= numberOfCellsPerDimension[ d ];
+      point[ d ] = std::min(
+        this->m_EvaluationGridMinimum[ d ] + ( cellIndex + 0.5 ) * this->m_EvaluationGridSpacing,
+        static_cast< double >( this->m_EvaluationGridMaximum[ d ] ) );
+    }
+    samples.push_back( point );
+  }
+
+  /** The landmarks. */
+  const unsigned long numberOfLandmarks = this->m_SourceLandmarks->GetNumberOfPoints();
+  const unsigned long step              = numberOfLandmarks / maximumNumberOfSamples + 1;
+  for( unsigned long i = 0; i < numberOfLandmarks; i += step )
+  {
+    this->m_SourceLandmarks->GetPoint( i, &point );
+    samples.push_back( point );
+  }
+
+  /** Compare the interpolated and exact deformation contribution. */
+  double maximumError = 0.0;
+  for( std::size_t i = 0; i < samples.size(); ++i )
+  {
+    OutputPointType exact, interpolated;
+    exact.Fill( NumericTraits< typename OutputPointType::ValueType >::ZeroValue() );
+    interpolated.Fill( NumericTraits< typename OutputPointType::ValueType >::ZeroValue() );
+    if( this->EvaluateDeformationOnGrid( samples[ i ], interpolated ) )
+    {
+      this->ComputeDeformationContribution( samples[ i ], exact );
+      maximumError = std::max( maximumError,
+        static_cast< double >( exact.EuclideanDistanceTo( interpolated ) ) );
+    }
+  }
+
+  return maximumError;
+
+} // end EstimateEvaluationGridError()
+
+
+/**
+ * ******************* EvaluateDeformationOnGrid *******************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+bool
+KernelTransform2< TScalarType, NDimensions >
+::EvaluateDeformationOnGrid(
+  const InputPointType & thisPoint, OutputPointType & opp ) const
+{
+  EvaluationGridContinuousIndexType cindex;
+  for( unsigned int d = 0; d < NDimensions; ++d )
+  {
+    if( thisPoint[ d ] < this->m_EvaluationGridMinimum[ d ]
+      || thisPoint[ d ] > this->m_EvaluationGridMaximum[ d ] )
+    {
+      return false;
+    }
+    cindex[ d ] = ( thisPoint[ d ] - this->m_EvaluationGridOrigin[ d ] )
+      / this->m_EvaluationGridSpacing;
+  }
+
+  EvaluationGridIndexType startIndex;
+  this->m_EvaluationGridWeightFunction->ComputeStartIndex( cindex, startIndex );
+  EvaluationGridWeightsType weights( this->m_EvaluationGridWeightFunction->GetNumberOfWeights() );
+  this->m_EvaluationGridWeightFunction->Evaluate( cindex, startIndex, weights );
+
+  /** The weights are ordered with the first dimension running fastest,
+   * like the iterator.
+   */
+  const EvaluationGridRegionType supportRegion(
+    startIndex, this->m_EvaluationGridWeightFunction->GetSupportSize() );
+  for( unsigned int d = 0; d < NDimensions; ++d )
+  {
+    ImageRegionConstIterator< EvaluationGridImageType > it(
+      this->m_EvaluationGridImages[ d ], supportRegion );
+    double        value = 0.0;
+    unsigned long k     = 0;
+    while( !it.IsAtEnd() )
+    {
+      value += weights[ k ] * it.Get();
+      ++k;
+      ++it;
+    }
+    opp[ d ] += value;
+  }
+
+  return true;
+
+} // end EvaluateDeformationOnGrid()
+
+
 /**
  * ******************* PrintSelf *******************
  */
@@ -923,6 +1521,27 @@ KernelTransform2< TScalarType, NDimensions >
      << this->m_PoissonRatio << std::endl;
   os << indent << "MatrixInversionMethod: "
      << this->m_MatrixInversionMethod << std::endl;
+  os << indent << "IterativeSolverTolerance: "
+     << this->m_IterativeSolverTolerance << std::endl;
+  os << indent << "MaximumNumberOfIterativeSolverIterations: "
+     << this->m_MaximumNumberOfIterativeSolverIterations << std::endl;
+  os << indent << "NumberOfIterativeSolverIterations: "
+     << this->m_NumberOfIterativeSolverIterations << std::endl;
+  os << indent << "IterativeSolverResidual: "
+     << this->m_IterativeSolverResidual << std::endl;
+  os << indent << "EvaluationGridTolerance: "
+     << this->m_EvaluationGridTolerance << std::endl;
+  os << indent << "MaximumEvaluationGridSize: "
+     << this->m_MaximumEvaluationGridSize << std::endl;
+  os << indent << "EvaluationGridRegion: "
+     << this->m_EvaluationGridMinimum << " - "
+     << this->m_EvaluationGridMaximum << std::endl;
+  os << indent << "EvaluationGridComputed: "
+     << this->m_EvaluationGridComputed << std::endl;
+  os << indent << "EvaluationGridError: "
+     << this->m_EvaluationGridError << std::endl;
+  os << indent << "EvaluationGridSpacing: "
+     << this->m_EvaluationGridSpacing << std::endl;
 
   /** Just print the sizes of these matrices, not their contents. */
   os << indent << "LMatrix: " << this->m_LMatrix.rows()
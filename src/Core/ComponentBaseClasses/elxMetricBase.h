@@ -64,6 +64,36 @@ namespace elastix
  *    CheckNumberOfSamples. \n
  *    example: <tt>(RequiredRatioOfValidSamples 0.1)</tt> \n
  *    The default is 0.25.
+ * \parameter UseImageSampleArrays: Whether the metric stores the image samples
+ *    as separate, aligned arrays of coordinates and values, instead of an array of
+ *    samples. This reduces the memory traffic in the loop over the samples. The
+ *    samples are only copied once they are used for a second time, so this does not
+ *    cost anything for samplers that select new samples every iteration. It is
+ *    only used by metrics that support it, like the AdvancedMeanSquares metric.
+ *    Can be given for each resolution or for all resolutions at once. \n
+ *    example: <tt>(UseImageSampleArrays "true")</tt> \n
+ *    The default is false.
+ * \parameter UseBSplineSupportCache: Whether the metric precomputes, once per
+ *    resolution, the B-spline weights and coefficient indices of all samples.
+ *    This is only done for a B-spline transform and an image sampler that selects
+ *    the same samples in each iteration, such as the Full and Grid samplers.
+ *    Can be given for each resolution or for all resolutions at once. \n
+ *    example: <tt>(UseBSplineSupportCache "true")</tt> \n
+ *    The default is false.
+ * \parameter BSplineSupportCacheMaximumMemory: The maximum memory in MB used by
+ *    the B-spline support cache. Samples that do not fit are computed as usual. \n
+ *    example: <tt>(BSplineSupportCacheMaximumMemory 1024)</tt> \n
+ *    The default is 512.
+ * \parameter UseTransformEvaluationCache: Whether the metric stores the mapped
+ *    sample points for the current transform parameters. Metrics that use the same
+ *    image sampler, e.g. the channels of a multi-metric registration with a single
+ *    sampler, then map the samples only once per iteration. A shared sampler does
+ *    not allow the concurrent evaluation of the metrics, so this only pays off when
+ *    mapping the samples is the most expensive part of the metrics. Only used by
+ *    metrics that support it, like the AdvancedMeanSquares and
+ *    AdvancedMattesMutualInformation metrics. Can be given for each resolution or for all resolutions at once. \n
+ *    example: <tt>(UseTransformEvaluationCache "true")</tt> \n
+ *    The default is false.
  *
  * \ingroup Metrics
  * \ingroup ComponentBaseClasses
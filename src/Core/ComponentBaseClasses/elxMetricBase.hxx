@@ -156,6 +156,29 @@ MetricBase< TElastix >
       thisAsAdvanced->SetScaleGradientWithRespectToMovingImageOrientation( wrtMoving );
     }
 
+    /** Should the metric use a structure-of-arrays copy of the samples? */
+    bool useImageSampleArrays = false;
+    this->GetConfiguration()->ReadParameter( useImageSampleArrays,
+      "UseImageSampleArrays", this->GetComponentLabel(), level, 0, false );
+    thisAsAdvanced->SetUseImageSampleArrays( useImageSampleArrays );
+
+    /** Should the metric precompute the B-spline support of the samples? */
+    bool useBSplineSupportCache = false;
+    this->GetConfiguration()->ReadParameter( useBSplineSupportCache,
+      "UseBSplineSupportCache", this->GetComponentLabel(), level, 0, false );
+    thisAsAdvanced->SetUseBSplineSupportCache( useBSplineSupportCache );
+
+    double supportCacheMaximumMemory = 512.0;
+    this->GetConfiguration()->ReadParameter( supportCacheMaximumMemory,
+      "BSplineSupportCacheMaximumMemory", this->GetComponentLabel(), level, 0, false );
+    thisAsAdvanced->SetBSplineSupportCacheMaximumMemory( supportCacheMaximumMemory );
+
+    /** Should the metric store the mapped sample points? */
+    bool useTransformEvaluationCache = false;
+    this->GetConfiguration()->ReadParameter( useTransformEvaluationCache,
+      "UseTransformEvaluationCache", this->GetComponentLabel(), level, 0, false );
+    thisAsAdvanced->SetUseTransformEvaluationCache( useTransformEvaluationCache );
+
     /** Should the metric use multi-threading? */
     bool useMultiThreading = true;
     this->GetConfiguration()->ReadParameter( useMultiThreading,
@@ -203,6 +226,22 @@ MetricBase< TElastix >
       << this->m_CurrentExactMetricValue;
   }
 
+  /** Report the size of the B-spline support cache, which is built
+   * during the first evaluation of the metric.
+   */
+  if( this->m_Elastix->GetIterationCounter() == 0 )
+  {
+    const AdvancedMetricType * thisAsAdvanced
+      = dynamic_cast< const AdvancedMetricType * >( this );
+    if( thisAsAdvanced != 0 && thisAsAdvanced->GetUseBSplineSupportCache() )
+    {
+      elxout << "  B-spline support cache: "
+             << thisAsAdvanced->GetBSplineSupportCacheSize() << " samples, "
+             << thisAsAdvanced->GetBSplineSupportCacheMemorySize() / 1048576.0
+             << " MB." << std::endl;
+    }
+  }
+
 } // end AfterEachIterationBase()
 
 
@@ -108,6 +108,13 @@ public:
   virtual void SetSinusScales( double amplitude, double frequency,
     unsigned long numberOfParameters );
 
+  /** Get the metric value, the step size and the gradient magnitude of the
+   * current iteration, for the iteration telemetry of ElastixTemplate.
+   * The default implementation sets them to NaN.
+   */
+  virtual void GetIterationTelemetry( double & value, double & stepSize,
+    double & gradientMagnitude ) const;
+
 protected:
 
   /** The constructor. */
@@ -23,6 +23,8 @@
 #include "itkSingleValuedNonLinearOptimizer.h"
 #include "itk_zlib.h"
 
+#include <limits>
+
 namespace elastix
 {
 
@@ -61,6 +63,23 @@ OptimizerBase< TElastix >
 } // end SetCurrentPositionPublic()
 
 
+/**
+ * ****************** GetIterationTelemetry ************************
+ */
+
+template< class TElastix >
+void
+OptimizerBase< TElastix >
+::GetIterationTelemetry( double & value, double & stepSize,
+  double & gradientMagnitude ) const
+{
+  value             = std::numeric_limits< double >::quiet_NaN();
+  stepSize          = std::numeric_limits< double >::quiet_NaN();
+  gradientMagnitude = std::numeric_limits< double >::quiet_NaN();
+
+} // end GetIterationTelemetry()
+
+
 /**
  * ****************** BeforeEachResolutionBase **********************
  */
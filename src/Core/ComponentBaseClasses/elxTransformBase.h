@@ -25,8 +25,11 @@
 #include "elxBaseComponentSE.h"
 #include "itkAdvancedTransform.h"
 #include "itkAdvancedCombinationTransform.h"
+#include "itkAdvancedMatrixOffsetTransformBase.h"
+#include "itkAdvancedTranslationTransform.h"
 #include "elxComponentDatabase.h"
 #include "elxProgressCommand.h"
+#include "itkMultiThreader.h"
 
 #include <fstream>
 #include <iomanip>
@@ -108,6 +111,30 @@ namespace elastix
  * The location is relative to the path from where elastix/transformix is started!\n
  * Default: "NoInitialTransform", which (obviously) means that there is no initial transform
  * to be loaded.
+ * \transformparameter DeformationFieldStreamingTileSize: The maximum number of voxels that
+ * is generated at once when transformix computes a deformation field (<tt>-def all</tt>),
+ * or the (determinant of the) spatial Jacobian (<tt>-jac all</tt>, <tt>-jacmat all</tt>).
+ * The image is then generated and written slab by slab, which bounds the memory usage.
+ * This only works for image formats that support streamed writing, such as mhd and nrrd.\n
+ * example <tt>(DeformationFieldStreamingTileSize 16777216)</tt>\n
+ * Default: 0, which means that the complete deformation field is kept in memory.
+ * \transformparameter FuseMatrixOffsetTransforms: Whether transformix fuses consecutive
+ * matrix-offset transforms (e.g. Euler, similarity, affine) and translations in the chain of
+ * initial transforms into one affine transform before resampling. Only transforms that
+ * are combined by composition are fused. This changes the result only by round-off.\n
+ * example <tt>(FuseMatrixOffsetTransforms "false")</tt>\n
+ * Default: "true".
+ * \transformparameter BakeTransformChain: Whether transformix evaluates the transform chain
+ * once at all voxels of the output image, and resamples using the resulting displacement
+ * field. Possible options are "true", "false" and "auto". With "auto" this is only done when
+ * the field is used for more than one image, and fits in MaximumBakedTransformChainMemory.
+ * Linear chains are never baked.\n
+ * example <tt>(BakeTransformChain "true")</tt>\n
+ * Default: "auto".
+ * \transformparameter MaximumBakedTransformChainMemory: The maximum size in MB of the
+ * displacement field of BakeTransformChain "auto".\n
+ * example <tt>(MaximumBakedTransformChainMemory 4096)</tt>\n
+ * Default: 1024.
  *
  * The command line arguments used by this class are:
  * \commandlinearg -t0: optional argument for elastix for specifying an initial transform
@@ -184,6 +211,11 @@ public:
     itkGetStaticConstMacro( FixedImageDimension ) >   CombinationTransformType;
   typedef typename
     CombinationTransformType::InitialTransformType InitialTransformType;
+  typedef itk::AdvancedMatrixOffsetTransformBase< CoordRepType,
+    itkGetStaticConstMacro( FixedImageDimension ),
+    itkGetStaticConstMacro( FixedImageDimension ) >   MatrixOffsetTransformType;
+  typedef itk::AdvancedTranslationTransform< CoordRepType,
+    itkGetStaticConstMacro( FixedImageDimension ) >   TranslationTransformType;
 
   /** Typedef's from Transform. */
   typedef typename ITKBaseType::ParametersType ParametersType;
@@ -201,6 +233,17 @@ public:
   /** Typedef that is used in the elastix dll version. */
   typedef typename ElastixType::ParameterMapType ParameterMapType;
 
+  /** Typedefs for the transformation of input points. */
+  typedef typename FixedImageType::IndexType  FixedImageIndexType;
+  typedef typename MovingImageType::IndexType MovingImageIndexType;
+  typedef itk::Vector< float,
+    itkGetStaticConstMacro( FixedImageDimension ) > DeformationVectorType;
+
+  /** Typedefs for multi-threading. */
+  typedef itk::ThreadIdType                       ThreadIdType;
+  typedef itk::MultiThreader                      ThreaderType;
+  typedef typename ThreaderType::ThreadInfoStruct ThreadInfoType;
+
   /** Cast to ITKBaseType. */
   virtual ITKBaseType * GetAsITKBaseType( void )
   {
@@ -293,6 +336,22 @@ public:
   /** Function to transform coordinates from fixed to moving image. */
   virtual void TransformPointsSomePoints( const std::string filename ) const;
 
+  /** Function to transform a set of points from fixed to moving image.
+   * The points are distributed in contiguous batches over the available
+   * threads. Each thread writes directly into the preallocated output vectors,
+   * so that the ordering of the output is identical to the ordering of the input.
+   * The fixed and moving images are only used to convert the transformed points
+   * to indices; the movingImage may be NULL.
+   */
+  virtual void TransformPointsThreaded(
+    const std::vector< InputPointType > & inputPoints,
+    const FixedImageType * fixedImage,
+    const MovingImageType * movingImage,
+    std::vector< OutputPointType > & outputPoints,
+    std::vector< FixedImageIndexType > & outputIndicesFixed,
+    std::vector< MovingImageIndexType > & outputIndicesMoving,
+    std::vector< DeformationVectorType > & deformations ) const;
+
   /** Function to transform coordinates from fixed to moving image, given as VTK file. */
   virtual void TransformPointsSomePointsVTK( const std::string filename ) const;
 
@@ -305,6 +364,24 @@ public:
   /** Function to compute the determinant of the spatial Jacobian. */
   virtual void ComputeSpatialJacobian( void ) const;
 
+  /** Function to optimize the transform chain for resampling, and to set
+   * the result as the transform of the resampler. This transform itself is
+   * not changed. The number of images that will be resampled decides
+   * whether baking the chain into a displacement field pays off.
+   */
+  virtual void OptimizeTransformChain( const unsigned int numberOfResamplings = 1 );
+
+  /** Returns true if TransformPoint() of this transform only combines its
+   * current and initial transform, as the AdvancedCombinationTransform does.
+   * OptimizeTransformChain() only splits such transforms into their parts.
+   * Transforms that override TransformPoint() should return false.
+   */
+  virtual bool GetTransformPointOnlyCombines( void ) const
+  {
+    return true;
+  }
+
+
   /** Makes sure that the final parameters from the registration components
    * are copied, set, and stored.
    */
@@ -325,6 +402,22 @@ protected:
    */
   void AutomaticScalesEstimation( ScalesType & scales ) const;
 
+  /** Determine the number of stream divisions for writing an image with the
+   * given number of voxels, based on the parameter DeformationFieldStreamingTileSize.
+   * Returns 1 if streaming is not requested, or not supported by the file format.
+   */
+  unsigned int GetNumberOfStreamDivisions( const std::string & fileName,
+    const unsigned long numberOfVoxels ) const;
+
+  /** Returns true if the transform can be fused into an affine transform. */
+  static bool IsMatrixOffsetOrTranslation( const InitialTransformType * transform );
+
+  /** Compose the fused affine transform with a matrix-offset or
+   * translation transform, which is applied after it.
+   */
+  static void ComposeMatrixOffsetOrTranslation( MatrixOffsetTransformType * fused,
+    const InitialTransformType * transform );
+
   /** Member variables. */
   ParametersType * m_TransformParametersPointer;
   std::string      m_TransformParametersFileName;
@@ -340,6 +433,27 @@ private:
   /** Boolean to decide whether or not the transform parameters are written. */
   bool m_ReadWriteTransformParameters;
 
+  /** Helper struct that multi-threads the transformation of input points. */
+  struct TransformPointsThreaderParameterType
+  {
+    const Self *                           st_Self;
+    const FixedImageType *                 st_FixedImage;
+    const MovingImageType *                st_MovingImage;
+    const std::vector< InputPointType > *  st_InputPoints;
+    std::vector< OutputPointType > *       st_OutputPoints;
+    std::vector< FixedImageIndexType > *   st_OutputIndicesFixed;
+    std::vector< MovingImageIndexType > *  st_OutputIndicesMoving;
+    std::vector< DeformationVectorType > * st_Deformations;
+    ThreadIdType                           st_NumberOfThreads;
+  };
+
+  /** The callback function for the multi-threaded point transformation. */
+  static ITK_THREAD_RETURN_TYPE TransformPointsThreaderCallback( void * arg );
+
+  /** The threaded implementation of TransformPointsThreaded(). */
+  void ThreadedTransformPoints( ThreadIdType threadId,
+    const TransformPointsThreaderParameterType & userData ) const;
+
 };
 
 } // end namespace elastix
@@ -30,6 +30,7 @@
 #include "itkTransformToDeterminantOfSpatialJacobianSource.h"
 #include "itkTransformToSpatialJacobianSource.h"
 #include "itkImageFileWriter.h"
+#include "itkImageIOFactory.h"
 #include "itkImageGridSampler.h"
 #include "itkContinuousIndex.h"
 #include "itkChangeInformationImageFilter.h"
@@ -41,8 +42,11 @@
 #include "itkTransformFileWriter.h"
 #include "itkTransformFactory.h"
 #include "itkAdvancedMatrixOffsetTransformBase.h"
+#include "itkAdvancedRayCastInterpolateImageFunction.h"
 #include "itkCompositeTransform.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -1173,14 +1177,9 @@ TransformBase< TElastix >
   typedef typename FixedImageType::RegionType           FixedImageRegionType;
   typedef typename FixedImageType::PointType            FixedImageOriginType;
   typedef typename FixedImageType::SpacingType          FixedImageSpacingType;
-  typedef typename FixedImageType::IndexType            FixedImageIndexType;
   typedef typename FixedImageIndexType::IndexValueType  FixedImageIndexValueType;
-  typedef typename MovingImageType::IndexType           MovingImageIndexType;
-  typedef typename MovingImageIndexType::IndexValueType MovingImageIndexValueType;
   typedef
     itk::ContinuousIndex< double, FixedImageDimension >   FixedImageContinuousIndexType;
-  typedef
-    itk::ContinuousIndex< double, MovingImageDimension >  MovingImageContinuousIndexType;
   typedef typename FixedImageType::DirectionType FixedImageDirectionType;
 
   typedef bool DummyIPPPixelType;
@@ -1191,7 +1190,6 @@ TransformBase< TElastix >
     FixedImageDimension, MeshTraitsType >                PointSetType;
   typedef itk::TransformixInputPointFileReader<
     PointSetType >                                      IPPReaderType;
-  typedef itk::Vector< float, FixedImageDimension > DeformationVectorType;
 
   /** Construct an ipp-file reader. */
   typename IPPReaderType::Pointer ippReader = IPPReaderType::New();
@@ -1255,8 +1253,7 @@ TransformBase< TElastix >
   dummyImage->SetDirection( direction );
 
   /** Temp vars */
-  FixedImageContinuousIndexType  fixedcindex;
-  MovingImageContinuousIndexType movingcindex;
+  FixedImageContinuousIndexType fixedcindex;
 
   /** Also output moving image indices if a moving image was supplied. */
   bool alsoMovingIndices = false;
@@ -1306,35 +1303,9 @@ TransformBase< TElastix >
 
   /** Apply the transform. */
   elxout << "  The input points are transformed." << std::endl;
-  for( unsigned int j = 0; j < nrofpoints; j++ )
-  {
-    /** Call TransformPoint. */
-    outputpointvec[ j ] = this->GetAsITKBaseType()->TransformPoint( inputpointvec[ j ] );
-
-    /** Transform back to index in fixed image domain. */
-    dummyImage->TransformPhysicalPointToContinuousIndex(
-      outputpointvec[ j ], fixedcindex );
-    for( unsigned int i = 0; i < FixedImageDimension; i++ )
-    {
-      outputindexfixedvec[ j ][ i ] = static_cast< FixedImageIndexValueType >(
-        itk::Math::Round< double >( fixedcindex[ i ] ) );
-    }
-
-    if( alsoMovingIndices )
-    {
-      /** Transform back to index in moving image domain. */
-      movingImage->TransformPhysicalPointToContinuousIndex(
-        outputpointvec[ j ], movingcindex );
-      for( unsigned int i = 0; i < MovingImageDimension; i++ )
-      {
-        outputindexmovingvec[ j ][ i ] = static_cast< MovingImageIndexValueType >(
-          itk::Math::Round< double >( movingcindex[ i ] ) );
-      }
-    }
-
-    /** Compute displacement. */
-    deformationvec[ j ].CastFrom( outputpointvec[ j ] - inputpointvec[ j ] );
-  }
+  this->TransformPointsThreaded( inputpointvec, dummyImage,
+    alsoMovingIndices ? movingImage.GetPointer() : NULL,
+    outputpointvec, outputindexfixedvec, outputindexmovingvec, deformationvec );
 
   /** Create filename and file stream. */
   std::string outputPointsFileName = this->m_Configuration
@@ -1399,6 +1370,167 @@ TransformBase< TElastix >
 } // end TransformPointsSomePoints()
 
 
+/**
+ * ************** TransformPointsThreaded *********************
+ *
+ * This function transforms a set of points from the fixed to the
+ * moving image domain, and converts the results to indices in the
+ * fixed and (optionally) moving image. The work is split in one
+ * contiguous batch of points per thread.
+ */
+
+template< class TElastix >
+void
+TransformBase< TElastix >
+::TransformPointsThreaded(
+  const std::vector< InputPointType > & inputPoints,
+  const FixedImageType * fixedImage,
+  const MovingImageType * movingImage,
+  std::vector< OutputPointType > & outputPoints,
+  std::vector< FixedImageIndexType > & outputIndicesFixed,
+  std::vector< MovingImageIndexType > & outputIndicesMoving,
+  std::vector< DeformationVectorType > & deformations ) const
+{
+  /** Allocate the output, so that the threads can write in place. */
+  const std::size_t nrofpoints = inputPoints.size();
+  outputPoints.resize( nrofpoints );
+  outputIndicesFixed.resize( nrofpoints );
+  outputIndicesMoving.resize( nrofpoints );
+  deformations.resize( nrofpoints );
+  if( nrofpoints == 0 ) { return; }
+
+  /** Use the number of threads of this run, as given by -threads, instead
+   * of the process-wide default, which may belong to another run.
+   */
+  typename ThreaderType::Pointer threader = ThreaderType::New();
+  ThreadIdType numberOfThreads = threader->GetNumberOfThreads();
+  const std::string threadsString
+    = this->GetConfiguration()->GetCommandLineArgument( "-threads" );
+  if( threadsString != "" )
+  {
+    const int threads = atoi( threadsString.c_str() );
+    numberOfThreads = static_cast< ThreadIdType >( std::max( threads, 1 ) );
+  }
+
+  /** Do not use more threads than there are points. */
+  if( static_cast< std::size_t >( numberOfThreads ) > nrofpoints )
+  {
+    numberOfThreads = static_cast< ThreadIdType >( nrofpoints );
+  }
+  threader->SetNumberOfThreads( numberOfThreads );
+
+  /** Fill the threader parameter struct with information. */
+  TransformPointsThreaderParameterType userData;
+  userData.st_Self                = this;
+  userData.st_FixedImage          = fixedImage;
+  userData.st_MovingImage         = movingImage;
+  userData.st_InputPoints         = &inputPoints;
+  userData.st_OutputPoints        = &outputPoints;
+  userData.st_OutputIndicesFixed  = &outputIndicesFixed;
+  userData.st_OutputIndicesMoving = &outputIndicesMoving;
+  userData.st_Deformations        = &deformations;
+  userData.st_NumberOfThreads     = threader->GetNumberOfThreads();
+
+  /** Call multi-threaded transformation of the points. */
+  threader->SetSingleMethod( TransformPointsThreaderCallback, &userData );
+  threader->SingleMethodExecute();
+
+} // end TransformPointsThreaded()
+
+
+/**
+ * ************** TransformPointsThreaderCallback *********************
+ */
+
+template< class TElastix >
+ITK_THREAD_RETURN_TYPE
+TransformBase< TElastix >
+::TransformPointsThreaderCallback( void * arg )
+{
+  /** Get the current thread id and user data. */
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadID   = infoStruct->ThreadID;
+  const TransformPointsThreaderParameterType * temp
+    = static_cast< TransformPointsThreaderParameterType * >( infoStruct->UserData );
+
+  /** Call the real implementation. */
+  temp->st_Self->ThreadedTransformPoints( threadID, *temp );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end TransformPointsThreaderCallback()
+
+
+/**
+ * ************** ThreadedTransformPoints *********************
+ */
+
+template< class TElastix >
+void
+TransformBase< TElastix >
+::ThreadedTransformPoints( ThreadIdType threadId,
+  const TransformPointsThreaderParameterType & userData ) const
+{
+  /** Typedef's. */
+  typedef typename FixedImageIndexType::IndexValueType  FixedImageIndexValueType;
+  typedef typename MovingImageIndexType::IndexValueType MovingImageIndexValueType;
+  typedef
+    itk::ContinuousIndex< double, FixedImageDimension >  FixedImageContinuousIndexType;
+  typedef
+    itk::ContinuousIndex< double, MovingImageDimension > MovingImageContinuousIndexType;
+
+  /** Compute the batch of points for this thread. */
+  const std::size_t nrofpoints = userData.st_InputPoints->size();
+  const std::size_t batchSize  = ( nrofpoints + userData.st_NumberOfThreads - 1 )
+    / userData.st_NumberOfThreads;
+  const std::size_t jmin = threadId * batchSize;
+  const std::size_t jmax = std::min( jmin + batchSize, nrofpoints );
+
+  /** Get handles to the input and output. */
+  const ITKBaseType * const              thisITK             = this->GetAsITKBaseType();
+  const std::vector< InputPointType > &  inputPoints         = *userData.st_InputPoints;
+  std::vector< OutputPointType > &       outputPoints        = *userData.st_OutputPoints;
+  std::vector< FixedImageIndexType > &   outputIndicesFixed  = *userData.st_OutputIndicesFixed;
+  std::vector< MovingImageIndexType > &  outputIndicesMoving = *userData.st_OutputIndicesMoving;
+  std::vector< DeformationVectorType > & deformations        = *userData.st_Deformations;
+
+  /** Temp vars */
+  FixedImageContinuousIndexType  fixedcindex;
+  MovingImageContinuousIndexType movingcindex;
+
+  for( std::size_t j = jmin; j < jmax; ++j )
+  {
+    /** Call TransformPoint. */
+    outputPoints[ j ] = thisITK->TransformPoint( inputPoints[ j ] );
+
+    /** Transform back to index in fixed image domain. */
+    userData.st_FixedImage->TransformPhysicalPointToContinuousIndex(
+      outputPoints[ j ], fixedcindex );
+    for( unsigned int i = 0; i < FixedImageDimension; i++ )
+    {
+      outputIndicesFixed[ j ][ i ] = static_cast< FixedImageIndexValueType >(
+        itk::Math::Round< double >( fixedcindex[ i ] ) );
+    }
+
+    if( userData.st_MovingImage != NULL )
+    {
+      /** Transform back to index in moving image domain. */
+      userData.st_MovingImage->TransformPhysicalPointToContinuousIndex(
+        outputPoints[ j ], movingcindex );
+      for( unsigned int i = 0; i < MovingImageDimension; i++ )
+      {
+        outputIndicesMoving[ j ][ i ] = static_cast< MovingImageIndexValueType >(
+          itk::Math::Round< double >( movingcindex[ i ] ) );
+      }
+    }
+
+    /** Compute displacement. */
+    deformations[ j ].CastFrom( outputPoints[ j ] - inputPoints[ j ] );
+  }
+
+} // end ThreadedTransformPoints()
+
+
 /**
  * ************** TransformPointsSomePointsVTK *********************
  *
@@ -1608,6 +1740,18 @@ TransformBase< TElastix >
       defWriter->SetInput( infoChanger->GetOutput() );
       defWriter->SetFileName( makeFileName.str().c_str() );
 
+      /** Possibly generate and write the deformation field in slabs, so that
+       * the peak memory usage is bounded by the tile size instead of by the
+       * image size.
+       */
+      unsigned long numberOfVoxels = 1;
+      for( unsigned int i = 0; i < FixedImageDimension; ++i )
+      {
+        numberOfVoxels *= defGenerator->GetSize()[ i ];
+      }
+      defWriter->SetNumberOfStreamDivisions( this->GetNumberOfStreamDivisions(
+        makeFileName.str(), numberOfVoxels ) );
+
       /** Do the writing. */
       elxout << "  Computing and writing the deformation field ..." << std::endl;
       defWriter->Update();
@@ -1740,6 +1884,15 @@ TransformBase< TElastix >
   jacWriter->SetInput( infoChanger->GetOutput() );
   jacWriter->SetFileName( makeFileName.str().c_str() );
 
+  /** Possibly generate and write the image in slabs. */
+  unsigned long numberOfVoxels = 1;
+  for( unsigned int i = 0; i < FixedImageDimension; ++i )
+  {
+    numberOfVoxels *= jacGenerator->GetOutputSize()[ i ];
+  }
+  jacWriter->SetNumberOfStreamDivisions( this->GetNumberOfStreamDivisions(
+    makeFileName.str(), numberOfVoxels ) );
+
   /** Do the writing. */
   elxout << "  Computing and writing the spatial Jacobian determinant..." << std::endl;
   try
@@ -1850,6 +2003,15 @@ TransformBase< TElastix >
     jacWriter->AddObserver( itk::StartEvent(), jacStartWriteCommand );
   }
 
+  /** Possibly generate and write the image in slabs. */
+  unsigned long numberOfVoxels = 1;
+  for( unsigned int i = 0; i < FixedImageDimension; ++i )
+  {
+    numberOfVoxels *= jacGenerator->GetOutputSize()[ i ];
+  }
+  jacWriter->SetNumberOfStreamDivisions( this->GetNumberOfStreamDivisions(
+    makeFileName.str(), numberOfVoxels ) );
+
   /** Do the writing. */
   elxout << "  Computing and writing the spatial Jacobian..." << std::endl;
   try
@@ -1871,6 +2033,283 @@ TransformBase< TElastix >
 } // end ComputeSpatialJacobian()
 
 
+/**
+ * ************** OptimizeTransformChain **********************
+ */
+
+template< class TElastix >
+void
+TransformBase< TElastix >
+::OptimizeTransformChain( const unsigned int numberOfResamplings )
+{
+  /** Typedef's. */
+  typedef typename InitialTransformType::Pointer TransformPointer;
+  typedef itk::DisplacementFieldTransform< CoordRepType,
+    FixedImageDimension >                             DisplacementFieldTransformType;
+  typedef typename DisplacementFieldTransformType
+    ::DisplacementFieldType                           DisplacementFieldType;
+  typedef itk::TransformToDisplacementFieldFilter<
+    DisplacementFieldType, CoordRepType >             DisplacementFieldGeneratorType;
+  typedef itk::AdvancedRayCastInterpolateImageFunction<
+    MovingImageType, CoordRepType >                   RayCastInterpolatorType;
+  typedef typename ElastixType::ResamplerBaseType::ITKBaseType ResamplerType;
+
+  ResamplerType * resampler = this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType();
+
+  /** The RayCastResampleInterpolator replaces the transform of the resampler. */
+  if( dynamic_cast< const RayCastInterpolatorType * >( resampler->GetInterpolator() ) )
+  {
+    return;
+  }
+
+  /** Collect the transforms of the chain, and how each of them is combined
+   * with the transforms before it. The first transform is applied first.
+   * A transform that does more than combining its current and initial
+   * transform, see GetTransformPointOnlyCombines(), is kept whole, together
+   * with the transforms before it.
+   */
+  CombinationTransformType * combination = this->GetAsCombinationTransform();
+  if( combination == 0 || combination->GetCurrentTransform() == 0 )
+  {
+    return;
+  }
+  std::vector< TransformPointer > transforms;
+  std::vector< bool >             useComposition;
+  while( combination != 0 )
+  {
+    const Self * elxCombination = dynamic_cast< const Self * >( combination );
+    if( elxCombination != 0 && !elxCombination->GetTransformPointOnlyCombines() )
+    {
+      elxout << "  The " << combination->GetNameOfClass()
+             << " and the transforms before it are kept as they are." << std::endl;
+      transforms.push_back( combination );
+      useComposition.push_back( true );
+      break;
+    }
+
+    transforms.push_back( combination->GetCurrentTransform() );
+    useComposition.push_back( combination->GetUseComposition() );
+
+    InitialTransformType * initialTransform = combination->GetInitialTransform();
+    combination = dynamic_cast< CombinationTransformType * >( initialTransform );
+    if( initialTransform != 0 && combination == 0 )
+    {
+      transforms.push_back( initialTransform );
+      useComposition.push_back( true );
+    }
+  }
+  std::reverse( transforms.begin(), transforms.end() );
+  std::reverse( useComposition.begin(), useComposition.end() );
+
+  /** Fuse consecutive matrix-offset (and translation) transforms that are
+   * combined by composition. A range is only extended if its first transform
+   * is composed with the transforms before it, or is the first of the chain.
+   * The transforms of the chain itself are not modified.
+   */
+  bool fuse = true;
+  this->m_Configuration->ReadParameter( fuse, "FuseMatrixOffsetTransforms", 0, false );
+
+  std::vector< TransformPointer > stages;
+  std::vector< bool >             stageUseComposition;
+  std::vector< unsigned int >     stageFirst;
+  std::vector< unsigned int >     stageSize;
+  for( unsigned int i = 0; i < transforms.size(); ++i )
+  {
+    const bool fusable = fuse && !stages.empty()
+      && useComposition[ i ] && stageUseComposition.back()
+      && Self::IsMatrixOffsetOrTranslation( transforms[ i ] )
+      && Self::IsMatrixOffsetOrTranslation( stages.back() );
+    if( !fusable )
+    {
+      stages.push_back( transforms[ i ] );
+      stageUseComposition.push_back( stages.size() == 1 || useComposition[ i ] );
+      stageFirst.push_back( i );
+      stageSize.push_back( 1 );
+      continue;
+    }
+
+    /** Replace the first transform of the range by an affine copy. */
+    if( stageSize.back() == 1 )
+    {
+      typename MatrixOffsetTransformType::Pointer copy = MatrixOffsetTransformType::New();
+      copy->SetIdentity();
+      Self::ComposeMatrixOffsetOrTranslation( copy, stages.back() );
+      stages.back() = copy.GetPointer();
+    }
+    MatrixOffsetTransformType * fused
+      = static_cast< MatrixOffsetTransformType * >( stages.back().GetPointer() );
+    Self::ComposeMatrixOffsetOrTranslation( fused, transforms[ i ] );
+    ++stageSize.back();
+  }
+
+  /** Tell the user what was fused. */
+  elxout << "  The transform chain consists of " << transforms.size()
+         << " transform(s)." << std::endl;
+  unsigned int numberOfFusedRanges = 0;
+  for( unsigned int j = 0; j < stages.size(); ++j )
+  {
+    if( stageSize[ j ] < 2 )
+    {
+      continue;
+    }
+    elxout << "  Fused transforms " << stageFirst[ j ] + 1
+           << " to " << stageFirst[ j ] + stageSize[ j ]
+           << " of the chain (";
+    for( unsigned int i = stageFirst[ j ]; i < stageFirst[ j ] + stageSize[ j ]; ++i )
+    {
+      elxout << ( i == stageFirst[ j ] ? "" : ", " ) << transforms[ i ]->GetNameOfClass();
+    }
+    elxout << ") into one affine transform." << std::endl;
+    ++numberOfFusedRanges;
+  }
+  if( numberOfFusedRanges == 0 )
+  {
+    elxout << "  No transforms were fused." << std::endl;
+  }
+
+  /** Build the optimized chain. A single transform is used as is. */
+  TransformPointer optimizedTransform = stages[ 0 ];
+  for( unsigned int j = 1; j < stages.size(); ++j )
+  {
+    typename CombinationTransformType::Pointer stage = CombinationTransformType::New();
+    stage->SetCurrentTransform( stages[ j ] );
+    stage->SetInitialTransform( optimizedTransform );
+    stage->SetUseComposition( stageUseComposition[ j ] );
+    optimizedTransform = stage;
+  }
+
+  /** Possibly bake the chain into a displacement field at the output
+   * resolution. The resampler then only looks up the displacement at the
+   * voxels, which only pays off if the field is used for several resamplings,
+   * so by default ("auto") this is only done in that case.
+   */
+  std::string bake = "auto";
+  this->m_Configuration->ReadParameter( bake, "BakeTransformChain", 0, false );
+  double maximumMemory = 1024.0;
+  this->m_Configuration->ReadParameter( maximumMemory,
+    "MaximumBakedTransformChainMemory", 0, false );
+
+  unsigned long numberOfVoxels = 1;
+  for( unsigned int i = 0; i < FixedImageDimension; ++i )
+  {
+    numberOfVoxels *= resampler->GetSize()[ i ];
+  }
+  const double fieldMemory = static_cast< double >( numberOfVoxels )
+    * sizeof( typename DisplacementFieldType::PixelType ) / 1048576.0;
+
+  const bool doBake = !optimizedTransform->IsLinear()
+    && ( bake == "true" || ( bake == "auto"
+    && numberOfResamplings > 1 && fieldMemory <= maximumMemory ) );
+  if( doBake )
+  {
+    typename DisplacementFieldGeneratorType::Pointer generator
+      = DisplacementFieldGeneratorType::New();
+    generator->SetSize( resampler->GetSize() );
+    generator->SetOutputSpacing( resampler->GetOutputSpacing() );
+    generator->SetOutputOrigin( resampler->GetOutputOrigin() );
+    generator->SetOutputStartIndex( resampler->GetOutputStartIndex() );
+    generator->SetOutputDirection( resampler->GetOutputDirection() );
+    generator->SetTransform( optimizedTransform );
+    generator->Update();
+
+    typename DisplacementFieldTransformType::Pointer bakedTransform
+      = DisplacementFieldTransformType::New();
+    bakedTransform->SetDisplacementField( generator->GetOutput() );
+    resampler->SetTransform( bakedTransform );
+
+    elxout << "  Baked the transform chain into a displacement field of "
+           << numberOfVoxels << " voxels (" << fieldMemory << " MB)." << std::endl;
+  }
+  else
+  {
+    resampler->SetTransform( optimizedTransform );
+  }
+
+} // end OptimizeTransformChain()
+
+
+/**
+ * ************** IsMatrixOffsetOrTranslation **********************
+ */
+
+template< class TElastix >
+bool
+TransformBase< TElastix >
+::IsMatrixOffsetOrTranslation( const InitialTransformType * transform )
+{
+  return dynamic_cast< const MatrixOffsetTransformType * >( transform ) != 0
+         || dynamic_cast< const TranslationTransformType * >( transform ) != 0;
+
+} // end IsMatrixOffsetOrTranslation()
+
+
+/**
+ * ************** ComposeMatrixOffsetOrTranslation **********************
+ */
+
+template< class TElastix >
+void
+TransformBase< TElastix >
+::ComposeMatrixOffsetOrTranslation( MatrixOffsetTransformType * fused,
+  const InitialTransformType * transform )
+{
+  const MatrixOffsetTransformType * matrixOffset
+    = dynamic_cast< const MatrixOffsetTransformType * >( transform );
+  if( matrixOffset != 0 )
+  {
+    fused->Compose( matrixOffset, false );
+    return;
+  }
+
+  const TranslationTransformType * translation
+    = dynamic_cast< const TranslationTransformType * >( transform );
+  fused->SetOffset( fused->GetOffset() + translation->GetOffset() );
+
+} // end ComposeMatrixOffsetOrTranslation()
+
+
+/**
+ * ************** GetNumberOfStreamDivisions **********************
+ */
+
+template< class TElastix >
+unsigned int
+TransformBase< TElastix >
+::GetNumberOfStreamDivisions( const std::string & fileName,
+  const unsigned long numberOfVoxels ) const
+{
+  /** The number of stream divisions follows from the maximum
+   * number of voxels per tile.
+   */
+  unsigned long tileSize = 0;
+  this->m_Configuration->ReadParameter( tileSize,
+    "DeformationFieldStreamingTileSize", 0, false );
+  if( tileSize == 0 || numberOfVoxels <= tileSize )
+  {
+    return 1;
+  }
+  const unsigned int numberOfStreamDivisions = static_cast< unsigned int >(
+    ( numberOfVoxels + tileSize - 1 ) / tileSize );
+
+  /** Check whether the output format supports streamed writing. */
+  itk::ImageIOBase::Pointer imageIO = itk::ImageIOFactory::CreateImageIO(
+    fileName.c_str(), itk::ImageIOFactory::WriteMode );
+  if( imageIO.IsNull() || !imageIO->CanStreamWrite() )
+  {
+    xl::xout[ "warning" ] << "WARNING: the file \"" << fileName
+                          << "\" can not be written in a streamed fashion.\n"
+                          << "  The image is computed in one piece."
+                          << std::endl;
+    return 1;
+  }
+
+  elxout << "  The image is written in "
+         << numberOfStreamDivisions << " streamed slabs." << std::endl;
+  return numberOfStreamDivisions;
+
+} // end GetNumberOfStreamDivisions()
+
+
 /**
  * ************** SetTransformParametersFileName ****************
  */
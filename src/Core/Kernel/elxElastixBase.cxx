@@ -17,7 +17,6 @@
  *=========================================================================*/
 #include "elxElastixBase.h"
 #include <sstream>
-#include "itkMersenneTwisterRandomVariateGenerator.h"
 
 namespace elastix
 {
@@ -65,9 +64,13 @@ ElastixBase::ElastixBase()
   this->m_InitialTransform = 0;
   this->m_FinalTransform   = 0;
 
+  /** Create the random number generator of this run. */
+  this->m_RandomGenerator = RandomGeneratorType::New();
+
   /** From Elastix 4.3 to 4.7: Ignore direction cosines by default, for
    * backward compatability. From Elastix 4.8: set it to true by default.*/
   this->m_UseDirectionCosines = true;
+  this->m_WriteIterationInfo  = true;
 
 } // end Constructor
 
@@ -238,12 +241,10 @@ ElastixBase::BeforeAllBase( void )
    * the default in the MersenneTwister code.
    * Use silent parameter file readout, to avoid annoying warning when
    * starting elastix */
-  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
-  typedef RandomGeneratorType::IntegerType                       SeedType;
+  typedef RandomGeneratorType::IntegerType SeedType;
   unsigned int randomSeed = 121212;
   this->GetConfiguration()->ReadParameter( randomSeed, "RandomSeed", 0, false );
-  RandomGeneratorType::Pointer randomGenerator = RandomGeneratorType::GetInstance();
-  randomGenerator->SetSeed( static_cast< SeedType >( randomSeed ) );
+  this->m_RandomGenerator->SetSeed( static_cast< SeedType >( randomSeed ) );
 
   /** Return a value. */
   return returndummy;
@@ -279,7 +280,14 @@ ElastixBase::BeforeAllTransformixBase( void )
   int inreturndummy = 0;
   this->m_MovingImageFileNameContainer = this->GenerateFileNameContainer(
     "-in", inreturndummy, false, true );
-  if( inreturndummy != 0 )
+
+  /** Append the input images that are listed in the "-inlist" file. */
+  const std::string inList = this->GetConfiguration()->GetCommandLineArgument( "-inlist" );
+  if( inList != "" )
+  {
+    returndummy |= this->ReadInputImageList( inList );
+  }
+  else if( inreturndummy != 0 )
   {
     elxout << "-in       unspecified, so no input image specified" << std::endl;
   }
@@ -367,6 +375,45 @@ ElastixBase::AfterRegistrationBase( void )
 } // end AfterRegistrationBase()
 
 
+/**
+ * ********************* ReadInputImageList ******************
+ */
+
+int
+ElastixBase::ReadInputImageList( const std::string & fileName )
+{
+  std::ifstream inputList( fileName.c_str() );
+  if( !inputList.is_open() )
+  {
+    xl::xout[ "error" ] << "ERROR: the file \"" << fileName
+                        << "\" given by -inlist could not be opened." << std::endl;
+    return 1;
+  }
+
+  /** One file name per line. Empty lines and lines that start with
+   * a '#' are skipped.
+   */
+  unsigned int numberOfImages = 0;
+  std::string  line;
+  while( std::getline( inputList, line ) )
+  {
+    const std::string::size_type first = line.find_first_not_of( " \t\r" );
+    if( first == std::string::npos || line[ first ] == '#' )
+    {
+      continue;
+    }
+    const std::string::size_type last = line.find_last_not_of( " \t\r" );
+    this->m_MovingImageFileNameContainer->CreateElementAt(
+      this->m_MovingImageFileNameContainer->Size() ) = line.substr( first, last - first + 1 );
+    ++numberOfImages;
+  }
+
+  elxout << "-inlist   " << fileName << " (" << numberOfImages << " images)" << std::endl;
+  return 0;
+
+} // end ReadInputImageList()
+
+
 /**
  * ********************* GenerateFileNameContainer ******************
  */
@@ -467,6 +514,17 @@ ElastixBase::GetUseDirectionCosines( void ) const
 }
 
 
+/**
+ * ******************** GetWriteIterationInfo ********************
+ */
+
+bool
+ElastixBase::GetWriteIterationInfo( void ) const
+{
+  return this->m_WriteIterationInfo;
+}
+
+
 /**
  * ******************** SetOriginalFixedImageDirectionFlat ********************
  */
@@ -38,6 +38,7 @@
 #include "itkVectorContainer.h"
 #include "itkImageFileReader.h"
 #include "itkChangeInformationImageFilter.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
 
 #include <fstream>
 #include <iomanip>
@@ -90,7 +91,7 @@ namespace elastix
  * of the images to be registered, is defined in this class.
  *
  * The parameters used by this class are:
- * \parameter RandomSeed: Sets a global seed for the random generator.\n
+ * \parameter RandomSeed: Sets the seed of the random generator of this run.\n
  *   example: <tt>(RandomSeed 121212)</tt>\n
  *   It must be a positive integer number. Default: 121212.
  * \parameter DefaultOutputPrecision: Set the default precision of floating values in the output.
@@ -136,6 +137,13 @@ namespace elastix
  * \commandlinearg -in: optional argument for transformix with the file name of an input image. \n
  *    example: <tt>-in inputImage.mhd</tt> \n
  *    If this option is skipped, a deformation field of the transform will be generated.
+ *    Several input images can be given with <tt>-in0</tt>, <tt>-in1</tt>, etc. They are
+ *    all resampled with the same transform, which is read only once. The result of
+ *    input image i is written to result.\<i\>.\<ResultImageFormat\>.
+ * \commandlinearg -inlist: optional argument for transformix with the name of a text file
+ *    that lists input images, one file name per line. Empty lines and lines starting with
+ *    '#' are skipped. The images are appended to the ones given by <tt>-in</tt>.\n
+ *    example: <tt>-inlist labelmaps.txt</tt> \n
  *
  * \ingroup Kernel
  */
@@ -171,6 +179,10 @@ public:
   typedef ComponentDatabaseType::IndexType DBIndexType;
   typedef std::vector< double >            FlatDirectionCosinesType;
 
+  /** The random number generator of this run. */
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+  typedef RandomGeneratorType::Pointer                           RandomGeneratorPointer;
+
   /** Typedef that is used in the elastix dll version. */
   typedef itk::ParameterMapInterface::ParameterMapType ParameterMapType;
 
@@ -305,6 +317,14 @@ public:
   elxSetObjectMacro( FinalTransform, ObjectType );
   elxGetObjectMacro( FinalTransform, ObjectType );
 
+  /** Get the random number generator. Each ElastixBase owns one, which is
+   * seeded with the RandomSeed parameter in BeforeAllBase(). The random
+   * samplers and the groupwise metrics draw from it instead of from the
+   * global instance, so that registrations that run in parallel in one
+   * process do not share, or reseed, each other's generator.
+   */
+  elxGetObjectMacro( RandomGenerator, RandomGeneratorType );
+
   /** Empty Run()-function to be overridden. */
   virtual int Run( void ) = 0;
 
@@ -343,6 +363,12 @@ public:
    * parameter. */
   virtual bool GetUseDirectionCosines( void ) const;
 
+  /** Get whether the iteration info table is written. It is not written
+   * when the IterationTelemetry is used; components can then skip filling
+   * their columns of the table in AfterEachIteration().
+   */
+  virtual bool GetWriteIterationInfo( void ) const;
+
   /** Set/Get the original fixed image direction as a flat array
    * (d11 d21 d31 d21 d22 etc ) */
   virtual void SetOriginalFixedImageDirectionFlat(
@@ -430,8 +456,12 @@ public:
           throw excp;
         }
 
-        /** Store loaded image in the image container, as a DataObjectPointer. */
+        /** Store loaded image in the image container, as a DataObjectPointer.
+         * Disconnect it from the reader, so that filters that use it in
+         * different threads do not share a pipeline.
+         */
         ImagePointer image = infoChanger->GetOutput();
+        image->DisconnectPipeline();
         imageContainer->CreateElementAt( i ) = image.GetPointer();
 
         /** Store the original direction cosines */
@@ -535,9 +565,15 @@ private:
   ObjectPointer m_InitialTransform;
   ObjectPointer m_FinalTransform;
 
+  /** The random number generator of this run. */
+  RandomGeneratorPointer m_RandomGenerator;
+
   /** Use or ignore direction cosines. */
   bool m_UseDirectionCosines;
 
+  /** Write the iteration info table or not. */
+  bool m_WriteIterationInfo;
+
   /** Read a series of command line options that satisfy the following syntax:
    * {-f,-f0} \<filename0\> [-f1 \<filename1\> [ -f2 \<filename2\> ... ] ]
    *
@@ -551,6 +587,13 @@ private:
     bool printerrors,
     bool printinfo ) const;
 
+  /** Append the input image file names that are listed in a text file,
+   * one per line, to the moving image file name container. This function
+   * is used by BeforeAllTransformixBase for "-inlist". Returns 1 if the
+   * file could not be opened, and 0 otherwise.
+   */
+  int ReadInputImageList( const std::string & fileName );
+
 };
 
 } // end namespace elastix
@@ -28,6 +28,7 @@
 
 #include "elxMacro.h"
 #include "itkMultiThreader.h"
+#include "itkPersistentThreadPool.h"
 
 #ifdef ELASTIX_USE_OPENCL
 #include "itkOpenCLSetup.h"
@@ -57,26 +58,26 @@ xoutsimple_type g_LogOnlyXout;
 std::ofstream   g_LogFileStream;
 
 /**
- * ********************* xoutSetup ******************************
+ * ********************* xoutSetupCells *************************
  *
- * NB: this function is a global function, not part of the ElastixMain
- * class!!
+ * Open the logfile and connect the target cells to the outputs.
+ * Used by xoutSetup and xoutManager.
  */
 
-int
-xoutSetup( const char * logfilename, bool setupLogging, bool setupCout )
+static int
+xoutSetupCells( const char * logfilename, bool setupLogging, bool setupCout,
+  xoutbase_type & mainXout, xoutsimple_type & warningXout,
+  xoutsimple_type & errorXout, xoutsimple_type & standardXout,
+  xoutsimple_type & coutOnlyXout, xoutsimple_type & logOnlyXout,
+  std::ofstream & logFileStream )
 {
-  /** The namespace of xout. */
-  using namespace xl;
-
   int returndummy = 0;
-  set_xout( &g_xout );
 
   if( setupLogging )
   {
     /** Open the logfile for writing. */
-    g_LogFileStream.open( logfilename );
-    if( !g_LogFileStream.is_open() )
+    logFileStream.open( logfilename );
+    if( !logFileStream.is_open() )
     {
       std::cerr << "ERROR: LogFile cannot be opened!" << std::endl;
       return 1;
@@ -86,43 +87,94 @@ xoutSetup( const char * logfilename, bool setupLogging, bool setupCout )
   /** Set std::cout and the logfile as outputs of xout. */
   if( setupLogging )
   {
-    returndummy |= xout.AddOutput( "log", &g_LogFileStream );
+    returndummy |= mainXout.AddOutput( "log", &logFileStream );
   }
   if( setupCout )
   {
-    returndummy |= xout.AddOutput( "cout", &std::cout );
+    returndummy |= mainXout.AddOutput( "cout", &std::cout );
   }
 
   /** Set outputs of LogOnly and CoutOnly. */
-  returndummy |= g_LogOnlyXout.AddOutput( "log", &g_LogFileStream );
-  returndummy |= g_CoutOnlyXout.AddOutput( "cout", &std::cout );
+  returndummy |= logOnlyXout.AddOutput( "log", &logFileStream );
+  returndummy |= coutOnlyXout.AddOutput( "cout", &std::cout );
 
   /** Copy the outputs to the warning-, error- and standard-xouts. */
-  g_WarningXout.SetOutputs( xout.GetCOutputs() );
-  g_ErrorXout.SetOutputs( xout.GetCOutputs() );
-  g_StandardXout.SetOutputs( xout.GetCOutputs() );
+  warningXout.SetOutputs( mainXout.GetCOutputs() );
+  errorXout.SetOutputs( mainXout.GetCOutputs() );
+  standardXout.SetOutputs( mainXout.GetCOutputs() );
 
-  g_WarningXout.SetOutputs( xout.GetXOutputs() );
-  g_ErrorXout.SetOutputs( xout.GetXOutputs() );
-  g_StandardXout.SetOutputs( xout.GetXOutputs() );
+  warningXout.SetOutputs( mainXout.GetXOutputs() );
+  errorXout.SetOutputs( mainXout.GetXOutputs() );
+  standardXout.SetOutputs( mainXout.GetXOutputs() );
 
   /** Link the warning-, error- and standard-xouts to xout. */
-  returndummy |= xout.AddTargetCell( "warning", &g_WarningXout );
-  returndummy |= xout.AddTargetCell( "error", &g_ErrorXout );
-  returndummy |= xout.AddTargetCell( "standard", &g_StandardXout );
-  returndummy |= xout.AddTargetCell( "logonly", &g_LogOnlyXout );
-  returndummy |= xout.AddTargetCell( "coutonly", &g_CoutOnlyXout );
+  returndummy |= mainXout.AddTargetCell( "warning", &warningXout );
+  returndummy |= mainXout.AddTargetCell( "error", &errorXout );
+  returndummy |= mainXout.AddTargetCell( "standard", &standardXout );
+  returndummy |= mainXout.AddTargetCell( "logonly", &logOnlyXout );
+  returndummy |= mainXout.AddTargetCell( "coutonly", &coutOnlyXout );
 
   /** Format the output. */
-  xout[ "standard" ] << std::fixed;
-  xout[ "standard" ] << std::showpoint;
+  mainXout[ "standard" ] << std::fixed;
+  mainXout[ "standard" ] << std::showpoint;
 
   /** Return a value. */
   return returndummy;
 
+} // end xoutSetupCells()
+
+
+/**
+ * ********************* xoutSetup ******************************
+ *
+ * NB: this function is a global function, not part of the ElastixMain
+ * class!!
+ */
+
+int
+xoutSetup( const char * logfilename, bool setupLogging, bool setupCout )
+{
+  /** The namespace of xout. */
+  using namespace xl;
+
+  set_xout( &g_xout );
+
+  return xoutSetupCells( logfilename, setupLogging, setupCout,
+    g_xout, g_WarningXout, g_ErrorXout, g_StandardXout,
+    g_CoutOnlyXout, g_LogOnlyXout, g_LogFileStream );
+
 } // end xoutSetup()
 
 
+/**
+ * ********************* xoutManager ****************************
+ */
+
+xoutManager::xoutManager( const char * logfilename,
+  bool setupLogging, bool setupCout )
+{
+  this->m_SetupReturnCode = xoutSetupCells( logfilename, setupLogging, setupCout,
+    this->m_Xout, this->m_WarningXout, this->m_ErrorXout, this->m_StandardXout,
+    this->m_CoutOnlyXout, this->m_LogOnlyXout, this->m_LogFileStream );
+
+  /** Let the calling thread write to this xout. */
+  this->m_PreviousThreadXout = get_thread_xout();
+  set_thread_xout( &this->m_Xout );
+
+} // end xoutManager()
+
+
+/**
+ * ********************* ~xoutManager ***************************
+ */
+
+xoutManager::~xoutManager()
+{
+  set_thread_xout( this->m_PreviousThreadXout );
+
+} // end ~xoutManager()
+
+
 
 /**
  * ********************* Constructor ****************************
@@ -164,6 +216,7 @@ ElastixMain::ElastixMain()
 
 ElastixMain::ComponentDatabasePointer ElastixMain::s_CDB             = 0;
 ElastixMain::ComponentLoaderPointer   ElastixMain::s_ComponentLoader = 0;
+itk::SimpleFastMutexLock              ElastixMain::s_ComponentsLock;
 
 /**
  * ********************** Destructor ****************************
@@ -373,6 +426,13 @@ ElastixMain::Run( void )
   this->GetElastixBase()->SetOriginalFixedImageDirectionFlat(
     this->GetOriginalFixedImageDirectionFlat() );
 
+  /** Start the threads that are shared by the components of this run. The
+   * runs in parallel threads of this process share the pool, which has
+   * the number of threads of the run that started it.
+   */
+  itk::PersistentThreadPool::AcquireGlobalInstance(
+    itk::MultiThreader::GetGlobalDefaultNumberOfThreads() );
+
   /** Run elastix! */
   try
   {
@@ -398,6 +458,9 @@ ElastixMain::Run( void )
     errorCode = 1;
   }
 
+  /** Stop the threads, if no other run uses them. */
+  itk::PersistentThreadPool::ReleaseGlobalInstance();
+
   /** Return the final transform. */
   this->m_FinalTransform = this->GetElastixBase()->GetFinalTransform();
 
@@ -619,15 +682,12 @@ ElastixMain::InitDBIndex( void )
       }
     }
 
-    /** Load the components. */
-    if( this->s_CDB.IsNull() )
+    /** Load the components, if that has not been done before. */
+    int loadReturnCode = this->LoadComponents();
+    if( loadReturnCode != 0 )
     {
-      int loadReturnCode = this->LoadComponents();
-      if( loadReturnCode != 0 )
-      {
-        xout[ "error" ] << "Loading components failed" << std::endl;
-        return loadReturnCode;
-      }
+      xout[ "error" ] << "Loading components failed" << std::endl;
+      return loadReturnCode;
     }
 
     if( this->s_CDB.IsNotNull() )
@@ -722,25 +782,32 @@ ElastixMain::GetTotalNumberOfElastixLevels( void )
 int
 ElastixMain::LoadComponents( void )
 {
-  /** Create a ComponentDatabase. */
-  if( this->s_CDB.IsNull() )
+  /** Runs in other threads may load the components at the same time. */
+  s_ComponentsLock.Lock();
+  if( s_CDB.IsNotNull() )
   {
-    this->s_CDB = ComponentDatabaseType::New();
+    s_ComponentsLock.Unlock();
+    return 0;
   }
 
-  /** Create a ComponentLoader and set the database. */
-  if( this->s_ComponentLoader.IsNull() )
-  {
-    this->s_ComponentLoader = ComponentLoaderType::New();
-    this->s_ComponentLoader->SetComponentDatabase( s_CDB );
-  }
+  /** Create a ComponentDatabase, and a ComponentLoader that fills it. */
+  ComponentDatabasePointer cdb = ComponentDatabaseType::New();
+  s_ComponentLoader = ComponentLoaderType::New();
+  s_ComponentLoader->SetComponentDatabase( cdb );
 
   /** Get the current program. */
   const char * argv0
     = this->m_Configuration->GetCommandLineArgument( "-argv0" ).c_str();
 
-  /** Load the components. */
-  return this->s_ComponentLoader->LoadComponents( argv0 );
+  /** Load the components. Only publish a complete database. */
+  const int loadReturnCode = s_ComponentLoader->LoadComponents( argv0 );
+  if( loadReturnCode == 0 )
+  {
+    s_CDB = cdb;
+  }
+  s_ComponentsLock.Unlock();
+
+  return loadReturnCode;
 
 } // end LoadComponents()
 
@@ -752,15 +819,17 @@ ElastixMain::LoadComponents( void )
 void
 ElastixMain::UnloadComponents( void )
 {
+  s_ComponentsLock.Lock();
   s_CDB = 0;
-  s_ComponentLoader->SetComponentDatabase( 0 );
 
   if( s_ComponentLoader )
   {
+    s_ComponentLoader->SetComponentDatabase( 0 );
     s_ComponentLoader->UnloadComponents();
   }
 
   s_ComponentLoader = 0;
+  s_ComponentsLock.Unlock();
 
 } // end UnloadComponents()
 
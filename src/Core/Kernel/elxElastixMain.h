@@ -23,6 +23,7 @@
 
 #include "elxElastixBase.h"
 #include "itkObject.h"
+#include "itkSimpleFastMutexLock.h"
 
 #include <iostream>
 #include <fstream>
@@ -54,6 +55,47 @@ namespace elastix
  */
 extern int xoutSetup( const char * logfilename, bool setupLogging, bool setupCout );
 
+/**
+ * \class xoutManager
+ * \brief Owns the xout objects and the logfile of one elastix or transformix run.
+ *
+ * xoutSetup() configures process-wide objects, so only one run at a time
+ * can log. An xoutManager configures its own xout, with the same fields,
+ * and sets it as the xout of the calling thread for its lifetime. The
+ * library interfaces create one for each call, so that several runs can
+ * be executed in parallel threads, each with its own logfile.
+ */
+class xoutManager
+{
+public:
+
+  xoutManager( const char * logfilename, bool setupLogging, bool setupCout );
+  ~xoutManager();
+
+  /** Returns 0 if the setup went ok, 1 otherwise. */
+  int GetSetupReturnCode( void ) const
+  {
+    return this->m_SetupReturnCode;
+  }
+
+
+private:
+
+  xoutManager( const xoutManager & );  // purposely not implemented
+  void operator=( const xoutManager & ); // purposely not implemented
+
+  xl::xoutbase_type   m_Xout;
+  xl::xoutsimple_type m_WarningXout;
+  xl::xoutsimple_type m_ErrorXout;
+  xl::xoutsimple_type m_StandardXout;
+  xl::xoutsimple_type m_CoutOnlyXout;
+  xl::xoutsimple_type m_LogOnlyXout;
+  std::ofstream       m_LogFileStream;
+
+  xl::xoutbase_type * m_PreviousThreadXout;
+  int                 m_SetupReturnCode;
+};
+
 /**
  * \class ElastixMain
  * \brief A class with all functionality to configure elastix.
@@ -269,6 +311,11 @@ public:
   /** Set maximum number of threads, which is read from the command line arguments.
    * Syntax:
    * -threads \<int\>
+   * NB: this sets the global maximum of the MultiThreader, so it affects all
+   * runs in the process, also those in other threads. The library
+   * interfaces do not pass -threads; a program that runs several
+   * registrations in parallel should set the maximum itself, before the
+   * first run starts.
    */
   virtual void SetMaximumNumberOfThreads( void ) const;
 
@@ -291,6 +338,10 @@ public:
   /** GetTransformParametersMap */
   virtual ParameterMapType GetTransformParametersMap( void ) const;
 
+  /** Release the component database. The database is shared by all
+   * ElastixMain objects in the process, so this should not be called
+   * while another run is in progress.
+   */
   static void UnloadComponents( void );
 
 protected:
@@ -338,6 +389,11 @@ protected:
 
   static ComponentDatabasePointer s_CDB;
   static ComponentLoaderPointer   s_ComponentLoader;
+  static itk::SimpleFastMutexLock s_ComponentsLock;
+
+  /** Fill the component database, if that has not been done before.
+   * Thread-safe, so runs in parallel threads can share the database.
+   */
   virtual int LoadComponents( void );
 
   /** InitDBIndex sets m_DBIndex by asking the ImageTypes
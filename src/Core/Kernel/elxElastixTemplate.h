@@ -39,9 +39,13 @@
 #include "elxTransformBase.h"
 
 #include "itkTimeProbe.h"
+#include "itkPersistentThreadPool.h"
+#include "itkSimpleMutexLock.h"
+#include "elxIterationTelemetry.h"
 
 #include <sstream>
 #include <fstream>
+#include <vector>
 
 /**
  * Macro that defines to functions. In the case of
@@ -89,6 +93,20 @@ namespace elastix
  *    example: <tt>(WriteTransformParametersEachIteration "true")</tt>\n
  *    This parameter can not be specified for each resolution separately.
  *    Default value: "false".
+ * \parameter IterationTelemetry: Write a record per iteration to the file
+ *    IterationTelemetry.\<elastixlevel\>.csv (or .bin) in the output
+ *    directory, instead of writing the iteration table to the screen, the
+ *    log file and the IterationInfo files. The record holds the resolution,
+ *    the iteration number, the metric value, the step size and the gradient
+ *    magnitude (NaN if the optimizer does not provide them), and the time in
+ *    ms spent by the optimizer and by the AfterEachIteration() functions. The
+ *    records are buffered and written by a separate thread, which makes the
+ *    bookkeeping of cheap iterations considerably faster. Choose from "off",
+ *    "csv" and "binary"; the binary file consists of the records as C structs
+ *    of two unsigned ints and five doubles, in native byte order.\n
+ *    example: <tt>(IterationTelemetry "csv")</tt>\n
+ *    This parameter can not be specified for each resolution separately.
+ *    Default value: "off".
  * \parameter WriteTransformParametersEachResolution: Controls whether
  *    to save a transform parameter file to disk in every resolution.\n
  *    example: <tt>(WriteTransformParametersEachResolution "true")</tt>\n
@@ -106,6 +124,14 @@ namespace elastix
  *  image, which relates voxel coordinates to world coordinates. Ignoring it
  *  may easily lead to left/right swaps for example, which could skrew up a
  *  (medical) analysis.
+ * \transformparameter NumberOfConcurrentResamplings: The maximum number of input
+ *    images that transformix resamples at the same time, when more than one input
+ *    image is given (<tt>-in0</tt>, <tt>-in1</tt>, ..., or <tt>-inlist</tt>). The
+ *    threads are divided over these images. Each image in flight takes the memory
+ *    of the input image, the output image and the interpolator. With 1, the images
+ *    are resampled one after another by the resampler component itself.\n
+ *    example: <tt>(NumberOfConcurrentResamplings 8)</tt>\n
+ *    Default value: 4.
  *
  * \ingroup Kernel
  */
@@ -351,6 +377,14 @@ protected:
   /** Count the number of iterations. */
   unsigned int m_IterationCounter;
 
+  /** The WriteTransformParametersEachIteration parameter, which is read
+   * once per resolution instead of in every iteration.
+   */
+  bool m_WriteTransformParametersEachIteration;
+
+  /** Stores the records of the iterations, if IterationTelemetry is on. */
+  IterationTelemetry::Pointer m_IterationTelemetry;
+
   /** CreateTransformParameterFile. */
   virtual void CreateTransformParameterFile( const std::string FileName,
     const bool ToLog );
@@ -395,6 +429,53 @@ protected:
   /** Set the direction in the superclass' m_OriginalFixedImageDirection variable */
   virtual void SetOriginalFixedImageDirection( const FixedImageDirectionType & arg );
 
+  /** Read the fixed and moving images and masks that are not set yet.
+   * The four containers are read concurrently.
+   */
+  virtual void ReadImageContainers( void );
+
+  /** Typedefs for reading the containers in threads. */
+  typedef itk::MultiThreader::ThreadInfoStruct ThreadInfoType;
+  struct ReadImageContainersThreaderParameterType
+  {
+    const Self *               st_Elastix;
+    bool                       st_UseDirectionCosines;
+    bool                       st_Read[ 4 ];
+    bool                       st_Failed[ 4 ];
+    DataObjectContainerPointer st_Containers[ 4 ];
+    itk::ExceptionObject       st_Exceptions[ 4 ];
+    FixedImageDirectionType    st_FixedImageDirection;
+  };
+
+  /** Read one or more of the containers, in a thread. */
+  static ITK_THREAD_RETURN_TYPE ReadImageContainersThreaderCallback( void * arg );
+
+  /** Resample all transformix input images and write the results to the
+   * given file names. Several images are resampled at the same time, each
+   * with its own resampler and a copy of the resample interpolator, which
+   * all share the transform of the resampler component.
+   */
+  virtual void ResampleAndWriteImages( const std::vector< std::string > & outputFileNames );
+
+  /** Typedefs for resampling the images in threads. */
+  typedef typename ResamplerBaseType::ITKBaseType  ResampleImageFilterType;
+  typedef typename ResampleImageFilterType::Pointer ResampleImageFilterPointer;
+  struct ResampleImagesThreaderParameterType
+  {
+    Self *                                    st_Elastix;
+    const std::vector< std::string > *        st_OutputFileNames;
+    std::vector< ResampleImageFilterPointer > st_Resamplers;
+    bool                                      st_UseDirectionCosines;
+    unsigned int                              st_NextImage;
+    itk::SimpleMutexLock                      st_Mutex;
+    xl::xoutbase_type *                       st_Xout;
+    bool                                      st_Failed;
+    itk::ExceptionObject                      st_Exception;
+  };
+
+  /** Resample and write images, in a thread. */
+  static ITK_THREAD_RETURN_TYPE ResampleImagesThreaderCallback( void * arg );
+
 private:
 
   ElastixTemplate( const Self & ); // purposely not implemented
@@ -19,6 +19,9 @@
 #define __elxElastixTemplate_hxx
 
 #include "elxElastixTemplate.h"
+#include "itkAdvancedRayCastInterpolateImageFunction.h"
+
+#include <algorithm>
 
 #define elxCheckAndSetComponentMacro( _name ) \
   _name##BaseType * base = this->GetElx##_name##Base( i ); \
@@ -60,6 +63,9 @@ ElastixTemplate< TFixedImage, TMovingImage >
   /** Initialize the this->m_IterationCounter. */
   this->m_IterationCounter = 0;
 
+  this->m_WriteTransformParametersEachIteration = false;
+  this->m_IterationTelemetry                    = IterationTelemetry::New();
+
   /** Initialize CurrentTransformParameterFileName. */
   this->m_CurrentTransformParameterFileName = "";
   this->m_TransformParametersMap.clear();
@@ -222,46 +228,7 @@ ElastixTemplate< TFixedImage, TMovingImage >
   elxout << "\nReading images..." << std::endl;
 
   /** Read images and masks, if not set already. */
-  const bool              useDirCos = this->GetUseDirectionCosines();
-  FixedImageDirectionType fixDirCos;
-  if( this->GetFixedImage() == 0 )
-  {
-    this->SetFixedImageContainer(
-      FixedImageLoaderType::GenerateImageContainer(
-      this->GetFixedImageFileNameContainer(), "Fixed Image", useDirCos, &fixDirCos ) );
-    this->SetOriginalFixedImageDirection( fixDirCos );
-  }
-  else
-  {
-    /**
-     *  images are set in elastixlib.cxx
-     *  just set direction cosines
-     *  in case images are imported for executable it does not matter
-     *  because the InfoChanger has changed these images.
-     */
-    FixedImageType * fixedIm = this->GetFixedImage( 0 );
-    fixDirCos = fixedIm->GetDirection();
-    this->SetOriginalFixedImageDirection( fixDirCos );
-  }
-
-  if( this->GetMovingImage() == 0 )
-  {
-    this->SetMovingImageContainer(
-      MovingImageLoaderType::GenerateImageContainer(
-      this->GetMovingImageFileNameContainer(), "Moving Image", useDirCos ) );
-  }
-  if( this->GetFixedMask() == 0 )
-  {
-    this->SetFixedMaskContainer(
-      FixedMaskLoaderType::GenerateImageContainer(
-      this->GetFixedMaskFileNameContainer(), "Fixed Mask", useDirCos ) );
-  }
-  if( this->GetMovingMask() == 0 )
-  {
-    this->SetMovingMaskContainer(
-      MovingMaskLoaderType::GenerateImageContainer(
-      this->GetMovingMaskFileNameContainer(), "Moving Mask", useDirCos ) );
-  }
+  this->ReadImageContainers();
 
   /** Print the time spent on reading images. */
   this->m_Timer0.Stop();
@@ -322,6 +289,142 @@ ElastixTemplate< TFixedImage, TMovingImage >
 } // end Run()
 
 
+/**
+ * ********************** ReadImageContainers ***********************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ElastixTemplate< TFixedImage, TMovingImage >
+::ReadImageContainers( void )
+{
+  /** Check which containers should be read. */
+  ReadImageContainersThreaderParameterType parameters;
+  parameters.st_Elastix             = this;
+  parameters.st_UseDirectionCosines = this->GetUseDirectionCosines();
+  parameters.st_Read[ 0 ]           = ( this->GetFixedImage() == 0 );
+  parameters.st_Read[ 1 ]           = ( this->GetMovingImage() == 0 );
+  parameters.st_Read[ 2 ]           = ( this->GetFixedMask() == 0 );
+  parameters.st_Read[ 3 ]           = ( this->GetMovingMask() == 0 );
+  for( unsigned int i = 0; i < 4; ++i )
+  {
+    parameters.st_Failed[ i ] = false;
+  }
+
+  /** Make sure that the object factories are initialized before the
+   * threads ask them for an ImageIO.
+   */
+  itk::ObjectFactoryBase::CreateAllInstance( "itkImageIOBase" );
+
+  /** Read the containers concurrently. */
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( 4 );
+  itk::PersistentThreadPool::Launch( threader,
+    Self::ReadImageContainersThreaderCallback, &parameters );
+
+  /** Pass on the first error, in the order in which the containers
+   * used to be read one after another.
+   */
+  for( unsigned int i = 0; i < 4; ++i )
+  {
+    if( parameters.st_Failed[ i ] )
+    {
+      throw parameters.st_Exceptions[ i ];
+    }
+  }
+
+  /** Store the containers. */
+  if( parameters.st_Read[ 0 ] )
+  {
+    this->SetFixedImageContainer( parameters.st_Containers[ 0 ] );
+    this->SetOriginalFixedImageDirection( parameters.st_FixedImageDirection );
+  }
+  else
+  {
+    /**
+     *  images are set in elastixlib.cxx
+     *  just set direction cosines
+     *  in case images are imported for executable it does not matter
+     *  because the InfoChanger has changed these images.
+     */
+    FixedImageType * fixedIm = this->GetFixedImage( 0 );
+    this->SetOriginalFixedImageDirection( fixedIm->GetDirection() );
+  }
+
+  if( parameters.st_Read[ 1 ] )
+  {
+    this->SetMovingImageContainer( parameters.st_Containers[ 1 ] );
+  }
+  if( parameters.st_Read[ 2 ] )
+  {
+    this->SetFixedMaskContainer( parameters.st_Containers[ 2 ] );
+  }
+  if( parameters.st_Read[ 3 ] )
+  {
+    this->SetMovingMaskContainer( parameters.st_Containers[ 3 ] );
+  }
+
+} // end ReadImageContainers()
+
+
+/**
+ * **************** ReadImageContainersThreaderCallback *******
+ */
+
+template< class TFixedImage, class TMovingImage >
+ITK_THREAD_RETURN_TYPE
+ElastixTemplate< TFixedImage, TMovingImage >
+::ReadImageContainersThreaderCallback( void * arg )
+{
+  ThreadInfoType *  infoStruct  = static_cast< ThreadInfoType * >( arg );
+  itk::ThreadIdType threadID    = infoStruct->ThreadID;
+  itk::ThreadIdType nrOfThreads = infoStruct->NumberOfThreads;
+
+  ReadImageContainersThreaderParameterType * temp
+    = static_cast< ReadImageContainersThreaderParameterType * >( infoStruct->UserData );
+  const Self * elastix   = temp->st_Elastix;
+  const bool   useDirCos = temp->st_UseDirectionCosines;
+
+  /** There may be less threads than containers. */
+  for( unsigned int i = threadID; i < 4; i += nrOfThreads )
+  {
+    if( !temp->st_Read[ i ] ) { continue; }
+
+    try
+    {
+      switch( i )
+      {
+        case 0:
+          temp->st_Containers[ i ] = FixedImageLoaderType::GenerateImageContainer(
+            elastix->GetFixedImageFileNameContainer(), "Fixed Image", useDirCos,
+            &temp->st_FixedImageDirection );
+          break;
+        case 1:
+          temp->st_Containers[ i ] = MovingImageLoaderType::GenerateImageContainer(
+            elastix->GetMovingImageFileNameContainer(), "Moving Image", useDirCos );
+          break;
+        case 2:
+          temp->st_Containers[ i ] = FixedMaskLoaderType::GenerateImageContainer(
+            elastix->GetFixedMaskFileNameContainer(), "Fixed Mask", useDirCos );
+          break;
+        case 3:
+          temp->st_Containers[ i ] = MovingMaskLoaderType::GenerateImageContainer(
+            elastix->GetMovingMaskFileNameContainer(), "Moving Mask", useDirCos );
+          break;
+      }
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      temp->st_Failed[ i ]     = true;
+      temp->st_Exceptions[ i ] = excp;
+    }
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ReadImageContainersThreaderCallback()
+
+
 /**
  * ************************ ApplyTransform **********************
  */
@@ -341,12 +444,18 @@ ElastixTemplate< TFixedImage, TMovingImage >
   int dummy = this->BeforeAllTransformix();
   if( dummy != 0 ) { return dummy; }
 
+  /** With more than one input image file name, all of them are resampled
+   * with the same transform. Only the first one is read here; the others
+   * are read while the images are resampled.
+   */
+  const unsigned int numberOfInputImages = this->GetNumberOfMovingImageFileNames();
+  const bool         batchMode = numberOfInputImages > 1 && this->GetMovingImage() == 0;
+
   /** Set the inputImage (=movingImage).
    * If "-in" was given or an input image was given in some other way,
    * load the image.
    */
-  if( ( this->GetNumberOfMovingImageFileNames() > 0 )
-    || ( this->GetMovingImage() != 0 ) )
+  if( ( numberOfInputImages > 0 ) || ( this->GetMovingImage() != 0 ) )
   {
     /** Timer. */
     timer.Start();
@@ -358,9 +467,16 @@ ElastixTemplate< TFixedImage, TMovingImage >
     const bool useDirCos = this->GetUseDirectionCosines();
     if( this->GetMovingImage() == 0 )
     {
+      FileNameContainerPointer fileNames = this->GetMovingImageFileNameContainer();
+      if( batchMode )
+      {
+        fileNames = FileNameContainerType::New();
+        fileNames->CreateElementAt( 0 )
+          = this->GetMovingImageFileNameContainer()->ElementAt( 0 );
+      }
       this->SetMovingImageContainer(
         MovingImageLoaderType::GenerateImageContainer(
-        this->GetMovingImageFileNameContainer(), "Input Image", useDirCos ) );
+        fileNames, "Input Image", useDirCos ) );
     } // end if !moving image
 
     /** Tell the user. */
@@ -449,27 +565,56 @@ ElastixTemplate< TFixedImage, TMovingImage >
   /** Resample the image. */
   if( this->GetMovingImage() != 0 )
   {
+    /** Optimize the transform chain for resampling. */
+    timer.Reset();
+    timer.Start();
+    elxout << "Optimizing the transform chain ..." << std::endl;
+    this->GetElxTransformBase()->OptimizeTransformChain(
+      batchMode ? numberOfInputImages : 1 );
+    timer.Stop();
+    elxout << "  Optimizing the transform chain took "
+      << this->ConvertSecondsToDHMS( timer.GetMean(), 2 ) << std::endl;
+
     timer.Reset();
     timer.Start();
-    elxout << "Resampling image and writing to disk ..." << std::endl;
 
     /** Create a name for the final result. */
     std::string resultImageFormat = "mhd";
     this->GetConfiguration()->ReadParameter( resultImageFormat,
       "ResultImageFormat", 0, false );
-    std::ostringstream makeFileName( "" );
-    makeFileName << this->GetConfiguration()->GetCommandLineArgument( "-out" )
-                 << "result." << resultImageFormat;
+    const std::string outputFolder
+      = this->GetConfiguration()->GetCommandLineArgument( "-out" );
 
-    /** Write the resampled image to disk.
-     * Actually we could loop over all resamplers.
-     * But for now, there seems to be no use yet for that.
-     */
+    if( batchMode )
+    {
+      /** The result of input image i is written to result.<i>.<format>. */
+      elxout << "Resampling " << numberOfInputImages
+             << " images and writing to disk ..." << std::endl;
+      std::vector< std::string > outputFileNames( numberOfInputImages );
+      for( unsigned int i = 0; i < numberOfInputImages; ++i )
+      {
+        std::ostringstream makeFileName( "" );
+        makeFileName << outputFolder << "result." << i << "." << resultImageFormat;
+        outputFileNames[ i ] = makeFileName.str();
+      }
+      this->ResampleAndWriteImages( outputFileNames );
+    }
+    else
+    {
+      elxout << "Resampling image and writing to disk ..." << std::endl;
+      std::ostringstream makeFileName( "" );
+      makeFileName << outputFolder << "result." << resultImageFormat;
+
+      /** Write the resampled image to disk.
+       * Actually we could loop over all resamplers.
+       * But for now, there seems to be no use yet for that.
+       */
 #ifndef _ELASTIX_BUILD_LIBRARY
-    this->GetElxResamplerBase()->ResampleAndWriteResultImage( makeFileName.str().c_str() );
+      this->GetElxResamplerBase()->ResampleAndWriteResultImage( makeFileName.str().c_str() );
 #else
-    this->GetElxResamplerBase()->CreateItkResultImage();
+      this->GetElxResamplerBase()->CreateItkResultImage();
 #endif
+    }
 
     /** Print the elapsed time for the resampling. */
     timer.Stop();
@@ -498,6 +643,207 @@ ElastixTemplate< TFixedImage, TMovingImage >
 } // end ApplyTransform()
 
 
+/**
+ * ************************ ResampleAndWriteImages **********************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ElastixTemplate< TFixedImage, TMovingImage >
+::ResampleAndWriteImages( const std::vector< std::string > & outputFileNames )
+{
+  typedef itk::AdvancedRayCastInterpolateImageFunction<
+    MovingImageType, CoordRepType >                   RayCastInterpolatorType;
+
+  const unsigned int numberOfImages = outputFileNames.size();
+  ResamplerBaseType *       elxResampler = this->GetElxResamplerBase();
+  ResampleImageFilterType * resampler    = elxResampler->GetAsITKBaseType();
+
+  /** Determine how many images are resampled at the same time. The
+   * RayCastResampleInterpolator replaces the transform of the resampler,
+   * so it can only be used by the resampler component itself.
+   */
+  unsigned int numberOfConcurrentImages = 4;
+  this->GetConfiguration()->ReadParameter( numberOfConcurrentImages,
+    "NumberOfConcurrentResamplings", 0, false );
+  const unsigned int numberOfThreads = static_cast< unsigned int >(
+    itk::MultiThreader::GetGlobalDefaultNumberOfThreads() );
+  numberOfConcurrentImages = std::min( numberOfConcurrentImages,
+    std::min( numberOfImages, numberOfThreads ) );
+  if( numberOfConcurrentImages < 1
+    || dynamic_cast< const RayCastInterpolatorType * >( resampler->GetInterpolator() ) )
+  {
+    numberOfConcurrentImages = 1;
+  }
+
+  /** Resample the images one after another with the resampler component. */
+  if( numberOfConcurrentImages == 1 )
+  {
+    for( unsigned int i = 0; i < numberOfImages; ++i )
+    {
+      if( i > 0 )
+      {
+        FileNameContainerPointer fileName = FileNameContainerType::New();
+        fileName->CreateElementAt( 0 ) = this->GetMovingImageFileNameContainer()->ElementAt( i );
+        this->SetMovingImageContainer( MovingImageLoaderType::GenerateImageContainer(
+          fileName, "Input Image", this->GetUseDirectionCosines() ) );
+        resampler->SetInput( this->GetMovingImage() );
+      }
+      elxout << "  Resampling image " << i << ": "
+             << this->GetMovingImageFileNameContainer()->ElementAt( i ) << std::endl;
+      elxResampler->ResampleAndWriteResultImage( outputFileNames[ i ].c_str() );
+    }
+    return;
+  }
+
+  /** Set up a resampler for each image in flight, with the same output
+   * geometry and transform as the resampler component, and a copy of the
+   * resample interpolator.
+   */
+  elxout << "  Resampling " << numberOfConcurrentImages
+         << " images at the same time." << std::endl;
+  ResampleImagesThreaderParameterType parameters;
+  parameters.st_Elastix             = this;
+  parameters.st_OutputFileNames     = &outputFileNames;
+  parameters.st_UseDirectionCosines = this->GetUseDirectionCosines();
+  parameters.st_NextImage           = 0;
+  parameters.st_Xout                = xl::get_thread_xout();
+  parameters.st_Failed              = false;
+  parameters.st_Resamplers.resize( numberOfConcurrentImages );
+  for( unsigned int j = 0; j < numberOfConcurrentImages; ++j )
+  {
+    itk::LightObject::Pointer anotherObject
+      = this->GetElxResampleInterpolatorBase()->GetAsITKBaseType()->CreateAnother();
+    ResampleInterpolatorBaseType * interpolator
+      = dynamic_cast< ResampleInterpolatorBaseType * >( anotherObject.GetPointer() );
+    interpolator->SetComponentLabel( "ResampleInterpolator", 0 );
+    interpolator->SetElastix( this );
+    interpolator->ReadFromFile();
+
+    ResampleImageFilterPointer imageResampler = ResampleImageFilterType::New();
+    imageResampler->SetTransform( resampler->GetTransform() );
+    imageResampler->SetInterpolator( interpolator->GetAsITKBaseType() );
+    imageResampler->SetSize( resampler->GetSize() );
+    imageResampler->SetOutputStartIndex( resampler->GetOutputStartIndex() );
+    imageResampler->SetOutputOrigin( resampler->GetOutputOrigin() );
+    imageResampler->SetOutputSpacing( resampler->GetOutputSpacing() );
+    imageResampler->SetOutputDirection( resampler->GetOutputDirection() );
+    imageResampler->SetDefaultPixelValue( resampler->GetDefaultPixelValue() );
+    imageResampler->SetNumberOfThreads(
+      std::max( numberOfThreads / numberOfConcurrentImages, 1u ) );
+    parameters.st_Resamplers[ j ] = imageResampler;
+  }
+
+  /** Make sure that the object factories are initialized before the
+   * threads ask them for an ImageIO.
+   */
+  itk::ObjectFactoryBase::CreateAllInstance( "itkImageIOBase" );
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( numberOfConcurrentImages );
+  itk::PersistentThreadPool::Launch( threader,
+    Self::ResampleImagesThreaderCallback, &parameters );
+
+  if( parameters.st_Failed )
+  {
+    throw parameters.st_Exception;
+  }
+
+} // end ResampleAndWriteImages()
+
+
+/**
+ * **************** ResampleImagesThreaderCallback *******
+ */
+
+template< class TFixedImage, class TMovingImage >
+ITK_THREAD_RETURN_TYPE
+ElastixTemplate< TFixedImage, TMovingImage >
+::ResampleImagesThreaderCallback( void * arg )
+{
+  ThreadInfoType *  infoStruct = static_cast< ThreadInfoType * >( arg );
+  itk::ThreadIdType threadID   = infoStruct->ThreadID;
+
+  ResampleImagesThreaderParameterType * temp
+    = static_cast< ResampleImagesThreaderParameterType * >( infoStruct->UserData );
+  Self *                    elastix   = temp->st_Elastix;
+  ResampleImageFilterType * resampler = temp->st_Resamplers[ threadID ];
+  const unsigned int        numberOfImages
+    = static_cast< unsigned int >( temp->st_OutputFileNames->size() );
+
+  /** Log to the xout of the thread that started the resampling. */
+  xl::xoutbase_type * previousXout = xl::get_thread_xout();
+  xl::set_thread_xout( temp->st_Xout );
+
+  while( true )
+  {
+    /** Take the next image. */
+    temp->st_Mutex.Lock();
+    const unsigned int i = temp->st_NextImage++;
+    const bool         stop = temp->st_Failed || i >= numberOfImages;
+    temp->st_Mutex.Unlock();
+    if( stop ) { break; }
+
+    const std::string & inputFileName
+      = elastix->GetMovingImageFileNameContainer()->ElementAt( i );
+    const std::string & outputFileName = ( *temp->st_OutputFileNames )[ i ];
+    try
+    {
+      /** Read and resample the image. The first image is already read. */
+      DataObjectContainerPointer container = elastix->GetMovingImageContainer();
+      if( i > 0 )
+      {
+        FileNameContainerPointer fileName = FileNameContainerType::New();
+        fileName->CreateElementAt( 0 ) = inputFileName;
+        container = MovingImageLoaderType::GenerateImageContainer(
+          fileName, "Input Image", temp->st_UseDirectionCosines );
+      }
+      resampler->SetInput( dynamic_cast< MovingImageType * >(
+        container->ElementAt( 0 ).GetPointer() ) );
+      resampler->Update();
+
+      /** The writing reads the parameter file and logs, which is done
+       * by one thread at a time.
+       */
+      temp->st_Mutex.Lock();
+      try
+      {
+        elastix->GetElxResamplerBase()->WriteResultImage(
+          resampler->GetOutput(), outputFileName.c_str(), false );
+        elxout << "  Resampled image " << i << ": " << inputFileName
+               << " -> " << outputFileName << std::endl;
+      }
+      catch( itk::ExceptionObject & )
+      {
+        temp->st_Mutex.Unlock();
+        throw;
+      }
+      temp->st_Mutex.Unlock();
+
+      /** Release the memory of this image before the next one is read. */
+      resampler->SetInput( 0 );
+      resampler->GetOutput()->ReleaseData();
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      temp->st_Mutex.Lock();
+      if( !temp->st_Failed )
+      {
+        temp->st_Failed    = true;
+        temp->st_Exception = excp;
+      }
+      temp->st_Mutex.Unlock();
+      break;
+    }
+  }
+
+  xl::set_thread_xout( previousXout );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ResampleImagesThreaderCallback()
+
+
 /**
  * ************************ BeforeAll ***************************
  */
@@ -586,6 +932,42 @@ ElastixTemplate< TFixedImage, TMovingImage >
   xout[ "iteration" ].AddTargetCell( "Time[ms]" );
   xout[ "iteration" ][ "Time[ms]" ] << std::showpoint << std::fixed << std::setprecision( 1 );
 
+  /** Open the iteration telemetry, if requested. */
+  this->m_WriteIterationInfo = true;
+  std::string iterationTelemetry = "off";
+  this->GetConfiguration()->ReadParameter( iterationTelemetry,
+    "IterationTelemetry", 0, false );
+  if( iterationTelemetry == "csv" || iterationTelemetry == "binary" )
+  {
+    const bool         binary = ( iterationTelemetry == "binary" );
+    std::ostringstream makeFileName( "" );
+    makeFileName << this->GetConfiguration()->GetCommandLineArgument( "-out" )
+                 << "IterationTelemetry."
+                 << this->GetConfiguration()->GetElastixLevel()
+                 << ( binary ? ".bin" : ".csv" );
+    std::string fileName = makeFileName.str();
+
+    if( this->m_IterationTelemetry->Open( fileName, binary ) )
+    {
+      /** The iteration table is not written anymore. Components that
+       * check GetWriteIterationInfo() do not fill their cells; the cells
+       * of the others are emptied after each resolution.
+       */
+      this->m_WriteIterationInfo = false;
+      xout[ "iteration" ].SetOutputs( xoutbase_type::CStreamMapType() );
+      xout[ "iteration" ].SetOutputs( xoutbase_type::XStreamMapType() );
+    }
+    else
+    {
+      xout[ "error" ] << "ERROR: File \"" << fileName << "\" could not be opened!" << std::endl;
+    }
+  }
+  else if( iterationTelemetry != "off" )
+  {
+    xout[ "warning" ] << "WARNING: unknown IterationTelemetry \"" << iterationTelemetry
+                      << "\", the iteration table is written as usual." << std::endl;
+  }
+
   /** Print time for initializing. */
   this->m_Timer0.Stop();
   elxout << "Initialization of all components (before registration) took: "
@@ -634,11 +1016,16 @@ ElastixTemplate< TFixedImage, TMovingImage >
   bool writeIterationInfo = true;
   this->GetConfiguration()->ReadParameter( writeIterationInfo,
     "WriteIterationInfo", 0, false );
-  if( writeIterationInfo )
+  if( writeIterationInfo && !this->m_IterationTelemetry->IsOpen() )
   {
     this->OpenIterationInfoFile();
   }
 
+  /** Read the parameters that are used in each iteration. */
+  this->m_WriteTransformParametersEachIteration = false;
+  this->GetConfiguration()->ReadParameter( this->m_WriteTransformParametersEachIteration,
+    "WriteTransformParametersEachIteration", 0, false );
+
   /** Call all the BeforeEachResolution() functions. */
   this->BeforeEachResolutionBase();
   CallInEachComponent( &BaseComponentType::BeforeEachResolutionBase );
@@ -686,6 +1073,14 @@ ElastixTemplate< TFixedImage, TMovingImage >
     << " s.\n";
   elxout << std::setprecision( this->GetDefaultOutputPrecision() );
 
+  /** Empty the cells of the iteration table that components filled,
+   * although the table is not written.
+   */
+  if( !this->m_WriteIterationInfo )
+  {
+    xout[ "iteration" ].WriteBufferedData();
+  }
+
   /** Call all the AfterEachResolution() functions. */
   this->AfterEachResolutionBase();
   CallInEachComponent( &BaseComponentType::AfterEachResolutionBase );
@@ -729,8 +1124,21 @@ void
 ElastixTemplate< TFixedImage, TMovingImage >
 ::AfterEachIteration( void )
 {
+  /** For the telemetry, measure the time of the optimizer separately
+   * from the time of the AfterEachIteration() functions.
+   */
+  const bool useTelemetry  = this->m_IterationTelemetry->IsOpen();
+  double     optimizerTime = 0.0;
+  if( useTelemetry )
+  {
+    this->m_IterationTimer.Stop();
+    optimizerTime = this->m_IterationTimer.GetMean() * 1000.0;
+    this->m_IterationTimer.Reset();
+    this->m_IterationTimer.Start();
+  }
+
   /** Write the headers of the columns that are printed each iteration. */
-  if( this->m_IterationCounter == 0 )
+  if( this->m_IterationCounter == 0 && this->m_WriteIterationInfo )
   {
     xout[ "iteration" ][ "WriteHeaders" ];
   }
@@ -740,21 +1148,35 @@ ElastixTemplate< TFixedImage, TMovingImage >
   CallInEachComponent( &BaseComponentType::AfterEachIterationBase );
   CallInEachComponent( &BaseComponentType::AfterEachIteration );
 
-  /** Write the iteration number to the table. */
-  xout[ "iteration" ][ "1:ItNr" ] << m_IterationCounter;
-
   /** Time in this iteration. */
   this->m_IterationTimer.Stop();
-  xout[ "iteration" ][ "Time[ms]" ] << this->m_IterationTimer.GetMean() * 1000.0;
 
-  /** Write the iteration info of this iteration. */
-  xout[ "iteration" ].WriteBufferedData();
+  /** Write the iteration info of this iteration. With the telemetry the
+   * table is skipped; the cells that components filled anyway are emptied
+   * in AfterEachResolution().
+   */
+  if( this->m_WriteIterationInfo )
+  {
+    xout[ "iteration" ][ "1:ItNr" ] << m_IterationCounter;
+    xout[ "iteration" ][ "Time[ms]" ] << this->m_IterationTimer.GetMean() * 1000.0;
+    xout[ "iteration" ].WriteBufferedData();
+  }
+
+  /** Store the record of this iteration. */
+  if( useTelemetry )
+  {
+    IterationTelemetry::RecordType record;
+    record.Resolution = this->GetElxRegistrationBase()->GetAsITKBaseType()->GetCurrentLevel();
+    record.Iteration  = this->m_IterationCounter;
+    this->GetElxOptimizerBase()->GetIterationTelemetry(
+      record.Value, record.StepSize, record.GradientMagnitude );
+    record.OptimizerTime = optimizerTime;
+    record.ObserverTime  = this->m_IterationTimer.GetMean() * 1000.0;
+    this->m_IterationTelemetry->Push( record );
+  }
 
   /** Create a TransformParameter-file for the current iteration. */
-  bool writeTansformParametersThisIteration = false;
-  this->GetConfiguration()->ReadParameter( writeTansformParametersThisIteration,
-    "WriteTransformParametersEachIteration", 0, false );
-  if( writeTansformParametersThisIteration )
+  if( this->m_WriteTransformParametersEachIteration )
   {
     /** Add zeros to the number of iterations, to make sure
      * it always consists of 7 digits.
@@ -837,6 +1259,7 @@ ElastixTemplate< TFixedImage, TMovingImage >
 #endif
 
   /** Call all the AfterRegistration() functions. */
+  this->m_IterationTelemetry->Close();
   this->AfterRegistrationBase();
   CallInEachComponent( &BaseComponentType::AfterRegistrationBase );
   CallInEachComponent( &BaseComponentType::AfterRegistration );
@@ -0,0 +1,278 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "elxIterationTelemetry.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace elastix
+{
+
+/**
+ * ****************** Constructor *********************************
+ */
+
+IterationTelemetry
+::IterationTelemetry()
+{
+  this->m_BufferSize          = 4096;
+  this->m_Binary              = false;
+  this->m_Begin               = 0;
+  this->m_Count               = 0;
+  this->m_Shutdown            = false;
+  this->m_DataAvailable       = itk::ConditionVariable::New();
+  this->m_SpaceAvailable      = itk::ConditionVariable::New();
+  this->m_Spawner             = itk::MultiThreader::New();
+  this->m_WriterThreadId      = 0;
+  this->m_WriterThreadRunning = false;
+
+} // end Constructor
+
+
+/**
+ * ****************** Destructor *********************************
+ */
+
+IterationTelemetry
+::~IterationTelemetry()
+{
+  this->Close();
+
+} // end Destructor
+
+
+/**
+ * ****************** Open *********************************
+ */
+
+bool
+IterationTelemetry
+::Open( const std::string & fileName, bool binary )
+{
+  this->Close();
+
+  if( binary )
+  {
+    this->m_File.open( fileName.c_str(), std::ios::out | std::ios::binary );
+  }
+  else
+  {
+    this->m_File.open( fileName.c_str() );
+  }
+  if( !this->m_File.is_open() )
+  {
+    return false;
+  }
+
+  this->m_Binary = binary;
+  if( !binary )
+  {
+    this->m_File << std::setprecision( 12 );
+    this->m_File << "Resolution,Iteration,Value,StepSize,GradientMagnitude,"
+                 << "OptimizerTime[ms],ObserverTime[ms]\n";
+  }
+
+  /** Allocate the ring buffer once, so that Push() never allocates. */
+  this->m_Buffer.resize( std::max( this->m_BufferSize, 1u ) );
+  this->m_Begin    = 0;
+  this->m_Count    = 0;
+  this->m_Shutdown = false;
+
+  this->m_WriterThreadId
+    = this->m_Spawner->SpawnThread( Self::WriterThreadCallback, this );
+  this->m_WriterThreadRunning = true;
+
+  return true;
+
+} // end Open()
+
+
+/**
+ * ****************** Close *********************************
+ */
+
+void
+IterationTelemetry
+::Close( void )
+{
+  if( !this->m_WriterThreadRunning )
+  {
+    return;
+  }
+
+  /** The writer thread writes the remaining records before it stops. */
+  this->m_Mutex.Lock();
+  this->m_Shutdown = true;
+  this->m_DataAvailable->Signal();
+  this->m_Mutex.Unlock();
+
+  /** TerminateThread() joins the thread. */
+  this->m_Spawner->TerminateThread( this->m_WriterThreadId );
+  this->m_WriterThreadRunning = false;
+
+  this->m_File.close();
+
+} // end Close()
+
+
+/**
+ * ****************** Push *********************************
+ */
+
+void
+IterationTelemetry
+::Push( const RecordType & record )
+{
+  const std::size_t bufferSize = this->m_Buffer.size();
+
+  this->m_Mutex.Lock();
+  while( this->m_Count == bufferSize )
+  {
+    this->m_DataAvailable->Signal();
+    this->m_SpaceAvailable->Wait( &this->m_Mutex );
+  }
+
+  /** Append the record behind the pending ones. */
+  this->m_Buffer[ ( this->m_Begin + this->m_Count ) % bufferSize ] = record;
+  ++this->m_Count;
+
+  /** Wake up the writer once the buffer is half full. */
+  if( this->m_Count == std::max( bufferSize / 2, static_cast< std::size_t >( 1 ) ) )
+  {
+    this->m_DataAvailable->Signal();
+  }
+  this->m_Mutex.Unlock();
+
+} // end Push()
+
+
+/**
+ * ****************** WriteRecords *********************************
+ */
+
+void
+IterationTelemetry
+::WriteRecords( std::size_t begin, std::size_t count )
+{
+  const RecordType * records = &this->m_Buffer[ begin ];
+
+  if( this->m_Binary )
+  {
+    this->m_File.write( reinterpret_cast< const char * >( records ),
+      static_cast< std::streamsize >( count * sizeof( RecordType ) ) );
+    return;
+  }
+
+  for( std::size_t i = 0; i < count; ++i )
+  {
+    const RecordType & record = records[ i ];
+    this->m_File << record.Resolution << ','
+                 << record.Iteration << ','
+                 << record.Value << ','
+                 << record.StepSize << ','
+                 << record.GradientMagnitude << ','
+                 << record.OptimizerTime << ','
+                 << record.ObserverTime << '\n';
+  }
+
+} // end WriteRecords()
+
+
+/**
+ * ****************** WriterLoop *********************************
+ */
+
+void
+IterationTelemetry
+::WriterLoop( void )
+{
+  const std::size_t bufferSize = this->m_Buffer.size();
+  const std::size_t threshold  = std::max( bufferSize / 2, static_cast< std::size_t >( 1 ) );
+
+  this->m_Mutex.Lock();
+  while( true )
+  {
+    while( !this->m_Shutdown && this->m_Count < threshold )
+    {
+      this->m_DataAvailable->Wait( &this->m_Mutex );
+    }
+    if( this->m_Count == 0 )
+    {
+      /** Shut down, and everything is written. */
+      break;
+    }
+
+    /** Write the contiguous part of the pending records. Push() only
+     * writes outside this part, so the lock can be released.
+     */
+    const std::size_t begin = this->m_Begin;
+    const std::size_t count = std::min( this->m_Count, bufferSize - begin );
+    this->m_Mutex.Unlock();
+
+    this->WriteRecords( begin, count );
+
+    this->m_Mutex.Lock();
+    this->m_Begin  = ( begin + count ) % bufferSize;
+    this->m_Count -= count;
+    this->m_SpaceAvailable->Signal();
+  }
+  this->m_Mutex.Unlock();
+
+  this->m_File.flush();
+
+} // end WriterLoop()
+
+
+/**
+ * ****************** WriterThreadCallback *********************************
+ */
+
+ITK_THREAD_RETURN_TYPE
+IterationTelemetry
+::WriterThreadCallback( void * arg )
+{
+  typedef itk::MultiThreader::ThreadInfoStruct ThreadInfoType;
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  Self *           telemetry  = static_cast< Self * >( infoStruct->UserData );
+
+  telemetry->WriterLoop();
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end WriterThreadCallback()
+
+
+/**
+ * ****************** PrintSelf *********************************
+ */
+
+void
+IterationTelemetry
+::PrintSelf( std::ostream & os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "BufferSize: " << this->m_BufferSize << std::endl;
+  os << indent << "Binary: " << this->m_Binary << std::endl;
+  os << indent << "WriterThreadRunning: " << this->m_WriterThreadRunning << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace elastix
@@ -0,0 +1,155 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __elxIterationTelemetry_h
+#define __elxIterationTelemetry_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleMutexLock.h"
+#include "itkConditionVariable.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace elastix
+{
+
+/**
+ * \class IterationTelemetry
+ * \brief Stores a record for each iteration, and writes the records to
+ * file in a separate thread.
+ *
+ * The iteration table of xout formats each cell and flushes it to the
+ * outputs in every iteration. When the iterations are cheap, this takes a
+ * considerable part of the run time. This class stores a fixed-size record
+ * per iteration in a preallocated ring buffer. A writer thread writes the
+ * records to a CSV or binary file whenever the buffer is half full, so
+ * Push() only copies the record. Only when the buffer is full Push() waits
+ * for the writer.
+ *
+ * The binary file contains the records as they are stored in memory (a
+ * RecordType in native byte order per iteration), without a header.
+ *
+ * \ingroup Kernel
+ */
+
+class IterationTelemetry : public itk::Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef IterationTelemetry              Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer< Self >       Pointer;
+  typedef itk::SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( IterationTelemetry, itk::Object );
+
+  /** The information of one iteration. Values that the optimizer does
+   * not provide are NaN. The times are in milliseconds.
+   */
+  struct RecordType
+  {
+    unsigned int Resolution;
+    unsigned int Iteration;
+    double       Value;
+    double       StepSize;
+    double       GradientMagnitude;
+    double       OptimizerTime;
+    double       ObserverTime;
+  };
+
+  /** Set the number of records in the ring buffer. Default: 4096.
+   * Takes effect at the next call to Open().
+   */
+  itkSetMacro( BufferSize, unsigned int );
+  itkGetConstMacro( BufferSize, unsigned int );
+
+  /** Open the file and start the writer thread. Returns false if the
+   * file cannot be opened.
+   */
+  virtual bool Open( const std::string & fileName, bool binary );
+
+  /** Write the remaining records, stop the writer thread and close the file. */
+  virtual void Close( void );
+
+  /** Returns true between Open() and Close(). */
+  bool IsOpen( void ) const
+  {
+    return this->m_WriterThreadRunning;
+  }
+
+
+  /** Store the record of an iteration. Only call this between Open()
+   * and Close(), and from one thread.
+   */
+  void Push( const RecordType & record );
+
+protected:
+
+  IterationTelemetry();
+  virtual ~IterationTelemetry();
+
+  /** PrintSelf. */
+  virtual void PrintSelf( std::ostream & os, itk::Indent indent ) const;
+
+  /** Write count records, starting at position begin in the buffer. */
+  virtual void WriteRecords( std::size_t begin, std::size_t count );
+
+  /** The loop of the writer thread. */
+  void WriterLoop( void );
+
+  /** The function that is started for the writer thread. */
+  static ITK_THREAD_RETURN_TYPE WriterThreadCallback( void * arg );
+
+private:
+
+  IterationTelemetry( const Self & ); // purposely not implemented
+  void operator=( const Self & );     // purposely not implemented
+
+  unsigned int               m_BufferSize;
+  std::vector< RecordType >  m_Buffer;
+  std::ofstream              m_File;
+  bool                       m_Binary;
+
+  /** The records in [m_Begin, m_Begin + m_Count), modulo the buffer size,
+   * are not written yet. Protected by m_Mutex.
+   */
+  std::size_t m_Begin;
+  std::size_t m_Count;
+  bool        m_Shutdown;
+
+  itk::SimpleMutexLock            m_Mutex;
+  itk::ConditionVariable::Pointer m_DataAvailable;
+  itk::ConditionVariable::Pointer m_SpaceAvailable;
+
+  itk::MultiThreader::Pointer m_Spawner;
+  itk::ThreadIdType           m_WriterThreadId;
+  bool                        m_WriterThreadRunning;
+
+};
+
+} // end namespace elastix
+
+#endif // end #ifndef __elxIterationTelemetry_h
@@ -239,8 +239,11 @@ ELASTIX::RegisterImages(
   /** The argv0 argument, required for finding the component.dll/so's. */
   argMap.insert( ArgumentMapEntryType( "-argv0", "elastix" ) );
 
-  /** Setup xout. */
-  returndummy = elx::xoutSetup( logFileName.c_str(), performLogging, performCout );
+  /** Setup xout. This call owns its own xout and logfile, so that several
+   * registrations can run in parallel threads.
+   */
+  elx::xoutManager xoutManager( logFileName.c_str(), performLogging, performCout );
+  returndummy = xoutManager.GetSetupReturnCode();
   if( returndummy && performCout )
   {
     if( performCout )
@@ -403,8 +406,9 @@ ELASTIX::RegisterImages(
   movingMaskContainer  = 0;
   resultImageContainer = 0;
 
-  /** Close the modules. */
-  ElastixMainType::UnloadComponents();
+  /** The component database is kept loaded, because it is shared with
+   * the runs in other threads, and reused by the next call.
+   */
 
   /** Exit and return the error code. */
   return 0;
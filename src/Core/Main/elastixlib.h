@@ -81,6 +81,11 @@ public:
    *    - itk::Image::PixelType must be the same as specified in ParameterMap
    *      ('Fixed/MovingInternalImagePixelType')
    *    - Direction cosines are taken from fixed image (always set UseDirectionCosines TRUE)
+   *    - Each call has its own log, so different ELASTIX objects may register
+   *      in parallel threads. Use a separate outputPath for each of them.
+   *      The number of threads is a process-wide setting of ITK
+   *      (itk::MultiThreader::SetGlobalMaximumNumberOfThreads()), and parallel
+   *      registrations share one pool of threads.
    *  Params:
    *    fixedImage  itk::Image note type should be the same as specified in the Parameterfile
    *      FixedInternalImagePixelType and dimensions!
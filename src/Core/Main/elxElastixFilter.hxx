@@ -155,7 +155,9 @@ ElastixFilter< TFixedImage, TMovingImage >
     }
   }
 
-  if( elx::xoutSetup( logFileName.c_str(), this->GetLogToFile(), this->GetLogToConsole() ) )
+  // Each update owns its xout, so that filters can run in parallel threads
+  elx::xoutManager xoutManager( logFileName.c_str(), this->GetLogToFile(), this->GetLogToConsole() );
+  if( xoutManager.GetSetupReturnCode() )
   {
     itkExceptionMacro( "Error while setting up xout" );
   }
@@ -247,8 +249,7 @@ ElastixFilter< TFixedImage, TMovingImage >
   TransformParameterObject->SetParameterMap( TransformParameterMapVector );
   this->SetOutput( "TransformParameterObject", static_cast< itk::DataObject* >( TransformParameterObject ) );
 
-  // Close the modules
-  ElastixMainType::UnloadComponents();
+  // The component database is kept loaded, it is shared with other filters
 }
 
 // TODO: We should not have to overwrite the ProcessObject's GetOutput()
@@ -143,7 +143,9 @@ TransformixFilter< TInputImage >
     }
   }
 
-  if( elx::xoutSetup( logFileName.c_str(), this->GetLogToFile(), this->GetLogToConsole() ) )
+  // Each update owns its xout, so that filters can run in parallel threads
+  elx::xoutManager xoutManager( logFileName.c_str(), this->GetLogToFile(), this->GetLogToConsole() );
+  if( xoutManager.GetSetupReturnCode() )
   {
     itkExceptionMacro( "Error while setting up xout" );
   }
@@ -206,9 +208,6 @@ TransformixFilter< TInputImage >
   {
     this->GraftOutput( "ResultImage", resultImageContainer->ElementAt( 0 ) );
   }
-
-  // Clean up
-  TransformixMainType::UnloadComponents();
 }
 
 template< typename TInputImage >
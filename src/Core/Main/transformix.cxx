@@ -144,6 +144,8 @@ main( int argc, char ** argv )
 
   /** Check that at least one of the following options is given. */
   if(  argMap.count( "-in" ) == 0
+    && argMap.count( "-in0" ) == 0
+    && argMap.count( "-inlist" ) == 0
     && argMap.count( "-ipp" ) == 0
     && argMap.count( "-def" ) == 0
     && argMap.count( "-jac" ) == 0
@@ -278,6 +280,10 @@ PrintHelp( void )
   /** Optional arguments. */
   std::cout << "Optional extra commands:\n";
   std::cout << "  -in       input image to deform\n";
+  std::cout << "  -in0, -in1, ...\n"
+            << "            several input images to deform with the same transform; the\n"
+            << "            result of input image i is written to result.<i>.<format>\n";
+  std::cout << "  -inlist   text file with the input images to deform, one per line\n";
   std::cout << "  -def      file containing input-image points; the point are transformed\n"
             << "            according to the specified transform-parameter file\n";
   std::cout << "            use \"-def all\" to transform all points from the input-image, which\n"
@@ -171,8 +171,11 @@ TRANSFORMIX::TransformImage(
   /** The argv0 argument, required for finding the component.dll/so's. */
   argMap.insert( ArgumentMapEntryType( "-argv0", "transformix" ) );
 
-  /** Setup xout. */
-  int returndummy2 = elx::xoutSetup( logFileName.c_str(), performLogging, performCout );
+  /** Setup xout. This call owns its own xout and logfile, so that several
+   * transformations can run in parallel threads.
+   */
+  elx::xoutManager xoutManager( logFileName.c_str(), performLogging, performCout );
+  int              returndummy2 = xoutManager.GetSetupReturnCode();
   if( returndummy2 && performCout )
   {
     if( performCout )
@@ -223,7 +226,6 @@ TRANSFORMIX::TransformImage(
 
   /** Clean up. */
   transformix = 0;
-  TransformixMainType::UnloadComponents();
 
   /** Exit and return the error code. */
   return returndummy;
@@ -0,0 +1,26 @@
+#---------------------------------------------------------------------
+# Checks an IterationTelemetry csv file: it should exist, start with the
+# header, and have one row per iteration.
+#
+# Usage:
+# cmake -DTELEMETRY_FILE=<file> -DNUMBER_OF_ITERATIONS=<n> -P elx_check_iteration_telemetry.cmake
+#
+
+if( NOT EXISTS "${TELEMETRY_FILE}" )
+  message( FATAL_ERROR "The telemetry file ${TELEMETRY_FILE} does not exist." )
+endif()
+
+file( STRINGS "${TELEMETRY_FILE}" telemetry_lines )
+list( LENGTH telemetry_lines number_of_lines )
+math( EXPR number_of_rows "${number_of_lines} - 1" )
+
+list( GET telemetry_lines 0 header )
+if( NOT header MATCHES "^Resolution,Iteration,Value," )
+  message( FATAL_ERROR "The telemetry file has an unexpected header: ${header}" )
+endif()
+
+if( NOT number_of_rows EQUAL NUMBER_OF_ITERATIONS )
+  message( FATAL_ERROR "The telemetry file has ${number_of_rows} rows instead of ${NUMBER_OF_ITERATIONS}." )
+endif()
+
+message( STATUS "The telemetry file has ${number_of_rows} rows." )
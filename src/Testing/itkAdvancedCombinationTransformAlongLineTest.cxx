@@ -0,0 +1,234 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkAdvancedCombinationTransform.h"
+#include "itkAdvancedMatrixOffsetTransformBase.h"
+
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+//-------------------------------------------------------------------------------------
+// This test checks that the line functions of a combination of an affine
+// initial transform and a (non-cyclic) B-spline transform give the same
+// result as the point-wise functions, both for addition and composition.
+// The B-spline grid has a non-identity direction. The lines are chosen
+// such that, after the initial transform, they run parallel to one of the
+// grid axes, so that the B-spline transform uses its fast line path. The
+// lines start and end outside the valid grid region. An oblique line,
+// which is transformed point by point, is compared as well.
+
+const unsigned int Dimension   = 2;
+const unsigned int SplineOrder = 3;
+typedef itk::AdvancedCombinationTransform< double, Dimension >                    CombinationTransformType;
+typedef itk::AdvancedBSplineDeformableTransform< double, Dimension, SplineOrder > BSplineTransformType;
+typedef itk::AdvancedMatrixOffsetTransformBase< double, Dimension, Dimension >    AffineTransformType;
+typedef CombinationTransformType::OutputPointContainerType                        OutputPointContainerType;
+typedef CombinationTransformType::SpatialJacobianType                             SpatialJacobianType;
+typedef CombinationTransformType::SpatialJacobianContainerType                    SpatialJacobianContainerType;
+typedef CombinationTransformType::InputPointType                                  InputPointType;
+typedef CombinationTransformType::OutputPointType                                 OutputPointType;
+typedef CombinationTransformType::InputVectorType                                 InputVectorType;
+
+/**
+ * Compare the line-wise and the point-wise functions of a transform.
+ */
+
+int
+CompareLine( const CombinationTransformType * transform,
+  const InputPointType & startPoint, const InputVectorType & step,
+  const unsigned long numberOfPoints, const std::string & description )
+{
+  const double tolerance = 1e-10;
+
+  OutputPointContainerType outputPoints;
+  transform->TransformPointsAlongLine( startPoint, step, numberOfPoints, outputPoints );
+  if( outputPoints.size() != numberOfPoints )
+  {
+    std::cerr << "ERROR: TransformPointsAlongLine() returned "
+              << outputPoints.size() << " instead of " << numberOfPoints
+              << " points for " << description << "." << std::endl;
+    return 1;
+  }
+
+  SpatialJacobianContainerType sjs;
+  transform->GetSpatialJacobianAlongLine( startPoint, step, numberOfPoints, sjs );
+  if( sjs.size() != numberOfPoints )
+  {
+    std::cerr << "ERROR: GetSpatialJacobianAlongLine() returned "
+              << sjs.size() << " instead of " << numberOfPoints
+              << " spatial Jacobians for " << description << "." << std::endl;
+    return 1;
+  }
+
+  for( unsigned long k = 0; k < numberOfPoints; ++k )
+  {
+    InputPointType point;
+    for( unsigned int j = 0; j < Dimension; ++j )
+    {
+      point[ j ] = startPoint[ j ] + static_cast< double >( k ) * step[ j ];
+    }
+
+    const OutputPointType outputPoint     = transform->TransformPoint( point );
+    const double          pointDifference = outputPoint.EuclideanDistanceTo( outputPoints[ k ] );
+    if( pointDifference > tolerance )
+    {
+      std::cerr << "ERROR: TransformPointsAlongLine() differs from "
+                << "TransformPoint() at point " << point << " of "
+                << description << ": " << pointDifference << std::endl;
+      return 1;
+    }
+
+    SpatialJacobianType sj;
+    transform->GetSpatialJacobian( point, sj );
+    const double sjDifference = ( sj.GetVnlMatrix() - sjs[ k ].GetVnlMatrix() ).frobenius_norm();
+    if( sjDifference > tolerance )
+    {
+      std::cerr << "ERROR: GetSpatialJacobianAlongLine() differs from "
+                << "GetSpatialJacobian() at point " << point << " of "
+                << description << ": " << sjDifference << std::endl;
+      return 1;
+    }
+  }
+
+  return 0;
+
+} // end CompareLine()
+
+
+int
+main( int argc, char * argv[] )
+{
+  /** Setup a B-spline grid with a rotated direction. */
+  BSplineTransformType::Pointer bsplineTransform = BSplineTransformType::New();
+
+  BSplineTransformType::SizeType gridSize;
+  gridSize[ 0 ] = 12; gridSize[ 1 ] = 10;
+  BSplineTransformType::RegionType gridRegion;
+  gridRegion.SetSize( gridSize );
+  BSplineTransformType::SpacingType gridSpacing;
+  gridSpacing[ 0 ] = 6.0; gridSpacing[ 1 ] = 5.0;
+  BSplineTransformType::OriginType gridOrigin;
+  gridOrigin[ 0 ] = -20.0; gridOrigin[ 1 ] = -15.0;
+  const double angle = 0.5;
+  BSplineTransformType::DirectionType gridDirection;
+  gridDirection[ 0 ][ 0 ] = std::cos( angle ); gridDirection[ 0 ][ 1 ] = -std::sin( angle );
+  gridDirection[ 1 ][ 0 ] = std::sin( angle ); gridDirection[ 1 ][ 1 ] = std::cos( angle );
+
+  bsplineTransform->SetGridOrigin( gridOrigin );
+  bsplineTransform->SetGridSpacing( gridSpacing );
+  bsplineTransform->SetGridRegion( gridRegion );
+  bsplineTransform->SetGridDirection( gridDirection );
+
+  /** Fill the coefficients with a smooth, but non-trivial pattern. */
+  BSplineTransformType::ParametersType parameters( bsplineTransform->GetNumberOfParameters() );
+  for( unsigned int i = 0; i < parameters.GetSize(); ++i )
+  {
+    parameters[ i ] = 2.0 * std::sin( 0.37 * i ) + std::cos( 1.3 * i );
+  }
+  bsplineTransform->SetParameters( parameters );
+
+  /** An affine initial transform T_0(x) = A x + b. */
+  AffineTransformType::Pointer affineTransform = AffineTransformType::New();
+  AffineTransformType::MatrixType matrix;
+  matrix[ 0 ][ 0 ] = 1.1;  matrix[ 0 ][ 1 ] = 0.15;
+  matrix[ 1 ][ 0 ] = -0.1; matrix[ 1 ][ 1 ] = 0.9;
+  AffineTransformType::OutputVectorType offset;
+  offset[ 0 ] = 3.0; offset[ 1 ] = -2.5;
+  affineTransform->SetMatrix( matrix );
+  affineTransform->SetOffset( offset );
+
+  const double determinant = matrix[ 0 ][ 0 ] * matrix[ 1 ][ 1 ] - matrix[ 0 ][ 1 ] * matrix[ 1 ][ 0 ];
+  AffineTransformType::MatrixType inverseMatrix;
+  inverseMatrix[ 0 ][ 0 ] = matrix[ 1 ][ 1 ] / determinant;
+  inverseMatrix[ 0 ][ 1 ] = -matrix[ 0 ][ 1 ] / determinant;
+  inverseMatrix[ 1 ][ 0 ] = -matrix[ 1 ][ 0 ] / determinant;
+  inverseMatrix[ 1 ][ 1 ] = matrix[ 0 ][ 0 ] / determinant;
+
+  CombinationTransformType::Pointer transform = CombinationTransformType::New();
+  transform->SetCurrentTransform( bsplineTransform );
+  transform->SetInitialTransform( affineTransform );
+
+  const unsigned long numberOfPoints = 40;
+  int                 result         = 0;
+  for( unsigned int useComposition = 0; useComposition < 2; ++useComposition )
+  {
+    transform->SetUseComposition( useComposition == 1 );
+    transform->SetUseAddition( useComposition == 0 );
+    const std::string combination = useComposition ? "composition" : "addition";
+
+    for( unsigned int axis = 0; axis < Dimension; ++axis )
+    {
+      /** A line in the space of the B-spline transform, that runs along a
+       * grid axis through the complete grid, crossing the borders of the
+       * valid region. It starts at a continuous grid index that is not on
+       * a grid point.
+       */
+      double startIndex[ Dimension ] = { 4.3, 3.7 };
+      startIndex[ axis ] = -0.5;
+      InputPointType  gridStartPoint;
+      InputVectorType gridStep;
+      for( unsigned int i = 0; i < Dimension; ++i )
+      {
+        gridStartPoint[ i ] = gridOrigin[ i ];
+        for( unsigned int j = 0; j < Dimension; ++j )
+        {
+          gridStartPoint[ i ] += gridDirection[ i ][ j ] * gridSpacing[ j ] * startIndex[ j ];
+        }
+        gridStep[ i ] = gridDirection[ i ][ axis ] * gridSpacing[ axis ]
+          * ( gridSize[ axis ] + 1.0 ) / static_cast< double >( numberOfPoints );
+      }
+
+      /** For composition the line is mapped back through the initial
+       * transform, so that T_0 maps it onto the grid line.
+       */
+      InputPointType  startPoint = gridStartPoint;
+      InputVectorType step       = gridStep;
+      if( useComposition )
+      {
+        for( unsigned int i = 0; i < Dimension; ++i )
+        {
+          startPoint[ i ] = 0.0;
+          step[ i ]       = 0.0;
+          for( unsigned int j = 0; j < Dimension; ++j )
+          {
+            startPoint[ i ] += inverseMatrix[ i ][ j ] * ( gridStartPoint[ j ] - offset[ j ] );
+            step[ i ]       += inverseMatrix[ i ][ j ] * gridStep[ j ];
+          }
+        }
+      }
+
+      std::ostringstream description;
+      description << combination << ", line along grid axis " << axis;
+      result |= CompareLine( transform, startPoint, step, numberOfPoints, description.str() );
+    }
+
+    /** An oblique line. */
+    InputPointType startPoint;
+    startPoint[ 0 ] = -12.0; startPoint[ 1 ] = -9.0;
+    InputVectorType step;
+    step[ 0 ] = 1.3; step[ 1 ] = 0.7;
+    result |= CompareLine( transform, startPoint, step, numberOfPoints,
+      combination + ", oblique line" );
+  }
+
+  /** Return a value. */
+  return result;
+
+} // end main
@@ -0,0 +1,243 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "AdvancedMeanSquares/itkAdvancedMeanSquaresImageToImageMetric.h"
+
+#include "itkAdvancedCombinationTransform.h"
+#include "itkAdvancedTranslationTransform.h"
+#include "itkBSplineInterpolateImageFunction.h"
+#include "itkImage.h"
+#include "itkImageFullSampler.h"
+#include "itkImageRandomSampler.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+//-------------------------------------------------------------------------------------
+// This test checks that the AdvancedMeanSquares metric gives the same value
+// and derivative when it reads the samples from the structure-of-arrays copy
+// (UseImageSampleArrays) as when it reads them from the sample container.
+// With the full sampler the samples are reused, so they are copied from the
+// second evaluation on. With a random sampler that selects new samples for
+// every evaluation, the samples should never be copied.
+
+const unsigned int Dimension = 2;
+typedef float                                                              PixelType;
+typedef itk::Image< PixelType, Dimension >                                 ImageType;
+typedef itk::AdvancedMeanSquaresImageToImageMetric< ImageType, ImageType > MetricType;
+typedef itk::AdvancedTranslationTransform< double, Dimension >             TranslationTransformType;
+typedef itk::AdvancedCombinationTransform< double, Dimension >             CombinationTransformType;
+typedef itk::BSplineInterpolateImageFunction< ImageType, double, double >  InterpolatorType;
+typedef itk::ImageSamplerBase< ImageType >                                 SamplerType;
+typedef itk::ImageFullSampler< ImageType >                                 FullSamplerType;
+typedef itk::ImageRandomSampler< ImageType >                               RandomSamplerType;
+
+/**
+ * Create an image of two blobs, translated by the given vector.
+ */
+
+ImageType::Pointer
+CreateImage( const double * translation )
+{
+  ImageType::SizeType size;
+  size.Fill( 64 );
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    ImageType::PointType point;
+    image->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    const double x  = point[ 0 ] - translation[ 0 ];
+    const double y  = point[ 1 ] - translation[ 1 ];
+    const double r1 = ( x - 28.0 ) * ( x - 28.0 ) + ( y - 30.0 ) * ( y - 30.0 );
+    const double r2 = ( x - 38.0 ) * ( x - 38.0 ) / 2.0 + ( y - 36.0 ) * ( y - 36.0 );
+    it.Set( static_cast< PixelType >( 100.0 * std::exp( -r1 / 60.0 )
+      + 60.0 * std::exp( -r2 / 30.0 ) + 0.1 * x ) );
+  }
+
+  return image;
+
+} // end CreateImage()
+
+
+/**
+ * Create a multi-threaded mean squares metric.
+ */
+
+MetricType::Pointer
+CreateMetric( ImageType * fixedImage, ImageType * movingImage,
+  SamplerType * sampler, const bool useImageSampleArrays )
+{
+  TranslationTransformType::Pointer translation = TranslationTransformType::New();
+  CombinationTransformType::Pointer transform   = CombinationTransformType::New();
+  transform->SetCurrentTransform( translation );
+
+  InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  interpolator->SetSplineOrder( 3 );
+
+  MetricType::Pointer metric = MetricType::New();
+  metric->SetFixedImage( fixedImage );
+  metric->SetMovingImage( movingImage );
+  metric->SetFixedImageRegion( fixedImage->GetBufferedRegion() );
+  metric->SetTransform( transform );
+  metric->SetInterpolator( interpolator );
+  metric->SetImageSampler( sampler );
+  metric->SetUseImageSampleArrays( useImageSampleArrays );
+  metric->SetUseMultiThread( true );
+  metric->SetNumberOfThreads( 3 );
+  metric->Initialize();
+
+  return metric;
+
+} // end CreateMetric()
+
+
+/**
+ * Compare the values and derivatives of the two metrics for a number of
+ * evaluations. If the sampler is given, it selects new samples before
+ * each evaluation.
+ */
+
+int
+CompareMetrics( const MetricType * containerMetric, const MetricType * arraysMetric,
+  SamplerType * newSamplesSampler )
+{
+  const double tolerance = 1e-12;
+
+  MetricType::ParametersType parameters( Dimension );
+  for( unsigned int k = 0; k < 4; ++k )
+  {
+    parameters[ 0 ] = 1.5 - 0.3 * k;
+    parameters[ 1 ] = -0.7 + 0.2 * k;
+
+    if( newSamplesSampler != 0 )
+    {
+      newSamplesSampler->SelectNewSamplesOnUpdate();
+    }
+
+    MetricType::MeasureType    containerValue = 0.0;
+    MetricType::MeasureType    arraysValue    = 0.0;
+    MetricType::DerivativeType containerDerivative;
+    MetricType::DerivativeType arraysDerivative;
+    containerMetric->GetValueAndDerivative( parameters, containerValue, containerDerivative );
+    arraysMetric->GetValueAndDerivative( parameters, arraysValue, arraysDerivative );
+
+    /** The value of GetValue() is computed by another loop. It would reuse
+     * the samples, so only call it when they are reused anyway.
+     */
+    MetricType::MeasureType arraysOnlyValue = arraysValue;
+    if( newSamplesSampler == 0 )
+    {
+      arraysOnlyValue = arraysMetric->GetValue( parameters );
+    }
+
+    double derivativeDifference = 0.0;
+    double derivativeMaximum    = 0.0;
+    for( unsigned int i = 0; i < Dimension; ++i )
+    {
+      derivativeMaximum    = std::max( derivativeMaximum, std::abs( containerDerivative[ i ] ) );
+      derivativeDifference = std::max( derivativeDifference,
+        std::abs( containerDerivative[ i ] - arraysDerivative[ i ] ) );
+    }
+
+    std::cout << "evaluation " << k << ": value " << containerValue
+              << " (container), " << arraysValue << " (arrays)" << std::endl;
+
+    if( containerValue == 0.0 || derivativeMaximum == 0.0 )
+    {
+      std::cerr << "ERROR: the value or derivative is zero, so the test is meaningless." << std::endl;
+      return 1;
+    }
+    if( std::abs( containerValue - arraysValue ) > tolerance * std::abs( containerValue )
+      || std::abs( containerValue - arraysOnlyValue ) > tolerance * std::abs( containerValue ) )
+    {
+      std::cerr << "ERROR: the value differs when the sample arrays are used." << std::endl;
+      return 1;
+    }
+    if( derivativeDifference > tolerance * derivativeMaximum )
+    {
+      std::cerr << "ERROR: the derivative differs when the sample arrays are used by "
+                << derivativeDifference << "." << std::endl;
+      return 1;
+    }
+  }
+
+  return 0;
+
+} // end CompareMetrics()
+
+
+int
+main( int argc, char * argv[] )
+{
+  const double translation[ Dimension ] = { 2.0, -1.0 };
+  const double zero[ Dimension ]        = { 0.0, 0.0 };
+
+  ImageType::Pointer fixedImage  = CreateImage( zero );
+  ImageType::Pointer movingImage = CreateImage( translation );
+
+  int result = 0;
+  try
+  {
+    /** The full sampler: the samples are reused, and thus copied. */
+    FullSamplerType::Pointer fullSampler1 = FullSamplerType::New();
+    FullSamplerType::Pointer fullSampler2 = FullSamplerType::New();
+    MetricType::Pointer      containerMetric
+      = CreateMetric( fixedImage, movingImage, fullSampler1, false );
+    MetricType::Pointer arraysMetric
+      = CreateMetric( fixedImage, movingImage, fullSampler2, true );
+
+    result |= CompareMetrics( containerMetric, arraysMetric, 0 );
+    if( arraysMetric->GetImageSampleArrays()->GetNumberOfSamples()
+      != fullSampler2->GetOutput()->Size() )
+    {
+      std::cerr << "ERROR: the reused samples of the full sampler were not copied." << std::endl;
+      result = 1;
+    }
+
+    /** A random sampler, shared by both metrics, with new samples for
+     * every evaluation: the samples are never copied.
+     */
+    RandomSamplerType::Pointer randomSampler = RandomSamplerType::New();
+    randomSampler->SetNumberOfSamples( 1000 );
+    containerMetric = CreateMetric( fixedImage, movingImage, randomSampler, false );
+    arraysMetric    = CreateMetric( fixedImage, movingImage, randomSampler, true );
+
+    result |= CompareMetrics( containerMetric, arraysMetric, randomSampler );
+    if( arraysMetric->GetImageSampleArrays()->GetNumberOfSamples() != 0 )
+    {
+      std::cerr << "ERROR: the samples of the random sampler were copied, "
+                << "although they change for every evaluation." << std::endl;
+      result = 1;
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: " << excp << std::endl;
+    return 1;
+  }
+
+  /** Return a value. */
+  return result;
+
+} // end main
@@ -249,6 +249,78 @@ main( int argc, char * argv[] )
     return EXIT_FAILURE;
   }
 
+  /**
+   * *********** Vectorized kernel TESTING ********************************
+   */
+
+  std::cerr << "\n--------------------------------------------------------";
+  std::cerr << "\nVectorized kernel TESTING:\n" << std::endl;
+
+  /** Compare the vectorized kernels with the default implementation,
+   * at several positions within the unit cell.
+   */
+  std::cerr << "The selected instruction set is: "
+            << itk::BSplineVectorizedKernels::GetInstructionSetName(
+    itk::BSplineVectorizedKernels::GetInstructionSet() ) << std::endl;
+  WeightFunction2Type3D::Pointer weight2VFunction3D = WeightFunction2Type3D::New();
+  weight2VFunction3D->SetUseVectorizedKernels( true );
+  const double tolerance = itk::BSplineVectorizedKernels::GetTolerance();
+  double       maxRelativeError = 0.0;
+  for( unsigned int k = 0; k < 100; ++k )
+  {
+    cindex3D[ 0 ] = 0.01 * k;
+    cindex3D[ 1 ] = 0.37 + 0.013 * k;
+    cindex3D[ 2 ] = 5.0 - 0.029 * k;
+    WeightsType3D weightsScalar     = weight2Function3D->Evaluate( cindex3D );
+    WeightsType3D weightsVectorized = weight2VFunction3D->Evaluate( cindex3D );
+    for( unsigned int i = 0; i < weightsScalar.Size(); ++i )
+    {
+      const double diff = vnl_math_abs( weightsScalar[ i ] - weightsVectorized[ i ] );
+      const double relativeError = diff / vnl_math_max( vnl_math_abs( weightsScalar[ i ] ), 1e-300 );
+      maxRelativeError = vnl_math_max( maxRelativeError, relativeError );
+    }
+  }
+  std::cerr << std::scientific;
+  std::cerr << std::setprecision( 4 );
+  std::cerr << "The maximum relative error is: " << maxRelativeError << std::endl;
+  if( maxRelativeError > tolerance )
+  {
+    std::cerr << "ERROR: the vectorized kernels differ from the default "
+              << "implementation with more than " << tolerance << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** Compare the vectorized product of the weights with a gradient. */
+  const unsigned long numberOfWeights = WeightFunction2Type3D::NumberOfWeights;
+  WeightsType3D weightsGradient = weight2Function3D->Evaluate( cindex3D );
+  double        gradient[ 3 ] = { 0.3, -1.7, 12.5 };
+  double        productScalar[ 3 * numberOfWeights ];
+  double        productVectorized[ 3 * numberOfWeights ];
+  itk::BSplineVectorizedKernels::MultiplyWeightsWithGradientScalar(
+    weightsGradient.data_block(), numberOfWeights, gradient, 3, productScalar );
+  itk::BSplineVectorizedKernels::MultiplyWeightsWithGradient(
+    weightsGradient.data_block(), numberOfWeights, gradient, 3, productVectorized );
+  for( unsigned int i = 0; i < 3 * numberOfWeights; ++i )
+  {
+    if( vnl_math_abs( productScalar[ i ] - productVectorized[ i ] )
+      > tolerance * vnl_math_abs( productScalar[ i ] ) )
+    {
+      std::cerr << "ERROR: the vectorized gradient product differs from "
+                << "the default implementation." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  /** Time the vectorized implementation. */
+  startClock = clock();
+  for( unsigned int i = 0; i < N; ++i )
+  {
+    weight2VFunction3D->Evaluate( cindex3D );
+  }
+  endClock = clock();
+  std::cerr << "The elapsed time for the vectorized implementation is: "
+            << endClock - startClock << std::endl;
+
   /**
    * *********** Function TESTING ****************************************
    */
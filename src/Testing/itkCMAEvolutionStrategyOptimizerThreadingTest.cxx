@@ -0,0 +1,333 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "CMAEvolutionStrategy/itkCMAEvolutionStrategyOptimizer.h"
+
+#include "itkNumericTraits.h"
+#include "itkSingleValuedCostFunction.h"
+
+#include <iostream>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+// This test checks that the multi-threaded CMA-ES optimizer, which evaluates
+// the members of the population concurrently and updates the covariance
+// matrix with several threads, gives the same result as the single-threaded
+// optimizer. Each element of the covariance matrix is computed by one thread
+// in the same order as without threads, and the random numbers are drawn
+// before the evaluation, so the results should be identical. It also checks
+// that without concurrent evaluation the random numbers are drawn in the
+// serial order when the cost function fails: a failed member immediately
+// gets the next search direction.
+
+namespace itk
+{
+
+/**
+ * A quadratic cost function with coupled parameters, which can be evaluated
+ * for different parameters at the same time.
+ */
+
+class CMAThreadingTestCostFunction : public SingleValuedCostFunction
+{
+public:
+
+  typedef CMAThreadingTestCostFunction Self;
+  typedef SingleValuedCostFunction     Superclass;
+  typedef SmartPointer< Self >         Pointer;
+  typedef SmartPointer< const Self >   ConstPointer;
+
+  itkNewMacro( Self );
+  itkTypeMacro( CMAThreadingTestCostFunction, SingleValuedCostFunction );
+
+  typedef Superclass::MeasureType    MeasureType;
+  typedef Superclass::ParametersType ParametersType;
+  typedef Superclass::DerivativeType DerivativeType;
+
+  void SetNumberOfParameters( const unsigned int numberOfParameters )
+  {
+    this->m_NumberOfParameters = numberOfParameters;
+  }
+
+
+  virtual unsigned int GetNumberOfParameters( void ) const
+  {
+    return this->m_NumberOfParameters;
+  }
+
+
+  /** The cost function fails if the first parameter exceeds this value. */
+  void SetMaximumFirstParameter( const double maximum )
+  {
+    this->m_MaximumFirstParameter = maximum;
+  }
+
+
+  virtual MeasureType GetValue( const ParametersType & parameters ) const
+  {
+    if( parameters[ 0 ] > this->m_MaximumFirstParameter )
+    {
+      itkExceptionMacro( << "The first parameter is too large." );
+    }
+
+    MeasureType value = 0.0;
+    for( unsigned int i = 0; i < this->m_NumberOfParameters; ++i )
+    {
+      const double target = 0.1 * ( i % 7 ) - 0.3;
+      const double x      = parameters[ i ] - target;
+      const double xnext  = i + 1 < this->m_NumberOfParameters
+        ? parameters[ i + 1 ] - 0.1 * ( ( i + 1 ) % 7 ) + 0.3 : 0.0;
+      value += ( 1.0 + ( i % 5 ) ) * x * x + 0.5 * x * xnext;
+    }
+    return value;
+  }
+
+
+  virtual void GetDerivative( const ParametersType &, DerivativeType & ) const
+  {
+    itkExceptionMacro( << "The derivative is not implemented." );
+  }
+
+
+protected:
+
+  CMAThreadingTestCostFunction() :
+    m_NumberOfParameters( 0 ),
+    m_MaximumFirstParameter( NumericTraits< double >::max() )
+  {}
+
+  virtual ~CMAThreadingTestCostFunction() {}
+
+private:
+
+  CMAThreadingTestCostFunction( const Self & ); // purposely not implemented
+  void operator=( const Self & );               // purposely not implemented
+
+  unsigned int m_NumberOfParameters;
+  double       m_MaximumFirstParameter;
+
+};
+
+/**
+ * The CMA-ES optimizer, which stops after the first generation, with access
+ * to the normalized search directions of that generation.
+ */
+
+class CMAThreadingTestOptimizer : public CMAEvolutionStrategyOptimizer
+{
+public:
+
+  typedef CMAThreadingTestOptimizer     Self;
+  typedef CMAEvolutionStrategyOptimizer Superclass;
+  typedef SmartPointer< Self >          Pointer;
+  typedef SmartPointer< const Self >    ConstPointer;
+
+  itkNewMacro( Self );
+  itkTypeMacro( CMAThreadingTestOptimizer, CMAEvolutionStrategyOptimizer );
+
+  const ParametersType & GetNormalizedSearchDir( const unsigned int lam ) const
+  {
+    return this->m_NormalizedSearchDirs[ lam ];
+  }
+
+
+protected:
+
+  CMAThreadingTestOptimizer() {}
+  virtual ~CMAThreadingTestOptimizer() {}
+
+  virtual void GenerateOffspring( void )
+  {
+    this->Superclass::GenerateOffspring();
+    this->StopOptimization();
+  }
+
+
+private:
+
+  CMAThreadingTestOptimizer( const Self & ); // purposely not implemented
+  void operator=( const Self & );            // purposely not implemented
+
+};
+
+} // end namespace itk
+
+/**
+ * Run the optimizer from a fixed seed.
+ */
+
+itk::CMAEvolutionStrategyOptimizer::Pointer
+RunOptimizer( itk::CMAThreadingTestCostFunction * costFunction,
+  const bool useThreads )
+{
+  typedef itk::CMAEvolutionStrategyOptimizer OptimizerType;
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+
+  /** The optimizer draws from the global random generator. */
+  RandomGeneratorType::GetInstance()->SetSeed( 1234 );
+
+  OptimizerType::ParametersType initialPosition( costFunction->GetNumberOfParameters() );
+  initialPosition.Fill( 0.0 );
+
+  OptimizerType::Pointer optimizer = OptimizerType::New();
+  optimizer->SetCostFunction( costFunction );
+  optimizer->SetInitialPosition( initialPosition );
+  optimizer->SetMaximumNumberOfIterations( 20 );
+  optimizer->SetInitialSigma( 0.5 );
+  optimizer->SetUseCovarianceMatrixAdaptation( true );
+  optimizer->SetUpdateBDPeriod( 5 );
+  optimizer->SetUseMultiThread( useThreads );
+  optimizer->SetEvaluatePopulationConcurrently( useThreads );
+  optimizer->SetNumberOfThreads( useThreads ? 4 : 1 );
+  optimizer->StartOptimization();
+
+  return optimizer;
+
+} // end RunOptimizer()
+
+
+int
+main( int argc, char * argv[] )
+{
+  typedef itk::CMAEvolutionStrategyOptimizer OptimizerType;
+
+  /** The covariance update is threaded from 12 parameters on. */
+  const unsigned int numberOfParameters = 30;
+
+  itk::CMAThreadingTestCostFunction::Pointer costFunction
+    = itk::CMAThreadingTestCostFunction::New();
+  costFunction->SetNumberOfParameters( numberOfParameters );
+
+  OptimizerType::Pointer serialOptimizer;
+  OptimizerType::Pointer threadedOptimizer;
+  try
+  {
+    serialOptimizer   = RunOptimizer( costFunction, false );
+    threadedOptimizer = RunOptimizer( costFunction, true );
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: " << excp << std::endl;
+    return 1;
+  }
+
+  std::cout << "Serial:   " << serialOptimizer->GetCurrentIteration()
+            << " iterations, value " << serialOptimizer->GetCurrentValue()
+            << ", sigma " << serialOptimizer->GetCurrentSigma() << std::endl;
+  std::cout << "Threaded: " << threadedOptimizer->GetCurrentIteration()
+            << " iterations, value " << threadedOptimizer->GetCurrentValue()
+            << ", sigma " << threadedOptimizer->GetCurrentSigma() << std::endl;
+
+  /** The runs should be identical. */
+  if( serialOptimizer->GetCurrentIteration() != threadedOptimizer->GetCurrentIteration()
+    || serialOptimizer->GetCurrentValue() != threadedOptimizer->GetCurrentValue()
+    || serialOptimizer->GetCurrentSigma() != threadedOptimizer->GetCurrentSigma()
+    || serialOptimizer->GetCurrentMaximumD() != threadedOptimizer->GetCurrentMaximumD()
+    || serialOptimizer->GetCurrentMinimumD() != threadedOptimizer->GetCurrentMinimumD() )
+  {
+    std::cerr << "ERROR: the threaded optimizer differs from the serial optimizer." << std::endl;
+    return 1;
+  }
+
+  const OptimizerType::ParametersType & serialPosition   = serialOptimizer->GetCurrentPosition();
+  const OptimizerType::ParametersType & threadedPosition = threadedOptimizer->GetCurrentPosition();
+  for( unsigned int i = 0; i < numberOfParameters; ++i )
+  {
+    if( serialPosition[ i ] != threadedPosition[ i ] )
+    {
+      std::cerr << "ERROR: parameter " << i << " of the threaded optimizer ("
+                << threadedPosition[ i ] << ") differs from the serial optimizer ("
+                << serialPosition[ i ] << ")." << std::endl;
+      return 1;
+    }
+  }
+
+  /** A cost function that fails for about a third of the first search
+   * directions. Without concurrent evaluation, member lam should get the
+   * lam-th search direction for which the cost function does not fail.
+   */
+  const double initialSigma          = 0.5;
+  const double maximumFirstParameter = 0.25;
+  costFunction->SetMaximumFirstParameter( maximumFirstParameter );
+
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+  itk::CMAThreadingTestOptimizer::Pointer optimizer = itk::CMAThreadingTestOptimizer::New();
+  try
+  {
+    RandomGeneratorType::GetInstance()->SetSeed( 1234 );
+
+    OptimizerType::ParametersType initialPosition( numberOfParameters );
+    initialPosition.Fill( 0.0 );
+    optimizer->SetCostFunction( costFunction );
+    optimizer->SetInitialPosition( initialPosition );
+    optimizer->SetInitialSigma( initialSigma );
+    optimizer->SetUseCovarianceMatrixAdaptation( true );
+    optimizer->SetEvaluatePopulationConcurrently( false );
+    optimizer->StartOptimization();
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: " << excp << std::endl;
+    return 1;
+  }
+
+  /** Draw the same random numbers, in the serial order. In the first
+   * generation the search direction is initialSigma times the normalized
+   * search direction.
+   */
+  RandomGeneratorType::Pointer referenceGenerator = RandomGeneratorType::New();
+  referenceGenerator->SetSeed( 1234 );
+  std::vector< double > normalizedSearchDir( numberOfParameters );
+  unsigned int          nrOfFails = 0;
+  for( unsigned int lam = 0; lam < optimizer->GetPopulationSize(); ++lam )
+  {
+    bool failed = true;
+    while( failed )
+    {
+      for( unsigned int i = 0; i < numberOfParameters; ++i )
+      {
+        normalizedSearchDir[ i ] = referenceGenerator->GetNormalVariate();
+      }
+      failed = initialSigma * normalizedSearchDir[ 0 ] > maximumFirstParameter;
+      if( failed )
+      {
+        ++nrOfFails;
+      }
+    }
+
+    for( unsigned int i = 0; i < numberOfParameters; ++i )
+    {
+      if( optimizer->GetNormalizedSearchDir( lam )[ i ] != normalizedSearchDir[ i ] )
+      {
+        std::cerr << "ERROR: population member " << lam
+                  << " did not get the search direction of the serial order." << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  std::cout << "Failed cost function evaluations: " << nrOfFails << std::endl;
+  if( nrOfFails == 0 )
+  {
+    std::cerr << "ERROR: the cost function did not fail, so the test is meaningless." << std::endl;
+    return 1;
+  }
+
+  /** Return a value. */
+  return 0;
+
+} // end main
@@ -0,0 +1,330 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "AdaptiveStochasticGradientDescent/itkComputeDisplacementDistribution.h"
+#include "AdaptiveStochasticGradientDescent/itkComputeJacobianTerms.h"
+#include "AdvancedMeanSquares/itkAdvancedMeanSquaresImageToImageMetric.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkAdvancedCombinationTransform.h"
+#include "itkAdvancedTransform.h"
+#include "itkBSplineInterpolateImageFunction.h"
+#include "itkImage.h"
+#include "itkImageFullSampler.h"
+#include "itkImageGridSampler.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include "vnl/vnl_matrix.h"
+#include "vnl/vnl_trace.h"
+
+#include <cmath>
+#include <iostream>
+#include <string>
+
+//-------------------------------------------------------------------------------------
+// This test checks that the multi-threaded computation of the Jacobian terms
+// and of the displacement distribution of the ASGD optimizer give the same
+// results as the single-threaded computation. The covariance matrix is
+// computed by the threads in blocks of samples, each thread for its own rows,
+// and runs of samples with the same nonzero Jacobian indices continue over
+// the blocks. The trace and Frobenius norm of the covariance matrix are also
+// compared with a computation of the dense matrix.
+
+const unsigned int Dimension = 2;
+typedef float                                                                 PixelType;
+typedef itk::Image< PixelType, Dimension >                                    ImageType;
+typedef itk::AdvancedTransform< double, Dimension, Dimension >                TransformType;
+typedef itk::AdvancedBSplineDeformableTransform< double, Dimension, 3 >       BSplineTransformType;
+typedef itk::AdvancedCombinationTransform< double, Dimension >                CombinationTransformType;
+typedef itk::ComputeJacobianTerms< ImageType, TransformType >                 JacobianTermsType;
+typedef itk::ComputeDisplacementDistribution< ImageType, TransformType >      DisplacementDistributionType;
+typedef itk::AdvancedMeanSquaresImageToImageMetric< ImageType, ImageType >    MetricType;
+typedef itk::BSplineInterpolateImageFunction< ImageType, double, double >     InterpolatorType;
+typedef itk::ImageFullSampler< ImageType >                                    FullSamplerType;
+typedef itk::ImageGridSampler< ImageType >                                    GridSamplerType;
+typedef TransformType::ParametersType                                         ParametersType;
+typedef TransformType::JacobianType                                           JacobianType;
+typedef TransformType::NonZeroJacobianIndicesType                             NonZeroJacobianIndicesType;
+
+/**
+ * The results of one computation.
+ */
+
+struct ResultsType
+{
+  double m_TrC;
+  double m_TrCC;
+  double m_MaxJJ;
+  double m_MaxJCJ;
+  double m_Jacg;
+  double m_DisplacementMaxJJ;
+};
+
+/**
+ * Create an image of a blob, translated by the given vector.
+ */
+
+ImageType::Pointer
+CreateImage( const double * translation )
+{
+  ImageType::SizeType size;
+  size.Fill( 64 );
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    ImageType::PointType point;
+    image->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    const double x = point[ 0 ] - 30.0 - translation[ 0 ];
+    const double y = point[ 1 ] - 32.0 - translation[ 1 ];
+    it.Set( static_cast< PixelType >( 100.0 * std::exp( -( x * x + 2.0 * y * y ) / 150.0 ) ) );
+  }
+
+  return image;
+
+} // end CreateImage()
+
+
+/**
+ * Compute the Jacobian terms and the displacement distribution.
+ */
+
+ResultsType
+ComputeTerms( ImageType * fixedImage, CombinationTransformType * transform,
+  MetricType * metric, const ParametersType & parameters,
+  const bool useMultiThread, const unsigned int numberOfThreads,
+  const bool useScales, const std::string & method )
+{
+  const unsigned int P = transform->GetNumberOfParameters();
+
+  /** Scales that differ per parameter. */
+  JacobianTermsType::ScalesType scales( P );
+  for( unsigned int p = 0; p < P; ++p )
+  {
+    scales[ p ] = 1.0 + 0.5 * std::sin( 0.3 * p );
+  }
+
+  ResultsType results;
+
+  JacobianTermsType::Pointer jacobianTerms = JacobianTermsType::New();
+  jacobianTerms->SetFixedImage( fixedImage );
+  jacobianTerms->SetFixedImageRegion( fixedImage->GetBufferedRegion() );
+  jacobianTerms->SetTransform( transform );
+  jacobianTerms->SetMaxBandCovSize( 40 );
+  jacobianTerms->SetNumberOfBandStructureSamples( 10 );
+  jacobianTerms->SetNumberOfJacobianMeasurements( 1000 );
+  jacobianTerms->SetScales( scales );
+  jacobianTerms->SetUseScales( useScales );
+  jacobianTerms->SetUseMultiThread( useMultiThread );
+  jacobianTerms->SetNumberOfThreads( numberOfThreads );
+  jacobianTerms->ComputeParameters( results.m_TrC, results.m_TrCC,
+    results.m_MaxJJ, results.m_MaxJCJ );
+
+  DisplacementDistributionType::Pointer distribution = DisplacementDistributionType::New();
+  distribution->SetFixedImage( fixedImage );
+  distribution->SetFixedImageRegion( fixedImage->GetBufferedRegion() );
+  distribution->SetTransform( transform );
+  distribution->SetCostFunction( metric );
+  distribution->SetNumberOfJacobianMeasurements( 1000 );
+  distribution->SetUseScales( false );
+  distribution->SetUseMultiThread( useMultiThread );
+  distribution->SetNumberOfThreads( numberOfThreads );
+  distribution->ComputeDistributionTerms( parameters,
+    results.m_Jacg, results.m_DisplacementMaxJJ, method );
+
+  return results;
+
+} // end ComputeTerms()
+
+
+/**
+ * Compute the trace and the squared Frobenius norm of the dense
+ * covariance matrix C = 1/n \sum_i J_i^T J_i, of the same samples.
+ */
+
+void
+ComputeDenseTerms( ImageType * fixedImage, CombinationTransformType * transform,
+  double & TrC, double & TrCC )
+{
+  GridSamplerType::Pointer sampler = GridSamplerType::New();
+  sampler->SetInput( fixedImage );
+  sampler->SetInputImageRegion( fixedImage->GetBufferedRegion() );
+  sampler->SetNumberOfSamples( 1000 );
+  sampler->Update();
+  const GridSamplerType::ImageSampleContainerType * samples = sampler->GetOutput();
+  const double                                      n       = samples->Size();
+
+  const unsigned int         P          = transform->GetNumberOfParameters();
+  const unsigned int         sizejacind = transform->GetNumberOfNonZeroJacobianIndices();
+  vnl_matrix< double >       cov( P, P, 0.0 );
+  JacobianType               jacj( Dimension, sizejacind );
+  NonZeroJacobianIndicesType jacind( sizejacind );
+  for( unsigned long i = 0; i < samples->Size(); ++i )
+  {
+    transform->GetJacobian( samples->GetElement( i ).m_ImageCoordinates, jacj, jacind );
+    if( sizejacind > 1 && jacind[ 0 ] == jacind[ 1 ] ) { continue; }
+    for( unsigned int pi = 0; pi < sizejacind; ++pi )
+    {
+      for( unsigned int qi = 0; qi < sizejacind; ++qi )
+      {
+        double accum = 0.0;
+        for( unsigned int d = 0; d < Dimension; ++d )
+        {
+          accum += jacj[ d ][ pi ] * jacj[ d ][ qi ];
+        }
+        cov( jacind[ pi ], jacind[ qi ] ) += accum / n;
+      }
+    }
+  }
+
+  TrC  = vnl_trace( cov );
+  TrCC = cov.frobenius_norm() * cov.frobenius_norm();
+
+} // end ComputeDenseTerms()
+
+
+/**
+ * Compare two values, relative to the first.
+ */
+
+int
+Compare( const double expected, const double actual, const double tolerance,
+  const std::string & description )
+{
+  if( std::abs( expected - actual ) > tolerance * std::abs( expected ) )
+  {
+    std::cerr << "ERROR: " << description << " is " << actual
+              << " instead of " << expected << "." << std::endl;
+    return 1;
+  }
+
+  return 0;
+
+} // end Compare()
+
+
+int
+main( int argc, char * argv[] )
+{
+  const double tolerance                = 1e-12;
+  const double translation[ Dimension ] = { 2.0, -1.5 };
+  const double zero[ Dimension ]        = { 0.0, 0.0 };
+
+  int result = 0;
+  try
+  {
+    ImageType::Pointer fixedImage  = CreateImage( zero );
+    ImageType::Pointer movingImage = CreateImage( translation );
+
+    /** A B-spline transform that covers the image, with a small deformation. */
+    BSplineTransformType::Pointer bsplineTransform = BSplineTransformType::New();
+    BSplineTransformType::SizeType gridSize;
+    gridSize.Fill( 10 );
+    BSplineTransformType::RegionType gridRegion;
+    gridRegion.SetSize( gridSize );
+    BSplineTransformType::SpacingType gridSpacing;
+    gridSpacing.Fill( 10.0 );
+    BSplineTransformType::OriginType gridOrigin;
+    gridOrigin.Fill( -15.0 );
+    BSplineTransformType::DirectionType gridDirection;
+    gridDirection.SetIdentity();
+    bsplineTransform->SetGridOrigin( gridOrigin );
+    bsplineTransform->SetGridSpacing( gridSpacing );
+    bsplineTransform->SetGridRegion( gridRegion );
+    bsplineTransform->SetGridDirection( gridDirection );
+
+    CombinationTransformType::Pointer transform = CombinationTransformType::New();
+    transform->SetCurrentTransform( bsplineTransform );
+
+    ParametersType parameters( transform->GetNumberOfParameters() );
+    for( unsigned int i = 0; i < parameters.GetSize(); ++i )
+    {
+      parameters[ i ] = 0.5 * std::sin( 0.37 * i ) + 0.2 * std::cos( 1.3 * i );
+    }
+    transform->SetParameters( parameters );
+
+    /** The metric of which the gradient is used by the displacement distribution. */
+    InterpolatorType::Pointer interpolator = InterpolatorType::New();
+    interpolator->SetSplineOrder( 3 );
+    MetricType::Pointer metric = MetricType::New();
+    metric->SetFixedImage( fixedImage );
+    metric->SetMovingImage( movingImage );
+    metric->SetFixedImageRegion( fixedImage->GetBufferedRegion() );
+    metric->SetTransform( transform );
+    metric->SetInterpolator( interpolator );
+    metric->SetImageSampler( FullSamplerType::New() );
+    metric->Initialize();
+
+    /** The dense reference of the covariance terms. */
+    double denseTrC  = 0.0;
+    double denseTrCC = 0.0;
+    ComputeDenseTerms( fixedImage, transform, denseTrC, denseTrCC );
+
+    const std::string methods[ 2 ] = { "2sigma", "95percentile" };
+    for( unsigned int useScales = 0; useScales < 2; ++useScales )
+    {
+      const ResultsType serial = ComputeTerms( fixedImage, transform, metric,
+        parameters, false, 1, useScales == 1, methods[ useScales ] );
+
+      std::cout << "serial" << ( useScales ? ", with scales" : "" )
+                << ": TrC " << serial.m_TrC << ", TrCC " << serial.m_TrCC
+                << ", maxJJ " << serial.m_MaxJJ << ", maxJCJ " << serial.m_MaxJCJ
+                << ", jacg " << serial.m_Jacg << std::endl;
+
+      if( serial.m_TrC == 0.0 || serial.m_Jacg == 0.0 )
+      {
+        std::cerr << "ERROR: the terms are zero, so the test is meaningless." << std::endl;
+        result = 1;
+      }
+      if( !useScales )
+      {
+        result |= Compare( denseTrC, serial.m_TrC, 1e-10, "TrC" );
+        result |= Compare( denseTrCC, serial.m_TrCC, 1e-10, "TrCC" );
+      }
+
+      /** Several numbers of threads, so that the blocks and the ranges of rows differ. */
+      const unsigned int numberOfThreads[ 3 ] = { 2, 3, 8 };
+      for( unsigned int t = 0; t < 3; ++t )
+      {
+        const ResultsType threaded = ComputeTerms( fixedImage, transform, metric,
+          parameters, true, numberOfThreads[ t ], useScales == 1, methods[ useScales ] );
+
+        result |= Compare( serial.m_TrC, threaded.m_TrC, tolerance, "the threaded TrC" );
+        result |= Compare( serial.m_TrCC, threaded.m_TrCC, tolerance, "the threaded TrCC" );
+        result |= Compare( serial.m_MaxJJ, threaded.m_MaxJJ, tolerance, "the threaded maxJJ" );
+        result |= Compare( serial.m_MaxJCJ, threaded.m_MaxJCJ, tolerance, "the threaded maxJCJ" );
+        result |= Compare( serial.m_Jacg, threaded.m_Jacg, tolerance,
+          "the threaded jacg of the displacement distribution" );
+        result |= Compare( serial.m_DisplacementMaxJJ, threaded.m_DisplacementMaxJJ, tolerance,
+          "the threaded maxJJ of the displacement distribution" );
+      }
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: " << excp << std::endl;
+    return 1;
+  }
+
+  /** Return a value. */
+  return result;
+
+} // end main
@@ -0,0 +1,160 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "AdvancedBSplineTransform/itkCyclicBSplineDeformableTransform.h"
+
+#include <cmath>
+#include <iostream>
+
+//-------------------------------------------------------------------------------------
+// This test checks that the line functions of the cyclic B-spline transform
+// give the same result as the point-wise functions, also for lines that run
+// through the zone where the support region wraps around the last dimension.
+
+int
+main( int argc, char * argv[] )
+{
+  /** Some basic type definitions. */
+  const unsigned int Dimension   = 3;
+  const unsigned int SplineOrder = 3;
+  typedef double CoordinateRepresentationType;
+  const double tolerance = 1e-10;
+
+  typedef itk::CyclicBSplineDeformableTransform<
+    CoordinateRepresentationType, Dimension, SplineOrder >    TransformType;
+  typedef TransformType::Superclass::Superclass::Superclass AdvancedTransformType;
+  typedef TransformType::OutputPointContainerType           OutputPointContainerType;
+  typedef TransformType::SpatialJacobianType                SpatialJacobianType;
+  typedef TransformType::SpatialJacobianContainerType       SpatialJacobianContainerType;
+  typedef TransformType::InputPointType                     InputPointType;
+  typedef TransformType::OutputPointType                    OutputPointType;
+  typedef TransformType::InputVectorType                    InputVectorType;
+  typedef TransformType::ParametersType                     ParametersType;
+  typedef TransformType::RegionType                         RegionType;
+  typedef TransformType::SizeType                           SizeType;
+  typedef TransformType::IndexType                          IndexType;
+  typedef TransformType::SpacingType                        SpacingType;
+  typedef TransformType::OriginType                         OriginType;
+  typedef TransformType::DirectionType                      DirectionType;
+
+  /** Setup a grid of which the last dimension is cyclic. */
+  TransformType::Pointer transform = TransformType::New();
+
+  /** The cyclic transform hides the single-point TransformPoint(). */
+  const AdvancedTransformType * advancedTransform = transform.GetPointer();
+
+  SizeType gridSize;
+  gridSize[ 0 ] = 10; gridSize[ 1 ] = 9; gridSize[ 2 ] = 6;
+  IndexType gridIndex;
+  gridIndex.Fill( 0 );
+  RegionType gridRegion;
+  gridRegion.SetSize( gridSize );
+  gridRegion.SetIndex( gridIndex );
+  SpacingType gridSpacing;
+  gridSpacing[ 0 ] = 4.0; gridSpacing[ 1 ] = 5.0; gridSpacing[ 2 ] = 1.0;
+  OriginType gridOrigin;
+  gridOrigin[ 0 ] = -2.0; gridOrigin[ 1 ] = -3.0; gridOrigin[ 2 ] = 0.0;
+  DirectionType gridDirection;
+  gridDirection.SetIdentity();
+
+  transform->SetGridOrigin( gridOrigin );
+  transform->SetGridSpacing( gridSpacing );
+  transform->SetGridRegion( gridRegion );
+  transform->SetGridDirection( gridDirection );
+
+  /** Fill the coefficients with a smooth, but non-trivial pattern. */
+  ParametersType parameters( transform->GetNumberOfParameters() );
+  for( unsigned int i = 0; i < parameters.GetSize(); ++i )
+  {
+    parameters[ i ] = 2.0 * std::sin( 0.37 * i ) + std::cos( 1.3 * i );
+  }
+  transform->SetParameters( parameters );
+
+  /** Lines along each axis. The line along the last axis runs through all
+   * time points, including the wrap-around zone between the last and the
+   * first grid point.
+   */
+  const unsigned long numberOfPoints = 40;
+  for( unsigned int axis = 0; axis < Dimension; ++axis )
+  {
+    InputPointType startPoint;
+    startPoint[ 0 ] = 11.3; startPoint[ 1 ] = 13.7; startPoint[ 2 ] = 0.1;
+    startPoint[ axis ] = gridOrigin[ axis ];
+
+    InputVectorType step;
+    step.Fill( 0.0 );
+    step[ axis ] = gridSpacing[ axis ] * gridSize[ axis ]
+      / static_cast< double >( numberOfPoints );
+
+    /** The points and the spatial Jacobians along the line. */
+    OutputPointContainerType outputPoints;
+    transform->TransformPointsAlongLine( startPoint, step, numberOfPoints, outputPoints );
+    if( outputPoints.size() != numberOfPoints )
+    {
+      std::cerr << "ERROR: TransformPointsAlongLine() returned "
+                << outputPoints.size() << " instead of " << numberOfPoints
+                << " points." << std::endl;
+      return 1;
+    }
+
+    SpatialJacobianContainerType sjs;
+    transform->GetSpatialJacobianAlongLine( startPoint, step, numberOfPoints, sjs );
+    if( sjs.size() != numberOfPoints )
+    {
+      std::cerr << "ERROR: GetSpatialJacobianAlongLine() returned "
+                << sjs.size() << " instead of " << numberOfPoints
+                << " spatial Jacobians." << std::endl;
+      return 1;
+    }
+
+    for( unsigned long k = 0; k < numberOfPoints; ++k )
+    {
+      InputPointType point;
+      for( unsigned int j = 0; j < Dimension; ++j )
+      {
+        point[ j ] = startPoint[ j ] + static_cast< double >( k ) * step[ j ];
+      }
+
+      const OutputPointType outputPoint = advancedTransform->TransformPoint( point );
+      const double pointDifference = outputPoint.EuclideanDistanceTo( outputPoints[ k ] );
+      if( pointDifference > tolerance )
+      {
+        std::cerr << "ERROR: TransformPointsAlongLine() differs from "
+                  << "TransformPoint() at point " << point
+                  << " of the line along axis " << axis << ": "
+                  << pointDifference << std::endl;
+        return 1;
+      }
+
+      SpatialJacobianType sj;
+      transform->GetSpatialJacobian( point, sj );
+      const double sjDifference = ( sj.GetVnlMatrix() - sjs[ k ].GetVnlMatrix() ).frobenius_norm();
+      if( sjDifference > tolerance )
+      {
+        std::cerr << "ERROR: GetSpatialJacobianAlongLine() differs from "
+                  << "GetSpatialJacobian() at point " << point
+                  << " of the line along axis " << axis << ": "
+                  << sjDifference << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  /** Return a value. */
+  return 0;
+
+} // end main
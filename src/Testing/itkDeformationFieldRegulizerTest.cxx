@@ -0,0 +1,214 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "BSplineDeformableTransformWithDiffusion/itkDeformationFieldRegulizer.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkAdvancedCombinationTransform.h"
+#include "itkAdvancedMatrixOffsetTransformBase.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+//-------------------------------------------------------------------------------------
+// This test checks that the DeformationFieldRegulizer, which is used by the
+// BSplineTransformWithDiffusion, includes its deformation field when the
+// points of a scanline are transformed at once, as the resampler does. The
+// line-wise result should equal the point-wise TransformPoint(), and should
+// differ from the transform without the deformation field.
+
+const unsigned int Dimension = 2;
+typedef itk::AdvancedCombinationTransform< double, Dimension >                 CombinationTransformType;
+typedef itk::DeformationFieldRegulizer< CombinationTransformType >             RegulizerType;
+typedef itk::AdvancedBSplineDeformableTransform< double, Dimension, 3 >        BSplineTransformType;
+typedef itk::AdvancedMatrixOffsetTransformBase< double, Dimension, Dimension > AffineTransformType;
+typedef RegulizerType::VectorImageType                                         VectorImageType;
+typedef RegulizerType::OutputPointContainerType                                OutputPointContainerType;
+typedef RegulizerType::InputPointType                                          InputPointType;
+typedef RegulizerType::OutputPointType                                         OutputPointType;
+typedef RegulizerType::InputVectorType                                         InputVectorType;
+
+/**
+ * Compare the line-wise and the point-wise transformation of a line.
+ */
+
+int
+CompareLine( const RegulizerType * regulizer, const CombinationTransformType * combination,
+  const InputPointType & startPoint, const InputVectorType & step,
+  const unsigned long numberOfPoints, double & maximumFieldContribution )
+{
+  const double tolerance = 1e-10;
+
+  OutputPointContainerType outputPoints;
+  regulizer->TransformPointsAlongLine( startPoint, step, numberOfPoints, outputPoints );
+  if( outputPoints.size() != numberOfPoints )
+  {
+    std::cerr << "ERROR: TransformPointsAlongLine() returned "
+              << outputPoints.size() << " instead of " << numberOfPoints
+              << " points." << std::endl;
+    return 1;
+  }
+
+  for( unsigned long k = 0; k < numberOfPoints; ++k )
+  {
+    InputPointType point;
+    for( unsigned int j = 0; j < Dimension; ++j )
+    {
+      point[ j ] = startPoint[ j ] + static_cast< double >( k ) * step[ j ];
+    }
+
+    const OutputPointType outputPoint = regulizer->TransformPoint( point );
+    const double          difference  = outputPoint.EuclideanDistanceTo( outputPoints[ k ] );
+    if( difference > tolerance )
+    {
+      std::cerr << "ERROR: TransformPointsAlongLine() differs from "
+                << "TransformPoint() at point " << point << ": "
+                << difference << std::endl;
+      return 1;
+    }
+
+    const OutputPointType withoutField = combination->TransformPoint( point );
+    maximumFieldContribution = std::max( maximumFieldContribution,
+      withoutField.EuclideanDistanceTo( outputPoints[ k ] ) );
+  }
+
+  return 0;
+
+} // end CompareLine()
+
+
+int
+main( int argc, char * argv[] )
+{
+  /** A B-spline transform with a non-trivial pattern of coefficients. */
+  BSplineTransformType::Pointer bsplineTransform = BSplineTransformType::New();
+  BSplineTransformType::RegionType::SizeType gridSize;
+  gridSize[ 0 ] = 10; gridSize[ 1 ] = 12;
+  BSplineTransformType::RegionType gridRegion;
+  gridRegion.SetSize( gridSize );
+  BSplineTransformType::SpacingType gridSpacing;
+  gridSpacing[ 0 ] = 8.0; gridSpacing[ 1 ] = 7.0;
+  BSplineTransformType::OriginType gridOrigin;
+  gridOrigin[ 0 ] = -12.0; gridOrigin[ 1 ] = -10.0;
+  BSplineTransformType::DirectionType gridDirection;
+  gridDirection.SetIdentity();
+  bsplineTransform->SetGridOrigin( gridOrigin );
+  bsplineTransform->SetGridSpacing( gridSpacing );
+  bsplineTransform->SetGridRegion( gridRegion );
+  bsplineTransform->SetGridDirection( gridDirection );
+
+  BSplineTransformType::ParametersType parameters( bsplineTransform->GetNumberOfParameters() );
+  for( unsigned int i = 0; i < parameters.GetSize(); ++i )
+  {
+    parameters[ i ] = 1.5 * std::sin( 0.37 * i ) + 0.5 * std::cos( 1.3 * i );
+  }
+  bsplineTransform->SetParameters( parameters );
+
+  /** An affine initial transform, composed with the B-spline transform,
+   * so that the CombinationTransform passes lines on to the B-spline.
+   */
+  AffineTransformType::Pointer affineTransform = AffineTransformType::New();
+  AffineTransformType::MatrixType matrix;
+  matrix[ 0 ][ 0 ] = 1.02; matrix[ 0 ][ 1 ] = 0.05;
+  matrix[ 1 ][ 0 ] = -0.03; matrix[ 1 ][ 1 ] = 0.97;
+  AffineTransformType::OutputVectorType offset;
+  offset[ 0 ] = 1.5; offset[ 1 ] = -2.0;
+  affineTransform->SetMatrix( matrix );
+  affineTransform->SetOffset( offset );
+
+  CombinationTransformType::Pointer combination = CombinationTransformType::New();
+  combination->SetCurrentTransform( bsplineTransform );
+  combination->SetInitialTransform( affineTransform );
+  combination->SetUseComposition( true );
+
+  RegulizerType::Pointer regulizer = RegulizerType::New();
+  regulizer->SetCurrentTransform( bsplineTransform );
+  regulizer->SetInitialTransform( affineTransform );
+  regulizer->SetUseComposition( true );
+
+  /** A smooth deformation field. */
+  VectorImageType::RegionType::SizeType fieldSize;
+  fieldSize[ 0 ] = 40; fieldSize[ 1 ] = 40;
+  VectorImageType::RegionType fieldRegion;
+  fieldRegion.SetSize( fieldSize );
+  VectorImageType::SpacingType fieldSpacing;
+  fieldSpacing.Fill( 2.0 );
+  VectorImageType::PointType fieldOrigin;
+  fieldOrigin.Fill( -10.0 );
+
+  regulizer->SetDeformationFieldRegion( fieldRegion );
+  regulizer->SetDeformationFieldSpacing( fieldSpacing );
+  regulizer->SetDeformationFieldOrigin( fieldOrigin );
+  regulizer->InitializeDeformationFields();
+
+  VectorImageType::Pointer field = VectorImageType::New();
+  field->SetRegions( fieldRegion );
+  field->SetSpacing( fieldSpacing );
+  field->SetOrigin( fieldOrigin );
+  field->Allocate();
+  itk::ImageRegionIteratorWithIndex< VectorImageType > it( field, fieldRegion );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    VectorImageType::PointType point;
+    field->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    VectorImageType::PixelType vector;
+    vector[ 0 ] = static_cast< float >( 2.0 * std::sin( 0.1 * point[ 1 ] ) );
+    vector[ 1 ] = static_cast< float >( -1.5 * std::cos( 0.08 * point[ 0 ] ) );
+    it.Set( vector );
+  }
+  regulizer->UpdateIntermediaryDeformationFieldTransform( field );
+
+  /** Compare lines along both axes, and an oblique line, as in images with
+   * a non-identity direction.
+   */
+  const unsigned long numberOfPoints = 30;
+  double              maximumFieldContribution = 0.0;
+  int                 result = 0;
+
+  InputPointType startPoint;
+  startPoint[ 0 ] = -5.3; startPoint[ 1 ] = 3.7;
+  InputVectorType step;
+  step[ 0 ] = 1.7; step[ 1 ] = 0.0;
+  result |= CompareLine( regulizer, combination, startPoint, step,
+    numberOfPoints, maximumFieldContribution );
+
+  startPoint[ 0 ] = 12.1; startPoint[ 1 ] = -6.2;
+  step[ 0 ] = 0.0; step[ 1 ] = 1.9;
+  result |= CompareLine( regulizer, combination, startPoint, step,
+    numberOfPoints, maximumFieldContribution );
+
+  startPoint[ 0 ] = -4.0; startPoint[ 1 ] = -5.0;
+  step[ 0 ] = 1.2; step[ 1 ] = 0.9;
+  result |= CompareLine( regulizer, combination, startPoint, step,
+    numberOfPoints, maximumFieldContribution );
+
+  /** Without any contribution of the field, the test is meaningless. */
+  std::cout << "Maximum contribution of the deformation field: "
+            << maximumFieldContribution << std::endl;
+  if( maximumFieldContribution < 0.1 )
+  {
+    std::cerr << "ERROR: the deformation field does not contribute, "
+              << "so the test is meaningless." << std::endl;
+    result = 1;
+  }
+
+  /** Return a value. */
+  return result;
+
+} // end main
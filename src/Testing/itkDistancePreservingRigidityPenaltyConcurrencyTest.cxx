@@ -0,0 +1,271 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "AdvancedMeanSquares/itkAdvancedMeanSquaresImageToImageMetric.h"
+#include "DistancePreservingRigidityPenalty/itkDistancePreservingRigidityPenaltyTerm.h"
+#include "MultiMetricMultiResolutionRegistration/itkCombinationImageToImageMetric.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkAdvancedCombinationTransform.h"
+#include "itkBSplineInterpolateImageFunction.h"
+#include "itkImage.h"
+#include "itkImageFullSampler.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+//-------------------------------------------------------------------------------------
+// This test checks that a CombinationImageToImageMetric of a mean squares
+// metric and the DistancePreservingRigidityPenalty gives the same value and
+// derivative when the metrics are evaluated concurrently as when they are
+// evaluated one after another. The penalty term may only set the parameters
+// of the shared B-spline transform before the concurrent evaluation.
+
+const unsigned int Dimension = 3;
+typedef float                                                              PixelType;
+typedef itk::Image< PixelType, Dimension >                                 ImageType;
+typedef itk::Image< signed short, Dimension >                              SegmentedImageType;
+typedef itk::CombinationImageToImageMetric< ImageType, ImageType >         CombinationMetricType;
+typedef itk::AdvancedMeanSquaresImageToImageMetric< ImageType, ImageType > MeanSquaresMetricType;
+typedef itk::DistancePreservingRigidityPenaltyTerm< ImageType, double >    PenaltyMetricType;
+typedef itk::AdvancedBSplineDeformableTransform< double, Dimension, 3 >    BSplineTransformType;
+typedef itk::AdvancedCombinationTransform< double, Dimension >             CombinationTransformType;
+typedef itk::BSplineInterpolateImageFunction< ImageType, double, double >  InterpolatorType;
+typedef itk::ImageFullSampler< ImageType >                                 SamplerType;
+typedef CombinationMetricType::ParametersType                              ParametersType;
+typedef CombinationMetricType::MeasureType                                 MeasureType;
+typedef CombinationMetricType::DerivativeType                              DerivativeType;
+
+/**
+ * Create an image of a blob, translated by the given vector.
+ */
+
+ImageType::Pointer
+CreateImage( const double * translation )
+{
+  ImageType::SizeType size;
+  size.Fill( 24 );
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    ImageType::PointType point;
+    image->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    double r2 = 0.0;
+    for( unsigned int i = 0; i < Dimension; ++i )
+    {
+      const double x = point[ i ] - 11.0 - translation[ i ];
+      r2 += x * x;
+    }
+    it.Set( static_cast< PixelType >( 100.0 * std::exp( -r2 / 40.0 ) + point[ 0 ] ) );
+  }
+
+  return image;
+
+} // end CreateImage()
+
+
+/**
+ * Create a segmentation with two rigid regions, on a coarser grid.
+ */
+
+SegmentedImageType::Pointer
+CreateSegmentation( void )
+{
+  SegmentedImageType::SizeType size;
+  size.Fill( 12 );
+  SegmentedImageType::SpacingType spacing;
+  spacing.Fill( 2.0 );
+
+  SegmentedImageType::Pointer image = SegmentedImageType::New();
+  image->SetRegions( size );
+  image->SetSpacing( spacing );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< SegmentedImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    SegmentedImageType::PointType point;
+    image->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    signed short label = 0;
+    if( point[ 0 ] >= 4.0 && point[ 0 ] <= 10.0 && point[ 1 ] >= 4.0 && point[ 1 ] <= 10.0
+      && point[ 2 ] >= 4.0 && point[ 2 ] <= 10.0 )
+    {
+      label = 1;
+    }
+    else if( point[ 0 ] >= 14.0 && point[ 0 ] <= 20.0 && point[ 1 ] >= 4.0 && point[ 1 ] <= 10.0
+      && point[ 2 ] >= 12.0 && point[ 2 ] <= 20.0 )
+    {
+      label = 2;
+    }
+    it.Set( label );
+  }
+
+  return image;
+
+} // end CreateSegmentation()
+
+
+/**
+ * Create the combination of a mean squares metric and the penalty term,
+ * with its own transform.
+ */
+
+CombinationMetricType::Pointer
+CreateMetric( ImageType * fixedImage, ImageType * movingImage,
+  SegmentedImageType * segmentation, const bool useMultiThread )
+{
+  /** A B-spline transform that covers the images. */
+  BSplineTransformType::Pointer bsplineTransform = BSplineTransformType::New();
+  BSplineTransformType::SizeType gridSize;
+  gridSize.Fill( 10 );
+  BSplineTransformType::RegionType gridRegion;
+  gridRegion.SetSize( gridSize );
+  BSplineTransformType::SpacingType gridSpacing;
+  gridSpacing.Fill( 4.0 );
+  BSplineTransformType::OriginType gridOrigin;
+  gridOrigin.Fill( -6.0 );
+  BSplineTransformType::DirectionType gridDirection;
+  gridDirection.SetIdentity();
+  bsplineTransform->SetGridOrigin( gridOrigin );
+  bsplineTransform->SetGridSpacing( gridSpacing );
+  bsplineTransform->SetGridRegion( gridRegion );
+  bsplineTransform->SetGridDirection( gridDirection );
+  bsplineTransform->SetIdentity();
+
+  CombinationTransformType::Pointer transform = CombinationTransformType::New();
+  transform->SetCurrentTransform( bsplineTransform );
+
+  InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  interpolator->SetSplineOrder( 3 );
+
+  MeanSquaresMetricType::Pointer meanSquares = MeanSquaresMetricType::New();
+  meanSquares->SetImageSampler( SamplerType::New() );
+  meanSquares->SetUseMultiThread( true );
+
+  PenaltyMetricType::Pointer penalty = PenaltyMetricType::New();
+  penalty->SetSegmentedImage( segmentation );
+  penalty->SetSampledSegmentedImage( segmentation );
+
+  CombinationMetricType::Pointer combination = CombinationMetricType::New();
+  combination->SetNumberOfMetrics( 2 );
+  combination->SetMetric( meanSquares, 0 );
+  combination->SetMetric( penalty, 1 );
+  combination->SetMetricWeight( 1.0, 0 );
+  combination->SetMetricWeight( 50.0, 1 );
+  combination->SetFixedImage( fixedImage );
+  combination->SetMovingImage( movingImage );
+  combination->SetFixedImageRegion( fixedImage->GetBufferedRegion() );
+  combination->SetTransform( transform );
+  combination->SetInterpolator( interpolator );
+  combination->SetUseMultiThread( useMultiThread );
+  combination->SetNumberOfThreads( 4 );
+  combination->Initialize();
+
+  return combination;
+
+} // end CreateMetric()
+
+
+int
+main( int argc, char * argv[] )
+{
+  const double tolerance                = 1e-10;
+  const double translation[ Dimension ] = { 1.5, -1.0, 0.5 };
+  const double zero[ Dimension ]        = { 0.0, 0.0, 0.0 };
+
+  int result = 0;
+  try
+  {
+    ImageType::Pointer          fixedImage   = CreateImage( zero );
+    ImageType::Pointer          movingImage  = CreateImage( translation );
+    SegmentedImageType::Pointer segmentation = CreateSegmentation();
+
+    CombinationMetricType::Pointer serialMetric
+      = CreateMetric( fixedImage, movingImage, segmentation, false );
+    CombinationMetricType::Pointer concurrentMetric
+      = CreateMetric( fixedImage, movingImage, segmentation, true );
+
+    if( !concurrentMetric->GetEvaluateMetricsConcurrently() )
+    {
+      std::cerr << "ERROR: the metrics are not evaluated concurrently." << std::endl;
+      return 1;
+    }
+
+    /** Compare for a few sets of parameters. */
+    ParametersType parameters( serialMetric->GetNumberOfParameters() );
+    for( unsigned int k = 0; k < 3; ++k )
+    {
+      for( unsigned int i = 0; i < parameters.GetSize(); ++i )
+      {
+        parameters[ i ] = 0.4 * std::sin( 0.37 * i + k ) + 0.2 * std::cos( 1.3 * i );
+      }
+
+      MeasureType    serialValue     = 0.0;
+      MeasureType    concurrentValue = 0.0;
+      DerivativeType serialDerivative;
+      DerivativeType concurrentDerivative;
+      serialMetric->GetValueAndDerivative( parameters, serialValue, serialDerivative );
+      concurrentMetric->GetValueAndDerivative( parameters, concurrentValue, concurrentDerivative );
+
+      const MeasureType penaltyValue = serialMetric->GetMetricValue( 1 );
+      std::cout << "parameters " << k << ": value " << serialValue << " (serial), "
+                << concurrentValue << " (concurrent); penalty " << penaltyValue << std::endl;
+
+      if( penaltyValue == 0.0 )
+      {
+        std::cerr << "ERROR: the penalty term is zero, so the test is meaningless." << std::endl;
+        result = 1;
+      }
+      if( std::abs( serialValue - concurrentValue ) > tolerance * std::abs( serialValue ) )
+      {
+        std::cerr << "ERROR: the concurrent value differs from the serial value." << std::endl;
+        result = 1;
+      }
+
+      double maximum       = 0.0;
+      double maxDifference = 0.0;
+      for( unsigned int i = 0; i < serialDerivative.GetSize(); ++i )
+      {
+        maximum       = std::max( maximum, std::abs( serialDerivative[ i ] ) );
+        maxDifference = std::max( maxDifference,
+          std::abs( serialDerivative[ i ] - concurrentDerivative[ i ] ) );
+      }
+      if( maxDifference > tolerance * maximum )
+      {
+        std::cerr << "ERROR: the concurrent derivative differs from the serial derivative by "
+                  << maxDifference << " (maximum " << maximum << ")." << std::endl;
+        result = 1;
+      }
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: " << excp << std::endl;
+    return 1;
+  }
+
+  /** Return a value. */
+  return result;
+
+} // end main
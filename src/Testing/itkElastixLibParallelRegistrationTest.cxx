@@ -0,0 +1,301 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "elastixlib.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMultiThreader.h"
+#include "itksys/SystemTools.hxx"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+// This test runs four registrations with the library interface at the same
+// time, in four threads. Each registration should find its own translation,
+// and write its own log: the log of a run should show its own output
+// directory, and not that of another run. Two of the registrations use a
+// random sampler. Each run draws from its own random generator, so these
+// should give exactly the same result as when they are run one at a time.
+
+const unsigned int Dimension = 2;
+typedef float                              PixelType;
+typedef itk::Image< PixelType, Dimension > ImageType;
+
+/** The input and output of one registration. */
+struct RegistrationData
+{
+  ImageType::Pointer m_FixedImage;
+  ImageType::Pointer m_MovingImage;
+  std::string        m_OutputDirectory;
+  std::string        m_ImageSampler;
+  std::string        m_RandomSeed;
+  double             m_Translation[ Dimension ];
+  int                m_ReturnCode;
+  double             m_Result[ Dimension ];
+
+  std::vector< std::string > m_TransformParameters;
+};
+
+/**
+ * Create an image of two blobs, translated by the given vector.
+ */
+
+ImageType::Pointer
+CreateImage( const double * translation )
+{
+  ImageType::SizeType size;
+  size.Fill( 64 );
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    ImageType::PointType point;
+    image->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    const double x  = point[ 0 ] - translation[ 0 ];
+    const double y  = point[ 1 ] - translation[ 1 ];
+    const double r1 = ( x - 28.0 ) * ( x - 28.0 ) + ( y - 30.0 ) * ( y - 30.0 );
+    const double r2 = ( x - 38.0 ) * ( x - 38.0 ) / 2.0 + ( y - 36.0 ) * ( y - 36.0 );
+    it.Set( static_cast< PixelType >( 100.0 * std::exp( -r1 / 60.0 )
+      + 60.0 * std::exp( -r2 / 30.0 ) ) );
+  }
+
+  return image;
+
+} // end CreateImage()
+
+
+/**
+ * A translation registration, with the image sampler and random seed of
+ * the given registration.
+ */
+
+elastix::ELASTIX::ParameterMapType
+CreateParameterMap( const RegistrationData & data )
+{
+  elastix::ELASTIX::ParameterMapType parameterMap;
+  parameterMap[ "FixedInternalImagePixelType" ]  = std::vector< std::string >( 1, "float" );
+  parameterMap[ "MovingInternalImagePixelType" ] = std::vector< std::string >( 1, "float" );
+  parameterMap[ "FixedImageDimension" ]          = std::vector< std::string >( 1, "2" );
+  parameterMap[ "MovingImageDimension" ]         = std::vector< std::string >( 1, "2" );
+  parameterMap[ "Registration" ]                 = std::vector< std::string >( 1, "MultiResolutionRegistration" );
+  parameterMap[ "FixedImagePyramid" ]            = std::vector< std::string >( 1, "FixedSmoothingImagePyramid" );
+  parameterMap[ "MovingImagePyramid" ]           = std::vector< std::string >( 1, "MovingSmoothingImagePyramid" );
+  parameterMap[ "Interpolator" ]                 = std::vector< std::string >( 1, "LinearInterpolator" );
+  parameterMap[ "Metric" ]                       = std::vector< std::string >( 1, "AdvancedMeanSquares" );
+  parameterMap[ "Optimizer" ]                    = std::vector< std::string >( 1, "AdaptiveStochasticGradientDescent" );
+  parameterMap[ "ResampleInterpolator" ]         = std::vector< std::string >( 1, "FinalLinearInterpolator" );
+  parameterMap[ "Resampler" ]                    = std::vector< std::string >( 1, "DefaultResampler" );
+  parameterMap[ "Transform" ]                    = std::vector< std::string >( 1, "TranslationTransform" );
+  parameterMap[ "NumberOfResolutions" ]          = std::vector< std::string >( 1, "2" );
+  parameterMap[ "MaximumNumberOfIterations" ]    = std::vector< std::string >( 1, "200" );
+  parameterMap[ "AutomaticParameterEstimation" ] = std::vector< std::string >( 1, "true" );
+  parameterMap[ "ImageSampler" ]                 = std::vector< std::string >( 1, data.m_ImageSampler );
+  parameterMap[ "NumberOfSpatialSamples" ]       = std::vector< std::string >( 1, "2000" );
+  parameterMap[ "NewSamplesEveryIteration" ]     = std::vector< std::string >( 1, "true" );
+  parameterMap[ "RandomSeed" ]                   = std::vector< std::string >( 1, data.m_RandomSeed );
+  parameterMap[ "WriteResultImage" ]             = std::vector< std::string >( 1, "false" );
+  return parameterMap;
+
+} // end CreateParameterMap()
+
+
+/**
+ * Run one registration.
+ */
+
+void
+RunRegistration( RegistrationData * data )
+{
+  elastix::ELASTIX::ParameterMapType parameterMap = CreateParameterMap( *data );
+  elastix::ELASTIX                   elastix;
+  data->m_ReturnCode = elastix.RegisterImages(
+    static_cast< itk::DataObject * >( data->m_FixedImage.GetPointer() ),
+    static_cast< itk::DataObject * >( data->m_MovingImage.GetPointer() ),
+    parameterMap, data->m_OutputDirectory, true, false );
+
+  if( data->m_ReturnCode == 0 )
+  {
+    elastix::ELASTIX::ParameterMapType transformParameterMap
+      = elastix.GetTransformParameterMap();
+    data->m_TransformParameters = transformParameterMap[ "TransformParameters" ];
+    for( unsigned int i = 0; i < Dimension && i < data->m_TransformParameters.size(); ++i )
+    {
+      data->m_Result[ i ] = std::atof( data->m_TransformParameters[ i ].c_str() );
+    }
+  }
+
+} // end RunRegistration()
+
+
+/**
+ * Run one registration. Used as the function of a thread.
+ */
+
+ITK_THREAD_RETURN_TYPE
+RegistrationThreadCallback( void * arg )
+{
+  itk::MultiThreader::ThreadInfoStruct * infoStruct
+    = static_cast< itk::MultiThreader::ThreadInfoStruct * >( arg );
+  RunRegistration( static_cast< RegistrationData * >( infoStruct->UserData ) );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end RegistrationThreadCallback()
+
+
+int
+main( int argc, char * argv[] )
+{
+  if( argc != 2 )
+  {
+    std::cerr << "Usage: " << argv[ 0 ] << " outputDirectory" << std::endl;
+    return 1;
+  }
+
+  const unsigned int numberOfRegistrations = 4;
+  const double       translations[ numberOfRegistrations ][ Dimension ]
+    = { { 3.0, -2.0 }, { -2.5, 4.0 }, { 1.5, 2.5 }, { -3.0, -1.5 } };
+  const char *       imageSamplers[ numberOfRegistrations ]
+    = { "Full", "Full", "Random", "RandomCoordinate" };
+  const char *       randomSeeds[ numberOfRegistrations ] = { "121212", "121212", "1234", "4321" };
+  const double       zero[ Dimension ] = { 0.0, 0.0 };
+  const double       tolerance = 0.2;
+
+  /** Prepare the registrations, each with its own output directory. */
+  RegistrationData data[ numberOfRegistrations ];
+  for( unsigned int r = 0; r < numberOfRegistrations; ++r )
+  {
+    std::ostringstream outputDirectory;
+    outputDirectory << argv[ 1 ] << "/run" << r << "/";
+    itksys::SystemTools::MakeDirectory( outputDirectory.str().c_str() );
+
+    data[ r ].m_FixedImage      = CreateImage( zero );
+    data[ r ].m_MovingImage     = CreateImage( translations[ r ] );
+    data[ r ].m_OutputDirectory = outputDirectory.str();
+    data[ r ].m_ImageSampler    = imageSamplers[ r ];
+    data[ r ].m_RandomSeed      = randomSeeds[ r ];
+    data[ r ].m_ReturnCode      = 1;
+    for( unsigned int i = 0; i < Dimension; ++i )
+    {
+      data[ r ].m_Translation[ i ] = translations[ r ][ i ];
+      data[ r ].m_Result[ i ]      = 0.0;
+    }
+  }
+
+  /** Run them at the same time. */
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  int                         threadIds[ numberOfRegistrations ];
+  for( unsigned int r = 0; r < numberOfRegistrations; ++r )
+  {
+    threadIds[ r ] = threader->SpawnThread( RegistrationThreadCallback, &data[ r ] );
+  }
+  for( unsigned int r = 0; r < numberOfRegistrations; ++r )
+  {
+    threader->TerminateThread( threadIds[ r ] );
+  }
+
+  /** Run the registrations with a random sampler again, one at a time. */
+  RegistrationData serialData[ numberOfRegistrations ];
+  for( unsigned int r = 0; r < numberOfRegistrations; ++r )
+  {
+    if( data[ r ].m_ImageSampler == "Full" )
+    {
+      continue;
+    }
+    std::ostringstream outputDirectory;
+    outputDirectory << argv[ 1 ] << "/serial" << r << "/";
+    itksys::SystemTools::MakeDirectory( outputDirectory.str().c_str() );
+
+    serialData[ r ]                   = data[ r ];
+    serialData[ r ].m_OutputDirectory = outputDirectory.str();
+    serialData[ r ].m_ReturnCode      = 1;
+    serialData[ r ].m_TransformParameters.clear();
+    RunRegistration( &serialData[ r ] );
+  }
+
+  /** Check the results and the logs. */
+  int result = 0;
+  for( unsigned int r = 0; r < numberOfRegistrations; ++r )
+  {
+    std::cout << "Registration " << r << ": return code " << data[ r ].m_ReturnCode
+              << ", translation " << data[ r ].m_Result[ 0 ] << " " << data[ r ].m_Result[ 1 ]
+              << " (expected " << data[ r ].m_Translation[ 0 ] << " "
+              << data[ r ].m_Translation[ 1 ] << ")" << std::endl;
+
+    if( data[ r ].m_ReturnCode != 0 )
+    {
+      std::cerr << "ERROR: registration " << r << " failed." << std::endl;
+      result = 1;
+      continue;
+    }
+    for( unsigned int i = 0; i < Dimension; ++i )
+    {
+      if( std::abs( data[ r ].m_Result[ i ] - data[ r ].m_Translation[ i ] ) > tolerance )
+      {
+        std::cerr << "ERROR: registration " << r << " did not find its translation." << std::endl;
+        result = 1;
+      }
+    }
+
+    /** A run with a random sampler should not depend on the other runs. */
+    if( data[ r ].m_ImageSampler != "Full"
+      && ( serialData[ r ].m_ReturnCode != 0
+      || serialData[ r ].m_TransformParameters != data[ r ].m_TransformParameters ) )
+    {
+      std::cerr << "ERROR: registration " << r << " with the " << data[ r ].m_ImageSampler
+                << " sampler gives another result when it is run on its own." << std::endl;
+      result = 1;
+    }
+
+    const std::string logFileName = data[ r ].m_OutputDirectory + "elastix.log";
+    std::ifstream     logFile( logFileName.c_str() );
+    if( !logFile.is_open() )
+    {
+      std::cerr << "ERROR: " << logFileName << " was not written." << std::endl;
+      result = 1;
+      continue;
+    }
+    std::stringstream log;
+    log << logFile.rdbuf();
+    const std::string & otherDirectory
+      = data[ ( r + 1 ) % numberOfRegistrations ].m_OutputDirectory;
+    if( log.str().find( data[ r ].m_OutputDirectory ) == std::string::npos
+      || log.str().find( otherDirectory ) != std::string::npos
+      || log.str().find( "Total time elapsed" ) == std::string::npos )
+    {
+      std::cerr << "ERROR: " << logFileName
+                << " does not contain the complete log of registration " << r
+                << " only." << std::endl;
+      result = 1;
+    }
+  }
+
+  /** Return a value. */
+  return result;
+
+} // end main
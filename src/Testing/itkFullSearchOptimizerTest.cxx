@@ -0,0 +1,356 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "FullSearch/itkFullSearchOptimizer.h"
+
+#include "itkSingleValuedCostFunction.h"
+
+#include <cmath>
+#include <iostream>
+
+//-------------------------------------------------------------------------------------
+// This test checks the FullSearchOptimizer:
+// - refining the grid brings the best point closer to the minimum;
+// - adding a search dimension after a refined search starts again from the
+//   initial grid, at refinement level 0;
+// - evaluating the grid points concurrently, with copies of the cost
+//   function, gives the same best point and value as the serial search.
+
+namespace itk
+{
+
+/**
+ * A quadratic cost function, which counts its evaluations. Each copy has
+ * its own counter, so copies can be evaluated at the same time.
+ */
+
+class FullSearchTestCostFunction : public SingleValuedCostFunction
+{
+public:
+
+  typedef FullSearchTestCostFunction Self;
+  typedef SingleValuedCostFunction   Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  itkNewMacro( Self );
+  itkTypeMacro( FullSearchTestCostFunction, SingleValuedCostFunction );
+
+  typedef Superclass::MeasureType    MeasureType;
+  typedef Superclass::ParametersType ParametersType;
+  typedef Superclass::DerivativeType DerivativeType;
+
+  virtual unsigned int GetNumberOfParameters( void ) const
+  {
+    return 3;
+  }
+
+
+  virtual MeasureType GetValue( const ParametersType & parameters ) const
+  {
+    ++this->m_NumberOfEvaluations;
+    const double x = parameters[ 0 ] - 0.3;
+    const double y = parameters[ 1 ] + 0.7;
+    const double z = parameters[ 2 ] - 0.2;
+    return x * x + 2.0 * y * y + 0.5 * x * y + z * z;
+  }
+
+
+  virtual void GetDerivative( const ParametersType &, DerivativeType & ) const
+  {
+    itkExceptionMacro( << "The derivative is not implemented." );
+  }
+
+
+  unsigned long GetNumberOfEvaluations( void ) const
+  {
+    return this->m_NumberOfEvaluations;
+  }
+
+
+  void ResetNumberOfEvaluations( void )
+  {
+    this->m_NumberOfEvaluations = 0;
+  }
+
+
+protected:
+
+  FullSearchTestCostFunction() : m_NumberOfEvaluations( 0 ) {}
+  virtual ~FullSearchTestCostFunction() {}
+
+private:
+
+  FullSearchTestCostFunction( const Self & ); // purposely not implemented
+  void operator=( const Self & );             // purposely not implemented
+
+  mutable unsigned long m_NumberOfEvaluations;
+
+};
+
+} // end namespace itk
+
+typedef itk::FullSearchOptimizer        OptimizerType;
+typedef itk::FullSearchTestCostFunction CostFunctionType;
+
+/**
+ * Create an optimizer that searches parameters 0 and 1 on a grid.
+ */
+
+OptimizerType::Pointer
+CreateOptimizer( CostFunctionType * costFunction, const double step,
+  const unsigned int numberOfRefinementLevels )
+{
+  OptimizerType::ParametersType initialPosition( costFunction->GetNumberOfParameters() );
+  initialPosition.Fill( 0.0 );
+
+  OptimizerType::Pointer optimizer = OptimizerType::New();
+  optimizer->SetCostFunction( costFunction );
+  optimizer->SetInitialPosition( initialPosition );
+  optimizer->SetMinimize( true );
+  optimizer->AddSearchDimension( 0, -2.0, 2.0, step );
+  optimizer->AddSearchDimension( 1, -2.0, 2.0, step );
+  optimizer->SetNumberOfRefinementLevels( numberOfRefinementLevels );
+
+  return optimizer;
+
+} // end CreateOptimizer()
+
+
+/**
+ * The distance of the best point to the minimum of the cost function.
+ */
+
+double
+DistanceToMinimum( const OptimizerType * optimizer )
+{
+  const OptimizerType::SearchSpacePointType & best = optimizer->GetBestPointInSearchSpace();
+  return std::sqrt( ( best[ 0 ] - 0.3 ) * ( best[ 0 ] - 0.3 )
+    + ( best[ 1 ] + 0.7 ) * ( best[ 1 ] + 0.7 ) );
+
+} // end DistanceToMinimum()
+
+
+/**
+ * Test the refinement of the grid.
+ */
+
+int
+TestRefinement( void )
+{
+  CostFunctionType::Pointer costFunction = CostFunctionType::New();
+
+  /** The search without refinement. */
+  OptimizerType::Pointer optimizer = CreateOptimizer( costFunction, 0.5, 0 );
+  optimizer->StartOptimization();
+  const double coarseDistance = DistanceToMinimum( optimizer );
+  const double coarseValue    = optimizer->GetBestValue();
+
+  /** The search with refinement. */
+  optimizer->SetNumberOfRefinementLevels( 3 );
+  optimizer->StartOptimization();
+  const double refinedDistance = DistanceToMinimum( optimizer );
+  const double refinedValue    = optimizer->GetBestValue();
+
+  std::cout << "Without refinement: distance " << coarseDistance
+            << ", value " << coarseValue << std::endl;
+  std::cout << "With refinement:    distance " << refinedDistance
+            << ", value " << refinedValue << std::endl;
+
+  if( optimizer->GetCurrentRefinementLevel() != 3 )
+  {
+    std::cerr << "ERROR: the refinement level is " << optimizer->GetCurrentRefinementLevel()
+              << " instead of 3." << std::endl;
+    return 1;
+  }
+
+  /** The final step is 0.5 / 2^3, so the best point is within half a step
+   * per dimension of the minimum.
+   */
+  if( !( refinedValue < coarseValue ) || !( refinedDistance < coarseDistance )
+    || refinedDistance > 0.0625 )
+  {
+    std::cerr << "ERROR: the refinement did not improve the best point." << std::endl;
+    return 1;
+  }
+
+  /** The best index refers to the initial grid. */
+  const OptimizerType::SearchSpaceIndexType & bestIndex = optimizer->GetBestIndexInSearchSpace();
+  if( bestIndex[ 0 ] < 0 || bestIndex[ 0 ] > 8 || bestIndex[ 1 ] < 0 || bestIndex[ 1 ] > 8 )
+  {
+    std::cerr << "ERROR: the best index " << bestIndex
+              << " does not refer to the initial grid." << std::endl;
+    return 1;
+  }
+
+  return 0;
+
+} // end TestRefinement()
+
+
+/**
+ * Test that changing the search dimensions after a refined search starts
+ * again from the initial grid.
+ */
+
+int
+TestChangeSearchDimensions( void )
+{
+  CostFunctionType::Pointer costFunction = CostFunctionType::New();
+  OptimizerType::Pointer    optimizer    = CreateOptimizer( costFunction, 0.5, 2 );
+  optimizer->StartOptimization();
+
+  /** Add a dimension: the grid should be the initial grid plus the new
+   * dimension, not the refined grid.
+   */
+  optimizer->AddSearchDimension( 2, -1.0, 1.0, 0.25 );
+  if( optimizer->GetCurrentRefinementLevel() != 0 )
+  {
+    std::cerr << "ERROR: AddSearchDimension did not reset the refinement level." << std::endl;
+    return 1;
+  }
+  const OptimizerType::SearchSpaceType * searchSpace = optimizer->GetSearchSpace();
+  if( searchSpace->Size() != 3
+    || searchSpace->GetElement( 0 )[ 0 ] != -2.0 || searchSpace->GetElement( 0 )[ 1 ] != 2.0
+    || searchSpace->GetElement( 0 )[ 2 ] != 0.5 || searchSpace->GetElement( 2 )[ 2 ] != 0.25 )
+  {
+    std::cerr << "ERROR: AddSearchDimension did not start from the initial grid." << std::endl;
+    return 1;
+  }
+
+  optimizer->SetNumberOfRefinementLevels( 0 );
+  costFunction->ResetNumberOfEvaluations();
+  optimizer->StartOptimization();
+  if( optimizer->GetNumberOfIterations() != 9 * 9 * 9
+    || costFunction->GetNumberOfEvaluations() != 9 * 9 * 9 )
+  {
+    std::cerr << "ERROR: after AddSearchDimension " << costFunction->GetNumberOfEvaluations()
+              << " points were searched instead of " << 9 * 9 * 9 << "." << std::endl;
+    return 1;
+  }
+
+  /** Remove it again, after a refined search. */
+  optimizer->SetNumberOfRefinementLevels( 1 );
+  optimizer->StartOptimization();
+  optimizer->RemoveSearchDimension( 2 );
+  if( optimizer->GetCurrentRefinementLevel() != 0
+    || optimizer->GetSearchSpace()->Size() != 2
+    || optimizer->GetSearchSpace()->GetElement( 1 )[ 2 ] != 0.5 )
+  {
+    std::cerr << "ERROR: RemoveSearchDimension did not start from the initial grid." << std::endl;
+    return 1;
+  }
+
+  optimizer->SetNumberOfRefinementLevels( 0 );
+  costFunction->ResetNumberOfEvaluations();
+  optimizer->StartOptimization();
+  if( costFunction->GetNumberOfEvaluations() != 9 * 9 )
+  {
+    std::cerr << "ERROR: after RemoveSearchDimension " << costFunction->GetNumberOfEvaluations()
+              << " points were searched instead of " << 9 * 9 << "." << std::endl;
+    return 1;
+  }
+
+  return 0;
+
+} // end TestChangeSearchDimensions()
+
+
+/**
+ * Test that the concurrent evaluation of blocks of grid points gives the
+ * same result as the serial search.
+ */
+
+int
+TestConcurrentEvaluation( void )
+{
+  const unsigned int numberOfCopies = 3;
+
+  /** A fine grid, so that it takes several blocks. */
+  CostFunctionType::Pointer serialCostFunction = CostFunctionType::New();
+  OptimizerType::Pointer    serialOptimizer    = CreateOptimizer( serialCostFunction, 0.05, 2 );
+  serialOptimizer->StartOptimization();
+
+  CostFunctionType::Pointer threadedCostFunction = CostFunctionType::New();
+  OptimizerType::Pointer    threadedOptimizer    = CreateOptimizer( threadedCostFunction, 0.05, 2 );
+  std::vector< CostFunctionType::Pointer > copies;
+  OptimizerType::CostFunctionContainerType concurrentCostFunctions;
+  for( unsigned int i = 0; i < numberOfCopies; ++i )
+  {
+    copies.push_back( CostFunctionType::New() );
+    concurrentCostFunctions.push_back( copies.back().GetPointer() );
+  }
+  threadedOptimizer->SetConcurrentCostFunctions( concurrentCostFunctions );
+  threadedOptimizer->StartOptimization();
+
+  /** All points should be evaluated once, by one of the cost functions. */
+  unsigned long numberOfEvaluations = threadedCostFunction->GetNumberOfEvaluations();
+  for( unsigned int i = 0; i < numberOfCopies; ++i )
+  {
+    numberOfEvaluations += copies[ i ]->GetNumberOfEvaluations();
+  }
+
+  std::cout << "Serial:   " << serialCostFunction->GetNumberOfEvaluations()
+            << " evaluations, best point " << serialOptimizer->GetBestPointInSearchSpace()
+            << ", value " << serialOptimizer->GetBestValue() << std::endl;
+  std::cout << "Threaded: " << numberOfEvaluations
+            << " evaluations, best point " << threadedOptimizer->GetBestPointInSearchSpace()
+            << ", value " << threadedOptimizer->GetBestValue() << std::endl;
+
+  if( numberOfEvaluations != serialCostFunction->GetNumberOfEvaluations()
+    || threadedOptimizer->GetCurrentIteration() != serialOptimizer->GetCurrentIteration() )
+  {
+    std::cerr << "ERROR: the concurrent search evaluated " << numberOfEvaluations
+              << " points instead of " << serialCostFunction->GetNumberOfEvaluations()
+              << "." << std::endl;
+    return 1;
+  }
+
+  /** The values are computed in the same way, so the results are identical. */
+  if( threadedOptimizer->GetBestValue() != serialOptimizer->GetBestValue()
+    || threadedOptimizer->GetBestPointInSearchSpace() != serialOptimizer->GetBestPointInSearchSpace()
+    || threadedOptimizer->GetBestIndexInSearchSpace() != serialOptimizer->GetBestIndexInSearchSpace() )
+  {
+    std::cerr << "ERROR: the concurrent search differs from the serial search." << std::endl;
+    return 1;
+  }
+
+  return 0;
+
+} // end TestConcurrentEvaluation()
+
+
+int
+main( int argc, char * argv[] )
+{
+  int result = 0;
+  try
+  {
+    result |= TestRefinement();
+    result |= TestChangeSearchDimensions();
+    result |= TestConcurrentEvaluation();
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: " << excp << std::endl;
+    return 1;
+  }
+
+  /** Return a value. */
+  return result;
+
+} // end main
@@ -0,0 +1,232 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkGenericMultiResolutionPyramidImageFilter.h"
+
+#include "itkImage.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+//-------------------------------------------------------------------------------------
+// This test checks that the cascaded mode of the
+// GenericMultiResolutionPyramidImageFilter, which computes each level from
+// the next finer level, gives the same levels as the direct computation
+// from the input. The geometry, i.e. the start index, size, spacing and
+// origin of each level, should be the same, also for an input with a
+// non-zero start index and sizes that are not a multiple of the shrink
+// factors. The intensities differ only by the discretisation errors of the
+// smoothing, which are small for a smooth input. For a smoothing schedule
+// that is not monotonic, a level with a smaller sigma than its finer level
+// should be computed from the input, and thus equal the direct computation.
+
+const unsigned int Dimension      = 2;
+const unsigned int NumberOfLevels = 3;
+typedef float                              PixelType;
+typedef itk::Image< PixelType, Dimension > ImageType;
+typedef itk::GenericMultiResolutionPyramidImageFilter<
+  ImageType, ImageType >                   PyramidType;
+
+/**
+ * Compute all levels of the pyramid, either cascaded or directly.
+ */
+
+PyramidType::Pointer
+ComputePyramid( const ImageType * input, const double * sigmaFactors,
+  const bool useShrinkImageFilter, const bool useCascade )
+{
+  PyramidType::RescaleScheduleType   rescaleSchedule( NumberOfLevels, Dimension );
+  PyramidType::SmoothingScheduleType smoothingSchedule( NumberOfLevels, Dimension );
+  const unsigned int                 factors[ NumberOfLevels ] = { 4, 2, 1 };
+  for( unsigned int level = 0; level < NumberOfLevels; ++level )
+  {
+    for( unsigned int dim = 0; dim < Dimension; ++dim )
+    {
+      rescaleSchedule[ level ][ dim ]   = factors[ level ];
+      smoothingSchedule[ level ][ dim ] = sigmaFactors[ level ] * input->GetSpacing()[ dim ];
+    }
+  }
+
+  PyramidType::Pointer pyramid = PyramidType::New();
+  pyramid->SetNumberOfLevels( NumberOfLevels );
+  pyramid->SetRescaleSchedule( rescaleSchedule );
+  pyramid->SetSmoothingSchedule( smoothingSchedule );
+  pyramid->SetUseShrinkImageFilter( useShrinkImageFilter );
+  pyramid->SetComputeOnlyForCurrentLevel( false );
+  pyramid->SetUseCascade( useCascade );
+  pyramid->SetInput( input );
+  pyramid->Update();
+
+  return pyramid;
+
+} // end ComputePyramid()
+
+
+/**
+ * Compare the levels of the cascaded and the direct pyramid. The sigmas
+ * are given in voxels of the input.
+ */
+
+int
+ComparePyramids( const ImageType * input, const double * sigmaFactors,
+  const bool useShrinkImageFilter )
+{
+  const double geometryTolerance  = 1e-6;
+  const double intensityTolerance = 0.01;
+  const double fromInputTolerance = 1e-6;
+  const char * mode = useShrinkImageFilter ? "shrinker" : "resampler";
+
+  PyramidType::Pointer direct   = ComputePyramid( input, sigmaFactors, useShrinkImageFilter, false );
+  PyramidType::Pointer cascaded = ComputePyramid( input, sigmaFactors, useShrinkImageFilter, true );
+
+  /** The intensity range of the input, to make the tolerance relative. */
+  itk::ImageRegionConstIterator< ImageType > inputIt(
+    input, input->GetLargestPossibleRegion() );
+  double minimum = inputIt.Get();
+  double maximum = inputIt.Get();
+  for( ; !inputIt.IsAtEnd(); ++inputIt )
+  {
+    minimum = std::min( minimum, static_cast< double >( inputIt.Get() ) );
+    maximum = std::max( maximum, static_cast< double >( inputIt.Get() ) );
+  }
+
+  for( unsigned int level = 0; level < direct->GetNumberOfLevels(); ++level )
+  {
+    const ImageType * directLevel   = direct->GetOutput( level );
+    const ImageType * cascadedLevel = cascaded->GetOutput( level );
+
+    /** Compare the geometry. */
+    const ImageType::RegionType directRegion   = directLevel->GetLargestPossibleRegion();
+    const ImageType::RegionType cascadedRegion = cascadedLevel->GetLargestPossibleRegion();
+    if( directRegion != cascadedRegion
+      || cascadedLevel->GetBufferedRegion() != cascadedRegion )
+    {
+      std::cerr << "ERROR: with the " << mode << ", the region of level " << level
+                << " differs.\n  direct:   " << directRegion
+                << "\n  cascaded: " << cascadedRegion << std::endl;
+      return 1;
+    }
+
+    for( unsigned int dim = 0; dim < Dimension; ++dim )
+    {
+      if( std::abs( directLevel->GetSpacing()[ dim ] - cascadedLevel->GetSpacing()[ dim ] ) > geometryTolerance
+        || std::abs( directLevel->GetOrigin()[ dim ] - cascadedLevel->GetOrigin()[ dim ] ) > geometryTolerance )
+      {
+        std::cerr << "ERROR: with the " << mode << ", the geometry of level " << level
+                  << " differs.\n"
+                  << "  direct:   spacing " << directLevel->GetSpacing()
+                  << " origin " << directLevel->GetOrigin() << "\n"
+                  << "  cascaded: spacing " << cascadedLevel->GetSpacing()
+                  << " origin " << cascadedLevel->GetOrigin() << std::endl;
+        return 1;
+      }
+    }
+
+    /** Compare the intensities. */
+    itk::ImageRegionConstIterator< ImageType > directIt( directLevel, directRegion );
+    itk::ImageRegionConstIterator< ImageType > cascadedIt( cascadedLevel, directRegion );
+    double        sumOfSquares   = 0.0;
+    unsigned long numberOfPixels = 0;
+    for( ; !directIt.IsAtEnd(); ++directIt, ++cascadedIt )
+    {
+      const double difference = directIt.Get() - cascadedIt.Get();
+      sumOfSquares += difference * difference;
+      ++numberOfPixels;
+    }
+    const double rmse = std::sqrt( sumOfSquares / numberOfPixels );
+
+    std::cout << "Level " << level << " (" << mode << "): size "
+              << directRegion.GetSize() << ", RMSE " << rmse << std::endl;
+
+    /** A level that is smoothed less than the finer level, and the finest
+     * level, are computed from the input, as in the direct computation.
+     */
+    const bool fromInput = level == NumberOfLevels - 1
+      || sigmaFactors[ level ] < sigmaFactors[ level + 1 ];
+    const double tolerance = fromInput ? fromInputTolerance : intensityTolerance;
+    if( rmse > tolerance * ( maximum - minimum ) )
+    {
+      std::cerr << "ERROR: with the " << mode << ", the intensities of level " << level
+                << " differ: RMSE " << rmse << std::endl;
+      return 1;
+    }
+  }
+
+  return 0;
+
+} // end ComparePyramids()
+
+
+int
+main( int argc, char * argv[] )
+{
+  /** A smooth input with a non-zero start index, and sizes that are not a
+   * multiple of the shrink factors.
+   */
+  ImageType::IndexType index;
+  index[ 0 ] = 3; index[ 1 ] = -5;
+  ImageType::SizeType size;
+  size[ 0 ] = 67; size[ 1 ] = 53;
+  ImageType::RegionType region( index, size );
+  ImageType::SpacingType spacing;
+  spacing[ 0 ] = 0.7; spacing[ 1 ] = 1.3;
+  ImageType::PointType origin;
+  origin[ 0 ] = -10.0; origin[ 1 ] = 4.0;
+
+  ImageType::Pointer input = ImageType::New();
+  input->SetRegions( region );
+  input->SetSpacing( spacing );
+  input->SetOrigin( origin );
+  input->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( input, region );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    ImageType::PointType point;
+    input->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    it.Set( static_cast< PixelType >( 100.0
+      + 40.0 * std::sin( 0.11 * point[ 0 ] ) * std::cos( 0.07 * point[ 1 ] )
+      + 15.0 * std::cos( 0.05 * ( point[ 0 ] + point[ 1 ] ) ) ) );
+  }
+
+  /** Compare for the shrinker and for the resampler, for the default
+   * schedule, and for a schedule in which level 0 is smoothed less than
+   * level 1.
+   */
+  const double defaultSigmas[ NumberOfLevels ]      = { 2.0, 1.0, 0.5 };
+  const double nonMonotonicSigmas[ NumberOfLevels ] = { 1.0, 3.0, 0.5 };
+  int          result = 0;
+  try
+  {
+    result |= ComparePyramids( input, defaultSigmas, true );
+    result |= ComparePyramids( input, defaultSigmas, false );
+    result |= ComparePyramids( input, nonMonotonicSigmas, true );
+    result |= ComparePyramids( input, nonMonotonicSigmas, false );
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: " << excp << std::endl;
+    return 1;
+  }
+
+  /** Return a value. */
+  return result;
+
+} // end main
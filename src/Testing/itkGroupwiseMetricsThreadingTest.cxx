@@ -0,0 +1,306 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "PCAMetric2/itkPCAMetric2.h"
+#include "SumOfPairwiseCorrelationsMetric/itkSumOfPairwiseCorrelationCoefficientsMetric.h"
+#include "VarianceOverLastDimension/itkVarianceOverLastDimensionImageMetric.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkAdvancedCombinationTransform.h"
+#include "itkBSplineInterpolateImageFunction.h"
+#include "itkImage.h"
+#include "itkImageFullSampler.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+//-------------------------------------------------------------------------------------
+// This test checks that the multi-threaded VarianceOverLastDimension, PCAMetric2
+// and SumOfPairwiseCorrelationCoefficients metrics give the same value and
+// derivative as their single-threaded versions, for a 2D+time image, with and
+// without SubtractMean. The variance metric is also checked with random
+// sampling of the last dimension, for which the metric is given its own random
+// generator. It is reseeded before each evaluation, so that both versions
+// draw the same positions.
+
+const unsigned int Dimension = 3;
+typedef float                                                              PixelType;
+typedef itk::Image< PixelType, Dimension >                                 ImageType;
+typedef itk::VarianceOverLastDimensionImageMetric< ImageType, ImageType >  VarianceMetricType;
+typedef itk::PCAMetric2< ImageType, ImageType >                            PCAMetricType;
+typedef itk::SumOfPairwiseCorrelationCoefficientsMetric<
+  ImageType, ImageType >                                                   PairwiseMetricType;
+typedef itk::AdvancedBSplineDeformableTransform< double, Dimension, 3 >    BSplineTransformType;
+typedef itk::AdvancedCombinationTransform< double, Dimension >             CombinationTransformType;
+typedef itk::BSplineInterpolateImageFunction< ImageType, double, double >  InterpolatorType;
+typedef itk::ImageFullSampler< ImageType >                                 SamplerType;
+typedef itk::Statistics::MersenneTwisterRandomVariateGenerator             RandomGeneratorType;
+typedef VarianceMetricType::ParametersType                                 ParametersType;
+typedef VarianceMetricType::MeasureType                                    MeasureType;
+typedef VarianceMetricType::DerivativeType                                 DerivativeType;
+
+/**
+ * Create a 2D+time image of a blob that moves and changes in intensity
+ * over time.
+ */
+
+ImageType::Pointer
+CreateImage( void )
+{
+  ImageType::SizeType size;
+  size[ 0 ] = 16;
+  size[ 1 ] = 16;
+  size[ 2 ] = 6;
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    ImageType::PointType point;
+    image->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    const double t = point[ 2 ];
+    const double x = point[ 0 ] - 7.0 - 0.6 * t;
+    const double y = point[ 1 ] - 8.0 + 0.4 * std::sin( t );
+    it.Set( static_cast< PixelType >( ( 100.0 + 5.0 * t ) * std::exp( -( x * x + y * y ) / 20.0 )
+      + 0.5 * point[ 0 ] ) );
+  }
+
+  return image;
+
+} // end CreateImage()
+
+
+/**
+ * Create a B-spline transform that covers the image, also in time.
+ */
+
+BSplineTransformType::Pointer
+CreateBSplineTransform( void )
+{
+  BSplineTransformType::Pointer bsplineTransform = BSplineTransformType::New();
+  BSplineTransformType::SizeType gridSize;
+  gridSize[ 0 ] = 8;
+  gridSize[ 1 ] = 8;
+  gridSize[ 2 ] = 8;
+  BSplineTransformType::RegionType gridRegion;
+  gridRegion.SetSize( gridSize );
+  BSplineTransformType::SpacingType gridSpacing;
+  gridSpacing[ 0 ] = 4.0;
+  gridSpacing[ 1 ] = 4.0;
+  gridSpacing[ 2 ] = 1.5;
+  BSplineTransformType::OriginType gridOrigin;
+  gridOrigin[ 0 ] = -6.0;
+  gridOrigin[ 1 ] = -6.0;
+  gridOrigin[ 2 ] = -3.0;
+  BSplineTransformType::DirectionType gridDirection;
+  gridDirection.SetIdentity();
+  bsplineTransform->SetGridOrigin( gridOrigin );
+  bsplineTransform->SetGridSpacing( gridSpacing );
+  bsplineTransform->SetGridRegion( gridRegion );
+  bsplineTransform->SetGridDirection( gridDirection );
+  bsplineTransform->SetIdentity();
+
+  return bsplineTransform;
+
+} // end CreateBSplineTransform()
+
+
+/**
+ * Connect the metric to the image, a B-spline transform and a full sampler
+ * of the first time point. It is initialized by CompareMetric().
+ */
+
+template< class TMetric >
+void
+SetUpMetric( TMetric * metric, ImageType * image, const bool subtractMean )
+{
+  BSplineTransformType::Pointer     bsplineTransform = CreateBSplineTransform();
+  CombinationTransformType::Pointer transform        = CombinationTransformType::New();
+  transform->SetCurrentTransform( bsplineTransform );
+
+  InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  interpolator->SetSplineOrder( 3 );
+
+  /** The metrics sample the first time point, and look at all the others. */
+  ImageType::RegionType fixedImageRegion = image->GetBufferedRegion();
+  fixedImageRegion.SetSize( Dimension - 1, 1 );
+
+  metric->SetFixedImage( image );
+  metric->SetMovingImage( image );
+  metric->SetFixedImageRegion( fixedImageRegion );
+  metric->SetTransform( transform );
+  metric->SetInterpolator( interpolator );
+  metric->SetImageSampler( SamplerType::New() );
+  metric->SetNumAdditionalSamplesFixed( 0 );
+  metric->SetReducedDimensionIndex( 0 );
+  metric->SetSubtractMean( subtractMean );
+  metric->SetGridSize( bsplineTransform->GetGridRegion().GetSize() );
+  metric->SetTransformIsStackTransform( false );
+  metric->SetUseMultiThread( true );
+
+} // end SetUpMetric()
+
+
+/**
+ * Compare the multi-threaded value and derivative of the metric with the
+ * single-threaded ones, for a few numbers of threads and parameters.
+ */
+
+template< class TMetric >
+int
+CompareMetric( TMetric * metric, const std::string & name )
+{
+  /** Some of the metrics accumulate in float. */
+  const double       tolerance    = 1e-6;
+  const unsigned int seed         = 1234;
+  const unsigned int threads[ 3 ] = { 1, 2, 5 };
+
+  RandomGeneratorType::Pointer randomGenerator = RandomGeneratorType::New();
+  metric->SetRandomGenerator( randomGenerator );
+
+  int            result = 0;
+  ParametersType parameters( metric->GetNumberOfParameters() );
+  for( unsigned int t = 0; t < 3; ++t )
+  {
+    metric->SetNumberOfThreads( threads[ t ] );
+    metric->Initialize();
+
+    for( unsigned int k = 0; k < 2; ++k )
+    {
+      for( unsigned int i = 0; i < parameters.GetSize(); ++i )
+      {
+        parameters[ i ] = 0.4 * std::sin( 0.37 * i + k ) + 0.2 * std::cos( 1.3 * i );
+      }
+
+      MeasureType    singleValue = 0.0;
+      MeasureType    threadValue = 0.0;
+      DerivativeType singleDerivative;
+      DerivativeType threadDerivative;
+      randomGenerator->SetSeed( seed );
+      metric->GetValueAndDerivativeSingleThreaded( parameters, singleValue, singleDerivative );
+      randomGenerator->SetSeed( seed );
+      metric->GetValueAndDerivative( parameters, threadValue, threadDerivative );
+
+      randomGenerator->SetSeed( seed );
+      const MeasureType singleOnlyValue = metric->GetValueSingleThreaded( parameters );
+      randomGenerator->SetSeed( seed );
+      const MeasureType threadOnlyValue = metric->GetValue( parameters );
+
+      std::cout << name << ", " << threads[ t ] << " threads, parameters " << k
+                << ": value " << singleValue << " (single-threaded), "
+                << threadValue << " (multi-threaded)" << std::endl;
+
+      if( std::abs( singleValue - threadValue ) > tolerance * std::abs( singleValue )
+        || std::abs( singleOnlyValue - threadOnlyValue ) > tolerance * std::abs( singleOnlyValue ) )
+      {
+        std::cerr << "ERROR: the multi-threaded value of " << name
+                  << " differs from the single-threaded value." << std::endl;
+        result = 1;
+      }
+
+      if( threadDerivative.GetSize() != singleDerivative.GetSize() )
+      {
+        std::cerr << "ERROR: the multi-threaded derivative of " << name
+                  << " has the wrong size." << std::endl;
+        result = 1;
+        continue;
+      }
+
+      double maximum       = 0.0;
+      double maxDifference = 0.0;
+      for( unsigned int i = 0; i < singleDerivative.GetSize(); ++i )
+      {
+        maximum       = std::max( maximum, std::abs( singleDerivative[ i ] ) );
+        maxDifference = std::max( maxDifference,
+          std::abs( singleDerivative[ i ] - threadDerivative[ i ] ) );
+      }
+      if( maximum == 0.0 )
+      {
+        std::cerr << "ERROR: the derivative of " << name
+                  << " is zero, so the test is meaningless." << std::endl;
+        result = 1;
+      }
+      if( maxDifference > tolerance * maximum )
+      {
+        std::cerr << "ERROR: the multi-threaded derivative of " << name
+                  << " differs from the single-threaded derivative by "
+                  << maxDifference << " (maximum " << maximum << ")." << std::endl;
+        result = 1;
+      }
+    }
+  }
+
+  return result;
+
+} // end CompareMetric()
+
+
+int
+main( int argc, char * argv[] )
+{
+  int result = 0;
+  try
+  {
+    ImageType::Pointer image = CreateImage();
+
+    for( unsigned int s = 0; s < 2; ++s )
+    {
+      const bool        subtractMean = ( s == 1 );
+      const std::string suffix       = subtractMean ? " (SubtractMean)" : "";
+
+      /** The variance over all time points. */
+      VarianceMetricType::Pointer variance = VarianceMetricType::New();
+      SetUpMetric< VarianceMetricType >( variance, image, subtractMean );
+      variance->SetSampleLastDimensionRandomly( false );
+      result |= CompareMetric< VarianceMetricType >( variance, "Variance" + suffix );
+
+      /** The variance over a random selection of time points, which
+       * always includes the reduced dimension index.
+       */
+      VarianceMetricType::Pointer randomVariance = VarianceMetricType::New();
+      SetUpMetric< VarianceMetricType >( randomVariance, image, subtractMean );
+      randomVariance->SetSampleLastDimensionRandomly( true );
+      randomVariance->SetNumSamplesLastDimension( 3 );
+      randomVariance->SetNumAdditionalSamplesFixed( 1 );
+      result |= CompareMetric< VarianceMetricType >( randomVariance, "RandomVariance" + suffix );
+
+      PCAMetricType::Pointer pca = PCAMetricType::New();
+      SetUpMetric< PCAMetricType >( pca, image, subtractMean );
+      result |= CompareMetric< PCAMetricType >( pca, "PCAMetric2" + suffix );
+
+      PairwiseMetricType::Pointer pairwise = PairwiseMetricType::New();
+      SetUpMetric< PairwiseMetricType >( pairwise, image, subtractMean );
+      result |= CompareMetric< PairwiseMetricType >( pairwise, "SumOfPairwiseCorrelations" + suffix );
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: " << excp << std::endl;
+    return 1;
+  }
+
+  /** Return a value. */
+  return result;
+
+} // end main
@@ -0,0 +1,285 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "AdvancedMattesMutualInformation/itkParzenWindowMutualInformationImageToImageMetric.h"
+
+#include "itkAdvancedCombinationTransform.h"
+#include "itkAdvancedTranslationTransform.h"
+#include "itkBSplineInterpolateImageFunction.h"
+#include "itkHardLimiterFunction.h"
+#include "itkImage.h"
+#include "itkImageFullSampler.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+//-------------------------------------------------------------------------------------
+// This test checks that the joint histogram of the Parzen window metrics,
+// which is computed per thread and then merged by the threads in bands of
+// histogram rows, equals the joint histogram of the single-threaded
+// computation. The numbers of histogram rows are chosen such that they are
+// not a multiple of the numbers of threads. The per-thread partial sums are
+// added in another order than the single-threaded sum, so the histograms are
+// compared with a small relative tolerance.
+
+namespace itk
+{
+
+/**
+ * A Parzen window mutual information metric that gives access to its
+ * joint histogram.
+ */
+
+template< class TFixedImage, class TMovingImage >
+class ParzenWindowHistogramThreadingTestMetric :
+  public ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+{
+public:
+
+  typedef ParzenWindowHistogramThreadingTestMetric Self;
+  typedef ParzenWindowMutualInformationImageToImageMetric<
+    TFixedImage, TMovingImage >                    Superclass;
+  typedef SmartPointer< Self >                     Pointer;
+  typedef SmartPointer< const Self >               ConstPointer;
+
+  itkNewMacro( Self );
+  itkTypeMacro( ParzenWindowHistogramThreadingTestMetric,
+    ParzenWindowMutualInformationImageToImageMetric );
+
+  typedef typename Superclass::ParametersType ParametersType;
+  typedef typename Superclass::JointPDFType   JointPDFType;
+
+  /** Compute the joint histogram, single- or multi-threaded. */
+  void ComputeJointHistogram( const ParametersType & parameters,
+    const bool multiThreaded ) const
+  {
+    if( multiThreaded )
+    {
+      this->ComputePDFs( parameters );
+    }
+    else
+    {
+      this->ComputePDFsSingleThreaded( parameters );
+    }
+  }
+
+
+  const JointPDFType * GetJointHistogram( void ) const
+  {
+    return this->m_JointPDF.GetPointer();
+  }
+
+
+  double GetAlpha( void ) const
+  {
+    return this->m_Alpha;
+  }
+
+
+protected:
+
+  ParzenWindowHistogramThreadingTestMetric() {}
+  virtual ~ParzenWindowHistogramThreadingTestMetric() {}
+
+private:
+
+  ParzenWindowHistogramThreadingTestMetric( const Self & ); // purposely not implemented
+  void operator=( const Self & );                           // purposely not implemented
+
+};
+
+} // end namespace itk
+
+const unsigned int Dimension = 2;
+typedef float                              PixelType;
+typedef itk::Image< PixelType, Dimension > ImageType;
+typedef itk::ParzenWindowHistogramThreadingTestMetric<
+  ImageType, ImageType >                   MetricType;
+typedef MetricType::JointPDFType           JointPDFType;
+
+/**
+ * Create an image of two blobs, translated by the given vector.
+ */
+
+ImageType::Pointer
+CreateImage( const double * translation )
+{
+  ImageType::SizeType size;
+  size.Fill( 64 );
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    ImageType::PointType point;
+    image->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    const double x  = point[ 0 ] - translation[ 0 ];
+    const double y  = point[ 1 ] - translation[ 1 ];
+    const double r1 = ( x - 28.0 ) * ( x - 28.0 ) + ( y - 30.0 ) * ( y - 30.0 );
+    const double r2 = ( x - 38.0 ) * ( x - 38.0 ) / 2.0 + ( y - 36.0 ) * ( y - 36.0 );
+    it.Set( static_cast< PixelType >( 100.0 * std::exp( -r1 / 60.0 )
+      + 60.0 * std::exp( -r2 / 30.0 ) + 0.1 * x ) );
+  }
+
+  return image;
+
+} // end CreateImage()
+
+
+/**
+ * Compare the single- and multi-threaded joint histogram for a number of
+ * threads and histogram bins.
+ */
+
+int
+CompareJointHistograms( ImageType * fixedImage, ImageType * movingImage,
+  const unsigned int numberOfThreads, const unsigned long numberOfFixedBins,
+  const unsigned long numberOfMovingBins )
+{
+  typedef itk::AdvancedTranslationTransform< double, Dimension >            TranslationTransformType;
+  typedef itk::AdvancedCombinationTransform< double, Dimension >            CombinationTransformType;
+  typedef itk::BSplineInterpolateImageFunction< ImageType, double, double > InterpolatorType;
+  typedef itk::ImageFullSampler< ImageType >                                SamplerType;
+  typedef itk::HardLimiterFunction< double, Dimension >                     LimiterType;
+
+  const double tolerance = 1e-10;
+
+  TranslationTransformType::Pointer translation = TranslationTransformType::New();
+  CombinationTransformType::Pointer transform   = CombinationTransformType::New();
+  transform->SetCurrentTransform( translation );
+
+  InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  interpolator->SetSplineOrder( 3 );
+
+  MetricType::Pointer metric = MetricType::New();
+  metric->SetFixedImage( fixedImage );
+  metric->SetMovingImage( movingImage );
+  metric->SetFixedImageRegion( fixedImage->GetBufferedRegion() );
+  metric->SetTransform( transform );
+  metric->SetInterpolator( interpolator );
+  metric->SetImageSampler( SamplerType::New() );
+  metric->SetFixedImageLimiter( LimiterType::New() );
+  metric->SetMovingImageLimiter( LimiterType::New() );
+  metric->SetNumberOfFixedHistogramBins( numberOfFixedBins );
+  metric->SetNumberOfMovingHistogramBins( numberOfMovingBins );
+  metric->SetUseMultiThread( true );
+  metric->SetNumberOfThreads( numberOfThreads );
+  metric->Initialize();
+
+  MetricType::ParametersType parameters( transform->GetNumberOfParameters() );
+  parameters[ 0 ] = 1.5;
+  parameters[ 1 ] = -0.7;
+
+  /** The single-threaded joint histogram. */
+  metric->ComputeJointHistogram( parameters, false );
+  JointPDFType::Pointer serialHistogram = JointPDFType::New();
+  serialHistogram->SetRegions( metric->GetJointHistogram()->GetBufferedRegion() );
+  serialHistogram->Allocate();
+  itk::ImageRegionConstIterator< JointPDFType > copyIt(
+    metric->GetJointHistogram(), serialHistogram->GetBufferedRegion() );
+  itk::ImageRegionIterator< JointPDFType > serialIt(
+    serialHistogram, serialHistogram->GetBufferedRegion() );
+  for( ; !copyIt.IsAtEnd(); ++copyIt, ++serialIt )
+  {
+    serialIt.Set( copyIt.Get() );
+  }
+  const double serialAlpha = metric->GetAlpha();
+
+  /** The merged multi-threaded joint histogram. */
+  metric->ComputeJointHistogram( parameters, true );
+  const JointPDFType * threadedHistogram = metric->GetJointHistogram();
+  const double         threadedAlpha     = metric->GetAlpha();
+
+  std::cout << numberOfThreads << " threads, " << numberOfFixedBins << " x "
+            << numberOfMovingBins << " bins: alpha " << serialAlpha
+            << " (serial), " << threadedAlpha << " (threaded)" << std::endl;
+
+  if( serialAlpha != threadedAlpha )
+  {
+    std::cerr << "ERROR: the number of samples of the threaded histogram differs." << std::endl;
+    return 1;
+  }
+  if( threadedHistogram->GetBufferedRegion() != serialHistogram->GetBufferedRegion() )
+  {
+    std::cerr << "ERROR: the threaded histogram has another size." << std::endl;
+    return 1;
+  }
+
+  itk::ImageRegionConstIterator< JointPDFType > threadedIt(
+    threadedHistogram, threadedHistogram->GetBufferedRegion() );
+  double maximum       = 0.0;
+  double maxDifference = 0.0;
+  double total         = 0.0;
+  for( serialIt.GoToBegin(); !serialIt.IsAtEnd(); ++serialIt, ++threadedIt )
+  {
+    maximum       = std::max( maximum, std::abs( static_cast< double >( serialIt.Get() ) ) );
+    maxDifference = std::max( maxDifference,
+      std::abs( static_cast< double >( serialIt.Get() - threadedIt.Get() ) ) );
+    total        += serialIt.Get();
+  }
+
+  if( total == 0.0 )
+  {
+    std::cerr << "ERROR: the histogram is empty, so the test is meaningless." << std::endl;
+    return 1;
+  }
+  if( maxDifference > tolerance * maximum )
+  {
+    std::cerr << "ERROR: the threaded histogram differs from the serial histogram by "
+              << maxDifference << " (maximum bin " << maximum << ")." << std::endl;
+    return 1;
+  }
+
+  return 0;
+
+} // end CompareJointHistograms()
+
+
+int
+main( int argc, char * argv[] )
+{
+  const double translation[ Dimension ] = { 2.0, -1.0 };
+  const double zero[ Dimension ]        = { 0.0, 0.0 };
+
+  ImageType::Pointer fixedImage  = CreateImage( zero );
+  ImageType::Pointer movingImage = CreateImage( translation );
+
+  int result = 0;
+  try
+  {
+    result |= CompareJointHistograms( fixedImage, movingImage, 1, 32, 32 );
+    result |= CompareJointHistograms( fixedImage, movingImage, 3, 27, 32 );
+    result |= CompareJointHistograms( fixedImage, movingImage, 4, 31, 29 );
+    result |= CompareJointHistograms( fixedImage, movingImage, 5, 32, 17 );
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: " << excp << std::endl;
+    return 1;
+  }
+
+  /** Return a value. */
+  return result;
+
+} // end main
@@ -0,0 +1,245 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "GradientDifference/itkGradientDifferenceImageToImageMetric2.h"
+#include "NormalizedGradientCorrelation/itkNormalizedGradientCorrelationImageToImageMetric.h"
+#include "PatternIntensity/itkPatternIntensityImageToImageMetric.h"
+
+#include "itkAdvancedCombinationTransform.h"
+#include "itkAdvancedEuler3DTransform.h"
+#include "itkAdvancedRayCastInterpolateImageFunction.h"
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkResampleImageFilter.h"
+
+#include <cmath>
+#include <iostream>
+
+//-------------------------------------------------------------------------------------
+// This test checks that the analytic derivatives of the 2D-3D metrics
+// GradientDifference, NormalizedGradientCorrelation and PatternIntensity
+// agree with their finite difference derivatives. The analytic derivative
+// samples the rays and treats some normalization factors as constants, so
+// the derivatives are compared with a relative tolerance.
+
+const unsigned int Dimension = 3;
+typedef float                                                             PixelType;
+typedef itk::Image< PixelType, Dimension >                                ImageType;
+typedef itk::AdvancedEuler3DTransform< double >                           EulerTransformType;
+typedef itk::AdvancedCombinationTransform< double, Dimension >            CombinationTransformType;
+typedef itk::AdvancedRayCastInterpolateImageFunction< ImageType, double > RayCastInterpolatorType;
+typedef CombinationTransformType::ParametersType                          ParametersType;
+
+/**
+ * Compare the analytic and finite difference derivative of a metric.
+ */
+
+template< class TMetric >
+int
+TestMetricDerivative( const char * name, TMetric * metric,
+  ImageType * fixedImage, ImageType * movingImage,
+  CombinationTransformType * transform, RayCastInterpolatorType * rayCaster,
+  const ParametersType & parameters, const double tolerance )
+{
+  typedef typename TMetric::MeasureType    MeasureType;
+  typedef typename TMetric::DerivativeType DerivativeType;
+  typedef typename TMetric::ScalesType     ScalesType;
+
+  /** The scales determine the finite difference step per parameter:
+   * small steps for the rotations, larger steps for the translations.
+   */
+  ScalesType scales( parameters.GetSize() );
+  for( unsigned int i = 0; i < parameters.GetSize(); ++i )
+  {
+    scales[ i ] = i < 3 ? 1.0e2 : 1.0e-4;
+  }
+
+  transform->SetParameters( parameters );
+  metric->SetFixedImage( fixedImage );
+  metric->SetMovingImage( movingImage );
+  metric->SetTransform( transform );
+  metric->SetInterpolator( rayCaster );
+  metric->SetFixedImageRegion( fixedImage->GetBufferedRegion() );
+  metric->SetScales( scales );
+
+  try
+  {
+    metric->Initialize();
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: " << name << " could not be initialized.\n" << excp << std::endl;
+    return 1;
+  }
+
+  /** The analytic derivative. */
+  MeasureType    value = 0.0;
+  DerivativeType analyticDerivative;
+  metric->SetUseFiniteDifferenceDerivative( false );
+  metric->GetValueAndDerivative( parameters, value, analyticDerivative );
+
+  /** The finite difference derivative. */
+  DerivativeType finiteDifferenceDerivative;
+  metric->SetUseFiniteDifferenceDerivative( true );
+  metric->GetDerivative( parameters, finiteDifferenceDerivative );
+
+  if( analyticDerivative.GetSize() != finiteDifferenceDerivative.GetSize() )
+  {
+    std::cerr << "ERROR: the derivatives of " << name
+              << " have different sizes." << std::endl;
+    return 1;
+  }
+
+  /** Compare the derivatives, relative to the size of the derivative. */
+  double differenceNorm = 0.0;
+  double norm           = 0.0;
+  for( unsigned int i = 0; i < analyticDerivative.GetSize(); ++i )
+  {
+    const double difference = analyticDerivative[ i ] - finiteDifferenceDerivative[ i ];
+    differenceNorm += difference * difference;
+    norm           += finiteDifferenceDerivative[ i ] * finiteDifferenceDerivative[ i ];
+  }
+  differenceNorm = std::sqrt( differenceNorm );
+  norm           = std::sqrt( norm );
+
+  std::cout << name << ":\n"
+            << "  value:                        " << value << "\n"
+            << "  analytic derivative:          " << analyticDerivative << "\n"
+            << "  finite difference derivative: " << finiteDifferenceDerivative << std::endl;
+
+  if( norm == 0.0 )
+  {
+    std::cerr << "ERROR: the finite difference derivative of " << name
+              << " is zero, so the test is meaningless." << std::endl;
+    return 1;
+  }
+  if( differenceNorm > tolerance * norm )
+  {
+    std::cerr << "ERROR: the analytic derivative of " << name
+              << " differs from the finite difference derivative by "
+              << differenceNorm / norm << " (relative)." << std::endl;
+    return 1;
+  }
+
+  return 0;
+
+} // end TestMetricDerivative()
+
+
+int
+main( int argc, char * argv[] )
+{
+  /** Some basic type definitions. */
+  typedef itk::ResampleImageFilter< ImageType, ImageType > ResampleFilterType;
+  typedef itk::GradientDifferenceImageToImageMetric< ImageType, ImageType >            GDMetricType;
+  typedef itk::NormalizedGradientCorrelationImageToImageMetric< ImageType, ImageType > NGCMetricType;
+  typedef itk::PatternIntensityImageToImageMetric< ImageType, ImageType >              PIMetricType;
+
+  const double tolerance = 0.1;
+
+  /** A moving volume of two smooth, asymmetric blobs around the origin. */
+  ImageType::SizeType volumeSize;
+  volumeSize.Fill( 24 );
+  ImageType::SpacingType volumeSpacing;
+  volumeSpacing.Fill( 2.0 );
+  ImageType::PointType volumeOrigin;
+  volumeOrigin.Fill( -23.0 );
+
+  ImageType::Pointer movingImage = ImageType::New();
+  movingImage->SetRegions( volumeSize );
+  movingImage->SetSpacing( volumeSpacing );
+  movingImage->SetOrigin( volumeOrigin );
+  movingImage->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it(
+    movingImage, movingImage->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    ImageType::PointType point;
+    movingImage->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    const double r1 = ( point[ 0 ] - 4.0 ) * ( point[ 0 ] - 4.0 )
+      + ( point[ 1 ] + 3.0 ) * ( point[ 1 ] + 3.0 ) + ( point[ 2 ] - 2.0 ) * ( point[ 2 ] - 2.0 );
+    const double r2 = ( point[ 0 ] + 7.0 ) * ( point[ 0 ] + 7.0 ) / 4.0
+      + ( point[ 1 ] - 6.0 ) * ( point[ 1 ] - 6.0 ) + point[ 2 ] * point[ 2 ] / 2.0;
+    it.Set( static_cast< PixelType >( 10.0 * std::exp( -r1 / 50.0 )
+      + 6.0 * std::exp( -r2 / 20.0 ) ) );
+  }
+
+  /** A detector plane behind the volume, opposite to the focal point. */
+  ImageType::SizeType projectionSize;
+  projectionSize[ 0 ] = 32; projectionSize[ 1 ] = 32; projectionSize[ 2 ] = 1;
+  ImageType::SpacingType projectionSpacing;
+  projectionSpacing.Fill( 2.0 );
+  ImageType::PointType projectionOrigin;
+  projectionOrigin[ 0 ] = -31.0; projectionOrigin[ 1 ] = -31.0; projectionOrigin[ 2 ] = 100.0;
+
+  RayCastInterpolatorType::InputPointType focalPoint;
+  focalPoint[ 0 ] = 0.0; focalPoint[ 1 ] = 0.0; focalPoint[ 2 ] = -400.0;
+
+  /** The transform, as set up by elastix for the ray caster. */
+  EulerTransformType::Pointer eulerTransform = EulerTransformType::New();
+  EulerTransformType::InputPointType center;
+  center.Fill( 0.0 );
+  eulerTransform->SetCenter( center );
+  CombinationTransformType::Pointer transform = CombinationTransformType::New();
+  transform->SetCurrentTransform( eulerTransform );
+
+  RayCastInterpolatorType::Pointer rayCaster = RayCastInterpolatorType::New();
+  rayCaster->SetTransform( transform );
+  rayCaster->SetFocalPoint( focalPoint );
+  rayCaster->SetThreshold( 0.0 );
+  rayCaster->SetInputImage( movingImage );
+
+  /** The fixed image is the projection at the identity transform. */
+  ParametersType parameters( transform->GetNumberOfParameters() );
+  parameters.Fill( 0.0 );
+  transform->SetParameters( parameters );
+
+  ResampleFilterType::Pointer projector = ResampleFilterType::New();
+  projector->SetInput( movingImage );
+  projector->SetTransform( transform );
+  projector->SetInterpolator( rayCaster );
+  projector->SetSize( projectionSize );
+  projector->SetOutputSpacing( projectionSpacing );
+  projector->SetOutputOrigin( projectionOrigin );
+  projector->SetDefaultPixelValue( 0 );
+  projector->Update();
+  ImageType::Pointer fixedImage = projector->GetOutput();
+  fixedImage->DisconnectPipeline();
+
+  /** Evaluate the derivatives away from the optimum. */
+  parameters[ 0 ] = 0.02; parameters[ 1 ] = -0.03; parameters[ 2 ] = 0.04;
+  parameters[ 3 ] = 1.5; parameters[ 4 ] = -1.0; parameters[ 5 ] = 2.0;
+
+  int result = 0;
+
+  GDMetricType::Pointer gdMetric = GDMetricType::New();
+  result |= TestMetricDerivative( "GradientDifference", gdMetric.GetPointer(),
+    fixedImage, movingImage, transform, rayCaster, parameters, tolerance );
+
+  NGCMetricType::Pointer ngcMetric = NGCMetricType::New();
+  result |= TestMetricDerivative( "NormalizedGradientCorrelation", ngcMetric.GetPointer(),
+    fixedImage, movingImage, transform, rayCaster, parameters, tolerance );
+
+  PIMetricType::Pointer piMetric = PIMetricType::New();
+  result |= TestMetricDerivative( "PatternIntensity", piMetric.GetPointer(),
+    fixedImage, movingImage, transform, rayCaster, parameters, tolerance );
+
+  /** Return a value. */
+  return result;
+
+} // end main
@@ -22,6 +22,8 @@
 #include "itkTimeProbe.h"
 #include "itkTimeProbesCollectorBase.h"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iomanip>
 
@@ -369,6 +371,172 @@ main( int argc, char * argv[] )
 
   } // end loop
 
+  //
+  // Test the iterative solver and the evaluation grid, which are meant
+  // for large numbers of landmarks.
+
+  typedef itk::ThinPlateSplineKernelTransform2<
+    ScalarType, Dimension >                             TPSTransformType;
+  typedef TPSTransformType::InputPointType TPSPointType;
+
+  const unsigned long numberOfComparedLandmarks = 500;
+  const ScalarType    solverTolerance           = 1e-4; // in mm
+  const double        gridTolerance             = 0.1;  // in mm
+  const unsigned long numberOfTestPoints        = 1000;
+
+  /** Move all landmarks with a smooth displacement field. */
+  const unsigned long    realNumberOfLandmarks = sourceLandmarks->GetNumberOfPoints();
+  PointsContainerPointer allTargetPoints       = PointsContainerType::New();
+  PointSetType::Pointer  allTargets            = PointSetType::New();
+  TPSPointType           minimum, maximum;
+  for( unsigned long j = 0; j < realNumberOfLandmarks; j++ )
+  {
+    PointType source = ( *sourceLandmarks->GetPoints() )[ j ];
+    PointType target;
+    for( unsigned int d = 0; d < Dimension; d++ )
+    {
+      target[ d ]  = source[ d ] + 3.0 * std::sin( source[ ( d + 1 ) % Dimension ] / 40.0 );
+      minimum[ d ] = ( j == 0 ) ? source[ d ] : std::min( minimum[ d ], source[ d ] );
+      maximum[ d ] = ( j == 0 ) ? source[ d ] : std::max( maximum[ d ], source[ d ] );
+    }
+    allTargetPoints->push_back( target );
+  }
+  allTargets->SetPoints( allTargetPoints );
+
+  /** Random test points in the bounding box of the landmarks. */
+  vnl_sample_reseed( 1234 );
+  std::vector< TPSPointType > testPoints( numberOfTestPoints );
+  for( unsigned long k = 0; k < numberOfTestPoints; k++ )
+  {
+    for( unsigned int d = 0; d < Dimension; d++ )
+    {
+      testPoints[ k ][ d ] = vnl_sample_uniform( minimum[ d ], maximum[ d ] );
+    }
+  }
+
+  /** Compare the iterative solver with QR on a subset of the landmarks. */
+  {
+    std::cerr << "----------------------------------------\n";
+    std::cerr << "Iterative solver versus QR, number of landmarks: "
+              << numberOfComparedLandmarks << std::endl;
+    itk::TimeProbesCollectorBase timeCollector;
+
+    PointsContainerPointer sourcePoints = PointsContainerType::New();
+    PointsContainerPointer targetPoints = PointsContainerType::New();
+    for( unsigned long j = 0; j < numberOfComparedLandmarks; j++ )
+    {
+      sourcePoints->push_back( ( *sourceLandmarks->GetPoints() )[ j ] );
+      targetPoints->push_back( ( *allTargets->GetPoints() )[ j ] );
+    }
+    PointSetType::Pointer sources = PointSetType::New();
+    PointSetType::Pointer targets = PointSetType::New();
+    sources->SetPoints( sourcePoints );
+    targets->SetPoints( targetPoints );
+
+    TPSTransformType::Pointer qrTransform = TPSTransformType::New();
+    qrTransform->SetMatrixInversionMethod( "QR" );
+    timeCollector.Start( "SolveByQR" );
+    qrTransform->SetSourceLandmarks( sources );
+    qrTransform->SetTargetLandmarks( targets );
+    timeCollector.Stop( "SolveByQR" );
+
+    TPSTransformType::Pointer iterativeTransform = TPSTransformType::New();
+    iterativeTransform->SetMatrixInversionMethod( "Iterative" );
+    iterativeTransform->SetIterativeSolverTolerance( 1e-10 );
+    timeCollector.Start( "SolveIteratively" );
+    iterativeTransform->SetSourceLandmarks( sources );
+    iterativeTransform->SetTargetLandmarks( targets );
+    timeCollector.Stop( "SolveIteratively" );
+
+    std::cerr << "Iterations: "
+              << iterativeTransform->GetNumberOfIterativeSolverIterations()
+              << ", relative residual: "
+              << iterativeTransform->GetIterativeSolverResidual() << std::endl;
+
+    double maximumDifference = 0.0;
+    for( unsigned long k = 0; k < numberOfTestPoints; k++ )
+    {
+      maximumDifference = std::max( maximumDifference,
+        qrTransform->TransformPoint( testPoints[ k ] ).EuclideanDistanceTo(
+        iterativeTransform->TransformPoint( testPoints[ k ] ) ) );
+    }
+    std::cerr << "Maximum difference of the transformed points: "
+              << maximumDifference << std::endl;
+    if( maximumDifference > solverTolerance )
+    {
+      std::cerr << "ERROR: the iterative solver differs too much from QR: "
+                << maximumDifference << std::endl;
+      return 1;
+    }
+
+    timeCollector.Report();
+    std::cout << std::endl;
+  }
+
+  /** Benchmark the iterative solver and the evaluation grid on all landmarks. */
+  {
+    std::cerr << "----------------------------------------\n";
+    std::cerr << "Iterative solver and evaluation grid, number of landmarks: "
+              << realNumberOfLandmarks << std::endl;
+    itk::TimeProbesCollectorBase timeCollector;
+
+    TPSTransformType::Pointer transform = TPSTransformType::New();
+    transform->SetMatrixInversionMethod( "Iterative" );
+    timeCollector.Start( "SolveIteratively" );
+    transform->SetSourceLandmarks( sourceLandmarks );
+    transform->SetTargetLandmarks( allTargets );
+    timeCollector.Stop( "SolveIteratively" );
+
+    std::cerr << "Iterations: "
+              << transform->GetNumberOfIterativeSolverIterations()
+              << ", relative residual: "
+              << transform->GetIterativeSolverResidual() << std::endl;
+
+    /** Exact evaluation. */
+    std::vector< TPSPointType > exactPoints( numberOfTestPoints );
+    timeCollector.Start( "TransformPointExact" );
+    for( unsigned long k = 0; k < numberOfTestPoints; k++ )
+    {
+      exactPoints[ k ] = transform->TransformPoint( testPoints[ k ] );
+    }
+    timeCollector.Stop( "TransformPointExact" );
+
+    /** Evaluation on the grid. */
+    transform->SetEvaluationGridRegion( minimum, maximum );
+    transform->SetEvaluationGridTolerance( gridTolerance );
+    timeCollector.Start( "ComputeEvaluationGrid" );
+    const bool gridUsed = transform->ComputeEvaluationGrid();
+    timeCollector.Stop( "ComputeEvaluationGrid" );
+    if( !gridUsed )
+    {
+      std::cerr << "ERROR: the evaluation grid could not reach the tolerance, "
+                << "estimated error: " << transform->GetEvaluationGridError() << std::endl;
+      return 1;
+    }
+    std::cerr << "Grid spacing: " << transform->GetEvaluationGridSpacing()
+              << ", estimated error: " << transform->GetEvaluationGridError() << std::endl;
+
+    double maximumError = 0.0;
+    timeCollector.Start( "TransformPointGrid" );
+    for( unsigned long k = 0; k < numberOfTestPoints; k++ )
+    {
+      maximumError = std::max( maximumError,
+        exactPoints[ k ].EuclideanDistanceTo( transform->TransformPoint( testPoints[ k ] ) ) );
+    }
+    timeCollector.Stop( "TransformPointGrid" );
+
+    std::cerr << "Maximum error of the evaluation grid: " << maximumError << std::endl;
+    if( maximumError > gridTolerance )
+    {
+      std::cerr << "ERROR: the error of the evaluation grid is too big: "
+                << maximumError << std::endl;
+      return 1;
+    }
+
+    timeCollector.Report();
+    std::cout << std::endl;
+  }
+
   /** Return a value. */
   return 0;
 
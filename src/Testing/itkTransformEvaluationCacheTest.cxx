@@ -0,0 +1,295 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "AdvancedMattesMutualInformation/itkParzenWindowMutualInformationImageToImageMetric.h"
+#include "MultiMetricMultiResolutionRegistration/itkCombinationImageToImageMetric.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkAdvancedCombinationTransform.h"
+#include "itkBSplineInterpolateImageFunction.h"
+#include "itkHardLimiterFunction.h"
+#include "itkImage.h"
+#include "itkImageFullSampler.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+//-------------------------------------------------------------------------------------
+// This test checks that two Mattes mutual information metrics, which share
+// one image sampler in a CombinationImageToImageMetric, give the same value
+// and derivative with a shared TransformEvaluationCache as without it. It
+// also checks a cache that is too small to store all samples, in which case
+// the other samples are mapped as usual.
+
+const unsigned int Dimension = 2;
+typedef float                                                              PixelType;
+typedef itk::Image< PixelType, Dimension >                                 ImageType;
+typedef itk::CombinationImageToImageMetric< ImageType, ImageType >         CombinationMetricType;
+typedef itk::ParzenWindowMutualInformationImageToImageMetric<
+  ImageType, ImageType >                                                   MattesMetricType;
+typedef itk::AdvancedBSplineDeformableTransform< double, Dimension, 3 >    BSplineTransformType;
+typedef itk::AdvancedCombinationTransform< double, Dimension >             CombinationTransformType;
+typedef itk::BSplineInterpolateImageFunction< ImageType, double, double >  InterpolatorType;
+typedef itk::ImageFullSampler< ImageType >                                 SamplerType;
+typedef itk::HardLimiterFunction< double, Dimension >                      LimiterType;
+typedef CombinationMetricType::ParametersType                              ParametersType;
+typedef CombinationMetricType::MeasureType                                 MeasureType;
+typedef CombinationMetricType::DerivativeType                              DerivativeType;
+
+/**
+ * Create an image of two blobs, translated by the given vector.
+ */
+
+ImageType::Pointer
+CreateImage( const double * translation )
+{
+  ImageType::SizeType size;
+  size.Fill( 64 );
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    ImageType::PointType point;
+    image->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    const double x  = point[ 0 ] - translation[ 0 ];
+    const double y  = point[ 1 ] - translation[ 1 ];
+    const double r1 = ( x - 28.0 ) * ( x - 28.0 ) + ( y - 30.0 ) * ( y - 30.0 );
+    const double r2 = ( x - 38.0 ) * ( x - 38.0 ) / 2.0 + ( y - 36.0 ) * ( y - 36.0 );
+    it.Set( static_cast< PixelType >( 100.0 * std::exp( -r1 / 60.0 )
+      + 60.0 * std::exp( -r2 / 30.0 ) + 0.1 * x ) );
+  }
+
+  return image;
+
+} // end CreateImage()
+
+
+/**
+ * Create a Mattes mutual information metric.
+ */
+
+MattesMetricType::Pointer
+CreateMattesMetric( SamplerType * sampler, const unsigned long numberOfBins,
+  const bool useCache )
+{
+  MattesMetricType::Pointer metric = MattesMetricType::New();
+  metric->SetImageSampler( sampler );
+  metric->SetFixedImageLimiter( LimiterType::New() );
+  metric->SetMovingImageLimiter( LimiterType::New() );
+  metric->SetNumberOfFixedHistogramBins( numberOfBins );
+  metric->SetNumberOfMovingHistogramBins( numberOfBins );
+  metric->SetUseExplicitPDFDerivatives( false );
+  metric->SetUseMultiThread( true );
+  metric->SetUseTransformEvaluationCache( useCache );
+
+  return metric;
+
+} // end CreateMattesMetric()
+
+
+/**
+ * Create a combination of two Mattes metrics with one sampler, and with
+ * its own transform.
+ */
+
+CombinationMetricType::Pointer
+CreateMetric( ImageType * fixedImage, ImageType * movingImage, const bool useCache )
+{
+  /** A B-spline transform that covers the images. */
+  BSplineTransformType::Pointer bsplineTransform = BSplineTransformType::New();
+  BSplineTransformType::SizeType gridSize;
+  gridSize.Fill( 10 );
+  BSplineTransformType::RegionType gridRegion;
+  gridRegion.SetSize( gridSize );
+  BSplineTransformType::SpacingType gridSpacing;
+  gridSpacing.Fill( 10.0 );
+  BSplineTransformType::OriginType gridOrigin;
+  gridOrigin.Fill( -15.0 );
+  BSplineTransformType::DirectionType gridDirection;
+  gridDirection.SetIdentity();
+  bsplineTransform->SetGridOrigin( gridOrigin );
+  bsplineTransform->SetGridSpacing( gridSpacing );
+  bsplineTransform->SetGridRegion( gridRegion );
+  bsplineTransform->SetGridDirection( gridDirection );
+  bsplineTransform->SetIdentity();
+
+  CombinationTransformType::Pointer transform = CombinationTransformType::New();
+  transform->SetCurrentTransform( bsplineTransform );
+
+  InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  interpolator->SetSplineOrder( 3 );
+
+  SamplerType::Pointer sampler = SamplerType::New();
+
+  CombinationMetricType::Pointer combination = CombinationMetricType::New();
+  combination->SetNumberOfMetrics( 2 );
+  combination->SetMetric( CreateMattesMetric( sampler, 32, useCache ), 0 );
+  combination->SetMetric( CreateMattesMetric( sampler, 21, useCache ), 1 );
+  combination->SetMetricWeight( 1.0, 0 );
+  combination->SetMetricWeight( 0.5, 1 );
+  combination->SetFixedImage( fixedImage );
+  combination->SetMovingImage( movingImage );
+  combination->SetFixedImageRegion( fixedImage->GetBufferedRegion() );
+  combination->SetTransform( transform );
+  combination->SetInterpolator( interpolator );
+  combination->SetUseMultiThread( true );
+  combination->SetNumberOfThreads( 4 );
+  combination->Initialize();
+
+  return combination;
+
+} // end CreateMetric()
+
+
+/**
+ * Compare the value and derivative of the cached and uncached metrics.
+ */
+
+int
+CompareMetrics( const CombinationMetricType * uncachedMetric,
+  const CombinationMetricType * cachedMetric, const ParametersType & parameters )
+{
+  const double tolerance = 1e-10;
+
+  MeasureType    uncachedValue = 0.0;
+  MeasureType    cachedValue   = 0.0;
+  DerivativeType uncachedDerivative;
+  DerivativeType cachedDerivative;
+  uncachedMetric->GetValueAndDerivative( parameters, uncachedValue, uncachedDerivative );
+  cachedMetric->GetValueAndDerivative( parameters, cachedValue, cachedDerivative );
+
+  std::cout << "value " << uncachedValue << " (uncached), " << cachedValue
+            << " (cached)" << std::endl;
+
+  int result = 0;
+  for( unsigned int m = 0; m < 2; ++m )
+  {
+    const MeasureType uncached = uncachedMetric->GetMetricValue( m );
+    const MeasureType cached   = cachedMetric->GetMetricValue( m );
+    if( std::abs( uncached - cached ) > tolerance * std::abs( uncached ) )
+    {
+      std::cerr << "ERROR: the cached value of metric " << m << " is " << cached
+                << " instead of " << uncached << "." << std::endl;
+      result = 1;
+    }
+  }
+
+  double maximum       = 0.0;
+  double maxDifference = 0.0;
+  for( unsigned int i = 0; i < uncachedDerivative.GetSize(); ++i )
+  {
+    maximum       = std::max( maximum, std::abs( uncachedDerivative[ i ] ) );
+    maxDifference = std::max( maxDifference,
+      std::abs( uncachedDerivative[ i ] - cachedDerivative[ i ] ) );
+  }
+  if( maximum == 0.0 )
+  {
+    std::cerr << "ERROR: the derivative is zero, so the test is meaningless." << std::endl;
+    result = 1;
+  }
+  if( maxDifference > tolerance * maximum )
+  {
+    std::cerr << "ERROR: the cached derivative differs by " << maxDifference
+              << " (maximum " << maximum << ")." << std::endl;
+    result = 1;
+  }
+
+  return result;
+
+} // end CompareMetrics()
+
+
+int
+main( int argc, char * argv[] )
+{
+  const double translation[ Dimension ] = { 2.0, -1.0 };
+  const double zero[ Dimension ]        = { 0.0, 0.0 };
+
+  int result = 0;
+  try
+  {
+    ImageType::Pointer fixedImage  = CreateImage( zero );
+    ImageType::Pointer movingImage = CreateImage( translation );
+
+    CombinationMetricType::Pointer uncachedMetric = CreateMetric( fixedImage, movingImage, false );
+    CombinationMetricType::Pointer cachedMetric   = CreateMetric( fixedImage, movingImage, true );
+
+    /** Both metrics should use the same cache. */
+    MattesMetricType * mattes0 = dynamic_cast< MattesMetricType * >( cachedMetric->GetMetric( 0 ) );
+    MattesMetricType * mattes1 = dynamic_cast< MattesMetricType * >( cachedMetric->GetMetric( 1 ) );
+    if( mattes0->GetTransformEvaluationCache() == 0
+      || mattes0->GetTransformEvaluationCache() != mattes1->GetTransformEvaluationCache() )
+    {
+      std::cerr << "ERROR: the metrics do not share a transform evaluation cache." << std::endl;
+      return 1;
+    }
+
+    /** A shared sampler does not allow the concurrent evaluation. */
+    if( cachedMetric->GetEvaluateMetricsConcurrently() )
+    {
+      std::cerr << "ERROR: metrics with a shared sampler are evaluated concurrently." << std::endl;
+      return 1;
+    }
+
+    ParametersType parameters( uncachedMetric->GetNumberOfParameters() );
+    for( unsigned int k = 0; k < 2; ++k )
+    {
+      for( unsigned int i = 0; i < parameters.GetSize(); ++i )
+      {
+        parameters[ i ] = 1.5 * std::sin( 0.37 * i + k ) + 0.5 * std::cos( 1.3 * i );
+      }
+
+      /** A cache for all samples. */
+      mattes0->GetTransformEvaluationCache()->SetMaximumMemory( 512 * 1024 * 1024 );
+      result |= CompareMetrics( uncachedMetric, cachedMetric, parameters );
+      const unsigned long numberOfSamples = mattes0->GetImageSampler()->GetOutput()->Size();
+      if( mattes0->GetTransformEvaluationCache()->GetNumberOfPoints() != numberOfSamples )
+      {
+        std::cerr << "ERROR: the cache does not hold all samples." << std::endl;
+        result = 1;
+      }
+
+      /** A cache for about a quarter of the samples. */
+      mattes0->GetTransformEvaluationCache()->SetMaximumMemory(
+        numberOfSamples / 4 * sizeof( CombinationTransformType::OutputPointType ) );
+      parameters[ 0 ] += 0.1;
+      result |= CompareMetrics( uncachedMetric, cachedMetric, parameters );
+      const unsigned long numberOfPoints = mattes0->GetTransformEvaluationCache()->GetNumberOfPoints();
+      if( numberOfPoints == 0 || numberOfPoints >= numberOfSamples )
+      {
+        std::cerr << "ERROR: the small cache holds " << numberOfPoints
+                  << " of " << numberOfSamples << " samples." << std::endl;
+        result = 1;
+      }
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: " << excp << std::endl;
+    return 1;
+  }
+
+  /** Return a value. */
+  return result;
+
+} // end main
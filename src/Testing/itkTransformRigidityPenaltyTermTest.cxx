@@ -0,0 +1,454 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "RigidityPenalty/itkTransformRigidityPenaltyTerm.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkAdvancedCombinationTransform.h"
+#include "itkBSplineInterpolateImageFunction.h"
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+// This test checks the value and derivative of GetValueAndDerivative() of the
+// TransformRigidityPenaltyTerm, which are only computed in the bounding region
+// of the non-zero rigidity coefficients, against the formula of the penalty
+// term evaluated on the full B-spline grid. The reference filters the
+// coefficient images with the 1D operators and the condition parts with the
+// ND operators of the penalty term, with a zero-flux Neumann boundary
+// condition, as the original full-grid implementation did. One rigid region
+// touches the border of the grid, the other one is inside the grid. The
+// metric is evaluated single-threaded and with several numbers of threads.
+
+const unsigned int Dimension = 2;
+typedef float                                                              PixelType;
+typedef itk::Image< PixelType, Dimension >                                 ImageType;
+typedef itk::TransformRigidityPenaltyTerm< ImageType, double >             MetricType;
+typedef MetricType::RigidityImageType                                      RigidityImageType;
+typedef itk::AdvancedBSplineDeformableTransform< double, Dimension, 3 >    BSplineTransformType;
+typedef itk::AdvancedCombinationTransform< double, Dimension >             CombinationTransformType;
+typedef itk::BSplineInterpolateImageFunction< ImageType, double, double >  InterpolatorType;
+typedef MetricType::ParametersType                                         ParametersType;
+typedef MetricType::MeasureType                                            MeasureType;
+typedef MetricType::DerivativeType                                         DerivativeType;
+
+/** The B-spline grid. */
+const unsigned int GridSize[ Dimension ]    = { 14, 12 };
+const double       GridSpacing[ Dimension ] = { 4.0, 3.0 };
+const double       GridOrigin[ Dimension ]  = { -6.0, -4.0 };
+
+/** The weights of the conditions. */
+const double LinearityConditionWeight      = 2.0;
+const double OrthonormalityConditionWeight = 0.5;
+const double PropernessConditionWeight     = 3.0;
+
+/**
+ * The rigidity coefficient of a grid point: a region at the corner of the
+ * grid, which touches its border, and a region with varying coefficients
+ * inside the grid. The other coefficients are zero.
+ */
+
+double
+GetRigidityCoefficient( const unsigned int x, const unsigned int y )
+{
+  if( x <= 3 && y <= 4 )
+  {
+    return 1.0;
+  }
+  if( x >= 7 && x <= 10 && y >= 6 && y <= 9 )
+  {
+    return 0.5 + 0.1 * ( x - 7 );
+  }
+  return 0.0;
+
+} // end GetRigidityCoefficient()
+
+
+/**
+ * The index of a neighbor of a grid point, clamped to the grid, which
+ * gives the zero-flux Neumann boundary condition.
+ */
+
+unsigned int
+ClampIndex( const int index, const unsigned int size )
+{
+  return static_cast< unsigned int >(
+    std::min( std::max( index, 0 ), static_cast< int >( size ) - 1 ) );
+
+} // end ClampIndex()
+
+
+/**
+ * Filter an image on the grid with the separable 3 x 3 kernel kx * ky.
+ */
+
+void
+FilterSeparable( const double * input, const double * kx, const double * ky,
+  std::vector< double > & output )
+{
+  const unsigned int nx = GridSize[ 0 ];
+  const unsigned int ny = GridSize[ 1 ];
+
+  output.assign( nx * ny, 0.0 );
+  for( unsigned int y = 0; y < ny; ++y )
+  {
+    for( unsigned int x = 0; x < nx; ++x )
+    {
+      double sum = 0.0;
+      for( int b = -1; b <= 1; ++b )
+      {
+        const unsigned int yb = ClampIndex( static_cast< int >( y ) + b, ny );
+        double             row = 0.0;
+        for( int a = -1; a <= 1; ++a )
+        {
+          const unsigned int xa = ClampIndex( static_cast< int >( x ) + a, nx );
+          row += kx[ a + 1 ] * input[ yb * nx + xa ];
+        }
+        sum += ky[ b + 1 ] * row;
+      }
+      output[ y * nx + x ] = sum;
+    }
+  }
+
+} // end FilterSeparable()
+
+
+/**
+ * Compute the value and derivative of the rigidity penalty term on the
+ * full grid.
+ */
+
+MeasureType
+ComputeFullGridPenalty( const ParametersType & parameters,
+  const std::vector< double > & c, DerivativeType & derivative )
+{
+  const unsigned int nx = GridSize[ 0 ];
+  const unsigned int ny = GridSize[ 1 ];
+  const unsigned int n  = nx * ny;
+  const double       s0 = GridSpacing[ 0 ];
+  const double       s1 = GridSpacing[ 1 ];
+
+  /** The 1D operators of the first and second order derivatives. */
+  const double b3[ 3 ]  = { 1.0 / 6.0, 4.0 / 6.0, 1.0 / 6.0 };
+  const double dx[ 3 ]  = { -0.5 / s0, 0.0, 0.5 / s0 };
+  const double dy[ 3 ]  = { -0.5 / s1, 0.0, 0.5 / s1 };
+  const double dxx[ 3 ] = { 0.5 / ( s0 * s0 ), -1.0 / ( s0 * s0 ), 0.5 / ( s0 * s0 ) };
+  const double dyy[ 3 ] = { 0.5 / ( s1 * s1 ), -1.0 / ( s1 * s1 ), 0.5 / ( s1 * s1 ) };
+  const double dxy[ 3 ] = { -0.5 / ( s0 * s1 ), 0.0, 0.5 / ( s0 * s1 ) };
+
+  /** The ND operators, with x running fastest. */
+  const double sxx = s0 * s0;
+  const double syy = s1 * s1;
+  const double sxy = s0 * s1;
+  const double NDA[ 9 ] = {
+    1.0 / 12.0 / s0, 0.0, -1.0 / 12.0 / s0,
+    1.0 / 3.0 / s0,  0.0, -1.0 / 3.0 / s0,
+    1.0 / 12.0 / s0, 0.0, -1.0 / 12.0 / s0 };
+  const double NDB[ 9 ] = {
+    1.0 / 12.0 / s1,  1.0 / 3.0 / s1,  1.0 / 12.0 / s1,
+    0.0,              0.0,             0.0,
+    -1.0 / 12.0 / s1, -1.0 / 3.0 / s1, -1.0 / 12.0 / s1 };
+  const double NDD[ 9 ] = {
+    1.0 / 12.0 / sxx, -1.0 / 6.0 / sxx, 1.0 / 12.0 / sxx,
+    1.0 / 3.0 / sxx,  -2.0 / 3.0 / sxx, 1.0 / 3.0 / sxx,
+    1.0 / 12.0 / sxx, -1.0 / 6.0 / sxx, 1.0 / 12.0 / sxx };
+  const double NDE[ 9 ] = {
+    1.0 / 12.0 / syy, 1.0 / 3.0 / syy,  1.0 / 12.0 / syy,
+    -1.0 / 6.0 / syy, -2.0 / 3.0 / syy, -1.0 / 6.0 / syy,
+    1.0 / 12.0 / syy, 1.0 / 3.0 / syy,  1.0 / 12.0 / syy };
+  const double NDG[ 9 ] = {
+    1.0 / 4.0 / sxy,  0.0, -1.0 / 4.0 / sxy,
+    0.0,              0.0, 0.0,
+    -1.0 / 4.0 / sxy, 0.0, 1.0 / 4.0 / sxy };
+
+  /** Filter the coefficient images. */
+  std::vector< std::vector< double > > FA( Dimension ), FB( Dimension ),
+  FD( Dimension ), FE( Dimension ), FG( Dimension );
+  for( unsigned int i = 0; i < Dimension; ++i )
+  {
+    const double * u = parameters.data_block() + i * n;
+    FilterSeparable( u, dx, b3, FA[ i ] );
+    FilterSeparable( u, b3, dy, FB[ i ] );
+    FilterSeparable( u, dxx, b3, FD[ i ] );
+    FilterSeparable( u, b3, dyy, FE[ i ] );
+    FilterSeparable( u, dxy, dxy, FG[ i ] );
+  }
+
+  /** Compute the conditions and their parts on the full grid. The parts
+   * are indexed by [ dimension ][ operator ][ grid point ].
+   */
+  std::vector< std::vector< std::vector< double > > > OCparts( Dimension ),
+  PCparts( Dimension ), LCparts( Dimension );
+  for( unsigned int i = 0; i < Dimension; ++i )
+  {
+    OCparts[ i ].assign( 2, std::vector< double >( n, 0.0 ) );
+    PCparts[ i ].assign( 2, std::vector< double >( n, 0.0 ) );
+    LCparts[ i ].assign( 3, std::vector< double >( n, 0.0 ) );
+  }
+
+  double sumC = 0.0, valueOC = 0.0, valuePC = 0.0, valueLC = 0.0;
+  for( unsigned int p = 0; p < n; ++p )
+  {
+    const double a1 = 1.0 + FA[ 0 ][ p ];
+    const double a2 = FA[ 1 ][ p ];
+    const double b1 = FB[ 0 ][ p ];
+    const double b2 = 1.0 + FB[ 1 ][ p ];
+
+    /** The orthonormality condition: J^T J = I. */
+    const double o11 = a1 * a1 + a2 * a2 - 1.0;
+    const double o22 = b1 * b1 + b2 * b2 - 1.0;
+    const double o12 = a1 * b1 + a2 * b2;
+    OCparts[ 0 ][ 0 ][ p ] = 4.0 * ( a1 * o11 ) + 2.0 * ( b1 * o12 );
+    OCparts[ 0 ][ 1 ][ p ] = 4.0 * ( b1 * o22 ) + 2.0 * ( a1 * o12 );
+    OCparts[ 1 ][ 0 ][ p ] = 4.0 * ( a2 * o11 ) + 2.0 * ( b2 * o12 );
+    OCparts[ 1 ][ 1 ][ p ] = 4.0 * ( b2 * o22 ) + 2.0 * ( a2 * o12 );
+
+    /** The properness condition: det( J ) = 1. */
+    const double det = a1 * b2 - a2 * b1 - 1.0;
+    PCparts[ 0 ][ 0 ][ p ] = 2.0 * det * b2;
+    PCparts[ 0 ][ 1 ][ p ] = -2.0 * det * a2;
+    PCparts[ 1 ][ 0 ][ p ] = -2.0 * det * b1;
+    PCparts[ 1 ][ 1 ][ p ] = 2.0 * det * a1;
+
+    /** The linearity condition: the second order derivatives are zero. */
+    double lc = 0.0;
+    for( unsigned int i = 0; i < Dimension; ++i )
+    {
+      lc += FD[ i ][ p ] * FD[ i ][ p ] + FE[ i ][ p ] * FE[ i ][ p ]
+        + FG[ i ][ p ] * FG[ i ][ p ];
+      LCparts[ i ][ 0 ][ p ] = 2.0 * FD[ i ][ p ];
+      LCparts[ i ][ 1 ][ p ] = 2.0 * FE[ i ][ p ];
+      LCparts[ i ][ 2 ][ p ] = 2.0 * FG[ i ][ p ];
+    }
+
+    sumC    += c[ p ];
+    valueOC += c[ p ] * ( o11 * o11 + o22 * o22 + o12 * o12 );
+    valuePC += c[ p ] * det * det;
+    valueLC += c[ p ] * lc;
+  }
+
+  /** The derivative: filter the parts, weighted by the rigidity coefficients,
+   * with the ND operators.
+   */
+  derivative = DerivativeType( Dimension * n );
+  for( unsigned int y = 0; y < ny; ++y )
+  {
+    for( unsigned int x = 0; x < nx; ++x )
+    {
+      for( unsigned int i = 0; i < Dimension; ++i )
+      {
+        double ocf = 0.0, pcf = 0.0, lcf = 0.0;
+        for( int b = -1; b <= 1; ++b )
+        {
+          for( int a = -1; a <= 1; ++a )
+          {
+            const unsigned int k = ( a + 1 ) + 3 * ( b + 1 );
+            const unsigned int q = ClampIndex( static_cast< int >( y ) + b, ny ) * nx
+              + ClampIndex( static_cast< int >( x ) + a, nx );
+            ocf += c[ q ] * ( NDA[ k ] * OCparts[ i ][ 0 ][ q ] + NDB[ k ] * OCparts[ i ][ 1 ][ q ] );
+            pcf += c[ q ] * ( NDA[ k ] * PCparts[ i ][ 0 ][ q ] + NDB[ k ] * PCparts[ i ][ 1 ][ q ] );
+            lcf += c[ q ] * ( NDD[ k ] * LCparts[ i ][ 0 ][ q ] + NDE[ k ] * LCparts[ i ][ 1 ][ q ]
+              + NDG[ k ] * LCparts[ i ][ 2 ][ q ] );
+          }
+        }
+        derivative[ i * n + y * nx + x ] = ( LinearityConditionWeight * lcf
+          + OrthonormalityConditionWeight * ocf + PropernessConditionWeight * pcf ) / sumC;
+      }
+    }
+  }
+
+  return ( LinearityConditionWeight * valueLC + OrthonormalityConditionWeight * valueOC
+         + PropernessConditionWeight * valuePC ) / sumC;
+
+} // end ComputeFullGridPenalty()
+
+
+/**
+ * Create the rigidity penalty term, with a fixed rigidity image on the grid.
+ */
+
+MetricType::Pointer
+CreateMetric( ImageType * image, RigidityImageType * rigidityImage,
+  const bool useMultiThread, const unsigned int numberOfThreads )
+{
+  BSplineTransformType::Pointer bsplineTransform = BSplineTransformType::New();
+  BSplineTransformType::SizeType    gridSize;
+  BSplineTransformType::SpacingType gridSpacing;
+  BSplineTransformType::OriginType  gridOrigin;
+  for( unsigned int i = 0; i < Dimension; ++i )
+  {
+    gridSize[ i ]    = GridSize[ i ];
+    gridSpacing[ i ] = GridSpacing[ i ];
+    gridOrigin[ i ]  = GridOrigin[ i ];
+  }
+  BSplineTransformType::RegionType gridRegion;
+  gridRegion.SetSize( gridSize );
+  BSplineTransformType::DirectionType gridDirection;
+  gridDirection.SetIdentity();
+  bsplineTransform->SetGridOrigin( gridOrigin );
+  bsplineTransform->SetGridSpacing( gridSpacing );
+  bsplineTransform->SetGridRegion( gridRegion );
+  bsplineTransform->SetGridDirection( gridDirection );
+  bsplineTransform->SetIdentity();
+
+  CombinationTransformType::Pointer transform = CombinationTransformType::New();
+  transform->SetCurrentTransform( bsplineTransform );
+
+  MetricType::Pointer metric = MetricType::New();
+  metric->SetFixedImage( image );
+  metric->SetMovingImage( image );
+  metric->SetFixedImageRegion( image->GetBufferedRegion() );
+  metric->SetTransform( transform );
+  metric->SetInterpolator( InterpolatorType::New() );
+  metric->SetUseFixedRigidityImage( true );
+  metric->SetFixedRigidityImage( rigidityImage );
+  metric->SetUseMovingRigidityImage( false );
+  metric->SetDilateRigidityImages( false );
+  metric->SetLinearityConditionWeight( LinearityConditionWeight );
+  metric->SetOrthonormalityConditionWeight( OrthonormalityConditionWeight );
+  metric->SetPropernessConditionWeight( PropernessConditionWeight );
+  metric->SetUseMultiThread( useMultiThread );
+  metric->SetNumberOfThreads( numberOfThreads );
+  metric->Initialize();
+  metric->CheckUseAndCalculationBooleans();
+
+  return metric;
+
+} // end CreateMetric()
+
+
+int
+main( int argc, char * argv[] )
+{
+  const double tolerance = 1e-10;
+
+  /** The fixed and moving image are only needed to initialize the metric. */
+  ImageType::SizeType imageSize;
+  imageSize.Fill( 40 );
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( imageSize );
+  image->Allocate();
+  image->FillBuffer( 1.0f );
+
+  /** The fixed rigidity image has the geometry of the grid. */
+  RigidityImageType::SizeType    rigiditySize;
+  RigidityImageType::SpacingType rigiditySpacing;
+  RigidityImageType::PointType   rigidityOrigin;
+  for( unsigned int i = 0; i < Dimension; ++i )
+  {
+    rigiditySize[ i ]    = GridSize[ i ];
+    rigiditySpacing[ i ] = GridSpacing[ i ];
+    rigidityOrigin[ i ]  = GridOrigin[ i ];
+  }
+  RigidityImageType::Pointer rigidityImage = RigidityImageType::New();
+  rigidityImage->SetRegions( rigiditySize );
+  rigidityImage->SetSpacing( rigiditySpacing );
+  rigidityImage->SetOrigin( rigidityOrigin );
+  rigidityImage->Allocate();
+
+  std::vector< double > coefficients( GridSize[ 0 ] * GridSize[ 1 ] );
+  itk::ImageRegionIteratorWithIndex< RigidityImageType > it(
+    rigidityImage, rigidityImage->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const unsigned int x = it.GetIndex()[ 0 ];
+    const unsigned int y = it.GetIndex()[ 1 ];
+    it.Set( GetRigidityCoefficient( x, y ) );
+    coefficients[ y * GridSize[ 0 ] + x ] = GetRigidityCoefficient( x, y );
+  }
+
+  /** Single-threaded, and with several numbers of threads. */
+  const unsigned int numberOfThreads[ 4 ] = { 1, 2, 3, 7 };
+
+  int result = 0;
+  try
+  {
+    for( unsigned int t = 0; t < 4; ++t )
+    {
+      MetricType::Pointer metric
+        = CreateMetric( image, rigidityImage, t > 0, numberOfThreads[ t ] );
+
+      ParametersType parameters( metric->GetNumberOfParameters() );
+      for( unsigned int k = 0; k < 3; ++k )
+      {
+        for( unsigned int i = 0; i < parameters.GetSize(); ++i )
+        {
+          parameters[ i ] = 0.4 * std::sin( 0.37 * i + k ) + 0.2 * std::cos( 1.3 * i );
+        }
+
+        MeasureType    value = 0.0;
+        DerivativeType derivative;
+        metric->GetValueAndDerivative( parameters, value, derivative );
+
+        DerivativeType    referenceDerivative;
+        const MeasureType referenceValue
+          = ComputeFullGridPenalty( parameters, coefficients, referenceDerivative );
+
+        std::cout << "threads " << numberOfThreads[ t ] << ( t > 0 ? "" : " (no multi-threading)" )
+                  << ", parameters " << k << ": value " << value
+                  << " (full grid " << referenceValue << ")" << std::endl;
+
+        if( referenceValue == 0.0 )
+        {
+          std::cerr << "ERROR: the penalty term is zero, so the test is meaningless." << std::endl;
+          return 1;
+        }
+        if( std::abs( value - referenceValue ) > tolerance * std::abs( referenceValue ) )
+        {
+          std::cerr << "ERROR: the value differs from the full-grid value." << std::endl;
+          result = 1;
+        }
+
+        if( derivative.GetSize() != referenceDerivative.GetSize() )
+        {
+          std::cerr << "ERROR: the derivative has size " << derivative.GetSize()
+                    << " instead of " << referenceDerivative.GetSize() << "." << std::endl;
+          return 1;
+        }
+
+        double maximum       = 0.0;
+        double maxDifference = 0.0;
+        for( unsigned int i = 0; i < referenceDerivative.GetSize(); ++i )
+        {
+          maximum       = std::max( maximum, std::abs( referenceDerivative[ i ] ) );
+          maxDifference = std::max( maxDifference,
+            std::abs( referenceDerivative[ i ] - derivative[ i ] ) );
+        }
+        if( maxDifference > tolerance * maximum )
+        {
+          std::cerr << "ERROR: the derivative differs from the full-grid derivative by "
+                    << maxDifference << " (maximum " << maximum << ")." << std::endl;
+          result = 1;
+        }
+      }
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: " << excp << std::endl;
+    return 1;
+  }
+
+  /** Return a value. */
+  return result;
+
+} // end main